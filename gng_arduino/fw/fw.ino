@@ -2,284 +2,200 @@
 // CONFIG
 //---------------------------------------------------
 #define MAXPTS   100
-#define MAX_NODES 20
-#define MAX_EDGES 40
 
-float dataX[MAXPTS];
-float dataY[MAXPTS];
+// SRAM bound: edge table MAX_NODES^2/2 bytes + ~18 bytes per node + dataset.
+// ATmega328P (Uno / Nano, 2 KB): 32 nodes leave room for Serial and stack.
+#if defined(RAMEND) && (RAMEND < 0x1000)
+#define MAX_NODES 32
+#else
+#define MAX_NODES 40
+#endif
+
+// GNG step, parameters and edge storage: shared core (../../gng_core,
+// installed as Arduino library "gng_core"); on AVR fixed-point with int16
+// Q1.15 positions (GNG_POS16), no float in the step
+#include <gng_core.h>
+
+sample_t dataQ[MAXPTS];   // Q1.15 x | y << 16
 int dataCount = 0;
 
 bool dataDone = false;
 bool running = false;
 
-// GNG parameters
-float epsilon_b = 0.08;
-float epsilon_n = 0.02;
-float alpha     = 0.5;
-float beta      = 0.995;
-int   lambda_it = 20;   // insert node every 20 steps
+// snapshot every N steps (a 40-node frame is ~20 ms at 115200 baud)
+#define GNG_STREAM_EVERY 20
 
 //---------------------------------------------------
-// GNG STRUCTURES
+// BINARY PROTOCOL (same frames as PicoTiny / NEORV32)
+// Frame: FF FF CMD LEN PAYLOAD CHK, CHK = ~(CMD + LEN + sum(payload))
+// Coordinates on the wire: int16 = value * 1000 (little endian)
 //---------------------------------------------------
-struct Node {
-  float x, y;
-  float error;
-  bool active;
-};
+#define UART_HDR        0xFF
+#define CMD_DATA_BATCH  0x01   // host: [count][x lo][x hi][y lo][y hi]...
+#define CMD_DONE        0x02   // host: dataset complete, start training
+#define CMD_RUN         0x03   // host: (re)start training
+#define CMD_GNG_NODES   0x10   // fw:   [frame_id][count][id][x lo][x hi][y lo][y hi]...
+#define CMD_GNG_EDGES   0x11   // fw:   [frame_id][count][a][b]...
 
-struct Edge {
-  int a, b;
-  int age;
-  bool active;
-};
+#define MAX_EDGE_PAIRS_PER_FRAME 126
 
-Node nodes[MAX_NODES];
-Edge edges[MAX_EDGES];
+uint8_t frameId = 0;
 
-int nodeCount = 0;
-int stepCount = 0;
+// frames go out byte by byte with a running checksum, no payload buffer
+uint8_t txSum = 0;
 
-
-//---------------------------------------------------
-// UTILITIES
-//---------------------------------------------------
-float dist2(float x1,float y1,float x2,float y2){
-  float dx=x1-x2, dy=y1-y2;
-  return dx*dx + dy*dy;
+void txBegin(uint8_t cmd, uint8_t len) {
+  Serial.write(UART_HDR);
+  Serial.write(UART_HDR);
+  Serial.write(cmd);
+  Serial.write(len);
+  txSum = (uint8_t)(cmd + len);
 }
 
-int findFreeNode(){
-  for(int i=0;i<MAX_NODES;i++){
-    if(!nodes[i].active) return i;
-  }
-  return -1;
+void txByte(uint8_t b) {
+  Serial.write(b);
+  txSum = (uint8_t)(txSum + b);
 }
 
-void connectNodes(int a,int b){
-  // If already exist → reset age
-  for(int i=0;i<MAX_EDGES;i++){
-    if(edges[i].active &&
-      ((edges[i].a==a && edges[i].b==b) ||
-       (edges[i].a==b && edges[i].b==a)))
-    {
-      edges[i].age=0;
-      return;
-    }
-  }
-
-  // Create new edge
-  for(int i=0;i<MAX_EDGES;i++){
-    if(!edges[i].active){
-      edges[i].a = a;
-      edges[i].b = b;
-      edges[i].age = 0;
-      edges[i].active = true;
-      return;
-    }
-  }
-}
-
-void ageEdgesOfWinner(int winner){
-  for(int i=0;i<MAX_EDGES;i++){
-    if(edges[i].active &&
-      (edges[i].a==winner || edges[i].b==winner))
-    {
-      edges[i].age++;
-      if(edges[i].age > 50)
-        edges[i].active = false;
-    }
-  }
+void txInt16(int16_t v) {
+  txByte((uint8_t)(v & 0xFF));
+  txByte((uint8_t)((v >> 8) & 0xFF));
 }
 
-//---------------------------------------------------
-// INSERT NEW NODE
-//---------------------------------------------------
-void insertNode(){
-  // find q = node with highest error
-  int q = -1;
-  float maxErr = -1;
-  for(int i=0;i<MAX_NODES;i++){
-    if(nodes[i].active && nodes[i].error > maxErr){
-      q = i;
-      maxErr = nodes[i].error;
-    }
-  }
-
-  if(q < 0) return;
-
-  // find f = neighbor of q with highest error
-  int f = -1;
-  maxErr = -1;
-
-  for(int i=0;i<MAX_EDGES;i++){
-    if(edges[i].active && edges[i].a == q){
-      int b = edges[i].b;
-      if(nodes[b].error > maxErr){
-        maxErr = nodes[b].error;
-        f = b;
-      }
-    }
-    else if(edges[i].active && edges[i].b == q){
-      int b = edges[i].a;
-      if(nodes[b].error > maxErr){
-        maxErr = nodes[b].error;
-        f = b;
-      }
-    }
-  }
-
-  if(f < 0) return;
-
-  int r = findFreeNode();
-  if(r < 0) return;
-
-  // new node at midpoint
-  nodes[r].x = 0.5*(nodes[q].x + nodes[f].x);
-  nodes[r].y = 0.5*(nodes[q].y + nodes[f].y);
-  nodes[r].error = nodes[q].error * 0.5;
-  nodes[r].active = true;
-  nodeCount++;
-
-  nodes[q].error *= alpha;
-  nodes[f].error *= alpha;
-
-  connectNodes(r,q);
-  connectNodes(r,f);
+void txEnd() {
+  Serial.write((uint8_t)(~txSum));
 }
 
 //---------------------------------------------------
-// SEND GNG STATE TO PROCESSING
+// SEND GNG STATE TO PROCESSING (NODES + EDGES, same frame_id)
 //---------------------------------------------------
 void sendGNG() {
-  Serial.print("GNG:");
-
-  // nodes
-  for(int i=0;i<MAX_NODES;i++){
-    if(nodes[i].active){
-      Serial.print("N:");
-      Serial.print(i);
-      Serial.print(",");
-      Serial.print(nodes[i].x, 3);
-      Serial.print(",");
-      Serial.print(nodes[i].y, 3);
-      Serial.print(";");
+  uint8_t n = 0;
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) { (void)i; n++; }
+
+  txBegin(CMD_GNG_NODES, (uint8_t)(2 + n * 5));
+  txByte(frameId);
+  txByte(n);
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES){
+    txByte((uint8_t)i);
+    txInt16(pos_to_wire(nodes[i].x));
+    txInt16(pos_to_wire(nodes[i].y));
+  }
+  txEnd();
+
+  // edges (j > i, each once), count first for LEN
+  uint8_t e = 0;
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES){
+    FOR_EACH_NEIGHBOR(j, i, i + 1, MAX_NODES){
+      (void)j;
+      if (e < MAX_EDGE_PAIRS_PER_FRAME) e++;
     }
   }
 
-  // edges
-  for(int i=0;i<MAX_EDGES;i++){
-    if(edges[i].active){
-      Serial.print("E:");
-      Serial.print(edges[i].a);
-      Serial.print(",");
-      Serial.print(edges[i].b);
-      Serial.print(";");
+  txBegin(CMD_GNG_EDGES, (uint8_t)(2 + e * 2));
+  txByte(frameId);
+  txByte(e);
+  uint8_t sent = 0;
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES){
+    FOR_EACH_NEIGHBOR(j, i, i + 1, MAX_NODES){
+      if (sent == e) continue;
+      txByte((uint8_t)i);
+      txByte((uint8_t)j);
+      sent++;
     }
   }
+  txEnd();
 
-  Serial.println();
+  frameId++;
 }
 
 //---------------------------------------------------
 // READ SERIAL FROM PROCESSING
-//---------------------------------------------------
-void readSerial() {
-  static String s = "";
-
-  while (Serial.available()) {
-    char c = Serial.read();
-
-    if (c == '\n') {
-
-      if (s.equals("DONE;")) {
-        dataDone = true;
-        Serial.println("OK_DONE");
-      }
-      else if (s.equals("RUN;")) {
-        running = true;
-        Serial.println("OK_RUN");
-      }
-      else if (s.startsWith("DATA:")) {
-        int c1 = s.indexOf(",");
-        int c2 = s.indexOf(";");
-
-        float x = s.substring(5, c1).toFloat();
-        float y = s.substring(c1+1, c2).toFloat();
-
-        if (dataCount < MAXPTS) {
-          dataX[dataCount] = x;
-          dataY[dataCount] = y;
-          dataCount++;
-        }
-      }
-
-      s = "";
-    }
-    else {
-      s += c;
-    }
-  }
+// DATA_BATCH samples go straight into dataQ (no payload buffer, 2 KB SRAM);
+// a bad checksum drops the batch again
+//---------------------------------------------------
+enum { RX_WAIT_H1 = 0, RX_WAIT_H2, RX_WAIT_CMD, RX_WAIT_LEN, RX_WAIT_PAYLOAD, RX_WAIT_CHK };
+
+uint8_t rxState = RX_WAIT_H1;
+uint8_t rxCmd   = 0;
+uint8_t rxLen   = 0;
+uint8_t rxIndex = 0;
+uint8_t rxSum   = 0;
+uint8_t rxXY[4];          // current sample bytes xL xH yL yH
+int     rxFirst = 0;      // dataCount before this DATA_BATCH
+
+void startTraining() {
+  if (dataCount < 2) return;
+  // restart from the two start nodes
+  gng_reset();
+  frameId = 0;
+  dataDone = true;
+  running = true;
+  sendGNG();
 }
 
-//---------------------------------------------------
-// ONE GNG TRAINING STEP
-//---------------------------------------------------
-void trainOneStep(float x, float y) {
-
-  int s1=-1, s2=-1;
-  float d1=99999, d2=99999;
+void rxPayloadByte(uint8_t b) {
+  if (rxCmd != CMD_DATA_BATCH || rxIndex == 0) return;   // [count] is implied by LEN
+  uint8_t k = (uint8_t)((rxIndex - 1) & 3);
+  rxXY[k] = b;
+  if (k != 3 || dataCount >= MAXPTS) return;
 
-  // find nearest + 2nd nearest
-  for(int i=0;i<MAX_NODES;i++){
-    if(!nodes[i].active) continue;
-
-    float d = dist2(x,y,nodes[i].x,nodes[i].y);
+  int16_t xi = (int16_t)((uint16_t)rxXY[0] | ((uint16_t)rxXY[1] << 8));
+  int16_t yi = (int16_t)((uint16_t)rxXY[2] | ((uint16_t)rxXY[3] << 8));
+  dataQ[dataCount] = q15_from_wire(xi) | (q15_from_wire(yi) << 16);
+  dataCount++;
+}
 
-    if(d < d1){
-      d2 = d1; s2 = s1;
-      d1 = d;  s1 = i;
-    }
-    else if(d < d2){
-      d2 = d;  s2 = i;
-    }
+void rxFrameDone(bool ok) {
+  if (rxCmd == CMD_DATA_BATCH) {
+    if (!ok) dataCount = rxFirst;
   }
-
-  // move winner
-  nodes[s1].x += epsilon_b * (x - nodes[s1].x);
-  nodes[s1].y += epsilon_b * (y - nodes[s1].y);
-
-  // move neighbors
-  for(int i=0;i<MAX_EDGES;i++){
-    if(edges[i].active &&
-      (edges[i].a==s1 || edges[i].b==s1))
-    {
-      int nb = (edges[i].a == s1 ? edges[i].b : edges[i].a);
-      nodes[nb].x += epsilon_n * (x - nodes[nb].x);
-      nodes[nb].y += epsilon_n * (y - nodes[nb].y);
-    }
+  else if (!ok) {
+    return;
   }
-
-  // increase error
-  nodes[s1].error += d1;
-
-  // connect s1-s2
-  connectNodes(s1, s2);
-
-  // age edges
-  ageEdgesOfWinner(s1);
-
-  stepCount++;
-
-  // insert new node every λ iterations
-  if(stepCount % lambda_it == 0 && nodeCount < MAX_NODES){
-    insertNode();
+  else if (rxCmd == CMD_DONE) {
+    startTraining();
   }
+  else if (rxCmd == CMD_RUN) {
+    if (!running) startTraining();
+  }
+}
 
-  // decrease all errors
-  for(int i=0;i<MAX_NODES;i++){
-    if(nodes[i].active)
-      nodes[i].error *= beta;
+void readSerial() {
+  while (Serial.available()) {
+    uint8_t b = (uint8_t)Serial.read();
+
+    switch (rxState) {
+      case RX_WAIT_H1:
+        if (b == UART_HDR) rxState = RX_WAIT_H2;
+        break;
+      case RX_WAIT_H2:
+        rxState = (b == UART_HDR) ? RX_WAIT_CMD : RX_WAIT_H1;
+        break;
+      case RX_WAIT_CMD:
+        rxCmd = b; rxSum = b; rxState = RX_WAIT_LEN;
+        break;
+      case RX_WAIT_LEN:
+        rxLen = b;
+        rxSum = (uint8_t)(rxSum + b);
+        rxIndex = 0;
+        rxFirst = dataCount;
+        rxState = (rxLen == 0) ? RX_WAIT_CHK : RX_WAIT_PAYLOAD;
+        break;
+      case RX_WAIT_PAYLOAD:
+        rxPayloadByte(b);
+        rxIndex++;
+        rxSum = (uint8_t)(rxSum + b);
+        if (rxIndex >= rxLen) rxState = RX_WAIT_CHK;
+        break;
+      case RX_WAIT_CHK:
+        rxFrameDone(b == (uint8_t)(~rxSum));
+        rxState = RX_WAIT_H1;
+        break;
+      default:
+        rxState = RX_WAIT_H1;
+        break;
+    }
   }
 }
 
@@ -290,11 +206,7 @@ void setup(){
   Serial.begin(115200);
 
   // init nodes → 2 initial nodes
-  nodes[0] = {0.2, 0.2, 0, true};
-  nodes[1] = {0.8, 0.8, 0, true};
-  nodeCount = 2;
-
-  Serial.println("READY");
+  gng_reset();
 }
 
 //---------------------------------------------------
@@ -309,12 +221,11 @@ void loop(){
   // LOOP THROUGH DATASET
   static int idx = 0;
 
-  float x = dataX[idx];
-  float y = dataY[idx];
+  sample_t smp = dataQ[idx];
 
   idx++;
   if(idx >= dataCount) idx = 0;
 
-  trainOneStep(x, y);
-  sendGNG();
+  if (!gng_step(sample_x(smp), sample_y(smp))) return;
+  if ((stepCount % GNG_STREAM_EVERY) == 0) sendGNG();
 }
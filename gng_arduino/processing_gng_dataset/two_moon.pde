@@ -1,17 +1,65 @@
 import processing.serial.*;
+import java.util.ArrayList;
 
+// ===============================
+// Serial config
+// ===============================
 Serial myPort;
-
+final String PORT_NAME = "COM1";   // <-- GANTI: contoh "COM5"
+final int    BAUD      = 115200;
+
+// ===============================
+// Two-moons dataset options (Keras/TF-like)
+// ===============================
+final int     MOONS_N            = 100;   // jumlah titik
+final boolean MOONS_RANDOM_ANGLE = false;  // true = t random, false = deterministic grid
+final int     MOONS_SEED         = 1234;  // >=0 reproducible; <0 random (millis)
+final float   MOONS_NOISE_STD    = 0.06;  // std dev gaussian noise (0.0 = no noise)
+final boolean MOONS_SHUFFLE      = true;  // shuffle order
+final boolean MOONS_NORMALIZE01  = true;  // normalize to [0,1]
+
+// ===============================
+// Dataset upload state
+// ===============================
 float[][] data;
 int idx = 0;
-
 boolean uploaded = false;
-boolean running = false;
+boolean running  = false;
 
+// debug strings
 String lastTX = "";
 String lastRX = "";
 
+// counts from payload
+int gngNodeCount = 0;
+int gngEdgeCount = 0;
+int lastFrameNodes = -1;
+int lastFrameEdges = -1;
+
+// ===============================
+// UART Binary protocol (match fw.ino)
+// Frame: FF FF CMD LEN PAYLOAD CHK, CHK = ~(CMD + LEN + sum(payload))
+// ===============================
+final int UART_HDR       = 0xFF;
+
+final int CMD_DATA_BATCH = 0x01;
+final int CMD_DONE       = 0x02;
+final int CMD_RUN        = 0x03;
+
+final int CMD_GNG_NODES  = 0x10;
+final int CMD_GNG_EDGES  = 0x11;
+
+// RX state machine
+int    rxState    = 0;
+int    rxCmd      = 0;
+int    rxLen      = 0;
+int    rxIndex    = 0;
+int    rxChecksum = 0;
+byte[] rxPayload  = new byte[512];
+
+// ===============================
 // GNG structures
+// ===============================
 class Node {
   float x, y;
   boolean active = false;
@@ -21,218 +69,433 @@ class Edge {
   boolean active = false;
 }
 
-Node[] gngNodes = new Node[20];
-Edge[] gngEdges = new Edge[40];
-
+// serial thread: working state of the RX parser
+ArrayList<Node> gngNodes = new ArrayList<Node>();
+ArrayList<Edge> gngEdges = new ArrayList<Edge>();
+
+// ===============================
+// Parser -> draw handoff
+// ===============================
+// serialEvent() parses on the serial thread and, at every EDGES frame (end
+// of a snapshot), publishes an immutable copy; draw() reads the latest one
+// and rebuilds the GNG shape only when it changed
+class GngView {
+  int seq;
+  Node[] nodes = new Node[0];
+  Edge[] edges = new Edge[0];
+  int nodeCount, edgeCount, frameNodes = -1, frameEdges = -1;
+  String rx = "";
+}
+volatile GngView gngView = new GngView();
+int gngSeq = 0;
+
+PShape datasetShape;
+PShape gngShape;
+int gngShapeSeq = -1;
+
+// ===============================
+// Setup / Draw
+// ===============================
+void settings() {
+  size(1000, 600, P2D);
+}
 
 void setup() {
-  size(1000, 600);
-  surface.setTitle("Two Moons (100 pts) → Arduino → GNG");
-
-  // Init GNG arrays
-  for (int i=0;i<20;i++) gngNodes[i] = new Node();
-  for (int i=0;i<40;i++) gngEdges[i] = new Edge();
+  surface.setTitle("Two Moons → Arduino GNG (binary)");
 
+  println("Available serial ports:");
   println(Serial.list());
-  myPort = new Serial(this, "COM1", 115200);
-  delay(1500);
 
-  data = generateMoons100();
+  myPort = new Serial(this, PORT_NAME, BAUD);
+  myPort.buffer(1);
+  delay(1500);   // board resets when the port opens
+
+  data = generateMoons(
+    MOONS_N,
+    MOONS_RANDOM_ANGLE,
+    MOONS_NOISE_STD,
+    MOONS_SEED,
+    MOONS_SHUFFLE,
+    MOONS_NORMALIZE01
+  );
+  datasetShape = buildDatasetShape();
 
   println("Uploading dataset...");
 }
 
 void draw() {
   background(30);
+  GngView v = gngView;  // one snapshot for the whole frame
 
   drawDataset();
-  drawGNG();
-  drawDebug();
+  drawGNG(v);
+  drawDebug(v);
 
   if (!uploaded) {
     uploadDataset();
-  }
-  else if (!running) {
+  } else if (!running) {
     sendRunCommand();
   }
-  else {
-    readGNG();
-  }
 }
 
-/* --------------------------------------------------
-   UPLOAD DATASET (100 POINTS)
--------------------------------------------------- */
+// serial thread: frames are parsed as they arrive, not at the frame rate
+void serialEvent(Serial p) {
+  readFrames();
+}
+
+// ===============================
+// Upload dataset in batches
+// ===============================
 void uploadDataset() {
+  final int BATCH_POINTS = 20;
+
   if (idx >= data.length) {
-    myPort.write("DONE;\n");
-    lastTX = "DONE;";
-    println("[TX] DONE;");
+    sendFrame((byte)CMD_DONE, new byte[0]);
+    lastTX = "DONE";
     uploaded = true;
+    println("[TX] DONE");
     return;
   }
 
-  float x = data[idx][0];
-  float y = data[idx][1];
+  int remaining = data.length - idx;
+  int count = min(BATCH_POINTS, remaining);
+
+  // payload: [count] + count*(xi,yi) where xi,yi are int16 LE scaled 1000
+  byte[] payload = new byte[1 + count * 4];
+  payload[0] = (byte)count;
+
+  int p = 1;
+  for (int i = 0; i < count; i++) {
+    float x = data[idx + i][0];
+    float y = data[idx + i][1];
+
+    short xi = (short)(x * 1000.0);
+    short yi = (short)(y * 1000.0);
+
+    payload[p++] = (byte)(xi & 0xFF);
+    payload[p++] = (byte)((xi >> 8) & 0xFF);
+    payload[p++] = (byte)(yi & 0xFF);
+    payload[p++] = (byte)((yi >> 8) & 0xFF);
+  }
 
-  String msg = "DATA:" + x + "," + y + ";\n";
-  myPort.write(msg);
-  lastTX = msg.trim();
+  sendFrame((byte)CMD_DATA_BATCH, payload);
+  lastTX = "DATA_BATCH count=" + count + " idx=" + idx;
   println("[TX] " + lastTX);
 
-  idx++;
-  delay(10);
+  idx += count;
 }
 
 void sendRunCommand() {
-  myPort.write("RUN;\n");
-  lastTX = "RUN;";
-  println("[TX] RUN;");
+  sendFrame((byte)CMD_RUN, new byte[0]);
+  lastTX = "RUN";
   running = true;
+  println("[TX] RUN");
 }
 
-/* --------------------------------------------------
-   READ GNG FROM ARDUINO
--------------------------------------------------- */
-void readGNG() {
+// ===============================
+// RX parser
+// ===============================
+void readFrames() {
   while (myPort.available() > 0) {
-    String line = myPort.readStringUntil('\n');
-    if (line == null) return;
+    int bi = myPort.read();
+    if (bi == -1) return;
+    int b = bi & 0xFF;
+
+    switch (rxState) {
+      case 0: // WAIT_H1
+        if (b == UART_HDR) rxState = 1;
+        break;
+
+      case 1: // WAIT_H2
+        if (b == UART_HDR) rxState = 2;
+        else rxState = 0;
+        break;
+
+      case 2: // CMD
+        rxCmd = b;
+        rxChecksum = b & 0xFF;
+        rxState = 3;
+        break;
+
+      case 3: // LEN
+        rxLen = b;
+        rxChecksum = (rxChecksum + (b & 0xFF)) & 0xFF;
+        rxIndex = 0;
+        if (rxLen == 0) rxState = 5;
+        else if (rxLen > rxPayload.length) rxState = 0;
+        else rxState = 4;
+        break;
+
+      case 4: // PAYLOAD
+        rxPayload[rxIndex++] = (byte)b;
+        rxChecksum = (rxChecksum + (b & 0xFF)) & 0xFF;
+        if (rxIndex >= rxLen) rxState = 5;
+        break;
+
+      case 5: { // CHECKSUM
+        int expected = (~rxChecksum) & 0xFF;
+        if (b == expected) {
+          handleFrame(rxCmd, rxPayload, rxLen);
+        }
+        rxState = 0;
+        break;
+      }
+    }
+  }
+}
+
+// ===============================
+// Handle frames from the Arduino
+// ===============================
+void handleFrame(int cmd, byte[] payload, int len) {
+
+  if (cmd == CMD_GNG_NODES) {
+    if (len < 2) return;
+
+    int frameId   = payload[0] & 0xFF;
+    int nodeCount = payload[1] & 0xFF;
+    gngNodeCount  = nodeCount;
+
+    int pos = 2;
+    gngNodes.clear();
 
-    lastRX = line.trim();
+    for (int i = 0; i < nodeCount; i++) {
+      if (pos + 5 > len) break;
 
-    if (line.startsWith("GNG:")) {
-      parseGNG(line.substring(4));
+      int idxNode = payload[pos++] & 0xFF;
+
+      int xi = (payload[pos++] & 0xFF) | ((payload[pos++] & 0xFF) << 8);
+      int yi = (payload[pos++] & 0xFF) | ((payload[pos++] & 0xFF) << 8);
+
+      // signed int16
+      if (xi >= 32768) xi -= 65536;
+      if (yi >= 32768) yi -= 65536;
+
+      while (gngNodes.size() <= idxNode) gngNodes.add(new Node());
+      Node n = gngNodes.get(idxNode);
+      n.x = xi / 1000.0;
+      n.y = yi / 1000.0;
+      n.active = true;
     }
 
-    println("[RX] " + lastRX);
+    lastFrameNodes = frameId;
+    lastRX = "NODES frame=" + frameId + " n=" + nodeCount;
+    // println("[RX] " + lastRX);
   }
-}
 
-/* --------------------------------------------------
-   PARSE GNG DATA
--------------------------------------------------- */
-void parseGNG(String s) {
-  for (Node n : gngNodes) n.active = false;
-  for (Edge e : gngEdges) e.active = false;
+  else if (cmd == CMD_GNG_EDGES) {
+    if (len < 2) return;
 
-  String[] parts = s.split(";");
+    int frameId   = payload[0] & 0xFF;
+    int edgeCount = payload[1] & 0xFF;
+    gngEdgeCount  = edgeCount;
 
-  for (String p : parts) {
-    if (p.startsWith("N:")) {
-      String[] a = p.substring(2).split(",");
-      int id = int(a[0]);
-      gngNodes[id].x = float(a[1]);
-      gngNodes[id].y = float(a[2]);
-      gngNodes[id].active = true;
-    }
-    else if (p.startsWith("E:")) {
-      String[] a = p.substring(2).split(",");
-      for (Edge e : gngEdges) {
-        if (!e.active) {
-          e.a = int(a[0]);
-          e.b = int(a[1]);
-          e.active = true;
-          break;
-        }
-      }
+    int pos = 2;
+    gngEdges.clear();
+
+    for (int i = 0; i < edgeCount; i++) {
+      if (pos + 2 > len) break;
+      Edge e = new Edge();
+      e.a = payload[pos++] & 0xFF;
+      e.b = payload[pos++] & 0xFF;
+      e.active = true;
+      gngEdges.add(e);
     }
+
+    lastFrameEdges = frameId;
+    lastRX = "EDGES frame=" + frameId + " e=" + edgeCount;
+    // println("[RX] " + lastRX);
+    publishGng();
   }
 }
 
-/* --------------------------------------------------
-   DRAWINGS
--------------------------------------------------- */
-void drawDataset() {
-  fill(255);
-  noStroke();
+// Node / Edge objects are fresh per frame and not touched after, so the
+// view shares them; only the lists are copied
+void publishGng() {
+  GngView v = new GngView();
+  v.nodes = gngNodes.toArray(new Node[0]);
+  v.edges = gngEdges.toArray(new Edge[0]);
+  v.nodeCount = gngNodeCount;
+  v.edgeCount = gngEdgeCount;
+  v.frameNodes = lastFrameNodes;
+  v.frameEdges = lastFrameEdges;
+  v.rx = lastRX;
+  v.seq = ++gngSeq;
+  gngView = v;
+}
 
+// ===============================
+// Send frame helper
+// ===============================
+void sendFrame(byte cmd, byte[] payload) {
+  int len = (payload == null) ? 0 : payload.length;
+  int sum = (cmd & 0xFF) + (len & 0xFF);
+  if (payload != null) {
+    for (int i = 0; i < payload.length; i++) sum += payload[i] & 0xFF;
+  }
+  int chk = (~sum) & 0xFF;
+
+  myPort.write(UART_HDR);
+  myPort.write(UART_HDR);
+  myPort.write(cmd & 0xFF);
+  myPort.write(len & 0xFF);
+  if (payload != null) myPort.write(payload);
+  myPort.write(chk);
+}
+
+// ===============================
+// Draw routines
+// ===============================
+// dataset points as one retained shape, built once
+PShape buildDatasetShape() {
+  PShape s = createShape();
+  s.beginShape(POINTS);
+  s.stroke(255);
+  s.strokeWeight(6);
   for (int i = 0; i < data.length; i++) {
-    float x = data[i][0] * 400 + 50;
-    float y = data[i][1] * 400 + 50;
-    ellipse(x, y, 6, 6);
+    s.vertex(data[i][0] * 400 + 50, data[i][1] * 400 + 50);
   }
+  s.endShape();
+  return s;
+}
+
+// edges + nodes of one view as a retained shape (nodes as round points)
+PShape buildGngShape(GngView v) {
+  PShape grp = createShape(GROUP);
+
+  PShape es = createShape();
+  es.beginShape(LINES);
+  es.stroke(255);
+  es.strokeWeight(2);
+  for (Edge e : v.edges) {
+    if (!e.active) continue;
+    if (e.a < 0 || e.a >= v.nodes.length) continue;
+    if (e.b < 0 || e.b >= v.nodes.length) continue;
+    Node a = v.nodes[e.a];
+    Node b = v.nodes[e.b];
+    if (!a.active || !b.active) continue;
+
+    es.vertex(a.x * 400 + 50, a.y * 400 + 50);
+    es.vertex(b.x * 400 + 50, b.y * 400 + 50);
+  }
+  es.endShape();
+  grp.addChild(es);
+
+  PShape ns = createShape();
+  ns.beginShape(POINTS);
+  ns.stroke(0, 180, 255);
+  ns.strokeWeight(12);
+  for (Node n : v.nodes) {
+    if (n.active) ns.vertex(n.x * 400 + 50, n.y * 400 + 50);
+  }
+  ns.endShape();
+  grp.addChild(ns);
+
+  return grp;
+}
+
+void drawDataset() {
+  shape(datasetShape);
 
   fill(200);
   textSize(16);
-  text("Two Moons – 100 pts", 50, 30);
+  text("Two Moons (" + MOONS_N + " pts)  noise=" + nf(MOONS_NOISE_STD, 1, 3) +
+       "  seed=" + MOONS_SEED +
+       "  randomAngle=" + MOONS_RANDOM_ANGLE, 50, 30);
 }
 
-void drawGNG() {
-  pushMatrix();
-  translate(500, 0);
-
-  stroke(255);
-  strokeWeight(2);
-  for (Edge e : gngEdges) {
-    if (e.active) {
-      Node a = gngNodes[e.a];
-      Node b = gngNodes[e.b];
-      line(a.x * 400 + 50, a.y * 400 + 50,
-           b.x * 400 + 50, b.y * 400 + 50);
-    }
+void drawGNG(GngView v) {
+  if (gngShape == null || gngShapeSeq != v.seq) {
+    gngShape = buildGngShape(v);
+    gngShapeSeq = v.seq;
   }
 
-  fill(0, 180, 255);
-  noStroke();
-  for (Node n : gngNodes) {
-    if (n.active) {
-      ellipse(n.x * 400 + 50, n.y * 400 + 50, 12, 12);
-    }
-  }
+  pushMatrix();
+  translate(500, 0);
+  shape(gngShape);
 
   fill(200);
-  text("MCU GNG Output", 150, 30);
+  text("Arduino GNG Output", 150, 30);
   popMatrix();
 }
 
-void drawDebug() {
+void drawDebug(GngView v) {
   fill(0, 0, 0, 180);
-  rect(0, height - 60, width, 60);
+  noStroke();
+  rect(0, height - 85, width, 85);
 
   fill(0,255,0);
-  text("TX: " + lastTX, 10, height - 40);
+  text("TX: " + lastTX, 10, height - 55);
 
   fill(255,200,0);
-  text("RX: " + lastRX, 10, height - 20);
+  text("RX: " + v.rx, 10, height - 35);
+
+  fill(200);
+  text("Nodes=" + v.nodeCount + "  Edges=" + v.edgeCount +
+       "  FrameN=" + v.frameNodes + "  FrameE=" + v.frameEdges,
+       10, height - 15);
 }
 
-/* --------------------------------------------------
-   GENERATE 100 TWO-MOONS DATASET
--------------------------------------------------- */
-float[][] generateMoons100() {
-  int N = 100;
+// ===============================
+// Two-moons generator (noise/seed/shuffle like make_moons)
+// ===============================
+float[][] generateMoons(int N, boolean randomAngle, float noiseStd, int seed,
+                        boolean shuffle, boolean normalize01) {
   float[][] arr = new float[N][2];
 
+  if (seed >= 0) randomSeed(seed);
+  else randomSeed((int)millis());
+
+  // First moon
   for (int i = 0; i < N/2; i++) {
-    float t = random(PI);
+    float t = randomAngle ? random(PI) : map(i, 0, (N/2) - 1, 0, PI);
     arr[i][0] = cos(t);
     arr[i][1] = sin(t);
   }
 
+  // Second moon
   for (int i = N/2; i < N; i++) {
-    float t = random(PI);
+    int j = i - N/2;
+    float t = randomAngle ? random(PI) : map(j, 0, (N/2) - 1, 0, PI);
     arr[i][0] = 1 - cos(t);
     arr[i][1] = -sin(t) + 0.5;
   }
 
-  float noise = 0.06;
-  for (int i=0;i<N;i++) {
-    arr[i][0] += random(-noise, noise);
-    arr[i][1] += random(-noise, noise);
+  // Gaussian noise
+  if (noiseStd > 0.0) {
+    for (int i = 0; i < N; i++) {
+      arr[i][0] += (float)randomGaussian() * noiseStd;
+      arr[i][1] += (float)randomGaussian() * noiseStd;
+    }
   }
 
-  float minx=999,maxx=-999,miny=999,maxy=-999;
-  for (float[] p : arr) {
-    if(p[0]<minx) minx=p[0];
-    if(p[0]>maxx) maxx=p[0];
-    if(p[1]<miny) miny=p[1];
-    if(p[1]>maxy) maxy=p[1];
+  // Normalize [0,1]
+  if (normalize01) {
+    float minx=999, maxx=-999, miny=999, maxy=-999;
+    for (int i = 0; i < N; i++) {
+      float x = arr[i][0], y = arr[i][1];
+      if (x < minx) minx = x;
+      if (x > maxx) maxx = x;
+      if (y < miny) miny = y;
+      if (y > maxy) maxy = y;
+    }
+    float dx = maxx - minx; if (dx < 1e-9) dx = 1.0;
+    float dy = maxy - miny; if (dy < 1e-9) dy = 1.0;
+
+    for (int i = 0; i < N; i++) {
+      arr[i][0] = (arr[i][0] - minx) / dx;
+      arr[i][1] = (arr[i][1] - miny) / dy;
+    }
   }
 
-  for (int i=0;i<N;i++) {
-    arr[i][0]=(arr[i][0]-minx)/(maxx-minx);
-    arr[i][1]=(arr[i][1]-miny)/(maxy-miny);
+  // Shuffle order
+  if (shuffle) {
+    for (int i = N - 1; i > 0; i--) {
+      int j = (int)random(i + 1);
+      float tx = arr[i][0], ty = arr[i][1];
+      arr[i][0] = arr[j][0]; arr[i][1] = arr[j][1];
+      arr[j][0] = tx;        arr[j][1] = ty;
+    }
   }
 
   return arr;
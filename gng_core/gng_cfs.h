@@ -0,0 +1,545 @@
+// ================================================================================
+// gng_cfs.h - NEORV32 CFS winner-search backend for gng_core.h
+//
+// Include this instead of gng_core.h on a NEORV32 with the GNG CFS; the core
+// then keeps g_dirty bits and gng_step() asks the CFS for (s1, s2, min1):
+//   - register subset shared by the V1 CFS (V2 board) and the V3 CFS:
+//     XIN/YIN, NODE_COUNT, ACT_LO/ACT_HI, OUT_S12/OUT_MIN1, node window at 128
+//   - V3 only: sample FIFO / result ring (16..19), REG_INFO (20), node bank
+//     select REG_CTX (21), ACT words at 64 + w for more than 64 nodes (the V1
+//     CFS maps its dataset at 16..127)
+//   - GNG_DIM > 2 (V3 CFS generic DIM, REG_DIM 22): node i word w at
+//     128 + i * CFS_NODE_STRIDE + w, sample words 1.. at CFS_REG_VEC_BASE + w;
+//     the bitstream must have the same GNG_WORDS (cfs_dim_ok), batch scans
+//     (SMP_PUSH) stay 2D
+//
+// DIRTY NODES (g_dirty, cfs_shadow):
+//   - moves only set a dirty bit; cfs_flush_dirty() runs right before the next
+//     CFS search and writes each dirty active node once
+//   - cfs_shadow[] holds what node_mem already has, so neighbor moves that do
+//     not change the Q1.15 word cost no bus write at all
+//   - ACT_LO/ACT_HI come straight from g_act (no per-step rebuild loop)
+//   - full syncs (cfs_sync_nodes_full) go through one neorv32_dma descriptor
+//     when the SoC has a DMA (cfs_setup sets g_has_dma), word stores otherwise
+//
+// CFS WINNER IRQ (CFS_USE_IRQ=1):
+//   - CTRL = START|IRQ_EN returns immediately, CFS raises FIRQ1 when DONE
+//   - ISR latches OUT_S12/OUT_MIN1 and acks with CTRL.CLEAR
+//   - the caller may do other work between cfs_start_winners and
+//     cfs_wait_winners (V3 drains the UART there)
+//   - CFS_WAIT_WFI=1 sleeps through the rest of the search; a wake-up and the
+//     trap entry cost more than a short search, so it only pays for long ones
+//
+// SAMPLE PRELOAD (g_cfs_dbuf, V3 INFO bit 25):
+//   - XIN/YIN/VEC are staging registers that START latches, so a sample may
+//     be written while the previous one is searched: cfs_preload() during
+//     the search, and cfs_start_winners() skips the writes when the staged
+//     sample is the one it gets
+//   - g_cfs_in tracks what the staging registers hold; any sample that does
+//     not match (new data, a query, another model) is simply written again
+//   - the caller sets g_cfs_dbuf from INFO (V1 CFS: INFO is dataset space)
+//
+// PERF COUNTERS (V3 INFO bit 26, REG 24..31):
+//   - the CFS counts START writes, SMP_PUSH samples, busy / idle cycles,
+//     node window writes, bus accesses and stalls (CTRL polls while busy,
+//     pushes on a full FIFO, pops of an empty ring) on clk_i
+//   - cfs_perf_read() freezes them, reads the CFS_PERF_N words in one burst
+//     and releases them (optionally cleared), so a set is one instant
+//
+// GRID CANDIDATES (GNG_GRID_BITS, gng_core.h GRID INDEX):
+//   - cfs_start_winners writes the 3x3 cell mask instead of g_act, the engine
+//     skips empty lane groups, so a sparse mask is a shorter scan
+//   - OUT_MIN2 < grid_bound_q30(m) proves the answer exact; otherwise the
+//     search runs again on g_act (GNG_GRID_EXACT=0 keeps the first answer)
+//   - the batch scans (SMP_PUSH) keep the full mask: cfs_write_active_mask()
+//
+// MOVE UNIT (GNG_CFS_MOVE=1, V3 CFS generic MOVE, REG_DIM bit 16):
+//   - adj_mem at CFS_REG_ADJ_BASE mirrors nbr[]: edge changes set g_nbr_dirty
+//     (gng_core.h GNG_NBR_DIRTY), cfs_flush_dirty() writes the changed rows
+//   - cfs_start_move() writes the step rates EPS_B_STEP / EPS_N_STEP and
+//     starts with CTRL.MOVE: after the search the CFS moves s1 and its active
+//     neighbors (pos_step of GNG_POS16, so the words are the positions)
+//   - gng_update() calls gng_cfs_move_sync() instead of (B) + (C): it reads
+//     the moved words back through the node window and leaves the aging to
+//     g_wins[s1]++ (GNG_EDGE_STAMP)
+//   - GNG_DRIFT: the rates are the ones before the step's drift update, one
+//     step behind the CPU path
+//   - a search that times out may have moved nodes: the next start resyncs
+//
+// SNAPSHOT DUMP (V3 CFS generic DUMP, REG_DIM bit 17):
+//   - cfs_dump_start() flushes dirty nodes / rows and the full mask, then the
+//     CFS sends CMD_GNG_NODES out of node_mem itself (and with GNG_CFS_MOVE
+//     the adj_mem pairs as CMD_GNG_EDGES / CMD_GNG_EDGES_CHUNK)
+//   - the framer shares the UART0 pin and holds UART0 by CTS until its last
+//     stop bit: the caller sets UART0 CTRL.HWFC_EN and starts on an idle
+//     line only, bytes queued after the start follow the dump
+//   - cfs_dump_setup(baud) sets the bit time (0 = off, START is ignored)
+// ================================================================================
+
+#ifndef GNG_CFS_H
+#define GNG_CFS_H
+
+#include <neorv32.h>
+
+#ifndef GNG_DIRTY
+#define GNG_DIRTY 1
+#endif
+#ifndef GNG_FIND_WINNERS
+#define GNG_FIND_WINNERS gng_cfs_find_winners
+#endif
+#ifndef GNG_CFS_MOVE
+#define GNG_CFS_MOVE 0
+#endif
+#if GNG_CFS_MOVE
+#define GNG_NBR_DIRTY 1
+#define GNG_MOVE_SYNC gng_cfs_move_sync
+#endif
+
+#include "gng_core.h"
+
+#if GNG_CFS_MOVE && (!GNG_POS16 || GNG_DIM != 2 || GNG_GRID_BITS)
+#error "GNG_CFS_MOVE needs GNG_POS16=1, GNG_DIM=2 and no GNG_GRID_BITS"
+#endif
+
+// ============================ CFS REG MAP (match VHDL) ============================
+#include "gng_cfs_regs.h"
+
+#define CFS_NODE_STRIDE    (1u << GNG_DIST_SHIFT)  // node window words per node (1 in 2D)
+#define CFS_NODE_REG(i, w) (CFS_NODE_BASE + (uint32_t)(i) * CFS_NODE_STRIDE + (uint32_t)(w))
+
+// 1 = wait for CFS DONE interrupt (overlap work), 0 = busy-poll CTRL.DONE
+#ifndef CFS_USE_IRQ
+#define CFS_USE_IRQ        0
+#endif
+
+// CFS_USE_IRQ: 1 = sleep (wfi) in cfs_wait_winners until the DONE IRQ instead
+// of spinning on g_win_ready; relies on the IRQ coming (no CFS_TIMEOUT fallback)
+#ifndef CFS_WAIT_WFI
+#define CFS_WAIT_WFI       0
+#endif
+
+#if CFS_USE_IRQ
+#define CFS_CTRL_MODE      CFS_CTRL_IRQ_EN
+#else
+#define CFS_CTRL_MODE      0u
+#endif
+
+#define CFS_TIMEOUT        200000u
+
+// neorv32_dma (tang_nano_9k IO_DMA_EN): CTRL bits and descriptor config word
+#define DMA_CTRL_EN        (1u << 0)
+#define DMA_CTRL_START     (1u << 1)
+#define DMA_CTRL_ERROR     (1u << 29)
+#define DMA_CTRL_DONE      (1u << 30)
+#define DMA_CONF_WORDS     ((3u << 28) | (3u << 30)) // src + dst: word, incrementing
+
+static bool g_has_cfs = false;
+static bool g_has_dma = false;
+static bool g_cfs_dbuf = false;   // staging registers may be written mid-search
+
+// sample in the XIN/YIN(/VEC) staging registers
+static sample_t g_cfs_in;
+static bool g_cfs_in_ok = false;
+
+// node_mem words the CFS holds, GNG_WORDS per node
+static uint32_t cfs_shadow[MAX_NODES * GNG_WORDS];
+
+#if GNG_CFS_MOVE
+static bool g_cfs_move_run = false;  // the running search moves (CTRL.MOVE)
+static bool g_cfs_moved = false;     // the last search moved s1 + neighbors
+static bool g_cfs_resync = false;    // node_mem unknown after a timeout
+static uint32_t g_cfs_eps[2] = { ~0u, ~0u };  // REG_EPS_B / REG_EPS_N
+#endif
+
+// ============================ CFS helpers =======================================
+// node_mem banks of the bitstream (generic CTX), 1 on bitstreams without them
+static inline uint32_t cfs_ctx_banks(void) {
+  uint32_t n = CFS_RD(CFS_REG_INFO) >> 28;
+  return n ? n : 1u;
+}
+
+// the bitstream streams as many words per node as this build packs
+static inline bool cfs_dim_ok(void) {
+  uint32_t d = CFS_RD(CFS_REG_DIM) & 0xFFu;
+  return (((d ? d : 2u) + 1u) / 2u) == (uint32_t)GNG_WORDS;
+}
+
+// CFS word w of node i
+static inline uint32_t cfs_node_word(int i, int w) {
+#if GNG_DIM > 2
+  if (w) return pack_z_q15(nodes[i].z, w);
+#else
+  (void)w;
+#endif
+  return pack_node_q15(nodes[i].x, nodes[i].y);
+}
+
+// n words src -> dst as one DMA descriptor (CFS acks every clock); false on bus error
+static bool dma_copy_words(volatile uint32_t *dst, const uint32_t *src, uint32_t n) {
+  NEORV32_DMA->CTRL = DMA_CTRL_EN;
+  NEORV32_DMA->DESC = (uint32_t)src;
+  NEORV32_DMA->DESC = (uint32_t)dst;
+  NEORV32_DMA->DESC = n | DMA_CONF_WORDS;
+  NEORV32_DMA->CTRL = DMA_CTRL_EN | DMA_CTRL_START;
+  uint32_t st;
+  do { st = NEORV32_DMA->CTRL; } while (!(st & (DMA_CTRL_DONE | DMA_CTRL_ERROR)));
+  return !(st & DMA_CTRL_ERROR);
+}
+
+// one DMA descriptor when the window has no gaps (GNG_WORDS a power of two)
+static void cfs_sync_nodes_full(void) {
+  for (int i = 0; i < MAX_NODES; i++) {
+    for (int w = 0; w < GNG_WORDS; w++) cfs_shadow[i * GNG_WORDS + w] = cfs_node_word(i, w);
+  }
+  bool dense = (CFS_NODE_STRIDE == (uint32_t)GNG_WORDS);
+  if (!dense || !g_has_dma ||
+      !dma_copy_words(&NEORV32_CFS->REG[CFS_NODE_BASE], cfs_shadow, MAX_NODES * GNG_WORDS)) {
+    for (int i = 0; i < MAX_NODES; i++) {
+      for (int w = 0; w < GNG_WORDS; w++) CFS_WR(CFS_NODE_REG(i, w), cfs_shadow[i * GNG_WORDS + w]);
+    }
+  }
+  for (int w = 0; w < ACT_WORDS; w++) g_dirty[w] = 0;
+#if GNG_CFS_MOVE
+  for (int i = 0; i < MAX_NODES; i++) {
+    for (int w = 0; w < ACT_WORDS; w++) CFS_WR(CFS_ADJ_REG(i, w), nbr[i][w]);
+  }
+  for (int w = 0; w < ACT_WORDS; w++) g_nbr_dirty[w] = 0;
+  g_cfs_resync = false;
+#endif
+}
+
+#if GNG_CFS_MOVE
+// adj_mem rows whose nbr[] row changed
+static void cfs_flush_nbr(void) {
+  for (int w = 0; w < ACT_WORDS; w++) {
+    uint32_t m = g_nbr_dirty[w];
+    g_nbr_dirty[w] = 0;
+    for (; m; m &= m - 1u) {
+      int i = w * 32 + GNG_CTZ(m);
+      for (int k = 0; k < ACT_WORDS; k++) CFS_WR(CFS_ADJ_REG(i, k), nbr[i][k]);
+    }
+  }
+}
+#endif
+
+// write moved active nodes whose Q1.15 word changed (inactive ones are masked)
+static void cfs_flush_dirty(void) {
+  for (int w = 0; w < ACT_WORDS; w++) {
+    uint32_t m = g_dirty[w] & g_act[w];
+    g_dirty[w] = 0;
+    for (; m; m &= m - 1u) {
+      int i = w * 32 + GNG_CTZ(m);
+      for (int k = 0; k < GNG_WORDS; k++) {
+        uint32_t v = cfs_node_word(i, k);
+        if (v == cfs_shadow[i * GNG_WORDS + k]) continue;
+        cfs_shadow[i * GNG_WORDS + k] = v;
+        CFS_WR(CFS_NODE_REG(i, k), v);
+      }
+    }
+  }
+#if GNG_CFS_MOVE
+  cfs_flush_nbr();
+#endif
+}
+
+// NODE_COUNT + node mask; up to 64 nodes the old ACT_LO/ACT_HI pair is
+// enough (and still works with a 40-node bitstream). GNG_COMPACT: NODE_COUNT
+// = gng_span(), the V1 CFS scans 0 .. NODE_COUNT-1 one node per clock
+static void cfs_write_mask(const uint32_t *m) {
+#if GNG_COMPACT
+  CFS_WR(CFS_REG_NODE_COUNT, (uint32_t)gng_span());  // no node at or above it
+#else
+  CFS_WR(CFS_REG_NODE_COUNT, (uint32_t)MAX_NODES);
+#endif
+#if ACT_WORDS <= 2
+  CFS_WR(CFS_REG_ACT_LO, m[0]);
+  CFS_WR(CFS_REG_ACT_HI, (ACT_WORDS > 1) ? m[ACT_WORDS - 1] : 0u);
+#else
+  for (int w = 0; w < ACT_WORDS; w++) CFS_WR(CFS_REG_ACT_BASE + w, m[w]);
+#endif
+}
+
+static inline void cfs_write_active_mask(void) {
+  cfs_write_mask(g_act);
+}
+
+#if GNG_GRID_BITS
+// OUT_MIN2 that proves the running search exact, 0 = full mask (no check)
+static uint32_t g_cfs_grid_bound = 0;
+
+// at least two nodes in m (the engine needs two for s1 / s2)
+static inline bool cfs_mask_has_two(const uint32_t *m) {
+  bool seen = false;
+  for (int w = 0; w < ACT_WORDS; w++) {
+    if (!m[w]) continue;
+    if (seen || (m[w] & (m[w] - 1u))) return true;
+    seen = true;
+  }
+  return false;
+}
+
+// candidate mask of the sample's 3x3 cells, g_act when it proves nothing
+static void cfs_write_grid_mask(sample_t smp) {
+  uint32_t cand[ACT_WORDS];
+  const uint32_t w0 = sample_word0(smp);
+  const uint32_t m = grid_probe(w0 & 0xFFFFu, w0 >> 16, cand);
+  g_cfs_grid_bound = 0;
+  if (m == 0xFFFFu || !cfs_mask_has_two(cand)) { cfs_write_active_mask(); return; }
+#if GNG_GRID_EXACT
+  g_cfs_grid_bound = grid_bound_q30(m);
+  if (g_cfs_grid_bound == 0) { cfs_write_active_mask(); return; }
+#endif
+  cfs_write_mask(cand);
+}
+#endif
+
+#if CFS_USE_IRQ
+static volatile bool     g_win_ready = false;
+static volatile uint32_t g_win_s12   = 0;
+static volatile uint32_t g_win_min1  = 0;
+static volatile uint32_t g_win_min2  = 0;
+
+// CFS FIRQ: level IRQ (DONE & IRQ_EN), must be acked by CTRL.CLEAR
+static void cfs_irq_handler(void) {
+  g_win_s12  = CFS_RD(CFS_REG_OUT_S12);
+  g_win_min1 = CFS_RD(CFS_REG_OUT_MIN1);
+  g_win_min2 = CFS_RD(CFS_REG_OUT_MIN2);
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_CLEAR | CFS_CTRL_IRQ_EN);
+  g_win_ready = true;
+}
+
+static void cfs_irq_setup(void) {
+  neorv32_rte_handler_install(CFS_TRAP_CODE, cfs_irq_handler);
+  neorv32_cpu_csr_set(CSR_MIE, 1 << CFS_FIRQ_ENABLE);
+  neorv32_cpu_csr_set(CSR_MSTATUS, 1 << CSR_MSTATUS_MIE);
+}
+#endif
+
+// after gng_reset(), with g_has_cfs checked: DMA probe, clear flags, node window
+static void cfs_setup(void) {
+  g_has_dma = (neorv32_dma_available() != 0);
+
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_CLEAR | CFS_CTRL_MODE);
+  cfs_sync_nodes_full();
+
+#if CFS_USE_IRQ
+  cfs_irq_setup();
+#endif
+}
+
+static inline bool cfs_in_is(sample_t smp) {
+  if (!g_cfs_in_ok) return false;
+#if GNG_DIM > 2
+  for (int w = 0; w < GNG_WORDS; w++)
+    if (g_cfs_in.w[w] != smp.w[w]) return false;
+  return true;
+#else
+  return g_cfs_in == smp;
+#endif
+}
+
+static void cfs_write_sample(sample_t smp) {
+  CFS_WR(CFS_REG_XIN, sample_word0(smp) & 0xFFFFu);
+  CFS_WR(CFS_REG_YIN, sample_word0(smp) >> 16);
+#if GNG_DIM > 2
+  for (int w = 1; w < GNG_WORDS; w++) CFS_WR(CFS_REG_VEC_BASE + w, smp.w[w]);
+#endif
+  g_cfs_in = smp;
+  g_cfs_in_ok = true;
+}
+
+// stage the next sample while the CFS searches (double-buffered bitstreams only)
+static inline void cfs_preload(sample_t smp) {
+  if (g_cfs_dbuf && !cfs_in_is(smp)) cfs_write_sample(smp);
+}
+
+// search with the given extra CTRL bits (CFS_CTRL_MOVE)
+static void cfs_start(sample_t smp, uint32_t ctrl) {
+#if GNG_CFS_MOVE
+  if (g_cfs_resync) cfs_sync_nodes_full();
+  g_cfs_move_run = (ctrl & CFS_CTRL_MOVE) != 0;
+  g_cfs_moved = false;
+#endif
+  cfs_flush_dirty();
+
+  if (!cfs_in_is(smp)) cfs_write_sample(smp);
+#if GNG_GRID_BITS
+  cfs_write_grid_mask(smp);
+#else
+  cfs_write_active_mask();
+#endif
+
+#if CFS_USE_IRQ
+  g_win_ready = false;
+#endif
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_START | CFS_CTRL_MODE | ctrl);
+#if GNG_DIM > 2
+  if (g_cfs_dbuf) g_cfs_in_ok = false;  // the VEC banks swapped, staging is stale
+#endif
+}
+
+static inline void cfs_start_winners(sample_t smp) {
+  cfs_start(smp, 0u);
+}
+
+#if GNG_CFS_MOVE
+// training search: the CFS also moves s1 and its neighbors (gng_cfs_move_sync)
+static void cfs_start_move(sample_t smp) {
+  const uint32_t eps[2] = { (uint32_t)EPS_B_STEP, (uint32_t)EPS_N_STEP };
+  for (int k = 0; k < 2; k++) {
+    if (eps[k] == g_cfs_eps[k]) continue;
+    g_cfs_eps[k] = eps[k];
+    CFS_WR(CFS_REG_EPS_B + k, eps[k]);
+  }
+  cfs_start(smp, CFS_CTRL_MOVE);
+}
+#endif
+
+// clk_i cycles per bit of the dump framer, 0 = off
+static uint32_t g_cfs_dump_div = 0;
+
+static inline void cfs_dump_setup(uint32_t baud) {
+  uint32_t div = baud ? (neorv32_sysinfo_get_clk() + baud / 2u) / baud : 0u;
+  g_cfs_dump_div = (div > 0xFFFFu) ? 0u : div;
+  CFS_WR(CFS_REG_DUMP_DIV, g_cfs_dump_div);
+}
+
+static inline bool cfs_dump_busy(void) {
+  return (CFS_RD(CFS_REG_DUMP) & CFS_DUMP_BUSY) != 0;
+}
+
+// keyframe 'fid' out of node_mem (+ adj_mem pairs); returns once the framer
+// owns the line, so UART0 bytes written from now on come after it
+static inline bool cfs_dump_start(uint8_t fid, bool edges) {
+  if (g_cfs_dump_div == 0) return false;
+#if GNG_CFS_MOVE
+  if (g_cfs_resync) cfs_sync_nodes_full();
+#endif
+  cfs_flush_dirty();
+  cfs_write_active_mask();  // a grid search leaves its cell mask in ACT
+  CFS_WR(CFS_REG_DUMP, (uint32_t)fid | CFS_DUMP_START | (edges ? CFS_DUMP_EDGES : 0u));
+  uint32_t st;
+  do {
+    st = CFS_RD(CFS_REG_DUMP);
+  } while ((st & CFS_DUMP_BUSY) && !(st & CFS_DUMP_OWN));
+  return true;
+}
+
+// perf counters in one frozen burst; clear = restart them from 0 afterwards
+static void cfs_perf_read(uint32_t v[CFS_PERF_N], bool clear) {
+  CFS_WR(CFS_REG_PERF_CTRL, CFS_PERF_FREEZE);
+  for (int k = 0; k < CFS_PERF_N; k++) v[k] = CFS_RD(CFS_REG_PERF_BASE + k);
+  CFS_WR(CFS_REG_PERF_CTRL, clear ? CFS_PERF_CLEAR : 0u);
+}
+
+// DONE of the running search -> OUT_S12 / OUT_MIN1 / OUT_MIN2
+static bool cfs_wait_done(uint32_t *s12, uint32_t *min1, uint32_t *min2) {
+#if CFS_USE_IRQ
+#if CFS_WAIT_WFI
+  // MIE off around the check: DONE between check and wfi still wakes it
+  for (;;) {
+    neorv32_cpu_csr_clr(CSR_MSTATUS, 1 << CSR_MSTATUS_MIE);
+    bool ready = g_win_ready;
+    if (!ready) neorv32_cpu_sleep();
+    neorv32_cpu_csr_set(CSR_MSTATUS, 1 << CSR_MSTATUS_MIE);
+    if (ready) break;
+  }
+#else
+  // spin on DMEM flag set by the ISR (no IO-bus polling of the CFS)
+  for (uint32_t t = 0; t < CFS_TIMEOUT; t++) {
+    if (g_win_ready) break;
+    if (t == CFS_TIMEOUT - 1) return false;
+  }
+#endif
+  *s12  = g_win_s12;
+  *min1 = g_win_min1;
+  *min2 = g_win_min2;
+#else
+  for (uint32_t t = 0; t < CFS_TIMEOUT; t++) {
+    uint32_t st = CFS_RD(CFS_REG_CTRL);
+    if (st & CFS_STATUS_DONE) break;
+    if (t == CFS_TIMEOUT - 1) return false;
+  }
+  *s12  = CFS_RD(CFS_REG_OUT_S12);
+  *min1 = CFS_RD(CFS_REG_OUT_MIN1);
+  *min2 = CFS_RD(CFS_REG_OUT_MIN2);
+#endif
+  return true;
+}
+
+static bool cfs_wait_winners(int *s1, int *s2, dist_t *d1_out) {
+  uint32_t s12, min1, min2;
+  if (!cfs_wait_done(&s12, &min1, &min2)) {
+#if GNG_CFS_MOVE
+    if (g_cfs_move_run) g_cfs_resync = true;
+    g_cfs_move_run = false;
+#endif
+    return false;
+  }
+#if GNG_CFS_MOVE
+  g_cfs_moved = g_cfs_move_run && (min2 != 0xFFFFFFFFu);
+  g_cfs_move_run = false;
+#endif
+
+#if GNG_GRID_BITS
+  if (g_cfs_grid_bound && !(min2 < g_cfs_grid_bound)) {
+    // a node outside the 3x3 cells may be closer: same sample, all nodes
+    g_cfs_grid_bound = 0;
+    cfs_write_active_mask();
+#if CFS_USE_IRQ
+    g_win_ready = false;
+#endif
+    CFS_WR(CFS_REG_CTRL, CFS_CTRL_START | CFS_CTRL_MODE);
+    if (!cfs_wait_done(&s12, &min1, &min2)) return false;
+  }
+#else
+  (void)min2;
+#endif
+
+  *s1 = (int)(s12 & 0xFFu);
+  *s2 = (int)((s12 >> 8) & 0xFFu);
+
+  *d1_out = dist_from_q30(min1);
+  return true;
+}
+
+#if GNG_CFS_MOVE
+// GNG_MOVE_SYNC of gng_update(): the words the move unit wrote for s1 and its
+// active neighbors become the positions (and the shadow); false = no move ran
+static bool gng_cfs_move_sync(int s1) {
+  if (!g_cfs_moved) return false;
+  g_cfs_moved = false;
+  uint32_t m[ACT_WORDS];
+  for (int w = 0; w < ACT_WORDS; w++) m[w] = nbr[s1][w] & g_act[w];
+  m[s1 >> 5] |= GNG_BIT(s1);
+  for (int w = 0; w < ACT_WORDS; w++) {
+    for (uint32_t b = m[w]; b; b &= b - 1u) {
+      int i = w * 32 + GNG_CTZ(b);
+      uint32_t v = CFS_RD(CFS_NODE_REG(i, 0));
+      cfs_shadow[i] = v;
+      nodes[i].x = (pos_t)(int16_t)v;
+      nodes[i].y = (pos_t)(int16_t)(v >> 16);
+      grid_move(i);
+    }
+  }
+  return true;
+}
+#endif
+
+// GNG_FIND_WINNERS backend: CFS search, CPU search if the CFS does not answer (rare)
+static void gng_cfs_find_winners(pos_t x, pos_t y, int *s1, int *s2, dist_t *d1) {
+#if GNG_DIM > 2
+  sample_t smp;
+  smp.w[0] = pack_node_q15(x, y);
+  for (int w = 1; w < GNG_WORDS; w++) smp.w[w] = pack_z_q15(g_in_z, w);
+  cfs_start_winners(smp);
+#else
+  cfs_start_winners(pack_node_q15(x, y));
+#endif
+  if (!cfs_wait_winners(s1, s2, d1)) {
+    *s1 = *s2 = -1;
+    gng_find_winners_sw(x, y, s1, s2, d1);
+  }
+}
+
+#endif // GNG_CFS_H
@@ -0,0 +1,87 @@
+// ================================================================================
+// gng_cfs_regs.h - register map of the NEORV32 GNG CFS (neorv32_cfs.vhd)
+//
+// Registers and control bits only, no gng_core.h state: gng_cfs.h builds
+// the winner-search backend on it, and the inference-only image
+// (gng_neorv32_accelerator_V3/fw_infer) drives the CFS with nothing else.
+// The node window stride follows GNG_DIM (gng_cfs.h CFS_NODE_STRIDE); a 2D
+// bitstream has one word per node at CFS_NODE_BASE + i.
+// ================================================================================
+
+#ifndef GNG_CFS_REGS_H
+#define GNG_CFS_REGS_H
+
+#include <neorv32.h>
+
+#define CFS_REG_CTRL       0
+#define CFS_REG_EPS_B      4   // V3, RW: Q16 rate, read by the move unit
+#define CFS_REG_EPS_N      5   // V3, RW: Q16 rate, read by the move unit
+#define CFS_REG_XIN        8
+#define CFS_REG_YIN        9
+#define CFS_REG_NODE_COUNT 10
+#define CFS_REG_ACT_LO     11
+#define CFS_REG_ACT_HI     12
+#define CFS_REG_OUT_S12    13
+#define CFS_REG_OUT_MIN1   14
+#define CFS_REG_OUT_MIN2   15
+#define CFS_REG_SMP_PUSH   16  // V3
+#define CFS_REG_BATCH      17  // V3
+#define CFS_REG_RES_S12    18  // V3
+#define CFS_REG_RES_MIN1   19  // V3
+#define CFS_REG_INFO       20  // V3, R: MAXNODES (15..0) | LANES << 16 | DBUF << 25 | PERF << 26 | COARSE << 27 | CTX << 28, 0 on old bitstreams
+#define CFS_REG_CTX        21  // V3, RW: node_mem bank (GNG instance) of node window + engine
+#define CFS_REG_DIM        22  // V3, R: components per node / sample (7..0) | coarse lanes (15..8) | MOVE << 16 | DUMP << 17, 0 on old bitstreams (= 2)
+#define CFS_REG_DUMP       23  // V3 DUMP, W: frame id (7..0) | START | EDGES; R: busy | own | ovf | nodes << 8 | pairs << 16
+#define CFS_REG_PERF_CTRL  24  // V3, W: b0 clear, b1 freeze; R: b1 freeze | count << 8
+#define CFS_REG_PERF_BASE  25  // V3, R: perf counter k at 25 + k (CFS_PERF_*)
+#define CFS_REG_VEC_BASE   4096  // V3, W: sample word w (1 .. GNG_WORDS-1) at 4096 + w
+#define CFS_REG_DUMP_DIV   32  // V3 DUMP, RW: clk cycles per UART bit of the dump (0 = off)
+#define CFS_REG_ACT_BASE   64  // V3, ACT word w at 64 + w (ACT_LO / ACT_HI = words 0 / 1)
+#define CFS_REG_ADJ_BASE   8192  // V3 MOVE, RW: nbr row i word w at 8192 + i * 8 + w
+
+// register access: volatile words on the target; the host build
+// (gng_host/fwhost) defines both in its neorv32.h and serves them from a
+// software model of neorv32_cfs.vhd
+#ifndef CFS_RD
+#define CFS_RD(r)          (NEORV32_CFS->REG[(r)])
+#define CFS_WR(r, v)       (NEORV32_CFS->REG[(r)] = (v))
+#endif
+
+#define CFS_NODE_BASE      128
+#define CFS_ADJ_STRIDE     8u  // words per adj_mem row (up to 256 nodes)
+#define CFS_ADJ_REG(i, w)  (CFS_REG_ADJ_BASE + (uint32_t)(i) * CFS_ADJ_STRIDE + (uint32_t)(w))
+
+#define CFS_CTRL_CLEAR     (1u << 0)
+#define CFS_CTRL_START     (1u << 1)
+#define CFS_CTRL_IRQ_EN    (1u << 2)
+#define CFS_CTRL_BATCH     (1u << 3)
+#define CFS_CTRL_FLUSH     (1u << 4)
+#define CFS_CTRL_SLEEP     (1u << 5)   // V3: engine clock gated until the next CTRL write
+#define CFS_CTRL_MOVE      (1u << 6)   // V3 MOVE: move s1 and its neighbors after the search
+#define CFS_STATUS_BUSY    (1u << 16)
+#define CFS_STATUS_DONE    (1u << 17)
+#define CFS_INFO_DBUF      (1u << 25)  // XIN/YIN/VEC latched by START
+#define CFS_INFO_PERF      (1u << 26)  // perf counters at 24..31
+#define CFS_INFO_COARSE    (1u << 27)  // 8-bit coarse pass ahead of the scan (same results)
+#define CFS_DIM_MOVE       (1u << 16)  // REG_DIM: move unit + adj_mem
+#define CFS_DIM_DUMP       (1u << 17)  // REG_DIM: keyframe framer on the UART0 pin
+
+#define CFS_DUMP_START     (1u << 8)   // REG_DUMP W: send CMD_GNG_NODES (frame id in 7..0)
+#define CFS_DUMP_EDGES     (1u << 9)   // ... and the adj_mem pairs (MOVE bitstreams)
+#define CFS_DUMP_BUSY      (1u << 0)   // REG_DUMP R: latched, UART0 held by CTS
+#define CFS_DUMP_OWN       (1u << 1)   // framer drives the pin
+#define CFS_DUMP_OVF       (1u << 2)   // more pairs than the framer buffers (512)
+
+#define CFS_PERF_CLEAR     (1u << 0)
+#define CFS_PERF_FREEZE    (1u << 1)
+// perf counter words (order = PERF_* in neorv32_cfs.vhd)
+#define CFS_PERF_START     0
+#define CFS_PERF_SMP       1
+#define CFS_PERF_BUSY      2
+#define CFS_PERF_IDLE      3
+#define CFS_PERF_NODE_WR   4
+#define CFS_PERF_BUS       5
+#define CFS_PERF_STALL     6
+#define CFS_PERF_N         7
+
+#endif // GNG_CFS_REGS_H
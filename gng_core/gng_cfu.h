@@ -0,0 +1,138 @@
+// ================================================================================
+// gng_cfu.h - NEORV32 CFU instructions of the GNG step (GNG_CFU=1)
+//
+// C intrinsics for the custom instructions of the V3 neorv32_cpu_cp_cfu.vhd
+// (Zxcfu, custom-0 R-type / custom-1 I-type), included by gng_core.h.
+// On RISC-V every call is one instruction; elsewhere (fwhost, host checks)
+// the same functions are a C model of the unit, bit for bit, so a
+// GNG_CFU=1 build trains identically on the host.
+//
+// R-TYPE (custom-0, funct7 = 0), one cycle each:
+//   funct3 0 DIST2 : rs1, rs2 = packed Q1.15 x | y << 16 (signed halves),
+//                    (dx^2 + dy^2) mod 2^32; dist2() of two packed nodes
+//   funct3 1 LERP  : p + ((eps * (t - p) + 32768) >> 16), rs1 = p, rs2 = t,
+//                    int32 (Q16.16) wrap-around like the RV32 mul; eps = the
+//                    Q16 rate of slot EPS (pos_step)
+//   funct3 2 LERP2 : the same per int16 half of two packed Q1.15 words
+//                    (pos_step of GNG_POS16)
+//   funct3 3 PACK  : pack_node_q15() of two Q16.16 positions: each clamped
+//                    v <= 0 -> 0, (v >> 1) > 0x7FFF -> 0x7FFF
+//   funct3 4 EIDX  : edge_index_ij(i, j) = i * (2N - i - 1) / 2 + j - i - 1,
+//                    rs1 = i < rs2 = j < N, N = slot N
+// I-TYPE (custom-1), funct3 1 writes rs1 to slot imm12, funct3 0 reads it:
+//   slot 0 EPS (Q16 rate, 0..65536), slot 1 N (edge table stride, MAX_NODES)
+//
+// The unit holds two 18 x 18 multipliers (DIST2 dx / dy, LERP low / high
+// half of t - p, LERP2 x / y, EIDX), muxed by funct3.
+// ================================================================================
+
+#ifndef GNG_CFU_H
+#define GNG_CFU_H
+
+#include <stdint.h>
+
+#define GNG_CFU_DIST2  0
+#define GNG_CFU_LERP   1
+#define GNG_CFU_LERP2  2
+#define GNG_CFU_PACK   3
+#define GNG_CFU_EIDX   4
+
+#define GNG_CFU_SLOT_EPS  0
+#define GNG_CFU_SLOT_N    1
+
+#if defined(__riscv)
+// DIST2 / PACK are pure (the compiler may hoist or merge them); LERP / EIDX
+// read a slot, so GNG_CFU_RS is volatile and stays behind the slot write
+#define GNG_CFU_R(f3, a, b) __extension__ ({                                   \
+  uint32_t _r;                                                                 \
+  __asm__ (".insn r CUSTOM_0, %1, 0, %0, %2, %3"                               \
+           : "=r"(_r) : "i"(f3), "r"(a), "r"(b));                              \
+  _r; })
+#define GNG_CFU_RS(f3, a, b) __extension__ ({                                  \
+  uint32_t _r;                                                                 \
+  __asm__ volatile (".insn r CUSTOM_0, %1, 0, %0, %2, %3"                      \
+                    : "=r"(_r) : "i"(f3), "r"(a), "r"(b));                     \
+  _r; })
+
+#define gng_cfu_slot_set(slot, v) do {                                         \
+  uint32_t _r;                                                                 \
+  __asm__ volatile (".insn i CUSTOM_1, 1, %0, %1, %2"                          \
+                    : "=r"(_r) : "r"((uint32_t)(v)), "i"(slot));               \
+  (void)_r; } while (0)
+#else
+// C model of neorv32_cpu_cp_cfu.vhd
+static uint32_t g_cfu_slot[2];
+
+static inline uint32_t gng_cfu_model(int f3, uint32_t a, uint32_t b) {
+  switch (f3) {
+    case GNG_CFU_DIST2: {
+      int32_t dx = (int32_t)(int16_t)a - (int16_t)b;
+      int32_t dy = (int32_t)(int16_t)(a >> 16) - (int16_t)(b >> 16);
+      return (uint32_t)dx * (uint32_t)dx + (uint32_t)dy * (uint32_t)dy;
+    }
+    case GNG_CFU_LERP: {
+      uint32_t m = (b - a) * g_cfu_slot[GNG_CFU_SLOT_EPS] + 32768u;
+      return a + (uint32_t)((int32_t)m >> 16);
+    }
+    case GNG_CFU_LERP2: {
+      uint32_t r = 0;
+      for (int h = 0; h < 32; h += 16) {
+        int32_t p = (int16_t)(a >> h);
+        uint32_t m = (uint32_t)((int16_t)(b >> h) - p) * g_cfu_slot[GNG_CFU_SLOT_EPS] + 32768u;
+        r |= (uint32_t)(uint16_t)(p + ((int32_t)m >> 16)) << h;
+      }
+      return r;
+    }
+    case GNG_CFU_PACK: {
+      int32_t v[2] = { (int32_t)a, (int32_t)b };
+      uint32_t q[2];
+      for (int k = 0; k < 2; k++)
+        q[k] = (v[k] <= 0) ? 0u : ((v[k] >> 1) > 0x7FFF) ? 0x7FFFu : (uint32_t)(v[k] >> 1);
+      return q[0] | (q[1] << 16);
+    }
+    case GNG_CFU_EIDX: {
+      uint32_t n = g_cfu_slot[GNG_CFU_SLOT_N];
+      return ((a * (2u * n - a - 1u)) >> 1) + b - a - 1u;
+    }
+    default:
+      return 0;
+  }
+}
+#define GNG_CFU_R(f3, a, b)  gng_cfu_model((f3), (uint32_t)(a), (uint32_t)(b))
+#define GNG_CFU_RS(f3, a, b) gng_cfu_model((f3), (uint32_t)(a), (uint32_t)(b))
+
+static inline void gng_cfu_slot_set(int slot, uint32_t v) {
+  g_cfu_slot[slot & 1] = v;
+}
+#endif
+
+static inline uint32_t gng_cfu_dist2(uint32_t a, uint32_t b) {
+  return GNG_CFU_R(GNG_CFU_DIST2, a, b);
+}
+
+static inline uint32_t gng_cfu_lerp(uint32_t p, uint32_t t) {
+  return GNG_CFU_RS(GNG_CFU_LERP, p, t);
+}
+
+static inline uint32_t gng_cfu_lerp2(uint32_t p, uint32_t t) {
+  return GNG_CFU_RS(GNG_CFU_LERP2, p, t);
+}
+
+static inline uint32_t gng_cfu_pack(uint32_t x, uint32_t y) {
+  return GNG_CFU_R(GNG_CFU_PACK, x, y);
+}
+
+static inline uint32_t gng_cfu_eidx(uint32_t i, uint32_t j) {
+  return GNG_CFU_RS(GNG_CFU_EIDX, i, j);
+}
+
+static inline void gng_cfu_eps(uint32_t eps_q16) {
+  gng_cfu_slot_set(GNG_CFU_SLOT_EPS, eps_q16);
+}
+
+// slot N for EIDX, gng_reset() does it
+static inline void gng_cfu_init(uint32_t max_nodes) {
+  gng_cfu_slot_set(GNG_CFU_SLOT_N, max_nodes);
+}
+
+#endif // GNG_CFU_H
@@ -0,0 +1,169 @@
+// ================================================================================
+// gng_ckpt.h - checkpoint record of the gng_core.h state (warm start)
+//
+// One record = GNG_CKPT_WORDS little-endian 32-bit words, storage agnostic
+// (the V3 firmware keeps two of them in Gowin user flash, see main.c):
+//   [0]      magic GNG_CKPT_MAGIC
+//   [1]      version (b7..0) | format (b15..8: b8 GNG_FIXED, b9 GNG_POS16,
+//            b10 GNG_UTILITY)
+//            | MAX_NODES << 16 | (GNG_DIM - 2) << 25
+//   [2]      seq (>= 1, higher = newer, picks between slots)
+//   [3]      stepCount
+//   [4]      g_err_inv (raw bits; GNG_ERR_BFP: the mantissa, errors below
+//            in its units, so a record reads the same either way)
+//   [5..]    g_act[ACT_WORDS]
+//   [..]     x, y, z[0 .. GNG_DIM-2), error (, utility) of every node (raw
+//            bits), MAX_NODES * GNG_CKPT_NODE
+//   [..]     edge_code() of every pair (0 = none, else age + 1), half matrix
+//            order, 4 cells per word (cell 0 in b7..0)
+//   [last]   CRC-32 (IEEE, reflected) of the words before it
+//
+// degree[], nbr[] and the edge cells (GNG_EDGE_STAMP: win counters restart
+// at 0) are rebuilt from the codes on load, the error
+// tournament from the errors. A record of another version, format,
+// MAX_NODES or GNG_DIM is rejected, so a reflashed firmware simply starts cold.
+//
+// gng_ckpt_write() hands word 0 over last: a write cut short leaves no
+// magic behind and the slot reads as empty.
+// ================================================================================
+
+#ifndef GNG_CKPT_H
+#define GNG_CKPT_H
+
+#include "gng_core.h"
+
+#define GNG_CKPT_MAGIC    0x4B474E47u  // "GNGK"
+#define GNG_CKPT_VERSION  1u
+
+#define GNG_CKPT_HDR      5
+#define GNG_CKPT_NODE     (GNG_DIM + 1 + GNG_UTILITY)  // words per node
+#define GNG_CKPT_WORDS    (GNG_CKPT_HDR + ACT_WORDS + GNG_CKPT_NODE * MAX_NODES + (MAX_EDGES_FULL + 3) / 4 + 1)
+
+static inline uint32_t gng_ckpt_id(void) {
+  uint32_t fmt = (GNG_FIXED ? 0x01u : 0u) | (GNG_POS16 ? 0x02u : 0u) | (GNG_UTILITY ? 0x04u : 0u);
+  return GNG_CKPT_VERSION | (fmt << 8) | ((uint32_t)MAX_NODES << 16) | ((uint32_t)(GNG_DIM - 2) << 25);
+}
+
+static uint32_t gng_crc32_word(uint32_t crc, uint32_t w) {
+  for (int b = 0; b < 32; b++) {
+    uint32_t m = -((crc ^ (w >> b)) & 1u);
+    crc = (crc >> 1) ^ (0xEDB88320u & m);
+  }
+  return crc;
+}
+
+// raw bits of pos_t / err_t (g_err_inv has the type of err_t)
+static inline uint32_t ckpt_pos_bits(pos_t v) { union { pos_t t; uint32_t u; } c; c.u = 0; c.t = v; return c.u; }
+static inline uint32_t ckpt_err_bits(err_t v) { union { err_t t; uint32_t u; } c; c.u = 0; c.t = v; return c.u; }
+static inline pos_t ckpt_pos_from(uint32_t w) { union { pos_t t; uint32_t u; } c; c.u = w; return c.t; }
+static inline err_t ckpt_err_from(uint32_t w) { union { err_t t; uint32_t u; } c; c.u = w; return c.t; }
+
+// word k of the record (k < GNG_CKPT_WORDS - 1)
+static uint32_t gng_ckpt_word(int k, uint32_t seq) {
+  if (k == 0) return GNG_CKPT_MAGIC;
+  if (k == 1) return gng_ckpt_id();
+  if (k == 2) return seq;
+  if (k == 3) return (uint32_t)stepCount;
+  if (k == 4) return ckpt_err_bits(g_err_inv);
+  k -= GNG_CKPT_HDR;
+  if (k < ACT_WORDS) return g_act[k];
+  k -= ACT_WORDS;
+  if (k < GNG_CKPT_NODE * MAX_NODES) {
+    const Node *n = &nodes[k / GNG_CKPT_NODE];
+    int c = k % GNG_CKPT_NODE;
+    if (c == 0) return ckpt_pos_bits(n->x);
+    if (c == 1) return ckpt_pos_bits(n->y);
+#if GNG_DIM > 2
+    if (c < GNG_DIM) return ckpt_pos_bits(n->z[c - 2]);
+#endif
+#if GNG_UTILITY
+    if (c > GNG_DIM) return ckpt_err_bits(err_now(k / GNG_CKPT_NODE, n->utility));
+#endif
+    return ckpt_err_bits(err_now(k / GNG_CKPT_NODE, n->error));
+  }
+  k = (k - GNG_CKPT_NODE * MAX_NODES) * 4;
+  // pair (i, j) of cell k: row i holds cells [row, row + MAX_NODES - 1 - i)
+  int i = 0, row = 0;
+  while (i < MAX_NODES - 1 && k >= row + (MAX_NODES - 1 - i)) row += MAX_NODES - 1 - i++;
+  int j = i + 1 + (k - row);
+  uint32_t w = 0;
+  for (int b = 0; b < 4 && k + b < MAX_EDGES_FULL; b++) {
+    w |= (uint32_t)edge_code(i, j) << (8 * b);
+    if (++j == MAX_NODES) { i++; j = i + 1; }
+  }
+  return w;
+}
+
+// put(k, word) for every word, word 0 last; returns the CRC word
+static uint32_t gng_ckpt_write(void (*put)(int k, uint32_t w), uint32_t seq) {
+  uint32_t crc = 0xFFFFFFFFu;
+  for (int k = 0; k < GNG_CKPT_WORDS - 1; k++) {
+    uint32_t w = gng_ckpt_word(k, seq);
+    crc = gng_crc32_word(crc, w);
+    if (k) put(k, w);
+  }
+  crc = ~crc;
+  put(GNG_CKPT_WORDS - 1, crc);
+  put(0, GNG_CKPT_MAGIC);
+  return crc;
+}
+
+// seq of a valid record, 0 = none (magic, id or CRC mismatch)
+static uint32_t gng_ckpt_check(const volatile uint32_t *r) {
+  if (r[0] != GNG_CKPT_MAGIC || r[1] != gng_ckpt_id()) return 0;
+  uint32_t crc = 0xFFFFFFFFu;
+  for (int k = 0; k < GNG_CKPT_WORDS - 1; k++) crc = gng_crc32_word(crc, r[k]);
+  if (~crc != r[GNG_CKPT_WORDS - 1]) return 0;
+  return r[2];
+}
+
+// state from a record that passed gng_ckpt_check()
+static void gng_ckpt_load(const volatile uint32_t *r) {
+  const volatile uint32_t *p = r + GNG_CKPT_HDR;
+
+  stepCount = r[3];
+  gng_lambda_sync();
+  g_err_inv = ckpt_err_from(r[4]);
+  g_qe_ema = 0;
+#if GNG_DRIFT
+  gng_drift_reset();
+#endif
+
+  for (int w = 0; w < ACT_WORDS; w++) g_act[w] = *p++;
+  for (int i = 0; i < MAX_NODES; i++) {
+    nodes[i].x = ckpt_pos_from(p[0]);
+    nodes[i].y = ckpt_pos_from(p[1]);
+#if GNG_DIM > 2
+    for (int k = 0; k < GNG_DIM - 2; k++) nodes[i].z[k] = ckpt_pos_from(p[2 + k]);
+#endif
+    nodes[i].error = ckpt_err_from(p[GNG_DIM]);
+#if GNG_UTILITY
+    nodes[i].utility = ckpt_err_from(p[GNG_DIM + 1]);
+#endif
+    err_mark_now(i);
+    nodes[i].active = (g_act[i >> 5] & GNG_BIT(i)) != 0;
+    p += GNG_CKPT_NODE;
+    node_mark_dirty(i);
+  }
+
+  edges_init_full();
+  for (int i = 0, ei = 0; i < MAX_NODES - 1; i++) {
+    for (int j = i + 1; j < MAX_NODES; j++, ei++) {
+      uint8_t c = (uint8_t)(p[ei >> 2] >> (8 * (ei & 3)));
+      if (!c) continue;
+      edge_code_set(i, j, c);
+      degree[i]++;
+      degree[j]++;
+      nbr_set(i, j);
+    }
+  }
+  emax_rebuild();
+#if GNG_GRID_BITS
+  gng_grid_rebuild();
+#endif
+#if GNG_COMPONENTS
+  gng_comp_rebuild();
+#endif
+}
+
+#endif // GNG_CKPT_H
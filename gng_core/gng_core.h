@@ -0,0 +1,2093 @@
+// ================================================================================
+// gng_core.h - portable GNG core (Fritzke), header-only C / C++
+//
+// One GNG step for every firmware target (gng_arduino, gng_picotiny,
+// gng_neorv32, V2, V3), so each board runs the same algorithm, the same
+// learning rates and the same hot-path optimizations; only the winner search
+// (software or CFS, see gng_cfs.h) and the host protocol differ.
+//
+// CONFIG (define before the #include, otherwise the defaults below):
+//   MAX_NODES         node capacity (< 256), edge table MAX_NODES*(MAX_NODES-1)/2 bytes
+//   GNG_FIXED         1 = fixed-point step (default), 0 = float
+//   GNG_POS16         1 = int16 Q1.15 positions (default on AVR), 0 = Q16.16
+//   GNG_POS_BITS      0 = full pos_t (default), p = 4..17 (..16 with GNG_POS16):
+//                     moves and midpoints round to a signed Q1.(p-1) grid
+//   GNG_ERR_BITS      error / utility width (default 32, narrower needs GNG_FIXED),
+//                     the accumulation saturates at 2^bits - 1
+//   GNG_AGE_BITS      edge age width (default 8): a_max <= 2^bits - 2
+//                     (gng_layout.h of python -m gngio precision sets all three)
+//   GNG_LAMBDA, GNG_EPSILON_B, GNG_EPSILON_N, GNG_ALPHA, GNG_A_MAX, GNG_D
+//                     learning parameters, shared by all boards
+//   GNG_PARAMS_RT     1 = the parameters above are only the defaults of g_par,
+//                     gng_params_set() changes them at runtime (V3 CMD_SET_PARAMS)
+//   GNG_DIRTY         1 = moves set g_dirty bits (backends holding node copies)
+//   GNG_NBR_DIRTY     1 = edge changes set g_nbr_dirty row bits (backends
+//                     holding nbr[] copies)
+//   GNG_FIND_WINNERS  winner search of gng_step(), default gng_find_winners_sw
+//   GNG_MOVE_SYNC     bool f(s1): the backend search already moved s1 and its
+//                     neighbors (gng_cfs.h GNG_CFS_MOVE) and f copied the new
+//                     positions back; gng_update() then only ages the edges
+//   GNG_PROFILE       1 = per-phase cycles in g_prof, GNG_CYCLES() reads the
+//                     target's cycle counter
+//   GNG_HOT           attribute of the step-path functions, e.g. a section
+//                     the target runs from on-chip RAM (PicoTiny .ramtext)
+//   GNG_MAX_DEGREE    0 = unbounded (default), else edges per node; a new edge
+//                     evicts the endpoint's oldest one instead of being dropped
+//   GNG_COMPONENTS    1 = connected-component labels g_comp[], kept per edge change
+//   GNG_GRID_BITS     0 = exhaustive winner search (default), b = 1..4: 2^b x 2^b
+//                     cell index of the Q1.15 (x, y) positions, the search
+//                     scans the probe cell and its 8 neighbors
+//   GNG_GRID_EXACT    1 = a grid result that cannot be proven exact falls
+//                     back to the full scan (default), 0 = keep it
+//   GNG_UTILITY       1 = GNG-U utility per node, a full network evicts its
+//                     least useful node for the insertion
+//   GNG_UTIL_K        eviction when error[q] > K * utility[u] (default 3)
+//   GNG_DRIFT         1 = drift boost: a rise of the fast QE over the slow one
+//                     raises the rates and speeds up insertion / aging for a while
+//   GNG_DRIFT_RISE, GNG_DRIFT_HOLD, GNG_DRIFT_EPS, GNG_DRIFT_LAMBDA,
+//   GNG_DRIFT_AMAX    its defaults (g_par with GNG_PARAMS_RT, gng_drift_set())
+//   GNG_COMPACT       1 = gng_compact(): move the active nodes to a dense prefix
+//   GNG_EDGE_STAMP    1 = edge ages as stamps of per-node win counters (default),
+//                     0 = age counters in edge_cell
+//   GNG_ERR_BFP       1 = block floating point errors (needs GNG_FIXED): a
+//                     mantissa scale under a shared exponent, per-node
+//                     exponents, renorm is O(1) instead of O(MAX_NODES)
+//   GNG_CFU           1 = dist2 / pos_step / pack_node_q15 / edge_index_ij on
+//                     the NEORV32 CFU instructions of gng_cfu.h (needs
+//                     GNG_FIXED; gng_reset() loads the unit's MAX_NODES)
+//
+// EDGE STORAGE (HALF ADJ MATRIX, NO FLAG BIT), GNG_EDGE_STAMP=0:
+//   edge_cell[ei] = 0            -> no edge (inactive)
+//   edge_cell[ei] = (age + 1)    -> edge active with true age = edge_cell - 1
+//   reset age to 0   -> edge_cell = 1
+//   age++            -> edge_cell++   (only if edge_cell != 0)
+//   delete old edges -> if edge_cell > (A_MAX + 1) then edge_cell = 0
+//
+// EDGE STAMPS (GNG_EDGE_STAMP=1):
+//   - an edge ages once per win of either end, so with g_wins[i] = wins of
+//     node i (mod 256): age(a, b) = g_wins[a] + g_wins[b] - edge_cell[ei]
+//   - reset age to 0 -> edge_cell = g_wins[a] + g_wins[b]; age++ of every
+//     winner edge -> g_wins[s1]++, one store instead of a read-modify-write
+//     per neighbor; the deletion pass reads the stamp and g_wins[i]
+//   - every win is followed by the deletion pass over the winner's edges, so
+//     no age passes A_MAX + 1 <= 255 and 8 bits never wrap an edge
+//   - nbr[] alone says which edges exist (a stamp may be 0); edge_code()
+//     gives the GNG_EDGE_STAMP=0 cell (checkpoints, host tools)
+//
+// DEGREE COUNTER:
+//   degree[i] = number of active edges incident to node i
+//   prune isolated -> if degree[i] == 0 then nodes[i].active=false
+//
+// NEIGHBOR ROWS:
+//   nbr[i] = bitset of j with an edge (i, j) (same words as
+//   g_act), set/cleared together with edge_cell and degree; winner-row scans
+//   walk these bits, so a step costs O(degree) instead of O(MAX_NODES)
+//
+// BOUNDED DEGREE (GNG_MAX_DEGREE=K):
+//   - connecting a node that already has K edges first removes its oldest
+//     edge (largest age, the one deleteOldEdges would drop next)
+//   - the winner pair always gets its edge; a neighbor left with degree 0 is
+//     pruned by the same pass as after old-edge deletion
+//   - aging, neighbor moves and insertion then touch at most K rows per step
+//
+// MAX-ERROR TOURNAMENT (emax_tree):
+//   - internal nodes hold the index of the larger-error active node below them
+//     (ties -> lower index, same as a linear scan)
+//   - lazy decay scales every error alike, so only touched nodes re-play
+//     their path (log2 EMAX_LEAVES compares); renorm rebuilds the tree
+//   - insertion reads q = emax_tree[1], free slot via ctz, f = largest error
+//     of row nbr[q] (degree many compares); no O(MAX_NODES) pass remains but
+//     the GNG_UTILITY eviction (utility_min), whose prune is the row of u
+//
+// LAZY DECAY (GLOBAL SCALING):
+//   - no per-step O(N) decay loop "error *= D"
+//   - g_err_inv = 1 / (D^k) since last renorm, error[s1] += d1 * g_err_inv
+//   - each step: g_err_inv *= (1/D)
+//   - occasional renorm: error[i] *= (1/g_err_inv), then g_err_inv = 1
+//
+// BLOCK FLOATING POINT ERRORS (GNG_ERR_BFP=1):
+//   - g_err_inv is a Q16 mantissa in [1, 2) under the shared exponent
+//     g_err_exp; node i keeps error / utility in units of its own eexp,
+//     true error = error * 2^(eexp - g_err_exp) / g_err_inv
+//   - renorm: the mantissa reached 2, halve it and g_err_exp++ (O(1), no
+//     division, no emax rebuild); no stored error changes
+//   - a node only catches up (error >>= lag, eexp = g_err_exp) when it is
+//     touched: winner accumulate, insertion, checkpoint; compares between
+//     nodes of different lags are exact (err_bfp_gt), so the emax tree stays
+//     valid without them
+//   - err_sweep() checks one node per step and brings it up to date when
+//     its lag could wrap before the next visit (at most one halving per
+//     step with D > 0.5), so uint8_t suffices; with D = 0.995 that is never
+//
+// FIXED-POINT PATH (GNG_FIXED=1):
+//   - positions pos_t = int32 Q16.16 (1.0 = 65536), CFS gets pos >> 1 (Q1.15)
+//   - distances dist_t = uint32 Q2.30 (squared Q1.15 distance, same as CFS)
+//   - error err_t = uint32 in Q16 distance units, lazy scale g_err_inv Q16
+//   - no soft-float in the step; '/' only at renorm
+//   - all shifts on uint32_t, so 16-bit int targets (AVR) get the same result
+//
+// FIELD WIDTHS (GNG_POS_BITS, GNG_ERR_BITS, GNG_AGE_BITS):
+//   - the step keeps its pos_t / err_t / edge_cell types; a position is
+//     rounded to 2^-(p-1) after every CPU move and midpoint, an error
+//     saturates at 2^e - 1 and a_max is clamped, so a build behaves as one
+//     with p / e / a bit fields would (the V2 gng.vhd node word narrows its
+//     fields to the widths of gng_layout.vhd)
+//   - not applied to GNG_MOVE_SYNC moves (the CFS move unit is Q1.15)
+//
+// 16-BIT POSITIONS (GNG_POS16=1, needs GNG_FIXED):
+//   - pos_t = int16 Q1.15, i.e. the CFS / sample word itself: 9 bytes per Node
+//     on AVR instead of 13, and pos_step is one 16x32 multiply
+//   - a neighbor move (EPS_N = 0.001) rounds to 0 once the neighbor is within
+//     ~0.015 of the sample; the winner move (EPS_B) keeps full Q1.15 steps
+//
+// CONNECTED COMPONENTS (GNG_COMPONENTS=1):
+//   - g_comp[i] = lowest node index of the component of active node i,
+//     g_comp_count components; g_comp_changes counts relabelings
+//   - nbr_set: an edge between two components relabels the one with the
+//     higher label, O(MAX_NODES) but only on a real merge
+//   - nbr_clr: bit-parallel flood from one end over nbr[] that stops when it
+//     reaches the other end (no split, the common case); a split relabels
+//     both sides, O(component size * ACT_WORDS) either way
+//   - insertion drops q - f with g_comp_bridged set: r links them again two
+//     calls later, so there is no flood (on a ring or a chain it would walk
+//     the whole component, split it and merge it back)
+//   - node_set_active: a new node is its own component, a pruned one (degree
+//     0) drops out; gng_comp_rebuild() after state is loaded wholesale
+//
+// GRID INDEX (GNG_GRID_BITS=b):
+//   - g_grid[c] = bitset of the active nodes in cell c (same words as
+//     g_act), g_cell[i] = cell of node i; node_step / node_mid move a node's
+//     bit only when its Q1.15 (x, y) crosses a cell border, activation and
+//     pruning add / drop it, gng_grid_rebuild() after bulk loads
+//   - search: candidates = OR of the 3x3 cells around the sample, the same
+//     ascending compare as the full scan over them; every node outside the
+//     block is at least m away on x or y (m = sample to block border), so
+//     best2 < m^2 proves the result equals the full scan, ties included
+//   - otherwise (or fewer than 2 candidates) the full scan runs, unless
+//     GNG_GRID_EXACT=0; with D > 2 the bound uses components 0 / 1 only
+//   - at ~40 uniformly spread nodes a 4x4 grid probes about half of them;
+//     the gain grows with MAX_NODES, an 8x8 grid pays from ~100 nodes
+//
+// UTILITY / SATURATION (GNG_UTILITY=1, GNG-U):
+//   - utility[s1] += d2 - d1 per step (d2 = node_dist(s2), one extra
+//     distance), decayed by D like the error: same g_err_inv scale, same
+//     renorm, so the step never touches the other nodes
+//   - insertion with no free slot: u = least utility node other than q / f
+//     (O(MAX_NODES) scan, once per lambda); error[q] > GNG_UTIL_K *
+//     utility[u] (the scales cancel) removes u with its edges and reuses
+//     its slot, otherwise nothing is inserted; utility[r] = mean of q / f
+//   - without GNG_UTILITY a full network returns before the q / f scans
+//
+// DRIFT BOOST (GNG_DRIFT=1, g_drift):
+//   - two EMAs of d1: g_qe_ema (QE_EMA_SHIFT, ~256 steps) and g_drift.qe_slow
+//     (QE_SLOW_SHIFT, ~4096); fast > RISE * slow marks a shift of the input
+//   - on that edge: rates * EPS (capped at 0.5), insertion every
+//     lambda / LAMBDA steps and edges dropped at a_max / AMAX; the boost
+//     holds while fast stays above and decays linearly to 1 over HOLD steps
+//   - events / latency (steps from the edge until fast fell back under
+//     (1 + RISE) / 2 * slow, the release point) are the adaptation figures
+//     a backend reports
+//   - per step: one more EMA and a 64-bit compare; no division, the boost
+//     values are derived when the parameters change
+//
+// COMPACTION (GNG_COMPACT=1, gng_compact()):
+//   - pruning leaves holes, insertion refills the lowest one, so the active
+//     set drifts apart and gng_span() (one past the highest active node,
+//     the CFS NODE_COUNT) stays above the live count
+//   - gng_compact() moves the highest active node into the lowest hole until
+//     the set is dense: node record, edge_cell ages, nbr rows and degree
+//     follow it, the emax tree replays both paths; O(degree) per move and
+//     no step state depends on a node index, so training goes on unchanged
+//   - the caller gets the (from, to) pairs for a remap event; moved nodes
+//     are dirty (the backend copies them), components / grid are rebuilt
+//
+// ACTIVE BITMASK (g_act[], kept by node_set_active):
+//   - node scans walk set bits with ctz (one instruction with Zbb) instead of
+//     testing nodes[i].active for every i
+//
+// RUNTIME PARAMETERS (GNG_PARAMS_RT=1):
+//   - gng_params_set() takes Q16 rates (1.0 = 65536, the CFS register format)
+//     and precomputes what the step needs: coef_t rates, (1/D - 1) in Q16 and
+//     a renorm threshold that keeps g_err_inv * (1/D - 1) inside 32 bit
+//   - insertion counts down g_lambda_left instead of stepCount % lambda (no
+//     division per step); gng_lambda_sync() after stepCount changes
+//
+// SAMPLES (sample_t = Q1.15 x | y << 16, the CFS XIN/YIN word):
+//   - datasets keep 4 bytes per sample, sample_x/sample_y widen for the step
+//
+// N-DIMENSIONAL INPUTS (GNG_DIM=D, 2..64):
+//   - components 0 / 1 stay Node.x / .y (snapshots, wire format, every 2D
+//     user unchanged), components 2.. live in Node.z[D - 2]; those of the
+//     sample under training in g_in_z[], set by sample_load_z() before
+//     gng_step() / gng_update() (file-scope like the rest of the state)
+//   - sample_t is GNG_WORDS = ceil(D/2) words, word k = components 2k | 2k+1
+//     << 16 (the CFS node / sample layout, the missing half of an odd D is 0)
+//   - distance: per word (dx^2 + dy^2) >> GNG_DIST_SHIFT (log2 of GNG_WORDS,
+//     rounded up), so D components stay inside uint32 Q2.30 and the CPU
+//     search matches the CFS bit for bit; D = 2 is the plain dist2()
+//   - every loop over z[] has the constant bound D - 2, so moves, insertion
+//     and the search unroll for small D and a 2D build has none of it
+// ================================================================================
+
+#ifndef GNG_CORE_H
+#define GNG_CORE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// ---------------- GNG parameters (Fritzke) ----------------
+#ifndef GNG_LAMBDA
+#define GNG_LAMBDA      100
+#endif
+#ifndef GNG_EPSILON_B
+#define GNG_EPSILON_B   0.3f
+#endif
+#ifndef GNG_EPSILON_N
+#define GNG_EPSILON_N   0.001f
+#endif
+#ifndef GNG_ALPHA
+#define GNG_ALPHA       0.5f
+#endif
+#ifndef GNG_A_MAX
+#define GNG_A_MAX       50
+#endif
+#ifndef GNG_D
+#define GNG_D           0.995f
+#endif
+
+#ifndef GNG_FIXED
+#define GNG_FIXED       1
+#endif
+#ifndef GNG_PARAMS_RT
+#define GNG_PARAMS_RT   0
+#endif
+#ifndef GNG_POS16
+#if defined(__AVR__) && GNG_FIXED
+#define GNG_POS16       1
+#else
+#define GNG_POS16       0
+#endif
+#endif
+#if GNG_POS16 && !GNG_FIXED
+#error "GNG_POS16 needs GNG_FIXED"
+#endif
+#ifndef GNG_POS_BITS
+#define GNG_POS_BITS    0
+#endif
+#if GNG_POS_BITS && (!GNG_FIXED || GNG_POS_BITS < 4 || GNG_POS_BITS > (GNG_POS16 ? 16 : 17))
+#error "GNG_POS_BITS: 0 or 4..17 (4..16 with GNG_POS16), needs GNG_FIXED"
+#endif
+#ifndef GNG_ERR_BITS
+#define GNG_ERR_BITS    32
+#endif
+#if GNG_ERR_BITS < 8 || GNG_ERR_BITS > 32 || (GNG_ERR_BITS < 32 && !GNG_FIXED)
+#error "GNG_ERR_BITS: 8..32 (below 32 needs GNG_FIXED)"
+#endif
+#ifndef GNG_AGE_BITS
+#define GNG_AGE_BITS    8
+#endif
+#if GNG_AGE_BITS < 2 || GNG_AGE_BITS > 8
+#error "GNG_AGE_BITS: 2..8 (edge_cell is 8 bits)"
+#endif
+#define GNG_AGE_LIMIT   ((1u << GNG_AGE_BITS) - 2u)  // largest a_max
+#if GNG_A_MAX > GNG_AGE_LIMIT
+#error "GNG_A_MAX does not fit GNG_AGE_BITS"
+#endif
+#ifndef GNG_DIRTY
+#define GNG_DIRTY       0
+#endif
+#ifndef GNG_NBR_DIRTY
+#define GNG_NBR_DIRTY   0
+#endif
+#ifndef GNG_COMPONENTS
+#define GNG_COMPONENTS  0
+#endif
+#ifndef GNG_GRID_BITS
+#define GNG_GRID_BITS   0
+#endif
+#ifndef GNG_GRID_EXACT
+#define GNG_GRID_EXACT  1
+#endif
+#if GNG_GRID_BITS < 0 || GNG_GRID_BITS > 4
+#error "GNG_GRID_BITS must be 0..4 (g_cell[] is uint8_t)"
+#endif
+#ifndef GNG_UTILITY
+#define GNG_UTILITY     0
+#endif
+#ifndef GNG_UTIL_K
+#define GNG_UTIL_K      3u
+#endif
+#ifndef GNG_PROFILE
+#define GNG_PROFILE     0
+#endif
+#ifndef GNG_HOT
+#define GNG_HOT
+#endif
+#ifndef GNG_MAX_DEGREE
+#define GNG_MAX_DEGREE  0
+#endif
+#if GNG_MAX_DEGREE == 1 || GNG_MAX_DEGREE > 255
+#error "GNG_MAX_DEGREE: 0 (unbounded) or 2..255"
+#endif
+#ifndef QE_EMA_SHIFT
+#define QE_EMA_SHIFT    8  // QE EMA over ~256 steps
+#endif
+#ifndef GNG_COMPACT
+#define GNG_COMPACT     0
+#endif
+#ifndef GNG_EDGE_STAMP
+#define GNG_EDGE_STAMP  1
+#endif
+#ifndef GNG_DRIFT
+#define GNG_DRIFT       0
+#endif
+#ifndef GNG_CFU
+#define GNG_CFU         0
+#endif
+#if GNG_CFU && !GNG_FIXED
+#error "GNG_CFU needs GNG_FIXED (the CFU works on Q16.16 / Q1.15 words)"
+#endif
+#ifndef GNG_ERR_BFP
+#define GNG_ERR_BFP     0
+#endif
+#if GNG_ERR_BFP && !GNG_FIXED
+#error "GNG_ERR_BFP needs GNG_FIXED (integer mantissas)"
+#endif
+#ifndef QE_SLOW_SHIFT
+#define QE_SLOW_SHIFT   12 // drift reference EMA over ~4096 steps
+#endif
+#ifndef GNG_DRIFT_RISE
+#define GNG_DRIFT_RISE    1.5f  // fast / slow QE that starts a boost, 0 = off
+#endif
+#ifndef GNG_DRIFT_HOLD
+#define GNG_DRIFT_HOLD    2000  // steps of the decay back to the normal rates
+#endif
+#ifndef GNG_DRIFT_EPS
+#define GNG_DRIFT_EPS     4.0f  // rate multiplier at the start of a boost
+#endif
+#ifndef GNG_DRIFT_LAMBDA
+#define GNG_DRIFT_LAMBDA  4     // lambda divisor while boosted
+#endif
+#ifndef GNG_DRIFT_AMAX
+#define GNG_DRIFT_AMAX    2     // a_max divisor while boosted
+#endif
+
+// ---------------- Limits ----------------
+#ifndef GNG_DIM
+#define GNG_DIM         2
+#endif
+#if GNG_DIM < 2 || GNG_DIM > 64
+#error "GNG_DIM must be 2..64"
+#endif
+#define GNG_WORDS      ((GNG_DIM + 1) / 2)  // Q1.15 pairs per node / sample
+#define GNG_DIST_SHIFT ((GNG_WORDS <= 1) ? 0 : (GNG_WORDS <= 2) ? 1 : (GNG_WORDS <= 4) ? 2 : \
+                        (GNG_WORDS <= 8) ? 3 : (GNG_WORDS <= 16) ? 4 : 5)
+
+#ifndef MAX_NODES
+#define MAX_NODES      20
+#endif
+#define MAX_EDGES_FULL ((MAX_NODES * (MAX_NODES - 1)) / 2)
+#define ACT_WORDS      ((MAX_NODES + 31) / 32)
+#define EMAX_LEAVES    ((MAX_NODES <= 16) ? 16 : (MAX_NODES <= 32) ? 32 : \
+                        (MAX_NODES <= 64) ? 64 : (MAX_NODES <= 128) ? 128 : 256)
+
+#define GNG_BIT(i)     ((uint32_t)1u << ((i) & 31))
+#define GNG_CTZ(m)     __builtin_ctzl(m)  // long: 32 bit on AVR and RV32
+
+#if GNG_CFU
+#include "gng_cfu.h"
+#endif
+
+// ---------------- Number formats ----------------
+#if GNG_FIXED
+#if GNG_POS16
+typedef int16_t  pos_t;   // Q1.15
+#define POS_CONST(v)   ((pos_t)((v) * 32768.0f + 0.5f))
+#else
+typedef int32_t  pos_t;   // Q16.16
+#define POS_CONST(v)   ((pos_t)((v) * 65536.0f + 0.5f))
+#endif
+typedef uint32_t dist_t;  // Q2.30 (squared Q1.15 distance, same as CFS)
+typedef uint32_t err_t;   // Q16 distance units, scaled by g_err_inv
+typedef int32_t  coef_t;  // Q16 rate
+#define COEF_CONST(v)  ((coef_t)((v) * 65536.0f + 0.5f))
+#define DIST_MAX       0xFFFFFFFFu
+#define ERR_MAX        ((err_t)(0xFFFFFFFFu >> (32 - GNG_ERR_BITS)))
+#else
+typedef float pos_t;
+typedef float dist_t;
+typedef float err_t;
+typedef float coef_t;
+#define POS_CONST(v)   (v)
+#define COEF_CONST(v)  (v)
+#define DIST_MAX       1e30f
+#endif
+
+// ---------------- Lazy decay control ----------------
+#if GNG_FIXED
+// g_err_inv in Q16; per step g += g * (1/D - 1)
+#define GNG_D_INV_FRAC     ((uint32_t)((1.0f / GNG_D - 1.0f) * 65536.0f + 0.5f))
+// renorm at 16.0 (~555 steps for D=0.995) keeps err_accum() inside 32 bit
+#define ERR_INV_RENORM_TH  ((uint32_t)1u << 20)
+#define ERR_INV_ONE        ((uint32_t)1u << 16)
+#else
+#define GNG_D_INV (1.0f / GNG_D)
+// renorm threshold; 1e6 renormalizes about every 2.7k steps at D=0.995
+#define ERR_INV_RENORM_TH  1.0e6f
+#define ERR_INV_ONE        1.0f
+#endif
+
+// ---------------- Parameters of the step (constants or g_par) ----------------
+#if GNG_DRIFT
+#define DRIFT_RISE_Q16  ((uint32_t)(GNG_DRIFT_RISE * 65536.0f + 0.5f))
+#define DRIFT_EPS_Q16   ((uint32_t)(GNG_DRIFT_EPS * 65536.0f + 0.5f))
+#define DRIFT_LAMBDA_C  ((GNG_LAMBDA / GNG_DRIFT_LAMBDA) ? (GNG_LAMBDA / GNG_DRIFT_LAMBDA) : 1u)
+#define DRIFT_AMAX_C    ((GNG_A_MAX / GNG_DRIFT_AMAX) ? (GNG_A_MAX / GNG_DRIFT_AMAX) : 1u)
+#if GNG_FIXED
+#define DRIFT_DEC_C     ((coef_t)((DRIFT_EPS_Q16 - 65536u) / GNG_DRIFT_HOLD))
+#else
+#define DRIFT_DEC_C     ((GNG_DRIFT_EPS - 1.0f) / (float)GNG_DRIFT_HOLD)
+#endif
+#endif
+
+#if GNG_PARAMS_RT
+typedef struct {
+  uint32_t lambda;          // >= 1
+  uint32_t a_max;           // <= GNG_AGE_LIMIT (254: ages fit 8 bits)
+  coef_t   eps_b, eps_n, alpha;
+  uint32_t d_q16;           // D as set, Q16
+#if GNG_FIXED
+  uint32_t d_inv_frac;      // (1/D - 1) in Q16
+  uint32_t renorm_th;
+#else
+  float    d_inv;
+#endif
+#if GNG_DRIFT
+  uint32_t drift_rise;      // Q16, 0 = off
+  uint32_t drift_hold;      // >= 1
+  uint32_t drift_eps;       // Q16, >= 1.0
+  uint32_t drift_lambda_div, drift_amax_div;
+  uint32_t drift_lambda;    // derived: lambda / div, a_max / div, per-step decay
+  uint32_t drift_amax;
+  coef_t   drift_dec;
+#endif
+} gng_params_t;
+
+static gng_params_t g_par = {
+  GNG_LAMBDA, GNG_A_MAX,
+  COEF_CONST(GNG_EPSILON_B), COEF_CONST(GNG_EPSILON_N), COEF_CONST(GNG_ALPHA),
+  (uint32_t)(GNG_D * 65536.0f + 0.5f),
+#if GNG_FIXED
+  GNG_D_INV_FRAC, ERR_INV_RENORM_TH,
+#else
+  GNG_D_INV,
+#endif
+#if GNG_DRIFT
+  DRIFT_RISE_Q16, GNG_DRIFT_HOLD, DRIFT_EPS_Q16, GNG_DRIFT_LAMBDA, GNG_DRIFT_AMAX,
+  DRIFT_LAMBDA_C, DRIFT_AMAX_C, DRIFT_DEC_C,
+#endif
+};
+
+#define EPS_B          g_par.eps_b
+#define EPS_N          g_par.eps_n
+#define ALPHA          g_par.alpha
+#define PAR_A_MAX      g_par.a_max
+#if GNG_FIXED
+#define PAR_D_INV      g_par.d_inv_frac
+#define PAR_RENORM_TH  g_par.renorm_th
+#else
+#define PAR_D_INV      g_par.d_inv
+#define PAR_RENORM_TH  ERR_INV_RENORM_TH
+#endif
+#define PAR_DRIFT_RISE    g_par.drift_rise
+#define PAR_DRIFT_HOLD    g_par.drift_hold
+#define PAR_DRIFT_EPS     g_par.drift_eps
+#define PAR_DRIFT_LAMBDA  g_par.drift_lambda
+#define PAR_DRIFT_AMAX    g_par.drift_amax
+#define PAR_DRIFT_DEC     g_par.drift_dec
+#else
+#define EPS_B          COEF_CONST(GNG_EPSILON_B)
+#define EPS_N          COEF_CONST(GNG_EPSILON_N)
+#define ALPHA          COEF_CONST(GNG_ALPHA)
+#define PAR_A_MAX      GNG_A_MAX
+#if GNG_FIXED
+#define PAR_D_INV      GNG_D_INV_FRAC
+#else
+#define PAR_D_INV      GNG_D_INV
+#endif
+#define PAR_RENORM_TH  ERR_INV_RENORM_TH
+#define PAR_DRIFT_RISE    DRIFT_RISE_Q16
+#define PAR_DRIFT_HOLD    GNG_DRIFT_HOLD
+#define PAR_DRIFT_EPS     DRIFT_EPS_Q16
+#define PAR_DRIFT_LAMBDA  DRIFT_LAMBDA_C
+#define PAR_DRIFT_AMAX    DRIFT_AMAX_C
+#define PAR_DRIFT_DEC     DRIFT_DEC_C
+#endif
+
+// ---------------- Profiling hooks ----------------
+#if GNG_PROFILE
+#ifndef GNG_CYCLES
+#error "GNG_PROFILE needs GNG_CYCLES() (free-running 32 bit cycle counter)"
+#endif
+
+typedef struct {
+  uint32_t cyc_total;
+  uint32_t cyc_winner;     // winner search
+  uint32_t cyc_move_w;     // move winner
+  uint32_t cyc_nb;         // age edges + move neighbors
+  uint32_t cyc_connect;    // connectOrResetEdge
+  uint32_t cyc_delete;     // deleteOldEdgesFromWinner
+  uint32_t cyc_prune;      // pruneIsolatedNodes_degree
+  uint32_t cyc_insert;     // insertNode_fritzke (only when called)
+  uint32_t cyc_renorm;     // error_renorm_if_needed (only when renorm)
+  uint32_t cyc_overlap;    // CPU work done while the CFS searched (CFS_USE_IRQ)
+} Prof;
+
+static Prof g_prof = {0};
+
+#define GNG_PROF(field, cyc)  (g_prof.field = (uint32_t)(cyc))
+
+static inline void gng_prof_clear(void) {
+  g_prof.cyc_total = g_prof.cyc_winner = g_prof.cyc_move_w = 0;
+  g_prof.cyc_nb = g_prof.cyc_connect = g_prof.cyc_delete = 0;
+  g_prof.cyc_prune = g_prof.cyc_insert = g_prof.cyc_renorm = 0;
+  g_prof.cyc_overlap = 0;
+}
+#else
+#undef  GNG_CYCLES
+#define GNG_CYCLES()          0u
+#define GNG_PROF(field, cyc)  ((void)(cyc))
+static inline void gng_prof_clear(void) { }
+#endif
+
+// ---------------- State ----------------
+// Samples as the CFS takes them: Q1.15 x | (Q1.15 y << 16)
+#if GNG_DIM > 2
+typedef struct { uint32_t w[GNG_WORDS]; } sample_t;  // w[k] = components 2k | 2k+1 << 16
+#else
+typedef uint32_t sample_t;
+#endif
+
+typedef struct {
+  pos_t x, y;
+#if GNG_DIM > 2
+  pos_t z[GNG_DIM - 2];  // components 2 .. GNG_DIM-1
+#endif
+  err_t error;   // NOTE: scaled error under lazy decay
+#if GNG_UTILITY
+  err_t utility; // scaled like error
+#endif
+  bool  active;
+#if GNG_ERR_BFP
+  uint8_t eexp;  // exponent of error / utility (g_err_exp when last touched)
+#endif
+} Node;
+
+static Node nodes[MAX_NODES];
+
+#if GNG_DIM > 2
+// components 2.. of the sample of the current step (sample_load_z)
+static pos_t g_in_z[GNG_DIM - 2];
+#endif
+
+// Active bitmask: bit i of g_act[i/32] == nodes[i].active
+static uint32_t g_act[ACT_WORDS];
+
+#if GNG_DIRTY
+// Nodes moved since the backend last copied them
+static uint32_t g_dirty[ACT_WORDS];
+#endif
+
+#if GNG_NBR_DIRTY
+// nbr[] rows changed since the backend last copied them
+static uint32_t g_nbr_dirty[ACT_WORDS];
+#endif
+
+// Max-error tournament tree: emax_tree[1] = node with the largest error
+static uint8_t emax_tree[EMAX_LEAVES];
+
+// Degree counter: number of active edges incident to each node
+static uint8_t degree[MAX_NODES];
+
+// Half adjacency matrix + neighbor rows
+static uint8_t  edge_cell[MAX_EDGES_FULL];
+static uint32_t nbr[MAX_NODES][ACT_WORDS];
+#if GNG_EDGE_STAMP
+static uint8_t  g_wins[MAX_NODES];  // wins of each node, mod 256 (edge stamps)
+#endif
+
+static uint32_t stepCount = 0;  // uint32: int is 16 bit on AVR
+
+// structural changes (node active flips, edge add/remove)
+static uint32_t g_topo_changes = 0;
+static uint32_t g_inserts = 0;  // nodes inserted (Fritzke / DBL), total
+static uint32_t g_renorms = 0;  // error_renorm_if_needed() that ran (total)
+
+#if GNG_GRID_BITS
+#define GRID_N      (1 << GNG_GRID_BITS)
+#define GRID_SHIFT  (15 - GNG_GRID_BITS)  // Q1.15 -> cell coordinate
+// active nodes per cell, cell of every active node
+static uint32_t g_grid[GRID_N * GRID_N][ACT_WORDS];
+static uint8_t  g_cell[MAX_NODES];
+#endif
+
+#if GNG_COMPONENTS
+// component label (lowest node index) of every active node
+static uint8_t  g_comp[MAX_NODES];
+static uint16_t g_comp_count   = 0;
+static uint32_t g_comp_changes = 0;
+static bool     g_comp_bridged = false;  // nbr_clr: the caller reconnects both ends
+#endif
+static dist_t   g_qe_ema = 0;
+
+#if GNG_DRIFT
+typedef struct {
+  dist_t   qe_slow;   // QE_SLOW_SHIFT EMA of d1, the reference of g_qe_ema
+  uint32_t left;      // boost steps to go, 0 = normal rates
+  coef_t   mul;       // rate multiplier now (Q16 / float)
+  bool     hi;        // fast QE above RISE * slow
+  uint32_t events;    // boosts started
+  uint32_t t0;        // stepCount of the last start
+  uint32_t latency;   // steps from the last start until hi fell
+} gng_drift_t;
+
+static gng_drift_t g_drift;
+
+static inline void gng_drift_reset(void) {
+  g_drift.qe_slow = 0;
+  g_drift.left = 0;
+  g_drift.mul = COEF_CONST(1.0f);
+  g_drift.hi = false;
+  g_drift.events = g_drift.t0 = g_drift.latency = 0;
+}
+
+static inline bool drift_boosted(void) { return g_drift.left != 0; }
+#else
+static inline bool drift_boosted(void) { return false; }
+#endif
+
+// global scaling for lazy decay: g_err_inv = 1/(D^k) since last renorm
+#if GNG_FIXED
+static uint32_t g_err_inv = ERR_INV_ONE;
+#else
+static float g_err_inv = ERR_INV_ONE;
+#endif
+
+#if GNG_ERR_BFP
+static uint8_t g_err_exp = 0;    // shared exponent, g_err_inv is its mantissa
+static uint8_t g_err_sweep = 0;  // next node err_sweep() checks
+
+// halvings of g_err_inv since node i was last touched (< 256, err_sweep)
+static inline uint32_t err_lag(int i) { return (uint8_t)(g_err_exp - nodes[i].eexp); }
+
+static inline err_t err_shr(err_t e, uint32_t k) { return (k < 32u) ? (e >> k) : 0u; }
+
+// a * 2^-la > b * 2^-lb, exact for any two lags
+static inline bool err_bfp_gt(uint64_t a, uint32_t la, uint64_t b, uint32_t lb) {
+  if (la == lb) return a > b;
+  if (la < lb) {
+    uint32_t s = lb - la;
+    return a > ((s < 64u) ? (b >> s) : 0u);
+  }
+  uint32_t s = la - lb;
+  return a != 0u && b <= ((s < 64u) ? ((a - 1u) >> s) : 0u);
+}
+#endif
+
+// error / utility e of node i in units of the current scale
+static inline err_t err_now(int i, err_t e) {
+#if GNG_ERR_BFP
+  return err_shr(e, err_lag(i));
+#else
+  (void)i;
+  return e;
+#endif
+}
+
+// node i catches up with the current scale (before an add or a mean)
+static inline void err_touch(int i) {
+#if GNG_ERR_BFP
+  uint32_t k = err_lag(i);
+  if (!k) return;
+  nodes[i].error = err_shr(nodes[i].error, k);
+#if GNG_UTILITY
+  nodes[i].utility = err_shr(nodes[i].utility, k);
+#endif
+  nodes[i].eexp = g_err_exp;
+#else
+  (void)i;
+#endif
+}
+
+// error / utility of node i were just set in units of the current scale
+static inline void err_mark_now(int i) {
+#if GNG_ERR_BFP
+  nodes[i].eexp = g_err_exp;
+#else
+  (void)i;
+#endif
+}
+
+// error[a] > error[b] (ties -> false)
+static inline bool err_node_gt(int a, int b) {
+#if GNG_ERR_BFP
+  if (nodes[a].eexp != nodes[b].eexp)
+    return err_bfp_gt(nodes[a].error, err_lag(a), nodes[b].error, err_lag(b));
+#endif
+  return nodes[a].error > nodes[b].error;
+}
+
+// ---------------- insertion schedule (every lambda steps) ----------------
+#if GNG_PARAMS_RT
+static uint32_t g_lambda_left = GNG_LAMBDA;  // steps to the next insertion
+
+// after stepCount was set: the next insertion where stepCount % lambda says
+static inline void gng_lambda_sync(void) {
+  g_lambda_left = g_par.lambda - (stepCount % g_par.lambda);
+}
+
+// called after stepCount++
+static inline bool gng_insert_due(void) {
+  if (--g_lambda_left) return false;
+#if GNG_DRIFT
+  g_lambda_left = drift_boosted() ? g_par.drift_lambda : g_par.lambda;
+#else
+  g_lambda_left = g_par.lambda;
+#endif
+  return true;
+}
+
+#if GNG_DRIFT
+// boost values that depend on lambda / a_max
+static void drift_derive(void) {
+  uint32_t l = g_par.lambda / g_par.drift_lambda_div;
+  uint32_t a = g_par.a_max / g_par.drift_amax_div;
+  g_par.drift_lambda = l ? l : 1u;
+  g_par.drift_amax = a ? a : 1u;
+#if GNG_FIXED
+  g_par.drift_dec = (coef_t)((g_par.drift_eps - 65536u) / g_par.drift_hold);
+#else
+  g_par.drift_dec = ((float)g_par.drift_eps * (1.0f / 65536.0f) - 1.0f) / (float)g_par.drift_hold;
+#endif
+}
+
+// drift boost: rise Q16 (0 = off), hold steps, eps Q16 multiplier,
+// lambda / a_max divisors; out of range values are clamped
+static void gng_drift_set(uint32_t rise, uint32_t hold, uint32_t eps,
+                          uint32_t lambda_div, uint32_t amax_div) {
+  if (rise && rise < 65536u) rise = 65536u;
+  if (hold < 1u) hold = 1u;
+  if (hold > 0xFFFFu) hold = 0xFFFFu;
+  if (eps < 65536u) eps = 65536u;
+  if (eps > 16u * 65536u) eps = 16u * 65536u;
+  if (lambda_div < 1u) lambda_div = 1u;
+  if (amax_div < 1u) amax_div = 1u;
+
+  g_par.drift_rise = rise;
+  g_par.drift_hold = hold;
+  g_par.drift_eps = eps;
+  g_par.drift_lambda_div = lambda_div;
+  g_par.drift_amax_div = amax_div;
+  drift_derive();
+  if (!rise) { g_drift.left = 0; g_drift.hi = false; g_drift.mul = COEF_CONST(1.0f); }
+}
+#endif
+
+// new parameters, Q16 rates (1.0 = 65536); out of range values are clamped,
+// eps_b / eps_n to 0.5: the Q16.16 pos_step() product is int32 (and so are
+// the CFU LERP and the CFS move unit)
+static void gng_params_set(uint32_t lambda, uint32_t a_max, uint32_t eps_b,
+                           uint32_t eps_n, uint32_t alpha, uint32_t d) {
+  if (lambda < 1u) lambda = 1u;
+  if (a_max > GNG_AGE_LIMIT) a_max = GNG_AGE_LIMIT;
+  if (eps_b > 32768u) eps_b = 32768u;
+  if (eps_n > 32768u) eps_n = 32768u;
+  if (alpha > 65536u) alpha = 65536u;
+  if (d <= 32768u) d = 32769u;            // D > 0.5 keeps renorm_th above ERR_INV_ONE
+  if (d > 65536u) d = 65536u;
+
+  g_par.lambda = lambda;
+  g_par.a_max = a_max;
+  g_par.d_q16 = d;
+#if GNG_FIXED
+  g_par.eps_b = (coef_t)eps_b;
+  g_par.eps_n = (coef_t)eps_n;
+  g_par.alpha = (coef_t)alpha;
+  // Q16 of 1/D - 1; the decay step multiplies it with g_err_inv <= renorm_th
+  uint32_t frac = (uint32_t)((((uint64_t)1u << 32) + d / 2u) / d) - ERR_INV_ONE;
+  uint32_t th = frac ? (0xFFFFFFFFu / frac) : ((uint32_t)1u << 20);
+  g_par.d_inv_frac = frac;
+  g_par.renorm_th = (th < ((uint32_t)1u << 20)) ? th : ((uint32_t)1u << 20);
+#else
+  g_par.eps_b = (float)eps_b * (1.0f / 65536.0f);
+  g_par.eps_n = (float)eps_n * (1.0f / 65536.0f);
+  g_par.alpha = (float)alpha * (1.0f / 65536.0f);
+  g_par.d_inv = 65536.0f / (float)d;
+#endif
+#if GNG_DRIFT
+  drift_derive();
+#endif
+  gng_lambda_sync();
+}
+#else
+static inline void gng_lambda_sync(void) { }
+#if GNG_DRIFT
+static inline bool gng_insert_due(void) {
+  return (stepCount % (drift_boosted() ? PAR_DRIFT_LAMBDA : GNG_LAMBDA)) == 0;
+}
+#else
+static inline bool gng_insert_due(void) { return (stepCount % GNG_LAMBDA) == 0; }
+#endif
+#endif
+
+// ============================ Utility ===========================================
+#if GNG_POS16
+static inline uint16_t pos_to_q15(pos_t v) {
+  return (v <= 0) ? 0u : (uint16_t)v;
+}
+
+static inline pos_t pos_from_q15(uint32_t q) {
+  return (pos_t)q;
+}
+
+static inline int16_t pos_to_wire(pos_t v) {
+  return (int16_t)(((int32_t)v * 1000) >> 15);
+}
+
+// p + eps * (t - p), rounded; t - p fits int16 for p, t in [0, 1)
+static inline pos_t pos_step(pos_t p, pos_t t, coef_t eps) {
+  return (pos_t)(p + ((eps * (int32_t)(t - p) + 32768) >> 16));
+}
+
+static inline pos_t pos_mid(pos_t a, pos_t b) {
+  return (pos_t)(((int32_t)a + b) >> 1);
+}
+#elif GNG_FIXED
+static inline uint16_t pos_to_q15(pos_t v) {
+  if (v <= 0) return 0;
+  v >>= 1;
+  if (v > 0x7FFF) return 0x7FFF;
+  return (uint16_t)v;
+}
+
+static inline pos_t pos_from_q15(uint32_t q) {
+  return (pos_t)(q << 1);
+}
+
+static inline int16_t pos_to_wire(pos_t v) {
+  return (int16_t)((v * 1000) >> 16);
+}
+
+// p + eps * (t - p), rounded; eps <= 0.5 (gng_params_set, drift_rate) keeps
+// the product inside int32 for p, t in [0, 1)
+static inline pos_t pos_step(pos_t p, pos_t t, coef_t eps) {
+  return p + ((eps * (t - p) + 32768) >> 16);
+}
+
+static inline pos_t pos_mid(pos_t a, pos_t b) {
+  return (a + b) >> 1;
+}
+#endif
+
+#if GNG_POS_BITS
+// nearest multiple of 2^-(GNG_POS_BITS-1), [0, 1) stays inside [0, 1)
+#define POS_QSH ((GNG_POS16 ? 16 : 17) - GNG_POS_BITS)
+static inline pos_t pos_quant(pos_t v) {
+  const int32_t step = (int32_t)1 << POS_QSH;
+  int32_t r = ((int32_t)v + (step >> 1)) & -step;
+#if GNG_POS16
+  if (r > 0x7FFF) r -= step;
+#endif
+  return (pos_t)r;
+}
+#else
+static inline pos_t pos_quant(pos_t v) { return v; }
+#endif
+
+#if GNG_FIXED
+static inline dist_t dist2(pos_t x1, pos_t y1, pos_t x2, pos_t y2) {
+#if GNG_CFU && !GNG_POS16
+  return gng_cfu_dist2(gng_cfu_pack((uint32_t)x1, (uint32_t)y1), gng_cfu_pack((uint32_t)x2, (uint32_t)y2));
+#elif GNG_CFU
+  return gng_cfu_dist2(pos_to_q15(x1) | ((uint32_t)pos_to_q15(y1) << 16),
+                       pos_to_q15(x2) | ((uint32_t)pos_to_q15(y2) << 16));
+#else
+  int32_t dx = (int32_t)pos_to_q15(x1) - (int32_t)pos_to_q15(x2);
+  int32_t dy = (int32_t)pos_to_q15(y1) - (int32_t)pos_to_q15(y2);
+  return (uint32_t)(dx*dx) + (uint32_t)(dy*dy);
+#endif
+}
+
+static inline dist_t dist_from_q30(uint32_t q30) {
+  return q30;
+}
+
+static inline uint32_t dist_to_q30(dist_t d) {
+  return d;
+}
+
+static inline err_t err_scale(err_t e, coef_t c) {
+  return (err_t)(((uint64_t)e * (uint32_t)c) >> 16);
+}
+#else
+static inline float dist2(float x1, float y1, float x2, float y2) {
+  float dx = x1 - x2;
+  float dy = y1 - y2;
+  return dx*dx + dy*dy;
+}
+
+static inline uint16_t pos_to_q15(float v) {
+  if (v <= 0.0f) return 0;
+  if (v >= 0.9999694824f) return 0x7FFF;
+  int32_t q = (int32_t)(v * 32768.0f + 0.5f);
+  if (q > 0x7FFF) q = 0x7FFF;
+  return (uint16_t)q;
+}
+
+static inline float pos_from_q15(uint32_t q) {
+  return (float)q * (1.0f / 32768.0f);
+}
+
+static inline int16_t pos_to_wire(float v) {
+  return (int16_t)(v * 1000.0f);
+}
+
+static inline float pos_step(float p, float t, float eps) {
+  return p + eps * (t - p);
+}
+
+static inline float pos_mid(float a, float b) {
+  return 0.5f * (a + b);
+}
+
+static inline float dist_from_q30(uint32_t q30) {
+  return (float)q30 / 1073741824.0f; // 2^30
+}
+
+static inline uint32_t dist_to_q30(float d) {
+  float q = d * 1073741824.0f;
+  return (q >= 4294967040.0f) ? 0xFFFFFFFFu : (uint32_t)q;
+}
+
+static inline float err_scale(float e, float c) {
+  return e * c;
+}
+#endif
+
+static inline uint32_t pack_node_q15(pos_t x, pos_t y) {
+#if GNG_CFU && !GNG_POS16
+  return gng_cfu_pack((uint32_t)x, (uint32_t)y);
+#else
+  uint16_t xq = pos_to_q15(x);
+  uint16_t yq = pos_to_q15(y);
+  return ((uint32_t)xq) | (((uint32_t)yq) << 16);
+#endif
+}
+
+// wire format: int16 = value * 1000 -> Q1.15 (v * 32768 / 1000 = v * 4096 / 125)
+static inline uint32_t q15_from_wire(int16_t v) {
+  if (v <= 0) return 0;
+  uint32_t q = ((uint32_t)v * 4096u + 62u) / 125u;
+  return (q > 0x7FFFu) ? 0x7FFFu : q;
+}
+
+#if GNG_DIM > 2
+static inline uint32_t sample_word0(sample_t s) { return s.w[0]; }
+
+// g_in_z[] = components 2.. of s
+static inline void sample_load_z(const sample_t *s) {
+  for (int k = 0; k < GNG_DIM - 2; k++) {
+    g_in_z[k] = pos_from_q15((s->w[1 + (k >> 1)] >> (16 * (k & 1))) & 0xFFFFu);
+  }
+}
+
+// CFS word w >= 1 of the components 2.. in z[]: z[2w-2] | z[2w-1] << 16
+static inline uint32_t pack_z_q15(const pos_t *z, int w) {
+  int k = 2 * w - 2;
+  uint32_t v = pos_to_q15(z[k]);
+  if (k + 1 < GNG_DIM - 2) v |= (uint32_t)pos_to_q15(z[k + 1]) << 16;
+  return v;
+}
+#else
+static inline uint32_t sample_word0(sample_t s) { return s; }
+static inline void sample_load_z(const sample_t *s) { (void)s; }
+#endif
+
+static inline pos_t sample_x(sample_t s) { return pos_from_q15(sample_word0(s) & 0xFFFFu); }
+static inline pos_t sample_y(sample_t s) { return pos_from_q15(sample_word0(s) >> 16); }
+
+// squared distance of node i to the sample (x, y, g_in_z), CFS word by word
+static inline dist_t node_dist(int i, pos_t x, pos_t y) {
+#if GNG_DIM > 2
+  const pos_t *z = nodes[i].z;
+#if GNG_FIXED
+  dist_t d = dist2(x, y, nodes[i].x, nodes[i].y) >> GNG_DIST_SHIFT;
+  for (int k = 0; k < GNG_DIM - 2; k += 2) {
+    int32_t da = (int32_t)pos_to_q15(g_in_z[k]) - (int32_t)pos_to_q15(z[k]);
+    uint32_t p = (uint32_t)(da * da);
+    if (k + 1 < GNG_DIM - 2) {
+      int32_t db = (int32_t)pos_to_q15(g_in_z[k + 1]) - (int32_t)pos_to_q15(z[k + 1]);
+      p += (uint32_t)(db * db);
+    }
+    d += p >> GNG_DIST_SHIFT;
+  }
+  return d;
+#else
+  float d = dist2(x, y, nodes[i].x, nodes[i].y);
+  for (int k = 0; k < GNG_DIM - 2; k++) {
+    float dz = g_in_z[k] - z[k];
+    d += dz * dz;
+  }
+  return d * (1.0f / (float)(1 << GNG_DIST_SHIFT));
+#endif
+#else
+  return dist2(x, y, nodes[i].x, nodes[i].y);
+#endif
+}
+
+#if GNG_GRID_BITS
+static inline int grid_cell_of(int i) {
+  return ((pos_to_q15(nodes[i].y) >> GRID_SHIFT) << GNG_GRID_BITS) |
+         (pos_to_q15(nodes[i].x) >> GRID_SHIFT);
+}
+
+static inline void grid_add(int i) {
+  int c = grid_cell_of(i);
+  g_cell[i] = (uint8_t)c;
+  g_grid[c][i >> 5] |= GNG_BIT(i);
+}
+
+static inline void grid_del(int i) {
+  g_grid[g_cell[i]][i >> 5] &= ~GNG_BIT(i);
+}
+
+// active node i moved: new cell only when it crossed a border
+static inline void grid_move(int i) {
+  if (!nodes[i].active || grid_cell_of(i) == g_cell[i]) return;
+  grid_del(i);
+  grid_add(i);
+}
+
+static void gng_grid_rebuild(void) {
+  for (int c = 0; c < GRID_N * GRID_N; c++)
+    for (int w = 0; w < ACT_WORDS; w++) g_grid[c][w] = 0;
+  for (int i = 0; i < MAX_NODES; i++)
+    if (nodes[i].active) grid_add(i);
+}
+#else
+static inline void grid_move(int i) { (void)i; }
+#endif
+
+#if GNG_POS_BITS
+static inline void node_quant(int i) {
+  nodes[i].x = pos_quant(nodes[i].x);
+  nodes[i].y = pos_quant(nodes[i].y);
+#if GNG_DIM > 2
+  for (int k = 0; k < GNG_DIM - 2; k++) nodes[i].z[k] = pos_quant(nodes[i].z[k]);
+#endif
+}
+#endif
+
+// node i += eps * (sample - node), every component
+static inline void node_step(int i, pos_t x, pos_t y, coef_t eps) {
+#if GNG_CFU && GNG_POS16
+  gng_cfu_eps((uint32_t)eps);
+  uint32_t p = gng_cfu_lerp2((uint16_t)nodes[i].x | ((uint32_t)(uint16_t)nodes[i].y << 16),
+                             (uint16_t)x | ((uint32_t)(uint16_t)y << 16));
+  nodes[i].x = (pos_t)(int16_t)p;
+  nodes[i].y = (pos_t)(int16_t)(p >> 16);
+#elif GNG_CFU
+  gng_cfu_eps((uint32_t)eps);
+  nodes[i].x = (pos_t)gng_cfu_lerp((uint32_t)nodes[i].x, (uint32_t)x);
+  nodes[i].y = (pos_t)gng_cfu_lerp((uint32_t)nodes[i].y, (uint32_t)y);
+#else
+  nodes[i].x = pos_step(nodes[i].x, x, eps);
+  nodes[i].y = pos_step(nodes[i].y, y, eps);
+#endif
+#if GNG_DIM > 2 && GNG_CFU && !GNG_POS16
+  for (int k = 0; k < GNG_DIM - 2; k++) nodes[i].z[k] = (pos_t)gng_cfu_lerp((uint32_t)nodes[i].z[k], (uint32_t)g_in_z[k]);
+#elif GNG_DIM > 2
+  for (int k = 0; k < GNG_DIM - 2; k++) nodes[i].z[k] = pos_step(nodes[i].z[k], g_in_z[k], eps);
+#endif
+#if GNG_POS_BITS
+  node_quant(i);
+#endif
+  grid_move(i);
+}
+
+// node r = midpoint of nodes a and b
+static inline void node_mid(int r, int a, int b) {
+  nodes[r].x = pos_mid(nodes[a].x, nodes[b].x);
+  nodes[r].y = pos_mid(nodes[a].y, nodes[b].y);
+#if GNG_DIM > 2
+  for (int k = 0; k < GNG_DIM - 2; k++) nodes[r].z[k] = pos_mid(nodes[a].z[k], nodes[b].z[k]);
+#endif
+#if GNG_POS_BITS
+  node_quant(r);
+#endif
+  grid_move(r);
+}
+
+// ============================ Max-error tournament ==============================
+static inline int emax_pick(int a, int b) {
+  bool va = (a < MAX_NODES) && nodes[a].active;
+  bool vb = (b < MAX_NODES) && nodes[b].active;
+  if (!vb) return a;
+  if (!va) return b;
+  return err_node_gt(b, a) ? b : a;
+}
+
+static inline int emax_child(int k) {
+  return (k >= EMAX_LEAVES) ? (k - EMAX_LEAVES) : emax_tree[k];
+}
+
+static inline void emax_replay(int k) {
+  emax_tree[k] = (uint8_t)emax_pick(emax_child(2 * k), emax_child(2 * k + 1));
+}
+
+// node i changed error or active flag
+GNG_HOT static inline void emax_update(int i) {
+  for (int k = (i + EMAX_LEAVES) >> 1; k >= 1; k >>= 1) emax_replay(k);
+}
+
+GNG_HOT static void emax_rebuild(void) {
+  for (int k = EMAX_LEAVES - 1; k >= 1; k--) emax_replay(k);
+}
+
+static inline int emax_top(void) {
+  int q = emax_tree[1];
+  return (q < MAX_NODES && nodes[q].active) ? q : -1;
+}
+
+static inline void node_mark_dirty(int i) {
+#if GNG_DIRTY
+  g_dirty[i >> 5] |= GNG_BIT(i);
+#else
+  (void)i;
+#endif
+}
+
+// bits of word w of set[] restricted to node index range [lo, hi)
+static inline uint32_t set_word_range(const uint32_t *set, int w, int lo, int hi) {
+  int b0 = lo - w * 32;
+  int b1 = hi - w * 32;
+  if (b1 <= 0 || b0 >= 32) return 0;
+  uint32_t m = set[w];
+  if (b0 > 0) m &= ~(GNG_BIT(b0) - 1u);
+  if (b1 < 32) m &= (GNG_BIT(b1) - 1u);
+  return m;
+}
+
+// for each node i in set[] with lo <= i < hi: body (i is declared by the macro)
+#define FOR_EACH_BIT(i, set, lo, hi)                                          \
+  for (int _w = 0; _w < ACT_WORDS; _w++)                                      \
+    for (uint32_t _m = set_word_range((set), _w, (lo), (hi)); _m; _m &= _m - 1u) \
+      for (int i = _w * 32 + GNG_CTZ(_m), _once = 1; _once; _once = 0)
+
+#define FOR_EACH_ACTIVE(i, lo, hi)       FOR_EACH_BIT(i, g_act, lo, hi)
+#define FOR_EACH_NEIGHBOR(i, n, lo, hi)  FOR_EACH_BIT(i, nbr[n], lo, hi)
+
+#if GNG_COMPONENTS
+// set[] = nodes reachable from a over nbr[]; true as soon as it holds stop
+GNG_HOT static bool comp_flood(int a, int stop, uint32_t *set) {
+  uint32_t front[ACT_WORDS], next[ACT_WORDS];
+  for (int w = 0; w < ACT_WORDS; w++) set[w] = front[w] = 0;
+  set[a >> 5] = front[a >> 5] = GNG_BIT(a);
+  for (bool grew = true; grew; ) {
+    grew = false;
+    for (int w = 0; w < ACT_WORDS; w++) next[w] = 0;
+    FOR_EACH_BIT(j, front, 0, MAX_NODES) {
+      for (int w = 0; w < ACT_WORDS; w++) next[w] |= nbr[j][w];
+    }
+    for (int w = 0; w < ACT_WORDS; w++) {
+      front[w] = next[w] & ~set[w];
+      set[w] |= front[w];
+      if (front[w]) grew = true;
+    }
+    if (stop >= 0 && (set[stop >> 5] & GNG_BIT(stop))) return true;
+  }
+  return false;
+}
+
+// every node of set[] gets the lowest index of set[] as label
+GNG_HOT static void comp_label(const uint32_t *set) {
+  int lo = -1;
+  for (int w = 0; w < ACT_WORDS && lo < 0; w++)
+    if (set[w]) lo = w * 32 + GNG_CTZ(set[w]);
+  FOR_EACH_BIT(j, set, 0, MAX_NODES) g_comp[j] = (uint8_t)lo;
+}
+
+GNG_HOT static void comp_union(int a, int b) {
+  uint8_t la = g_comp[a], lb = g_comp[b];
+  if (la == lb) return;
+  uint8_t lo = (la < lb) ? la : lb, hi = (la < lb) ? lb : la;
+  FOR_EACH_ACTIVE(i, hi, MAX_NODES) {
+    if (g_comp[i] == hi) g_comp[i] = lo;
+  }
+  g_comp_count--;
+  g_comp_changes++;
+}
+
+// edge a-b is gone: still connected, or two components now
+GNG_HOT static void comp_split(int a, int b) {
+  uint32_t set[ACT_WORDS];
+  if (comp_flood(a, b, set)) return;
+  comp_label(set);
+  comp_flood(b, -1, set);
+  comp_label(set);
+  g_comp_count++;
+  g_comp_changes++;
+}
+
+// labels from scratch: after gng_ckpt_load(), gng_ctx_load() or direct edits
+static void gng_comp_rebuild(void) {
+  uint32_t left[ACT_WORDS], set[ACT_WORDS];
+  for (int w = 0; w < ACT_WORDS; w++) left[w] = g_act[w];
+  g_comp_count = 0;
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    if (!(left[i >> 5] & GNG_BIT(i))) continue;
+    comp_flood(i, -1, set);
+    comp_label(set);  // i is the lowest index left, so the label is i
+    for (int w = 0; w < ACT_WORDS; w++) left[w] &= ~set[w];
+    g_comp_count++;
+  }
+  g_comp_changes++;
+}
+#endif
+
+GNG_HOT static inline void node_set_active(int i, bool a) {
+  nodes[i].active = a;
+  g_topo_changes++;
+  if (a) g_act[i >> 5] |=  GNG_BIT(i);
+  else   g_act[i >> 5] &= ~GNG_BIT(i);
+  emax_update(i);
+#if GNG_GRID_BITS
+  if (a) grid_add(i);
+  else   grid_del(i);
+#endif
+#if GNG_COMPONENTS
+  // a node is activated before its edges and pruned after them
+  if (a) { g_comp[i] = (uint8_t)i; g_comp_count++; }
+  else   g_comp_count--;
+  g_comp_changes++;
+#endif
+}
+
+static inline void nbr_mark_dirty(int i) {
+#if GNG_NBR_DIRTY
+  g_nbr_dirty[i >> 5] |= GNG_BIT(i);
+#else
+  (void)i;
+#endif
+}
+
+static inline void nbr_set(int a, int b) {
+  g_topo_changes++;
+  nbr_mark_dirty(a);
+  nbr_mark_dirty(b);
+  nbr[a][b >> 5] |= GNG_BIT(b);
+  nbr[b][a >> 5] |= GNG_BIT(a);
+#if GNG_COMPONENTS
+  comp_union(a, b);
+#endif
+}
+
+static inline void nbr_clr(int a, int b) {
+  g_topo_changes++;
+  nbr_mark_dirty(a);
+  nbr_mark_dirty(b);
+  nbr[a][b >> 5] &= ~GNG_BIT(b);
+  nbr[b][a >> 5] &= ~GNG_BIT(a);
+#if GNG_COMPONENTS
+  if (!g_comp_bridged) comp_split(a, b);
+#endif
+}
+
+// one past the highest active node (0 = none): every node scan may stop there
+static inline int gng_span(void) {
+  for (int w = ACT_WORDS - 1; w >= 0; w--)
+    if (g_act[w]) return w * 32 + (int)(8 * sizeof(long)) - __builtin_clzl(g_act[w]);
+  return 0;
+}
+
+// active nodes
+static inline int gng_live(void) {
+  int n = 0;
+  for (int w = 0; w < ACT_WORDS; w++) n += __builtin_popcountl(g_act[w]);
+  return n;
+}
+
+// runtime node budget <= MAX_NODES: insertions never use a slot at or above
+// it (a hierarchical coarse network runs with a few nodes in a MAX_NODES build)
+static int g_node_cap = MAX_NODES;
+
+static int findFreeNode(void) {
+  for (int w = 0; w < ACT_WORDS; w++) {
+    uint32_t fr = ~g_act[w];
+    if (fr == 0) continue;
+    int i = w * 32 + GNG_CTZ(fr);
+    return (i < g_node_cap) ? i : -1;
+  }
+  return -1;
+}
+
+// edge index for i<j
+static inline int edge_index_ij(int i, int j) {
+  // ASSUME i < j
+#if GNG_CFU
+  return (int)gng_cfu_eidx((uint32_t)i, (uint32_t)j);
+#else
+  return (i * (2*MAX_NODES - i - 1)) / 2 + (j - i - 1);
+#endif
+}
+
+// general index with swap
+static inline int edge_index(int i, int j) {
+  if (i == j) return -1;
+  if (i > j) { int t=i; i=j; j=t; }
+  return edge_index_ij(i, j);
+}
+
+static void edges_init_full(void) {
+  for (int i = 0; i < MAX_EDGES_FULL; i++) edge_cell[i] = 0;
+  for (int i = 0; i < MAX_NODES; i++) {
+    degree[i] = 0;
+#if GNG_EDGE_STAMP
+    g_wins[i] = 0;
+#endif
+    for (int w = 0; w < ACT_WORDS; w++) nbr[i][w] = 0;
+    nbr_mark_dirty(i);
+  }
+}
+
+static inline bool edge_on(int a, int b) {
+  return (nbr[a][b >> 5] & GNG_BIT(b)) != 0;
+}
+
+// age of the existing edge ei = (a, b)
+static inline uint8_t edge_age(int ei, int a, int b) {
+#if GNG_EDGE_STAMP
+  return (uint8_t)(g_wins[a] + g_wins[b] - edge_cell[ei]);
+#else
+  (void)a; (void)b;
+  return (uint8_t)(edge_cell[ei] - 1u);
+#endif
+}
+
+// (a, b) in the GNG_EDGE_STAMP=0 encoding: 0 = no edge, else age + 1
+static inline uint8_t edge_code(int a, int b) {
+  if (a == b || !edge_on(a, b)) return 0;
+  return (uint8_t)(edge_age(edge_index(a, b), a, b) + 1u);
+}
+
+// edge_code() -> cell; nbr[] / degree[] are the caller's
+static inline void edge_code_set(int a, int b, uint8_t c) {
+#if GNG_EDGE_STAMP
+  edge_cell[edge_index(a, b)] = (uint8_t)(g_wins[a] + g_wins[b] - (uint8_t)(c - 1u));
+#else
+  edge_cell[edge_index(a, b)] = c;
+#endif
+}
+
+// Lazy decay renormalization: keep g_err_inv bounded
+GNG_HOT static inline bool error_renorm_if_needed(void) {
+#if GNG_ERR_BFP
+  // the exponent takes the factor 2, the nodes follow when touched
+  if (g_err_inv < 2u * ERR_INV_ONE) return false;
+  do { g_err_inv >>= 1; g_err_exp++; } while (g_err_inv >= 2u * ERR_INV_ONE);
+  return true;
+#else
+  if (g_err_inv <= PAR_RENORM_TH) return false;
+
+#if GNG_FIXED
+  for (int i = 0; i < MAX_NODES; i++) {
+    if (!nodes[i].active) continue;
+    nodes[i].error = (err_t)(((uint64_t)nodes[i].error << 16) / g_err_inv);
+#if GNG_UTILITY
+    nodes[i].utility = (err_t)(((uint64_t)nodes[i].utility << 16) / g_err_inv);
+#endif
+  }
+#else
+  float g = 1.0f / g_err_inv;
+  for (int i = 0; i < MAX_NODES; i++) {
+    if (!nodes[i].active) continue;
+    nodes[i].error *= g;
+#if GNG_UTILITY
+    nodes[i].utility *= g;
+#endif
+  }
+#endif
+  g_err_inv = ERR_INV_ONE;
+  emax_rebuild();
+  return true;
+#endif
+}
+
+#if GNG_ERR_BFP
+// one node per step is checked: a lag that could wrap before the next visit
+// (at most one halving per step) catches up with g_err_exp; the shifted
+// error may now lose a tie it won, so its emax path is replayed
+static inline void err_sweep(void) {
+  int i = g_err_sweep;
+  g_err_sweep = (uint8_t)((i + 1 < MAX_NODES) ? i + 1 : 0);
+  if (nodes[i].active && err_lag(i) > (uint32_t)(255 - MAX_NODES)) {
+    err_touch(i);
+    emax_update(i);
+  }
+}
+#endif
+
+// *acc += d * g_err_inv (saturating at ERR_MAX in fixed point)
+static inline void err_add_scaled(err_t *acc, dist_t d) {
+#if GNG_FIXED
+  // (Q30 >> 14) * (Q16 >> 8) >> 8 -> Q16; bounded by the renorm threshold
+  uint32_t inc = ((d >> 14) * (g_err_inv >> 8)) >> 8;
+  uint32_t e = *acc + inc;
+  *acc = (e < inc || e > ERR_MAX) ? ERR_MAX : e;
+#else
+  *acc += d * g_err_inv;
+#endif
+}
+
+// error[s1] += d1 * g_err_inv
+static inline void err_accum(int s1, dist_t d1) {
+  err_touch(s1);  // utility follows in the same units
+  err_add_scaled(&nodes[s1].error, d1);
+  emax_update(s1);
+}
+
+// running quantization error: EMA of the winner distance
+static inline void qe_track(dist_t d1) {
+  if (g_qe_ema == 0) { g_qe_ema = d1; return; }  // first step seeds the EMA
+#if GNG_FIXED
+  g_qe_ema = g_qe_ema - (g_qe_ema >> QE_EMA_SHIFT) + (d1 >> QE_EMA_SHIFT);
+#else
+  g_qe_ema += (d1 - g_qe_ema) * (1.0f / (1 << QE_EMA_SHIFT));
+#endif
+}
+
+#if GNG_DRIFT
+// slow EMA, boost start / hold / decay; after qe_track()
+static inline void drift_track(dist_t d1) {
+  gng_drift_t *g = &g_drift;
+  // hysteresis: a boost ends below the midpoint of 1 and RISE
+  const uint32_t th = g->hi ? ((PAR_DRIFT_RISE >> 1) + 32768u) : PAR_DRIFT_RISE;
+  if (g->qe_slow == 0) g->qe_slow = d1;
+#if GNG_FIXED
+  else g->qe_slow = g->qe_slow - (g->qe_slow >> QE_SLOW_SHIFT) + (d1 >> QE_SLOW_SHIFT);
+  bool hi = PAR_DRIFT_RISE && ((uint64_t)g_qe_ema << 16) > (uint64_t)g->qe_slow * th;
+#else
+  else g->qe_slow += (d1 - g->qe_slow) * (1.0f / (1 << QE_SLOW_SHIFT));
+  bool hi = PAR_DRIFT_RISE && g_qe_ema * 65536.0f > g->qe_slow * (float)th;
+#endif
+  if (hi != g->hi) {
+    if (hi) {
+      g->events++;
+      g->t0 = stepCount;
+#if GNG_PARAMS_RT
+      if (g_lambda_left > PAR_DRIFT_LAMBDA) g_lambda_left = PAR_DRIFT_LAMBDA;
+#endif
+    } else {
+      g->latency = stepCount - g->t0;
+    }
+    g->hi = hi;
+  }
+  if (hi) {
+#if GNG_FIXED
+    g->mul = (coef_t)PAR_DRIFT_EPS;
+#else
+    g->mul = (float)PAR_DRIFT_EPS * (1.0f / 65536.0f);
+#endif
+    g->left = PAR_DRIFT_HOLD;
+  } else if (g->left) {
+    g->mul -= PAR_DRIFT_DEC;
+    if (--g->left == 0) g->mul = COEF_CONST(1.0f);
+  }
+}
+
+// learning rate c under the boost, at most 0.5 (pos_step's int32 product)
+static inline coef_t drift_rate(coef_t c) {
+  if (!g_drift.left) return c;
+#if GNG_FIXED
+  coef_t r = (coef_t)(((int64_t)c * g_drift.mul) >> 16);
+#else
+  coef_t r = c * g_drift.mul;
+#endif
+  const coef_t cap = COEF_CONST(0.5f);
+  return (r <= cap) ? r : cap;
+}
+#define EPS_B_STEP  drift_rate(EPS_B)
+#define EPS_N_STEP  drift_rate(EPS_N)
+#define A_MAX_STEP  (g_drift.left ? PAR_DRIFT_AMAX : PAR_A_MAX)
+#else
+#define EPS_B_STEP  EPS_B
+#define EPS_N_STEP  EPS_N
+#define A_MAX_STEP  PAR_A_MAX
+#endif
+
+// g_err_inv *= 1/D
+static inline void err_decay_step(void) {
+#if GNG_ERR_BFP
+  // mantissa < 2^17, (1/D - 1) < 2^16: the product needs 33 bits
+  g_err_inv += (uint32_t)(((uint64_t)g_err_inv * PAR_D_INV) >> 16);
+#elif GNG_FIXED
+  g_err_inv += (g_err_inv * PAR_D_INV) >> 16;
+#else
+  g_err_inv *= PAR_D_INV;
+#endif
+}
+
+// Remove edge. If previously connected, decrement degree.
+GNG_HOT static inline void removeEdgePair(int a, int b) {
+  int ei = edge_index(a, b);
+  if (ei < 0) return;
+
+  bool was_conn = edge_on(a, b);
+  edge_cell[ei] = 0;
+
+  if (was_conn) {
+    if (degree[a] > 0u) degree[a]--;
+    if (degree[b] > 0u) degree[b]--;
+    nbr_clr(a, b);
+  }
+}
+
+#if GNG_MAX_DEGREE
+// full node n: drop its oldest edge (ties -> lower index), O(GNG_MAX_DEGREE)
+GNG_HOT static void evictOldestEdge(int n) {
+  if (degree[n] < (uint8_t)GNG_MAX_DEGREE) return;
+
+  int o = -1;
+  int oldest = -1;
+  FOR_EACH_NEIGHBOR(j, n, 0, MAX_NODES) {
+    int v = edge_age(edge_index(n, j), n, j);
+    if (v > oldest) { oldest = v; o = j; }
+  }
+  if (o >= 0) removeEdgePair(n, o);
+}
+#endif
+
+// Connect/reset (age=0 encoded as 1). If previously disconnected, increment degree.
+GNG_HOT static inline void connectOrResetEdge(int a, int b) {
+  int ei = edge_index(a, b);
+  if (ei < 0) return;
+
+  bool was_conn = edge_on(a, b);
+
+  if (!was_conn) {
+#if GNG_MAX_DEGREE
+    evictOldestEdge(a);
+    evictOldestEdge(b);
+#endif
+    if (degree[a] < 255u) degree[a]++;
+    if (degree[b] < 255u) degree[b]++;
+    nbr_set(a, b);
+  }
+
+#if GNG_EDGE_STAMP
+  edge_cell[ei] = (uint8_t)(g_wins[a] + g_wins[b]);  // age 0
+#else
+  edge_cell[ei] = 1; // age=0 -> store 1
+#endif
+}
+
+// ============================ COMBINED: age edges + move neighbors (winner-only) ==
+GNG_HOT static inline void age_edges_and_move_neighbors(int s1, pos_t x, pos_t y) {
+  const coef_t eps_n = EPS_N_STEP;
+
+#if GNG_EDGE_STAMP
+  g_wins[s1]++;  // every edge of s1 one older
+  FOR_EACH_NEIGHBOR(i, s1, 0, MAX_NODES) {
+    node_step(i, x, y, eps_n);
+    node_mark_dirty(i);
+  }
+#else
+  // i < s1  --> edge(i, s1)
+  FOR_EACH_NEIGHBOR(i, s1, 0, s1) {
+    int ei = edge_index_ij(i, s1);
+    uint8_t v = edge_cell[ei];
+
+    // age++ (cap at 255)
+    if (v < 255u) edge_cell[ei] = (uint8_t)(v + 1u);
+
+    // move neighbor
+    node_step(i, x, y, eps_n);
+    node_mark_dirty(i);
+  }
+
+  // i > s1  --> edge(s1, i), row s1 is contiguous
+  const int row = edge_index_ij(s1, s1 + 1) - (s1 + 1);
+  FOR_EACH_NEIGHBOR(i, s1, s1 + 1, MAX_NODES) {
+    int ei = row + i;
+    uint8_t v = edge_cell[ei];
+
+    if (v < 255u) edge_cell[ei] = (uint8_t)(v + 1u);
+
+    node_step(i, x, y, eps_n);
+    node_mark_dirty(i);
+  }
+#endif
+}
+
+// ============================ deleteOldEdgesFromWinner (two-loop) ================
+GNG_HOT static void deleteOldEdgesFromWinner(int w) {
+#if GNG_EDGE_STAMP
+  const uint8_t amax = (uint8_t)A_MAX_STEP;
+  const uint8_t ww = g_wins[w];
+  FOR_EACH_NEIGHBOR(i, w, 0, MAX_NODES) {
+    int ei = edge_index(i, w);
+    if ((uint8_t)(ww + g_wins[i] - edge_cell[ei]) > amax) {
+      edge_cell[ei] = 0;
+      if (degree[i] > 0u) degree[i]--;
+      if (degree[w] > 0u) degree[w]--;
+      nbr_clr(w, i);
+    }
+  }
+#else
+  const uint8_t TH = (uint8_t)(A_MAX_STEP + 1); // encoded threshold
+
+  // i < w
+  FOR_EACH_NEIGHBOR(i, w, 0, w) {
+    int ei = edge_index_ij(i, w);
+    if (edge_cell[ei] > TH) {
+      edge_cell[ei] = 0;
+      if (degree[i] > 0u) degree[i]--;
+      if (degree[w] > 0u) degree[w]--;
+      nbr_clr(i, w);
+    }
+  }
+  // i > w
+  const int row = edge_index_ij(w, w + 1) - (w + 1);
+  FOR_EACH_NEIGHBOR(i, w, w + 1, MAX_NODES) {
+    int ei = row + i;
+    if (edge_cell[ei] > TH) {
+      edge_cell[ei] = 0;
+      if (degree[i] > 0u) degree[i]--;
+      if (degree[w] > 0u) degree[w]--;
+      nbr_clr(w, i);
+    }
+  }
+#endif
+}
+
+// node n with all its edges (neighbors left isolated go with the next prune)
+static inline void node_remove(int n) {
+  FOR_EACH_NEIGHBOR(j, n, 0, MAX_NODES) removeEdgePair(n, j);
+  node_set_active(n, false);
+}
+
+// ============================ pruneIsolatedNodes (degree) ========================
+GNG_HOT static void pruneIsolatedNodes_degree(void) {
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    if (degree[i] == 0u) node_set_active(i, false);
+  }
+}
+
+// ============================ Fritzke insertion (incident to q only) ==============
+#if GNG_UTILITY
+// least utility active node other than a / b (ties -> lower index), -1 = none
+static int utility_min(int a, int b) {
+  int u = -1;
+#if !GNG_ERR_BFP
+  err_t minU = 0;
+#endif
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    if (i == a || i == b) continue;
+#if GNG_ERR_BFP
+    if (u < 0 || err_bfp_gt(nodes[u].utility, err_lag(u), nodes[i].utility, err_lag(i))) u = i;
+#else
+    if (u < 0 || nodes[i].utility < minU) { minU = nodes[i].utility; u = i; }
+#endif
+  }
+  return u;
+}
+
+// full network: free the slot of the least useful node if q needs it more
+static int utility_evict(int q, int f) {
+  int u = utility_min(q, f);
+  if (u < 0) return -1;
+#if GNG_ERR_BFP
+  if (!err_bfp_gt(nodes[q].error, err_lag(q), (uint64_t)nodes[u].utility * GNG_UTIL_K, err_lag(u)))
+    return -1;
+#elif GNG_FIXED
+  if ((uint64_t)nodes[q].error <= (uint64_t)nodes[u].utility * GNG_UTIL_K) return -1;
+#else
+  if (nodes[q].error <= nodes[u].utility * (float)GNG_UTIL_K) return -1;
+#endif
+  // only neighbors of u can end up isolated here (step (F) just ran), so
+  // they are the whole prune of the insertion; q and f keep their edge
+  uint32_t was[ACT_WORDS];
+  for (int w = 0; w < ACT_WORDS; w++) was[w] = nbr[u][w];
+  node_remove(u);
+  FOR_EACH_BIT(j, was, 0, MAX_NODES) {
+    if (degree[j] == 0u) node_set_active(j, false);
+  }
+  return u;
+}
+#endif
+
+GNG_HOT static int insertNode_fritzke(void) {
+  int r = findFreeNode();
+#if !GNG_UTILITY
+  if (r < 0) return -1;  // saturated: no q / f scan
+#endif
+
+  int q = emax_top();
+  if (q < 0) return -1;
+
+  int f = -1;
+
+  // neighbors of q (ascending index, same tie-break as the row scan)
+  FOR_EACH_NEIGHBOR(i, q, 0, MAX_NODES) {
+    if (f < 0 || err_node_gt(i, f)) f = i;
+  }
+  if (f < 0) return -1;
+
+#if GNG_UTILITY
+  if (r < 0) r = utility_evict(q, f);
+  if (r < 0) return -1;
+#endif
+
+  node_mid(r, q, f);
+  node_set_active(r, true);
+
+  // q - f becomes q - r - f: same component, no split check; the degrees
+  // of q and f drop first, so GNG_MAX_DEGREE evicts nothing in between
+#if GNG_COMPONENTS
+  g_comp_bridged = true;
+#endif
+  removeEdgePair(q, f);
+#if GNG_COMPONENTS
+  g_comp_bridged = false;
+#endif
+  connectOrResetEdge(q, r);
+  connectOrResetEdge(r, f);
+
+  // Under lazy decay, still OK (global scaling cancels)
+  err_touch(q);
+  err_touch(f);
+  nodes[q].error = err_scale(nodes[q].error, ALPHA);
+  nodes[f].error = err_scale(nodes[f].error, ALPHA);
+  nodes[r].error  = nodes[q].error;
+#if GNG_UTILITY
+#if GNG_FIXED
+  nodes[r].utility = (err_t)(((uint64_t)nodes[q].utility + nodes[f].utility) >> 1);
+#else
+  nodes[r].utility = 0.5f * (nodes[q].utility + nodes[f].utility);
+#endif
+#endif
+  err_mark_now(r);
+  emax_update(q);
+  emax_update(f);
+  emax_update(r);
+
+  return r;
+}
+
+// ============================ Software winner search =============================
+#if GNG_GRID_BITS
+// cand[] = nodes of the 3x3 cells around Q1.15 (xq, yq); returns m, the
+// distance (Q1.15 units) from the sample to the border of that block,
+// 0xFFFF when the block is the whole grid
+GNG_HOT static uint32_t grid_probe(uint32_t xq, uint32_t yq, uint32_t *cand) {
+  const int cx = (int)(xq >> GRID_SHIFT), cy = (int)(yq >> GRID_SHIFT);
+  const int x0 = (cx > 0) ? cx - 1 : 0, x1 = (cx < GRID_N - 1) ? cx + 1 : GRID_N - 1;
+  const int y0 = (cy > 0) ? cy - 1 : 0, y1 = (cy < GRID_N - 1) ? cy + 1 : GRID_N - 1;
+
+  for (int w = 0; w < ACT_WORDS; w++) cand[w] = 0;
+  for (int gy = y0; gy <= y1; gy++)
+    for (int gx = x0; gx <= x1; gx++)
+      for (int w = 0; w < ACT_WORDS; w++) cand[w] |= g_grid[(gy << GNG_GRID_BITS) | gx][w];
+
+  uint32_t m = 0xFFFFu, e;
+  if (x0 > 0)          { e = xq - ((uint32_t)x0 << GRID_SHIFT);       if (e < m) m = e; }
+  if (x1 < GRID_N - 1) { e = ((uint32_t)(x1 + 1) << GRID_SHIFT) - xq; if (e < m) m = e; }
+  if (y0 > 0)          { e = yq - ((uint32_t)y0 << GRID_SHIFT);       if (e < m) m = e; }
+  if (y1 < GRID_N - 1) { e = ((uint32_t)(y1 + 1) << GRID_SHIFT) - yq; if (e < m) m = e; }
+  return m;
+}
+
+// Q2.30 distance (CFS / fixed point) a node outside the block has at least
+static inline uint32_t grid_bound_q30(uint32_t m) {
+  return (m * m) >> GNG_DIST_SHIFT;
+}
+
+// node_dist() a node outside the probed block has at least
+static inline dist_t grid_bound(uint32_t m) {
+  if (m == 0xFFFFu) return DIST_MAX;
+#if GNG_FIXED
+  return grid_bound_q30(m);
+#else
+  // float positions round to Q1.15 on both sides: one unit of slack
+  float f = (m > 1u) ? (float)(m - 1u) * (1.0f / 32768.0f) : 0.0f;
+  return f * f * (1.0f / (float)(1 << GNG_DIST_SHIFT));
+#endif
+}
+
+// winners among the 3x3 cells; false when the full scan has to decide
+GNG_HOT static bool gng_find_winners_grid(pos_t x, pos_t y, int *s1, int *s2, dist_t *d1) {
+  uint32_t cand[ACT_WORDS];
+  const uint32_t m = grid_probe(pos_to_q15(x), pos_to_q15(y), cand);
+  dist_t best1=DIST_MAX, best2=DIST_MAX;
+  int a = -1, b = -1;
+  FOR_EACH_BIT(i, cand, 0, MAX_NODES) {
+    dist_t d = node_dist(i, x, y);
+    if (d < best1) { best2=best1; b=a; best1=d; a=i; }
+    else if (d < best2) { best2=d; b=i; }
+  }
+  if (b < 0) return false;
+#if GNG_GRID_EXACT
+  if (m != 0xFFFFu && !(best2 < grid_bound(m))) return false;
+#else
+  (void)m;
+#endif
+  *s1 = a; *s2 = b; *d1 = best1;
+  return true;
+}
+#endif
+
+GNG_HOT static inline void gng_find_winners_sw(pos_t x, pos_t y, int *s1, int *s2, dist_t *d1) {
+#if GNG_GRID_BITS
+  if (gng_find_winners_grid(x, y, s1, s2, d1)) return;
+#endif
+  dist_t best1=DIST_MAX, best2=DIST_MAX;
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    dist_t d = node_dist(i, x, y);
+    if (d < best1) { best2=best1; *s2=*s1; best1=d; *s1=i; }
+    else if (d < best2) { best2=d; *s2=i; }
+  }
+  *d1 = best1;
+}
+
+#ifdef GNG_FIND_WINNERS
+// backend search, defined by the backend header after this one (gng_cfs.h)
+static void GNG_FIND_WINNERS(pos_t x, pos_t y, int *s1, int *s2, dist_t *d1);
+#else
+#define GNG_FIND_WINNERS gng_find_winners_sw
+#endif
+
+#ifdef GNG_MOVE_SYNC
+#if !GNG_EDGE_STAMP
+#error "GNG_MOVE_SYNC: a backend move leaves the aging to g_wins[s1]++, needs GNG_EDGE_STAMP"
+#endif
+// backend move of the last search, defined by the backend header (gng_cfs.h)
+static bool GNG_MOVE_SYNC(int s1);
+#endif
+
+// ============================ GNG update (after winners are known) ===============
+GNG_HOT static void gng_update(pos_t x, pos_t y, int s1, int s2, dist_t d1) {
+  uint32_t t0;
+
+  // (A) error accumulate (LAZY DECAY: scale increment)
+  err_accum(s1, d1);
+  qe_track(d1);
+#if GNG_DRIFT
+  drift_track(d1);
+#endif
+#if GNG_UTILITY
+  {
+    // d2 before anything moves; a backend search only hands over d1
+    dist_t d2 = node_dist(s2, x, y);
+    err_add_scaled(&nodes[s1].utility, (d2 > d1) ? (dist_t)(d2 - d1) : (dist_t)0);
+  }
+#endif
+
+  // (B) + (C) the backend search may have moved s1 and its neighbors already:
+  // copy the positions back, the aging is the stamp
+  bool moved = false;
+  t0 = GNG_CYCLES();
+#ifdef GNG_MOVE_SYNC
+  moved = GNG_MOVE_SYNC(s1);
+  if (moved) {
+    GNG_PROF(cyc_move_w, GNG_CYCLES() - t0);
+    t0 = GNG_CYCLES();
+    g_wins[s1]++;
+    GNG_PROF(cyc_nb, GNG_CYCLES() - t0);
+  }
+#endif
+  if (!moved) {
+    // (B) move winner
+    node_step(s1, x, y, EPS_B_STEP);
+    node_mark_dirty(s1);
+    GNG_PROF(cyc_move_w, GNG_CYCLES() - t0);
+
+    // (C) age edges + move neighbors
+    t0 = GNG_CYCLES();
+    age_edges_and_move_neighbors(s1, x, y);
+    GNG_PROF(cyc_nb, GNG_CYCLES() - t0);
+  }
+
+  // (D) connect winners
+  t0 = GNG_CYCLES();
+  connectOrResetEdge(s1, s2);
+  GNG_PROF(cyc_connect, GNG_CYCLES() - t0);
+
+  // (E) delete old edges (winner-only)
+  t0 = GNG_CYCLES();
+  deleteOldEdgesFromWinner(s1);
+  GNG_PROF(cyc_delete, GNG_CYCLES() - t0);
+
+  // (F) prune isolated nodes (degree)
+  t0 = GNG_CYCLES();
+  pruneIsolatedNodes_degree();
+  GNG_PROF(cyc_prune, GNG_CYCLES() - t0);
+
+  stepCount++;
+
+  // (G) insert every lambda
+  if (gng_insert_due()) {
+    t0 = GNG_CYCLES();
+    int r = insertNode_fritzke();  // prunes what an eviction isolates
+    // only r is new; pruned nodes drop out via the active mask
+    if (r >= 0) { node_mark_dirty(r); g_inserts++; }
+    GNG_PROF(cyc_insert, GNG_CYCLES() - t0);
+  }
+
+  // (H) lazy decay update
+  err_decay_step();
+
+  // renorm (optional)
+  t0 = GNG_CYCLES();
+  bool did_renorm = error_renorm_if_needed();
+  if (did_renorm) g_renorms++;
+  GNG_PROF(cyc_renorm, did_renorm ? (GNG_CYCLES() - t0) : 0u);
+#if GNG_ERR_BFP
+  err_sweep();
+#endif
+}
+
+// One full step: GNG_FIND_WINNERS + gng_update; false if < 2 active nodes
+GNG_HOT static inline bool gng_step(pos_t x, pos_t y) {
+  int s1 = -1, s2 = -1;
+  dist_t d1 = DIST_MAX;
+
+  gng_prof_clear();
+  uint32_t t_total0 = GNG_CYCLES();
+
+  GNG_FIND_WINNERS(x, y, &s1, &s2, &d1);
+  GNG_PROF(cyc_winner, GNG_CYCLES() - t_total0);
+
+  bool ok = (s1 >= 0 && s2 >= 0);
+  if (ok) gng_update(x, y, s1, s2, d1);
+
+  GNG_PROF(cyc_total, GNG_CYCLES() - t_total0);
+  return ok;
+}
+
+#if GNG_COMPACT
+// ============================ Compaction ========================================
+// active node src -> free slot dst, edges and ages included
+static void node_relocate(int dst, int src) {
+  FOR_EACH_NEIGHBOR(j, src, 0, MAX_NODES) {
+    int es = edge_index(src, j), ed = edge_index(dst, j);
+    edge_cell[ed] = edge_cell[es];
+    edge_cell[es] = 0;
+    nbr[j][src >> 5] &= ~GNG_BIT(src);
+    nbr[j][dst >> 5] |=  GNG_BIT(dst);
+    nbr_mark_dirty(j);
+  }
+  for (int w = 0; w < ACT_WORDS; w++) { nbr[dst][w] = nbr[src][w]; nbr[src][w] = 0; }
+  nbr_mark_dirty(src);
+  nbr_mark_dirty(dst);
+  degree[dst] = degree[src];
+  degree[src] = 0;
+#if GNG_EDGE_STAMP
+  g_wins[dst] = g_wins[src];  // the stamps of the moved edges stay valid
+#endif
+
+#if GNG_GRID_BITS
+  grid_del(src);
+#endif
+  nodes[dst] = nodes[src];
+  nodes[src].active = false;
+  g_act[src >> 5] &= ~GNG_BIT(src);
+  g_act[dst >> 5] |=  GNG_BIT(dst);
+#if GNG_GRID_BITS
+  grid_add(dst);
+#endif
+  emax_update(src);
+  emax_update(dst);
+  node_mark_dirty(dst);
+  g_topo_changes++;
+}
+
+// dense prefix 0 .. live-1; at most max moves, (from[k], to[k]) each; returns
+// the number of moves (0: already dense)
+static int gng_compact(uint8_t *from, uint8_t *to, int max) {
+  int n = 0;
+  for (int top = gng_span() - 1; n < max; top = gng_span() - 1) {
+    int hole = findFreeNode();
+    if (hole < 0 || hole >= top) break;
+    node_relocate(hole, top);
+    from[n] = (uint8_t)top;
+    to[n]   = (uint8_t)hole;
+    n++;
+  }
+#if GNG_COMPONENTS
+  if (n) gng_comp_rebuild();  // labels are lowest node indices
+#endif
+  return n;
+}
+#endif // GNG_COMPACT
+
+// ============================ Init ===============================================
+// empty graph, no active node; step count, QE and drift state are kept
+// (a seed / merged network loaded node by node follows, or gng_reset())
+static void gng_clear(void) {
+#if GNG_CFU
+  gng_cfu_init(MAX_NODES);
+#endif
+  for (int i=0;i<MAX_NODES;i++){
+    nodes[i].x=0; nodes[i].y=0;
+#if GNG_DIM > 2
+    for (int k=0;k<GNG_DIM-2;k++) nodes[i].z[k]=0;
+#endif
+    nodes[i].error=0;
+#if GNG_UTILITY
+    nodes[i].utility=0;
+#endif
+#if GNG_ERR_BFP
+    nodes[i].eexp=0;
+#endif
+    nodes[i].active=false;
+  }
+  for (int w=0;w<ACT_WORDS;w++) g_act[w]=0;
+#if GNG_COMPONENTS
+  g_comp_count=0;
+#endif
+#if GNG_GRID_BITS
+  gng_grid_rebuild();  // no node is active yet: empty cells
+#endif
+#if GNG_DIRTY
+  for (int w=0;w<ACT_WORDS;w++) g_dirty[w]=0;
+#endif
+  edges_init_full();
+
+  // reset lazy decay scaling
+  g_err_inv = ERR_INV_ONE;
+#if GNG_ERR_BFP
+  g_err_exp = 0;
+  g_err_sweep = 0;
+#endif
+}
+
+// empty graph + the two start nodes (0.2,0.2) and (0.8,0.8), all components
+static void gng_reset(void) {
+  gng_clear();
+
+  stepCount=0;
+  gng_lambda_sync();
+  g_qe_ema=0;
+#if GNG_DRIFT
+  gng_drift_reset();
+#endif
+
+#if GNG_DIM > 2
+  for (int k=0;k<GNG_DIM-2;k++) { nodes[0].z[k]=POS_CONST(0.2f); nodes[1].z[k]=POS_CONST(0.8f); }
+#endif
+  nodes[0].x=POS_CONST(0.2f); nodes[0].y=POS_CONST(0.2f); node_set_active(0, true);
+  nodes[1].x=POS_CONST(0.8f); nodes[1].y=POS_CONST(0.8f); node_set_active(1, true);
+  emax_rebuild();
+}
+
+#endif // GNG_CORE_H
@@ -0,0 +1,129 @@
+// ================================================================================
+// gng_ctx.h - several independent GNG instances on one gng_core.h
+//
+// gng_core.h keeps one network in file-scope state (nodes[], edge_cell[],
+// degree[], nbr[], g_err_inv, ...) that every step touches directly. Instead
+// of threading a pointer through the hot path, a gng_ctx_t holds a parked
+// copy of that state and the backend swaps instances between time slices:
+//   - gng_ctx_save(c) parks the live network in c, gng_ctx_load(c) makes c
+//     the live one; nothing in gng_step() changes
+//   - a switch copies sizeof(gng_ctx_t) bytes (MAX_NODES 20: ~0.7 KB), so
+//     slices of tens of steps or more keep it off the profile
+//   - with GNG_PARAMS_RT the parameters (g_par) and the insertion countdown
+//     belong to the instance: every model has its own lambda, rates and D
+//     (and GNG_DRIFT boost settings, its QE references and boost state)
+//   - so does the node budget g_node_cap (a hierarchical coarse network
+//     keeps its small cap while the fine ones fill MAX_NODES)
+//   - g_dirty is not part of it: the backend flushes moved nodes before a
+//     switch (V3: cfs_flush_dirty into the instance's node bank)
+//   - g_prof stays shared, it describes whatever step ran last
+//   - GNG_COMPONENTS labels and the GNG_GRID_BITS cells are rebuilt by
+//     gng_ctx_load() instead of parked
+//
+//     static gng_ctx_t models[K];
+//     gng_reset(); gng_ctx_save(&models[k]);                  // for every k
+//     gng_ctx_switch(&models[cur], &models[next]);            // per slice
+// ================================================================================
+
+#ifndef GNG_CTX_H
+#define GNG_CTX_H
+
+#include <string.h>
+
+#include "gng_core.h"
+
+typedef struct {
+  Node     nodes[MAX_NODES];
+  uint32_t act[ACT_WORDS];
+  uint8_t  emax_tree[EMAX_LEAVES];
+  uint8_t  degree[MAX_NODES];
+  uint8_t  edge_cell[MAX_EDGES_FULL];
+  uint32_t nbr[MAX_NODES][ACT_WORDS];
+#if GNG_EDGE_STAMP
+  uint8_t  wins[MAX_NODES];
+#endif
+  uint32_t step_count;
+  uint32_t topo_changes;
+  int      node_cap;
+  dist_t   qe_ema;
+  err_t    err_inv;
+#if GNG_ERR_BFP
+  uint8_t  err_exp;
+#endif
+#if GNG_PARAMS_RT
+  gng_params_t par;
+  uint32_t lambda_left;
+#endif
+#if GNG_DRIFT
+  gng_drift_t drift;
+#endif
+} gng_ctx_t;
+
+// live network -> c
+static void gng_ctx_save(gng_ctx_t *c) {
+  memcpy(c->nodes, nodes, sizeof(nodes));
+  memcpy(c->act, g_act, sizeof(g_act));
+  memcpy(c->emax_tree, emax_tree, sizeof(emax_tree));
+  memcpy(c->degree, degree, sizeof(degree));
+  memcpy(c->edge_cell, edge_cell, sizeof(edge_cell));
+  memcpy(c->nbr, nbr, sizeof(nbr));
+#if GNG_EDGE_STAMP
+  memcpy(c->wins, g_wins, sizeof(g_wins));
+#endif
+  c->step_count = stepCount;
+  c->topo_changes = g_topo_changes;
+  c->node_cap = g_node_cap;
+  c->qe_ema = g_qe_ema;
+  c->err_inv = g_err_inv;
+#if GNG_ERR_BFP
+  c->err_exp = g_err_exp;
+#endif
+#if GNG_PARAMS_RT
+  c->par = g_par;
+  c->lambda_left = g_lambda_left;
+#endif
+#if GNG_DRIFT
+  c->drift = g_drift;
+#endif
+}
+
+// c -> live network (c is left as it was)
+static void gng_ctx_load(const gng_ctx_t *c) {
+  memcpy(nodes, c->nodes, sizeof(nodes));
+  memcpy(g_act, c->act, sizeof(g_act));
+  memcpy(emax_tree, c->emax_tree, sizeof(emax_tree));
+  memcpy(degree, c->degree, sizeof(degree));
+  memcpy(edge_cell, c->edge_cell, sizeof(edge_cell));
+  memcpy(nbr, c->nbr, sizeof(nbr));
+#if GNG_EDGE_STAMP
+  memcpy(g_wins, c->wins, sizeof(g_wins));
+#endif
+  stepCount = c->step_count;
+  g_topo_changes = c->topo_changes;
+  g_node_cap = c->node_cap;
+  g_qe_ema = c->qe_ema;
+  g_err_inv = c->err_inv;
+#if GNG_ERR_BFP
+  g_err_exp = c->err_exp;
+#endif
+#if GNG_PARAMS_RT
+  g_par = c->par;
+  g_lambda_left = c->lambda_left;
+#endif
+#if GNG_DRIFT
+  g_drift = c->drift;
+#endif
+#if GNG_GRID_BITS
+  gng_grid_rebuild();
+#endif
+#if GNG_COMPONENTS
+  gng_comp_rebuild();
+#endif
+}
+
+static inline void gng_ctx_switch(gng_ctx_t *from, const gng_ctx_t *to) {
+  gng_ctx_save(from);
+  gng_ctx_load(to);
+}
+
+#endif // GNG_CTX_H
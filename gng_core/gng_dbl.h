@@ -0,0 +1,229 @@
+// ================================================================================
+// gng_dbl.h - DBL-GNG epochs (distributed batch learning) for gng_core.h
+//
+// One update per pass over the whole dataset instead of one Fritzke step per
+// sample, as DBL_GNG of gng_neorv32_accelerator_V2/fw/try_gng_python.py
+// (resetBatch + batchLearning + updateNetwork + addNewNode):
+//   - every sample of an epoch is matched against the node positions of the
+//     epoch start, so the winner searches are independent of each other; a
+//     CFS batch scan gives exactly the same winners as one search per sample
+//   - dbl_accum(): per node sum of (x - w) over the samples it won (dw1, a1)
+//     and over the samples one of its neighbors won (dw2, a2), error[s1] +=
+//     d1, score[s1, s2]++ in a half-matrix like edge_cell
+//   - dbl_apply(): w += DBL_L1 * dw1 / a1 + DBL_L2 * dw2 / a2, the edge set
+//     becomes the winner pairs of the epoch (score > 0, age 0), isolated
+//     nodes are pruned, errors *= DBL_ERR_FACTOR, every DBL_PRUNE_EVERY
+//     epochs nodes that won no sample go too, then DBL_ADD_PCT % of the nodes
+//     (at least one) are inserted between the max-error node and its
+//     max-error neighbor
+//
+// DIFFERENCES TO THE PYTHON MODEL:
+//   - the error sums d1 as the winner search returns it (squared distance),
+//     Python sums sqrt(d2 + eps) * L1
+//   - insertions: a fixed share of the nodes instead of "errors above the
+//     85 % quantile"; non-activated nodes are removed every DBL_PRUNE_EVERY
+//     epochs instead of with probability 0.1
+//
+// Accumulators are int32 in pos_t units (fixed point), so an epoch holds at
+// most 32768 samples; counts are uint16, scores saturate at 0xFFFF. With
+// GNG_DIM > 2 components 2.. get their own sums (dbl_dw1z / dbl_dw2z) from
+// g_in_z, i.e. sample_load_z() before dbl_accum().
+// ================================================================================
+
+#ifndef GNG_DBL_H
+#define GNG_DBL_H
+
+#include "gng_core.h"
+
+#ifndef DBL_L1
+#define DBL_L1           0.5f    // winner rate (alpha of DBL-GNG)
+#endif
+#ifndef DBL_L2
+#define DBL_L2           0.01f   // neighbor rate (beta)
+#endif
+#ifndef DBL_ERR_FACTOR
+#define DBL_ERR_FACTOR   0.5f    // error decay per epoch (delta)
+#endif
+#ifndef DBL_NEW_FACTOR
+#define DBL_NEW_FACTOR   0.5f    // q1 / q2 error on insertion (rho)
+#endif
+#ifndef DBL_ADD_PCT
+#define DBL_ADD_PCT      15      // nodes inserted per epoch, % of active (1 - add_quantile)
+#endif
+#ifndef DBL_PRUNE_EVERY
+#define DBL_PRUNE_EVERY  10      // epochs between non-activated node removals, 0 = never
+#endif
+
+#if GNG_FIXED
+typedef int32_t dbl_acc_t;
+#else
+typedef float   dbl_acc_t;
+#endif
+
+static dbl_acc_t dbl_dw1x[MAX_NODES], dbl_dw1y[MAX_NODES];
+static dbl_acc_t dbl_dw2x[MAX_NODES], dbl_dw2y[MAX_NODES];
+#if GNG_DIM > 2
+static dbl_acc_t dbl_dw1z[MAX_NODES][GNG_DIM - 2], dbl_dw2z[MAX_NODES][GNG_DIM - 2];
+#endif
+static uint16_t  dbl_a1[MAX_NODES], dbl_a2[MAX_NODES];
+static uint16_t  dbl_score[MAX_EDGES_FULL];
+static uint32_t  dbl_epoch = 0;
+
+// accumulators of a new epoch
+static void dbl_reset(void) {
+  for (int i = 0; i < MAX_NODES; i++) {
+    dbl_dw1x[i] = dbl_dw1y[i] = 0;
+    dbl_dw2x[i] = dbl_dw2y[i] = 0;
+#if GNG_DIM > 2
+    for (int k = 0; k < GNG_DIM - 2; k++) dbl_dw1z[i][k] = dbl_dw2z[i][k] = 0;
+#endif
+    dbl_a1[i] = dbl_a2[i] = 0;
+  }
+  for (int i = 0; i < MAX_EDGES_FULL; i++) dbl_score[i] = 0;
+}
+
+// one sample and its winners (positions of the epoch start); CPU only, so it
+// may run while the CFS scans the next batch
+GNG_HOT static void dbl_accum(pos_t x, pos_t y, int s1, int s2, dist_t d1) {
+  err_accum(s1, d1);
+  qe_track(d1);
+
+  dbl_dw1x[s1] += (dbl_acc_t)(x - nodes[s1].x);
+  dbl_dw1y[s1] += (dbl_acc_t)(y - nodes[s1].y);
+#if GNG_DIM > 2
+  for (int k = 0; k < GNG_DIM - 2; k++) dbl_dw1z[s1][k] += (dbl_acc_t)(g_in_z[k] - nodes[s1].z[k]);
+#endif
+  dbl_a1[s1]++;
+
+  FOR_EACH_NEIGHBOR(i, s1, 0, MAX_NODES) {
+    dbl_dw2x[i] += (dbl_acc_t)(x - nodes[i].x);
+    dbl_dw2y[i] += (dbl_acc_t)(y - nodes[i].y);
+#if GNG_DIM > 2
+    for (int k = 0; k < GNG_DIM - 2; k++) dbl_dw2z[i][k] += (dbl_acc_t)(g_in_z[k] - nodes[i].z[k]);
+#endif
+    dbl_a2[i]++;
+  }
+
+  int ei = edge_index(s1, s2);
+  if (ei >= 0 && dbl_score[ei] < 0xFFFFu) dbl_score[ei]++;
+}
+
+// p + c * (sum / n), rounded
+static inline pos_t dbl_step(pos_t p, dbl_acc_t sum, uint16_t n, coef_t c) {
+#if GNG_FIXED
+  int32_t mean = sum / (int32_t)n;
+  return (pos_t)(p + (pos_t)(((int64_t)c * mean + 32768) >> 16));
+#else
+  return p + c * (sum / (float)n);
+#endif
+}
+
+// addNewNode: midpoint of q1 (max error) and its max-error neighbor q2
+GNG_HOT static int dbl_insert(void) {
+  int q1 = emax_top();
+  if (q1 < 0 || nodes[q1].error == 0) return -1;
+
+  int q2 = -1;
+  FOR_EACH_NEIGHBOR(i, q1, 0, MAX_NODES) {
+    if (q2 < 0 || err_node_gt(i, q2)) q2 = i;
+  }
+  if (q2 < 0 || nodes[q2].error == 0) return -1;
+
+  int r = findFreeNode();
+  if (r < 0) return -1;
+
+  node_mid(r, q1, q2);
+  node_set_active(r, true);
+  node_mark_dirty(r);
+
+  removeEdgePair(q1, q2);
+  connectOrResetEdge(q1, r);
+  connectOrResetEdge(q2, r);
+
+  err_touch(q1);
+  err_touch(q2);
+  nodes[q1].error = err_scale(nodes[q1].error, COEF_CONST(DBL_NEW_FACTOR));
+  nodes[q2].error = err_scale(nodes[q2].error, COEF_CONST(DBL_NEW_FACTOR));
+#if GNG_FIXED
+  nodes[r].error = (err_t)(((uint64_t)nodes[q1].error + nodes[q2].error) >> 1);
+#else
+  nodes[r].error = 0.5f * (nodes[q1].error + nodes[q2].error);
+#endif
+  err_mark_now(r);
+  emax_update(q1);
+  emax_update(q2);
+  emax_update(r);
+  return r;
+}
+
+// updateNetwork + addNewNode at the end of an epoch
+GNG_HOT static void dbl_apply(void) {
+  uint32_t t0;
+
+  // (A) positions from the epoch sums
+  t0 = GNG_CYCLES();
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    if (dbl_a1[i] == 0 && dbl_a2[i] == 0) continue;
+    pos_t x = nodes[i].x, y = nodes[i].y;
+    if (dbl_a1[i]) {
+      x = dbl_step(x, dbl_dw1x[i], dbl_a1[i], COEF_CONST(DBL_L1));
+      y = dbl_step(y, dbl_dw1y[i], dbl_a1[i], COEF_CONST(DBL_L1));
+    }
+    if (dbl_a2[i]) {
+      x = dbl_step(x, dbl_dw2x[i], dbl_a2[i], COEF_CONST(DBL_L2));
+      y = dbl_step(y, dbl_dw2y[i], dbl_a2[i], COEF_CONST(DBL_L2));
+    }
+    nodes[i].x = x;
+    nodes[i].y = y;
+#if GNG_DIM > 2
+    for (int k = 0; k < GNG_DIM - 2; k++) {
+      pos_t z = nodes[i].z[k];
+      if (dbl_a1[i]) z = dbl_step(z, dbl_dw1z[i][k], dbl_a1[i], COEF_CONST(DBL_L1));
+      if (dbl_a2[i]) z = dbl_step(z, dbl_dw2z[i][k], dbl_a2[i], COEF_CONST(DBL_L2));
+      nodes[i].z[k] = z;
+    }
+#endif
+    grid_move(i);
+    node_mark_dirty(i);
+  }
+  GNG_PROF(cyc_move_w, GNG_CYCLES() - t0);
+
+  // (B) edges = winner pairs of this epoch
+  t0 = GNG_CYCLES();
+  for (int i = 0, ei = 0; i < MAX_NODES - 1; i++) {
+    for (int j = i + 1; j < MAX_NODES; j++, ei++) {
+      if (dbl_score[ei]) connectOrResetEdge(i, j);
+      else if (edge_on(i, j)) removeEdgePair(i, j);
+    }
+  }
+  GNG_PROF(cyc_connect, GNG_CYCLES() - t0);
+
+  // (C) isolated nodes, error decay, non-activated nodes
+  t0 = GNG_CYCLES();
+  pruneIsolatedNodes_degree();
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    nodes[i].error = err_scale(nodes[i].error, COEF_CONST(DBL_ERR_FACTOR));
+  }
+  dbl_epoch++;
+#if DBL_PRUNE_EVERY
+  if ((dbl_epoch % DBL_PRUNE_EVERY) == 0) {
+    FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+      if (dbl_a1[i] == 0) node_remove(i);
+    }
+    pruneIsolatedNodes_degree();
+  }
+#endif
+  emax_rebuild();
+  GNG_PROF(cyc_prune, GNG_CYCLES() - t0);
+
+  // (D) insertions
+  t0 = GNG_CYCLES();
+  int n = 0;
+  for (int w = 0; w < ACT_WORDS; w++) n += __builtin_popcount(g_act[w]);
+  int add = (n * DBL_ADD_PCT) / 100;
+  if (add < 1) add = 1;
+  while (add-- > 0 && dbl_insert() >= 0) g_inserts++;
+  GNG_PROF(cyc_insert, GNG_CYCLES() - t0);
+}
+
+#endif // GNG_DBL_H
@@ -0,0 +1,138 @@
+// ================================================================================
+// gng_gen.h - synthetic 2D training streams on the board, no dataset memory
+//
+// The bench datasets of benchmark_datasets.py, drawn sample by sample in
+// integer Q1.15 (x | y << 16, the CMD_DATA_BATCH sample word), so a
+// benchmark trains at step speed on an endless, non-repeating stream with
+// no upload and no MAXPTS limit:
+//   GNG_GEN_UNIFORM  uniform square
+//   GNG_GEN_MOONS    two moons (cos t, sin t) / (1 - cos t, 0.5 - sin t),
+//                    t in [0, pi), noise 0.1, box [-1.3, 2.3] x [-0.8, 1.3]
+//   GNG_GEN_CIRCLES  radii 1/3, 2/3, 1, radial noise 0.05, box +-1.15
+//   GNG_GEN_GAUSS    5 clusters, centres from the seed in [0, 1]^2, noise
+//                    0.1, box [-0.3, 1.3]
+// The boxes are fixed (a stream has no min / max to normalise by), wide
+// enough for 3 sigma of noise; the rare sample beyond is clamped.
+//   - sample i is a pure function of (seed, i): five gng_perm_mix() words
+//     of a counter (shape, then 8 x 16 bits for two Irwin-Hall normals), so
+//     gng_gen_at() can peek ahead and a seed replays the same stream
+//   - sin / cos: quarter-wave table of 65 Q15 entries, linear in between
+//     (error < 1.3e-4, well below the 1e-3 wire resolution)
+//
+//     gng_gen_init(&gen, GNG_GEN_MOONS, seed);
+//     s = gng_gen_next(&gen);
+// ================================================================================
+
+#ifndef GNG_GEN_H
+#define GNG_GEN_H
+
+#include <stdint.h>
+
+#include "gng_perm.h"  // gng_perm_mix
+
+#define GNG_GEN_OFF      0u
+#define GNG_GEN_UNIFORM  1u
+#define GNG_GEN_MOONS    2u
+#define GNG_GEN_CIRCLES  3u
+#define GNG_GEN_GAUSS    4u
+#define GNG_GEN_KINDS    5u
+
+#define GNG_GEN_CLUSTERS 5
+#define GNG_GEN_WORDS    5  // hash words per sample
+
+typedef struct {
+  uint32_t key;   // gng_perm_mix(seed)
+  uint32_t n;     // samples drawn (gng_gen_next)
+  uint8_t  kind;
+  int32_t  cx[GNG_GEN_CLUSTERS], cy[GNG_GEN_CLUSTERS];  // GNG_GEN_GAUSS, Q15
+} gng_gen_t;
+
+static const int16_t gng_gen_sin_q[65] = {
+      0,   804,  1608,  2411,  3212,  4011,  4808,  5602,  6393,
+   7180,  7962,  8740,  9512, 10279, 11039, 11793, 12540, 13279,
+  14010, 14733, 15447, 16151, 16846, 17531, 18205, 18868, 19520,
+  20160, 20788, 21403, 22006, 22595, 23170, 23732, 24279, 24812,
+  25330, 25833, 26320, 26791, 27246, 27684, 28106, 28511, 28899,
+  29269, 29622, 29957, 30274, 30572, 30853, 31114, 31357, 31581,
+  31786, 31972, 32138, 32286, 32413, 32522, 32610, 32679, 32729,
+  32758, 32767,
+};
+
+// phase: 65536 = one turn -> sin, Q15
+static inline int32_t gng_gen_sin(uint32_t ph) {
+  uint32_t q = (ph >> 14) & 3u, p = ph & 0x3FFFu;
+  if (q & 1u) p = 0x4000u - p;
+  uint32_t i = p >> 8, f = p & 0xFFu;
+  int32_t v = gng_gen_sin_q[i];
+  if (i < 64u) v += ((gng_gen_sin_q[i + 1] - v) * (int32_t)f) >> 8;
+  return (q & 2u) ? -v : v;
+}
+
+static inline int32_t gng_gen_cos(uint32_t ph) { return gng_gen_sin(ph + 0x4000u); }
+
+// sigma * N(0, 1) in Q15 from 4 uniform 16-bit halves, k = sigma * sqrt(3) * 32768
+static inline int32_t gng_gen_noise(uint32_t a, uint32_t b, int32_t k) {
+  int32_t s = (int32_t)((a & 0xFFFFu) + (a >> 16) + (b & 0xFFFFu) + (b >> 16)) - 131070;
+  return (s * k) >> 16;
+}
+
+// v (Q15, 1.0 = 32768) in [-off, -off + 32768 / scale) -> [0, 0x7FFF]
+static inline uint32_t gng_gen_box(int32_t v, int32_t off, int32_t scale) {
+  int32_t q = ((v + off) * scale) >> 15;
+  return (q < 0) ? 0u : (q > 0x7FFF) ? 0x7FFFu : (uint32_t)q;
+}
+
+static inline uint32_t gng_gen_word(const gng_gen_t *g, uint32_t k) {
+  return gng_perm_mix(g->key + k * 0x9E3779B9u);
+}
+
+static void gng_gen_init(gng_gen_t *g, uint8_t kind, uint32_t seed) {
+  g->key = gng_perm_mix(seed);
+  g->n = 0;
+  g->kind = (kind < GNG_GEN_KINDS) ? kind : GNG_GEN_OFF;
+  for (int c = 0; c < GNG_GEN_CLUSTERS; c++) {
+    uint32_t w = gng_perm_mix(g->key ^ (0xC0FFEE00u + (uint32_t)c));
+    g->cx[c] = (int32_t)(w & 0x7FFFu);
+    g->cy[c] = (int32_t)((w >> 16) & 0x7FFFu);
+  }
+}
+
+// sample i of the stream, packed Q1.15 x | y << 16
+static uint32_t gng_gen_at(const gng_gen_t *g, uint32_t i) {
+  const uint32_t k = i * GNG_GEN_WORDS;
+  const uint32_t w0 = gng_gen_word(g, k);
+  uint32_t x, y;
+
+  if (g->kind == GNG_GEN_UNIFORM) {
+    x = w0 & 0x7FFFu;
+    y = (w0 >> 16) & 0x7FFFu;
+    return x | (y << 16);
+  }
+  const uint32_t w1 = gng_gen_word(g, k + 1), w2 = gng_gen_word(g, k + 2);
+  const uint32_t w3 = gng_gen_word(g, k + 3), w4 = gng_gen_word(g, k + 4);
+
+  if (g->kind == GNG_GEN_MOONS) {
+    const uint32_t ph = w0 & 0x7FFFu;            // t in [0, pi)
+    int32_t c = gng_gen_cos(ph), s = gng_gen_sin(ph);
+    if (w0 >> 31) { c = 32768 - c; s = 16384 - s; }
+    x = gng_gen_box(c + gng_gen_noise(w1, w2, 5676), 42598, 9102);
+    y = gng_gen_box(s + gng_gen_noise(w3, w4, 5676), 26214, 15604);
+  } else if (g->kind == GNG_GEN_CIRCLES) {
+    const uint32_t ph = w0 & 0xFFFFu;
+    const int32_t ring = (int32_t)(((w0 >> 16) * 3u) >> 16);  // 0..2
+    const int32_t r = (ring + 1) * 10923 + gng_gen_noise(w1, w2, 2838);
+    x = gng_gen_box((r * gng_gen_cos(ph)) >> 15, 37683, 14247);
+    y = gng_gen_box((r * gng_gen_sin(ph)) >> 15, 37683, 14247);
+  } else {
+    const int c = (int)(((w0 >> 16) * GNG_GEN_CLUSTERS) >> 16);
+    x = gng_gen_box(g->cx[c] + gng_gen_noise(w1, w2, 5676), 9830, 20480);
+    y = gng_gen_box(g->cy[c] + gng_gen_noise(w3, w4, 5676), 9830, 20480);
+  }
+  return x | (y << 16);
+}
+
+static inline uint32_t gng_gen_next(gng_gen_t *g) {
+  return gng_gen_at(g, g->n++);
+}
+
+#endif // GNG_GEN_H
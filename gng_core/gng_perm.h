@@ -0,0 +1,74 @@
+// ================================================================================
+// gng_perm.h - shuffled passes over a stored dataset without a shuffled copy
+//
+// Cycling dataQ[0..n) in upload order feeds the network the same sequence
+// every pass; a sorted or clustered upload (one class after the other, a
+// scan line by line) then drags the nodes across the set each pass. A
+// Fisher-Yates shuffle needs an index table of n entries and the host to
+// upload again for a new order. gng_perm_at() instead maps pass position
+// i -> sample index through a keyed bijection of [0, n):
+//   - a 4-round balanced Feistel network on the smallest 2^(2h) >= n, the
+//     round function one multiply; indices >= n are walked on (cycle
+//     walking), on average fewer than 4 rounds sets per sample
+//   - gng_perm_key(p, seed, pass) draws the round keys of a pass from a
+//     hash of (seed, pass): every pass a new order, no state but the pass
+//     number, so a parked model only keeps its position and pass count
+//   - n may change between calls (appended samples), the order of that pass
+//     changes with it but stays a bijection of the new [0, n)
+//
+//     gng_perm_key(&perm, seed, pass);
+//     s = dataQ[gng_perm_at(&perm, i, n)];
+//     if (++i == n) { i = 0; gng_perm_key(&perm, seed, ++pass); }
+// ================================================================================
+
+#ifndef GNG_PERM_H
+#define GNG_PERM_H
+
+#include <stdint.h>
+
+#define GNG_PERM_ROUNDS 4
+
+typedef struct {
+  uint32_t key[GNG_PERM_ROUNDS];
+} gng_perm_t;
+
+// murmur3 finalizer: full avalanche of a 32-bit word
+static inline uint32_t gng_perm_mix(uint32_t x) {
+  x ^= x >> 16; x *= 0x85EBCA6Bu;
+  x ^= x >> 13; x *= 0xC2B2AE35u;
+  x ^= x >> 16;
+  return x;
+}
+
+static void gng_perm_key(gng_perm_t *p, uint32_t seed, uint32_t pass) {
+  uint32_t s = gng_perm_mix(seed ^ gng_perm_mix(pass + 0x9E3779B9u));
+  for (int r = 0; r < GNG_PERM_ROUNDS; r++) {
+    s = gng_perm_mix(s + 0x9E3779B9u);
+    p->key[r] = s;
+  }
+}
+
+// x in [0, 2^(2h)) -> a permuted x in the same range, h in 1..16
+static inline uint32_t gng_perm_feistel(const gng_perm_t *p, uint32_t x, int h) {
+  const uint32_t mask = (h >= 16) ? 0xFFFFu : ((1u << h) - 1u);
+  uint32_t l = (x >> h) & mask, r = x & mask;
+  for (int k = 0; k < GNG_PERM_ROUNDS; k++) {
+    uint32_t f = ((r ^ p->key[k]) * 0x9E3779B1u) >> (32 - h);
+    uint32_t t = l ^ f;
+    l = r;
+    r = t;
+  }
+  return (l << h) | r;
+}
+
+// pass position i -> index in [0, n), a bijection for every key set
+static inline uint32_t gng_perm_at(const gng_perm_t *p, uint32_t i, uint32_t n) {
+  if (n <= 1u) return 0u;
+  int bits = 32 - __builtin_clz(n - 1u);  // n - 1 < 2^bits
+  int h = (bits + 1) >> 1;
+  uint32_t x = i;
+  do { x = gng_perm_feistel(p, x, h); } while (x >= n);
+  return x;
+}
+
+#endif // GNG_PERM_H
@@ -0,0 +1,71 @@
+// ================================================================================
+// gng_prof.h - per-phase interval statistics of g_prof (GNG_PROFILE=1)
+//
+// g_prof holds the cycles of the last step only, so a PROF frame every 100
+// steps sees an insertion or a renorm only when that step happens to be one.
+// gng_prof_commit() after every step folds g_prof into g_prof_agg[], one
+// entry per Prof field in struct order (total, winner, ..., renorm, overlap):
+//   - count / min / max / 64-bit sum; a phase with 0 cycles did not run
+//     (insert, renorm, overlap) and is not counted
+//   - log2 histogram: bucket b counts [2^b, 2^(b+1)) cycles, the last one
+//     everything above; counts saturate at 0xFFFF
+//   - the backend sends the interval and calls gng_prof_agg_reset() (reset
+//     on read); a commit costs a few compares per phase, outside the phases
+//
+//     trainOneStep(...);  gng_prof_commit();
+//     if (interval over) { send g_prof_agg[0 .. GNG_PROF_PHASES); gng_prof_agg_reset(); }
+// ================================================================================
+
+#ifndef GNG_PROF_H
+#define GNG_PROF_H
+
+#include <string.h>
+
+#include "gng_core.h"
+
+#if !GNG_PROFILE
+#error "gng_prof.h needs GNG_PROFILE=1"
+#endif
+
+#define GNG_PROF_PHASES   ((int)(sizeof(Prof) / sizeof(uint32_t)))
+#ifndef GNG_PROF_BUCKETS
+#define GNG_PROF_BUCKETS  24      // last bucket: 2^23 cycles and more
+#endif
+
+typedef struct {
+  uint32_t count;
+  uint32_t min;
+  uint32_t max;
+  uint64_t sum;
+  uint16_t hist[GNG_PROF_BUCKETS];
+} gng_phase_agg_t;
+
+static gng_phase_agg_t g_prof_agg[GNG_PROF_PHASES];
+
+static inline int gng_prof_bucket(uint32_t cyc) {
+  int b = (int)(8 * sizeof(long)) - 1 - __builtin_clzl(cyc);  // cyc != 0; long is 64 bit on hosts
+  return (b < GNG_PROF_BUCKETS) ? b : GNG_PROF_BUCKETS - 1;
+}
+
+static void gng_prof_agg_reset(void) {
+  memset(g_prof_agg, 0, sizeof(g_prof_agg));
+  for (int i = 0; i < GNG_PROF_PHASES; i++) g_prof_agg[i].min = 0xFFFFFFFFu;
+}
+
+// g_prof (one finished step) -> interval statistics
+static void gng_prof_commit(void) {
+  const uint32_t *f = (const uint32_t *)&g_prof;  // Prof is uint32_t fields only
+  for (int i = 0; i < GNG_PROF_PHASES; i++) {
+    uint32_t c = f[i];
+    if (c == 0) continue;
+    gng_phase_agg_t *a = &g_prof_agg[i];
+    a->count++;
+    a->sum += c;
+    if (c < a->min) a->min = c;
+    if (c > a->max) a->max = c;
+    uint16_t *h = &a->hist[gng_prof_bucket(c)];
+    if (*h != 0xFFFFu) (*h)++;
+  }
+}
+
+#endif // GNG_PROF_H
@@ -0,0 +1,699 @@
+// ================================================================================
+// fwhost.c - V3 firmware on the desktop (gng_neorv32_accelerator_V3/fw/main.c)
+//
+// main.c is compiled unchanged for the host (main -> fw_main, see makefile)
+// next to this file, which stands in for the SoC:
+//   - CFS: register model of neorv32_cfs.vhd, same map as gng_cfs.h
+//       CTRL CLEAR / START / IRQ_EN / BATCH / FLUSH / SLEEP, status bits,
+//       XIN / YIN (+ VEC banks) staged and latched by START (INFO DBUF),
+//       NODE_COUNT, ACT_LO / ACT_HI / ACT_BASE + w, OUT_S12 / OUT_MIN1 /
+//       OUT_MIN2, SMP_PUSH FIFO and result ring (BATCH, RES_S12, RES_MIN1),
+//       REG_LAMBDA..REG_D, INFO, CTX banks, DIM, PERF_CTRL + the 7 counters,
+//       node window at 128, VEC words at 4096, adj rows at 8192 (-m)
+//     search = neorv32_cfs_engine: Q1.15 (dx^2 + dy^2) >> log2(WS) summed over
+//     the words, active mask below NODE_COUNT, strict '<' (ties keep the lower
+//     id), s2 = 0 without a second candidate; it finishes inside the START
+//     write (or the push / CTRL write that lets a batch scan run), so BUSY is
+//     never seen and the DONE IRQ handler runs on return from that access
+//   - MOVE (-m): a START with CTRL.MOVE moves s1 by REG_EPS_B and the active
+//     nodes of its adj row by REG_EPS_N towards the latched sample, the
+//     Q1.15 lerp of the move unit, right after the scan; REG_DIM bit 16
+//   - DUMP (-s): a REG_DUMP START (REG_DUMP_DIV != 0) puts the keyframe of
+//     the snapshot framer into the UART0 output inside the write: NODES of
+//     the active nodes of the current CTX (at most 50), with EDGES (and -m)
+//     the i < j adj pairs as one EDGES or EDGES_CHUNK frames; REG_DIM bit 17
+//   - UART0: a pseudo terminal (default, the slave path is printed on stderr
+//     for gngio / Processing) or files (-i / -o, e.g. recorded host traffic
+//     or fuzzer input); with -i the run ends -t ms after the input EOF
+//   - mcycle / CLINT: host CLOCK_MONOTONIC scaled to 27 MHz, so PROF and
+//     TIME numbers are host time in board units
+//   - CFU (GNG_CFU=1): the C model of gng_cfu.h, mxisa reports Zxcfu
+//
+// Not modeled: bus and engine timing (the perf BUSY counter adds the engine
+// clocks of each scan, LANES per clock + 5; IDLE is host time), CFS_TIMEOUT,
+// DMA, SMP, TF card, uflash checkpoints, tracer, TRNG.
+//
+//   fwhost [-i in] [-o out] [-t ms] [-n maxnodes] [-l lanes] [-c ctx] [-d dim] [-m] [-s]
+// ================================================================================
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "neorv32.h"
+
+int fw_main(void);
+
+// ---------------- bitstream generics (gng_preset.vhd defaults) ----------------
+static int g_maxnodes = 40;
+static int g_lanes    = 4;
+static int g_ctx      = 1;
+static int g_dim      = 2;
+static int g_move     = 0;
+static int g_dump     = 0;
+static int g_words, g_ws, g_dshift, g_act_words;
+
+// ---------------- host time ----------------
+static struct timespec t_boot;
+
+static uint64_t host_cycles(void) {
+  struct timespec t;
+  clock_gettime(CLOCK_MONOTONIC, &t);
+  uint64_t ns = (uint64_t)(t.tv_sec - t_boot.tv_sec) * 1000000000u +
+                (uint64_t)(t.tv_nsec - t_boot.tv_nsec);
+  return ns * (FWHOST_CLK_HZ / 1000000u) / 1000u;
+}
+
+// ---------------- CPU: CSRs, traps ----------------
+static uint32_t csr_mstatus = 0, csr_mie = 0;
+static void (*irq_cfs)(void) = NULL;
+static int in_trap = 0;
+
+static void cfs_irq_check(void);
+
+uint32_t neorv32_cpu_csr_read(int csr) {
+  switch (csr) {
+    case CSR_MSTATUS: return csr_mstatus;
+    case CSR_MIE:     return csr_mie;
+    case CSR_MISA:    return 0x40001100u;  // rv32im
+    case CSR_MXISA:   return 1u << CSR_MXISA_ZXCFU;  // GNG_CFU: the gng_cfu.h C model
+    case CSR_MCYCLE:  return (uint32_t)host_cycles();
+    case CSR_MCYCLEH: return (uint32_t)(host_cycles() >> 32);
+    default:          return 0;
+  }
+}
+
+void neorv32_cpu_csr_set(int csr, uint32_t mask) {
+  if (csr == CSR_MSTATUS) csr_mstatus |= mask;
+  if (csr == CSR_MIE) csr_mie |= mask;
+  cfs_irq_check();  // a pending level IRQ is taken as soon as it is enabled
+}
+
+void neorv32_cpu_csr_clr(int csr, uint32_t mask) {
+  if (csr == CSR_MSTATUS) csr_mstatus &= ~mask;
+  if (csr == CSR_MIE) csr_mie &= ~mask;
+}
+
+void neorv32_rte_setup(void) { }
+
+int neorv32_rte_handler_install(uint32_t code, void (*handler)(void)) {
+  if (code == CFS_TRAP_CODE) irq_cfs = handler;
+  return 0;  // UART0 IRQ: not installed by a UART_TX_IRQ=0 build
+}
+
+uint64_t neorv32_clint_time_get(void) { return host_cycles(); }
+
+// ---------------- SYSINFO, absent peripherals ----------------
+neorv32_sysinfo_t fwhost_sysinfo = { FWHOST_CLK_HZ, { 0, 0, 1, 0 }, 0, 0 };
+neorv32_uart_t    fwhost_uart0;
+neorv32_dma_t     fwhost_dma;
+neorv32_tracer_t  fwhost_tracer;
+neorv32_cfs_t     fwhost_cfs_dummy;
+
+uint32_t neorv32_sysinfo_get_clk(void) { return FWHOST_CLK_HZ; }
+int  neorv32_dma_available(void) { return 0; }
+int  neorv32_tracer_available(void) { return 0; }
+int  neorv32_sdi_available(void) { return 0; }
+void neorv32_sdi_setup(uint32_t irq_mask) { (void)irq_mask; }
+int  neorv32_sdi_put_nonblocking(uint8_t b) { (void)b; return 0; }
+int  neorv32_spi_available(void) { return 0; }
+int  neorv32_trng_available(void) { return 0; }  // CMD_GEN falls back to GEN_SEED
+void neorv32_trng_enable(void) { }
+void neorv32_trng_disable(void) { }
+int  neorv32_trng_get(uint8_t *data) { (void)data; return -1; }
+void neorv32_spi_setup(int prsc, int cdiv, int clk_phase, int clk_pol) {
+  (void)prsc; (void)cdiv; (void)clk_phase; (void)clk_pol;
+}
+int neorv32_smp_launch(void (*entry)(void), uint8_t *stack, uint32_t size) {
+  (void)entry; (void)stack; (void)size;
+  return -1;
+}
+
+// ================================================================================
+// CFS model
+// ================================================================================
+#define R_CTRL       0
+#define R_LAMBDA     2
+#define R_EPS_B      4
+#define R_EPS_N      5
+#define R_D          7
+#define R_XIN        8
+#define R_YIN        9
+#define R_NODE_COUNT 10
+#define R_ACT_LO     11
+#define R_ACT_HI     12
+#define R_OUT_S12    13
+#define R_OUT_MIN1   14
+#define R_OUT_MIN2   15
+#define R_SMP_PUSH   16
+#define R_BATCH      17
+#define R_RES_S12    18
+#define R_RES_MIN1   19
+#define R_INFO       20
+#define R_CTX        21
+#define R_DIM        22
+#define R_DUMP       23
+#define R_PERF_CTRL  24
+#define R_PERF_BASE  25
+#define R_DUMP_DIV   32
+#define R_ACT_BASE   64
+#define R_NODE_BASE  128
+#define R_VEC_BASE   4096
+#define R_ADJ_BASE   8192
+
+#define SMP_DEPTH    32
+#define MAX_ACT      8     // 256 nodes (8-bit ids)
+#define MAX_WS       32    // DIM 64
+#define ADJ_WS       8     // adj row stride (MAX_ACT words)
+#define PERF_N       7
+#define DP_PAIRS     512   // framer pair_mem
+#define DP_NODES     50    // node records per NODES frame
+enum { P_START, P_SMP, P_BUSY, P_IDLE, P_NODE_WR, P_BUS, P_STALL };
+
+static const uint32_t par_reset[6] = { 100, 50, 19661, 66, 32768, 65208 };
+
+static struct {
+  uint32_t *node_mem;              // ctx * maxnodes * ws words
+  uint32_t *adj_mem;               // ctx * maxnodes * ADJ_WS words (-m)
+  uint32_t act[MAX_ACT];
+  uint32_t node_count;
+  uint32_t xin, yin, xin_run, yin_run;
+  uint32_t vec[2][MAX_WS];
+  int vec_wb, vec_new;
+  uint32_t par[6];
+  int ctx_sel;
+  int armed, bdone, irq_en, batch_en, sleep;
+  uint32_t out_s12, out_min1, out_min2;
+  uint32_t smp[SMP_DEPTH];
+  uint32_t smp_rp, smp_wp;
+  uint32_t res_s12[SMP_DEPTH], res_min1[SMP_DEPTH];
+  uint32_t res_rp, res_wp;
+  uint32_t perf[PERF_N];
+  int perf_freeze;
+  uint64_t perf_t;                 // host cycles already booked as IDLE
+  int starts;                      // START writes, for the idle backoff
+  uint32_t dump_div, dump_stat;    // -s
+} cfs;
+
+static void cfs_reset(void) {
+  g_words = (g_dim + 1) / 2;
+  g_ws = 1;
+  g_dshift = 0;
+  while (g_ws < g_words) { g_ws <<= 1; g_dshift++; }
+  g_act_words = (g_maxnodes + 31) / 32;
+  cfs.node_mem = calloc((size_t)g_ctx * (size_t)g_maxnodes * (size_t)g_ws, sizeof(uint32_t));
+  cfs.adj_mem = calloc((size_t)g_ctx * (size_t)g_maxnodes * ADJ_WS, sizeof(uint32_t));
+  if (!cfs.node_mem || !cfs.adj_mem) { perror("fwhost"); exit(1); }
+  memcpy(cfs.par, par_reset, sizeof(par_reset));
+  cfs.perf_t = host_cycles();
+}
+
+static inline uint32_t *node_row(int i) {
+  return &cfs.node_mem[((size_t)cfs.ctx_sel * (size_t)g_maxnodes + (size_t)i) * (size_t)g_ws];
+}
+
+static inline uint32_t *adj_row(int i) {
+  return &cfs.adj_mem[((size_t)cfs.ctx_sel * (size_t)g_maxnodes + (size_t)i) * ADJ_WS];
+}
+
+static inline uint32_t word_dist(uint32_t a, uint32_t b) {
+  int32_t dx = (int32_t)(a & 0xFFFFu) - (int32_t)(b & 0xFFFFu);
+  int32_t dy = (int32_t)(a >> 16) - (int32_t)(b >> 16);
+  return ((uint32_t)(dx * dx) + (uint32_t)(dy * dy)) >> g_dshift;
+}
+
+// one engine scan; 2D batch samples have no VEC words (vec = NULL)
+static void cfs_scan(uint32_t w0, const uint32_t *vec, uint32_t *s12, uint32_t *min1, uint32_t *min2) {
+  uint32_t m1 = 0xFFFFFFFFu, m2 = 0xFFFFFFFFu;
+  int id1 = 0, id2 = 0, groups = 0, last_group = -1;
+  int n = (int)cfs.node_count < g_maxnodes ? (int)cfs.node_count : g_maxnodes;
+  for (int i = 0; i < n; i++) {
+    if (!(cfs.act[i >> 5] & (1u << (i & 31)))) continue;
+    if (i / g_lanes != last_group) { last_group = i / g_lanes; groups++; }
+    const uint32_t *row = node_row(i);
+    uint64_t d = word_dist(w0, row[0]);
+    for (int w = 1; w < g_words; w++) d += word_dist(vec ? vec[w] : 0u, row[w]);
+    uint32_t d32 = (d >> 32) ? 0xFFFFFFFFu : (uint32_t)d;
+    if (d32 < m1) { m2 = m1; id2 = id1; m1 = d32; id1 = i; }
+    else if (d32 < m2) { m2 = d32; id2 = i; }
+  }
+  *s12 = (uint32_t)id1 | ((uint32_t)id2 << 8);
+  *min1 = m1;
+  *min2 = m2;
+  if (!cfs.perf_freeze) cfs.perf[P_BUSY] += (uint32_t)(groups * g_words + 5);
+}
+
+// Q1.15 halves of p one eps step towards t (move unit lerp_q15)
+static uint32_t lerp_word(uint32_t p, uint32_t t, uint32_t eps) {
+  uint32_t r = 0;
+  for (int h = 0; h < 32; h += 16) {
+    int32_t ph = (int16_t)(p >> h);
+    int32_t d = (int32_t)(int16_t)(t >> h) - ph;
+    int32_t m = (int32_t)((int64_t)d * (int64_t)eps + 32768);
+    r |= (uint32_t)(uint16_t)(ph + (m >> 16)) << h;
+  }
+  return r;
+}
+
+// move unit after a CTRL.MOVE scan: s1 by EPS_B, its active adj row by EPS_N
+static void cfs_move(void) {
+  int s1 = (int)(cfs.out_s12 & 0xFFu);
+  if (cfs.out_min2 == 0xFFFFFFFFu || s1 >= g_maxnodes) return;
+  uint32_t t = cfs.xin_run | (cfs.yin_run << 16);
+  uint32_t *row = node_row(s1);
+  row[0] = lerp_word(row[0], t, cfs.par[R_EPS_B - R_LAMBDA] & 0x1FFFFu);
+  const uint32_t eps_n = cfs.par[R_EPS_N - R_LAMBDA] & 0x1FFFFu;
+  for (int w = 0; w < g_act_words; w++) {
+    for (uint32_t b = adj_row(s1)[w] & cfs.act[w]; b; b &= b - 1u) {
+      int i = w * 32 + __builtin_ctz(b);
+      if (i >= g_maxnodes) break;
+      node_row(i)[0] = lerp_word(node_row(i)[0], t, eps_n);
+    }
+  }
+}
+
+// (v * 1000) >> 15 of a Q1.15 half (q15_to_wire of the framer)
+static inline uint16_t dump_wire(uint32_t w, int h) {
+  return (uint16_t)(((int32_t)(int16_t)(w >> h) * 1000) >> 15);
+}
+
+static void dump_frame(uint8_t cmd, const uint8_t *p, int len) {
+  uint8_t sum = (uint8_t)(cmd + len);
+  neorv32_uart0_putc((char)0xFF);
+  neorv32_uart0_putc((char)0xFF);
+  neorv32_uart0_putc((char)cmd);
+  neorv32_uart0_putc((char)len);
+  for (int i = 0; i < len; i++) {
+    neorv32_uart0_putc((char)p[i]);
+    sum = (uint8_t)(sum + p[i]);
+  }
+  neorv32_uart0_putc((char)~sum);
+}
+
+// snapshot framer: NODES, then the collected pairs (EDGES, EDGES_CHUNK > 126)
+static void cfs_dump(uint32_t v) {
+  uint8_t pl[255];
+  uint8_t fid = (uint8_t)v;
+  int n = 0, p = 2;
+  for (int i = 0; i < g_maxnodes && n < DP_NODES; i++) {
+    if (!(cfs.act[i >> 5] & (1u << (i & 31)))) continue;
+    uint32_t w = node_row(i)[0];
+    uint16_t x = dump_wire(w, 0), y = dump_wire(w, 16);
+    pl[p++] = (uint8_t)i;
+    pl[p++] = (uint8_t)x;
+    pl[p++] = (uint8_t)(x >> 8);
+    pl[p++] = (uint8_t)y;
+    pl[p++] = (uint8_t)(y >> 8);
+    n++;
+  }
+  pl[0] = fid;
+  pl[1] = (uint8_t)n;
+  dump_frame(0x10, pl, p);
+
+  int np = 0, ovf = 0;
+  static uint16_t pairs[DP_PAIRS];
+  if (g_move && (v & (1u << 9))) {
+    for (int i = 0; i < g_maxnodes; i++) {
+      for (int j = i + 1; j < g_maxnodes; j++) {
+        if (!(adj_row(i)[j >> 5] & (1u << (j & 31)))) continue;
+        if (np < DP_PAIRS) pairs[np++] = (uint16_t)(i << 8 | j);
+        else ovf = 1;
+      }
+    }
+    if (np <= 126) {
+      pl[1] = (uint8_t)np;
+      for (int k = 0; k < np; k++) { pl[2 + 2 * k] = (uint8_t)(pairs[k] >> 8); pl[3 + 2 * k] = (uint8_t)pairs[k]; }
+      dump_frame(0x11, pl, 2 + 2 * np);
+    } else {
+      int nch = (np + 123) / 124;
+      for (int c = 0; c < nch; c++) {
+        int m = (np - c * 124 < 124) ? np - c * 124 : 124;
+        pl[1] = 0;
+        pl[2] = (uint8_t)c;
+        pl[3] = (uint8_t)nch;
+        pl[4] = (uint8_t)np;
+        pl[5] = (uint8_t)(np >> 8);
+        pl[6] = (uint8_t)m;
+        for (int k = 0; k < m; k++) {
+          pl[7 + 2 * k] = (uint8_t)(pairs[c * 124 + k] >> 8);
+          pl[8 + 2 * k] = (uint8_t)pairs[c * 124 + k];
+        }
+        dump_frame(0x14, pl, 7 + 2 * m);
+      }
+    }
+  }
+  cfs.dump_stat = ((uint32_t)ovf << 2) | ((uint32_t)n << 8) | ((uint32_t)np << 16);
+}
+
+// batch: the engine scans FIFO samples while there are some and ring space
+static void cfs_batch_run(void) {
+  int ran = 0;
+  while (cfs.batch_en && cfs.smp_wp != cfs.smp_rp && (cfs.res_wp - cfs.res_rp) < SMP_DEPTH) {
+    uint32_t s12, m1, m2;
+    cfs_scan(cfs.smp[cfs.smp_rp++ % SMP_DEPTH], NULL, &s12, &m1, &m2);
+    cfs.res_s12[cfs.res_wp % SMP_DEPTH] = s12;
+    cfs.res_min1[cfs.res_wp % SMP_DEPTH] = m1;
+    cfs.res_wp++;
+    ran = 1;
+  }
+  if (ran) cfs.bdone = 1;
+}
+
+static inline int cfs_done(void) { return cfs.armed || cfs.bdone; }
+
+// IRQ level = DONE & IRQ_EN, taken with mstatus.MIE and mie.FIRQ1 set
+static void cfs_irq_check(void) {
+  if (in_trap || !irq_cfs || !cfs.irq_en || !cfs_done()) return;
+  if (!(csr_mstatus & (1u << CSR_MSTATUS_MIE)) || !(csr_mie & (1u << CFS_FIRQ_ENABLE))) return;
+  in_trap = 1;
+  csr_mstatus &= ~(1u << CSR_MSTATUS_MIE);
+  irq_cfs();
+  csr_mstatus |= (1u << CSR_MSTATUS_MIE);
+  in_trap = 0;
+}
+
+// cycles since the last access: IDLE unless the engine clock is gated
+static void cfs_perf_tick(void) {
+  uint64_t now = host_cycles();
+  if (!cfs.perf_freeze) {
+    if (!cfs.sleep) cfs.perf[P_IDLE] += (uint32_t)(now - cfs.perf_t);
+    cfs.perf[P_BUS]++;
+  }
+  cfs.perf_t = now;
+}
+
+static inline int in_node_window(uint32_t reg) {
+  return reg >= R_NODE_BASE && reg < R_NODE_BASE + (uint32_t)(g_maxnodes * g_ws);
+}
+
+static inline int in_adj(uint32_t reg) {
+  return g_move && reg >= R_ADJ_BASE && reg < R_ADJ_BASE + (uint32_t)g_maxnodes * ADJ_WS;
+}
+
+static inline int in_vec(uint32_t reg) {
+  return reg > R_VEC_BASE && reg < R_VEC_BASE + (uint32_t)g_words;
+}
+
+static inline int act_word(uint32_t reg) {
+  if (reg == R_ACT_LO) return 0;
+  if (reg == R_ACT_HI) return g_act_words > 1 ? 1 : -1;
+  if (reg >= R_ACT_BASE && reg < R_ACT_BASE + (uint32_t)g_act_words) return (int)(reg - R_ACT_BASE);
+  return -1;
+}
+
+void fwhost_cfs_wr(uint32_t reg, uint32_t v) {
+  cfs_perf_tick();
+  if (reg == R_CTRL) {
+    if (v & 1u) { cfs.armed = 0; cfs.bdone = 0; }
+    if (v & 2u) {
+      cfs.armed = 1;
+      cfs.bdone = 0;
+      cfs.xin_run = cfs.xin;
+      cfs.yin_run = cfs.yin;
+      if (cfs.vec_new) { cfs.vec_wb ^= 1; cfs.vec_new = 0; }
+      if (!cfs.perf_freeze) cfs.perf[P_START]++;
+      cfs.starts++;
+      cfs_scan(cfs.xin_run | (cfs.yin_run << 16), cfs.vec[cfs.vec_wb ^ 1],
+               &cfs.out_s12, &cfs.out_min1, &cfs.out_min2);
+      if (g_move && (v & (1u << 6)) && !(v & (1u << 3))) cfs_move();
+    }
+    cfs.irq_en   = (v >> 2) & 1u;
+    cfs.batch_en = (v >> 3) & 1u;
+    cfs.sleep    = (v >> 5) & 1u;
+    if (v & (1u << 4)) {  // FLUSH: drop queued samples and unread results
+      cfs.smp_rp = cfs.smp_wp;
+      cfs.res_rp = cfs.res_wp;
+    }
+  } else if (reg == R_XIN) {
+    cfs.xin = v & 0xFFFFu;
+  } else if (reg == R_YIN) {
+    cfs.yin = v & 0xFFFFu;
+  } else if (reg == R_NODE_COUNT) {
+    cfs.node_count = v & 0x1FFu;
+  } else if (reg >= R_LAMBDA && reg <= R_D) {
+    cfs.par[reg - R_LAMBDA] = v;
+  } else if (reg == R_CTX) {
+    if ((int)(v & 7u) < g_ctx) cfs.ctx_sel = (int)(v & 7u);
+  } else if (reg == R_SMP_PUSH) {
+    if (cfs.smp_wp - cfs.smp_rp < SMP_DEPTH) {
+      cfs.smp[cfs.smp_wp++ % SMP_DEPTH] = v;
+      if (!cfs.perf_freeze) cfs.perf[P_SMP]++;
+    } else if (!cfs.perf_freeze) {
+      cfs.perf[P_STALL]++;
+    }
+  } else if (g_dump && reg == R_DUMP_DIV) {
+    cfs.dump_div = v & 0xFFFFu;
+  } else if (g_dump && reg == R_DUMP) {
+    if ((v & (1u << 8)) && cfs.dump_div) cfs_dump(v);
+  } else if (reg == R_PERF_CTRL) {
+    if (v & 1u) memset(cfs.perf, 0, sizeof(cfs.perf));
+    cfs.perf_freeze = (v >> 1) & 1u;
+  } else if (in_node_window(reg)) {
+    uint32_t di = reg - R_NODE_BASE;
+    node_row((int)(di / (uint32_t)g_ws))[di % (uint32_t)g_ws] = v;
+    if (!cfs.perf_freeze) cfs.perf[P_NODE_WR]++;
+  } else if (in_adj(reg)) {
+    uint32_t di = reg - R_ADJ_BASE;
+    if (di % ADJ_WS < (uint32_t)g_act_words) adj_row((int)(di / ADJ_WS))[di % ADJ_WS] = v;
+  } else if (in_vec(reg)) {
+    cfs.vec[cfs.vec_wb][reg - R_VEC_BASE] = v;
+    cfs.vec_new = 1;
+  }
+  int w = act_word(reg);
+  if (w >= 0) cfs.act[w] = v;
+
+  cfs_batch_run();
+  cfs_irq_check();
+}
+
+uint32_t fwhost_cfs_rd(uint32_t reg) {
+  cfs_perf_tick();
+  uint32_t v = 0;
+  int w = act_word(reg);
+  if (reg == R_CTRL) {
+    v = ((uint32_t)cfs_done() << 17) | ((uint32_t)cfs.irq_en << 18) |
+        ((uint32_t)cfs.batch_en << 19) | ((uint32_t)cfs.sleep << 20);
+  } else if (reg >= R_LAMBDA && reg <= R_D) {
+    v = cfs.par[reg - R_LAMBDA];
+  } else if (reg == R_XIN) {
+    v = cfs.xin;
+  } else if (reg == R_YIN) {
+    v = cfs.yin;
+  } else if (reg == R_NODE_COUNT) {
+    v = cfs.node_count;
+  } else if (reg == R_INFO) {
+    v = (uint32_t)g_maxnodes | ((uint32_t)g_lanes << 16) | (1u << 25) | (1u << 26) |
+        ((uint32_t)g_ctx << 28);
+  } else if (reg == R_CTX) {
+    v = (uint32_t)cfs.ctx_sel;
+  } else if (reg == R_DIM) {
+    v = (uint32_t)g_dim | ((uint32_t)g_move << 16) | ((uint32_t)g_dump << 17);
+  } else if (g_dump && reg == R_DUMP) {
+    v = cfs.dump_stat;  // never busy: the frames went out inside the START write
+  } else if (g_dump && reg == R_DUMP_DIV) {
+    v = cfs.dump_div;
+  } else if (reg == R_PERF_CTRL) {
+    v = ((uint32_t)cfs.perf_freeze << 1) | ((uint32_t)PERF_N << 8);
+  } else if (reg >= R_PERF_BASE && reg < R_PERF_BASE + PERF_N) {
+    v = cfs.perf[reg - R_PERF_BASE];
+  } else if (reg == R_OUT_S12) {
+    v = cfs.out_s12;
+  } else if (reg == R_OUT_MIN1) {
+    v = cfs.out_min1;
+  } else if (reg == R_OUT_MIN2) {
+    v = cfs.out_min2;
+  } else if (reg == R_BATCH) {
+    v = (cfs.smp_wp - cfs.smp_rp) | ((cfs.res_wp - cfs.res_rp) << 8);
+  } else if (reg == R_RES_S12) {
+    v = cfs.res_s12[cfs.res_rp % SMP_DEPTH];
+  } else if (reg == R_RES_MIN1) {
+    v = cfs.res_min1[cfs.res_rp % SMP_DEPTH];
+    if (cfs.res_wp != cfs.res_rp) cfs.res_rp++;
+    else if (!cfs.perf_freeze) cfs.perf[P_STALL]++;
+  } else if (in_node_window(reg)) {
+    uint32_t di = reg - R_NODE_BASE;
+    v = node_row((int)(di / (uint32_t)g_ws))[di % (uint32_t)g_ws];
+  } else if (in_adj(reg)) {
+    uint32_t di = reg - R_ADJ_BASE;
+    if (di % ADJ_WS < (uint32_t)g_act_words) v = adj_row((int)(di / ADJ_WS))[di % ADJ_WS];
+  } else if (in_vec(reg)) {
+    v = cfs.vec[cfs.vec_new ? cfs.vec_wb : cfs.vec_wb ^ 1][reg - R_VEC_BASE];
+  } else if (w >= 0) {
+    v = cfs.act[w];
+  }
+
+  cfs_batch_run();  // a ring pop makes room for the next scan
+  cfs_irq_check();
+  return v;
+}
+
+int neorv32_cfs_available(void) { return 1; }
+
+// ================================================================================
+// UART0: pty or files
+// ================================================================================
+static int fd_in = -1, fd_out = -1;
+static int is_file = 0;         // -i given: exit after EOF + linger
+static int in_eof = 0;
+static uint64_t eof_at = 0;
+static uint32_t linger_ms = 500;
+
+static uint8_t rx_buf[4096];
+static int rx_pos = 0, rx_len = 0;
+static uint8_t tx_buf[4096];
+static int tx_len = 0;
+
+static int idle_polls = 0;      // empty RX polls with no START in between
+static int idle_starts = 0;
+
+static void tx_flush(void) {
+  int off = 0;
+  while (off < tx_len) {
+    ssize_t n = write(fd_out, tx_buf + off, (size_t)(tx_len - off));
+    if (n > 0) { off += (int)n; continue; }
+    if (n < 0 && errno == EINTR) continue;
+    if (n < 0 && errno == EAGAIN) {
+      // no reader on the pty: wait a little, then drop like an open line
+      struct pollfd p = { fd_out, POLLOUT, 0 };
+      if (poll(&p, 1, 100) > 0) continue;
+    }
+    break;
+  }
+  tx_len = 0;
+}
+
+static void fwhost_exit(void) {
+  tx_flush();
+  exit(0);
+}
+
+void neorv32_uart0_setup(uint32_t baud, uint32_t irq_mask) { (void)baud; (void)irq_mask; }
+
+void neorv32_uart0_putc(char c) {
+  if (tx_len == (int)sizeof(tx_buf)) tx_flush();
+  tx_buf[tx_len++] = (uint8_t)c;
+}
+
+void neorv32_uart0_puts(const char *s) {
+  while (*s) neorv32_uart0_putc(*s++);
+}
+
+// block up to ms for input (idle CPU)
+static void rx_wait(int ms) {
+  struct pollfd p = { fd_in, POLLIN, 0 };
+  if (!in_eof && poll(&p, 1, ms) > 0 && (p.revents & POLLIN)) return;
+  // EOF or a hung-up descriptor returns at once: sleep instead
+  struct timespec ts = { 0, (long)ms * 1000000L };
+  if (in_eof || p.revents) nanosleep(&ts, NULL);
+}
+
+int neorv32_uart0_char_received(void) {
+  if (rx_pos < rx_len) return 1;
+  if (!in_eof) {
+    ssize_t n = read(fd_in, rx_buf, sizeof(rx_buf));
+    if (n > 0) {
+      rx_pos = 0;
+      rx_len = (int)n;
+      idle_polls = 0;
+      return 1;
+    }
+    if (n == 0 && is_file) {
+      in_eof = 1;
+      eof_at = host_cycles();
+    }
+  }
+  tx_flush();  // nothing to read: the frames of this step go out now
+  if (in_eof && host_cycles() - eof_at >= (uint64_t)linger_ms * (FWHOST_CLK_HZ / 1000u)) fwhost_exit();
+  // not training (no START since the last empty poll): stop spinning
+  if (cfs.starts != idle_starts) { idle_starts = cfs.starts; idle_polls = 0; }
+  else if (++idle_polls > 64) rx_wait(1);
+  return 0;
+}
+
+char neorv32_uart0_getc(void) {
+  while (!neorv32_uart0_char_received()) { }
+  return (char)rx_buf[rx_pos++];
+}
+
+// wfi: the pending CFS IRQ, else the next RX byte (or 1 ms)
+void neorv32_cpu_sleep(void) {
+  csr_mstatus |= (1u << CSR_MSTATUS_MIE);
+  cfs_irq_check();
+  csr_mstatus &= ~(1u << CSR_MSTATUS_MIE);
+  if (rx_pos >= rx_len) { tx_flush(); rx_wait(1); }
+}
+
+static int open_pty(void) {
+  int m = posix_openpt(O_RDWR | O_NOCTTY);
+  if (m < 0 || grantpt(m) != 0 || unlockpt(m) != 0) { perror("fwhost: pty"); exit(1); }
+  const char *name = ptsname(m);
+  // keep the slave open: no EIO / HUP on the master between two host sessions
+  int s = open(name, O_RDWR | O_NOCTTY);
+  if (s < 0) { perror("fwhost: pty slave"); exit(1); }
+  struct termios t;
+  if (tcgetattr(s, &t) == 0) {
+    cfmakeraw(&t);
+    tcsetattr(s, TCSANOW, &t);
+  }
+  fcntl(m, F_SETFL, fcntl(m, F_GETFL) | O_NONBLOCK);
+  fprintf(stderr, "fwhost: UART0 on %s\n", name);
+  return m;
+}
+
+static void usage(void) {
+  fprintf(stderr,
+          "usage: fwhost [-i in] [-o out] [-t ms] [-n maxnodes] [-l lanes] [-c ctx] [-d dim] [-m] [-s]\n"
+          "  no -i: UART0 on a pseudo terminal (path on stderr)\n"
+          "  -i in   host -> board bytes from a file ('-' = stdin), exit -t ms after EOF\n"
+          "  -o out  board -> host bytes (default stdout with -i, the pty without)\n"
+          "  -t ms   run on after the input EOF (default 500)\n"
+          "  -n -l -c -d  CFS generics MAXNODES (40), LANES (4), CTX (1), DIM (2)\n"
+          "  -m      CFS generic MOVE = true (DIM 2)\n"
+          "  -s      CFS generic DUMP = true (keyframes from the CFS)\n");
+  exit(2);
+}
+
+int main(int argc, char **argv) {
+  const char *in = NULL, *out = NULL;
+  int opt;
+  while ((opt = getopt(argc, argv, "i:o:t:n:l:c:d:msh")) != -1) {
+    switch (opt) {
+      case 'i': in = optarg; break;
+      case 'o': out = optarg; break;
+      case 't': linger_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'n': g_maxnodes = atoi(optarg); break;
+      case 'l': g_lanes = atoi(optarg); break;
+      case 'c': g_ctx = atoi(optarg); break;
+      case 'd': g_dim = atoi(optarg); break;
+      case 'm': g_move = 1; break;
+      case 's': g_dump = 1; break;
+      default: usage();
+    }
+  }
+  if (g_maxnodes < 1 || g_maxnodes > 32 * MAX_ACT || g_lanes < 1 || g_ctx < 1 || g_ctx > 8 ||
+      g_dim < 2 || g_dim > 2 * MAX_WS || (g_move && g_dim != 2)) usage();
+
+  clock_gettime(CLOCK_MONOTONIC, &t_boot);
+  cfs_reset();
+
+  if (in) {
+    is_file = 1;
+    fd_in = strcmp(in, "-") ? open(in, O_RDONLY) : STDIN_FILENO;
+    fd_out = out ? open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644) : STDOUT_FILENO;
+    if (fd_in < 0 || fd_out < 0) { perror("fwhost"); return 1; }
+    if (fd_in == STDIN_FILENO) fcntl(fd_in, F_SETFL, fcntl(fd_in, F_GETFL) | O_NONBLOCK);
+  } else {
+    fd_in = open_pty();
+    fd_out = out ? open(out, O_WRONLY | O_CREAT | O_TRUNC, 0644) : fd_in;
+    if (fd_out < 0) { perror("fwhost"); return 1; }
+  }
+
+  return fw_main();
+}
@@ -0,0 +1,117 @@
+// ================================================================================
+// neorv32.h - host stand-in for the NEORV32 software framework (fwhost)
+//
+// Just what gng_neorv32_accelerator_V3/fw/main.c and gng_core/gng_cfs.h use,
+// built with UART_TX_IRQ=0 (blocking UART0 calls) and no SMP / SD / uflash:
+//   - CFS_RD / CFS_WR go to fwhost_cfs_rd / fwhost_cfs_wr, the register model
+//     of neorv32_cfs.vhd in fwhost.c; NEORV32_CFS only exists for the
+//     dma_copy_words() address (no DMA here, so it is never written)
+//   - UART0 getc / putc / char_received = the pty or the -i / -o files
+//   - mcycle and the CLINT count host time at the 27 MHz of tang_nano_9k
+//   - mie / mstatus are tracked, the CFS DONE IRQ runs its installed handler
+//     right after the register access that raised it (once MIE allows it)
+//   - every other peripheral reads as absent
+// ================================================================================
+
+#ifndef FWHOST_NEORV32_H
+#define FWHOST_NEORV32_H
+
+#include <stdint.h>
+
+#define FWHOST_CLK_HZ 27000000u  // tang_nano_9k.vhd CLOCK_FREQUENCY
+
+// ---------------- CFS (fwhost.c model) ----------------
+uint32_t fwhost_cfs_rd(uint32_t reg);
+void     fwhost_cfs_wr(uint32_t reg, uint32_t v);
+
+#define CFS_RD(r)    fwhost_cfs_rd((uint32_t)(r))
+#define CFS_WR(r, v) fwhost_cfs_wr((uint32_t)(r), (uint32_t)(v))
+
+typedef struct { volatile uint32_t REG[16384]; } neorv32_cfs_t;
+extern neorv32_cfs_t fwhost_cfs_dummy;
+#define NEORV32_CFS (&fwhost_cfs_dummy)
+
+int neorv32_cfs_available(void);
+
+// ---------------- CPU: CSRs, traps, sleep ----------------
+enum {
+  CSR_MSTATUS = 0x300, CSR_MISA = 0x301, CSR_MIE = 0x304, CSR_MXISA = 0xFC0,
+  CSR_MCYCLE = 0xB00, CSR_MCYCLEH = 0xB80, CSR_MHARTID = 0xF14
+};
+enum { CSR_MSTATUS_MIE = 3, CSR_MXISA_ZXCFU = 3 };
+enum {
+  UART0_FIRQ_ENABLE = 18, CFS_FIRQ_ENABLE = 17,  // FIRQ2 / FIRQ1
+  UART0_TRAP_CODE = 0x80000012, CFS_TRAP_CODE = 0x80000011
+};
+
+uint32_t neorv32_cpu_csr_read(int csr);
+void     neorv32_cpu_csr_set(int csr, uint32_t mask);
+void     neorv32_cpu_csr_clr(int csr, uint32_t mask);
+void     neorv32_cpu_sleep(void);
+void     neorv32_rte_setup(void);
+int      neorv32_rte_handler_install(uint32_t code, void (*handler)(void));
+uint64_t neorv32_clint_time_get(void);
+
+// ---------------- SYSINFO ----------------
+enum { SYSINFO_MISC_IMEM, SYSINFO_MISC_DMEM, SYSINFO_MISC_HART, SYSINFO_MISC_BOOT };
+typedef struct {
+  uint32_t CLK;
+  uint8_t  MISC[4];
+  uint32_t SOC;
+  uint32_t CACHE;
+} neorv32_sysinfo_t;
+extern neorv32_sysinfo_t fwhost_sysinfo;
+#define NEORV32_SYSINFO (&fwhost_sysinfo)
+
+uint32_t neorv32_sysinfo_get_clk(void);
+
+// ---------------- UART0 ----------------
+enum {
+  UART_CTRL_HWFC_EN = 2, UART_CTRL_RX_NEMPTY = 16, UART_CTRL_TX_NFULL = 19,
+  UART_CTRL_IRQ_RX_NEMPTY = 21, UART_CTRL_IRQ_TX_EMPTY = 24, UART_CTRL_TX_BUSY = 31
+};
+typedef struct { volatile uint32_t CTRL; volatile uint32_t DATA; } neorv32_uart_t;
+extern neorv32_uart_t fwhost_uart0;
+#define NEORV32_UART0 (&fwhost_uart0)  // CTRL reads 0: TX never busy
+
+void neorv32_uart0_setup(uint32_t baud, uint32_t irq_mask);
+void neorv32_uart0_putc(char c);
+void neorv32_uart0_puts(const char *s);
+int  neorv32_uart0_char_received(void);
+char neorv32_uart0_getc(void);
+
+// ---------------- absent peripherals ----------------
+typedef struct { volatile uint32_t CTRL; volatile uint32_t DESC; } neorv32_dma_t;
+extern neorv32_dma_t fwhost_dma;
+#define NEORV32_DMA (&fwhost_dma)
+int neorv32_dma_available(void);
+
+typedef struct {
+  volatile uint32_t CTRL;
+  volatile uint32_t STOP_ADDR;
+  volatile uint32_t DELTA_SRC;
+  volatile uint32_t DELTA_DST;
+} neorv32_tracer_t;
+extern neorv32_tracer_t fwhost_tracer;
+#define NEORV32_TRACER (&fwhost_tracer)
+enum {
+  TRACER_CTRL_EN = 0, TRACER_CTRL_HSEL = 1, TRACER_CTRL_START = 2,
+  TRACER_CTRL_STOP = 3, TRACER_CTRL_RUN = 4, TRACER_CTRL_AVAIL = 5
+};
+int neorv32_tracer_available(void);
+
+int  neorv32_sdi_available(void);
+void neorv32_sdi_setup(uint32_t irq_mask);
+int  neorv32_sdi_put_nonblocking(uint8_t b);
+
+int  neorv32_spi_available(void);
+void neorv32_spi_setup(int prsc, int cdiv, int clk_phase, int clk_pol);
+
+int  neorv32_trng_available(void);
+void neorv32_trng_enable(void);
+void neorv32_trng_disable(void);
+int  neorv32_trng_get(uint8_t *data);
+
+int neorv32_smp_launch(void (*entry)(void), uint8_t *stack, uint32_t size);
+
+#endif // FWHOST_NEORV32_H
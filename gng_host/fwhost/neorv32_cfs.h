@@ -0,0 +1,6 @@
+// neorv32_cfs.h - host stand-in (fwhost): the CFS is the register model in
+// fwhost.c, reached through CFS_RD / CFS_WR of neorv32.h
+#ifndef FWHOST_NEORV32_CFS_H
+#define FWHOST_NEORV32_CFS_H
+#include "neorv32.h"
+#endif
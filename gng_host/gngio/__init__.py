@@ -0,0 +1,30 @@
+"""
+gngio - serial receiver shared by the GNG host tools
+====================================================
+
+    from gngio import SerialReader, CMD_GNG_NODES, decode_nodes
+
+    rd = SerialReader("COM5", 1_000_000, kind="ff", record="run.gnglog")
+    rd.start()
+    for fr in rd.frames():
+        if fr.cmd == CMD_GNG_NODES:
+            frame_id, nodes = decode_nodes(fr.payload)   # nodes["x"] / 1000.0
+
+kind="a5" selects the V2 gng.vhd stream (A5 10 / 20 / 21).
+gngio.metrics holds the vectorized QE / TE kernel of the metrics scripts.
+"""
+
+from .protocol import *  # noqa: F401,F403
+from .protocol import Frame, FrameParser, A5Parser, encode_frame, encode_data_batch
+from .recorder import Recorder, read_log, replay
+from .reader import (SerialReader, cfs_perf, checkpoint, link, model_command, query, sd_command,
+                     set_baud, set_params, trace_capture)
+from . import bootload, linktest, metrics, sdcard
+
+__all__ = [
+    "Frame", "FrameParser", "A5Parser", "encode_frame", "encode_data_batch",
+    "Recorder", "read_log", "replay", "SerialReader", "set_baud", "set_params", "checkpoint",
+    "sd_command", "model_command", "query", "cfs_perf",
+    "trace_capture", "link",
+    "bootload", "linktest", "metrics", "sdcard",
+]
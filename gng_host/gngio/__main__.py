@@ -0,0 +1,422 @@
+"""
+python -m gngio record <port> <out.gnglog> [--baud N] [--a5] [--seconds S]
+python -m gngio dump <in.gnglog>
+python -m gngio bench <port> [--board v3|v2|v2-sw] [--exe neorv32_exe.bin] [--build LABEL]
+python -m gngio ckpt <port> save|load|erase [--baud N]
+python -m gngio sd <port> train|log|stop [--arg N] [--baud N]
+python -m gngio params <port> [--lambda N] [--a-max N] [--eps-b F] [--eps-n F] [--alpha F] [--d F]
+                               [--drift-rise F] [--drift-hold N] [--drift-eps F] [--drift-lambda N] [--drift-amax N]
+python -m gngio model <port> [--run K] [--slice N] [--view M] [--hier 0|1]
+python -m gngio perf <port> [--clear]
+python -m gngio stats <port> [--ms N] [--seconds S]
+python -m gngio eval <port> [--every N] [--seconds S]
+python -m gngio link <port> [--clear] [--cobs | --legacy]
+python -m gngio linktest <port> [-c ff|cobs|both] [--frames N] [--len L] [--hit P] [--kinds drop,flip,noise]
+python -m gngio suite run <platform>... [--port P] [--dataset D] [--results F] | golden | table <F>...
+python -m gngio precision [--qe-rel R] [--pos P,..] [--err E,..] [--age A,..] [--deg D,..]
+                          [--header gng_layout.h] [--vhd gng_layout.vhd] [--results F]
+python -m gngio query <port> [--dataset NAME] [--labels] [--window N]
+python -m gngio shard <port>... [--dataset NAME] [--rounds N] [--round S] [--max-nodes N] [--out F]
+python -m gngio export <in.npz|in.gnglog> <out.h>
+python -m gngio sdlog <GNGLOG.BIN> [--alloc MB]
+python -m gngio pnr show|record <project>... [--label L] [--results suite.json] | table [history]
+python -m gngio trace capture <port> <out.txt> [--steps N] | report <out.txt> <main.elf> [--top N]
+python -m gngio tb vectors v2|v3 <out.txt> | data <out.txt> | check <tx.txt> <data.txt>
+"""
+
+import argparse
+import time
+
+import numpy as np
+
+from . import bench
+from . import export
+from . import linktest
+from . import pnr
+from . import precision
+from . import protocol as P
+from . import sdcard
+from . import shard
+from . import suite
+from . import tb
+from . import trace
+from .reader import (SerialReader, cfs_perf, checkpoint, link, model_command, query, sd_command,
+                     set_params)
+from .recorder import replay, read_log
+
+
+def _summary(fr) -> str:
+    if fr.kind == "a5":
+        if fr.cmd == P.A5_DBG:
+            d = P.decode_a5_dbg(fr.payload)
+            return f"A5 DBG s1={d['s1']} s2={d['s2']} nodes={d['node_count']} ts={d['ts']}"
+        if fr.cmd == P.A5_NODES:
+            cnt, nodes = P.decode_a5_nodes(fr.payload)
+            return f"A5 NODES count={cnt} act={int(nodes['act'].astype(bool).sum())}"
+        if fr.cmd == P.A5_EDGE_BITMAP:
+            return f"A5 EDGE_BITMAP n={int(np.unpackbits(np.frombuffer(fr.payload, np.uint8)[4:]).sum())}"
+        return f"A5 EDGES n={len(P.decode_a5_edges(fr.payload))}"
+    if fr.cmd == P.CMD_GNG_NODES:
+        fid, nodes = P.decode_nodes(fr.payload)
+        return f"NODES frame={fid} n={len(nodes)}"
+    if fr.cmd == P.CMD_GNG_EDGES:
+        fid, edges = P.decode_edges(fr.payload)
+        return f"EDGES frame={fid} e={len(edges)}"
+    if fr.cmd == P.CMD_GNG_EDGES_CHUNK:
+        fid, c, nc, total, pairs = P.decode_edges_chunk(fr.payload)
+        return f"EDGES_CHUNK frame={fid} {c + 1}/{nc} total={total}"
+    if fr.cmd == P.CMD_GNG_EDGES_BITMAP:
+        fid, edges = P.decode_edges_bitmap(fr.payload)
+        return f"EDGES_BITMAP frame={fid} e={len(edges)} gap={fr.payload[2] & 1}"
+    if fr.cmd == P.CMD_GNG_DELTA:
+        fid, nodes, add, rem = P.decode_delta(fr.payload)
+        return f"DELTA frame={fid} n={len(nodes)} +{len(add)} -{len(rem)}"
+    if fr.cmd == P.CMD_PROF:
+        d = P.decode_prof(fr.payload)
+        line = f"PROF frame={d['frame_id']} step={d.get('step')} cyc_total={d['cyc_total']}"
+        if "qe" in d:
+            line += f" qe={d['qe'] / 2.0**30:.3g}"
+        if d.get("qe_slow"):
+            line += (f" drift events={d['drift_events']} lat={d['drift_lat']}"
+                     f" left={d['drift_left']}")
+        if "passes" in d:
+            line += f" passes={d['passes']}"
+        if d.get("rx_bad") or d.get("rx_lost"):
+            line += f" rx_bad={d['rx_bad']} rx_lost={d['rx_lost']}"
+        return line
+    if fr.cmd == P.CMD_PROF_AGG:
+        d = P.decode_prof_agg(fr.payload)
+        mean = d["sum"] / d["count"] if d["count"] else 0.0
+        return (f"PROF_AGG frame={d['frame_id']} {d['phase']} n={d['count']} "
+                f"min={d['min']} mean={mean:.0f} max={d['max']}")
+    if fr.cmd == P.CMD_CREDIT:
+        return f"CREDIT {P.decode_credit(fr.payload)}"
+    if fr.cmd == P.CMD_CKPT_ACK:
+        op, ok, seq = P.decode_ckpt_ack(fr.payload)
+        return f"CKPT_ACK op={op} ok={int(ok)} seq={seq}"
+    if fr.cmd == P.CMD_SD_ACK:
+        op, status, samples, sectors = P.decode_sd_ack(fr.payload)
+        return f"SD_ACK op={op} {P.SD_STATUS.get(status, status)} samples={samples} sectors={sectors}"
+    if fr.cmd == P.CMD_PARAMS_ACK:
+        return "PARAMS_ACK " + _params_line(P.decode_params_ack(fr.payload))
+    if fr.cmd == P.CMD_MODEL_ACK:
+        return "MODEL_ACK " + _model_line(P.decode_model_ack(fr.payload))
+    if fr.cmd == P.CMD_GNG_COMPONENTS:
+        fid, count, first, lbl = P.decode_components(fr.payload)
+        return f"COMPONENTS frame={fid} count={count} nodes={first}..{first + len(lbl) - 1}"
+    if fr.cmd == P.CMD_GNG_REMAP:
+        fid, m = P.decode_remap(fr.payload)
+        return f"REMAP frame={fid} " + " ".join(f"{a}->{b}" for a, b in m.items())
+    if fr.cmd == P.CMD_CONVERGED:
+        d = P.decode_converged(fr.payload)
+        return (f"CONVERGED step={d['step']} since={d['since']} qe={d['qe']:.3g}"
+                f" churn={d['churn']} action={d['action']}")
+    if fr.cmd == P.CMD_CFS_PERF_ACK:
+        d = P.decode_cfs_perf(fr.payload)
+        return "CFS_PERF " + (_perf_line(d) if d else "none")
+    if fr.cmd == P.CMD_STATS_FRAME:
+        return "STATS " + _stats_line(P.decode_stats(fr.payload))
+    if fr.cmd == P.CMD_EVAL_ACK:
+        return "EVAL " + _eval_line(P.decode_eval(fr.payload))
+    if fr.cmd == P.CMD_LINK_ACK:
+        return "LINK_ACK " + _link_line(P.decode_link_ack(fr.payload))
+    if fr.cmd == P.CMD_SEED_ACK:
+        ok, n, e, lost = P.decode_seed_ack(fr.payload)
+        return f"SEED_ACK ok={int(ok)} nodes={n} edges={e} lost={lost}"
+    if fr.cmd == P.CMD_GEN_ACK:
+        kind, seed, trng = P.decode_gen_ack(fr.payload)
+        return f"GEN_ACK kind={kind} seed=0x{seed:08x}{' (trng)' if trng else ''}"
+    if fr.cmd == P.CMD_TRACE_DATA:
+        step, cycles, first, flags, rec = P.decode_trace_data(fr.payload)
+        if flags & P.TRACE_NONE:
+            return "TRACE_DATA none"
+        return (f"TRACE_DATA step={step} cycles={cycles} pairs={first}..{first + len(rec) - 1}"
+                + (" last" if flags & P.TRACE_LAST else ""))
+    if fr.cmd == P.CMD_QUERY_ACK:
+        seq, first, rec = P.decode_query_ack(fr.payload)
+        return f"QUERY_ACK seq={seq} first={first} n={len(rec)}"
+    return f"CMD 0x{fr.cmd:02X} len={len(fr.payload)}"
+
+
+def _model_line(d: dict) -> str:
+    per = " ".join(f"[{m}] steps={s} samples={n}"
+                   for m, (s, n) in enumerate(zip(d["steps"], d["samples"])))
+    hier = " hier" if d.get("hier") else ""
+    return f"k={d['k']}/{d['models']} view={d['view']} slice={d['slice']} banks={d['banks']}{hier} {per}"
+
+
+def _perf_line(d: dict) -> str:
+    duty = d["busy"] / max(d["busy"] + d["idle"], 1)
+    per = d["bus"] / max(d["start"] + d["smp"], 1)
+    return (" ".join(f"{k}={v}" for k, v in d.items())
+            + f" duty={100 * duty:.1f}% bus/search={per:.1f}")
+
+
+def _stats_line(d: dict) -> str:
+    return " ".join(f"{k}={d[k]}" for k in P.STATS_FIELDS if k != "cycles")
+
+
+def _eval_line(d: dict) -> str:
+    return (f"step={d['step']} n={d['n']} qe={d['qe']:.5f} mse={d['mse']:.6f} "
+            f"te={d['te']:.4f} cycles={d['cycles']}")
+
+
+def _link_line(d: dict) -> str:
+    framing = "cobs" if d["framing"] == P.RX_FRAMING_COBS else "ff"
+    return f"framing={framing} " + " ".join(f"{k}={d[k]}" for k in P.LINK_FIELDS)
+
+
+def _params_line(par: dict) -> str:
+    return " ".join(f"{k}={v:g}" for k, v in par.items())
+
+
+def main():
+    ap = argparse.ArgumentParser(prog="gngio")
+    sub = ap.add_subparsers(dest="op", required=True)
+    r = sub.add_parser("record")
+    r.add_argument("port")
+    r.add_argument("out")
+    r.add_argument("--baud", type=int, default=1_000_000)
+    r.add_argument("--a5", action="store_true", help="V2 gng.vhd A5 stream")
+    r.add_argument("--seconds", type=float, default=0, help="0 = until Ctrl-C")
+    d = sub.add_parser("dump")
+    d.add_argument("log")
+    bench.add_arguments(sub.add_parser("bench", help="hardware-in-the-loop benchmark"))
+    suite.add_arguments(sub.add_parser("suite", help="cross-implementation benchmark suite (bench_suite.json)"))
+    precision.add_arguments(sub.add_parser("precision", help="field width sweep on gngsim -> gng_layout.h / .vhd"))
+    c = sub.add_parser("ckpt", help="V3 user flash checkpoint")
+    c.add_argument("port")
+    c.add_argument("action", choices=("save", "load", "erase"))
+    c.add_argument("--baud", type=int, default=1_000_000)
+    s = sub.add_parser("sd", help="V3 TF card run (SD_CARD=1 build)")
+    s.add_argument("port")
+    s.add_argument("action", choices=("train", "log", "stop"))
+    s.add_argument("--arg", type=int, help="train: passes (0 = endless), log: 1 = tee to the wire")
+    s.add_argument("--baud", type=int, default=1_000_000)
+    q = sub.add_parser("params", help="V3 GNG parameters at run time (no option = query)")
+    q.add_argument("port")
+    q.add_argument("--lambda", dest="lambda_", type=int, metavar="N")
+    q.add_argument("--a-max", type=int)
+    for name in ("eps-b", "eps-n", "alpha", "d", "drift-rise", "drift-eps"):
+        q.add_argument(f"--{name}", type=float)
+    for name in ("drift-hold", "drift-lambda", "drift-amax"):
+        q.add_argument(f"--{name}", type=int)
+    q.add_argument("--baud", type=int, default=1_000_000)
+    m = sub.add_parser("model", help="V3 time-sliced models (GNG_MODELS > 1 build)")
+    m.add_argument("port")
+    m.add_argument("--run", type=int, metavar="K", help="models 0..K-1 take turns")
+    m.add_argument("--slice", type=int, default=0, help="steps per turn (with --run)")
+    m.add_argument("--view", type=int, metavar="M", help="model the snapshots show")
+    m.add_argument("--hier", type=int, choices=(0, 1),
+                   help="1 = model 0 routes the samples to models 1.. (coarse / fine)")
+    m.add_argument("--baud", type=int, default=1_000_000)
+    f = sub.add_parser("perf", help="V3 CFS perf counters (bitstream INFO bit 26)")
+    f.add_argument("port")
+    f.add_argument("--clear", action="store_true", help="restart the counters after the read")
+    f.add_argument("--baud", type=int, default=1_000_000)
+    t = sub.add_parser("stats", help="V3 health stats frames (steps/s, nodes, edges, link)")
+    t.add_argument("port")
+    t.add_argument("--ms", type=int, default=1000, help="interval, left running on exit (0 = off)")
+    t.add_argument("--seconds", type=float, default=0, help="0 = until Ctrl-C")
+    t.add_argument("--baud", type=int, default=1_000_000)
+    v = sub.add_parser("eval", help="V3 on-board QE / TE sweeps over the resident samples")
+    v.add_argument("port")
+    v.add_argument("--every", type=int, default=0, help="steps between sweeps, left running on exit (0 = one)")
+    v.add_argument("--seconds", type=float, default=0, help="0 = until Ctrl-C (one sweep: until its ACK)")
+    v.add_argument("--baud", type=int, default=1_000_000)
+    k = sub.add_parser("link", help="V3 RX frame counters / host -> board framing")
+    k.add_argument("port")
+    k.add_argument("--clear", action="store_true", help="restart the counters after the read")
+    k.add_argument("--cobs", action="store_true", help="switch to COBS frames")
+    k.add_argument("--legacy", action="store_true", help="switch back to FF FF frames")
+    k.add_argument("--baud", type=int, default=1_000_000)
+    linktest.add_arguments(sub.add_parser("linktest", help="V3 frame parser loss / noise stress test"))
+    y = sub.add_parser("query", help="V3 nearest-node lookups on the trained network")
+    y.add_argument("port")
+    y.add_argument("--dataset", default="circles", help="bench dataset to look up")
+    y.add_argument("--labels", action="store_true", help="connected component of s1 as well")
+    y.add_argument("--window", type=int, default=2, help="query frames in flight")
+    y.add_argument("--baud", type=int, default=1_000_000)
+    shard.add_arguments(sub.add_parser("shard", help="V3 boards on dataset shards, merged and re-seeded"))
+    export.add_arguments(sub.add_parser("export", help="network -> gng_model.h of the V3 inference image"))
+    g = sub.add_parser("sdlog", help="dump (or --alloc) a card frame log")
+    g.add_argument("log")
+    g.add_argument("--alloc", type=int, metavar="MB", help="create a zero-filled log instead")
+    pnr.add_arguments(sub.add_parser("pnr", help="Gowin PnR resource / timing snapshots and history"))
+    trace.add_arguments(sub.add_parser("trace", help="V3 neorv32_tracer profile (GNG_TRACE=1 build)"))
+    tb.add_arguments(sub.add_parser("tb", help="HDL testbench vectors / gng.vhd capture check"))
+    args = ap.parse_args()
+
+    if args.op == "tb":
+        raise SystemExit(tb.main(args))
+
+    if args.op == "trace":
+        raise SystemExit(trace.main(args))
+
+    if args.op == "pnr":
+        raise SystemExit(pnr.main(args))
+
+    if args.op == "sd":
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            op = {"train": P.SD_OP_TRAIN, "log": P.SD_OP_LOG, "stop": P.SD_OP_STOP}[args.action]
+            status, samples, sectors = sd_command(ser, op, args.arg)
+        print(f"{args.action}: {P.SD_STATUS.get(status, 'no answer')}, "
+              f"samples={samples} log sectors={sectors}")
+        raise SystemExit(0 if status == 0 else 1)
+
+    if args.op == "params":
+        import serial
+        new = {k: getattr(args, k + "_" if k == "lambda" else k) for k in P.PARAM_NAMES}
+        new = {k: v for k, v in new.items() if v is not None}
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            par = set_params(ser, new)
+        if par is None:
+            raise SystemExit("no PARAMS_ACK (fw built with GNG_PARAMS_RT=0?)")
+        print(_params_line(par))
+        raise SystemExit(0)
+
+    if args.op == "model":
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            d = None
+            if args.run is not None:
+                d = model_command(ser, P.MODEL_OP_RUN, args.run, args.slice)
+            if args.hier is not None:
+                d = model_command(ser, P.MODEL_OP_HIER, args.hier)
+            if args.view is not None:
+                d = model_command(ser, P.MODEL_OP_VIEW, args.view)
+            if args.run is None and args.view is None and args.hier is None:
+                d = model_command(ser)
+        if d is None:
+            raise SystemExit("no MODEL_ACK (fw built with GNG_MODELS=1?)")
+        print(_model_line(d))
+        raise SystemExit(0)
+
+    if args.op == "perf":
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            answered, d = cfs_perf(ser, args.clear)
+        if not answered:
+            raise SystemExit("no CFS_PERF_ACK (fw built with CFS_PERF=0?)")
+        if d is None:
+            raise SystemExit("bitstream has no CFS perf counters")
+        print(_perf_line(d))
+        raise SystemExit(0)
+
+    if args.op == "stats":
+        import serial
+        parser = P.FrameParser()
+        t0 = time.time()
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            ser.write(P.encode_stats(args.ms))
+            try:
+                while not args.seconds or time.time() - t0 < args.seconds:
+                    for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+                        if fr.cmd == P.CMD_STATS_FRAME:
+                            print(f"{time.time() - t0:8.2f}  {_stats_line(P.decode_stats(fr.payload))}")
+            except KeyboardInterrupt:
+                pass
+        raise SystemExit(0)
+
+    if args.op == "eval":
+        import serial
+        parser = P.FrameParser()
+        t0 = time.time()
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            ser.write(P.encode_eval(args.every))
+            try:
+                while not args.seconds or time.time() - t0 < args.seconds:
+                    for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+                        if fr.cmd == P.CMD_EVAL_ACK:
+                            print(f"{time.time() - t0:8.2f}  {_eval_line(P.decode_eval(fr.payload))}")
+                            if not args.every:
+                                raise SystemExit(0)
+            except KeyboardInterrupt:
+                pass
+        raise SystemExit(0)
+
+    if args.op == "link":
+        import serial
+        op = P.LINK_OP_COBS if args.cobs else P.LINK_OP_LEGACY if args.legacy else P.LINK_OP_STATS
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            # a board left in COBS framing takes the legacy switch as a COBS frame
+            d = link(ser, op, args.clear, cobs=args.legacy)
+        if d is None:
+            raise SystemExit("no LINK_ACK (fw without CMD_LINK?)")
+        print(_link_line(d))
+        raise SystemExit(0)
+
+    if args.op == "linktest":
+        raise SystemExit(linktest.main(args))
+
+    if args.op == "shard":
+        raise SystemExit(shard.main(args))
+
+    if args.op == "export":
+        raise SystemExit(export.main(args))
+
+    if args.op == "query":
+        import serial
+        data = bench.load_dataset(args.dataset)
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            res, dt = query(ser, data, args.labels, args.window)
+        ok = res["s1"] != P.QUERY_NONE
+        line = (f"{len(res)} queries in {dt:.3f} s ({len(res) / max(dt, 1e-9):.0f}/s), "
+                f"{len(np.unique(res['s1'][ok]))} nodes hit, "
+                f"mean min1={res['min1'][ok].mean() / 2**30 if ok.any() else 0:.5f}")
+        if args.labels:
+            line += f", {len(np.unique(res['label'][ok]))} components"
+        print(line)
+        raise SystemExit(0 if ok.any() else 1)
+
+    if args.op == "sdlog":
+        if args.alloc:
+            sdcard.alloc_log(args.log, args.alloc)
+            raise SystemExit(0)
+        info, frames = sdcard.read_log(args.log)
+        if info is None:
+            raise SystemExit(f"{args.log}: no GNGL header (blank or not a card log)")
+        print(f"# sectors={info['sectors']} samples={info['samples']} frames={len(frames)}")
+        for fr in frames:
+            print(_summary(fr))
+        raise SystemExit(0)
+
+    if args.op == "ckpt":
+        import serial
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            op = {"save": P.CKPT_SAVE, "load": P.CKPT_LOAD, "erase": P.CKPT_ERASE}[args.action]
+            ok, seq = checkpoint(ser, op)
+        print(f"{args.action}: {'ok' if ok else 'FAILED'}, newest checkpoint seq={seq}")
+        raise SystemExit(0 if ok else 1)
+
+    if args.op == "bench":
+        raise SystemExit(bench.run(args))
+    if args.op == "suite":
+        raise SystemExit(suite.main(args))
+    if args.op == "precision":
+        raise SystemExit(precision.main(args))
+    if args.op == "record":
+        rd = SerialReader(args.port, args.baud, "a5" if args.a5 else "ff", record=args.out)
+        rd.start()
+        t0 = time.time()
+        n = 0
+        try:
+            while not args.seconds or time.time() - t0 < args.seconds:
+                n += len(rd.drain())
+                time.sleep(0.2)
+        except KeyboardInterrupt:
+            pass
+        rd.stop()
+        dt = time.time() - t0
+        print(f"{rd.bytes_in} bytes, {n} frames, {rd.parser.frames_bad} bad, "
+              f"{rd.bytes_in / max(dt, 1e-9):.0f} B/s")
+    else:
+        info, _ = read_log(args.log)
+        print(f"# baud={info['baud']} kind={info['kind']}")
+        for t_ns, fr in replay(args.log):
+            print(f"{t_ns / 1e9:10.4f}  {_summary(fr)}")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,606 @@
+"""
+Hardware-in-the-loop benchmark
+==============================
+
+Flashes a build (optional), trains on a standard dataset of
+benchmark_datasets.DatasetGenerator and reports what the board did:
+
+- steps/s per phase, from the host clock between the first and the last
+  profiling frame of the phase
+- mean / p50 / p99 cycles of every PROF phase (cyc_winner, cyc_nb, ...);
+  PROF carries the last step before each snapshot, so these are sampled
+- with CMD_PROF_AGG (V3 GNG_PROF_AGG=1) every step of the phase instead:
+  count, mean, max and p50 / p99 / p99.9 bounds from the log2 histograms
+  (the upper edge of the bucket the quantile falls in); --hist draws them
+- link utilization: bytes * 10 / (baud * seconds), each direction
+- awake share and awake cycles per step from the PROF idle / time counters
+  (CLINT ticks in the firmware's idle wfi); with --active-mw also uJ per
+  step, the energy number of a build that sleeps while it waits for samples
+- drift adaptation (V3 GNG_DRIFT): boosts started in the phase and the
+  latency of each in steps (PROF drift_events / drift_lat); --drift-samples
+  K streams the dataset as three segments of K samples each (temporal:
+  the three cluster positions), so the input really moves
+
+Phases (board "v3"):
+  stream  CMD_SNAP_MODE EVERY --every steps (the default GUI setting)
+  quiet   CMD_SNAP_MODE TIME --quiet-ms: almost no UART traffic, the PROF
+          frames of the rare snapshots still give the step counter
+
+Boards:
+  v3      V3 firmware: DATA_BATCH + DONE (or --feed stream: CMD_STREAM and
+          CMD_CREDIT back-pressure; --feed gen: CMD_GEN, the dataset drawn
+          on the board by gng_gen.h, no upload, --gen-seed), PROF frames
+  v2      V2 gng.vhd: raw int16 dataset blob, A5 DBG frames; cycles per
+          iteration from the DBG timestamps (27 MHz) / --dbg-every
+  v2-sw   V2 software firmware: NODES frame every --every steps, no cycles
+
+Every run appends one record to a JSON history (--history) and is compared
+with the last record of the same board / dataset / feed / baud: a phase
+whose steps/s fell or whose p50 cyc_total rose by more than --tolerance is
+reported as a regression (exit status 2 with --strict). The p50 change of
+every PROF phase is printed as well; with the PROF `cache` word in the
+record this is how two i-cache profiles (presets.py CPU_ICACHE) compare.
+
+    python -m gngio bench COM5 --board v3 --exe fw/neorv32_exe.bin --build cfs-batch8
+    python -m gngio bench COM5 --board v2 --dataset circles --seconds 20
+"""
+
+import hashlib
+import json
+import platform
+import subprocess
+import sys
+import time
+from pathlib import Path
+
+import numpy as np
+
+from . import protocol as P
+from .bootload import FAST_BAUD, fast_upload
+from .reader import SerialReader, set_baud
+
+_REPO = Path(__file__).resolve().parents[2]
+_DATASETS = _REPO / "gng_neorv32_accelerator_V2" / "fw"
+
+CPU_HZ = 27_000_000       # Tang Nano 9K clock (V2 and V3)
+BOOT_BAUD = 256000        # NEORV32 bootloader (uart_upload.py)
+APP_BAUD = 1_000_000      # BAUD_RATE of the V2 / V3 firmware
+SETTLE_S = 0.3            # PROF frames this long after a phase switch are dropped
+
+BOARDS = {
+    # frame kind, dataset limit (MAXPTS of the firmware / gng.vhd)
+    "v3":    {"kind": "ff", "max_pts": 1000},
+    "v2":    {"kind": "a5", "max_pts": 100},
+    "v2-sw": {"kind": "ff", "max_pts": 100},
+}
+
+CYC_FIELDS = tuple(f for f in P.PROF_FIELDS if f.startswith("cyc_"))
+
+
+# ---------------------------------------------------------------------------
+# flashing (NEORV32 bootloader, same sequence as uart_upload.py)
+# ---------------------------------------------------------------------------
+def _expect(ser, token: str, timeout: float) -> str:
+    text = ""
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        text += ser.read(max(1, ser.in_waiting)).decode(errors="ignore")
+        if token in text:
+            return text
+    raise RuntimeError(f"bootloader: no '{token}' (reset the board before flashing)")
+
+
+def flash(port: str, exe: str, boot_baud: int = BOOT_BAUD, fast_baud: int = FAST_BAUD):
+    """Upload exe to the bootloader and start it; returns when sent.
+
+    fast_baud > 0 uses the block upload ('f': changed pages only, see
+    bootload.py) and falls back to 'z' + 'u' on a bootloader without it.
+    """
+    import serial
+
+    image = Path(exe).read_bytes()
+    with serial.Serial(port, boot_baud, timeout=0.1) as ser:
+        ser.write(b" ")                  # abort autoboot
+        _expect(ser, "CMD:>", 10.0)
+        if fast_baud:
+            try:
+                sent, total = fast_upload(ser, image, fast_baud)
+                print(f"flash: {sent} of {total} pages written", file=sys.stderr)
+                return
+            except RuntimeError as e:
+                if "old bootloader" not in str(e):
+                    raise
+                ser.write(b"\n")
+                _expect(ser, "CMD:>", 2.0)
+        ser.write(b"z")                  # erase
+        _expect(ser, "CMD:>", 30.0)
+        ser.write(b"u")
+        _expect(ser, "Awaiting neorv32_exe.bin", 5.0)
+        ser.write(image)
+        _expect(ser, "OK", 30.0)
+        ser.write(b"e")
+        ser.flush()
+
+
+def wait_banner(ser, token: str = "CFS=", timeout: float = 3.0) -> str:
+    """Firmware text after boot (READY / CFS=1 / DMA=1 ...)."""
+    text = ""
+    t_end = time.time() + timeout
+    while time.time() < t_end and token not in text:
+        text += ser.read(64).decode(errors="ignore")
+    return text
+
+
+# ---------------------------------------------------------------------------
+# dataset / build identity
+# ---------------------------------------------------------------------------
+def load_dataset(name: str) -> np.ndarray:
+    """(N, 2) float32 in [0, 1] from DatasetGenerator (fixed seeds)."""
+    sys.path.insert(0, str(_DATASETS))
+    from benchmark_datasets import DatasetGenerator
+
+    fn = {"circles": "concentric_circles", "gaussian_mix": "gaussian_mixture",
+          "grid": "grid_pattern", "uniform": "uniform_square",
+          "anisotropic": "anisotropic_gaussian", "outliers": "with_outliers",
+          "imbalanced": "imbalanced_clusters", "temporal": "temporal_drift"}.get(name, name)
+    data = np.asarray(getattr(DatasetGenerator, fn)(), dtype=np.float32)
+    if data.ndim != 2 or data.shape[1] != 2:
+        raise ValueError(f"{name}: not a 2D dataset")
+    return data
+
+
+def _git_rev() -> str:
+    try:
+        rev = subprocess.run(["git", "-C", str(_REPO), "describe", "--always", "--dirty"],
+                             capture_output=True, text=True, check=True).stdout.strip()
+    except (OSError, subprocess.CalledProcessError):
+        rev = ""
+    return rev
+
+
+def build_info(label: str, exe: str = None) -> dict:
+    info = {"label": label, "git": _git_rev()}
+    if exe:
+        info["exe"] = str(exe)
+        info["exe_sha256"] = hashlib.sha256(Path(exe).read_bytes()).hexdigest()[:16]
+    return info
+
+
+# ---------------------------------------------------------------------------
+# statistics
+# ---------------------------------------------------------------------------
+def _dist(v) -> dict:
+    v = np.asarray(v, dtype=np.float64)
+    if len(v) == 0:
+        return {}
+    return {"mean": float(v.mean()), "p50": float(np.percentile(v, 50)),
+            "p99": float(np.percentile(v, 99)), "n": int(len(v))}
+
+
+def _awake(prof) -> dict:
+    """Awake share / cycles per step between the first and the last PROF frame."""
+    if len(prof) < 2 or "time" not in prof[0]:
+        return {}
+    # per-frame differences, the 32-bit CLINT words wrap every ~159 s
+    dt = sum((b["time"] - a["time"]) % (1 << 32) for a, b in zip(prof, prof[1:]))
+    di = sum((b["idle"] - a["idle"]) % (1 << 32) for a, b in zip(prof, prof[1:]))
+    steps = prof[-1].get("step", 0) - prof[0].get("step", 0)
+    if dt <= 0:
+        return {}
+    awake = max(dt - di, 0)
+    return {"awake": awake / dt, "awake_cyc_step": awake / steps if steps > 0 else 0.0}
+
+
+def _merge_agg(aggs) -> dict:
+    """CMD_PROF_AGG intervals of a phase -> {field: count / min / max / sum / hist}."""
+    out = {}
+    for a in aggs:
+        m = out.setdefault(a["phase"], {"count": 0, "min": None, "max": 0, "sum": 0, "hist": {}})
+        m["count"] += a["count"]
+        m["sum"] += a["sum"]
+        m["max"] = max(m["max"], a["max"])
+        m["min"] = a["min"] if m["min"] is None else min(m["min"], a["min"])
+        for b, n in a["hist"].items():
+            m["hist"][b] = m["hist"].get(b, 0) + n
+    return out
+
+
+def hist_quantile(hist: dict, q: float, cmax: int) -> int:
+    """Upper bound of the q quantile: top edge of its log2 bucket (<= max)."""
+    total = sum(hist.values())
+    seen = 0
+    for b in sorted(hist):
+        seen += hist[b]
+        if seen >= q * total:
+            return min((1 << (b + 1)) - 1, cmax)
+    return cmax
+
+
+def _agg_stats(merged: dict) -> dict:
+    out = {}
+    for f, m in merged.items():
+        if not m["count"]:
+            continue
+        out[f] = {"n": m["count"], "mean": m["sum"] / m["count"], "min": m["min"], "max": m["max"],
+                  "p50": hist_quantile(m["hist"], 0.50, m["max"]),
+                  "p99": hist_quantile(m["hist"], 0.99, m["max"]),
+                  "p999": hist_quantile(m["hist"], 0.999, m["max"]),
+                  "hist": {str(b): n for b, n in sorted(m["hist"].items())}}
+    return out
+
+
+def _rate(t, count) -> float:
+    """Steps per host second between the first and the last sample."""
+    if len(t) < 2 or t[-1] <= t[0]:
+        return 0.0
+    return float((count[-1] - count[0]) / (t[-1] - t[0]))
+
+
+class _Link:
+    """rx / tx byte counters of one phase."""
+
+    def __init__(self, rd, baud):
+        self.rd, self.baud = rd, baud
+        self.tx = 0
+        self.mark()
+
+    def write(self, data: bytes):
+        self.rd.write(data)
+        self.tx += len(data)
+
+    def mark(self):
+        self.t0, self.rx0, self.tx0 = time.time(), self.rd.bytes_in, self.tx
+
+    def report(self) -> dict:
+        dt = max(time.time() - self.t0, 1e-9)
+        rx, tx = self.rd.bytes_in - self.rx0, self.tx - self.tx0
+        return {"seconds": dt, "rx_bytes": rx, "tx_bytes": tx,
+                "rx_util": rx * 10 / (self.baud * dt), "tx_util": tx * 10 / (self.baud * dt)}
+
+
+# ---------------------------------------------------------------------------
+# runners
+# ---------------------------------------------------------------------------
+class _Feeder:
+    """CMD_STREAM: cycle the dataset, never more samples than credited."""
+
+    def __init__(self, link, wire):
+        self.link, self.wire = link, wire  # (N, 2) int16, sent in this order
+        self.credit = 0
+        self.pos = 0
+
+    def on_frame(self, fr):
+        if fr.cmd == P.CMD_CREDIT:
+            self.credit += P.decode_credit(fr.payload)
+        while self.credit > 0:
+            n = min(63, self.credit, len(self.wire) - self.pos)
+            part = self.wire[self.pos:self.pos + n]
+            self.link.write(P.encode_frame(P.CMD_DATA_BATCH, bytes((n,)) + part.tobytes()))
+            self.credit -= n
+            self.pos = (self.pos + n) % len(self.wire)
+
+
+def drift_stream(data: np.ndarray, k: int, seed: int = 1) -> np.ndarray:
+    """Dataset in three consecutive segments, each resampled to k samples."""
+    rng = np.random.default_rng(seed)
+    return np.concatenate([seg[rng.integers(0, len(seg), k)] for seg in np.array_split(data, 3)])
+
+
+def _drift(prof) -> dict:
+    """Boosts started between the first and the last PROF, latency of each
+    one that ended (the fw sets drift_lat when the QE settles)."""
+    if "drift_events" not in prof[0] or not prof[0].get("qe_slow"):
+        return {}
+    lat = [b["drift_lat"] for a, b in zip(prof, prof[1:]) if b["drift_lat"] != a["drift_lat"]]
+    return {"drift_events": prof[-1]["drift_events"] - prof[0]["drift_events"], "drift_lat": lat}
+
+
+def _run_v3(rd, link, data, args) -> dict:
+    feeder = None
+    link.write(P.encode_snap_mode(P.SNAP_TRIG_EVERY, every=args.every))
+    if args.feed == "stream":
+        if args.drift_samples:
+            data = drift_stream(data, args.drift_samples)
+        feeder = _Feeder(link, np.round(data.astype(np.float64) * 1000.0).astype("<i2"))
+        link.write(P.encode_frame(P.CMD_STREAM))
+    elif args.feed == "gen":
+        link.write(P.encode_gen(P.GEN_DATASETS[args.dataset], args.gen_seed))
+    else:
+        for fr in P.encode_data_batch(data):
+            link.write(fr)
+        link.write(P.encode_frame(P.CMD_DONE))   # auto-runs
+    if args.converge:
+        link.write(P.encode_converge(P.CONV_NOTIFY))
+    t_start, conv = time.time(), None
+
+    stream = (P.encode_snap_mode(P.SNAP_TRIG_AUTO, every=args.every, io_pct=args.snap_io)
+              if args.snap_io else P.encode_snap_mode(P.SNAP_TRIG_EVERY, every=args.every))
+    modes = [("stream", stream),
+             ("quiet", P.encode_snap_mode(P.SNAP_TRIG_TIME, ms=args.quiet_ms))]
+    phases, isa = {}, {}
+    for name, cmd in modes:
+        link.write(cmd)
+        t_switch = time.time()
+        link.mark()
+        prof_t, prof, aggs, stats = [], [], [], None
+        stats_asked = False
+        while time.time() - t_switch < args.seconds + (0.5 if stats_asked else 0.0):
+            if not stats_asked and time.time() - t_switch >= args.seconds:
+                link.write(P.encode_stats())   # the snapshot interval the phase ended with
+                stats_asked = True
+            for fr in rd.drain():
+                if feeder:
+                    feeder.on_frame(fr)
+                if fr.cmd == P.CMD_STATS_FRAME:
+                    stats = P.decode_stats(fr.payload)
+                if fr.cmd == P.CMD_CONVERGED and conv is None:
+                    conv = P.decode_converged(fr.payload)
+                    conv["s"] = time.time() - t_start
+                if fr.cmd not in (P.CMD_PROF, P.CMD_PROF_AGG):
+                    continue
+                now = time.time()
+                if now - t_switch < SETTLE_S:
+                    continue
+                if fr.cmd == P.CMD_PROF_AGG:
+                    aggs.append(P.decode_prof_agg(fr.payload))
+                    continue
+                prof_t.append(now)
+                prof.append(P.decode_prof(fr.payload))
+            time.sleep(0.01)
+        ph = {"link": link.report(), "prof_frames": len(prof)}
+        if name == "stream" and stats and "snap_every" in stats:
+            ph["snap_every"], ph["snap_io"] = stats["snap_every"], stats["snap_io"]
+        if aggs:
+            ph["agg"] = _agg_stats(_merge_agg(aggs))
+        if prof:
+            ph["steps_s"] = _rate(prof_t, [p.get("step", 0) for p in prof])
+            ph["cycles"] = {f: _dist([p[f] for p in prof]) for f in CYC_FIELDS if f in prof[0]}
+            if "cyc_total" in ph["cycles"]:
+                ph["cpu_steps_s"] = CPU_HZ / max(ph["cycles"]["cyc_total"]["mean"], 1.0)
+            for f in ("tx_stall", "smp_dropped"):
+                if f in prof[0]:
+                    ph[f] = int(sum(p[f] for p in prof))
+            ph.update(_awake(prof))
+            ph.update(_drift(prof))
+            if args.active_mw and ph.get("awake_cyc_step"):
+                ph["uj_step"] = args.active_mw * ph["awake_cyc_step"] / CPU_HZ * 1e3
+            isa = {f: prof[-1][f] for f in ("misa", "mxisa", "cache") if f in prof[-1]}
+        phases[name] = ph
+    link.write(P.encode_snap_mode(P.SNAP_TRIG_EVERY, every=args.every))
+    if args.converge:
+        link.write(P.encode_converge(P.CONV_OFF))
+    rec = {"phases": phases, "isa": isa}
+    if conv:
+        rec["converge"] = conv
+    return rec
+
+
+def _run_v2(rd, link, data, args) -> dict:
+    # gng.vhd takes the samples as one raw int16 blob (V2_dataset.pde)
+    link.write(np.round(data.astype(np.float64) * 1000.0).astype("<i2").tobytes())
+    time.sleep(0.05)
+    rd.drain()                       # snapshots of the old run
+    link.mark()
+    t_end = time.time() + args.seconds
+    ts = []
+    while time.time() < t_end:
+        for fr in rd.drain():
+            if fr.cmd == P.A5_DBG:
+                ts.append(P.decode_a5_dbg(fr.payload)["ts"])
+        time.sleep(0.01)
+    ph = {"link": link.report(), "dbg_frames": len(ts)}
+    if len(ts) >= 2:
+        dts = np.diff(np.asarray(ts, dtype=np.int64)) % (1 << 32)
+        ph["cycles"] = {"cyc_total": _dist(dts / args.dbg_every)}
+        # ts runs on the FPGA clock: dropped DBG records (DBG_RING) do not skew it
+        ph["steps_s"] = CPU_HZ * args.dbg_every / max(float(dts.mean()), 1.0)
+    return {"phases": {"stream": ph}}
+
+
+def _run_v2_sw(rd, link, data, args) -> dict:
+    for fr in P.encode_data_batch(data):
+        link.write(fr)
+    link.write(P.encode_frame(P.CMD_DONE))   # auto-runs
+    time.sleep(SETTLE_S)
+    rd.drain()
+    link.mark()
+    t_end = time.time() + args.seconds
+    host_t = []
+    while time.time() < t_end:
+        host_t += [time.time() for fr in rd.drain() if fr.cmd == P.CMD_GNG_NODES]
+        time.sleep(0.01)
+    ph = {"link": link.report(), "snapshots": len(host_t)}
+    ph["steps_s"] = _rate(host_t, [k * args.every for k in range(len(host_t))])
+    return {"phases": {"stream": ph}}
+
+
+RUNNERS = {"v3": _run_v3, "v2": _run_v2, "v2-sw": _run_v2_sw}
+
+
+# ---------------------------------------------------------------------------
+# history
+# ---------------------------------------------------------------------------
+def load_history(path) -> list:
+    path = Path(path)
+    if not path.exists():
+        return []
+    with open(path) as f:
+        return json.load(f)
+
+
+def save_history(path, history: list):
+    path = Path(path)
+    tmp = path.with_suffix(".tmp")
+    with open(tmp, "w") as f:
+        json.dump(history, f, indent=1)
+    tmp.replace(path)
+
+
+def _same_setup(a: dict, b: dict) -> bool:
+    return all(a.get(k) == b.get(k) for k in ("board", "dataset", "feed", "baud"))
+
+
+def compare(prev: dict, cur: dict, tolerance: float) -> list:
+    """Regressions of cur against prev as text lines."""
+    out = []
+    for name, ph in cur["phases"].items():
+        old = prev["phases"].get(name)
+        if not old:
+            continue
+        a, b = old.get("steps_s", 0.0), ph.get("steps_s", 0.0)
+        if a > 0 and b < a * (1.0 - tolerance):
+            out.append(f"{name}: steps/s {a:.0f} -> {b:.0f} ({100 * (b / a - 1):+.1f}%)")
+        a = old.get("cycles", {}).get("cyc_total", {}).get("p50", 0.0)
+        b = ph.get("cycles", {}).get("cyc_total", {}).get("p50", 0.0)
+        if a > 0 and b > a * (1.0 + tolerance):
+            out.append(f"{name}: cyc_total p50 {a:.0f} -> {b:.0f} ({100 * (b / a - 1):+.1f}%)")
+    return out
+
+
+def cycle_deltas(prev: dict, cur: dict) -> list:
+    """p50 change of every PROF phase, one line per run phase (tuning profiles)."""
+    out = []
+    for name, ph in cur["phases"].items():
+        old = prev["phases"].get(name, {}).get("cycles", {})
+        cells = []
+        for f, d in ph.get("cycles", {}).items():
+            a = old.get(f, {}).get("p50", 0.0)
+            if d and a > 0:
+                cells.append(f"{f} {d['p50'] - a:+.0f}")
+        if cells:
+            out.append(f"{name}: " + ", ".join(cells))
+    return out
+
+
+def cache_str(word: int) -> str:
+    """SYSINFO cache word of PROF 'cache' -> "i$ 64 x 32 B" / "no i$"."""
+    if word & 0xFF == 0:
+        return "no i$"
+    return f"i$ {1 << ((word >> 4) & 0xF)} x {1 << (word & 0xF)} B"
+
+
+def _hist_bars(hist: dict, width: int = 40) -> list:
+    top = max(hist.values())
+    return [f"          >= {1 << int(b):8d} {n:8d} " + "#" * max(1, round(width * n / top))
+            for b, n in hist.items()]
+
+
+def print_report(rec: dict, bars: bool = False):
+    b = rec["build"]
+    print(f"# {rec['board']} {b.get('label', '')} git={b.get('git', '')} "
+          f"{b.get('exe_sha256', '')}  {rec['dataset']} ({rec['samples']} samples) "
+          f"feed={rec['feed']} baud={rec['baud']}"
+          + (f" {cache_str(rec['isa']['cache'])}" if "cache" in rec.get("isa", {}) else ""))
+    if "converge" in rec:
+        c = rec["converge"]
+        print(f"converged at step {c['step']} (quiet since {c['since']}) after {c['s']:.1f} s"
+              f"  qe {c['qe']:.3g}")
+    for name, ph in rec["phases"].items():
+        ln = ph["link"]
+        line = f"{name:7s} {ph.get('steps_s', 0.0):10.0f} steps/s"
+        if "cpu_steps_s" in ph:
+            line += f"  (compute only {ph['cpu_steps_s']:.0f})"
+        print(line + f"  link rx {100 * ln['rx_util']:.1f}% tx {100 * ln['tx_util']:.1f}%")
+        if "snap_every" in ph:
+            print(f"        snapshot every {ph['snap_every']} steps, "
+                  f"{ph['snap_io'] / 10:.1f}% of the cycles in the last one")
+        if "awake" in ph:
+            line = f"        awake {100 * ph['awake']:.1f}%  {ph['awake_cyc_step']:.0f} cycles/step"
+            if "uj_step" in ph:
+                line += f"  {ph['uj_step']:.3f} uJ/step"
+            print(line)
+        if "drift_events" in ph:
+            lat = ph["drift_lat"]
+            print(f"        drift {ph['drift_events']} boosts  latency "
+                  + (" ".join(str(v) for v in lat) + " steps" if lat else "-"))
+        for f, d in ph.get("cycles", {}).items():
+            if d:
+                print(f"        {f:12s} mean {d['mean']:9.1f}  p50 {d['p50']:9.1f}  p99 {d['p99']:9.1f}")
+        for f, d in ph.get("agg", {}).items():
+            print(f"        all {f:12s} n {d['n']:8d}  mean {d['mean']:9.1f}  p50<= {d['p50']:8d}"
+                  f"  p99<= {d['p99']:8d}  p99.9<= {d['p999']:8d}  max {d['max']:8d}")
+            if bars:
+                for ln in _hist_bars(d["hist"]):
+                    print(ln)
+
+
+# ---------------------------------------------------------------------------
+# entry point (python -m gngio bench)
+# ---------------------------------------------------------------------------
+def add_arguments(ap):
+    ap.add_argument("port")
+    ap.add_argument("--board", choices=sorted(BOARDS), default="v3")
+    ap.add_argument("--exe", help="neorv32_exe.bin to flash first (reset the board before)")
+    ap.add_argument("--fast-baud", type=int, default=FAST_BAUD,
+                    help="block upload rate for --exe, 0 = classic 'z' + 'u' upload")
+    ap.add_argument("--build", default="", help="label of this build in the history")
+    ap.add_argument("--dataset", default="two_moons", help="DatasetGenerator 2D set")
+    ap.add_argument("--baud", type=int, default=APP_BAUD, help="V3: CMD_SET_BAUD to this rate")
+    ap.add_argument("--feed", choices=("upload", "stream", "gen"), default="upload",
+                    help="V3: DATA_BATCH + DONE, CMD_STREAM or CMD_GEN (on-board generator)")
+    ap.add_argument("--gen-seed", type=int, default=0,
+                    help="v3 --feed gen: generator seed, 0 = from the board's TRNG")
+    ap.add_argument("--seconds", type=float, default=10.0, help="per phase")
+    ap.add_argument("--drift-samples", type=int, default=0, metavar="K",
+                    help="v3 --feed stream: three dataset segments of K samples each (drift)")
+    ap.add_argument("--converge", action="store_true",
+                    help="v3: CMD_CONVERGE notify, report the steps to converge")
+    ap.add_argument("--every", type=int, default=100,
+                    help="snapshot period in steps (v3: CMD_SNAP_MODE; v2-sw: STREAM_EVERY_N = 5)")
+    ap.add_argument("--snap-io", type=int, default=0, metavar="PCT",
+                    help="v3: SNAP_TRIG_AUTO, the board picks the period so snapshots take PCT %% of the cycles")
+    ap.add_argument("--quiet-ms", type=int, default=1000, help="v3 quiet phase snapshot period")
+    ap.add_argument("--dbg-every", type=int, default=1, help="v2: DBG_EVERY of the bitstream")
+    ap.add_argument("--active-mw", type=float, default=0.0,
+                    help="v3: awake core power (board measurement or gng.power.html) for uJ/step")
+    ap.add_argument("--hist", action="store_true",
+                    help="v3: draw the CMD_PROF_AGG cycle histograms of every phase")
+    ap.add_argument("--history", default="bench_history.json")
+    ap.add_argument("--tolerance", type=float, default=0.05)
+    ap.add_argument("--strict", action="store_true", help="exit 2 on a regression")
+
+
+def run(args) -> int:
+    import serial
+
+    board = BOARDS[args.board]
+    if args.board == "v2-sw" and args.every == 100:
+        args.every = 5
+    data = load_dataset(args.dataset)[:board["max_pts"]]
+    if args.feed == "gen" and (args.board != "v3" or args.dataset not in P.GEN_DATASETS):
+        print(f"--feed gen: v3 with --dataset {' / '.join(P.GEN_DATASETS)}")
+        return 1
+
+    if args.exe:
+        flash(args.port, args.exe, fast_baud=args.fast_baud)
+    ser = serial.Serial(args.port, APP_BAUD, timeout=0.05)
+    if args.exe:
+        wait_banner(ser)
+    baud = APP_BAUD
+    if args.board == "v3" and args.baud != APP_BAUD:
+        baud = set_baud(ser, args.baud) or APP_BAUD
+    rd = SerialReader(args.port, baud, board["kind"], ser=ser)
+    rd.start()
+    try:
+        res = RUNNERS[args.board](rd, _Link(rd, baud), data, args)
+    finally:
+        rd.stop()
+
+    rec = {"time": time.strftime("%Y-%m-%dT%H:%M:%S"), "host": platform.node(),
+           "board": args.board, "build": build_info(args.build, args.exe),
+           "dataset": args.dataset, "samples": int(len(data)), "feed": args.feed,
+           "baud": baud, **res}
+    print_report(rec, args.hist)
+
+    history = load_history(args.history)
+    prev = next((h for h in reversed(history) if _same_setup(h, rec)), None)
+    regress = compare(prev, rec, args.tolerance) if prev else []
+    if prev:
+        print(f"# vs {prev['time']} {prev['build'].get('label', '')} {prev['build'].get('git', '')}: "
+              + ("; ".join(regress) if regress else "no regression"))
+        for ln in cycle_deltas(prev, rec):
+            print(f"#   p50 cycles {ln}")
+    rec["regressions"] = regress
+    history.append(rec)
+    save_history(args.history, history)
+    return 2 if regress and args.strict else 0
@@ -0,0 +1,149 @@
+"""
+Block upload to the V3 NEORV32 bootloader ('f', bootloader/hal/source/uflash.c)
+==============================================================================
+
+The classic 'z' + 'u' upload erases all 38 user flash pages and streams the
+whole image at 256000 baud. 'f' instead:
+
+1. switches both sides to a negotiated rate (the bootloader answers with
+   the rate its divider really makes), synced with 0x55 -> 'A'
+2. returns a CRC-32 of every 2 KB image page already in flash; only the
+   pages that differ from the new image are sent
+3. takes each page as one block [page u8][len u16][data][CRC-32]; a block
+   whose CRC fails is answered 'N' before the flash is touched and sent
+   again alone
+4. checks the CRC of the whole image and seals it ('E'), then boots ('G')
+
+    with serial.Serial(port, 256000, timeout=0.1) as ser:
+        ...                             # "CMD:>" prompt reached
+        sent, total = fast_upload(ser, Path("neorv32_exe.bin").read_bytes())
+"""
+
+import struct
+import time
+import zlib
+
+PAGE = 2048
+FAST_BAUD = 2_250_000     # 27 MHz / (2 * 6), exact
+BIN_SIGNATURE = 0xB007C0DE
+RETRIES = 4
+
+ACK, NAK, BAD, DESC = b"A", b"N", b"X", b"D"
+
+
+def _read(ser, n: int, timeout: float) -> bytes:
+    data = b""
+    t_end = time.time() + timeout
+    while len(data) < n and time.time() < t_end:
+        data += ser.read(n - len(data))
+    if len(data) < n:
+        raise RuntimeError("bootloader: block upload timed out")
+    return data
+
+
+def _answer(ser, timeout: float = 2.0):
+    """(answer byte, text before it); the seal line of 'E' may come first."""
+    text = b""
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        b = ser.read(1)
+        if not b:
+            continue
+        if b in (ACK, NAK, BAD, DESC) and (not text or text.endswith(b"\n")):
+            return b, text.decode(errors="ignore")
+        text += b
+    raise RuntimeError("bootloader: no block upload answer")
+
+
+def _negotiate(ser, baud: int) -> int:
+    ser.reset_input_buffer()
+    ser.write(b"f")
+    ser.write(struct.pack("<I", baud))
+    t_end = time.time() + 1.0
+    while ser.read(1) != b"B":         # after the console echo "f\r\n"
+        if time.time() > t_end:
+            raise RuntimeError("bootloader: no 'f' block upload (old bootloader?)")
+    actual = struct.unpack("<I", _read(ser, 4, 1.0))[0]
+    time.sleep(0.005)
+    ser.baudrate = actual
+    for _ in range(40):
+        ser.write(b"\x55")
+        if ser.read(1) == ACK:
+            time.sleep(0.05)
+            ser.reset_input_buffer()   # answers of the extra syncs
+            return actual
+    raise RuntimeError(f"bootloader: no sync at {actual} baud")
+
+
+def _send_page(ser, data: bytes, page: int):
+    blk = data[page * PAGE:(page + 1) * PAGE]
+    msg = b"P" + struct.pack("<BH", page, len(blk)) + blk + struct.pack("<I", zlib.crc32(blk))
+    for _ in range(RETRIES):
+        ser.write(msg)
+        a, _ = _answer(ser)
+        if a == ACK:
+            return
+        if a == BAD:
+            raise RuntimeError(f"bootloader: page {page} out of range "
+                               "(image larger than UFLASH_IMG_KB?)")
+    raise RuntimeError(f"bootloader: page {page} failed {RETRIES} times")
+
+
+def fast_upload(ser, exe: bytes, baud: int = FAST_BAUD, boot: bool = True, log=None):
+    """Upload a neorv32_exe.bin at the console prompt; returns (pages sent, pages).
+
+    The port is left at the negotiated rate; boot=False quits to the console
+    (at the bootloader's own rate again) instead of starting the image.
+    """
+    sig, size, _ = struct.unpack("<III", exe[:12])
+    if sig != BIN_SIGNATURE:
+        raise ValueError("not a NEORV32 executable (signature)")
+    data = exe[12:12 + size]
+    n = (size + PAGE - 1) // PAGE
+    log = log or (lambda s: None)
+
+    boot_baud = ser.baudrate
+    log(f"block upload at {_negotiate(ser, baud)} baud")
+
+    ser.write(b"H" + struct.pack("<I", size))
+    if _read(ser, 1, 2.0) != b"H":
+        raise RuntimeError("bootloader: page hashes refused (image too large?)")
+    remote = struct.unpack(f"<{n}I", _read(ser, 4 * n, 5.0))
+    dirty = [p for p in range(n) if zlib.crc32(data[p * PAGE:(p + 1) * PAGE]) != remote[p]]
+    log(f"{len(dirty)} of {n} pages changed")
+
+    sent = set()
+    for p in dirty:
+        _send_page(ser, data, p)
+        sent.add(p)
+
+    end = b"E" + struct.pack("<II", size, zlib.crc32(data))
+    for _ in range(3):
+        ser.write(end)
+        a, text = _answer(ser, 10.0)
+        if text.strip():
+            log(text.strip())
+        if a == ACK:
+            break
+        if a == DESC:                  # descriptor shares a page with the image
+            p = _read(ser, 1, 1.0)[0]
+            _send_page(ser, data, p)
+            sent.add(p)
+        elif a == NAK:                 # a skipped page was not what its hash said
+            for p in range(n):
+                _send_page(ser, data, p)
+                sent.add(p)
+        else:
+            raise RuntimeError("bootloader: image size refused")
+    else:
+        raise RuntimeError("bootloader: image CRC check failed")
+
+    if boot:
+        ser.write(b"G")
+        ser.flush()
+    else:
+        ser.write(b"Q")
+        _answer(ser)
+        time.sleep(0.005)
+        ser.baudrate = boot_baud
+    return len(sent), n
@@ -0,0 +1,134 @@
+"""
+Pretrained network -> C header of the inference image
+=====================================================
+
+`python -m gngio export <in> <out.h>` writes the gng_model.h that
+gng_neorv32_accelerator_V3/fw_infer bakes into its image:
+
+- GNG_MODEL_NODES packed Q1.15 words x | y << 16 (the CFS node window
+  word, 1.0 = 32768 clamped to 0x7FFF; the network must be in [0, 1])
+- gng_model_label[]: lowest node index of the node's component, the
+  V3 CMD_GNG_COMPONENTS label
+- GNG_MODEL_EDGES pairs of node indices
+
+Nodes are numbered 0.. in id order, so s1 of a CMD_QUERY_ACK is the index
+into the arrays (the keyframe the image sends at boot uses the same).
+
+Inputs:
+- .npz with xy (N, 2) and edges (E, 2) index pairs, optionally ids (the
+  pairs are then ids): gngio shard --out, or GNGLite via
+  np.savez(f, xy=g.get_weights_as_float(), edges=g.get_edges_as_list())
+- .gnglog: the last complete keyframe of a recording (gngio record)
+
+    python -m gngio export run.gnglog gng_model.h
+    python -m gngio export merged.npz ../gng_neorv32_accelerator_V3/fw_infer/gng_model.h
+"""
+
+import numpy as np
+
+MAX_NODES = 255  # 8-bit s1 in CMD_QUERY_ACK
+MAX_EDGES = 126  # one CMD_GNG_EDGES frame (boot keyframe)
+
+
+def component_labels(n: int, edges) -> list:
+    """Lowest node index of each node's connected component."""
+    root = list(range(n))
+
+    def find(i):
+        while root[i] != i:
+            root[i] = root[root[i]]
+            i = root[i]
+        return i
+
+    for a, b in edges:
+        ra, rb = find(int(a)), find(int(b))
+        if ra != rb:
+            root[max(ra, rb)] = min(ra, rb)
+    return [find(i) for i in range(n)]
+
+
+def dense(ids, xy, edges):
+    """(ids, xy, id pairs) -> (xy in id order, unique index pairs a < b)."""
+    order = sorted(range(len(ids)), key=lambda k: int(ids[k]))
+    index = {int(ids[k]): i for i, k in enumerate(order)}
+    pairs = sorted({(min(index[int(a)], index[int(b)]), max(index[int(a)], index[int(b)]))
+                    for a, b in edges
+                    if int(a) in index and int(b) in index and int(a) != int(b)})
+    return [tuple(map(float, xy[k][:2])) for k in order], pairs
+
+
+def q15(v: float) -> int:
+    return min(max(int(round(v * 32768.0)), 0), 0x7FFF)
+
+
+def c_header(xy, edges, source: str = "") -> str:
+    """Nodes (N, 2) in [0, 1] and index pairs -> gng_model.h text."""
+    n = len(xy)
+    if not 2 <= n <= MAX_NODES:
+        raise ValueError(f"{n} nodes: the inference image takes 2 .. {MAX_NODES}")
+    if len(edges) > MAX_EDGES:
+        raise ValueError(f"{len(edges)} edges: the inference image takes up to {MAX_EDGES}")
+    label = component_labels(n, edges)
+    words = [q15(x) | (q15(y) << 16) for x, y in xy]
+    lines = [
+        "// gng_model.h - pretrained GNG network for fw_infer (python -m gngio export)",
+        f"// {n} nodes, {len(edges)} edges, {len(set(label))} component"
+        + ("s" if len(set(label)) != 1 else "")
+        + (f", from {source}" if source else ""),
+        "",
+        "#ifndef GNG_MODEL_H",
+        "#define GNG_MODEL_H",
+        "",
+        "#include <stdint.h>",
+        "",
+        f"#define GNG_MODEL_NODES {n}",
+        f"#define GNG_MODEL_EDGES {len(edges)}",
+        "",
+        "// Q1.15 x | y << 16",
+        "static const uint32_t gng_model_node[GNG_MODEL_NODES] = {",
+    ]
+    lines += ["  " + ", ".join(f"0x{w:08X}u" for w in words[k:k + 6]) + ","
+              for k in range(0, n, 6)]
+    lines += ["};", "", "// lowest node index of the component",
+              "static const uint8_t gng_model_label[GNG_MODEL_NODES] = {"]
+    lines += ["  " + ", ".join(f"{v:3d}" for v in label[k:k + 16]) + ","
+              for k in range(0, n, 16)]
+    lines += ["};", ""]
+    # an empty array is not C: one dummy pair, GNG_MODEL_EDGES stays 0
+    rows = edges if edges else [(0, 0)]
+    lines += ["static const uint8_t gng_model_edge[GNG_MODEL_EDGES ? GNG_MODEL_EDGES : 1][2] = {"]
+    lines += ["  " + " ".join(f"{{{a:3d}, {b:3d}}}," for a, b in rows[k:k + 8])
+              for k in range(0, len(rows), 8)]
+    lines += ["};", "", "#endif // GNG_MODEL_H", ""]
+    return "\n".join(lines)
+
+
+def load(path: str):
+    """.npz or .gnglog -> (xy in id order, index pairs)."""
+    if path.endswith(".npz"):
+        z = np.load(path)
+        xy, edges = z["xy"], z["edges"].reshape(-1, 2)
+        ids = z["ids"] if "ids" in z else np.arange(len(xy))
+        return dense(ids, xy, edges)
+    from .recorder import read_log, replay
+    from .suite import _Snapshot
+    snap = _Snapshot(read_log(path)[0]["kind"])
+    for _, fr in replay(path):
+        snap.on_frame(fr)
+    if snap.last is None:
+        raise ValueError(f"{path}: no complete keyframe")
+    return dense(*snap.last)
+
+
+def main(args) -> int:
+    xy, edges = load(args.input)
+    text = c_header(xy, edges, args.input)
+    with open(args.output, "w") as f:
+        f.write(text)
+    print(f"{args.output}: {len(xy)} nodes, {len(edges)} edges")
+    return 0
+
+
+def add_arguments(ap):
+    ap.add_argument("input", help=".npz (xy, edges[, ids]) or .gnglog recording")
+    ap.add_argument("output", help="C header for fw_infer (make MODEL=...)")
@@ -0,0 +1,135 @@
+"""
+UART frame parser stress test (V3 firmware CMD_LINK)
+====================================================
+
+Sends a burst of pad frames (CMD_LINK LINK_OP_PAD, ignored by the
+firmware, no answer) and damages some of them on the way out, then
+reads the link counters (CMD_LINK_ACK) to see what the parser made of
+it:
+
+- drop:  one byte of the frame left out
+- flip:  one byte XORed with a random non-zero value
+- noise: 1..8 random bytes inserted into the frame
+
+A damaged frame is lost by design. What the framing decides is how many
+clean frames go with it before the parser is back in step: with FF FF
+framing a lost byte makes the parser take the rest of the frame and
+whatever follows as payload and look for the next FF FF, which may sit
+inside a payload (0xFF is a valid data byte). With COBS framing (-c
+cobs) every 00 restarts the parser, so each hit should cost no more than
+the frame it hit. The report gives per framing
+
+- ingest: clean frames / s and bytes / s from the first byte sent until
+  the ACK came back (the ACK is queued behind everything sent)
+- recovery: clean frames lost per hit, and the bytes dropped between
+  frames per hit (rx_skip)
+
+    python -m gngio linktest COM5 --frames 5000 --hit 0.01
+    python -m gngio linktest /dev/pts/7 -c ff --len 200 --kinds drop
+
+A 256 byte run of 00 after the burst brings a parser stuck inside a cut
+frame back (and is counted in rx_skip of the FF FF run, which the report
+takes off again). The firmware is left in FF FF framing. A frame the
+parser mis-reads passes its checksum 1 time in 256 and runs as a
+command, so point it at a board that has nothing to lose (fwhost).
+"""
+
+import random
+import time
+
+from . import protocol as P
+
+KINDS = ("drop", "flip", "noise")
+FLUSH = 256
+
+
+def pad_frames(n: int, length: int, rng) -> list:
+    """n CMD_LINK LINK_OP_PAD frames, payload = op + random filler bytes."""
+    length = max(1, min(length, 255))
+    return [P.encode_frame(P.CMD_LINK, bytes((P.LINK_OP_PAD,))
+                           + bytes(rng.getrandbits(8) for _ in range(length - 1)))
+            for _ in range(n)]
+
+
+def damage(raw: bytes, kind: str, rng) -> bytes:
+    """One hit of `kind` somewhere in the wire bytes of one frame."""
+    i = rng.randrange(len(raw))
+    if kind == "drop":
+        return raw[:i] + raw[i + 1:]
+    if kind == "flip":
+        return raw[:i] + bytes((raw[i] ^ rng.randrange(1, 256),)) + raw[i + 1:]
+    return raw[:i] + bytes(rng.getrandbits(8) for _ in range(rng.randint(1, 8))) + raw[i:]
+
+
+def run(ser, cobs: bool, frames: list, hit: float, kinds, rng, baud: int) -> dict:
+    """One burst in one framing; returns the counters plus the test figures.
+    Raises RuntimeError when the firmware does not answer CMD_LINK."""
+    from .reader import link
+    if cobs and link(ser, P.LINK_OP_COBS) is None:
+        raise RuntimeError("no CMD_LINK_ACK (firmware without CMD_LINK?)")
+    if link(ser, P.LINK_OP_STATS, clear=True, cobs=cobs) is None:
+        raise RuntimeError("no CMD_LINK_ACK (firmware without CMD_LINK?)")
+
+    wire = bytearray()
+    hits = 0
+    for fr in frames:
+        raw = P.to_cobs(fr) if cobs else fr
+        if rng.random() < hit:
+            raw = damage(raw, rng.choice(kinds), rng)
+            hits += 1
+        wire += raw
+    wire += bytes(FLUSH)
+
+    t0 = time.time()
+    ser.write(wire)
+    d = link(ser, P.LINK_OP_LEGACY if cobs else P.LINK_OP_STATS, cobs=cobs,
+             timeout=2.0 + 20.0 * len(wire) / baud)
+    dt = time.time() - t0
+    if d is None:
+        raise RuntimeError("no CMD_LINK_ACK after the burst (link gone?)")
+
+    good = d["rx_ok"] - 1  # the stats / legacy frame itself
+    lost = len(frames) - good
+    skip = d["rx_skip"] - (0 if cobs else FLUSH)
+    d.update(frames=len(frames), hits=hits, good=good, lost=lost, seconds=dt,
+             bytes=len(wire), fps=good / max(dt, 1e-9), bps=len(wire) / max(dt, 1e-9),
+             collateral=(lost - hits) / hits if hits else 0.0,
+             skip_per_hit=skip / hits if hits else 0.0)
+    return d
+
+
+def format_line(name: str, d: dict) -> str:
+    return (f"{name:5s} {d['good']}/{d['frames']} frames in {d['seconds']:.3f} s "
+            f"({d['fps']:.0f} frames/s, {d['bps']:.0f} B/s), {d['hits']} hits, "
+            f"lost {d['lost']} ({d['collateral']:+.2f} clean frames / hit, "
+            f"{d['skip_per_hit']:.1f} bytes skipped / hit), rx_bad={d['rx_bad']}")
+
+
+def main(args) -> int:
+    import serial
+    kinds = tuple(k for k in args.kinds.split(",") if k)
+    bad = [k for k in kinds if k not in KINDS]
+    if bad or not kinds:
+        raise SystemExit(f"--kinds: one or more of {','.join(KINDS)}")
+    rng = random.Random(args.seed)
+    frames = pad_frames(args.frames, args.len, rng)
+    runs = {"ff": (False,), "cobs": (True,), "both": (False, True)}[args.framing]
+    with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+        for cobs in runs:
+            try:
+                d = run(ser, cobs, frames, args.hit, kinds, random.Random(args.seed), args.baud)
+            except RuntimeError as e:
+                raise SystemExit(str(e))
+            print(format_line("cobs" if cobs else "ff", d))
+    return 0
+
+
+def add_arguments(ap):
+    ap.add_argument("port")
+    ap.add_argument("-c", "--framing", choices=("ff", "cobs", "both"), default="both")
+    ap.add_argument("--frames", type=int, default=2000, help="pad frames per run")
+    ap.add_argument("--len", type=int, default=64, help="payload bytes per frame (1..255)")
+    ap.add_argument("--hit", type=float, default=0.01, help="share of frames damaged")
+    ap.add_argument("--kinds", default="drop,flip,noise", help=f"damage kinds ({','.join(KINDS)})")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--baud", type=int, default=1_000_000)
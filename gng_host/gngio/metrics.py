@@ -0,0 +1,198 @@
+"""
+QE / TE kernel shared by the metrics scripts
+============================================
+
+QE = mean distance from each sample to its nearest node (s1), TE = fraction
+of samples whose s1 and second-nearest node (s2) share no edge.
+
+- distances: one (chunk x M) squared-distance block per CHUNK samples, so
+  memory stays bounded for long datasets
+- s1 / s2: two argmin passes over the block (the second with s1 masked)
+  instead of a full argsort; argmin keeps the first column, so both are
+  ordered by (distance, index) like the firmware's index-order scan, also
+  with three or more equal distances (1/1000 quantized CSV snapshots)
+- adjacency: edges become a boolean (M x M) matrix, TE is one fancy-index
+  lookup adj[s1, s2]
+
+SnapshotScorer re-scores a series of snapshots incrementally. It keeps the
+(N x ids) distance matrix and each sample's s1 / s2, and a new snapshot only
+recomputes the columns of nodes that moved, appeared or vanished:
+
+- samples whose s1 or s2 is one of those nodes rescan their whole row
+- every other sample merges its old (s1, s2) with the best two of the
+  changed columns
+
+    sc = SnapshotScorer(samples)                     # (N, 2)
+    for ids, xy, edges in snapshots:                 # node ids, (M, 2), (K, 2) id pairs
+        qe, te = sc.update(ids, xy, edges)
+"""
+
+import numpy as np
+
+CHUNK = 4096  # samples per distance block
+
+
+def _top2(d, cols):
+    """Best two columns of each row of d -> (i1, i2, d1, d2), i = cols[...]
+    (ascending), ties -> lower index; i2 = -1 / d2 = inf when d has a single
+    column. d is masked in place and restored."""
+    n, m = d.shape
+    if m == 0:
+        return (np.full(n, -1), np.full(n, -1),
+                np.full(n, np.inf), np.full(n, np.inf))
+    if m == 1:
+        return (np.full(n, cols[0]), np.full(n, -1),
+                d[:, 0].copy(), np.full(n, np.inf))
+    # cols ascend, so the lowest column of a tie is the lowest index
+    r = np.arange(n)
+    c1 = d.argmin(axis=1)
+    d1 = d[r, c1]
+    d[r, c1] = np.inf
+    c2 = d.argmin(axis=1)
+    d2 = d[r, c2]
+    d[r, c1] = d1
+    cols = np.asarray(cols)
+    return cols[c1], cols[c2], d1, d2
+
+
+def _merge2(a, b):
+    """Best two of two disjoint (i1, i2, d1, d2) candidate sets, ties -> lower
+    index (-1 only comes with d = inf and sorts last)."""
+    i = np.stack((a[0], a[1], b[0], b[1]), axis=1)
+    d = np.stack((a[2], a[3], b[2], b[3]), axis=1)
+    key = np.lexsort((np.where(i < 0, np.iinfo(np.intp).max, i), d), axis=1)
+    rows = np.arange(len(i))[:, None]
+    i = i[rows, key]
+    d = d[rows, key]
+    return i[:, 0], i[:, 1], d[:, 0], d[:, 1]
+
+
+def sqdist(samples, xy):
+    """(N, M) squared distances."""
+    diff = np.asarray(samples, dtype=np.float64)[:, None, :] - np.asarray(xy, dtype=np.float64)[None, :, :]
+    return np.einsum("nmk,nmk->nm", diff, diff)
+
+
+def winners(samples, xy, chunk=CHUNK):
+    """s1, s2 (row indices into xy, s2 = -1 with one node) and d1 (squared)."""
+    samples = np.asarray(samples, dtype=np.float64)
+    xy = np.asarray(xy, dtype=np.float64)
+    n = len(samples)
+    s1 = np.empty(n, dtype=np.intp)
+    s2 = np.empty(n, dtype=np.intp)
+    d1 = np.empty(n)
+    cols = np.arange(len(xy))
+    for lo in range(0, n, chunk):
+        hi = min(lo + chunk, n)
+        s1[lo:hi], s2[lo:hi], d1[lo:hi], _ = _top2(sqdist(samples[lo:hi], xy), cols)
+    return s1, s2, d1
+
+
+def adjacency(edges, ids):
+    """Boolean (M x M) matrix over the rows of ids; edges hold node ids,
+    pairs with an id outside ids are ignored."""
+    ids = np.asarray(ids, dtype=np.intp)
+    m = len(ids)
+    adj = np.zeros((m, m), dtype=bool)
+    edges = np.asarray(edges, dtype=np.intp).reshape(-1, 2)
+    if m == 0 or len(edges) == 0:
+        return adj
+    row = np.full(max(int(ids.max()), int(edges.max())) + 1, -1, dtype=np.intp)
+    row[ids] = np.arange(m)
+    a = row[edges[:, 0]]
+    b = row[edges[:, 1]]
+    ok = (a >= 0) & (b >= 0)
+    adj[a[ok], b[ok]] = True
+    adj[b[ok], a[ok]] = True
+    return adj
+
+
+def quantization_error(samples, xy, chunk=CHUNK):
+    if len(xy) == 0:
+        return float("inf")
+    _, _, d1 = winners(samples, xy, chunk)
+    return float(np.sqrt(d1).mean())
+
+
+def topological_error(samples, xy, edges, ids=None, chunk=CHUNK):
+    """TE over samples; ids = node id of each row of xy (default 0..M-1),
+    edges = (K, 2) id pairs. NaN with < 2 nodes."""
+    if len(xy) < 2:
+        return float("nan")
+    if ids is None:
+        ids = np.arange(len(xy))
+    s1, s2, _ = winners(samples, xy, chunk)
+    adj = adjacency(edges, ids)
+    return float((~adj[s1, s2]).mean())
+
+
+def node_utilization(samples, xy, chunk=CHUNK):
+    """Fraction of nodes that are s1 of at least one sample."""
+    if len(xy) == 0:
+        return 0.0
+    s1, _, _ = winners(samples, xy, chunk)
+    return len(np.unique(s1)) / len(xy)
+
+
+class SnapshotScorer:
+    """QE / TE of consecutive snapshots of the same run, see module doc."""
+
+    def __init__(self, samples):
+        self.samples = np.asarray(samples, dtype=np.float64).reshape(-1, 2)
+        n = len(self.samples)
+        self.pos = np.full((0, 2), np.nan)   # by node id, NaN = inactive
+        self.d = np.full((n, 0), np.inf)     # squared distance by node id
+        self.s1 = np.full(n, -1, dtype=np.intp)
+        self.s2 = np.full(n, -1, dtype=np.intp)
+        self.d1 = np.full(n, np.inf)
+        self.d2 = np.full(n, np.inf)
+        self.rescored = 0                    # columns recomputed by the last update
+
+    def _grow(self, cap):
+        if cap <= len(self.pos):
+            return
+        extra = cap - len(self.pos)
+        self.pos = np.vstack((self.pos, np.full((extra, 2), np.nan)))
+        self.d = np.hstack((self.d, np.full((len(self.samples), extra), np.inf)))
+
+    def update(self, ids, xy, edges):
+        """Score one snapshot: ids (M,) node ids, xy (M, 2), edges (K, 2) id pairs.
+        Returns (qe, te); te is NaN with < 2 nodes."""
+        ids = np.asarray(ids, dtype=np.intp)
+        xy = np.asarray(xy, dtype=np.float64).reshape(-1, 2)
+        self._grow(int(ids.max()) + 1 if len(ids) else 0)
+
+        new = np.full_like(self.pos, np.nan)
+        new[ids] = xy
+        same = (new == self.pos) | (np.isnan(new) & np.isnan(self.pos))
+        changed = np.flatnonzero(~same.all(axis=1))
+        self.pos = new
+        self.rescored = len(changed)
+
+        if len(changed):
+            live = changed[~np.isnan(new[changed, 0])]
+            self.d[:, changed] = np.inf
+            for lo in range(0, len(self.samples), CHUNK):
+                self.d[lo:lo + CHUNK, live] = sqdist(self.samples[lo:lo + CHUNK], new[live])
+
+            hit = np.isin(self.s1, changed) | np.isin(self.s2, changed)
+            cols = np.arange(self.d.shape[1])
+            for lo in range(0, len(hit), CHUNK):
+                rows = lo + np.flatnonzero(hit[lo:lo + CHUNK])
+                if len(rows):
+                    (self.s1[rows], self.s2[rows],
+                     self.d1[rows], self.d2[rows]) = _top2(self.d[rows], cols)
+            keep = np.flatnonzero(~hit)
+            if len(keep) and len(live):
+                old = (self.s1[keep], self.s2[keep], self.d1[keep], self.d2[keep])
+                (self.s1[keep], self.s2[keep],
+                 self.d1[keep], self.d2[keep]) = _merge2(old, _top2(self.d[keep][:, live], live))
+
+        if len(ids) == 0:
+            return float("inf"), float("nan")
+        qe = float(np.sqrt(self.d1).mean())
+        if len(ids) < 2:
+            return qe, float("nan")
+        adj = adjacency(edges, np.arange(len(self.pos)))
+        te = float((~adj[self.s1, self.s2]).mean())
+        return qe, te
@@ -0,0 +1,305 @@
+"""
+Gowin place-and-route snapshots
+===============================
+
+Every Gowin project in the repo keeps its last PnR run in impl/pnr/:
+<name>.rpt.txt (resource usage), <name>_tr_content.html (timing summary),
+<name>.timing_paths (worst paths) and the bitstream <name>.fs. This
+module reads them into one record per build:
+
+- resources: every row of "Resource Usage Summary" (Logic, Register,
+  CLS, BSRAM, DSP, ...) as used / total, plus the LUT / ALU / ROM16 split
+- timing: per clock constraint, actual Fmax and logic levels, setup /
+  hold TNS, violated endpoints and the worst setup slack
+- bitstream: sha256 of the .fs (first 16 hex), git describe, tool,
+  part and the report's creation time
+
+`record` appends it to a JSON history (--history) and compares it with the
+last record of the same project: Fmax down or Logic / Register / BSRAM /
+DSP up by more than --tolerance, or any setup violation, is reported as a
+regression (exit status 2 with --strict). With --results, the suite rows
+(python -m gngio suite run ... --bitstream <fs>) of the same bitstream
+give its throughput: mean steps/s over their datasets and steps/s per
+1000 Logic cells, the figure to watch when lanes or pipeline stages go in.
+
+    python -m gngio pnr show ../gng_neorv32_accelerator_V3/gng_gowin_project
+    python -m gngio pnr record ../gng_neorv32_accelerator_V3/gng_gowin_project --label lanes4 \\
+        --results suite.json
+    python -m gngio pnr table pnr_history.json
+"""
+
+import hashlib
+import html
+import json
+import re
+import time
+from pathlib import Path
+
+from .bench import _git_rev, load_history, save_history
+
+# resources compared by `record`, larger = worse
+WATCH = ("Logic", "Register", "BSRAM", "DSP")
+
+_ROW = re.compile(r"^  (\S[^|]*?)\s*\|\s*(\d+)(?:/(\d+))?")
+_SUB = re.compile(r"^    --(\S[^|]*?)\s*\|\s*(\d+)(?:/(\d+))?")
+_LUT = re.compile(r"(\d+) LUT, (\d+) ALU, (\d+) ROM16")
+_HDR = re.compile(r"<(Tool Version|Part Number|Device|Created Time)>:\s*(.*)")
+
+
+def find_pnr(path) -> Path:
+    """Project dir, its impl/pnr dir or a .rpt.txt -> the .rpt.txt."""
+    p = Path(path)
+    if p.is_file():
+        return p
+    for d in (p / "impl" / "pnr", p):
+        hits = sorted(d.glob("*.rpt.txt"))
+        if hits:
+            return hits[0]
+    raise FileNotFoundError(f"{path}: no impl/pnr/*.rpt.txt")
+
+
+def parse_rpt(text: str) -> dict:
+    """<name>.rpt.txt -> {"info": {...}, "resources": {name: {used, total}}}."""
+    info, res = {}, {}
+    section = None
+    top = None
+    for line in text.splitlines():
+        m = _HDR.search(line)
+        if m and m.group(1) not in info:
+            info[m.group(1)] = m.group(2).strip()
+        if re.match(r"^\d+\. ", line):
+            section = line.split(". ", 1)[1].strip()
+            continue
+        if section != "Resource Usage Summary":
+            continue
+        m = _ROW.match(line)
+        if m and m.group(1) != "Resources":
+            top = m.group(1)
+            res[top] = {"used": int(m.group(2))}
+            if m.group(3):
+                res[top]["total"] = int(m.group(3))
+            continue
+        m = _SUB.match(line)
+        if m and top:
+            lut = _LUT.search(line)
+            if lut:
+                res[top].update(lut=int(lut.group(1)), alu=int(lut.group(2)), rom16=int(lut.group(3)))
+            res[f"{top}/{m.group(1)}"] = {"used": int(m.group(2))}
+            if m.group(3):
+                res[f"{top}/{m.group(1)}"]["total"] = int(m.group(3))
+    return {"info": info, "resources": res}
+
+
+def _cells(table: str) -> list:
+    rows = []
+    for tr in re.findall(r"<tr>(.*?)(?=<tr>|</table>|$)", table, re.S):
+        cells = [html.unescape(re.sub(r"<[^>]+>", "", c)).strip()
+                 for c in re.findall(r"<td[^>]*>(.*?)(?=<td|</tr>|$)", tr, re.S)]
+        if cells:
+            rows.append(cells)
+    return rows
+
+
+def _section(text: str, anchor: str) -> str:
+    i = text.find(f'name="{anchor}"')
+    if i < 0:
+        return ""
+    return text[i:text.find("</table>", i)]
+
+
+def _mhz(s: str) -> float:
+    m = re.match(r"([\d.]+)", s)
+    return float(m.group(1)) if m else 0.0
+
+
+def parse_timing(text: str) -> dict:
+    """<name>_tr_content.html -> per clock Fmax, TNS and violated endpoints."""
+    clocks = {}
+    for c in _cells(_section(text, "Max_Frequency_Report")):
+        if len(c) >= 5:
+            clocks[c[1]] = {"constraint_mhz": _mhz(c[2]), "fmax_mhz": _mhz(c[3]),
+                            "levels": int(c[4]) if c[4].isdigit() else None}
+    for c in _cells(_section(text, "Total_Negative_Slack_Report")):
+        if len(c) >= 4 and c[0] in clocks:
+            clocks[c[0]][f"tns_{c[1].lower()}"] = float(c[2])
+    out = {"clocks": clocks}
+    for c in _cells(_section(text, "STA_Tool_Run_Summary")):
+        if len(c) >= 2 and c[0].startswith("Numbers of") and "Violated" in c[0]:
+            out["setup_violated" if "Setup" in c[0] else "hold_violated"] = int(c[1])
+    return out
+
+
+def worst_setup_slack(text: str):
+    """First SETUP path of <name>.timing_paths -> its slack (ns), None if absent."""
+    lines = text.splitlines()
+    for i, ln in enumerate(lines):
+        if ln.strip() == "SETUP" and i + 1 < len(lines):
+            try:
+                return float(lines[i + 1])
+            except ValueError:
+                return None
+    return None
+
+
+def snapshot(path) -> dict:
+    """One record of the PnR run of a project (see the module doc)."""
+    rpt = find_pnr(path)
+    d = rpt.parent
+    stem = rpt.name[:-len(".rpt.txt")]
+    rec = parse_rpt(rpt.read_text(errors="replace"))
+    tr = d / f"{stem}_tr_content.html"
+    rec["timing"] = parse_timing(tr.read_text(errors="replace")) if tr.exists() else {"clocks": {}}
+    tp = d / f"{stem}.timing_paths"
+    if tp.exists():
+        rec["timing"]["setup_slack"] = worst_setup_slack(tp.read_text(errors="replace"))
+    for ext in (".fs", ".bin"):
+        bs = d / f"{stem}{ext}"
+        if bs.exists():
+            rec["bitstream"] = bitstream_sha(bs)
+            break
+    # project = the directory above impl/, relative names stay stable across clones
+    proj = d.parent.parent if d.name == "pnr" else d
+    rec.update(project=f"{proj.parent.name}/{proj.name}", git=_git_rev())
+    return rec
+
+
+def bitstream_sha(path) -> str:
+    """sha256 (16 hex) of a bitstream file, as snapshot() and suite --bitstream store it."""
+    return hashlib.sha256(Path(path).read_bytes()).hexdigest()[:16]
+
+
+def fmax(rec: dict) -> float:
+    """Lowest Fmax over the clocks (the one that limits the build)."""
+    f = [c["fmax_mhz"] for c in rec["timing"]["clocks"].values() if c.get("fmax_mhz")]
+    return min(f) if f else 0.0
+
+
+def attach_suite(rec: dict, rows: list):
+    """Board suite rows of rec's bitstream -> rec["suite"] (mean steps/s, per kLogic)."""
+    mine = [r for r in rows if r.get("bitstream") == rec.get("bitstream") and r.get("steps_s")]
+    if not mine:
+        return
+    sps = sum(r["steps_s"] for r in mine) / len(mine)
+    logic = rec["resources"].get("Logic", {}).get("used", 0)
+    rec["suite"] = {"rows": len(mine), "datasets": sorted({r["dataset"] for r in mine}),
+                    "platform": sorted({r["platform"] for r in mine}), "steps_s": sps,
+                    "steps_s_klogic": sps * 1000.0 / logic if logic else 0.0}
+
+
+def compare(prev: dict, cur: dict, tolerance: float) -> list:
+    """Regressions of cur against prev as text lines."""
+    out = []
+    a, b = fmax(prev), fmax(cur)
+    if a > 0 and b < a * (1.0 - tolerance):
+        out.append(f"Fmax {a:.3f} -> {b:.3f} MHz ({100 * (b / a - 1):+.1f}%)")
+    for k in WATCH:
+        a = prev["resources"].get(k, {}).get("used", 0)
+        b = cur["resources"].get(k, {}).get("used", 0)
+        if b > a * (1.0 + tolerance) and b > a:
+            out.append(f"{k} {a} -> {b}" + (f" ({100 * (b / a - 1):+.1f}%)" if a else ""))
+    t = cur["timing"]
+    if t.get("setup_violated") or (t.get("setup_slack") is not None and t["setup_slack"] < 0):
+        out.append(f"setup violated: {t.get('setup_violated', '?')} endpoints, "
+                   f"worst slack {t.get('setup_slack')} ns")
+    a = prev.get("suite", {}).get("steps_s_klogic", 0.0)
+    b = cur.get("suite", {}).get("steps_s_klogic", 0.0)
+    if a > 0 and 0 < b < a * (1.0 - tolerance):
+        out.append(f"steps/s per kLogic {a:.1f} -> {b:.1f} ({100 * (b / a - 1):+.1f}%)")
+    return out
+
+
+def _used(rec: dict, k: str) -> str:
+    r = rec["resources"].get(k)
+    if not r:
+        return "-"
+    return f"{r['used']}/{r['total']}" if "total" in r else str(r["used"])
+
+
+def format_record(rec: dict) -> list:
+    res = rec["resources"]
+    lg = res.get("Logic", {})
+    info = rec["info"]
+    lines = [f"# {rec['project']} {rec.get('label', '')} git={rec.get('git', '')} "
+             f"bitstream={rec.get('bitstream', '-')}  {info.get('Part Number', '')} "
+             f"{info.get('Tool Version', '')} ({info.get('Created Time', '')})",
+             f"  Logic {_used(rec, 'Logic')} ({lg.get('lut', '-')} LUT, {lg.get('alu', '-')} ALU)"
+             f"  Register {_used(rec, 'Register')}  CLS {_used(rec, 'CLS')}"
+             f"  BSRAM {_used(rec, 'BSRAM')}  DSP {_used(rec, 'DSP')}"]
+    t = rec["timing"]
+    for name, c in t["clocks"].items():
+        lines.append(f"  {name}: {c['fmax_mhz']:.3f} MHz (constraint {c['constraint_mhz']:.3f}, "
+                     f"{c.get('levels', '-')} levels)  TNS setup {c.get('tns_setup', 0.0):.3f} "
+                     f"hold {c.get('tns_hold', 0.0):.3f}")
+    if t.get("setup_slack") is not None:
+        lines.append(f"  worst setup slack {t['setup_slack']:.3f} ns, "
+                     f"violated setup {t.get('setup_violated', '-')} hold {t.get('hold_violated', '-')}")
+    if "suite" in rec:
+        s = rec["suite"]
+        lines.append(f"  suite {','.join(s['platform'])} {s['rows']} rows: {s['steps_s']:.0f} steps/s, "
+                     f"{s['steps_s_klogic']:.1f} steps/s per 1000 Logic")
+    return lines
+
+
+TABLE_HEADER = (f"  {'time':19s}  {'project':40s}  {'label':11s} {'Logic':>5s} {'LUT':>5s} {'Reg':>4s}"
+                f" {'BSRAM':>5s} {'DSP':>3s} {'Fmax':>6s} {'slack':>6s} {'steps/s':>9s} {'/kLogic':>8s}")
+
+
+def format_row(rec: dict) -> str:
+    res = rec["resources"]
+    s = rec.get("suite", {})
+    slack = rec["timing"].get("setup_slack")
+    return (f"  {rec.get('time', ''):19s}  {rec['project'][:40]:40s}  {rec.get('label', '')[:11]:11s}"
+            f" {res.get('Logic', {}).get('used', 0):5d} {res.get('Logic', {}).get('lut', 0):5d}"
+            f" {res.get('Register', {}).get('used', 0):4d} {res.get('BSRAM', {}).get('used', 0):5d}"
+            f" {res.get('DSP', {}).get('used', 0):3d} {fmax(rec):6.2f}"
+            f" {slack if slack is not None else float('nan'):6.2f}"
+            f" {s.get('steps_s', 0.0):9.0f} {s.get('steps_s_klogic', 0.0):8.1f}")
+
+
+def main(args) -> int:
+    if args.pnr_op == "table":
+        print(TABLE_HEADER)
+        for rec in load_history(args.history):
+            print(format_row(rec))
+        return 0
+    recs = [snapshot(p) for p in args.project]
+    if args.pnr_op == "show":
+        for rec in recs:
+            print("\n".join(format_record(rec)))
+        return 0
+
+    rows = []
+    for p in args.results or ():
+        rows += json.loads(Path(p).read_text())
+    history = load_history(args.history)
+    regress_any = False
+    for rec in recs:
+        rec.update(time=time.strftime("%Y-%m-%dT%H:%M:%S"), label=args.label)
+        attach_suite(rec, rows)
+        print("\n".join(format_record(rec)))
+        prev = next((h for h in reversed(history) if h["project"] == rec["project"]), None)
+        regress = compare(prev, rec, args.tolerance) if prev else []
+        if prev:
+            print(f"# vs {prev['time']} {prev.get('label', '')} {prev.get('git', '')}: "
+                  + ("; ".join(regress) if regress else "no regression"))
+        rec["regressions"] = regress
+        regress_any = regress_any or bool(regress)
+        history.append(rec)
+    save_history(args.history, history)
+    return 2 if regress_any and args.strict else 0
+
+
+def add_arguments(ap):
+    sub = ap.add_subparsers(dest="pnr_op", required=True)
+    s = sub.add_parser("show", help="print the PnR snapshot of projects")
+    s.add_argument("project", nargs="+", help="Gowin project dir, impl/pnr dir or .rpt.txt")
+    r = sub.add_parser("record", help="append snapshots to the history, flag regressions")
+    r.add_argument("project", nargs="+", help="Gowin project dir, impl/pnr dir or .rpt.txt")
+    r.add_argument("--label", default="", help="label of this build in the history")
+    r.add_argument("--results", action="append",
+                   help="suite results file (rows with --bitstream), repeatable")
+    r.add_argument("--history", default="pnr_history.json")
+    r.add_argument("--tolerance", type=float, default=0.02)
+    r.add_argument("--strict", action="store_true", help="exit 2 on a regression")
+    t = sub.add_parser("table", help="one line per history record")
+    t.add_argument("history", nargs="?", default="pnr_history.json")
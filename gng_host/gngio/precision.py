@@ -0,0 +1,313 @@
+"""
+Precision / footprint sweep
+===========================
+
+The firmware steps Q16.16 positions (Q1.15 with GNG_POS16), 32-bit errors
+and 8-bit edge ages, the V2 node word is 16 + 16 + 1 + 32 bits. This runs
+the bench suite (bench_suite.json: datasets, samples, steps, params) on
+gngsim builds with narrower fields and picks, per field, the smallest width
+whose QE stays within --qe-rel of the full-width run and whose TE rises by
+at most --te-abs (default: band_tol te_abs of the spec) on every dataset:
+
+  pos  P bits per component, signed Q1.(P-1) (GNG_POS_BITS): a move or a
+       midpoint rounds to 2^-(P-1); P <= 16 also stores int16 positions
+       (GNG_POS16), P = 17 is the full Q16.16 step
+  err  E bits per error / utility word (GNG_ERR_BITS), saturating
+  age  A bits per edge cell: a_max <= 2^A - 2 (GNG_AGE_BITS)
+  deg  D bits per degree counter: GNG_MAX_DEGREE = 2^D - 1, a full node
+       drops its oldest edge; unbounded once 2^D - 1 >= MAX_NODES - 1
+
+Every field is swept alone, the others at full width; its pick is the
+smallest candidate from which on every wider one meets the target too (one
+lucky run does not pick a width). The picks are then run together, and
+while that misses the target the field whose pick cost the most alone
+(QE / TE change over its target) goes back to its next wider candidate.
+
+QE / TE of a run are the mean of SCORE_TAIL snapshots over the last fifth
+of the `steps` (one final snapshot moves by a few % from insertion to
+insertion). Columns:
+
+  QE       mean over the datasets
+  dQE      worst relative QE change against full width, "ok" within target
+  TE       mean over the datasets (worst TE rise in the target)
+  bits     packed bits per node: node word 2P + 1 + E + D and (N - 1) / 2
+           edge cells of A bits (half matrix)
+  fw B     static GNG state of the firmware build / MAX_NODES (gngsim
+           state_bytes; only GNG_POS16 shrinks the C structs)
+  ns/step  host simulator, the relative cost; board cycles come from
+           `suite run v3` on a `make LAYOUT=...` build
+  fit      nodes whose bits fit in --budget bytes
+
+Outputs:
+  --header  gng_layout.h for gng_neorv32_accelerator_V3/fw (and
+            gng_host/fwhost): make LAYOUT=gng_layout.h
+  --vhd     gng_layout.vhd of gng_neorv32_accelerator_V2 (its src/ has the
+            full-width one), tang_nano_9k.vhd maps it to gng.vhd POS_W /
+            ERR_W / A_MAX. V2 positions are value * 1000, so POS_W =
+            max(P, 11): 11 bits hold [-1.024, 1.024) exactly. The V2 error
+            (d^2 * 62500 under a [1, 2) scale) is within 5 % of the
+            firmware's units (d^2 * 65536, BFP mantissa in [1, 2)) and
+            takes E as it is; the degree stays in the 8-bit deg_r.
+
+    python -m gngio precision                                   # table + picks
+    python -m gngio precision --qe-rel 0.02 --pos 10,12,14,16,17
+    python -m gngio precision --header ../gng_neorv32_accelerator_V3/fw/gng_layout.h \\
+        --vhd ../gng_neorv32_accelerator_V2/gng_gowin_project/src/gng_layout.vhd
+"""
+
+import json
+import sys
+import time
+from pathlib import Path
+
+from .suite import SPEC, check_dataset, load_spec, make_dataset, score
+
+FIELDS = ("pos", "err", "age", "deg")
+FULL_POS = 17   # Q16.16: sign + 16 fraction bits over [0, 1)
+FULL_ERR = 32
+FULL_AGE = 8
+SCORE_TAIL = 4  # snapshots per run, spread over the last fifth
+V2_POS_MIN = 11
+
+
+def full_deg(n: int) -> int:
+    return max(2, (n - 1).bit_length())
+
+
+def full_layout(n: int) -> dict:
+    return {"pos": FULL_POS, "err": FULL_ERR, "age": FULL_AGE, "deg": full_deg(n)}
+
+
+def max_degree(lay: dict, n: int) -> int:
+    """GNG_MAX_DEGREE of the layout, 0 = unbounded."""
+    k = (1 << lay["deg"]) - 1
+    return 0 if k >= n - 1 else k
+
+
+def a_max(lay: dict, spec_a_max: int) -> int:
+    return min(spec_a_max, (1 << lay["age"]) - 2)
+
+
+def node_bits(lay: dict, n: int) -> float:
+    return 2 * lay["pos"] + 1 + lay["err"] + lay["deg"] + lay["age"] * (n - 1) / 2.0
+
+
+def fit(lay: dict, budget: int) -> int:
+    """Largest MAX_NODES (<= 255) whose node words and edge cells fit budget bytes."""
+    word = 2 * lay["pos"] + 1 + lay["err"] + lay["deg"]
+    n = 1
+    while n < 255 and (n + 1) * word + (n + 1) * n // 2 * lay["age"] <= 8 * budget:
+        n += 1
+    return n
+
+
+def run_layout(spec: dict, lay: dict, data: dict) -> dict:
+    """gngsim on every dataset with the widths of lay -> row."""
+    sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+    from gngsim import Sim
+    p = spec["params"]
+    n = p["max_nodes"]
+    pos = 0 if lay["pos"] >= FULL_POS else lay["pos"]
+    sim = Sim(n, max_degree(lay, n), pos_bits=pos, err_bits=lay["err"], age_bits=lay["age"])
+    steps = spec["steps"]
+    gap = max(steps // (5 * SCORE_TAIL), 1)
+    per, dt = {}, 0.0
+    for name, d in data.items():
+        sim.config(p["lambda"], p["eps_b"], p["eps_n"], p["alpha"], a_max(lay, p["a_max"]), p["d"])
+        sim.load(d)
+        sim.reset()
+        t0 = time.perf_counter()
+        sim.run(steps - gap * (SCORE_TAIL - 1))
+        dt += time.perf_counter() - t0
+        qe = te = 0.0
+        for k in range(SCORE_TAIL):
+            if k:
+                t0 = time.perf_counter()
+                sim.run(gap)
+                dt += time.perf_counter() - t0
+            ids, xy = sim.nodes()
+            s = score(d, ids, xy, [(a, b) for a, b, _ in sim.edges()])
+            qe += s["qe"] / SCORE_TAIL
+            te += s["te"] / SCORE_TAIL
+        per[name] = {"qe": qe, "te": te}
+    m = len(per)
+    return {**lay, "per": per, "n": n,
+            "qe": sum(r["qe"] for r in per.values()) / m,
+            "te": sum(r["te"] for r in per.values()) / m,
+            "bits": node_bits(lay, n), "fw_bytes": sim.state_bytes() / n,
+            "ns_step": dt * 1e9 / (steps * m)}
+
+
+def rel(row: dict, ref: dict) -> tuple:
+    """(worst relative QE change against ref, its dataset)."""
+    return max((row["per"][k]["qe"] / ref["per"][k]["qe"] - 1.0, k) for k in ref["per"])
+
+
+def cost(row: dict, ref: dict, target: tuple) -> float:
+    """Worst QE / TE change over its target, <= 1 meets both."""
+    dte = max(row["per"][k]["te"] - ref["per"][k]["te"] for k in ref["per"])
+    return max(rel(row, ref)[0] / target[0], dte / target[1])
+
+
+def format_row(tag: str, r: dict, ref: dict, target: tuple, budget: int) -> str:
+    d, name = rel(r, ref)
+    ok = "ok" if cost(r, ref, target) <= 1.0 else "-"
+    return (f"  {tag:5s} {r['pos']:3d} {r['err']:3d} {r['age']:3d} {r['deg']:3d}"
+            f" {r['qe']:8.4f} {d * 100:+6.1f}% {ok:2s} {r['te']:6.3f} {r['bits']:7.1f}"
+            f" {r['fw_bytes']:6.1f} {r['ns_step']:8.0f} {fit(r, budget):4d}  {name if d > 0 else ''}")
+
+
+HEADER = ("  run     P   E   A   D       QE     dQE     TE    bits   fw B  ns/step  fit")
+
+
+def sweep(spec: dict, data: dict, cands: dict, target: tuple, budget: int, out=print):
+    """Field sweeps + combination -> (pick layout, its row, full row, all rows)."""
+    n = spec["params"]["max_nodes"]
+    cache = {}
+
+    def run(lay):
+        key = tuple(lay[f] for f in FIELDS)
+        if key not in cache:
+            cache[key] = run_layout(spec, lay, data)
+        return cache[key]
+
+    full = full_layout(n)
+    ref = run(full)
+    out(format_row("full", ref, ref, target, budget))
+    loss, picks, ladders = {}, {}, {}
+    for f in FIELDS:
+        ladder = sorted({c for c in cands[f] if c < full[f]} | {full[f]})
+        rows = []
+        for c in ladder:
+            r = run({**full, f: c})
+            rows.append(r)
+            if c != full[f]:
+                out(format_row(f, r, ref, target, budget))
+        k = len(ladder) - 1
+        while k > 0 and cost(rows[k - 1], ref, target) <= 1.0:
+            k -= 1
+        ladders[f], picks[f], loss[f] = ladder, k, cost(rows[k], ref, target)
+    while True:
+        lay = {f: ladders[f][picks[f]] for f in FIELDS}
+        row = run(lay)
+        out(format_row("pick", row, ref, target, budget))
+        if cost(row, ref, target) <= 1.0:
+            break
+        back = [f for f in FIELDS if picks[f] < len(ladders[f]) - 1]
+        if not back:
+            break
+        f = max(back, key=lambda g: loss[g])
+        picks[f] += 1
+        loss[f] = cost(run({**full, f: ladders[f][picks[f]]}), ref, target)
+    return lay, row, ref, list(cache.values())
+
+
+def _summary(spec: dict, row: dict, ref: dict, target: tuple) -> list:
+    d, name = rel(row, ref)
+    return [f"{spec['suite']} v{spec['version']}, MAX_NODES {row['n']}: QE {d * 100:+.1f} % of full width"
+            f" (worst {name}), target {target[0] * 100:+.1f} % / TE {target[1]:+.3f}",
+            f"{row['bits']:.1f} bits per node instead of {ref['bits']:.1f}"]
+
+
+def c_header(lay: dict, n: int, spec_a_max: int, summary: list) -> str:
+    pos = 0 if lay["pos"] >= FULL_POS else lay["pos"]
+    am = a_max(lay, spec_a_max)
+    k = max_degree(lay, n)
+    lines = [
+        "// gng_layout.h - node field widths (python -m gngio precision)",
+        *(f"// {s}" for s in summary),
+        "// generated, re-run python -m gngio precision --header instead of editing",
+        "",
+        "#ifndef GNG_LAYOUT_H",
+        "#define GNG_LAYOUT_H",
+        "",
+        f"#define GNG_POS_BITS    {pos:<3d} // " + (f"Q1.{pos - 1} per component" if pos else "full Q16.16"),
+    ]
+    if 0 < pos <= 16:
+        lines += ["#ifndef GNG_POS16", "#define GNG_POS16       1   // int16 node positions", "#endif"]
+    lines += [f"#define GNG_ERR_BITS    {lay['err']}",
+              f"#define GNG_AGE_BITS    {lay['age']:<3d} // a_max <= {(1 << lay['age']) - 2}"]
+    if am < spec_a_max:
+        lines += [f"#define GNG_A_MAX       {am:<3d} // suite a_max {spec_a_max} does not fit"]
+    lines += [f"#define GNG_MAX_DEGREE  {k:<3d} // " + (f"{lay['deg']}-bit degree" if k else "unbounded"),
+              "", "#endif // GNG_LAYOUT_H", ""]
+    return "\n".join(lines)
+
+
+def vhd_package(lay: dict, spec_a_max: int, summary: list) -> str:
+    pos = min(max(lay["pos"], V2_POS_MIN), 16)
+    err, am = lay["err"], a_max(lay, spec_a_max)
+    lines = [
+        "-- gng_layout.vhd : node_mem field widths of gng.vhd (V2)",
+        *(f"-- {s}" for s in summary),
+        "-- generated by python -m gngio precision (gng_host/gngio/precision.py),",
+        "-- re-run it with --vhd instead of editing",
+        "",
+        "package gng_layout is",
+        f"  constant LAYOUT_POS_W : natural := {f'{pos};':4s} -- x / y (value * 1000, signed)",
+        f"  constant LAYOUT_ERR_W : natural := {f'{err};':4s} -- saturating error",
+        f"  constant LAYOUT_A_MAX : natural := {f'{am};':4s} -- A_MAX <= 2^{lay['age']} - 2",
+        "end package;",
+        "",
+    ]
+    return "\n".join(lines)
+
+
+def _widths(text: str) -> list:
+    return [int(v) for v in text.split(",") if v.strip()]
+
+
+def main(args) -> int:
+    spec = load_spec(args.spec)
+    if args.max_nodes:
+        spec["params"]["max_nodes"] = args.max_nodes
+    if args.steps:
+        spec["steps"] = args.steps
+    names = args.dataset or list(spec["datasets"])
+    data = {}
+    for name in names:
+        data[name] = make_dataset(spec, name)
+        check_dataset(spec, name, data[name])
+    cands = {f: _widths(getattr(args, f)) for f in FIELDS}
+    target = (args.qe_rel, spec["band_tol"]["te_abs"] if args.te_abs is None else args.te_abs)
+    print(f"# {spec['suite']} v{spec['version']}: {spec['samples']} samples, {spec['steps']} steps,"
+          f" MAX_NODES {spec['params']['max_nodes']}, {len(names)} datasets, target QE"
+          f" {target[0] * 100:+.1f} % / TE {target[1]:+.3f}")
+    print(HEADER)
+    lay, row, ref, rows = sweep(spec, data, cands, target, args.budget)
+    summary = _summary(spec, row, ref, target)
+    print(f"# pick: P={lay['pos']} E={lay['err']} A={lay['age']} D={lay['deg']}, {summary[1]}")
+    a = spec["params"]["a_max"]
+    if args.header:
+        Path(args.header).write_text(c_header(lay, row["n"], a, summary))
+        print(f"{args.header}: make LAYOUT={Path(args.header).name}")
+    if args.vhd:
+        Path(args.vhd).write_text(vhd_package(lay, a, summary))
+        print(f"{args.vhd}: POS_W {min(max(lay['pos'], V2_POS_MIN), 16)}, ERR_W {lay['err']}")
+    if args.results:
+        path = Path(args.results)
+        old = json.loads(path.read_text()) if path.exists() else []
+        stamp = time.strftime("%Y-%m-%dT%H:%M:%S")
+        new = [{**r, "version": spec["version"], "time": stamp, "pick": r is row} for r in rows]
+        path.write_text(json.dumps(old + new, indent=1) + "\n")
+    return 0 if cost(row, ref, target) <= 1.0 else 2
+
+
+def add_arguments(ap):
+    ap.add_argument("--spec", default=str(SPEC))
+    ap.add_argument("--dataset", action="append", help="spec dataset (repeatable, default all)")
+    ap.add_argument("--max-nodes", type=int, help="instead of the spec's max_nodes")
+    ap.add_argument("--steps", type=int, help="instead of the spec's steps")
+    ap.add_argument("--qe-rel", type=float, default=0.05,
+                    help="largest QE increase over full width per dataset (default 0.05)")
+    ap.add_argument("--te-abs", type=float,
+                    help="largest TE increase per dataset (default: spec band_tol te_abs)")
+    ap.add_argument("--pos", default="8,10,11,12,13,14,16", help="candidate P bits (full: 17)")
+    ap.add_argument("--err", default="12,14,16,18,20,24", help="candidate E bits (full: 32)")
+    ap.add_argument("--age", default="3,4,5,6,7", help="candidate A bits (full: 8)")
+    ap.add_argument("--deg", default="2,3,4", help="candidate D bits (full: log2 MAX_NODES)")
+    ap.add_argument("--budget", type=int, default=4096,
+                    help="bytes of node words + edge cells for the fit column (default 4096)")
+    ap.add_argument("--header", help="write the pick as gng_layout.h (V3 firmware)")
+    ap.add_argument("--vhd", help="write the pick as gng_layout.vhd (V2 gng.vhd)")
+    ap.add_argument("--results", help="JSON file the rows are appended to")
@@ -0,0 +1,752 @@
+"""
+Wire formats of the GNG boards and a bulk frame splitter
+========================================================
+
+Two families of streams come out of the boards:
+
+1. Framed protocol (NEORV32 V3 firmware, PicoTiny, Arduino):
+       FF FF CMD LEN PAYLOAD CHK      CHK = ~(CMD + LEN + sum(payload))
+   (V3 after CMD_LINK LINK_OP_COBS, host -> board only:
+       COBS(CMD LEN PAYLOAD CHK) 00)
+2. V2 hardware streamer (gng.vhd, no checksum):
+       A5 10  DBG, fixed 54 bytes, tag/value pairs
+       A5 20  node snapshot: MAX_NODES, node_count, MAX_NODES * 7 bytes
+       A5 21  edge snapshot: cnt lo, cnt hi, cnt * 3 bytes
+       A5 22  edge bitmap: nbytes lo, nbytes hi, half-matrix bitmap
+
+The parsers take whole chunks of bytes (what serial.read() returned) and
+search for headers with bytes.find(), so there is no Python work per byte.
+Each frame is sliced out once. The decoders then use numpy.frombuffer()
+to make views over that slice, with no per-node or per-edge Python loop.
+"""
+
+import struct
+from dataclasses import dataclass
+from typing import List
+
+import numpy as np
+
+# ---------------------------------------------------------------------------
+# Framed protocol (V3 main.c / PicoTiny firmware.c)
+# ---------------------------------------------------------------------------
+UART_HDR = 0xFF
+
+CMD_DATA_BATCH = 0x01
+CMD_DONE = 0x02
+CMD_RUN = 0x03
+CMD_STREAM = 0x04
+CMD_SET_BAUD = 0x05
+CMD_SNAP_MODE = 0x06
+CMD_TRAIN_MODE = 0x07
+CMD_CKPT = 0x08
+CMD_SD = 0x09
+CMD_SET_PARAMS = 0x0A
+CMD_MODEL = 0x0B
+CMD_QUERY = 0x0C
+CMD_CONVERGE = 0x0D
+CMD_CFS_PERF = 0x0E
+CMD_TRACE = 0x0F
+CMD_LINK = 0x23
+CMD_STATS = 0x25
+CMD_SEED = 0x27
+CMD_GEN = 0x29
+CMD_EVAL = 0x2B
+
+# CMD_SNAP_MODE trigger bits (V3 firmware)
+SNAP_TRIG_EVERY = 0x01
+SNAP_TRIG_TOPO = 0x02
+SNAP_TRIG_QE = 0x04
+SNAP_TRIG_TIME = 0x08
+SNAP_TRIG_AUTO = 0x10  # like EVERY, the firmware sets 'every' to hold io_pct % of cycles
+
+# CMD_TRAIN_MODE modes (V3 firmware)
+TRAIN_ONLINE = 0  # one Fritzke step per sample
+TRAIN_DBL = 1     # DBL-GNG: one batch update per pass over the dataset
+# CMD_TRAIN_MODE order byte (V3 GNG_SHUFFLE=1)
+ORDER_UPLOAD = 0   # online passes in upload order
+ORDER_SHUFFLE = 1  # a new on-device permutation every pass (default)
+
+# CMD_CONVERGE actions (V3 firmware GNG_CONVERGE=1)
+CONV_OFF = 0
+CONV_NOTIFY = 1  # CMD_CONVERGED + keyframe, training goes on
+CONV_STOP = 2    # CMD_CONVERGED + keyframe, then frozen until CMD_RUN
+
+# CMD_CFS_PERF_ACK counter order (V3 firmware CFS_PERF=1, gng_cfs.h CFS_PERF_*)
+CFS_PERF_NAMES = ("start", "smp", "busy", "idle", "node_wr", "bus", "stall")
+
+# CMD_TRACE_DATA flags (V3 firmware GNG_TRACE=1)
+TRACE_LAST = 0x01  # last frame of the traced step
+TRACE_NONE = 0x02  # bitstream without neorv32_tracer (CPU_TRACER = 0)
+
+# CMD_LINK ops and CMD_LINK_ACK framing byte (V3 firmware)
+LINK_OP_STATS = 0
+LINK_OP_LEGACY = 1  # host -> board FF FF frames (boot default)
+LINK_OP_COBS = 2    # host -> board COBS frames, 00 delimited
+LINK_OP_PAD = 3     # ignored, no ACK (link tests)
+LINK_OP_CLEAR = 0x80
+RX_FRAMING_FF = 0
+RX_FRAMING_COBS = 1
+LINK_FIELDS = ("rx_ok", "rx_bad", "rx_skip", "rx_lost")
+
+# CMD_STATS_FRAME payload order (V3 firmware health stats); steps / cycles
+# since the previous frame, the rest are totals or the state now. snap_every
+# (steps) and snap_io (last snapshot's share of its interval, per mille)
+# follow on newer firmware (48 bytes)
+STATS_FIELDS = ("steps", "cycles", "steps_s", "nodes", "edges", "rx_ok", "rx_bad",
+                "tx_queued", "tx_sent", "inserts", "renorms", "snap_every", "snap_io")
+
+# CMD_CKPT ops (V3 firmware, user flash checkpoint)
+CKPT_SAVE = 0
+CKPT_LOAD = 1
+CKPT_ERASE = 2
+
+# CMD_SEED ops (V3 firmware, network seed); every frame stays within the
+# GNG_SMP command ring (SMP_CMD_MAX = 48 payload bytes)
+SEED_OP_BEGIN = 0
+SEED_OP_NODES = 1   # [first][n] + n samples, CMD_DATA_BATCH layout
+SEED_OP_EDGES = 2   # [n] + n * (a, b)
+SEED_OP_COMMIT = 3  # swapped in between two steps, CMD_SEED_ACK
+SEED_FRAME_MAX = 48
+
+# CMD_GEN kinds (V3 firmware, gng_core/gng_gen.h): the bench dataset drawn on
+# the board, no upload; GEN_DATASETS maps the bench names onto them
+GEN_OFF = 0
+GEN_UNIFORM = 1
+GEN_MOONS = 2
+GEN_CIRCLES = 3
+GEN_GAUSS = 4
+GEN_DATASETS = {"uniform": GEN_UNIFORM, "two_moons": GEN_MOONS,
+                "circles": GEN_CIRCLES, "gaussian_mix": GEN_GAUSS}
+
+# CMD_SD ops and CMD_SD_ACK status (V3 firmware built with SD_CARD=1)
+SD_OP_STOP = 0
+SD_OP_TRAIN = 1   # arg = passes over GNGDATA.BIN, 0 = endless
+SD_OP_LOG = 2     # arg = 1: frames on the wire as well as in GNGLOG.BIN
+SD_STATUS = {0: "ok", 1: "no card", 2: "data file", 3: "log file"}
+
+# CMD_SET_PARAMS / CMD_PARAMS_ACK payload order (V3 firmware, GNG_PARAMS_RT=1);
+# lambda and a_max are integers, the others go as Q16 (1.0 = 65536). The
+# drift_* words follow only on a GNG_DRIFT build (ACK of 44 bytes).
+PARAM_NAMES = ("lambda", "a_max", "eps_b", "eps_n", "alpha", "d",
+               "drift_rise", "drift_hold", "drift_eps", "drift_lambda", "drift_amax")
+PARAM_BASE = 6
+PARAM_Q16 = ("eps_b", "eps_n", "alpha", "d", "drift_rise", "drift_eps")
+
+# CMD_MODEL ops (V3 firmware built with GNG_MODELS > 1)
+MODEL_OP_RUN = 0   # [k][slice u16]: models 0..k-1 take turns of slice steps
+MODEL_OP_DATA = 1  # [m]: the following DATA_BATCH samples are model m's
+MODEL_OP_VIEW = 2  # [m]: snapshots, PROF, CKPT and SET_PARAMS refer to model m
+MODEL_OP_HIER = 3  # [on]: model 0 routes the samples to fine models 1.. (GNG_MODELS >= 3)
+
+# CMD_QUERY flags and CMD_QUERY_ACK records (V3 firmware, inference only)
+QUERY_LABEL = 0x01  # label = connected component of s1
+QUERY_NONE = 0xFF   # s1 / label: no answer (fewer than 2 nodes, no label asked)
+QUERY_DTYPE = np.dtype([("s1", "u1"), ("label", "u1"), ("min1", "<u4")])
+
+CMD_GNG_NODES = 0x10
+CMD_GNG_EDGES = 0x11
+CMD_PROF = 0x12
+CMD_GNG_DELTA = 0x13
+CMD_GNG_EDGES_CHUNK = 0x14
+CMD_CREDIT = 0x15
+CMD_BAUD_ACK = 0x16
+CMD_GNG_EDGES_BITMAP = 0x17
+CMD_CKPT_ACK = 0x18
+CMD_SD_ACK = 0x19
+CMD_PARAMS_ACK = 0x1A
+CMD_MODEL_ACK = 0x1B
+CMD_PROF_AGG = 0x1C
+CMD_QUERY_ACK = 0x1D
+CMD_GNG_COMPONENTS = 0x1E
+CMD_CONVERGED = 0x1F
+CMD_GNG_REMAP = 0x20
+CMD_CFS_PERF_ACK = 0x21
+CMD_TRACE_DATA = 0x22
+CMD_LINK_ACK = 0x24
+CMD_STATS_FRAME = 0x26
+CMD_SEED_ACK = 0x28
+CMD_GEN_ACK = 0x2A
+CMD_EVAL_ACK = 0x2C
+
+# [id][x lo][x hi][y lo][y hi], coordinates int16 = value * 1000
+NODE_DTYPE = np.dtype([("id", "u1"), ("x", "<i2"), ("y", "<i2")])
+EDGE_DTYPE = np.dtype([("a", "u1"), ("b", "u1")])
+EDGE16_DTYPE = np.dtype([("a", "<u2"), ("b", "<u2")])
+
+# PROF: frame_id + u32 fields, later fields are optional (older firmware)
+PROF_FIELDS = (
+    "cyc_total", "cyc_winner", "cyc_move_w", "cyc_nb", "cyc_connect",
+    "cyc_delete", "cyc_prune", "cyc_insert", "cyc_renorm", "step",
+    "cyc_overlap", "misa", "mxisa", "tx_stall", "smp_dropped",
+    "epochs", "cache", "idle", "time", "qe", "qe_slow",
+    "drift_events", "drift_lat", "drift_left", "passes", "rx_bad", "rx_lost",
+)
+
+# PROF_AGG phase index = firmware Prof field order (gng_core/gng_prof.h)
+PROF_AGG_PHASES = PROF_FIELDS[:9] + ("cyc_overlap",)
+
+# ---------------------------------------------------------------------------
+# V2 A5 streamer (gng.vhd)
+# ---------------------------------------------------------------------------
+TAG_A5 = 0xA5
+A5_DBG = 0x10
+A5_NODES = 0x20
+A5_EDGES = 0x21
+A5_EDGE_BITMAP = 0x22
+
+A5_DBG_LEN = 54
+# tag bytes at the even offsets 2..52 of a DBG frame
+A5_DBG_TAGS = bytes(
+    [0xA6, 0xA7, 0xA8, 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8,
+     0xC9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB0, 0xB1, 0xB2, 0xB3, 0xB4,
+     0xB5, 0xA9])
+A5_DBG_FIELDS = (
+    "s1", "s2", "edge01", "es1s2_pre", "deg_s1", "deg_s2", "conn", "rm",
+    "iso", "iso_id", "node_count", "ins", "ins_id",
+    "err0", "err1", "err2", "err3", "s1x_lo", "s1x_hi", "s1y_lo", "s1y_hi",
+    "ts0", "ts1", "ts2", "ts3", "sample",
+)
+
+A5_NODE_DTYPE = np.dtype([("id", "u1"), ("act", "u1"), ("deg", "u1"),
+                          ("x", "<i2"), ("y", "<i2")])
+A5_EDGE_DTYPE = np.dtype([("a", "u1"), ("b", "u1"), ("age", "u1")])
+
+
+@dataclass
+class Frame:
+    """One frame. For "a5" the payload includes the A5 type header."""
+    kind: str        # "ff" (FF FF framed) or "a5" (V2 streamer)
+    cmd: int         # CMD_* or A5_* type
+    payload: bytes
+
+
+class FrameParser:
+    """Split a FF FF CMD LEN PAYLOAD CHK byte stream into frames.
+
+    feed() returns every complete, checksum-valid frame in the data so far.
+    Bytes outside frames (READY, DATA OK, ...) are collected in self.text.
+    """
+
+    def __init__(self):
+        self._buf = bytearray()
+        self.text = bytearray()
+        self.frames_ok = 0
+        self.frames_bad = 0
+
+    def feed(self, data) -> List[Frame]:
+        buf = self._buf
+        buf += data
+        out = []
+        hdr = b"\xff\xff"
+        i = 0
+        n = len(buf)
+        while True:
+            j = buf.find(hdr, i)
+            if j < 0:
+                keep = n - 1 if (n > i and buf[n - 1] == UART_HDR) else n
+                self.text += buf[i:keep]
+                i = keep
+                break
+            if j > i:
+                self.text += buf[i:j]
+            if j + 4 > n:
+                i = j
+                break
+            cmd = buf[j + 2]
+            if cmd == UART_HDR:      # FF FF FF: header starts one byte later
+                i = j + 1
+                continue
+            ln = buf[j + 3]
+            end = j + 5 + ln
+            if end > n:
+                i = j
+                break
+            if ((~sum(buf[j + 2:end - 1])) & 0xFF) == buf[end - 1]:
+                out.append(Frame("ff", cmd, bytes(buf[j + 4:end - 1])))
+                self.frames_ok += 1
+                i = end
+            else:
+                self.frames_bad += 1
+                i = j + 1
+        del buf[:i]
+        return out
+
+
+class A5Parser:
+    """Split the V2 gng.vhd A5 stream into DBG / node / edge frames."""
+
+    def __init__(self):
+        self._buf = bytearray()
+        self.frames_ok = 0
+        self.frames_bad = 0
+
+    def feed(self, data) -> List[Frame]:
+        buf = self._buf
+        buf += data
+        out = []
+        i = 0
+        n = len(buf)
+        while True:
+            j = buf.find(b"\xa5", i)
+            if j < 0:
+                i = n
+                break
+            if j + 4 > n:
+                i = j
+                break
+            t = buf[j + 1]
+            if t == A5_DBG:
+                ln = A5_DBG_LEN
+            elif t == A5_NODES:
+                ln = 4 + buf[j + 2] * A5_NODE_DTYPE.itemsize
+            elif t == A5_EDGES:
+                ln = 4 + (buf[j + 2] | (buf[j + 3] << 8)) * A5_EDGE_DTYPE.itemsize
+            elif t == A5_EDGE_BITMAP:
+                ln = 4 + (buf[j + 2] | (buf[j + 3] << 8))
+            else:
+                i = j + 1
+                continue
+            if j + ln > n:
+                i = j
+                break
+            if t == A5_DBG:
+                if buf[j + 2:j + A5_DBG_LEN:2] != A5_DBG_TAGS:
+                    self.frames_bad += 1
+                    i = j + 1
+                    continue
+            out.append(Frame("a5", t, bytes(buf[j:j + ln])))
+            self.frames_ok += 1
+            i = j + ln
+        del buf[:i]
+        return out
+
+
+# ---------------------------------------------------------------------------
+# Payload decoders (numpy views, no per-element Python loop)
+# ---------------------------------------------------------------------------
+def decode_nodes(p: bytes):
+    """CMD_GNG_NODES -> (frame_id, structured array id/x/y)."""
+    cnt = p[1]
+    return p[0], np.frombuffer(p, NODE_DTYPE, cnt, 2)
+
+
+def decode_edges(p: bytes):
+    """CMD_GNG_EDGES -> (frame_id, structured array a/b)."""
+    cnt = p[1]
+    return p[0], np.frombuffer(p, EDGE_DTYPE, cnt, 2)
+
+
+def decode_edges_chunk(p: bytes):
+    """CMD_GNG_EDGES_CHUNK -> (frame_id, chunk, n_chunks, total, pairs)."""
+    frame_id, flags, chunk, n_chunks = p[0], p[1], p[2], p[3]
+    total = p[4] | (p[5] << 8)
+    dt = EDGE16_DTYPE if (flags & 1) else EDGE_DTYPE
+    return frame_id, chunk, n_chunks, total, np.frombuffer(p, dt, p[6], 7)
+
+
+_TRIU = {}
+
+
+def _triu(n: int):
+    """(i, j) of every half-matrix bit k, i < j row-major (edge_index_ij)."""
+    if n not in _TRIU:
+        _TRIU[n] = np.triu_indices(n, 1)
+    return _TRIU[n]
+
+
+def _pairs_from_bits(k, n: int):
+    ii, jj = _triu(n)
+    k = k[k < len(ii)]
+    out = np.empty(len(k), EDGE_DTYPE)
+    out["a"] = ii[k]
+    out["b"] = jj[k]
+    return out
+
+
+def decode_edges_bitmap(p: bytes):
+    """CMD_GNG_EDGES_BITMAP -> (frame_id, structured array a/b).
+
+    flags bit 0 = gap code (byte g < 255: g zero bits then an edge, 255:
+    255 zero bits), else one bit per half-matrix cell, LSB first.
+    """
+    frame_id, n, flags = p[0], p[1], p[2]
+    data = np.frombuffer(p, np.uint8, len(p) - 3, 3)
+    if flags & 1:
+        esc = data == 255
+        adv = np.where(esc, 255, data.astype(np.int64) + 1)
+        k = (np.cumsum(adv) - 1)[~esc]
+    else:
+        k = np.flatnonzero(np.unpackbits(data, bitorder="little"))
+    return frame_id, _pairs_from_bits(k, n)
+
+
+def decode_delta(p: bytes):
+    """CMD_GNG_DELTA -> (frame_id, nodes, added, removed).
+
+    nodes["id"] bit 7 set = node removed.
+    """
+    frame_id, n_node, n_add, n_rem = p[0], p[1], p[2], p[3]
+    nodes = np.frombuffer(p, NODE_DTYPE, n_node, 4)
+    off = 4 + n_node * NODE_DTYPE.itemsize
+    pairs = np.frombuffer(p, EDGE_DTYPE, n_add + n_rem, off)
+    return frame_id, nodes, pairs[:n_add], pairs[n_add:]
+
+
+def decode_prof(p: bytes) -> dict:
+    """CMD_PROF -> dict of the fields present in this firmware's layout."""
+    n = min((len(p) - 1) // 4, len(PROF_FIELDS))
+    v = np.frombuffer(p, "<u4", n, 1)
+    d = {"frame_id": p[0]}
+    d.update({k: int(x) for k, x in zip(PROF_FIELDS, v)})
+    return d
+
+
+def decode_prof_agg(p: bytes) -> dict:
+    """CMD_PROF_AGG -> one phase of an interval: count / min / max / sum and
+    hist {b: steps with cycles in [2^b, 2^(b+1))}."""
+    fid, ph, b0, nb = p[0], p[1], p[2], p[3]
+    count, cmin, cmax, lo, hi = struct.unpack_from("<5I", p, 4)
+    h = np.frombuffer(p, "<u2", nb, 24)
+    name = PROF_AGG_PHASES[ph] if ph < len(PROF_AGG_PHASES) else f"phase{ph}"
+    return {"frame_id": fid, "phase": name, "count": count, "min": cmin, "max": cmax,
+            "sum": lo | (hi << 32), "hist": {b0 + k: int(n) for k, n in enumerate(h) if n}}
+
+
+def decode_credit(p: bytes) -> int:
+    return p[0] | (p[1] << 8)
+
+
+def decode_u32(p: bytes) -> int:
+    """CMD_BAUD_ACK (and other single u32 payloads)."""
+    return p[0] | (p[1] << 8) | (p[2] << 16) | (p[3] << 24)
+
+
+def decode_components(p: bytes):
+    """(frame_id, component count, first node, labels of nodes first..) from
+    CMD_GNG_COMPONENTS; label = lowest node index of the component, 0xFF =
+    inactive node."""
+    return p[0], p[1], p[2], np.frombuffer(p, np.uint8, count=p[3], offset=4)
+
+
+def decode_query_ack(p: bytes):
+    """(seq, first sample index, QUERY_DTYPE records); min1 is Q2.30 (1.0 = 2^30)."""
+    return p[0], p[1], np.frombuffer(p, QUERY_DTYPE, count=p[2], offset=3)
+
+
+def decode_ckpt_ack(p: bytes):
+    """CMD_CKPT_ACK -> (op, ok, seq of the newest checkpoint, 0 = none)."""
+    return p[0], bool(p[1]), decode_u32(p[2:6])
+
+
+def decode_seed_ack(p: bytes):
+    """CMD_SEED_ACK -> (ok, nodes, edges as loaded, staged edges lost)."""
+    return bool(p[0]), p[1], p[2] | (p[3] << 8), p[4]
+
+
+def decode_gen_ack(p: bytes):
+    """CMD_GEN_ACK -> (kind, seed in use, seed came from the TRNG)."""
+    return p[0], decode_u32(p[1:5]), bool(p[5])
+
+
+def decode_sd_ack(p: bytes):
+    """CMD_SD_ACK -> (op, status, card samples trained, log sectors written)."""
+    return p[0], p[1], decode_u32(p[2:6]), decode_u32(p[6:10])
+
+
+def decode_params_ack(p: bytes) -> dict:
+    """CMD_PARAMS_ACK -> {name: value} of the parameters the fw now uses."""
+    n = len(PARAM_NAMES) if len(p) >= 4 * len(PARAM_NAMES) else PARAM_BASE
+    raw = struct.unpack(f"<{n}I", bytes(p[:4 * n]))
+    return {k: (v / 65536.0 if k in PARAM_Q16 else v) for k, v in zip(PARAM_NAMES, raw)}
+
+
+def decode_remap(p: bytes):
+    """CMD_GNG_REMAP -> (frame_id, {old id: new id}); the next snapshot is a
+    keyframe with the new ids, per-node host state moves along the map."""
+    return p[0], {p[2 + 2 * k]: p[3 + 2 * k] for k in range(p[1])}
+
+
+def decode_converged(p: bytes) -> dict:
+    """CMD_CONVERGED -> step, since (first step of the quiet run), qe (float),
+    churn of the last window, action."""
+    step, since, qe, churn = struct.unpack("<4I", bytes(p[:16]))
+    return {"step": step, "since": since, "qe": qe / 2.0**30, "churn": churn, "action": p[16]}
+
+
+def decode_eval(p: bytes) -> dict:
+    """CMD_EVAL_ACK -> step, n samples swept, qe (mean distance), mse (mean
+    squared distance), te (share of s1-s2 pairs without an edge), cycles."""
+    step, n, qe, mse, te, cyc = struct.unpack("<IHIIHI", bytes(p[:20]))
+    return {"step": step, "n": n, "qe": qe / 65536.0, "mse": mse / 2.0**30,
+            "te": te / n if n else 0.0, "cycles": cyc}
+
+
+def decode_cfs_perf(p: bytes) -> dict:
+    """CMD_CFS_PERF_ACK -> {name: count} (CFS_PERF_NAMES), None if the
+    bitstream has no perf counters."""
+    if not p[0]:
+        return None
+    raw = struct.unpack(f"<{len(CFS_PERF_NAMES)}I", bytes(p[1:1 + 4 * len(CFS_PERF_NAMES)]))
+    return dict(zip(CFS_PERF_NAMES, raw))
+
+
+def decode_trace_data(p: bytes):
+    """CMD_TRACE_DATA -> (step, cycles, first, flags, [(src, dst), ...]);
+    first = index of the first pair in the step's capture."""
+    step, cycles, first, n, flags = struct.unpack("<IIHBB", bytes(p[:12]))
+    raw = struct.unpack(f"<{2 * n}I", bytes(p[13:13 + 8 * n]))
+    return step, cycles, first, flags, list(zip(raw[0::2], raw[1::2]))
+
+
+def decode_link_ack(p: bytes) -> dict:
+    """CMD_LINK_ACK -> framing (RX_FRAMING_*) and the LINK_FIELDS counters."""
+    raw = struct.unpack("<4I", bytes(p[1:17]))
+    d = dict(zip(LINK_FIELDS, raw))
+    d["framing"] = p[0]
+    return d
+
+
+def decode_stats(p: bytes) -> dict:
+    """CMD_STATS_FRAME -> {name: value} in STATS_FIELDS order (the fields
+    this firmware sends)."""
+    fmt = "<3I2H8I" if len(p) >= 48 else "<3I2H6I"
+    return dict(zip(STATS_FIELDS, struct.unpack_from(fmt, bytes(p))))
+
+
+def decode_model_ack(p: bytes) -> dict:
+    """CMD_MODEL_ACK -> models, k, view, upload target, CFS banks, slice and
+    per model (steps, samples); banks 0 = no CFS, 1 = one shared bank. hier
+    is the MODEL_OP_HIER state (False from firmware without the byte)."""
+    models, k, view, up, banks, slice_ = struct.unpack("<5BH", bytes(p[:7]))
+    per = [struct.unpack("<IH", bytes(p[7 + 6 * m:13 + 6 * m])) for m in range(models)]
+    end = 7 + 6 * models
+    return dict(models=models, k=k, view=view, up=up, banks=banks, slice=slice_,
+                steps=[s for s, _ in per], samples=[n for _, n in per],
+                hier=len(p) > end and p[end] != 0)
+
+
+def decode_a5_dbg(p: bytes) -> dict:
+    """A5 10 -> dict with the raw values plus err32 / s1x / s1y / ts."""
+    vals = np.frombuffer(p, np.uint8, A5_DBG_LEN - 3, 3)[::2]
+    d = dict(zip(A5_DBG_FIELDS, (int(x) for x in vals)))
+    d["err32"] = d["err0"] | (d["err1"] << 8) | (d["err2"] << 16) | (d["err3"] << 24)
+    d["s1x"] = int(np.int16(d["s1x_lo"] | (d["s1x_hi"] << 8)))
+    d["s1y"] = int(np.int16(d["s1y_lo"] | (d["s1y_hi"] << 8)))
+    d["ts"] = d["ts0"] | (d["ts1"] << 8) | (d["ts2"] << 16) | (d["ts3"] << 24)
+    return d
+
+
+def decode_a5_nodes(p: bytes):
+    """A5 20 -> (node_count, structured array id/act/deg/x/y of MAX_NODES)."""
+    return p[3], np.frombuffer(p, A5_NODE_DTYPE, p[2], 4)
+
+
+def decode_a5_edges(p: bytes):
+    """A5 21 -> structured array a/b/age."""
+    return np.frombuffer(p, A5_EDGE_DTYPE, p[2] | (p[3] << 8), 4)
+
+
+def decode_a5_edge_bitmap(p: bytes, max_nodes: int):
+    """A5 22 -> structured array a/b (no ages in the bitmap form)."""
+    data = np.frombuffer(p, np.uint8, p[2] | (p[3] << 8), 4)
+    return _pairs_from_bits(np.flatnonzero(np.unpackbits(data, bitorder="little")), max_nodes)
+
+
+def encode_frame(cmd: int, payload: bytes = b"") -> bytes:
+    """Build one FF FF CMD LEN PAYLOAD CHK frame (host -> board)."""
+    if len(payload) > 255:
+        raise ValueError("payload > 255 bytes")
+    chk = (~(cmd + len(payload) + sum(payload))) & 0xFF
+    return bytes((UART_HDR, UART_HDR, cmd, len(payload))) + bytes(payload) + bytes((chk,))
+
+
+def cobs_encode(data: bytes) -> bytes:
+    """Consistent overhead byte stuffing: no 00 in the result, 1 byte per
+    254 of overhead; the caller appends the 00 delimiter."""
+    out = bytearray((0,))
+    code_at, code = 0, 1
+    for b in data:
+        if b:
+            out.append(b)
+            code += 1
+        if not b or code == 0xFF:
+            out[code_at] = code
+            code_at, code = len(out), 1
+            out.append(0)
+    out[code_at] = code
+    return bytes(out)
+
+
+def to_cobs(frame: bytes) -> bytes:
+    """FF FF CMD LEN PAYLOAD CHK frame -> COBS(CMD .. CHK) 00, the host ->
+    board framing after LINK_OP_COBS."""
+    return cobs_encode(frame[2:]) + b"\0"
+
+
+def encode_link(op: int = LINK_OP_STATS, clear: bool = False) -> bytes:
+    """CMD_LINK frame (LINK_OP_*); clear restarts the counters after the ACK."""
+    return encode_frame(CMD_LINK, bytes(((op & 0x7F) | (LINK_OP_CLEAR if clear else 0),)))
+
+
+def encode_stats(ms: int = None) -> bytes:
+    """CMD_STATS frame: a CMD_STATS_FRAME every ms (0 = off), None = one now."""
+    if ms is None:
+        return encode_frame(CMD_STATS)
+    return encode_frame(CMD_STATS, struct.pack("<H", max(0, min(int(ms), 0xFFFF))))
+
+
+def encode_eval(every: int = 0) -> bytes:
+    """CMD_EVAL frame: one QE / TE sweep now, every > 0 also one per every
+    steps (0 stops them)."""
+    return encode_frame(CMD_EVAL, struct.pack("<I", max(0, int(every))))
+
+
+def encode_snap_mode(mask: int, every: int = 0, gap: int = 0,
+                     qe_pct: int = 0, ms: int = 0, io_pct: int = 0) -> bytes:
+    """CMD_SNAP_MODE frame; a 0 argument keeps the firmware's setting.
+    io_pct: SNAP_TRIG_AUTO budget, % of the cycles spent on snapshots."""
+    p = bytes((mask & 0xFF,)) + every.to_bytes(2, "little") + gap.to_bytes(2, "little")
+    p += bytes((qe_pct & 0xFF,)) + ms.to_bytes(2, "little")
+    if io_pct:
+        p += bytes((io_pct & 0xFF,))
+    return encode_frame(CMD_SNAP_MODE, p)
+
+
+def encode_converge(action: int, window: int = 0, qe_pct: int = 0,
+                    churn: int = None, windows: int = 0) -> bytes:
+    """CMD_CONVERGE frame; a 0 argument keeps the firmware's setting, churn
+    None sends the action only (all settings kept), churn 0 allows none."""
+    p = bytes((action & 0xFF,))
+    if churn is not None:
+        p += window.to_bytes(2, "little") + bytes((qe_pct & 0xFF,))
+        p += churn.to_bytes(2, "little") + bytes((windows & 0xFF,))
+    return encode_frame(CMD_CONVERGE, p)
+
+
+def encode_cfs_perf(clear: bool = False) -> bytes:
+    """CMD_CFS_PERF frame; clear restarts the counters after the read."""
+    return encode_frame(CMD_CFS_PERF, bytes((1 if clear else 0,)))
+
+
+def encode_trace(steps: int = 1) -> bytes:
+    """CMD_TRACE frame: trace the next `steps` training steps (1..255)."""
+    return encode_frame(CMD_TRACE, bytes((max(1, min(int(steps), 255)),)))
+
+
+def encode_ckpt(op: int) -> bytes:
+    """CMD_CKPT frame (CKPT_SAVE / CKPT_LOAD / CKPT_ERASE)."""
+    return encode_frame(CMD_CKPT, bytes((op & 0xFF,)))
+
+
+def encode_sd(op: int, arg: int = None) -> bytes:
+    """CMD_SD frame; arg None = fw default (1 pass / no tee)."""
+    p = bytes((op & 0xFF,)) if arg is None else bytes((op & 0xFF, arg & 0xFF))
+    return encode_frame(CMD_SD, p)
+
+
+def encode_params(params: dict = None) -> bytes:
+    """CMD_SET_PARAMS frame from the six base PARAM_NAMES, plus the drift_*
+    ones when params has all of them; None = query only."""
+    if params is None:
+        return encode_frame(CMD_SET_PARAMS)
+    names = PARAM_NAMES if all(k in params for k in PARAM_NAMES) else PARAM_NAMES[:PARAM_BASE]
+    raw = [int(round(params[k] * 65536.0)) if k in PARAM_Q16 else int(params[k])
+           for k in names]
+    return encode_frame(CMD_SET_PARAMS, struct.pack(f"<{len(raw)}I", *raw))
+
+
+def encode_model(op: int = None, arg: int = 0, slice_: int = 0) -> bytes:
+    """CMD_MODEL frame (MODEL_OP_*); op None = query, 0 arguments of RUN keep."""
+    if op is None:
+        return encode_frame(CMD_MODEL)
+    p = bytes((op & 0xFF, arg & 0xFF))
+    if op == MODEL_OP_RUN:
+        p += struct.pack("<H", slice_)
+    return encode_frame(CMD_MODEL, p)
+
+
+def encode_model_upload(sets) -> List[bytes]:
+    """One (N, D) array per model -> MODEL_OP_DATA + DATA_BATCH frames, in
+    model order (the fw appends each section to its dataset memory)."""
+    frames = []
+    for m, xy in enumerate(sets):
+        frames.append(encode_model(MODEL_OP_DATA, m))
+        frames += encode_data_batch(xy)
+    return frames
+
+
+def encode_train_mode(mode: int, order: int = None) -> bytes:
+    """CMD_TRAIN_MODE frame (TRAIN_ONLINE / TRAIN_DBL); streaming runs stay online.
+
+    order (ORDER_UPLOAD / ORDER_SHUFFLE) sets the sample order of online
+    passes, None keeps the firmware's current one.
+    """
+    p = bytes((mode & 0xFF,)) if order is None else bytes((mode & 0xFF, order & 0xFF))
+    return encode_frame(CMD_TRAIN_MODE, p)
+
+
+def encode_data_batch(xy: np.ndarray) -> List[bytes]:
+    """(N, D) float array in dataset units -> DATA_BATCH frames (252 // 2D
+    points max: 63 for 2D). D must be the firmware's GNG_DIM."""
+    wire = np.round(np.asarray(xy, dtype=np.float64) * 1000.0).astype("<i2")
+    per = 252 // (2 * wire.shape[1])
+    frames = []
+    for k in range(0, len(wire), per):
+        part = wire[k:k + per]
+        frames.append(encode_frame(CMD_DATA_BATCH, bytes((len(part),)) + part.tobytes()))
+    return frames
+
+
+def encode_query(xy: np.ndarray, seq: int = 0, labels: bool = False) -> List[bytes]:
+    """(N, D) float array in dataset units -> CMD_QUERY frames (253 // 2D points
+    each: 63 for 2D); seq counts up from seq (mod 256) frame by frame."""
+    wire = np.round(np.asarray(xy, dtype=np.float64) * 1000.0).astype("<i2")
+    per = 253 // (2 * wire.shape[1])
+    flags = QUERY_LABEL if labels else 0
+    frames = []
+    for k in range(0, len(wire), per):
+        hdr = bytes(((seq + k // per) & 0xFF, flags))
+        frames.append(encode_frame(CMD_QUERY, hdr + wire[k:k + per].tobytes()))
+    return frames
+
+
+def encode_seed(ids: np.ndarray, xy: np.ndarray, edges: np.ndarray) -> List[bytes]:
+    """Network -> CMD_SEED frames BEGIN, NODES.., EDGES.., COMMIT. ids are
+    node slots (< MAX_NODES), xy the (N, D) positions in dataset units, edges
+    (E, 2) pairs of slots; runs of consecutive ids share a NODES frame."""
+    ids = np.asarray(ids, dtype=np.int64)
+    wire = np.round(np.asarray(xy, dtype=np.float64) * 1000.0).astype("<i2")
+    per = (SEED_FRAME_MAX - 3) // (2 * wire.shape[1])
+    frames = [encode_frame(CMD_SEED, bytes((SEED_OP_BEGIN,)))]
+    order = np.argsort(ids, kind="stable")
+    k = 0
+    while k < len(order):
+        n = 1
+        while (n < per and k + n < len(order)
+               and ids[order[k + n]] == ids[order[k]] + n):
+            n += 1
+        run = order[k:k + n]
+        hdr = bytes((SEED_OP_NODES, int(ids[run[0]]) & 0xFF, n))
+        frames.append(encode_frame(CMD_SEED, hdr + wire[run].tobytes()))
+        k += n
+    pairs = np.asarray(edges, dtype=np.uint8).reshape(-1, 2)
+    per = (SEED_FRAME_MAX - 2) // 2
+    for k in range(0, len(pairs), per):
+        part = pairs[k:k + per]
+        frames.append(encode_frame(CMD_SEED, bytes((SEED_OP_EDGES, len(part))) + part.tobytes()))
+    frames.append(encode_frame(CMD_SEED, bytes((SEED_OP_COMMIT,))))
+    return frames
+
+
+def encode_gen(kind: int, seed: int = 0) -> bytes:
+    """CMD_GEN: train on generator kind (GEN_OFF = back to the dataset);
+    seed 0 = fresh one from the board's TRNG (reported in CMD_GEN_ACK)."""
+    p = bytes((kind & 0xFF,))
+    if seed:
+        p += (seed & 0xFFFFFFFF).to_bytes(4, "little")
+    return encode_frame(CMD_GEN, p)
+
+
+def parser_for(kind: str):
+    """'ff' -> FrameParser, 'a5' -> A5Parser."""
+    return {"ff": FrameParser, "a5": A5Parser}[kind]()
@@ -0,0 +1,338 @@
+"""
+Background serial reader
+========================
+
+A thread does nothing but serial.read() in large chunks, so the OS buffer
+is emptied even while the GUI or the metrics code is busy. The chunks are
+optionally recorded, then split into frames and put on a queue. The
+consumer takes frames with get() / frames(), or with async for in asyncio
+(aframes()).
+"""
+
+import asyncio
+import queue
+import threading
+import time
+from typing import Iterator, Optional
+
+import numpy as np
+
+from .protocol import (CMD_BAUD_ACK, CMD_CFS_PERF_ACK, CMD_CKPT_ACK, CMD_LINK_ACK, CMD_MODEL_ACK,
+                       CMD_PARAMS_ACK, CMD_QUERY_ACK, CMD_SD_ACK, CMD_SET_BAUD, CMD_TRACE_DATA,
+                       LINK_OP_COBS, QUERY_DTYPE, TRACE_LAST, TRACE_NONE, Frame, FrameParser,
+                       decode_cfs_perf, decode_ckpt_ack, decode_link_ack, decode_model_ack,
+                       decode_params_ack, decode_query_ack, decode_sd_ack, decode_trace_data,
+                       decode_u32, encode_cfs_perf, encode_ckpt, encode_frame, encode_link,
+                       encode_model, encode_params, encode_query, encode_sd, encode_trace,
+                       parser_for, to_cobs)
+from .recorder import Recorder
+
+READ_CHUNK = 4096
+
+
+def set_baud(ser, baud: int, timeout: float = 1.0) -> int:
+    """Ask the fw (CMD_SET_BAUD) for a new UART rate; switch the port on ACK.
+
+    Returns the rate both sides now use (the fw reports the rate its divider
+    really makes, e.g. 3375000 for 3 M at 27 MHz), or 0 if it was refused.
+    Call it before the SerialReader thread is started.
+    """
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    ser.write(encode_frame(CMD_SET_BAUD, int(baud).to_bytes(4, "little")))
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd == CMD_BAUD_ACK and len(fr.payload) >= 4:
+                actual = decode_u32(fr.payload)
+                if actual:
+                    time.sleep(0.01)   # fw drains and reprograms UART0
+                    ser.baudrate = actual
+                return actual
+    return 0
+
+
+def checkpoint(ser, op: int, timeout: float = 3.0):
+    """Run a CMD_CKPT op (protocol.CKPT_*) and wait for its ACK.
+
+    Returns (ok, seq), (False, 0) on timeout. A save or erase blocks the fw
+    for ~120 ms per flash page, nothing else should be sent meanwhile. Call
+    it before the SerialReader thread is started.
+    """
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    ser.write(encode_ckpt(op))
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd == CMD_CKPT_ACK and len(fr.payload) >= 6:
+                r_op, ok, seq = decode_ckpt_ack(fr.payload)
+                if r_op == op:
+                    return ok, seq
+    return False, 0
+
+
+def sd_command(ser, op: int, arg: int = None, timeout: float = 2.0):
+    """Run a CMD_SD op (protocol.SD_OP_*) and wait for its ACK.
+
+    Returns (status, samples, log sectors), status -1 on timeout. A card run
+    also sends an SD_OP_STOP ACK by itself when its last pass is done. Call
+    it before the SerialReader thread is started.
+    """
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    ser.write(encode_sd(op, arg))
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd == CMD_SD_ACK and len(fr.payload) >= 10:
+                r_op, status, samples, sectors = decode_sd_ack(fr.payload)
+                if r_op == op:
+                    return status, samples, sectors
+    return -1, 0, 0
+
+
+def set_params(ser, params: dict = None, timeout: float = 1.0):
+    """Set GNG parameters (CMD_SET_PARAMS) between two steps, no reflash.
+
+    params maps protocol.PARAM_NAMES to values (rates as floats, e.g.
+    {"eps_b": 0.2}); missing names keep their current value, None only
+    queries. Returns the values the fw uses after clamping, None on timeout.
+    Call it before the SerialReader thread is started.
+    """
+    def xfer(frame):
+        parser = FrameParser()
+        ser.reset_input_buffer()
+        ser.write(frame)
+        t_end = time.time() + timeout
+        while time.time() < t_end:
+            for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+                if fr.cmd == CMD_PARAMS_ACK and len(fr.payload) >= 24:
+                    return decode_params_ack(fr.payload)
+        return None
+
+    cur = xfer(encode_params())
+    if cur is None or not params:
+        return cur
+    unknown = set(params) - set(cur)
+    if unknown:
+        raise ValueError(f"unknown GNG parameter(s): {', '.join(sorted(unknown))}")
+    return xfer(encode_params({**cur, **params}))
+
+
+def model_command(ser, op: int = None, arg: int = 0, slice_: int = 0, timeout: float = 1.0):
+    """Run a CMD_MODEL op (protocol.MODEL_OP_*, None = query) and wait for its ACK.
+
+    Returns the decode_model_ack() dict, None on timeout (fw built with
+    GNG_MODELS=1). Call it before the SerialReader thread is started.
+    """
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    ser.write(encode_model(op, arg, slice_))
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd == CMD_MODEL_ACK and len(fr.payload) >= 7:
+                return decode_model_ack(fr.payload)
+    return None
+
+
+def cfs_perf(ser, clear: bool = False, timeout: float = 1.0):
+    """Read the CFS perf counters (CMD_CFS_PERF), one frozen set.
+
+    Returns (answered, counters): counters is the decode_cfs_perf() dict,
+    None on a bitstream without them; answered is False on timeout (fw
+    built with CFS_PERF=0 or GNG_CFS=0). Call it before the SerialReader
+    thread is started.
+    """
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    ser.write(encode_cfs_perf(clear))
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd == CMD_CFS_PERF_ACK and len(fr.payload) >= 1:
+                return True, decode_cfs_perf(fr.payload)
+    return False, None
+
+
+def link(ser, op: int, clear: bool = False, cobs: bool = False, timeout: float = 1.0):
+    """CMD_LINK: read the RX counters (LINK_OP_STATS) or switch the host ->
+    board framing (LINK_OP_LEGACY / LINK_OP_COBS).
+
+    cobs = the board expects COBS frames now. Returns the decode_link_ack()
+    dict (the counters from before a clear), None on timeout (fw without
+    CMD_LINK). After a switch to COBS a 00 is sent, the parser waits for one.
+    Call it before the SerialReader thread is started.
+    """
+    frame = encode_link(op, clear)
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    ser.write(to_cobs(frame) if cobs else frame)
+    t_end = time.time() + timeout
+    while time.time() < t_end:
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd == CMD_LINK_ACK and len(fr.payload) >= 17:
+                if op == LINK_OP_COBS:
+                    ser.write(b"\0")
+                return decode_link_ack(fr.payload)
+    return None
+
+
+def trace_capture(ser, steps: int = 1, timeout: float = 5.0):
+    """Trace the next `steps` training steps (CMD_TRACE) and collect them.
+
+    Returns a list of (step, cycles, [(src, dst), ...]) in capture order,
+    shorter than `steps` on timeout (training not running, fw built with
+    GNG_TRACE=0), None when the bitstream has no tracer. Other frames are
+    dropped. Call it before the SerialReader thread is started.
+    """
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    ser.write(encode_trace(steps))
+    out, pairs = [], []
+    t_end = time.time() + timeout
+    while time.time() < t_end and len(out) < steps:
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd != CMD_TRACE_DATA or len(fr.payload) < 13:
+                continue
+            step, cycles, first, flags, rec = decode_trace_data(fr.payload)
+            if flags & TRACE_NONE:
+                return None
+            if first == 0:
+                pairs = []
+            pairs += rec
+            if flags & TRACE_LAST:
+                out.append((step, cycles, pairs))
+                pairs = []
+                t_end = time.time() + timeout
+    return out
+
+
+def query(ser, xy, labels: bool = False, window: int = 2, timeout: float = 1.0,
+          retries: int = 3):
+    """Nearest-node lookup (CMD_QUERY) of every row of xy on the trained network.
+
+    Keeps `window` query frames in flight (the fw buffers 2) and sends a
+    frame again when its answers are late. Returns (QUERY_DTYPE array in xy
+    order, seconds from the first frame to the last answer). Call it before
+    the SerialReader thread is started.
+    """
+    xy = np.asarray(xy)
+    frames = encode_query(xy, 0, labels)
+    per = 253 // (2 * xy.shape[1])
+    out = np.zeros(len(xy), QUERY_DTYPE)
+    got = {}        # frame in flight -> {first: n} of its ACK frames
+    sent = {}       # frame in flight -> (last write, writes)
+    parser = FrameParser()
+    ser.reset_input_buffer()
+    t0 = time.time()
+    nxt = done = 0
+    while done < len(frames):
+        while nxt < len(frames) and len(sent) < window:
+            ser.write(frames[nxt])
+            sent[nxt], got[nxt] = (time.time(), 1), {}
+            nxt += 1
+        for q, (t, w) in list(sent.items()):
+            if time.time() - t > timeout:
+                if w > retries:
+                    raise RuntimeError(f"query: no answer to frame {q} (fw without CMD_QUERY?)")
+                ser.write(frames[q])
+                sent[q] = (time.time(), w + 1)
+        for fr in parser.feed(ser.read(max(1, ser.in_waiting))):
+            if fr.cmd != CMD_QUERY_ACK or len(fr.payload) < 3:
+                continue
+            seq, first, rec = decode_query_ack(fr.payload)
+            q = next((q for q in sent if q & 0xFF == seq), None)
+            if q is None:
+                continue
+            out[q * per + first:q * per + first + len(rec)] = rec
+            got[q][first] = len(rec)
+            if sum(got[q].values()) >= min(per, len(xy) - q * per):
+                del sent[q], got[q]
+                done += 1
+    return out, time.time() - t0
+
+
+class SerialReader(threading.Thread):
+    def __init__(self, port: str, baud: int = 1_000_000, kind: str = "ff",
+                 record: Optional[str] = None, maxsize: int = 0, ser=None):
+        super().__init__(daemon=True)
+        if ser is None:
+            import serial
+            ser = serial.Serial(port, baud, timeout=0.05)
+        self.ser = ser
+        self.parser = parser_for(kind)
+        self.recorder = Recorder(record, baud, kind) if record else None
+        self.q: "queue.Queue[Frame]" = queue.Queue(maxsize)
+        self.bytes_in = 0
+        self.frames_dropped = 0  # queue full (consumer too slow)
+        self._stop_evt = threading.Event()
+        self._lock = threading.Lock()     # parser.text is shared with text()
+
+    # ---- producer thread ----
+    def run(self):
+        ser = self.ser
+        while not self._stop_evt.is_set():
+            data = ser.read(max(READ_CHUNK, ser.in_waiting))
+            if not data:
+                continue
+            self.bytes_in += len(data)
+            if self.recorder:
+                self.recorder.write(data, time.monotonic_ns())
+            with self._lock:
+                frames = self.parser.feed(data)
+            for fr in frames:
+                try:
+                    self.q.put_nowait(fr)
+                except queue.Full:
+                    self.frames_dropped += 1
+        if self.recorder:
+            self.recorder.close()
+
+    def stop(self):
+        self._stop_evt.set()
+        self.join(timeout=1.0)
+        self.ser.close()
+
+    # ---- consumer side ----
+    def write(self, data: bytes):
+        self.ser.write(data)
+
+    def get(self, timeout: Optional[float] = None) -> Optional[Frame]:
+        try:
+            return self.q.get(timeout=timeout)
+        except queue.Empty:
+            return None
+
+    def drain(self) -> list:
+        """All frames queued right now (non-blocking), e.g. once per GUI tick."""
+        out = []
+        while True:
+            try:
+                out.append(self.q.get_nowait())
+            except queue.Empty:
+                return out
+
+    def frames(self) -> Iterator[Frame]:
+        while self.is_alive() or not self.q.empty():
+            fr = self.get(timeout=0.1)
+            if fr is not None:
+                yield fr
+
+    def text(self) -> str:
+        """Non-frame bytes received so far (READY, DATA OK, ...), then cleared."""
+        with self._lock:
+            t = getattr(self.parser, "text", None)
+            if not t:
+                return ""
+            s = t.decode("ascii", errors="ignore")
+            t.clear()
+        return s
+
+    async def aframes(self):
+        loop = asyncio.get_running_loop()
+        while self.is_alive() or not self.q.empty():
+            fr = await loop.run_in_executor(None, self.get, 0.1)
+            if fr is not None:
+                yield fr
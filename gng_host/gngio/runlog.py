@@ -0,0 +1,235 @@
+"""
+Columnar run log of the V2 dataset logger
+=========================================
+
+V2_dataset.pde writes one log set per dataset send. Each file is
+append-only with fixed-size records behind a 16-byte header, so numpy maps
+it as it is (np.memmap) and record k sits at 16 + k * size:
+
+    header : b"GNGB" + u16 version + u16 record size + u32 unix start + 4s kind
+
+    dataset_<ts>.bin    "dset"  x, y (f32, normalized) | x_int, y_int | label
+    gng_dbg_<ts>.bin    "dbg "  one A5 DBG frame (DBG_DTYPE)
+    gng_nodes_<ts>.bin  "node"  id, act, deg, x_int, y_int, snapshots back to back
+    gng_edges_<ts>.bin  "edge"  a, b, age_stored (age + 1), snapshots back to back
+    gng_snap_<ts>.bin   "snap"  snapshot index: first record and count in the
+                                node / edge files, FPGA timestamp, DBG count
+
+A snapshot's index record is written after its node and edge records, so
+a reader that maps a log still being written sees whole snapshots only
+(a torn record at the end is cut off). Seeking snapshot k is one index
+lookup plus two slices.
+
+    log = open_log(LOGS_PATH)               # latest set, CSV sets too
+    log.dataset["x"], log.dataset["y"]      # (N,) float32
+    ids, xy, edges = log.active(log.n_snaps - 1)
+
+CsvLog reads the older CSV sets into the same interface (parsed eagerly);
+python -m gngio.runlog <logs> [ts ...] converts them to the binary layout.
+"""
+
+import csv
+import glob
+import os
+import sys
+
+import numpy as np
+
+MAGIC = b"GNGB"
+VERSION = 1
+HEADER = 16
+
+HEADER_DTYPE = np.dtype([("magic", "S4"), ("version", "<u2"), ("rec_size", "<u2"),
+                         ("t0", "<u4"), ("kind", "S4")])
+
+DSET_DTYPE = np.dtype([("x", "<f4"), ("y", "<f4"), ("x_int", "<i2"), ("y_int", "<i2"),
+                       ("label", "u1"), ("pad", "u1", 3)])
+# flags: b0 conn, b1 rm, b2 iso, b3 ins
+DBG_DTYPE = np.dtype([("sample", "u1"), ("s1", "u1"), ("s2", "u1"), ("deg_s1", "u1"),
+                      ("deg_s2", "u1"), ("node_count", "u1"), ("flags", "u1"),
+                      ("iso_id", "u1"), ("ins_id", "u1"), ("pad", "u1", 3),
+                      ("err32", "<u4"), ("s1x", "<i2"), ("s1y", "<i2"),
+                      ("fpga_ts", "<u4"), ("host_ms", "<u4"), ("iter_us", "<f4")])
+NODE_DTYPE = np.dtype([("id", "u1"), ("act", "u1"), ("deg", "u1"), ("pad", "u1"),
+                       ("x_int", "<i2"), ("y_int", "<i2")])
+EDGE_DTYPE = np.dtype([("a", "u1"), ("b", "u1"), ("age_stored", "u1"), ("pad", "u1")])
+SNAP_DTYPE = np.dtype([("snap_idx", "<u4"), ("node_off", "<u4"), ("edge_off", "<u4"),
+                       ("node_n", "<u2"), ("edge_n", "<u2"), ("fpga_ts", "<u4"),
+                       ("dbg_n", "<u4"), ("host_ms", "<u4"), ("pad", "<u4")])
+
+FILES = {  # attribute: (file prefix, kind, dtype)
+    "dataset": ("dataset", b"dset", DSET_DTYPE),
+    "dbg": ("gng_dbg", b"dbg ", DBG_DTYPE),
+    "nodes": ("gng_nodes", b"node", NODE_DTYPE),
+    "edges": ("gng_edges", b"edge", EDGE_DTYPE),
+    "snaps": ("gng_snap", b"snap", SNAP_DTYPE),
+}
+
+SCALE = 1000.0  # x_int / y_int units
+
+
+def mapfile(path: str, kind: bytes, dtype: np.dtype) -> np.ndarray:
+    """Read-only record array of a log file, whole records only."""
+    size = os.path.getsize(path)
+    with open(path, "rb") as f:
+        raw = f.read(HEADER)
+    hdr = np.frombuffer(raw, HEADER_DTYPE) if len(raw) == HEADER else np.zeros(0, HEADER_DTYPE)
+    if len(hdr) == 0 or hdr["magic"][0] != MAGIC or hdr["kind"][0] != kind:
+        raise ValueError(f"{path}: not a GNGB '{kind.decode()}' file")
+    if hdr["version"][0] != VERSION or hdr["rec_size"][0] != dtype.itemsize:
+        raise ValueError(f"{path}: version {hdr['version'][0]} / record size {hdr['rec_size'][0]}")
+    n = (size - HEADER) // dtype.itemsize
+    if n == 0:
+        return np.zeros(0, dtype)
+    return np.memmap(path, dtype, "r", HEADER, (n,))
+
+
+def find_latest(logs_path: str) -> str:
+    """Timestamp of the newest log set (binary or CSV)."""
+    files = glob.glob(os.path.join(logs_path, "dataset_*.bin")) + \
+        glob.glob(os.path.join(logs_path, "dataset_*.csv"))
+    if not files:
+        raise FileNotFoundError(f"No dataset_*.bin / dataset_*.csv in {logs_path}")
+    return max(os.path.splitext(os.path.basename(f))[0][len("dataset_"):] for f in files)
+
+
+def open_log(logs_path: str, ts: str = None):
+    """RunLog of a binary set, CsvLog of an older CSV set."""
+    ts = ts or find_latest(logs_path)
+    if os.path.exists(os.path.join(logs_path, f"dataset_{ts}.bin")):
+        return RunLog(logs_path, ts)
+    return CsvLog(logs_path, ts)
+
+
+class _Log:
+    """Shared snapshot accessors; subclasses fill dataset / dbg / snaps."""
+
+    def __init__(self, logs_path: str, ts: str):
+        self.ts = ts
+        meta = os.path.join(logs_path, f"meta_{ts}.txt")
+        self.name = "Unknown"
+        if os.path.exists(meta):
+            with open(meta) as f:
+                self.name = f.readline().strip() or self.name
+
+    @property
+    def n_snaps(self) -> int:
+        return len(self.snaps)
+
+    def active(self, k: int):
+        """(ids, (M, 2) normalized positions, (K, 2) id pairs) of snapshot k."""
+        nodes, edges = self.snapshot(k)
+        a = nodes[nodes["act"] != 0]
+        xy = np.column_stack((a["x_int"], a["y_int"])) / SCALE
+        return a["id"].astype(np.intp), xy, np.column_stack((edges["a"], edges["b"]))
+
+
+class RunLog(_Log):
+    """Memory-mapped binary log set, see module doc."""
+
+    def __init__(self, logs_path: str, ts: str):
+        super().__init__(logs_path, ts)
+        for attr, (prefix, kind, dtype) in FILES.items():
+            setattr(self, attr, mapfile(os.path.join(logs_path, f"{prefix}_{ts}.bin"), kind, dtype))
+        # a snapshot whose node / edge records were cut off is not complete
+        s = self.snaps
+        ok = (s["node_off"].astype(np.int64) + s["node_n"] <= len(self.nodes)) & \
+             (s["edge_off"].astype(np.int64) + s["edge_n"] <= len(self.edges))
+        self.snaps = s[:int(np.argmin(ok)) if not ok.all() else len(s)]
+
+    def snapshot(self, k: int):
+        """(nodes, edges) record arrays of snapshot k (views into the maps)."""
+        s = self.snaps[k]
+        n0, e0 = int(s["node_off"]), int(s["edge_off"])
+        return self.nodes[n0:n0 + int(s["node_n"])], self.edges[e0:e0 + int(s["edge_n"])]
+
+
+class CsvLog(_Log):
+    """CSV log set of older V2_dataset.pde versions behind the RunLog interface."""
+
+    def __init__(self, logs_path: str, ts: str):
+        super().__init__(logs_path, ts)
+
+        def rows(prefix):
+            with open(os.path.join(logs_path, f"{prefix}_{ts}.csv"), newline="") as f:
+                return list(csv.DictReader(f))
+
+        ds = rows("dataset")
+        self.dataset = np.zeros(len(ds), DSET_DTYPE)
+        for k, r in enumerate(ds):
+            self.dataset[k] = (float(r["x_norm"]), float(r["y_norm"]), int(r["x_int"]),
+                               int(r["y_int"]), int(r["label"]), (0, 0, 0))
+
+        dbg = []
+        for r in rows("gng_dbg"):
+            try:
+                flags = int(r["conn"]) | int(r["rm"]) << 1 | int(r["iso"]) << 2 | int(r["ins"]) << 3
+                dbg.append((int(r["sample_idx"]), int(r["s1"]), int(r["s2"]), int(r["deg_s1"]),
+                            int(r["deg_s2"]), int(r["node_count"]), flags, int(r["iso_id"]),
+                            int(r["ins_id"]), (0, 0, 0), int(r["err32"]), int(r["s1x_raw"]),
+                            int(r["s1y_raw"]), int(r["fpga_ts_cycles"]), 0, float(r["iter_us"])))
+            except (TypeError, ValueError):
+                pass
+        self.dbg = np.array(dbg, DBG_DTYPE)
+
+        nodes, fts = {}, {}
+        for r in rows("gng_nodes"):
+            sid = int(r["snap_idx"])
+            nodes.setdefault(sid, []).append((int(r["node_id"]), int(r["active"]), int(r["degree"]),
+                                              0, int(r["x_int"]), int(r["y_int"])))
+            if r.get("fpga_ts_cycles"):
+                fts.setdefault(sid, int(r["fpga_ts_cycles"]))
+        edges = {}
+        for r in rows("gng_edges"):
+            edges.setdefault(int(r["snap_idx"]), []).append(
+                (int(r["node_a"]), int(r["node_b"]), int(r["age_stored"]), 0))
+        sids = sorted(nodes)
+        self.snaps = np.zeros(len(sids), SNAP_DTYPE)
+        self.snaps["snap_idx"] = sids
+        self.snaps["fpga_ts"] = [fts.get(s, 0) for s in sids]
+        self._nodes = [np.array(nodes[s], NODE_DTYPE) for s in sids]
+        self._edges = [np.array(edges.get(s, []), EDGE_DTYPE) for s in sids]
+
+    def snapshot(self, k: int):
+        return self._nodes[k], self._edges[k]
+
+
+def write_csv_as_bin(logs_path: str, ts: str):
+    """Convert a CSV log set into the binary layout (same timestamp)."""
+    src = CsvLog(logs_path, ts)
+    t0 = 0
+
+    def out(attr, records):
+        prefix, kind, dtype = FILES[attr]
+        hdr = np.array([(MAGIC, VERSION, dtype.itemsize, t0, kind)], HEADER_DTYPE)
+        with open(os.path.join(logs_path, f"{prefix}_{ts}.bin"), "wb") as f:
+            f.write(hdr.tobytes())
+            f.write(np.asarray(records, dtype).tobytes())
+
+    snaps = src.snaps.copy()
+    nodes, edges = [], []
+    n_off = e_off = 0
+    for k in range(src.n_snaps):
+        nd, ed = src.snapshot(k)
+        snaps["node_off"][k], snaps["node_n"][k] = n_off, len(nd)
+        snaps["edge_off"][k], snaps["edge_n"][k] = e_off, len(ed)
+        nodes.append(nd)
+        edges.append(ed)
+        n_off += len(nd)
+        e_off += len(ed)
+    out("dataset", src.dataset)
+    out("dbg", src.dbg)
+    out("nodes", np.concatenate(nodes) if nodes else np.zeros(0, NODE_DTYPE))
+    out("edges", np.concatenate(edges) if edges else np.zeros(0, EDGE_DTYPE))
+    out("snaps", snaps)
+
+
+if __name__ == "__main__":
+    if len(sys.argv) < 2:
+        sys.exit("usage: python -m gngio.runlog <logs dir> [timestamp ...]  (default: all CSV sets)")
+    logs = sys.argv[1]
+    stamps = sys.argv[2:] or sorted(os.path.basename(f)[len("dataset_"):-len(".csv")]
+                                    for f in glob.glob(os.path.join(logs, "dataset_*.csv")))
+    for st in stamps:
+        write_csv_as_bin(logs, st)
+        print(f"{st}: {RunLog(logs, st).n_snaps} snapshots")
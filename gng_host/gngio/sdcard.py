@@ -0,0 +1,69 @@
+"""
+TF card files of the V3 firmware (SD_CARD=1)
+============================================
+
+The card is FAT32 with two files in the root, both written on the PC:
+
+    GNGDATA.BIN   samples, 4 bytes each: x, y int16 LE in 1/1000 units
+                  (the CMD_DATA_BATCH sample), any number of them
+    GNGLOG.BIN    preallocated frame log (Petit FatFs cannot grow a file)
+
+The firmware fills the log with the frames it would send on the wire,
+starting at sector 1, with zeros between them. Sector 0 is its header:
+
+    b"GNGL" + u32 version + u32 frame sectors + u32 samples trained
+
+A run that did not stop (power cut) leaves sectors = 0. read_log() then
+parses the whole file, and a fresh alloc_log() file keeps stale frames out.
+
+    write_dataset("E:/GNGDATA.BIN", xy)     # (N, 2) floats, dataset units
+    alloc_log("E:/GNGLOG.BIN", 64)          # 64 MB of zeros
+    hdr, frames = read_log("E:/GNGLOG.BIN")
+"""
+
+import os
+
+import numpy as np
+
+from .protocol import FrameParser
+
+SECTOR = 512
+LOG_MAGIC = b"GNGL"
+LOG_HDR_DTYPE = np.dtype([("magic", "S4"), ("version", "<u4"), ("sectors", "<u4"),
+                          ("samples", "<u4")])
+
+
+def write_dataset(path: str, xy: np.ndarray):
+    """(N, 2) float array in dataset units -> GNGDATA.BIN records."""
+    wire = np.round(np.asarray(xy, dtype=np.float64) * 1000.0).astype("<i2")
+    with open(path, "wb") as f:
+        f.write(wire.reshape(-1, 2).tobytes())
+
+
+def alloc_log(path: str, mb: int):
+    """Zero-filled log file of mb megabytes."""
+    with open(path, "wb") as f:
+        f.truncate(mb * 1024 * 1024)
+
+
+def read_log(path: str, chunk: int = 1 << 20):
+    """(header dict, frames) of a card log; header None for a blank file."""
+    size = os.path.getsize(path)
+    with open(path, "rb") as f:
+        raw = f.read(SECTOR)
+        hdr = np.frombuffer(raw, LOG_HDR_DTYPE, 1)[0] if len(raw) == SECTOR else None
+        if hdr is None or hdr["magic"] != LOG_MAGIC:
+            return None, []
+        info = {k: int(hdr[k]) for k in ("version", "sectors", "samples")}
+        end = SECTOR * (1 + info["sectors"]) if info["sectors"] else size
+        parser = FrameParser()
+        frames = []
+        pos = SECTOR
+        while pos < end:
+            data = f.read(min(chunk, end - pos))
+            if not data:
+                break
+            frames += parser.feed(data)
+            parser.text.clear()          # the zero fill between frames
+            pos += len(data)
+    return info, frames
@@ -0,0 +1,238 @@
+"""
+Data-parallel training on several boards
+========================================
+
+One dataset, N V3 boards on their own UARTs. Each board gets a random
+shard (so every shard covers the whole distribution at 1/N density, at
+most MAXPTS samples, the board's upload limit) and trains on it on its
+own; the host only listens. Every `round` seconds the newest complete
+NODES + EDGES snapshot of each board is merged into one network, which
+goes back to every board with CMD_SEED; the boards train on from it
+between two steps, no reset and no re-upload.
+
+Merge (merge()):
+
+- the node sets are pooled and clustered greedily, board by board: a
+  node joins the nearest cluster centre within `radius` that holds no
+  node of its own board yet, else it starts a cluster (one board's nodes
+  never collapse into each other, so a board's resolution survives);
+  centre = mean of the members
+- radius default: half the median edge length of the pooled snapshots
+- while there are more clusters than MAX_NODES, the two closest centres
+  are merged (member-weighted mean)
+- edges: union of the boards' edges, mapped onto the clusters; an edge
+  inside one cluster drops out
+- node errors go back as 0 and edges at age 0 (CMD_SEED does that), so
+  the next insertions follow what the boards see after the merge
+
+Throughput is the sum of the boards' PROF step counters over host time;
+the merged network is scored (QE / TE, suite.score) on the full dataset
+after every round. With a GNG_SMP or COBS link the seed frames stay
+within SMP_CMD_MAX and legacy FF FF framing, which every build accepts.
+
+Snapshots carry x / y only: 2D builds (GNG_DIM=2). --max-nodes must be
+the build's MAX_NODES (main.c default 20, preset.mk; slots at and above
+it are dropped by the firmware, the ACK counts what was loaded).
+
+    python -m gngio shard /dev/ttyUSB0 /dev/ttyUSB1 --dataset circles --rounds 5 --round 4
+    python -m gngio shard /dev/pts/3 /dev/pts/5 --max-nodes 40 --out merged.npz
+"""
+
+import time
+
+import numpy as np
+
+from . import protocol as P
+from .bench import APP_BAUD, _Link, load_dataset
+from .suite import _Snapshot, score
+
+MAXPTS = 1000  # V3 main.c dataset upload limit (2D)
+
+
+def split(data: np.ndarray, n: int, seed: int = 1, maxpts: int = MAXPTS) -> list:
+    """n random shards of data, maxpts samples at most each."""
+    perm = np.random.default_rng(seed).permutation(len(data))
+    return [data[part[:maxpts]] for part in np.array_split(perm, n)]
+
+
+def merge(models, max_nodes: int, radius: float = None):
+    """Board snapshots [(ids, xy, edges), ...] -> (xy, edges) of one network.
+
+    edges are node id pairs of the snapshot; the result has at most
+    max_nodes nodes numbered 0.., edges as index pairs into xy.
+    """
+    pos, board, pairs = [], [], []
+    for m, (ids, xy, edges) in enumerate(models):
+        lut = {int(i): len(pos) + k for k, i in enumerate(ids)}
+        pos += list(np.asarray(xy, dtype=np.float64))
+        board += [m] * len(ids)
+        pairs += [(lut[int(a)], lut[int(b)]) for a, b in edges
+                  if int(a) in lut and int(b) in lut]
+    if not pos:
+        return np.zeros((0, 2)), np.zeros((0, 2), dtype=np.int64)
+    pos = np.array(pos)
+    if radius is None:
+        lens = [np.linalg.norm(pos[a] - pos[b]) for a, b in pairs]
+        radius = 0.5 * float(np.median(lens)) if lens else 0.0
+
+    # greedy radius clustering, one board after the other
+    centre, count, boards = [], [], []
+    label = np.zeros(len(pos), dtype=np.int64)
+    for k, p in enumerate(pos):
+        best, best_d = -1, radius
+        if centre:
+            d = np.linalg.norm(np.array(centre) - p, axis=1)
+            for c in np.argsort(d):
+                if d[c] > best_d:
+                    break
+                if board[k] not in boards[c]:
+                    best = int(c)
+                    break
+        if best < 0:
+            centre.append(p.copy())
+            count.append(1)
+            boards.append({board[k]})
+            best = len(centre) - 1
+        else:
+            count[best] += 1
+            centre[best] += (p - centre[best]) / count[best]
+            boards[best].add(board[k])
+        label[k] = best
+
+    # down to max_nodes: merge the two closest centres
+    centre = np.array(centre)
+    count = np.array(count, dtype=np.float64)
+    alive = np.ones(len(centre), dtype=bool)
+    remap = np.arange(len(centre))
+    d = np.linalg.norm(centre[:, None, :] - centre[None, :, :], axis=2)
+    np.fill_diagonal(d, np.inf)
+    while alive.sum() > max_nodes:
+        a, b = np.unravel_index(np.argmin(d), d.shape)
+        a, b = min(a, b), max(a, b)
+        centre[a] = (centre[a] * count[a] + centre[b] * count[b]) / (count[a] + count[b])
+        count[a] += count[b]
+        alive[b] = False
+        remap[remap == b] = a
+        d[b, :] = d[:, b] = np.inf
+        d[a, :] = d[:, a] = np.where(alive, np.linalg.norm(centre - centre[a], axis=1), np.inf)
+        d[a, a] = np.inf
+
+    index = np.cumsum(alive) - 1   # surviving clusters numbered 0..
+    label = index[remap[label]]
+    edges = {(min(la, lb), max(la, lb)) for la, lb in ((label[a], label[b]) for a, b in pairs)
+             if la != lb}
+    return centre[alive], np.array(sorted(edges), dtype=np.int64).reshape(-1, 2)
+
+
+class _Board:
+    """One board: reader thread, last keyframe, PROF steps, pending seed."""
+
+    def __init__(self, port: str, baud: int):
+        import serial
+        from .reader import SerialReader
+
+        self.port = port
+        self.rd = SerialReader(port, baud, "ff", ser=serial.Serial(port, baud, timeout=0.05))
+        self.rd.start()
+        self.link = _Link(self.rd, baud)
+        self.snap = _Snapshot("ff")
+        self.steps = []         # (host time, PROF step)
+        self.ack = None         # decode_seed_ack() of the last seed
+
+    def start(self, shard: np.ndarray, every: int):
+        self.link.write(P.encode_train_mode(P.TRAIN_ONLINE))
+        self.link.write(P.encode_snap_mode(P.SNAP_TRIG_EVERY, every=every))
+        for fr in P.encode_data_batch(shard):
+            self.link.write(fr)
+        self.link.write(P.encode_frame(P.CMD_DONE))   # auto-runs
+
+    def poll(self):
+        for fr in self.rd.drain():
+            if fr.cmd == P.CMD_SEED_ACK:
+                self.ack = P.decode_seed_ack(fr.payload)
+                self.snap.nodes, self.snap.last = None, None   # older than the seed
+            else:
+                self.snap.on_frame(fr)
+            if fr.cmd == P.CMD_PROF:
+                d = P.decode_prof(fr.payload)
+                if "step" in d:
+                    self.steps.append((time.time(), int(d["step"])))
+
+    def seed(self, xy: np.ndarray, edges: np.ndarray):
+        self.ack = None
+        for fr in P.encode_seed(np.arange(len(xy)), xy, edges):
+            self.link.write(fr)
+
+    def steps_since(self, t0: float) -> int:
+        s = [n for t, n in self.steps if t >= t0]
+        return s[-1] - s[0] if len(s) >= 2 else 0
+
+    def close(self):
+        self.rd.stop()
+
+
+def run(ports, data: np.ndarray, rounds: int, round_s: float, max_nodes: int,
+        radius: float = None, every: int = 100, baud: int = APP_BAUD, log=print) -> dict:
+    """Train len(ports) boards on shards of data, merge and re-seed every
+    round; returns the last merged network and one row per round."""
+    shards = split(data, len(ports))
+    boards = [_Board(p, baud) for p in ports]
+    rows, xy, edges = [], None, None
+    try:
+        for b, s in zip(boards, shards):
+            b.start(s, every)
+        for r in range(rounds):
+            t0 = time.time()
+            while time.time() - t0 < round_s:
+                for b in boards:
+                    b.poll()
+                time.sleep(0.01)
+            dt = time.time() - t0
+            models = [b.snap.last for b in boards if b.snap.last is not None]
+            if not models:
+                log(f"round {r}: no complete snapshot yet")
+                continue
+            xy, edges = merge(models, max_nodes, radius)
+            for b in boards:
+                b.seed(xy, edges)
+            t_ack = time.time() + 2.0
+            while time.time() < t_ack and any(b.ack is None for b in boards):
+                for b in boards:
+                    b.poll()
+                time.sleep(0.01)
+            steps = [b.steps_since(t0) for b in boards]
+            row = {"round": r, "boards": len(models), "steps": steps,
+                   "steps_s": sum(steps) / max(dt, 1e-9),
+                   "acks": [b.ack for b in boards],
+                   **score(data, np.arange(len(xy)), xy, edges)}
+            rows.append(row)
+            log(f"round {r}: {row['steps_s']:.0f} steps/s ({'+'.join(map(str, steps))} steps), "
+                f"merged {len(models)} -> {row['nodes']} nodes {row['edges']} edges, "
+                f"QE {row['qe']:.4f} TE {row['te']:.3f}"
+                + "".join(f"  [{b.port}: no SEED_ACK]" for b in boards if b.ack is None))
+    finally:
+        for b in boards:
+            b.close()
+    return {"xy": xy, "edges": edges, "rows": rows}
+
+
+def main(args) -> int:
+    data = np.load(args.data) if args.data else load_dataset(args.dataset)
+    res = run(args.ports, data, args.rounds, args.round, args.max_nodes, args.radius,
+              args.every, args.baud)
+    if args.out and res["xy"] is not None:
+        np.savez(args.out, xy=res["xy"], edges=res["edges"])
+    return 0 if res["rows"] and all(all(a and a[0] for a in r["acks"]) for r in res["rows"]) else 1
+
+
+def add_arguments(ap):
+    ap.add_argument("ports", nargs="+", help="one serial port per board")
+    ap.add_argument("--dataset", default="circles", help="bench dataset")
+    ap.add_argument("--data", help=".npy (N, 2) array in [0, 1] instead of --dataset")
+    ap.add_argument("--rounds", type=int, default=5)
+    ap.add_argument("--round", type=float, default=4.0, help="seconds of training per round")
+    ap.add_argument("--max-nodes", type=int, default=20, help="MAX_NODES of the build")
+    ap.add_argument("--radius", type=float, help="merge radius (default: half the median edge)")
+    ap.add_argument("--every", type=int, default=100, help="steps per snapshot")
+    ap.add_argument("--out", help=".npz with the last merged xy / edges")
+    ap.add_argument("--baud", type=int, default=APP_BAUD)
@@ -0,0 +1,374 @@
+"""
+Cross-implementation benchmark suite
+====================================
+
+One versioned spec (gng_host/bench_suite.json) for every GNG build in the
+repo: datasets with their seeds, the sample count, the learning parameters
+(gng_core.h defaults, which every firmware and gng.vhd build in) and
+golden QE / TE bands. Each run prints one table row per platform and
+dataset and appends it to a results file; `suite table` merges the files
+of several sessions, so the boards can be run one at a time.
+
+Datasets (spec "datasets", `samples` each, in this upload order):
+
+- processing_moons: generate_moons_processing_exact() of try_gng_python.py,
+  the JavaRandom moons of the Processing sketches and firmware demos
+- generator: benchmark_datasets.DatasetGenerator (bench.load_dataset),
+  subsampled and ordered by a permutation from the dataset's seed
+- the sha256 of the wire form (int16 = value * 1000) is part of the golden
+  record; a run whose data hashes differently stops, as a changed
+  generator would make the rows incomparable
+
+Platforms:
+  python    gng_lite.GNG_Dist2Winner (float Fritzke reference), `steps` steps
+  sim       gngsim.Sim (V3 firmware step, fixed point), `steps` steps
+  v3        V3 firmware: CMD_SET_PARAMS + upload order, PROF cycles
+  neorv32   gng_neorv32 (V3 firmware, software winners), PROF cycles
+  v2        V2 gng.vhd (A5 stream), cycles from the DBG timestamps
+  v2-sw     V2 software firmware, NODES frames only
+  picotiny  PicoTiny firmware at 115200 baud, PROF cycles
+  arduino   Arduino sketch at 115200 baud, NODES frames only
+
+The boards run `seconds` per dataset and are scored on their last full
+NODES + EDGES (A5 NODES + EDGES) snapshot. The builds fix lambda / a_max /
+rates at compile time (V3 also takes CMD_SET_PARAMS), so a board row is
+only comparable when the build uses the spec values; MAX_NODES is the
+build's own (table column N). Each dataset needs a freshly reset board:
+with --exe the suite reflashes before every dataset, otherwise pass one
+--dataset.
+
+Columns: steps/s (host clock), cycles/step (mean PROF cyc_total or DBG
+delta), bytes/step (board -> host), final QE / TE and "ok" when both are
+inside the golden band of the dataset.
+
+    python -m gngio suite golden                        # after a spec change
+    python -m gngio suite run python sim --results suite.json
+    python -m gngio suite run v3 --port COM5 --exe fw/neorv32_exe.bin --results suite.json
+    python -m gngio suite table suite.json
+
+--bitstream <gng.fs> stores the bitstream's hash in the board rows, which
+ties them to its PnR record (python -m gngio pnr record --results).
+"""
+
+import hashlib
+import json
+import sys
+import time
+from pathlib import Path
+
+import numpy as np
+
+from . import protocol as P
+from .bench import APP_BAUD, _DATASETS, _Link, flash, load_dataset
+from .metrics import quantization_error, topological_error
+from .pnr import bitstream_sha
+
+SPEC = Path(__file__).resolve().parents[1] / "bench_suite.json"
+
+BOARDS = {
+    # frame kind, baud, steps per NODES frame (no PROF step counter)
+    "v3":       {"kind": "ff", "baud": APP_BAUD, "every": 100},
+    "neorv32":  {"kind": "ff", "baud": APP_BAUD, "every": 100},
+    "v2":       {"kind": "a5", "baud": APP_BAUD, "every": 1},
+    "v2-sw":    {"kind": "ff", "baud": APP_BAUD, "every": 5},
+    "picotiny": {"kind": "ff", "baud": 115200, "every": 20},
+    "arduino":  {"kind": "ff", "baud": 115200, "every": 20},
+}
+PLATFORMS = ("python", "sim") + tuple(BOARDS)
+
+
+# ---------------------------------------------------------------------------
+# spec / datasets
+# ---------------------------------------------------------------------------
+def load_spec(path=SPEC) -> dict:
+    with open(path) as f:
+        return json.load(f)
+
+
+def make_dataset(spec: dict, name: str) -> np.ndarray:
+    """(samples, 2) float32 in [0, 1], in upload order."""
+    d = spec["datasets"][name]
+    n = spec["samples"]
+    if d["gen"] == "processing_moons":
+        sys.path.insert(0, str(_DATASETS))
+        from try_gng_python import generate_moons_processing_exact
+        return generate_moons_processing_exact(n, d.get("random_angle", False), d["noise"],
+                                               d["seed"], shuffle=True, normalize01=True)
+    data = load_dataset(name)
+    return data[np.random.default_rng(d["seed"]).permutation(len(data))[:n]]
+
+
+def data_hash(data: np.ndarray) -> str:
+    wire = np.round(data.astype(np.float64) * 1000.0).astype("<i2")
+    return hashlib.sha256(wire.tobytes()).hexdigest()[:16]
+
+
+def check_dataset(spec: dict, name: str, data: np.ndarray):
+    g = spec.get("golden", {}).get(name)
+    if g and g.get("version") == spec["version"] and g["sha256"] != data_hash(data):
+        raise SystemExit(f"{name}: dataset hash {data_hash(data)} != golden {g['sha256']} "
+                         "(generator changed: bump the spec version and rerun suite golden)")
+
+
+def score(data, ids, xy, edges) -> dict:
+    xy = np.asarray(xy, dtype=np.float64).reshape(-1, 2)
+    edges = np.asarray(edges, dtype=np.int64).reshape(-1, 2)
+    return {"nodes": int(len(xy)), "edges": int(len(edges)),
+            "qe": quantization_error(data, xy),
+            "te": topological_error(data, xy, edges, np.asarray(ids))}
+
+
+def in_band(spec: dict, name: str, row: dict) -> str:
+    g = spec.get("golden", {}).get(name)
+    if not g or g.get("version") != spec["version"] or "qe" not in row:
+        return "-"
+    bad = [k for k in ("qe", "te") if not g[k][0] <= row[k] <= g[k][1]]
+    return "ok" if not bad else "/".join(k.upper() for k in bad) + "!"
+
+
+# ---------------------------------------------------------------------------
+# offline platforms
+# ---------------------------------------------------------------------------
+def run_python(spec: dict, data: np.ndarray) -> dict:
+    sys.path.insert(0, str(_DATASETS))
+    from gng_lite import GNG_Dist2Winner
+    p = spec["params"]
+    g = GNG_Dist2Winner(max_nodes=p["max_nodes"], a_max=p["a_max"], lamb=p["lambda"],
+                        eps_b=p["eps_b"], eps_n=p["eps_n"], alpha=p["alpha"], beta=1.0 - p["d"])
+    x = data.astype(np.float64)
+    t0 = time.perf_counter()
+    for k in range(spec["steps"]):
+        g.step(x[k % len(x)])
+    dt = time.perf_counter() - t0
+    ids = np.flatnonzero(g.act)
+    i, j = np.nonzero(np.triu(g.edge, 1))
+    return {"steps": spec["steps"], "steps_s": spec["steps"] / max(dt, 1e-9), "n": p["max_nodes"],
+            **score(data, ids, g.W[ids], np.column_stack((i, j)))}
+
+
+def run_sim(spec: dict, data: np.ndarray) -> dict:
+    sys.path.insert(0, str(Path(__file__).resolve().parents[1]))
+    from gngsim import Sim
+    p = spec["params"]
+    sim = Sim(max_nodes=p["max_nodes"])
+    sim.config(p["lambda"], p["eps_b"], p["eps_n"], p["alpha"], p["a_max"], p["d"])
+    sim.train_order(P.ORDER_UPLOAD)  # as run_board sends to the V3
+    sim.load(data)
+    sim.reset()
+    t0 = time.perf_counter()
+    sim.run(spec["steps"])
+    dt = time.perf_counter() - t0
+    ids, xy = sim.nodes()
+    return {"steps": spec["steps"], "steps_s": spec["steps"] / max(dt, 1e-9), "n": p["max_nodes"],
+            **score(data, ids, xy, [(a, b) for a, b, _ in sim.edges()])}
+
+
+# ---------------------------------------------------------------------------
+# boards
+# ---------------------------------------------------------------------------
+class _Snapshot:
+    """Last complete node + edge snapshot of the stream (keyframes only)."""
+
+    def __init__(self, kind: str):
+        self.kind = kind
+        self.nodes = None     # (frame_id, ids, xy)
+        self.chunks = []
+        self.last = None      # (ids, xy, edges)
+        self.count = 0
+        self.slots = None     # MAX_NODES of the build, A5 NODES only
+
+    def on_frame(self, fr):
+        if self.kind == "a5":
+            if fr.cmd == P.A5_NODES:
+                _, nd = P.decode_a5_nodes(fr.payload)
+                act = nd["act"].astype(bool)
+                self.nodes = (None, nd["id"][act], np.column_stack((nd["x"], nd["y"]))[act] / 1000.0)
+                self.slots = len(nd)
+            elif self.nodes and fr.cmd in (P.A5_EDGES, P.A5_EDGE_BITMAP):
+                e = (P.decode_a5_edges(fr.payload) if fr.cmd == P.A5_EDGES
+                     else P.decode_a5_edge_bitmap(fr.payload, self.slots))
+                self._done(np.column_stack((e["a"], e["b"])))
+            return
+        if fr.cmd == P.CMD_GNG_NODES:
+            fid, nd = P.decode_nodes(fr.payload)
+            self.nodes = (fid, nd["id"], np.column_stack((nd["x"], nd["y"])) / 1000.0)
+            self.chunks = []
+        elif not self.nodes:
+            return
+        elif fr.cmd in (P.CMD_GNG_EDGES, P.CMD_GNG_EDGES_BITMAP):
+            fid, e = (P.decode_edges if fr.cmd == P.CMD_GNG_EDGES else P.decode_edges_bitmap)(fr.payload)
+            if fid == self.nodes[0]:
+                self._done(np.column_stack((e["a"], e["b"])))
+        elif fr.cmd == P.CMD_GNG_EDGES_CHUNK:
+            fid, c, nc, _, pairs = P.decode_edges_chunk(fr.payload)
+            if fid == self.nodes[0]:
+                self.chunks.append(np.column_stack((pairs["a"], pairs["b"])))
+                if c + 1 == nc:
+                    self._done(np.concatenate(self.chunks))
+
+    def _done(self, edges):
+        self.last = (self.nodes[1], self.nodes[2], edges)
+        self.nodes = None
+        self.count += 1
+
+
+def run_board(spec: dict, board: str, port: str, data: np.ndarray, seconds: float,
+              exe: str = None) -> dict:
+    import serial
+    from .reader import SerialReader, set_params
+
+    b = BOARDS[board]
+    if exe:
+        flash(port, exe)
+    ser = serial.Serial(port, b["baud"], timeout=0.05)
+    params = None
+    if board == "v3":
+        p = spec["params"]
+        params = set_params(ser, {k: p[k] for k in P.PARAM_NAMES[:P.PARAM_BASE]})
+    rd = SerialReader(port, b["baud"], b["kind"], ser=ser)
+    rd.start()
+    link = _Link(rd, b["baud"])
+    snap, prof, ts = _Snapshot(b["kind"]), [], []
+    try:
+        wire = np.round(data.astype(np.float64) * 1000.0).astype("<i2")
+        if b["kind"] == "a5":
+            link.write(wire.tobytes())
+        else:
+            if board == "v3":
+                link.write(P.encode_train_mode(P.TRAIN_ONLINE, P.ORDER_UPLOAD))
+                link.write(P.encode_snap_mode(P.SNAP_TRIG_EVERY, every=b["every"]))
+            for fr in P.encode_data_batch(data):
+                link.write(fr)
+            link.write(P.encode_frame(P.CMD_DONE))   # auto-runs
+        link.mark()
+        t_end = time.time() + seconds
+        while time.time() < t_end:
+            for fr in rd.drain():
+                snap.on_frame(fr)
+                if fr.kind == "a5" and fr.cmd == P.A5_DBG:
+                    ts.append(P.decode_a5_dbg(fr.payload)["ts"])
+                elif fr.kind != "a5" and fr.cmd == P.CMD_PROF:
+                    prof.append(P.decode_prof(fr.payload))
+            time.sleep(0.01)
+        ln = link.report()
+    finally:
+        rd.stop()
+
+    row = {"params": "spec" if params else "build"}
+    if prof and "step" in prof[-1]:
+        row["steps"] = int(prof[-1]["step"])
+        row["cycles"] = float(np.mean([q["cyc_total"] for q in prof]))
+    elif len(ts) >= 2:
+        # gng.vhd: one DBG record per DBG_EVERY iterations, ts on the FPGA clock
+        dts = np.diff(np.asarray(ts, dtype=np.int64)) % (1 << 32)
+        row["cycles"] = float(dts.mean()) / b["every"]
+        row["steps"] = len(ts) * b["every"]
+    else:
+        row["steps"] = snap.count * b["every"]
+    row["steps_s"] = row["steps"] / max(ln["seconds"], 1e-9)
+    row["bytes_step"] = ln["rx_bytes"] / max(row["steps"], 1)
+    if snap.last:
+        ids, xy, edges = snap.last
+        row.update(score(data, ids, xy, edges))
+    row["n"] = snap.slots
+    return row
+
+
+# ---------------------------------------------------------------------------
+# golden bands / table
+# ---------------------------------------------------------------------------
+def golden(spec: dict, path=SPEC) -> dict:
+    """Bands around the sim run (the V3 firmware step, bit-exact to the
+    board), written back into the spec."""
+    tol = spec["band_tol"]
+    out = {}
+    for name in spec["datasets"]:
+        data = make_dataset(spec, name)
+        r = run_sim(spec, data)
+        out[name] = {"version": spec["version"], "sha256": data_hash(data),
+                     "qe": [round(r["qe"] * (1 - tol["qe_rel"]), 6), round(r["qe"] * (1 + tol["qe_rel"]), 6)],
+                     "te": [round(max(r["te"] - tol["te_abs"], 0.0), 6), round(min(r["te"] + tol["te_abs"], 1.0), 6)]}
+    spec["golden"] = out
+    with open(path, "w") as f:
+        json.dump(spec, f, indent=2)
+        f.write("\n")
+    return out
+
+
+def format_row(r: dict) -> str:
+    def f(k, w, fmt):
+        return f"{r[k]:{w}{fmt}}" if r.get(k) is not None else f"{'-':>{w}}"
+    return (f"  {r['platform']:9s} {r['dataset']:17s} {f('n', 3, 'd')} {f('steps', 9, 'd')}"
+            f" {f('steps_s', 11, '.0f')} {f('cycles', 11, '.0f')} {f('bytes_step', 10, '.2f')}"
+            f" {f('nodes', 5, 'd')} {f('qe', 8, '.4f')} {f('te', 6, '.3f')}  {r.get('band', '-')}")
+
+
+HEADER = ("  platform  dataset             N     steps     steps/s cycles/step bytes/step"
+          " nodes       QE     TE  band")
+
+
+def main(args) -> int:
+    spec = load_spec(args.spec)
+    if args.suite_op == "golden":
+        for name, g in golden(spec, args.spec).items():
+            print(f"{name:17s} {g['sha256']}  qe {g['qe'][0]:.4f}..{g['qe'][1]:.4f}"
+                  f"  te {g['te'][0]:.3f}..{g['te'][1]:.3f}")
+        return 0
+    if args.suite_op == "table":
+        rows = [r for p in args.results for r in json.loads(Path(p).read_text())]
+        rows = [r for r in rows if r.get("version") == spec["version"]]
+        print(f"# {spec['suite']} v{spec['version']}: {spec['samples']} samples, {spec['steps']} steps")
+        print(HEADER)
+        for r in sorted(rows, key=lambda r: (r["dataset"], PLATFORMS.index(r["platform"]))):
+            print(format_row(r))
+        return 0
+
+    names = args.dataset or list(spec["datasets"])
+    boards = [p for p in args.platform if p in BOARDS]
+    if boards and not args.port:
+        raise SystemExit("board platforms need --port")
+    if boards and len(names) > 1 and not args.exe:
+        raise SystemExit("one --dataset per board reset (or --exe to reflash before each)")
+    rows = []
+    print(f"# {spec['suite']} v{spec['version']}: {spec['samples']} samples, {spec['steps']} steps")
+    print(HEADER)
+    for name in names:
+        data = make_dataset(spec, name)
+        check_dataset(spec, name, data)
+        for plat in args.platform:
+            if plat == "python":
+                r = run_python(spec, data)
+            elif plat == "sim":
+                r = run_sim(spec, data)
+            else:
+                r = run_board(spec, plat, args.port, data, args.seconds or spec["seconds"], args.exe)
+            r.update(platform=plat, dataset=name, version=spec["version"],
+                     time=time.strftime("%Y-%m-%dT%H:%M:%S"))
+            r["band"] = in_band(spec, name, r)
+            if plat in BOARDS and args.bitstream:
+                r["bitstream"] = bitstream_sha(args.bitstream)
+            rows.append(r)
+            print(format_row(r))
+    if args.results:
+        path = Path(args.results)
+        old = json.loads(path.read_text()) if path.exists() else []
+        path.write_text(json.dumps(old + rows, indent=1) + "\n")
+    bad = [r for r in rows if r["band"].endswith("!")]
+    return 2 if bad and args.strict else 0
+
+
+def add_arguments(ap):
+    ap.add_argument("--spec", default=str(SPEC))
+    sub = ap.add_subparsers(dest="suite_op", required=True)
+    r = sub.add_parser("run", help="run platforms on the spec datasets, one row each")
+    r.add_argument("platform", nargs="+", choices=PLATFORMS)
+    r.add_argument("--dataset", action="append", help="spec dataset (repeatable, default all)")
+    r.add_argument("--port", help="serial port of the board platforms")
+    r.add_argument("--exe", help="firmware to flash before every dataset (NEORV32 boards)")
+    r.add_argument("--seconds", type=float, help="per board dataset (default: spec)")
+    r.add_argument("--results", help="JSON file the rows are appended to")
+    r.add_argument("--bitstream", help="bitstream the board runs (.fs), hashed into its rows")
+    r.add_argument("--strict", action="store_true", help="exit 2 on a row outside its band")
+    sub.add_parser("golden", help="rewrite the golden hashes / bands from the sim")
+    t = sub.add_parser("table", help="one table of the current spec version from result files")
+    t.add_argument("results", nargs="+")
@@ -0,0 +1,370 @@
+"""
+HDL testbench vectors and golden models
+=======================================
+
+Stimulus for the GHDL / NVC benches of gng_neorv32_accelerator_V2/sim and
+gng_neorv32_accelerator_V3/sim, and the check of what they write back.
+
+Winner benches (V2 gng_find_winner.vhd, V3 neorv32_cfs.vhd):
+
+- node sets drawn from a standard dataset (bench.load_dataset) plus the
+  corner cases a datapath change breaks first: no active node, a single
+  one, equal distances (duplicate nodes), active nodes past NODE_COUNT,
+  a full MAX_NODES set
+- every sample carries the s1 / s2 / d1 / d2 of scan_ref(), the
+  sequential scan both engines must reproduce (strict <, so ties go to
+  the lower index); the bench compares and prints cycles per search
+
+tb_gng.vhd (V2 gng.vhd, SNAP_EVERY = 1, edge list snapshots):
+
+- the dataset as int16 x 1000, like bench.py uploads it
+- the bench writes every TX byte; check_gng() replays the A5 stream
+  through GngVhdRef, an integer model of one gng.vhd iteration, from each
+  snapshot to the next: s1 / s2 / s2_valid, the s1 move of the DBG record,
+  neighbor moves, aging, pruning, connect and the resulting node / edge
+  snapshot must match exactly
+- an insertion is checked for its structure: the lowest free slot, at the
+  midpoint of an edge (q, f) that the same iteration removed, with edges
+  q-r and r-f of age 0 (q = max error is not visible in the stream)
+
+Vector file (winner benches), one record per line, '#' = comment:
+
+    N <node_count> <n>                 node set, then n lines "x y act"
+    S <m>                              then m lines
+    x y s1 s2 d1_hi d1_lo d2_hi d2_lo  d = hi * 65536 + lo
+
+    python -m gngio tb vectors v2 winner_v2.txt --dataset circles
+    python -m gngio tb data gng_data.txt --dataset circles
+    python -m gngio tb check tx.txt gng_data.txt
+"""
+
+import numpy as np
+
+from . import protocol as P
+from .metrics import quantization_error
+
+ENGINES = {
+    # coordinate scale, coordinate range, distance cap (initial min / saturation)
+    "v2": {"scale": 1000.0, "lo": -32768, "hi": 32767, "dmax": (1 << 33) - 1, "sat": False},
+    "v3": {"scale": 32767.0, "lo": 0, "hi": 32767, "dmax": (1 << 32) - 1, "sat": True},
+}
+
+# gng.vhd generics the model needs (defaults of the entity)
+GNG_VHD = {"a_max": 50, "init": ((-500, 500), (500, -500))}
+EPS_WIN_Q8 = 77
+EPS_N_Q16 = 66
+
+
+# ---------------------------------------------------------------------------
+# winner scan
+# ---------------------------------------------------------------------------
+def scan_ref(xy, act, count, x, y, dmax, sat):
+    """(s1, s2, d1, d2) of a scan over nodes 0 .. count-1 with act set."""
+    b1 = b2 = dmax
+    i1 = i2 = 0
+    for i in range(min(count, len(xy))):
+        if not act[i]:
+            continue
+        dx = x - int(xy[i][0])
+        dy = y - int(xy[i][1])
+        d = dx * dx + dy * dy
+        if sat and d > dmax:
+            d = dmax
+        if d < b1:
+            b2, i2 = b1, i1
+            b1, i1 = d, i
+        elif d < b2:
+            b2, i2 = d, i
+    return i1, i2, b1, b2
+
+
+def _quant(data, eng) -> np.ndarray:
+    e = ENGINES[eng]
+    return np.clip(np.round(np.asarray(data, np.float64) * e["scale"]), e["lo"], e["hi"]).astype(np.int64)
+
+
+def winner_cases(data, eng: str, max_nodes: int, cases: int = 40, samples: int = 50, seed: int = 1):
+    """[(count, xy, act, samples)] for one engine; data (N, 2) in [0, 1]."""
+    rng = np.random.default_rng(seed)
+    pts = _quant(data, eng)
+    e = ENGINES[eng]
+
+    def pick(k):
+        return pts[rng.integers(0, len(pts), k)].copy()
+
+    out = []
+    # corner cases first, then random sets
+    xy = pick(max_nodes)
+    out.append((max_nodes, xy, np.zeros(max_nodes, bool), pick(4)))            # nothing active
+    one = np.zeros(max_nodes, bool)
+    one[rng.integers(0, max_nodes)] = True
+    out.append((max_nodes, xy, one, pick(4)))                                   # one active node
+    dup = pick(max_nodes)
+    dup[1::2] = dup[0::2][:len(dup[1::2])]
+    out.append((max_nodes, dup, np.ones(max_nodes, bool), np.vstack((dup[:8], pick(8)))))  # ties
+    past = np.ones(max_nodes, bool)
+    out.append((max_nodes // 2, pick(max_nodes), past, pick(8)))                # active past count
+    out.append((0, pick(max_nodes), past, pick(2)))                             # count 0
+    out.append((max_nodes, pick(max_nodes), np.ones(max_nodes, bool), pick(samples)))  # full
+    if eng == "v2":
+        edge = np.array([[e["lo"], e["lo"]], [e["hi"], e["hi"]], [e["lo"], e["hi"]]], np.int64)
+        xy = pick(max_nodes)
+        xy[:3] = edge
+        out.append((max_nodes, xy, np.ones(max_nodes, bool), edge[::-1].copy()))  # 17-bit deltas
+    for _ in range(cases):
+        n = int(rng.integers(2, max_nodes + 1))
+        act = rng.random(max_nodes) < 0.8
+        act[n:] = False
+        xy = pick(max_nodes)
+        xy[n:] = 0
+        s = pick(samples)
+        s[:2] = xy[:2]                                                          # d1 = 0
+        out.append((n, xy, act, s))
+    return out
+
+
+def write_winner_vectors(path, data, eng: str, max_nodes: int, **kw) -> int:
+    """Vector file for tb_gng_find_winner / tb_neorv32_cfs; returns the sample count."""
+    e = ENGINES[eng]
+    total = 0
+    with open(path, "w") as f:
+        f.write(f"# {eng} MAX_NODES={max_nodes}\n")
+        for count, xy, act, smp in winner_cases(data, eng, max_nodes, **kw):
+            f.write(f"N {count} {max_nodes}\n")
+            for (x, y), a in zip(xy, act):
+                f.write(f"{x} {y} {int(a)}\n")
+            f.write(f"S {len(smp)}\n")
+            for x, y in smp:
+                s1, s2, d1, d2 = scan_ref(xy, act, count, int(x), int(y), e["dmax"], e["sat"])
+                f.write(f"{x} {y} {s1} {s2} {d1 >> 16} {d1 & 0xFFFF} {d2 >> 16} {d2 & 0xFFFF}\n")
+            total += len(smp)
+    return total
+
+
+def write_gng_data(path, data) -> int:
+    """tb_gng.vhd dataset: one "x y" int16 line per sample (<= 1024)."""
+    q = _quant(data, "v2")[:1024]
+    with open(path, "w") as f:
+        for x, y in q:
+            f.write(f"{x} {y}\n")
+    return len(q)
+
+
+def read_ints(path) -> np.ndarray:
+    with open(path) as f:
+        return np.array([int(t) for t in f.read().split()], dtype=np.int64)
+
+
+# ---------------------------------------------------------------------------
+# gng.vhd iteration model
+# ---------------------------------------------------------------------------
+def _sat16(v: int) -> int:
+    return max(-32768, min(32767, v))
+
+
+class GngVhdRef:
+    """gng.vhd state as the snapshots show it: x, y, act, deg and stored
+    edge ages (age + 1, 0 = none) keyed by (i, j), i < j."""
+
+    def __init__(self, max_nodes: int, a_max: int = GNG_VHD["a_max"], init=GNG_VHD["init"]):
+        self.n = max_nodes
+        self.a_max_stored = 255 if a_max >= 254 else a_max + 1
+        self.x = [0] * max_nodes
+        self.y = [0] * max_nodes
+        self.act = [False] * max_nodes
+        self.deg = [0] * max_nodes
+        self.edge = {(0, 1): 1}
+        for k, (x, y) in enumerate(init):
+            self.x[k], self.y[k], self.act[k], self.deg[k] = x, y, True, 1
+        self.node_count = 2
+
+    @classmethod
+    def from_snapshot(cls, nodes, edges, node_count, a_max: int = GNG_VHD["a_max"]):
+        r = cls(len(nodes), a_max)
+        r.x = [int(v) for v in nodes["x"]]
+        r.y = [int(v) for v in nodes["y"]]
+        r.act = [bool(v) for v in nodes["act"]]
+        r.deg = [int(v) for v in nodes["deg"]]
+        r.edge = {(int(min(a, b)), int(max(a, b))): int(g)
+                  for a, b, g in zip(edges["a"], edges["b"], edges["age"])}
+        r.node_count = int(node_count)
+        return r
+
+    def nbrs(self, i):
+        return sorted(b if a == i else a for a, b in self.edge if i in (a, b))
+
+    def step(self, sx: int, sy: int) -> dict:
+        """One iteration up to (not including) the insertion; returns the
+        DBG fields it determines."""
+        b1 = b2 = None
+        i1 = i2 = 0
+        for i in range(self.n):
+            if not self.act[i]:
+                continue
+            d = (sx - self.x[i]) ** 2 + (sy - self.y[i]) ** 2
+            if b1 is None or d < b1:
+                b2, i2 = b1, i1
+                b1, i1 = d, i
+            elif b2 is None or d < b2:
+                b2, i2 = d, i
+        s2_valid = b2 is not None
+        s1 = i1
+        # winner move (Q8, floor)
+        nx = _sat16(self.x[s1] + (((sx - self.x[s1]) * EPS_WIN_Q8) >> 8))
+        ny = _sat16(self.y[s1] + (((sy - self.y[s1]) * EPS_WIN_Q8) >> 8))
+        self.x[s1], self.y[s1] = nx, ny
+        rm = iso = False
+        for k in self.nbrs(s1):
+            key = (min(s1, k), max(s1, k))
+            is_s2 = s2_valid and k == i2
+            age = min(self.edge[key] + 1, 255)
+            if not is_s2 and age > self.a_max_stored:
+                del self.edge[key]
+                rm = True
+                self.deg[s1] = max(self.deg[s1] - 1, 0)
+                self.deg[k] = max(self.deg[k] - 1, 0)
+                iso |= self.deg[k] == 0
+                continue
+            if not is_s2:
+                self.edge[key] = age
+            self.x[k] = _sat16(self.x[k] + (((sx - self.x[k]) * EPS_N_Q16) >> 16))
+            self.y[k] = _sat16(self.y[k] + (((sy - self.y[k]) * EPS_N_Q16) >> 16))
+        iso |= self.act[s1] and self.deg[s1] == 0
+        if s2_valid and s1 != i2:
+            key = (min(s1, i2), max(s1, i2))
+            if key not in self.edge:
+                self.deg[s1] = min(self.deg[s1] + 1, 255)
+                self.deg[i2] = min(self.deg[i2] + 1, 255)
+            self.edge[key] = 1
+        return {"s1": s1, "s2": i2, "conn": int(s2_valid), "rm": int(rm), "iso": int(iso),
+                "s1x": nx, "s1y": ny}
+
+    def insert_from(self, got: "GngVhdRef", r: int):
+        """Apply the insertion the snapshot shows for node r; a reason
+        string if it is not a valid gng.vhd insertion."""
+        free = [i for i in range(self.n) if not self.act[i]]
+        if not free or free[0] != r:
+            return f"inserted {r}, lowest free slot {free[0] if free else None}"
+        qf = got.nbrs(r)
+        if len(qf) != 2:
+            return f"inserted {r} has neighbors {qf}"
+        q, f = qf
+        if (q, f) not in self.edge or (q, f) in got.edge:
+            return f"edge ({q}, {f}) was not split"
+        mx = _sat16((self.x[q] + self.x[f]) >> 1)
+        my = _sat16((self.y[q] + self.y[f]) >> 1)
+        if (got.x[r], got.y[r]) != (mx, my):
+            return f"inserted {r} at ({got.x[r]}, {got.y[r]}), midpoint ({mx}, {my})"
+        del self.edge[(q, f)]
+        self.edge[(min(q, r), max(q, r))] = 1
+        self.edge[(min(r, f), max(r, f))] = 1
+        self.x[r], self.y[r], self.act[r], self.deg[r] = mx, my, True, 2
+        self.node_count = min(self.node_count + 1, self.n)
+        return None
+
+    def diff(self, got: "GngVhdRef") -> list:
+        out = []
+        for i in range(self.n):
+            a = (self.act[i], self.deg[i], self.x[i], self.y[i])
+            b = (got.act[i], got.deg[i], got.x[i], got.y[i])
+            if a != b:
+                out.append(f"node {i}: act/deg/x/y {a} != {b}")
+        for k in sorted(set(self.edge) | set(got.edge)):
+            if self.edge.get(k, 0) != got.edge.get(k, 0):
+                out.append(f"edge {k}: age+1 {self.edge.get(k, 0)} != {got.edge.get(k, 0)}")
+        if self.node_count != got.node_count:
+            out.append(f"node_count {self.node_count} != {got.node_count}")
+        return out
+
+
+def iterations(raw: bytes):
+    """A5 stream -> [(dbg dict, nodes, edges, node_count)] per iteration."""
+    frames = P.A5Parser().feed(raw)
+    out = []
+    k = 0
+    while k + 2 < len(frames):
+        d, n, e = frames[k:k + 3]
+        if d.cmd != P.A5_DBG or n.cmd != P.A5_NODES:
+            raise ValueError(f"frame {k}: want DBG + NODES + EDGES (SNAP_EVERY = 1)")
+        if e.cmd == P.A5_EDGE_BITMAP:
+            raise ValueError("edge bitmap snapshot: run tb_gng with SNAP_EDGE_BITMAP = false")
+        cnt, nodes = P.decode_a5_nodes(n.payload)
+        out.append((P.decode_a5_dbg(d.payload), nodes, P.decode_a5_edges(e.payload), cnt))
+        k += 3
+    return out
+
+
+def check_gng(raw: bytes, data, a_max: int = GNG_VHD["a_max"], init=GNG_VHD["init"],
+              max_errors: int = 20) -> dict:
+    """Replay a tb_gng TX capture against GngVhdRef; data = (N, 2) int16."""
+    its = iterations(raw)
+    if not its:
+        raise ValueError("no complete iteration in the capture")
+    ref = GngVhdRef(len(its[0][1]), a_max, init)
+    errors = []
+    inserts = 0
+    for k, (dbg, nodes, edges, cnt) in enumerate(its):
+        sx, sy = (int(v) for v in data[k % len(data)])
+        got = GngVhdRef.from_snapshot(nodes, edges, cnt, a_max)
+        want = ref.step(sx, sy)
+        bad = [f"{f} {want[f]} != {dbg[f]}" for f in ("s1", "conn", "rm", "iso", "s1x", "s1y") if want[f] != dbg[f]]
+        if want["conn"] and want["s2"] != dbg["s2"]:
+            bad.append(f"s2 {want['s2']} != {dbg['s2']}")
+        if dbg["sample"] != k % len(data) % 256:
+            bad.append(f"sample index {dbg['sample']}")
+        if dbg["ins"]:
+            inserts += 1
+            why = ref.insert_from(got, dbg["ins_id"])
+            if why:
+                bad.append(why)
+        if not bad:
+            bad = ref.diff(got)
+        if bad:
+            errors.append((k, bad))
+            if len(errors) >= max_errors:
+                break
+        ref = got                 # next iteration starts from what the DUT did
+    xy = np.column_stack((nodes["x"], nodes["y"]))[nodes["act"] != 0] / 1000.0
+    return {"iterations": len(its), "inserts": inserts, "errors": errors,
+            "nodes": int((nodes["act"] != 0).sum()), "edges": len(edges),
+            "qe": quantization_error(np.asarray(data) / 1000.0, xy)}
+
+
+def main(args) -> int:
+    from .bench import load_dataset
+    if args.tb_op == "vectors":
+        n = write_winner_vectors(args.out, load_dataset(args.dataset), args.engine, args.max_nodes,
+                                 cases=args.cases, samples=args.samples, seed=args.seed)
+        print(f"{args.out}: {n} samples ({args.engine}, MAX_NODES={args.max_nodes})")
+        return 0
+    if args.tb_op == "data":
+        n = write_gng_data(args.out, load_dataset(args.dataset))
+        print(f"{args.out}: {n} samples (DATA_WORDS={n})")
+        return 0
+    raw = bytes(int(v) & 0xFF for v in read_ints(args.tx))
+    data = read_ints(args.data).reshape(-1, 2)
+    r = check_gng(raw, data, args.a_max)
+    for k, bad in r["errors"]:
+        print(f"iteration {k}: " + "; ".join(bad[:4]))
+    print(f"{r['iterations']} iterations, {r['inserts']} inserts, {len(r['errors'])} mismatches; "
+          f"final {r['nodes']} nodes / {r['edges']} edges, QE {r['qe']:.4f}")
+    return 1 if r["errors"] else 0
+
+
+def add_arguments(ap):
+    sub = ap.add_subparsers(dest="tb_op", required=True)
+    v = sub.add_parser("vectors", help="winner bench stimulus + expected s1/s2/d1")
+    v.add_argument("engine", choices=sorted(ENGINES))
+    v.add_argument("out")
+    v.add_argument("--dataset", default="circles")
+    v.add_argument("--max-nodes", type=int, default=40)
+    v.add_argument("--cases", type=int, default=40)
+    v.add_argument("--samples", type=int, default=50)
+    v.add_argument("--seed", type=int, default=1)
+    d = sub.add_parser("data", help="tb_gng.vhd dataset (int16 x 1000)")
+    d.add_argument("out")
+    d.add_argument("--dataset", default="circles")
+    c = sub.add_parser("check", help="replay a tb_gng TX capture against the gng.vhd model")
+    c.add_argument("tx")
+    c.add_argument("data")
+    c.add_argument("--a-max", type=int, default=GNG_VHD["a_max"])
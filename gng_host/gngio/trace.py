@@ -0,0 +1,235 @@
+"""
+Execution trace profile (V3 firmware GNG_TRACE=1, neorv32_tracer)
+=================================================================
+
+CMD_TRACE makes the firmware run the next steps with the NEORV32 trace
+buffer on hart 0 and send its contents after each step (CMD_TRACE_DATA).
+The tracer records every non-linear PC change as a (src, dst) pair: src
+is the branch / jump / trapping instruction, dst where execution went
+on. Between two pairs the CPU ran linearly from the previous dst to the
+next src, so with the instruction lengths of main.elf's .text (low bits
+0b11 = 4 bytes, else a compressed 2-byte one) the capture gives exact
+instruction counts:
+
+- per function (STT_FUNC symbols of main.elf, self = without callees)
+- per loop: a taken backward branch inside one function, head = dst,
+  latch = src; iterations = times the back edge was taken, instructions
+  = self instructions in [head, latch]
+- traps entered (dst bit 0) and truncation: when the step was longer
+  than the buffer the oldest pairs are gone (the first pair lacks the
+  src bit 0 start mark) and only the tail of the step is counted
+
+The tracer has no timestamps. Cycles are mcycle over the whole step
+(CMD_TRACE_DATA) spread by instruction share, so a function that waits
+on the CFS or the bus gets less than it really took; the CFS perf
+counters (gngio perf) give the stall side. The run from the tracer start
+to the first pair and from the last pair to the stop are not visible.
+
+Capture file, one step after the other:
+
+    step <n> cycles <c> pairs <p>      then p lines "src dst" (hex)
+
+    python -m gngio trace capture COM5 trace.txt --steps 20
+    python -m gngio trace report trace.txt ../gng_neorv32_accelerator_V3/fw/main.elf --top 15
+"""
+
+import bisect
+import struct
+from collections import defaultdict
+
+SHF_EXECINSTR = 0x4
+SHT_SYMTAB = 2
+STT_FUNC = 2
+
+
+# ---------------------------------------------------------------------------
+# main.elf: functions and instruction addresses
+# ---------------------------------------------------------------------------
+
+class Elf:
+    """Functions of an RV32 ELF and the start address of every instruction
+    inside them (each function decoded from its first byte)."""
+
+    def __init__(self, path: str):
+        with open(path, "rb") as f:
+            b = f.read()
+        if b[:4] != b"\x7fELF" or b[4] != 1 or b[5] != 1:
+            raise ValueError(f"{path}: not a little-endian ELF32 file")
+        shoff, = struct.unpack_from("<I", b, 0x20)
+        shentsize, shnum, _ = struct.unpack_from("<HHH", b, 0x2E)
+        sec = [struct.unpack_from("<10I", b, shoff + k * shentsize) for k in range(shnum)]
+        # (name, type, flags, addr, offset, size, link, info, align, entsize)
+        text = [(s[3], b[s[4]:s[4] + s[5]]) for s in sec if s[2] & SHF_EXECINSTR and s[5]]
+        funcs = {}
+        for s in sec:
+            if s[1] != SHT_SYMTAB:
+                continue
+            strtab = sec[s[6]]
+            for k in range(s[5] // 16):
+                name, value, size, info, _, _ = struct.unpack_from("<IIIBBH", b, s[4] + 16 * k)
+                if info & 0xF == STT_FUNC and size:
+                    o = strtab[4] + name
+                    funcs[value] = (b[o:b.index(b"\0", o)].decode(errors="replace"), size)
+        self.start = sorted(funcs)
+        self.name = [funcs[a][0] for a in self.start]
+        self.end = [a + funcs[a][1] for a in self.start]
+        insn = []
+        for a, e in zip(self.start, self.end):
+            for base, data in text:
+                if base <= a < base + len(data):
+                    pc = a
+                    while pc < e and pc + 2 <= base + len(data):
+                        insn.append(pc)
+                        pc += 4 if data[pc - base] & 3 == 3 else 2
+        self.insn = insn  # ascending: functions do not overlap
+
+    def func(self, pc: int) -> int:
+        """Index of the function holding pc, -1 outside every function."""
+        k = bisect.bisect_right(self.start, pc) - 1
+        return k if k >= 0 and pc < self.end[k] else -1
+
+    def next_start(self, pc: int) -> int:
+        k = bisect.bisect_right(self.start, pc)
+        return self.start[k] if k < len(self.start) else 1 << 32
+
+    def label(self, pc: int) -> str:
+        k = self.func(pc)
+        return f"{self.name[k]}+0x{pc - self.start[k]:x}" if k >= 0 else f"0x{pc:08x}"
+
+    def count(self, a: int, b: int) -> int:
+        """Instructions starting in [a, b]."""
+        return bisect.bisect_right(self.insn, b) - bisect.bisect_left(self.insn, a)
+
+
+# ---------------------------------------------------------------------------
+# capture file
+# ---------------------------------------------------------------------------
+
+def write_capture(path: str, steps) -> int:
+    """trace_capture() result -> capture file; returns the pair count."""
+    n = 0
+    with open(path, "w") as f:
+        for step, cycles, pairs in steps:
+            f.write(f"step {step} cycles {cycles} pairs {len(pairs)}\n")
+            for s, d in pairs:
+                f.write(f"{s:08x} {d:08x}\n")
+            n += len(pairs)
+    return n
+
+
+def read_capture(path: str):
+    steps = []
+    with open(path) as f:
+        for line in f:
+            w = line.split()
+            if not w or w[0].startswith("#"):
+                continue
+            if w[0] == "step":
+                steps.append((int(w[1]), int(w[3]), []))
+            else:
+                steps[-1][2].append((int(w[0], 16), int(w[1], 16)))
+    return steps
+
+
+# ---------------------------------------------------------------------------
+# profile
+# ---------------------------------------------------------------------------
+
+def profile(elf: Elf, steps) -> dict:
+    """Per function / per loop instruction counts of the captured steps,
+    cycles apportioned per step by instruction share."""
+    f_ins = defaultdict(int)
+    f_cyc = defaultdict(float)
+    loops = {}        # (head, latch) -> [iterations, instructions, cycles]
+    traps = truncated = 0
+    total_ins = total_cyc = 0
+    for _, cycles, pairs in steps:
+        if not pairs:
+            continue
+        truncated += not pairs[0][0] & 1
+        runs = []
+        for k in range(1, len(pairs)):
+            a, b = pairs[k - 1][1] & ~1, pairs[k][0] & ~1
+            if a <= b:
+                runs.append((a, b))
+        for s, d in pairs:
+            traps += d & 1
+            s, d = s & ~1, d & ~1
+            if d < s and elf.func(s) >= 0 and elf.func(s) == elf.func(d):
+                loops.setdefault((d, s), [0, 0, 0.0])[0] += 1
+        step_f = defaultdict(int)
+        step_l = defaultdict(int)
+        for a, b in runs:
+            while a <= b:  # a linear run may fall through into the next function
+                k = elf.func(a)
+                e = min(b, elf.end[k] - 1 if k >= 0 else elf.next_start(a) - 1)
+                step_f[k] += elf.count(a, e)
+                a = e + 1
+        for a, b in runs:
+            for head, latch in loops:
+                lo, hi = max(a, head), min(b, latch)
+                if lo <= hi:
+                    step_l[(head, latch)] += elf.count(lo, hi)
+        n = sum(step_f.values())
+        if not n:
+            continue
+        total_ins += n
+        total_cyc += cycles
+        for k, v in step_f.items():
+            f_ins[k] += v
+            f_cyc[k] += cycles * v / n
+        for key, v in step_l.items():
+            loops[key][1] += v
+            loops[key][2] += cycles * v / n
+    return {"steps": len(steps), "instructions": total_ins, "cycles": total_cyc,
+            "traps": traps, "truncated": truncated,
+            "funcs": {k: (f_ins[k], f_cyc[k]) for k in f_ins},
+            "loops": loops}
+
+
+def format_report(elf: Elf, p: dict, top: int = 20) -> str:
+    n = max(p["steps"], 1)
+    ins = max(p["instructions"], 1)
+    out = [f"{p['steps']} steps, {p['instructions'] / n:.0f} instructions/step seen, "
+           f"{p['cycles'] / n:.0f} cycles/step, CPI {p['cycles'] / ins:.2f}, "
+           f"{p['traps']} traps, {p['truncated']} truncated (tail only)",
+           "", "  function                          instr/step      %    cycles/step"]
+    for k, (i, c) in sorted(p["funcs"].items(), key=lambda kv: -kv[1][0])[:top]:
+        name = elf.name[k] if k >= 0 else "(no symbol)"
+        out.append(f"  {name[:32]:32s} {i / n:11.0f} {100 * i / ins:6.1f} {c / n:14.0f}")
+    out += ["", "  loop (head .. latch)                         iter/step  instr/step    cycles/step"]
+    for (head, latch), (it, i, c) in sorted(p["loops"].items(), key=lambda kv: -kv[1][1])[:top]:
+        where = f"{elf.label(head)} .. +0x{latch - head:x}"
+        out.append(f"  {where[:44]:44s} {it / n:9.1f} {i / n:11.0f} {c / n:14.0f}")
+    return "\n".join(out)
+
+
+def main(args) -> int:
+    if args.trace_op == "capture":
+        import serial
+        from .reader import trace_capture
+        with serial.Serial(args.port, args.baud, timeout=0.05) as ser:
+            steps = trace_capture(ser, args.steps)
+        if steps is None:
+            raise SystemExit("bitstream has no tracer (preset profile-trace, CPU_TRACER > 0)")
+        if not steps:
+            raise SystemExit("no CMD_TRACE_DATA (fw built with GNG_TRACE=0, or not training?)")
+        n = write_capture(args.out, steps)
+        print(f"{args.out}: {len(steps)} steps, {n} pairs")
+        return 0
+    elf = Elf(args.elf)
+    print(format_report(elf, profile(elf, read_capture(args.capture)), args.top))
+    return 0
+
+
+def add_arguments(ap):
+    sub = ap.add_subparsers(dest="trace_op", required=True)
+    c = sub.add_parser("capture", help="trace the next steps, write a capture file")
+    c.add_argument("port")
+    c.add_argument("out")
+    c.add_argument("--steps", type=int, default=10, help="1..255")
+    c.add_argument("--baud", type=int, default=1_000_000)
+    r = sub.add_parser("report", help="per function / per loop profile against main.elf")
+    r.add_argument("capture")
+    r.add_argument("elf")
+    r.add_argument("--top", type=int, default=20)
@@ -0,0 +1,290 @@
+"""
+gngsim - host simulator of the V3 firmware step
+===============================================
+
+gngsim.c compiles gng_core.h with the step knobs of the default V3 firmware
+build (GNG_FIXED=1, block floating point errors, dirty flush, runtime
+parameters, utility eviction, drift boost, compaction, shuffled passes)
+behind a C model of the CFS winner engine, so a run on the same samples
+gives the same nodes / edges / errors as the board, bit for bit;
+tests/test_fwhost_gngsim.py checks that against main.c on fwhost.
+
+    import sys; sys.path.insert(0, "<repo>/gng_host")
+    from gngsim import Sim
+
+    sim = Sim(max_nodes=20)                       # one library per MAX_NODES (+ widths)
+    sim.config(lambda_=100, eps_b=0.3, a_max=50)  # CMD_SET_PARAMS, optional
+    sim.load(samples)                             # (N, 2) in [0, 1], as uploaded
+    sim.reset()
+    sim.run(100_000)
+    ids, xy = sim.nodes()                         # xy in Q16.16 / 65536
+    edges = sim.edges()                           # [(a, b, age), ...]
+
+- the library is built on first use with the host C compiler ($CC, else cc)
+  into gngsim/_build/, rebuilt when gngsim.c or gng_core.h change
+- every Sim loads a private copy, so several simulators can live side by side
+- samples go through the wire format (int16 = value * 1000) like
+  CMD_DATA_BATCH; each pass takes them in a new shuffled order (main.c
+  GNG_SHUFFLE, gng_perm.h) unless train_order(ORDER_UPLOAD) selects upload
+  order, as CMD_TRAIN_MODE does on the board
+- batch_n > 0 reproduces CFS_BATCH_N (winners of the batch start); run()
+  checks the adjacency after every batch
+
+V3Model wraps a Sim with the model interface of
+gng_neorv32_accelerator_V2/fw/experiment_metrics.py (train, n_nodes, ...).
+"""
+
+import ctypes
+import os
+import shutil
+import subprocess
+import sys
+import tempfile
+from pathlib import Path
+
+_HERE = Path(__file__).resolve().parent
+_SRC = _HERE / "gngsim.c"
+_CORE = _HERE.parent.parent / "gng_core" / "gng_core.h"
+_BUILD = _HERE / "_build"
+
+_EXT = ".dll" if sys.platform == "win32" else ".so"
+
+
+def build(max_nodes=20, max_degree=0, cc=None, pos_bits=0, err_bits=32, age_bits=8):
+    """Path of the library for (MAX_NODES, GNG_MAX_DEGREE) and the field
+    widths (GNG_POS_BITS, GNG_ERR_BITS, GNG_AGE_BITS), compiled if stale.
+    pos_bits <= 16 stores int16 Q1.15 positions (GNG_POS16) like the
+    gng_layout.h of gngio precision."""
+    if not 2 <= max_nodes <= 255:
+        raise ValueError("max_nodes must be 2..255 (8-bit CFS node ids)")
+    lay = (pos_bits, err_bits, age_bits)
+    tag = "" if lay == (0, 32, 8) else "_p{}_e{}_a{}".format(*lay)
+    out = _BUILD / f"gngsim_n{max_nodes}_k{max_degree}{tag}{_EXT}"
+    src_time = max(_SRC.stat().st_mtime, _CORE.stat().st_mtime)
+    if out.exists() and out.stat().st_mtime >= src_time:
+        return out
+    _BUILD.mkdir(exist_ok=True)
+    cc = cc or os.environ.get("CC", "cc")
+    # -ffp-contract=off: no FMA in COEF_CONST(), same rounding as the target
+    cmd = [cc, "-O2", "-shared", "-fPIC", "-ffp-contract=off",
+           f"-DMAX_NODES={max_nodes}", f"-DGNG_MAX_DEGREE={max_degree}",
+           f"-DGNG_POS_BITS={pos_bits}", f"-DGNG_ERR_BITS={err_bits}", f"-DGNG_AGE_BITS={age_bits}",
+           f"-DGNG_POS16={int(0 < pos_bits <= 16)}", str(_SRC), "-o", str(out)]
+    try:
+        subprocess.run(cmd, check=True, capture_output=True, text=True)
+    except FileNotFoundError:
+        raise RuntimeError(f"gngsim: C compiler '{cc}' not found (set CC)") from None
+    except subprocess.CalledProcessError as e:
+        raise RuntimeError(f"gngsim: build failed\n{e.stderr}") from None
+    return out
+
+
+def _load(path):
+    """Private copy of the library (its GNG state is static)."""
+    fd, tmp = tempfile.mkstemp(prefix="gngsim_", suffix=_EXT)
+    os.close(fd)
+    shutil.copyfile(path, tmp)
+    lib = ctypes.CDLL(tmp)
+    if sys.platform != "win32":
+        os.unlink(tmp)  # stays mapped
+
+    i32p = ctypes.POINTER(ctypes.c_int32)
+    lib.gngsim_max_nodes.restype = ctypes.c_int
+    lib.gngsim_max_degree.restype = ctypes.c_int
+    u32 = ctypes.c_uint32
+    lib.gngsim_config.argtypes = [u32, u32, u32, u32, u32, u32, ctypes.c_int,
+                                  ctypes.POINTER(u32)]
+    lib.gngsim_config.restype = ctypes.c_int
+    lib.gngsim_reset.restype = None
+    lib.gngsim_order.argtypes = [ctypes.c_int]
+    lib.gngsim_order.restype = None
+    lib.gngsim_load.argtypes = [ctypes.POINTER(ctypes.c_int16), ctypes.c_int]
+    lib.gngsim_load.restype = ctypes.c_int
+    lib.gngsim_run.argtypes = [ctypes.c_uint32]
+    lib.gngsim_run.restype = ctypes.c_uint32
+    lib.gngsim_nodes.argtypes = [i32p]
+    lib.gngsim_nodes.restype = ctypes.c_int
+    lib.gngsim_edges.argtypes = [i32p]
+    lib.gngsim_edges.restype = ctypes.c_int
+    lib.gngsim_stats.argtypes = [ctypes.POINTER(ctypes.c_uint32)]
+    lib.gngsim_stats.restype = None
+    lib.gngsim_state_bytes.restype = ctypes.c_int
+    lib.gngsim_check.restype = ctypes.c_int
+    return lib
+
+
+def _q16(v):
+    # as gngio.protocol.encode_params packs a CMD_SET_PARAMS rate
+    return int(round(float(v) * 65536.0))
+
+
+# drift_* words of CMD_SET_PARAMS (gngio.protocol.PARAM_NAMES[6:]), Q16 or not
+_DRIFT = (("drift_rise", True), ("drift_hold", False), ("drift_eps", True),
+          ("drift_lambda", False), ("drift_amax", False))
+
+
+# CMD_TRAIN_MODE sample order (gngio.protocol ORDER_*)
+ORDER_UPLOAD = 0
+ORDER_SHUFFLE = 1
+
+
+def wire(v):
+    """Q16.16 position -> wire int16 (pos_to_wire)."""
+    return (int(v) * 1000) >> 16
+
+
+class Sim:
+    """One simulated V3 board, see module doc."""
+
+    def __init__(self, max_nodes=20, max_degree=0, cc=None, pos_bits=0, err_bits=32, age_bits=8):
+        self._lib = _load(build(max_nodes, max_degree, cc, pos_bits, err_bits, age_bits))
+        self.max_nodes = self._lib.gngsim_max_nodes()
+        self.max_degree = self._lib.gngsim_max_degree()
+        self.n_samples = 0
+        self._nbuf = (ctypes.c_int32 * (3 * self.max_nodes))()
+        self._ebuf = (ctypes.c_int32 * (3 * self.max_nodes * (self.max_nodes - 1) // 2))()
+        self.reset()
+
+    def config(self, lambda_=100, eps_b=0.3, eps_n=0.001, alpha=0.5, a_max=50,
+               d=0.995, batch_n=0, drift=None):
+        """Learning parameters as a CMD_SET_PARAMS frame sets them (Q16 rates
+        through gng_params_set()) and CFS_BATCH_N; takes effect on the next
+        step, call reset() for a fresh run. Without it the Sim runs the
+        gng_core.h constants, like a board that never got CMD_SET_PARAMS.
+        drift: dict with all five drift_* keys of gngio PARAM_NAMES (the
+        44-byte frame, gng_drift_set() clamps), None = drift left as is."""
+        dw = None
+        if drift is not None:
+            dw = (ctypes.c_uint32 * 5)(*[_q16(drift[k]) if q else int(drift[k])
+                                        for k, q in _DRIFT])
+        if int(lambda_) < 1 or int(a_max) < 0 or self._lib.gngsim_config(
+                int(lambda_), int(a_max), _q16(eps_b), _q16(eps_n), _q16(alpha), _q16(d),
+                int(batch_n), dw):
+            raise ValueError("gngsim: lambda_ >= 1, a_max 0..2^age_bits - 2 (254), "
+                             "eps_b / eps_n 0..0.5, alpha 0..1, 0.5 < d <= 1, batch_n 0..32")
+
+    def load(self, samples):
+        """Dataset in upload order: (N, 2) floats in [0, 1] (anything indexable)."""
+        flat = []
+        for x, y in samples:
+            flat.append(max(-32768, min(32767, int(round(float(x) * 1000)))))
+            flat.append(max(-32768, min(32767, int(round(float(y) * 1000)))))
+        n = len(flat) // 2
+        buf = (ctypes.c_int16 * max(len(flat), 1))(*flat)
+        if self._lib.gngsim_load(buf, n):
+            raise MemoryError("gngsim: dataset")
+        self.n_samples = n
+
+    def train_order(self, order):
+        """Sample order of the passes as CMD_TRAIN_MODE sets it: ORDER_SHUFFLE
+        (the firmware default, a new gng_perm.h order every pass) or
+        ORDER_UPLOAD; kept by reset()."""
+        self._lib.gngsim_order(int(order))
+
+    def reset(self):
+        """Two start nodes, dataset kept, next sample = first one of pass 0."""
+        self._lib.gngsim_reset()
+
+    def run(self, n):
+        """n samples (whole batches in batch mode); returns samples taken.
+        Batch mode checks the adjacency after every batch, RuntimeError on an
+        edge to an inactive node (see check())."""
+        done = 0
+        while n > done:
+            k = min(n - done, 0xFFFFFFFF)
+            took = self._lib.gngsim_run(k)
+            if took == 0:
+                break
+            done += took
+            if self._lib.gngsim_check():
+                raise RuntimeError(f"gngsim: edge to an inactive node after step {self.steps}")
+        return done
+
+    def check(self):
+        """Broken adjacency cells (edge to an inactive node, one-sided edge,
+        degree != neighbours); 0 = consistent."""
+        return self._lib.gngsim_check()
+
+    def nodes(self):
+        """(ids, xy): active node ids and float positions, in id order."""
+        n = self._lib.gngsim_nodes(self._nbuf)
+        b = self._nbuf
+        ids = [b[3 * k] for k in range(n)]
+        xy = [(b[3 * k + 1] / 65536.0, b[3 * k + 2] / 65536.0) for k in range(n)]
+        return ids, xy
+
+    def nodes_raw(self):
+        """[(id, x, y), ...] with Q16.16 positions; wire(x) = snapshot value."""
+        n = self._lib.gngsim_nodes(self._nbuf)
+        b = self._nbuf
+        return [(b[3 * k], b[3 * k + 1], b[3 * k + 2]) for k in range(n)]
+
+    def edges(self):
+        """[(a, b, age), ...], a < b node ids."""
+        e = self._lib.gngsim_edges(self._ebuf)
+        b = self._ebuf
+        return [(b[3 * k], b[3 * k + 1], b[3 * k + 2]) for k in range(e)]
+
+    def stats(self):
+        """{'steps', 'topo_changes', 'qe_ema', 'drift_events'}; qe_ema as a
+        distance (sqrt of Q2.30), drift_events = drift boosts started."""
+        s = (ctypes.c_uint32 * 4)()
+        self._lib.gngsim_stats(s)
+        return {"steps": s[0], "topo_changes": s[1], "qe_ema": (s[2] / float(1 << 30)) ** 0.5,
+                "drift_events": s[3]}
+
+    @property
+    def steps(self):
+        return self.stats()["steps"]
+
+    def state_bytes(self):
+        """Static GNG state of the firmware build for this MAX_NODES."""
+        return self._lib.gngsim_state_bytes()
+
+
+class V3Model:
+    """Sim behind the GNGLite model interface of experiment_metrics.py:
+    train() uploads the data once and runs epochs * len(data) steps, each
+    pass in the order the firmware takes (order, default ORDER_SHUFFLE)."""
+
+    def __init__(self, max_nodes=20, lambda_=100, eps_b=0.3, eps_n=0.001,
+                 alpha=0.5, a_max=50, d=0.995, batch_n=0, max_degree=0,
+                 order=ORDER_SHUFFLE):
+        self.sim = Sim(max_nodes, max_degree)
+        self.sim.config(lambda_, eps_b, eps_n, alpha, a_max, d, batch_n)
+        self.sim.train_order(order)
+        self._loaded = False
+
+    def train(self, data, epochs=1):
+        if not self._loaded:
+            self.sim.load(data)
+            self.sim.reset()
+            self._loaded = True
+        self.sim.run(epochs * self.sim.n_samples)
+
+    def get_weights_as_float(self):
+        import numpy as np
+        _, xy = self.sim.nodes()
+        return np.asarray(xy, dtype=np.float32).reshape(-1, 2)
+
+    def get_edges_as_list(self):
+        """Edges as row indices into get_weights_as_float()."""
+        ids, _ = self.sim.nodes()
+        row = {i: r for r, i in enumerate(ids)}
+        return [(row[a], row[b]) for a, b, _ in self.sim.edges()]
+
+    def get_memory_usage(self):
+        total = self.sim.state_bytes()
+        return {"total_bytes": total, "total_kb": total / 1024}
+
+    @property
+    def n_nodes(self):
+        return len(self.sim.nodes()[0])
+
+    @property
+    def n_edges(self):
+        return len(self.sim.edges())
+
+    @property
+    def iteration(self):
+        return self.sim.steps
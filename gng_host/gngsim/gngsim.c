@@ -0,0 +1,309 @@
+// ================================================================================
+// gngsim.c - host build of the V3 firmware step (gng_neorv32_accelerator_V3/fw)
+//
+// gng_core.h with the step knobs of the default main.c build: GNG_FIXED,
+// GNG_DIRTY, GNG_ERR_BFP, GNG_PARAMS_RT, GNG_UTILITY, GNG_DRIFT, GNG_COMPACT
+// (compact_serve schedule) and GNG_SHUFFLE (next_sample through gng_perm.h,
+// ORDER_SHUFFLE from reset). Left out because they do not change the step:
+// GNG_COMPONENTS labels, GNG_PROFILE. tests/test_fwhost_gngsim.py holds the
+// snapshot keyframes of main.c on fwhost against this build.
+// The CFS is replaced by a C model of neorv32_cfs_engine:
+//   - cfs_node_mem / cfs_act = node_mem and the ACT words, written by the same
+//     dirty flush / mask copy as gng_cfs.h right before a search
+//   - search: Q1.15 dx^2 + dy^2 (Q2.30, no >> 15) over the active mask in index
+//     order, strict '<' -> ties keep the lower index (engine merge_pair);
+//     no second candidate -> s2 = 0 (CAND_NONE id), like OUT_S12
+//   - batch_n > 0: trainBatch of main.c (CFS_BATCH_N), N winners against the
+//     node_mem of the batch start, then the N updates in order (a winner pruned
+//     by an earlier one: that sample is searched again, gng_find_winners_sw)
+//   - not modeled: CFS timeouts (software fallback), UART / streaming /
+//     snapshots (so no REMAP frame), DBL epochs, GNG_MODELS, a main.c built
+//     with other knobs than the defaults above
+//
+// MAX_NODES (and GNG_MAX_DEGREE, the GNG_POS_BITS / GNG_ERR_BITS /
+// GNG_AGE_BITS field widths, GNG_POS16) are fixed per build, gngsim/__init__.py
+// compiles one library per value. The learning parameters are g_par
+// (GNG_PARAMS_RT=1 as in main.c): until gngsim_config() the gng_core.h
+// constants of the firmware build, after it what gng_params_set() makes of
+// the Q16 values of a CMD_SET_PARAMS frame.
+// ================================================================================
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+#ifndef MAX_NODES
+#define MAX_NODES 20
+#endif
+
+#define GNG_FIXED        1
+#define GNG_DIRTY        1
+#define GNG_ERR_BFP      1  // main.c: GNG_ERR_BFP = GNG_FIXED
+#define GNG_PARAMS_RT    1  // main.c: CMD_SET_PARAMS
+#define GNG_UTILITY      1  // main.c: GNG-U eviction at MAX_NODES
+#define GNG_DRIFT        1  // main.c: QE-triggered boost
+#define GNG_COMPACT      1  // main.c: periodic dense renumbering
+#define GNG_FIND_WINNERS sim_cfs_find_winners
+#define SHUFFLE_SEED     0x5EEDu  // main.c: GNG_SHUFFLE=1, same seed
+
+static int sim_batch = 0;
+
+#include "../../gng_core/gng_core.h"
+#include "../../gng_core/gng_perm.h"
+
+#ifdef _WIN32
+#define GNGSIM_API __declspec(dllexport)
+#else
+#define GNGSIM_API __attribute__((visibility("default")))
+#endif
+
+#define CFS_SMP_DEPTH 32  // batch FIFO depth of the V3 CFS
+#define COMPACT_EVERY 1000  // main.c: steps between two checks
+#define COMPACT_SLACK    2  // holes below the span that start a compaction
+#define COMPACT_MAX    126  // moves per CMD_GNG_REMAP frame
+
+// ---------------- CFS model ----------------
+static uint32_t cfs_node_mem[MAX_NODES];
+static uint32_t cfs_act[ACT_WORDS];
+
+static void cfs_sync_nodes_full(void) {
+  for (int i = 0; i < MAX_NODES; i++) cfs_node_mem[i] = pack_node_q15(nodes[i].x, nodes[i].y);
+  for (int w = 0; w < ACT_WORDS; w++) g_dirty[w] = 0;
+}
+
+static void cfs_flush_dirty(void) {
+  for (int w = 0; w < ACT_WORDS; w++) {
+    uint32_t m = g_dirty[w] & g_act[w];
+    g_dirty[w] = 0;
+    for (; m; m &= m - 1u) {
+      int i = w * 32 + GNG_CTZ(m);
+      cfs_node_mem[i] = pack_node_q15(nodes[i].x, nodes[i].y);
+    }
+  }
+}
+
+static void cfs_write_active_mask(void) {
+  for (int w = 0; w < ACT_WORDS; w++) cfs_act[w] = g_act[w];
+}
+
+static void cfs_search(sample_t smp, int *s1, int *s2, dist_t *d1) {
+  const int32_t sx = (int32_t)(smp & 0xFFFFu), sy = (int32_t)(smp >> 16);
+  uint32_t min1 = 0xFFFFFFFFu, min2 = 0xFFFFFFFFu;
+  int id1 = 0, id2 = 0;
+  FOR_EACH_BIT(i, cfs_act, 0, MAX_NODES) {
+    int32_t dx = sx - (int32_t)(cfs_node_mem[i] & 0xFFFFu);
+    int32_t dy = sy - (int32_t)(cfs_node_mem[i] >> 16);
+    uint32_t d = (uint32_t)(dx*dx) + (uint32_t)(dy*dy);
+    if (d < min1) { min2 = min1; id2 = id1; min1 = d; id1 = i; }
+    else if (d < min2) { min2 = d; id2 = i; }
+  }
+  *s1 = id1;
+  *s2 = id2;
+  *d1 = dist_from_q30(min1);
+}
+
+// GNG_FIND_WINNERS backend: gng_cfs_find_winners without the bus
+static void sim_cfs_find_winners(pos_t x, pos_t y, int *s1, int *s2, dist_t *d1) {
+  cfs_flush_dirty();
+  cfs_write_active_mask();
+  cfs_search(pack_node_q15(x, y), s1, s2, d1);
+}
+
+// ---------------- dataset (dataQ / next_sample of main.c) ----------------
+#define ORDER_UPLOAD  0u
+#define ORDER_SHUFFLE 1u
+
+static sample_t *dataQ = NULL;
+static int dataCount = 0;
+static int dataIndex = 0;
+static uint8_t    train_order = ORDER_SHUFFLE;  // CMD_TRAIN_MODE order, kept by reset
+static uint32_t   g_passes = 0;
+static gng_perm_t g_perm;
+
+static inline void pass_rekey(void) {
+  gng_perm_key(&g_perm, SHUFFLE_SEED, g_passes);
+}
+
+static inline sample_t next_sample(void) {
+  int i = dataIndex;
+  if (train_order == ORDER_SHUFFLE) i = (int)gng_perm_at(&g_perm, (uint32_t)dataIndex, (uint32_t)dataCount);
+  sample_t s = dataQ[i];
+  if (++dataIndex >= dataCount) {
+    dataIndex = 0;
+    g_passes++;
+    pass_rekey();
+  }
+  return s;
+}
+
+// main.c trainBatch, minus profiling and the FIFO handshake
+static void trainBatch(void) {
+  sample_t bs[CFS_SMP_DEPTH];
+  int      rs1[CFS_SMP_DEPTH], rs2[CFS_SMP_DEPTH];
+  dist_t   rd1[CFS_SMP_DEPTH];
+
+  cfs_flush_dirty();
+  cfs_write_active_mask();
+  for (int k = 0; k < sim_batch; k++) {
+    bs[k] = next_sample();
+    cfs_search(bs[k], &rs1[k], &rs2[k], &rd1[k]);
+  }
+  for (int k = 0; k < sim_batch; k++) {
+    if (!(nodes[rs1[k]].active && nodes[rs2[k]].active)) {  // pruned earlier in the batch
+      rs1[k] = rs2[k] = -1;
+      gng_find_winners_sw(sample_x(bs[k]), sample_y(bs[k]), &rs1[k], &rs2[k], &rd1[k]);
+    }
+    if (rs1[k] >= 0 && rs2[k] >= 0) gng_update(sample_x(bs[k]), sample_y(bs[k]), rs1[k], rs2[k], rd1[k]);
+  }
+}
+
+// ---------------- compaction (compact_serve of main.c, no REMAP frame) ----------------
+static uint32_t compact_step = 0;  // stepCount of the last check
+
+static void compact_serve(void) {
+  compact_step = stepCount;
+  if (gng_span() - gng_live() < COMPACT_SLACK) return;
+  uint8_t from[COMPACT_MAX], to[COMPACT_MAX];
+  (void)gng_compact(from, to, COMPACT_MAX);
+}
+
+// the main loop checks after a step (batch), after the snapshot of that
+// step; gngsim_run() checks before the next one, so gngsim_nodes() after
+// step k shows what the snapshot of step k shows
+static inline void compact_due(void) {
+  if ((uint32_t)(stepCount - compact_step) >= COMPACT_EVERY) compact_serve();
+}
+
+// ---------------- exported API ----------------
+GNGSIM_API int gngsim_max_nodes(void) { return MAX_NODES; }
+
+GNGSIM_API int gngsim_max_degree(void) { return GNG_MAX_DEGREE; }
+
+// CMD_SET_PARAMS (params_serve of main.c): rates Q16, 1.0 = 65536; drift =
+// the five drift_* words of a 44-byte frame (gng_drift_set() clamps them),
+// NULL = the 24-byte frame. Where gng_params_set() would clamp, -1 and
+// nothing changed; 0 = ok
+GNGSIM_API int gngsim_config(uint32_t lambda, uint32_t a_max, uint32_t eps_b, uint32_t eps_n,
+                             uint32_t alpha, uint32_t d, int batch_n, const uint32_t *drift) {
+  if (lambda < 1u || a_max > GNG_AGE_LIMIT) return -1;
+  if (eps_b > 32768u || eps_n > 32768u || alpha > 65536u) return -1;
+  if (d <= 32768u || d > 65536u) return -1;
+  if (batch_n < 0 || batch_n > CFS_SMP_DEPTH) return -1;
+  if (drift) gng_drift_set(drift[0], drift[1], drift[2], drift[3], drift[4]);
+  gng_params_set(lambda, a_max, eps_b, eps_n, alpha, d);
+  sim_batch = batch_n;
+  return 0;
+}
+
+// CMD_TRAIN_MODE order: ORDER_UPLOAD or ORDER_SHUFFLE (the board default);
+// takes effect on the next sample, the pass count goes on
+GNGSIM_API void gngsim_order(int order) {
+  train_order = order ? ORDER_SHUFFLE : ORDER_UPLOAD;
+}
+
+// initGNG + cfs_setup: two start nodes, node_mem in sync; keeps the dataset
+GNGSIM_API void gngsim_reset(void) {
+  g_topo_changes = 0;  // counts from boot on the board
+  gng_reset();
+  dataIndex = 0;
+  g_passes = 0;
+  pass_rekey();
+  compact_step = 0;
+  cfs_sync_nodes_full();
+}
+
+// samples as wire int16 pairs (value * 1000), converted like CMD_DATA_BATCH
+GNGSIM_API int gngsim_load(const int16_t *xy, int n) {
+  sample_t *q = (sample_t *)malloc((size_t)(n > 0 ? n : 1) * sizeof(sample_t));
+  if (!q) return -1;
+  for (int k = 0; k < n; k++) q[k] = q15_from_wire(xy[2*k]) | (q15_from_wire(xy[2*k + 1]) << 16);
+  free(dataQ);
+  dataQ = q;
+  dataCount = n;
+  dataIndex = 0;
+  g_passes = 0;
+  pass_rekey();
+  return 0;
+}
+
+// broken adjacency cells: an edge to (or from) an inactive node, an edge only
+// one end knows, a degree[] that is not the popcount of nbr[]; 0 = consistent
+GNGSIM_API int gngsim_check(void) {
+  int bad = 0;
+  for (int i = 0; i < MAX_NODES; i++) {
+    int deg = 0;
+    FOR_EACH_NEIGHBOR(j, i, 0, MAX_NODES) {
+      deg++;
+      if (!nodes[i].active || !nodes[j].active) bad++;
+      if (!(nbr[j][i >> 5] & GNG_BIT(i))) bad++;
+    }
+    if (degree[i] != deg) bad++;
+  }
+  return bad;
+}
+
+// n samples; batch mode runs n / batch_n whole batches and stops after one
+// that leaves gngsim_check() != 0. Returns samples taken.
+GNGSIM_API uint32_t gngsim_run(uint32_t n) {
+  if (dataCount <= 0) return 0;
+  if (sim_batch > 0) {
+    uint32_t b = n / (uint32_t)sim_batch;
+    for (uint32_t k = 0; k < b; k++) {
+      compact_due();
+      trainBatch();
+      if (gngsim_check()) return (k + 1) * (uint32_t)sim_batch;
+    }
+    return b * (uint32_t)sim_batch;
+  }
+  for (uint32_t k = 0; k < n; k++) {
+    compact_due();
+    sample_t s = next_sample();
+    gng_step(sample_x(s), sample_y(s));
+  }
+  return n;
+}
+
+// id, x, y (Q16.16, also with GNG_POS16) per active node, in id order;
+// returns the node count
+GNGSIM_API int gngsim_nodes(int32_t *out) {
+  int n = 0;
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    out[3*n] = i;
+    out[3*n + 1] = (int32_t)nodes[i].x * (GNG_POS16 ? 2 : 1);
+    out[3*n + 2] = (int32_t)nodes[i].y * (GNG_POS16 ? 2 : 1);
+    n++;
+  }
+  return n;
+}
+
+// a, b (a < b), age per edge; returns the edge count
+GNGSIM_API int gngsim_edges(int32_t *out) {
+  int e = 0;
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    FOR_EACH_NEIGHBOR(j, i, i + 1, MAX_NODES) {
+      out[3*e] = i;
+      out[3*e + 1] = j;
+      out[3*e + 2] = edge_code(i, j) - 1;
+      e++;
+    }
+  }
+  return e;
+}
+
+// stepCount, topology changes, QE EMA (Q2.30), drift boosts started
+GNGSIM_API void gngsim_stats(uint32_t *out) {
+  out[0] = stepCount;
+  out[1] = g_topo_changes;
+  out[2] = g_qe_ema;
+  out[3] = g_drift.events;
+}
+
+// static GNG state of the firmware build (nodes, edges, bitsets, tournament)
+GNGSIM_API int gngsim_state_bytes(void) {
+  return (int)(sizeof(nodes) + sizeof(g_act) + sizeof(g_dirty) + sizeof(emax_tree) +
+               sizeof(degree) + sizeof(edge_cell) + sizeof(nbr) + sizeof(cfs_node_mem)
+#if GNG_EDGE_STAMP
+               + sizeof(g_wins)
+#endif
+               );
+}
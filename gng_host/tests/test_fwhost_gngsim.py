@@ -0,0 +1,206 @@
+"""
+gngsim against the V3 firmware on fwhost, step by step
+======================================================
+
+fwhost runs gng_neorv32_accelerator_V3/fw/main.c unchanged on its CFS
+register model; gngsim claims the same trajectory. A seeded ring of 600
+samples goes up as CMD_DATA_BATCH frames with the firmware defaults (no
+CMD_SET_PARAMS, shuffled passes, compaction, drift, utility), and every
+keyframe of the snapshot stream (CMD_GNG_NODES + its edge frame, every
+20th snapshot of 100 steps) must equal the gngsim nodes and edges at that
+step, wire units and ids included.
+
+CMD_SET_PARAMS with eps_b = eps_n = 1.0 must come back clamped to 0.5 in
+CMD_PARAMS_ACK, and every keyframe position of the run must stay in [0, 1)
+(the Q16.16 position step is an int32 product).
+
+    cd gng_host && python -m unittest discover -s tests
+
+Pure Python (no gngio / numpy); skipped without make and a C compiler.
+"""
+
+import math
+import os
+import random
+import shutil
+import struct
+import subprocess
+import sys
+import tempfile
+import unittest
+
+_HERE = os.path.dirname(os.path.abspath(__file__))
+sys.path.insert(0, os.path.join(_HERE, ".."))
+
+_FWHOST = os.path.join(_HERE, "..", "fwhost")
+
+CMD_DATA_BATCH = 0x01
+CMD_DONE = 0x02
+CMD_SET_PARAMS = 0x0A
+CMD_PARAMS_ACK = 0x1A
+CMD_GNG_NODES = 0x10
+CMD_GNG_EDGES = 0x11
+CMD_GNG_EDGES_CHUNK = 0x14
+CMD_GNG_EDGES_BITMAP = 0x17
+
+MAX_NODES = 20       # main.c default
+SNAP_STEPS = 100     # SNAP_TRIG_EVERY default interval
+N_SAMPLES = 600
+RUN_MS = 3000        # fwhost -t: keyframes up to tens of thousands of steps
+
+
+def frame(cmd, payload=b""):
+    chk = ~(cmd + len(payload) + sum(payload)) & 0xFF
+    return bytes((0xFF, 0xFF, cmd, len(payload))) + bytes(payload) + bytes((chk,))
+
+
+def ring(n, seed=7):
+    rng = random.Random(seed)
+    out = []
+    for _ in range(n):
+        a = rng.random() * 2.0 * math.pi
+        r = 0.3 + rng.gauss(0.0, 0.02)
+        out.append((0.5 + r * math.cos(a), 0.5 + r * math.sin(a)))
+    return out
+
+
+def upload(samples):
+    """DATA_BATCH frames (63 points max each) + DONE, which auto-runs."""
+    w = [struct.pack("<hh", int(round(x * 1000)), int(round(y * 1000))) for x, y in samples]
+    out = b""
+    for i in range(0, len(w), 63):
+        chunk = w[i:i + 63]
+        out += frame(CMD_DATA_BATCH, bytes((len(chunk),)) + b"".join(chunk))
+    return out + frame(CMD_DONE)
+
+
+def parse(stream):
+    """Frames with a good checksum, in order; text lines in between skipped."""
+    frames, i = [], 0
+    while True:
+        i = stream.find(b"\xff\xff", i)
+        if i < 0 or i + 4 > len(stream):
+            return frames
+        cmd, n = stream[i + 2], stream[i + 3]
+        if i + 5 + n > len(stream):
+            return frames
+        p = stream[i + 4:i + 4 + n]
+        if ~(cmd + n + sum(p)) & 0xFF != stream[i + 4 + n]:
+            i += 1
+            continue
+        frames.append((cmd, p))
+        i += 5 + n
+
+
+def bitmap_pairs(p):
+    """CMD_GNG_EDGES_BITMAP -> (frame_id, [(a, b)]), half-matrix index k
+    row-major with a < b; flags 1 = gap code (255 = 255 zeros, g = g zeros
+    then an edge), else one bit per cell, LSB first."""
+    fid, n, flags = p[0], p[1], p[2]
+    ks, k = [], -1
+    if flags & 1:
+        for g in p[3:]:
+            if g == 255:
+                k += 255
+            else:
+                k += g + 1
+                ks.append(k)
+    else:
+        for byte_i, v in enumerate(p[3:]):
+            ks += [byte_i * 8 + b for b in range(8) if v >> b & 1]
+    cells = [(a, b) for a in range(n) for b in range(a + 1, n)]
+    return fid, [cells[k] for k in ks if k < len(cells)]
+
+
+def keyframes(frames):
+    """[(step, nodes, edges)]: nodes sorted (id, x, y) wire int16, edges a
+    set of (a, b) a < b. frame_id wraps at 256, a keyframe comes at least
+    every 20 snapshots, so the unwrapped id is the step / SNAP_STEPS."""
+    out, u, cur, chunks = [], None, None, []
+    for cmd, p in frames:
+        if cmd == CMD_GNG_NODES:
+            fid = p[0]
+            u = fid if u is None else u + ((fid - u) & 0xFF)
+            nodes = sorted((p[2 + 5 * k], *struct.unpack_from("<hh", p, 3 + 5 * k))
+                           for k in range(p[1]))
+            cur, chunks = (p[0], u, nodes), []
+        elif cur is None:
+            continue
+        elif cmd == CMD_GNG_EDGES and p[0] == cur[0]:
+            pairs = [(p[2 + 2 * k], p[3 + 2 * k]) for k in range(p[1])]
+            out.append((cur[1] * SNAP_STEPS, cur[2], {(min(e), max(e)) for e in pairs}))
+            cur = None
+        elif cmd == CMD_GNG_EDGES_BITMAP and p[0] == cur[0]:
+            out.append((cur[1] * SNAP_STEPS, cur[2], set(bitmap_pairs(p)[1])))
+            cur = None
+        elif cmd == CMD_GNG_EDGES_CHUNK and p[0] == cur[0]:
+            wide, chunk, nc = p[1] & 1, p[2], p[3]
+            fmt, sz = ("<HH", 4) if wide else ("<BB", 2)
+            chunks += [struct.unpack_from(fmt, p, 7 + sz * k) for k in range(p[6])]
+            if chunk + 1 == nc:
+                out.append((cur[1] * SNAP_STEPS, cur[2], {(min(e), max(e)) for e in chunks}))
+                cur = None
+    return out
+
+
+def _can_build():
+    return shutil.which("make") and (shutil.which(os.environ.get("CC", "cc")))
+
+
+@unittest.skipUnless(_can_build(), "needs make and a C compiler")
+class TestFwhostTrajectory(unittest.TestCase):
+    @classmethod
+    def setUpClass(cls):
+        subprocess.run(["make", "-s", "-C", _FWHOST], check=True, capture_output=True)
+        cls.samples = ring(N_SAMPLES)
+        with tempfile.TemporaryDirectory() as tmp:
+            fin, fout = os.path.join(tmp, "in.bin"), os.path.join(tmp, "out.bin")
+            with open(fin, "wb") as f:
+                f.write(upload(cls.samples))
+            subprocess.run([os.path.join(_FWHOST, "fwhost"), "-i", fin, "-o", fout,
+                            "-t", str(RUN_MS)], check=True, capture_output=True)
+            with open(fout, "rb") as f:
+                cls.keys = keyframes(parse(f.read()))
+
+    def test_keyframes_match(self):
+        from gngsim import Sim, wire
+        self.assertGreaterEqual(len(self.keys), 5, "fwhost sent too few keyframes")
+        sim = Sim(max_nodes=MAX_NODES)
+        sim.load(self.samples)
+        sim.reset()
+        for step, nodes, edges in self.keys:
+            sim.run(step - sim.steps)
+            self.assertEqual(sim.steps, step)
+            got = sorted((i, wire(x), wire(y)) for i, x, y in sim.nodes_raw())
+            self.assertEqual(got, nodes, f"nodes at step {step}")
+            self.assertEqual({(a, b) for a, b, _ in sim.edges()}, edges, f"edges at step {step}")
+
+
+@unittest.skipUnless(_can_build(), "needs make and a C compiler")
+class TestFwhostParams(unittest.TestCase):
+    def test_unit_rates_clamped(self):
+        subprocess.run(["make", "-s", "-C", _FWHOST], check=True, capture_output=True)
+        # lambda, a_max, eps_b = eps_n = 1.0, alpha 0.5, d 0.995 (Q16)
+        par = struct.pack("<6I", 100, 50, 65536, 65536, 32768, 65209)
+        with tempfile.TemporaryDirectory() as tmp:
+            fin, fout = os.path.join(tmp, "in.bin"), os.path.join(tmp, "out.bin")
+            with open(fin, "wb") as f:
+                f.write(frame(CMD_SET_PARAMS, par) + upload(ring(N_SAMPLES)))
+            subprocess.run([os.path.join(_FWHOST, "fwhost"), "-i", fin, "-o", fout,
+                            "-t", str(RUN_MS)], check=True, capture_output=True)
+            with open(fout, "rb") as f:
+                frames = parse(f.read())
+        acks = [p for cmd, p in frames if cmd == CMD_PARAMS_ACK]
+        self.assertTrue(acks, "no CMD_PARAMS_ACK")
+        self.assertEqual(struct.unpack_from("<6I", acks[0]),
+                         (100, 50, 32768, 32768, 32768, 65209))
+        keys = keyframes(frames)
+        self.assertGreaterEqual(len(keys), 5, "fwhost sent too few keyframes")
+        for step, nodes, _ in keys:
+            for i, x, y in nodes:
+                self.assertTrue(0 <= x < 1000 and 0 <= y < 1000,
+                                f"node {i} at ({x}, {y}) at step {step}")
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,385 @@
+"""
+V2 Python reference models against the loops they replaced
+==========================================================
+
+gng_neorv32_accelerator_V2/fw keeps two reference models that were
+rewritten over preallocated arrays:
+
+- gng_lite.GNG_Dist2Winner: slots with tombstones (act = False) and one
+  dist2 vector per step. ListDist2Winner below is the list / dict version
+  it replaced (nodes appended, removals shifting the rest down); both run
+  the same samples and must hold the same nodes, errors and edges (ages
+  included) after every step, node i of the list = the i-th active slot
+  in creation order (seq). A run on a coarse grid with rates 1/2 and 1/4
+  makes distances and errors tie, so slot reuse cannot reorder a tie-break;
+  a_max 6 ages edges out all the time (age + 1 encoding, > a_max + 1).
+  Over a two-moons run each step's s1 / s2 must also be the two nearest
+  active slots by np.linalg.norm + argsort.
+- gng_lite_fixed_point.GNGLite: distances_squared must equal the per-node
+  distance_squared loop (Q16.16 and float), find_two_nearest the argsort
+  of that loop; LoopGNGLite (the per-node / per-edge loops of train_step,
+  add_edge, get_neighbors, remove_isolated_nodes and insert_node's edge
+  search before the change) must train to the same weights, errors and
+  edge list, step by step, also on a grid where Q16.16 distances tie.
+
+gng_lite imports matplotlib for its animation; when matplotlib is missing
+it is stubbed, the model itself only needs numpy.
+
+    cd gng_host && python -m unittest discover -s tests
+
+Skipped without numpy.
+"""
+
+import os
+import sys
+import types
+import unittest
+
+_FW = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                   "..", "..", "gng_neorv32_accelerator_V2", "fw")
+sys.path.insert(0, _FW)
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+
+def _stub_matplotlib():
+    try:
+        import matplotlib  # noqa: F401
+        return
+    except ImportError:
+        pass
+    names = {"matplotlib": {}, "matplotlib.pyplot": {},
+             "matplotlib.animation": {"FuncAnimation": None},
+             "matplotlib.collections": {"LineCollection": None}}
+    for name, attrs in names.items():
+        mod = types.ModuleType(name)
+        mod.__dict__.update(attrs)
+        sys.modules[name] = mod
+
+
+if np is not None:
+    _stub_matplotlib()
+    import gng_lite
+    import gng_lite_fixed_point as glf
+
+
+class ListDist2Winner:
+    """gng_lite.GNG_Dist2Winner before the preallocated arrays."""
+
+    def __init__(self, max_nodes=40, a_max=50, lamb=50, eps_b=0.05, eps_n=0.006,
+                 alpha=0.5, beta=0.0005, init_nodes=((0.2, 0.2), (0.8, 0.8))):
+        self.max_nodes, self.a_max, self.lamb = max_nodes, a_max, lamb
+        self.eps_b, self.eps_n, self.alpha, self.beta = eps_b, eps_n, alpha, beta
+        self.nodes = [np.array(init_nodes[0], dtype=np.float64),
+                      np.array(init_nodes[1], dtype=np.float64)]
+        self.err = [0.0, 0.0]
+        self.adj = [dict(), dict()]
+        self.step_count = 0
+
+    def _remove_edge(self, i, j):
+        self.adj[i].pop(j, None)
+        self.adj[j].pop(i, None)
+
+    def _add_or_reset_edge(self, i, j):
+        self.adj[i][j] = 0
+        self.adj[j][i] = 0
+
+    def _remove_node(self, k):
+        for nb in list(self.adj[k].keys()):
+            self._remove_edge(k, nb)
+        self.nodes.pop(k)
+        self.err.pop(k)
+        self.adj.pop(k)
+        self.adj = [{nb - 1 if nb > k else nb: age for nb, age in a.items()} for a in self.adj]
+
+    def _insert_node(self):
+        q = int(np.argmax(self.err))
+        if len(self.adj[q]) == 0:
+            return
+        f = max(self.adj[q].keys(), key=lambda j: self.err[j])
+        r = len(self.nodes)
+        self.nodes.append(0.5 * (self.nodes[q] + self.nodes[f]))
+        self.err.append(self.err[q])
+        self.adj.append(dict())
+        self._remove_edge(q, f)
+        self._add_or_reset_edge(q, r)
+        self._add_or_reset_edge(r, f)
+        self.err[q] *= self.alpha
+        self.err[f] *= self.alpha
+        if len(self.nodes) > self.max_nodes:
+            idx = int(np.argmin(self.err))
+            if idx == r and len(self.nodes) > 3:
+                idx = int(np.argsort(self.err, kind="stable")[1])
+            self._remove_node(idx)
+
+    def step(self, x):
+        if len(self.nodes) < 2:
+            return
+        d = np.vstack(self.nodes) - x[None, :]
+        d1 = (d * d).sum(axis=1)
+        s1 = int(np.argmin(d1))
+        d1[s1] = np.inf
+        s2 = int(np.argmin(d1))
+        for nb in list(self.adj[s1].keys()):
+            self.adj[s1][nb] += 1
+            self.adj[nb][s1] += 1
+            if self.adj[s1][nb] > self.a_max:
+                self._remove_edge(s1, nb)
+        self._add_or_reset_edge(s1, s2)
+        dx = x - self.nodes[s1]
+        self.err[s1] += float(dx[0] * dx[0] + dx[1] * dx[1])
+        self.nodes[s1] += self.eps_b * (x - self.nodes[s1])
+        for nb in self.adj[s1].keys():
+            self.nodes[nb] += self.eps_n * (x - self.nodes[nb])
+        k = 0
+        while k < len(self.nodes):
+            if len(self.adj[k]) == 0:
+                self._remove_node(k)
+            else:
+                k += 1
+        self.step_count += 1
+        if self.lamb > 0 and self.step_count % self.lamb == 0 and len(self.nodes) >= 2:
+            self._insert_node()
+        if self.beta > 0.0:
+            for i in range(len(self.err)):
+                self.err[i] *= (1.0 - self.beta)
+
+
+def list_view(g):
+    """(nodes, errors, edges) of a GNG_Dist2Winner in list order: active
+    slots by seq, edges as {(i, j, age)} with i < j."""
+    slots = np.flatnonzero(g.act)
+    slots = slots[np.argsort(g.seq[slots])]
+    rank = {int(s): k for k, s in enumerate(slots)}
+    i, j = np.nonzero(np.triu(g.edge, 1))
+    edges = {(min(rank[a], rank[b]), max(rank[a], rank[b]), int(g.edge[a, b]) - 1)
+             for a, b in zip(i.tolist(), j.tolist())}
+    return g.W[slots], g.err[slots], edges
+
+
+def ref_view(ref):
+    edges = {(i, j, age) for i, a in enumerate(ref.adj) for j, age in a.items() if i < j}
+    return np.vstack(ref.nodes), np.array(ref.err), edges
+
+
+class LoopGNGLite(glf.GNGLite if np is not None else object):
+    """gng_lite_fixed_point.GNGLite with the per-edge loops it replaced."""
+
+    def find_two_nearest(self, sample):
+        distances = np.array([self.distance_squared(i, sample) for i in range(self.n_nodes)])
+        sorted_idx = np.argsort(distances)
+        return sorted_idx[0], sorted_idx[1]
+
+    def add_edge(self, n1, n2):
+        if n1 == n2:
+            return False
+        if n1 > n2:
+            n1, n2 = n2, n1
+        for i in range(self.n_edges):
+            if self.edge_nodes[i, 0] == n1 and self.edge_nodes[i, 1] == n2:
+                self.edge_ages[i] = 0
+                return True
+        if self.n_edges < self.cfg.max_edges:
+            self.edge_nodes[self.n_edges] = [n1, n2]
+            self.edge_ages[self.n_edges] = 0
+            self.n_edges += 1
+            return True
+        return False
+
+    def get_neighbors(self, node_idx):
+        neighbors = []
+        for i in range(self.n_edges):
+            if self.edge_nodes[i, 0] == node_idx:
+                neighbors.append(self.edge_nodes[i, 1])
+            elif self.edge_nodes[i, 1] == node_idx:
+                neighbors.append(self.edge_nodes[i, 0])
+        return neighbors
+
+    def train_step(self, sample):
+        if self.n_nodes < 2:
+            return
+        s1, s2 = self.find_two_nearest(sample)
+        dist_sq = self.distance_squared(s1, sample)
+        if self.cfg.use_fixed_point:
+            self.errors[s1] += dist_sq
+        else:
+            self.errors[s1] += dist_sq / glf.FIXED_POINT_SCALE
+        self.update_weights(s1, sample, self.eps_w)
+        for n in self.get_neighbors(s1):
+            self.update_weights(n, sample, self.eps_n)
+        self.add_edge(s1, s2)
+        for i in range(self.n_edges):
+            if self.edge_nodes[i, 0] == s1 or self.edge_nodes[i, 1] == s1:
+                self.edge_ages[i] += 1
+        i = 0
+        while i < self.n_edges:
+            if self.edge_ages[i] > self.cfg.max_age:
+                self.remove_edge(i)
+            else:
+                i += 1
+        self.remove_isolated_nodes()
+        self.iteration += 1
+        if self.iteration % self.cfg.lambda_ == 0 and self.n_nodes < self.cfg.max_nodes:
+            self.insert_node()
+        if self.cfg.use_fixed_point:
+            for i in range(self.n_nodes):
+                self.errors[i] = glf.fixed_mul(self.errors[i], self.beta_fixed)
+        else:
+            self.errors[:self.n_nodes] *= self.beta_fixed
+
+    def remove_isolated_nodes(self):
+        used = np.zeros(self.cfg.max_nodes, dtype=bool)
+        for i in range(self.n_edges):
+            used[self.edge_nodes[i, 0]] = True
+            used[self.edge_nodes[i, 1]] = True
+        new_idx = 0
+        mapping = np.zeros(self.cfg.max_nodes, dtype=np.int32) - 1
+        for old_idx in range(self.n_nodes):
+            if used[old_idx]:
+                if new_idx != old_idx:
+                    self.weights[new_idx] = self.weights[old_idx]
+                    self.errors[new_idx] = self.errors[old_idx]
+                mapping[old_idx] = new_idx
+                new_idx += 1
+        self.n_nodes = new_idx
+        for i in range(self.n_edges):
+            self.edge_nodes[i, 0] = mapping[self.edge_nodes[i, 0]]
+            self.edge_nodes[i, 1] = mapping[self.edge_nodes[i, 1]]
+
+    def _find_edge(self, n1, n2):
+        for i in range(self.n_edges):
+            if ((self.edge_nodes[i, 0] == n1 and self.edge_nodes[i, 1] == n2) or
+                    (self.edge_nodes[i, 0] == n2 and self.edge_nodes[i, 1] == n1)):
+                return i
+        return -1
+
+
+def two_nearest(w, act, x):
+    """(s1, s2) slots: per-node norm over the active slots, argsort."""
+    slots = np.flatnonzero(act)
+    order = np.argsort(np.linalg.norm(w[slots] - x, axis=1))
+    return int(slots[order[0]]), int(slots[order[1]])
+
+
+@unittest.skipIf(np is None, "needs numpy")
+class TestDist2Winner(unittest.TestCase):
+    def run_both(self, data, steps, **kw):
+        g = gng_lite.GNG_Dist2Winner(**kw)
+        ref = ListDist2Winner(**kw)
+        ties = 0
+        for k in range(steps):
+            x = data[k % len(data)]
+            d = ((np.vstack(ref.nodes) - x) ** 2).sum(axis=1)
+            ties += (d == d.min()).sum() > 1
+            g.step(x)
+            ref.step(x)
+            w, e, edges = list_view(g)
+            rw, re_, redges = ref_view(ref)
+            np.testing.assert_array_equal(w, rw, f"nodes after step {k}")
+            np.testing.assert_array_equal(e, re_, f"errors after step {k}")
+            self.assertEqual(edges, redges, f"edges after step {k}")
+        return ties
+
+    def test_list_version_moons(self):
+        data = gng_lite.generate_moons(N=1000, random_angle=True, seed=1234)
+        self.run_both(data, 3000, max_nodes=20, lamb=25)
+
+    def test_list_version_ties(self):
+        # dyadic grid and rates: exact ties in distances and errors
+        rng = np.random.default_rng(4)
+        data = rng.integers(0, 5, (400, 2)) / 4.0
+        ties = self.run_both(data, 3000, max_nodes=8, lamb=10, a_max=6, eps_b=0.5,
+                             eps_n=0.25, beta=0.0, init_nodes=((0.25, 0.25), (0.75, 0.75)))
+        self.assertGreater(ties, 50, "too few distance ties")
+
+    def test_edge_age_limit(self):
+        # age + 1 encoding: age a_max survives, a_max + 1 removes the edge
+        g = gng_lite.GNG_Dist2Winner(a_max=3)
+        g._add_or_reset_edge(0, 1)
+        for _ in range(3):
+            g._age_edges_of(0)
+        self.assertEqual(g.edge[0, 1], 4)
+        g._age_edges_of(0)
+        self.assertEqual((g.edge[0, 1], g.edge[1, 0], g.deg[0], g.deg[1]), (0, 0, 0, 0))
+
+    def test_winners_with_tombstones(self):
+        data = gng_lite.generate_moons(N=1000, random_angle=True, seed=1234)
+        g = gng_lite.GNG_Dist2Winner(max_nodes=40, seed=0)
+        for k in range(2500):
+            g.step(data[k % len(data)])
+        gaps = checked = 0
+        for k in range(2500, 4500):
+            x = data[k % len(data)]
+            used = np.flatnonzero(g.act)
+            gaps += not g.act[:used[-1]].all()
+            s1, s2 = two_nearest(g.W, g.act, x)
+            w1 = g.W[s1].copy()
+            g.step(x)
+            if not (g.act[s1] and g.act[s2]):
+                continue  # pruned by this step's insertion
+            checked += 1
+            np.testing.assert_array_equal(g.W[s1], w1 + g.eps_b * (x - w1), f"s1 at step {k}")
+            self.assertEqual(g.edge[s1, s2], 1, f"edge s1-s2 at step {k}")
+        self.assertGreater(gaps, 0, "no tombstone below the highest slot")
+        self.assertGreater(checked, 1900)
+
+
+@unittest.skipIf(np is None, "needs numpy")
+class TestGngLiteDistances(unittest.TestCase):
+    def check(self, fixed, dim):
+        rng = np.random.default_rng(17 + dim)
+        g = glf.GNGLite(glf.GNGLiteConfig(max_nodes=32, feature_dim=dim, use_fixed_point=fixed))
+        w = rng.random((32, dim))
+        if fixed:
+            g.weights[:] = [[glf.float_to_fixed(v) for v in row] for row in w]
+        else:
+            g.weights[:] = w.astype(np.float32)
+        for n in (2, 9, 32):
+            g.n_nodes = n
+            for sample in rng.random((50, dim)):
+                loop = [g.distance_squared(i, sample) for i in range(n)]
+                self.assertEqual(g.distances_squared(sample).tolist(), loop)
+                order = np.argsort(loop)
+                self.assertEqual(tuple(int(i) for i in g.find_two_nearest(sample)),
+                                 (int(order[0]), int(order[1])))
+
+    def test_fixed_point(self):
+        self.check(True, 2)
+        self.check(True, 5)
+
+    def test_float(self):
+        self.check(False, 2)
+        self.check(False, 5)
+
+    def train_both(self, fixed, data):
+        cfg = dict(max_nodes=20, max_edges=40, feature_dim=2, lambda_=30, max_age=20,
+                   use_fixed_point=fixed)
+        g, ref = glf.GNGLite(glf.GNGLiteConfig(**cfg)), LoopGNGLite(glf.GNGLiteConfig(**cfg))
+        for m in (g, ref):
+            np.random.seed(0)
+            m.initialize(data)
+        for k in range(1500):
+            g.train_step(data[k % len(data)])
+            ref.train_step(data[k % len(data)])
+            self.assertEqual((g.n_nodes, g.n_edges), (ref.n_nodes, ref.n_edges), f"step {k}")
+            n, m = g.n_nodes, g.n_edges
+            np.testing.assert_array_equal(g.weights[:n], ref.weights[:n], f"weights at step {k}")
+            np.testing.assert_array_equal(g.errors[:n], ref.errors[:n], f"errors at step {k}")
+            np.testing.assert_array_equal(g.edge_nodes[:m], ref.edge_nodes[:m], f"edges at step {k}")
+            np.testing.assert_array_equal(g.edge_ages[:m], ref.edge_ages[:m], f"ages at step {k}")
+        self.assertGreater(g.n_nodes, 10)
+
+    def test_loop_version_fixed(self):
+        # 1/8 grid: equal Q16.16 distances
+        data = np.random.default_rng(21).integers(0, 9, (500, 2)) / 8.0
+        self.train_both(True, data)
+
+    def test_loop_version_float(self):
+        self.train_both(False, np.random.default_rng(22).random((500, 2)).astype(np.float32))
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,197 @@
+"""
+gngio.metrics against the per-sample loops it replaced
+======================================================
+
+The reference is the loop of experiment_metrics.py / compute_metrics.py
+before the kernel: np.linalg.norm to every node per sample, a stable
+argsort for the two nearest (the (distance, node) order of compute_metrics
+and the firmware scan), an edge set lookup. Seeded random data, plus runs
+on a coarse grid where three and more nodes tie for s1 / s2 (CSV
+snapshots are quantized to 1/1000); both sides must pick the same nodes.
+
+    cd gng_host && python -m unittest discover -s tests
+
+Skipped without numpy.
+"""
+
+import os
+import sys
+import unittest
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), ".."))
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+if np is not None:
+    from gngio import metrics as gm
+
+
+def loop_winners(samples, xy):
+    """(s1, s2, d1) rows per sample, the old per-sample scan."""
+    s1, s2, d1 = [], [], []
+    for sample in samples:
+        distances = np.linalg.norm(xy - sample, axis=1)
+        order = np.argsort(distances, kind="stable")
+        s1.append(order[0])
+        s2.append(order[1] if len(order) > 1 else -1)
+        d1.append(distances[order[0]])
+    return np.array(s1), np.array(s2), np.array(d1)
+
+
+def loop_qe(samples, xy):
+    if len(xy) == 0:
+        return float("inf")
+    return float(loop_winners(samples, xy)[2].mean())
+
+
+def loop_te(samples, xy, edges, ids):
+    """edges hold node ids, ids[row] is the id of xy[row]."""
+    if len(xy) < 2:
+        return float("nan")
+    adjacency = set()
+    for a, b in edges:
+        adjacency.add((min(a, b), max(a, b)))
+    s1, s2, _ = loop_winners(samples, xy)
+    errors = 0
+    for a, b in zip(ids[s1], ids[s2]):
+        if (min(a, b), max(a, b)) not in adjacency:
+            errors += 1
+    return errors / len(samples)
+
+
+def random_edges(rng, ids, k):
+    if len(ids) < 2:
+        return np.zeros((0, 2), dtype=np.intp)
+    pairs = {tuple(sorted(rng.choice(ids, 2, replace=False))) for _ in range(k)}
+    return np.array(sorted(pairs), dtype=np.intp).reshape(-1, 2)
+
+
+def on_grid(v, grid):
+    """v snapped to multiples of 1 / grid (exact binary fractions for a
+    power of two, so equal distances compare equal)."""
+    return v if grid is None else np.round(np.asarray(v) * grid) / grid
+
+
+def snapshot_series(rng, n_snap=40, id_cap=48, grid=None):
+    """(ids, xy, edges) of a run: every snapshot moves some nodes, removes
+    some, adds some (fresh ids and reused ones), keeps the rest; one
+    snapshot drops to a single node and one to none. grid: positions on
+    multiples of 1 / grid (ties)."""
+    pos = {int(i): rng.random(2) for i in rng.choice(id_cap // 2, 12, replace=False)}
+    out = []
+    for t in range(n_snap):
+        if t == 15:
+            pos = {min(pos): pos[min(pos)]}
+        elif t == 25:
+            pos = {}
+        else:
+            ids = np.array(sorted(pos), dtype=np.intp)
+            if len(ids):
+                for i in rng.choice(ids, max(1, len(ids) // 4), replace=False):
+                    pos[int(i)] = np.clip(pos[int(i)] + rng.normal(0, 0.05, 2), 0, 1)
+            if len(ids) > 3:
+                for i in rng.choice(ids, rng.integers(0, 3), replace=False):
+                    del pos[int(i)]
+            free = [i for i in range(id_cap) if i not in pos]
+            for i in rng.choice(free, min(len(free), rng.integers(0, 4)), replace=False):
+                pos[int(i)] = rng.random(2)
+        ids = np.array(sorted(pos), dtype=np.intp)
+        xy = on_grid(np.array([pos[i] for i in ids]).reshape(-1, 2), grid)
+        out.append((ids, xy, random_edges(rng, ids, 2 * len(ids))))
+    return out
+
+
+@unittest.skipIf(np is None, "numpy not available")
+class TestKernel(unittest.TestCase):
+    def setUp(self):
+        rng = np.random.default_rng(7)
+        self.samples = rng.random((1500, 2))
+        self.xy = rng.random((37, 2))
+        self.ids = np.arange(len(self.xy))
+        self.edges = random_edges(rng, self.ids, 60)
+
+    def test_winners(self):
+        s1, s2, d1 = gm.winners(self.samples, self.xy, chunk=256)
+        r1, r2, rd = loop_winners(self.samples, self.xy)
+        np.testing.assert_array_equal(s1, r1)
+        np.testing.assert_array_equal(s2, r2)
+        np.testing.assert_allclose(np.sqrt(d1), rd, rtol=1e-12)
+
+    def test_qe_te_utilization(self):
+        self.assertAlmostEqual(gm.quantization_error(self.samples, self.xy, chunk=256),
+                               loop_qe(self.samples, self.xy), places=12)
+        self.assertEqual(gm.topological_error(self.samples, self.xy, self.edges, chunk=256),
+                         loop_te(self.samples, self.xy, self.edges, self.ids))
+        used = len(set(loop_winners(self.samples, self.xy)[0])) / len(self.xy)
+        self.assertEqual(gm.node_utilization(self.samples, self.xy), used)
+
+    def test_te_node_ids(self):
+        rng = np.random.default_rng(3)
+        ids = np.sort(rng.choice(200, len(self.xy), replace=False))
+        edges = ids[self.edges]
+        self.assertEqual(gm.topological_error(self.samples, self.xy, edges, ids=ids),
+                         loop_te(self.samples, self.xy, edges, ids))
+
+    def test_ties(self):
+        # 8 x 8 grid: most samples have three or more nodes at one distance
+        rng = np.random.default_rng(13)
+        samples = on_grid(rng.random((1500, 2)), 8)
+        xy = on_grid(rng.random((60, 2)), 8)
+        edges = random_edges(rng, np.arange(len(xy)), 90)
+        d = np.linalg.norm(xy[None, :, :] - samples[:, None, :], axis=2)
+        self.assertGreater(((d == d.min(axis=1, keepdims=True)).sum(axis=1) >= 3).sum(), 100)
+        s1, s2, _ = gm.winners(samples, xy, chunk=256)
+        r1, r2, _ = loop_winners(samples, xy)
+        np.testing.assert_array_equal(s1, r1)
+        np.testing.assert_array_equal(s2, r2)
+        self.assertEqual(gm.topological_error(samples, xy, edges, chunk=256),
+                         loop_te(samples, xy, edges, np.arange(len(xy))))
+
+    def test_one_node(self):
+        self.assertAlmostEqual(gm.quantization_error(self.samples, self.xy[:1]),
+                               loop_qe(self.samples, self.xy[:1]), places=12)
+        self.assertTrue(np.isnan(gm.topological_error(self.samples, self.xy[:1], [])))
+
+
+@unittest.skipIf(np is None, "numpy not available")
+class TestSnapshotScorer(unittest.TestCase):
+    def check_series(self, seed, grid=None):
+        rng = np.random.default_rng(seed)
+        samples = on_grid(rng.random((gm.CHUNK + 700, 2)), grid)  # two distance blocks
+        sc = gm.SnapshotScorer(samples)
+        for t, (ids, xy, edges) in enumerate(snapshot_series(rng, grid=grid)):
+            qe, te = sc.update(ids, xy, edges)
+            with self.subTest(snapshot=t, nodes=len(ids), grid=grid):
+                ref_qe = loop_qe(samples, xy)
+                if np.isinf(ref_qe):
+                    self.assertTrue(np.isinf(qe))
+                else:
+                    self.assertAlmostEqual(qe, ref_qe, places=12)
+                ref_te = loop_te(samples, xy, edges, ids)
+                if np.isnan(ref_te):
+                    self.assertTrue(np.isnan(te))
+                else:
+                    self.assertEqual(te, ref_te)
+
+    def test_series(self):
+        self.check_series(11)
+
+    def test_series_ties(self):
+        # incremental merges must keep the (distance, id) order of a rescan
+        self.check_series(12, grid=16)
+
+    def test_unchanged_snapshot(self):
+        rng = np.random.default_rng(5)
+        samples = rng.random((500, 2))
+        ids, xy, edges = snapshot_series(rng, n_snap=1)[0]
+        sc = gm.SnapshotScorer(samples)
+        first = sc.update(ids, xy, edges)
+        self.assertEqual(sc.update(ids, xy, edges), first)
+        self.assertEqual(sc.rescored, 0)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -0,0 +1,174 @@
+"""
+gng_ultra_optimized BMU searches against brute-force scans
+==========================================================
+
+gng_neorv32_accelerator_V2/fw/gng_ultra_optimized.py replaced its per-node
+loops with table kernels and matrix products. The references here are the
+plain scans: every node's distance, a stable argsort, the first row (ties
+keep the lower index, as the loops did).
+
+- BinaryGNG / TernaryGNG find_bmu, find_bmu_batch: Hamming / code-step L1
+  on unpacked codes, and BinaryGNG.find_bmu_loop; packed ties are common,
+  so this also pins the tie rule
+- HierarchicalGNG.find_bmu_hierarchical / find_bmu_batch: np.linalg.norm
+  to every finest node (exact), also for samples ~1e-11 off the midpoint of
+  two nodes near 1000, where ||w||^2 - 2 x.w cancels to either node
+- HierarchicalGNG.find_bmu_coarse: exact when top_k covers level 0, and
+  with the default top_k equal to a loop of the coarse-to-fine rule (top_k
+  nearest parents, their children by nearest parent, argmin)
+
+Hierarchy levels are seeded float weight sets standing in for trained
+GNGLite levels, so apart from the near-tie case there are no float
+distance ties.
+
+    cd gng_host && python -m unittest discover -s tests
+
+Skipped without numpy.
+"""
+
+import os
+import sys
+import unittest
+
+_FW = os.path.join(os.path.dirname(os.path.abspath(__file__)),
+                   "..", "..", "gng_neorv32_accelerator_V2", "fw")
+sys.path.insert(0, _FW)
+
+try:
+    import numpy as np
+except ImportError:
+    np = None
+
+if np is not None:
+    import gng_ultra_optimized as uo
+
+
+def first(distances):
+    return int(np.argsort(distances, kind="stable")[0])
+
+
+def ternary_codes(x):
+    return (np.asarray(x) >= 0.33).astype(np.int16) + (np.asarray(x) >= 0.67)
+
+
+class _Level:
+    """The part of GNGLite that HierarchicalGNG reads."""
+
+    def __init__(self, w):
+        self.w = np.asarray(w, dtype=np.float32)
+        self.iteration = 0
+        self.n_nodes = len(self.w)
+
+    def get_weights_as_float(self):
+        return self.w.copy()
+
+
+def hierarchy(sizes, dim=2, seed=3):
+    rng = np.random.default_rng(seed)
+    h = uo.HierarchicalGNG.__new__(uo.HierarchicalGNG)
+    h.levels = [_Level(rng.random((n, dim))) for n in sizes]
+    h._weights_cache = {}
+    return h
+
+
+def loop_hierarchical(ws, sample, top_k):
+    """Coarse-to-fine by per-node norms: the top_k nearest candidates of a
+    level pass on the next-level nodes whose nearest parent they are."""
+    cand = np.arange(len(ws[0]))
+    for li, w in enumerate(ws):
+        order = np.argsort(np.linalg.norm(w[cand] - sample, axis=1), kind="stable")
+        if li == len(ws) - 1:
+            return int(cand[order[0]])
+        best = set(cand[order[:top_k]].tolist())
+        nxt = ws[li + 1]
+        cand = np.array([j for j in range(len(nxt))
+                         if first(np.linalg.norm(w - nxt[j], axis=1)) in best], dtype=np.int64)
+        if len(cand) == 0:
+            cand = np.arange(len(nxt))
+    return 0
+
+
+@unittest.skipIf(np is None, "needs numpy")
+class TestPackedBmu(unittest.TestCase):
+    def setUp(self):
+        rng = np.random.default_rng(11)
+        self.nodes = rng.random((300, 32))
+        self.samples = rng.random((400, 32))
+
+    def test_binary(self):
+        g = uo.BinaryGNG(uo.BinaryGNGConfig(max_nodes=300, feature_dim=32))
+        g.weights_binary[:] = g.encode_binary_batch(self.nodes)
+        g.n_nodes = len(self.nodes)
+        bits = self.nodes > 0.5
+        ref = [first((bits != (s > 0.5)).sum(axis=1)) for s in self.samples]
+        self.assertEqual([g.find_bmu(s) for s in self.samples], ref)
+        self.assertEqual([g.find_bmu_loop(s) for s in self.samples], ref)
+        self.assertEqual(g.find_bmu_batch(self.samples).tolist(), ref)
+
+    def test_ternary(self):
+        # 30 codes: the last byte of a row is half padding
+        nodes, samples = self.nodes[:, :30], self.samples[:, :30]
+        g = uo.TernaryGNG(uo.BinaryGNGConfig(max_nodes=300, feature_dim=30))
+        g.weights_ternary[:] = g.encode_ternary_batch(nodes)
+        g.n_nodes = len(nodes)
+        codes = ternary_codes(nodes)
+        ref = [first(np.abs(codes - ternary_codes(s)).sum(axis=1)) for s in samples]
+        self.assertEqual([g.find_bmu(s) for s in samples], ref)
+        self.assertEqual(g.find_bmu_batch(samples).tolist(), ref)
+
+
+@unittest.skipIf(np is None, "needs numpy")
+class TestHierarchicalBmu(unittest.TestCase):
+    def setUp(self):
+        self.h = hierarchy((10, 40, 160))
+        self.ws = [lv.w.astype(np.float64) for lv in self.h.levels]
+        self.samples = np.random.default_rng(5).random((500, 2))
+
+    def test_batch_is_exact(self):
+        ref = [first(np.linalg.norm(self.ws[-1] - s, axis=1)) for s in self.samples]
+        level, got = self.h.find_bmu_batch(self.samples)
+        self.assertEqual(level, 2)
+        self.assertEqual(got.tolist(), ref)
+
+    def test_hierarchical_is_exact(self):
+        ref = [first(np.linalg.norm(self.ws[-1] - s, axis=1)) for s in self.samples]
+        got = [self.h.find_bmu_hierarchical(s) for s in self.samples]
+        self.assertEqual([lv for lv, _ in got], [2] * len(ref))
+        self.assertEqual([n for _, n in got], ref)
+
+    def test_near_ties(self):
+        # node pairs 2^-10 apart at 1000: ||w||^2 ~ 2e6, the distances differ by ~1e-13
+        h = hierarchy((4, 8))
+        w = 1000.0 + np.arange(16, dtype=np.float64).reshape(8, 2) * 2.0 ** -10
+        h.levels[1] = _Level(w)
+        mids = (w[0::2] + w[1::2]) / 2.0
+        samples = np.concatenate([mids + off * (w[1::2] - w[0::2]) for off in (-1e-8, 1e-8)])
+        ref = [first(np.linalg.norm(w - s, axis=1)) for s in samples]
+        self.assertEqual([h.find_bmu_hierarchical(s)[1] for s in samples], ref)
+        self.assertEqual(h.find_bmu_batch(samples)[1].tolist(), ref)
+
+    def test_coarse_full_top_k_is_exact(self):
+        ref = [first(np.linalg.norm(self.ws[-1] - s, axis=1)) for s in self.samples]
+        got = [self.h.find_bmu_coarse(s, top_k=len(self.ws[0])) for s in self.samples]
+        self.assertEqual([lv for lv, _ in got], [2] * len(ref))
+        self.assertEqual([n for _, n in got], ref)
+
+    def test_coarse_default_top_k(self):
+        ref = [loop_hierarchical(self.ws, s, uo.HIER_TOP_K) for s in self.samples]
+        got = [self.h.find_bmu_coarse(s)[1] for s in self.samples]
+        self.assertEqual(got, ref)
+
+    def test_coarse_children_follow_weights(self):
+        # a changed level (new training stamp) must not reuse stale children
+        self.h.find_bmu_coarse(self.samples[0])
+        rng = np.random.default_rng(9)
+        self.h.levels[1].w = rng.random((40, 2)).astype(np.float32)
+        self.h.levels[1].iteration += 1
+        self.ws[1] = self.h.levels[1].w.astype(np.float64)
+        ref = [loop_hierarchical(self.ws, s, uo.HIER_TOP_K) for s in self.samples]
+        got = [self.h.find_bmu_coarse(s)[1] for s in self.samples]
+        self.assertEqual(got, ref)
+
+
+if __name__ == "__main__":
+    unittest.main()
@@ -58,12 +58,24 @@ class Node:
     error: float = 0.0
     active: bool = False
 
-@dataclass
-class Edge:
-    a: int = 0
-    b: int = 0
-    age: int = 0
-    active: bool = False
+class EdgeTable:
+    """Edges as in the V3 firmware (gng_core.h): cell[a][b] = age + 1, 0 = no
+    edge (edge_cell, symmetric); nbr[i] = neighbor ids of i (degree =
+    len(nbr[i])). Lookups are O(1), aging / neighbor moves O(degree).
+    At most max_edges edges, a new one past that is dropped."""
+
+    def __init__(self, n_nodes, max_edges):
+        self.cell = [[0] * n_nodes for _ in range(n_nodes)]
+        self.nbr = [set() for _ in range(n_nodes)]
+        self.count = 0
+        self.max_edges = max_edges
+
+    def pairs(self):
+        """(a, b, age) of every edge, a < b."""
+        for a, nb in enumerate(self.nbr):
+            for b in nb:
+                if b > a:
+                    yield a, b, self.cell[a][b] - 1
 
 
 # ===============================
@@ -141,60 +153,40 @@ def find_winners(nodes, x, y):
     return s1, s2, d1
 
 def find_edge(edges, a, b):
-    aa, bb = (a, b) if a <= b else (b, a)
-    for i, e in enumerate(edges):
-        if not e.active:
-            continue
-        ea, eb = (e.a, e.b) if e.a <= e.b else (e.b, e.a)
-        if ea == aa and eb == bb:
-            return i
-    return -1
+    """Age of edge a-b, -1 if there is none."""
+    return edges.cell[a][b] - 1
 
 def connect_or_reset_edge(edges, a, b):
-    ei = find_edge(edges, a, b)
-    if ei >= 0:
-        edges[ei].a = a
-        edges[ei].b = b
-        edges[ei].age = 0
-        edges[ei].active = True
-        return
-
-    for e in edges:
-        if not e.active:
-            e.a = a
-            e.b = b
-            e.age = 0
-            e.active = True
-            return
-    # if full, drop silently (matches "limited edges" behavior)
+    if edges.cell[a][b] == 0:
+        if edges.count >= edges.max_edges:
+            return  # if full, drop silently (matches "limited edges" behavior)
+        edges.nbr[a].add(b)
+        edges.nbr[b].add(a)
+        edges.count += 1
+    edges.cell[a][b] = edges.cell[b][a] = 1  # age 0
 
 def remove_edge_pair(edges, a, b):
-    ei = find_edge(edges, a, b)
-    if ei >= 0:
-        edges[ei].active = False
+    if edges.cell[a][b]:
+        edges.cell[a][b] = edges.cell[b][a] = 0
+        edges.nbr[a].discard(b)
+        edges.nbr[b].discard(a)
+        edges.count -= 1
 
 def age_edges_from_winner(edges, w):
-    for e in edges:
-        if e.active and (e.a == w or e.b == w):
-            e.age += 1
+    row = edges.cell[w]
+    for nb in edges.nbr[w]:
+        row[nb] += 1
+        edges.cell[nb][w] += 1
 
-def delete_old_edges(edges):
-    for e in edges:
-        if e.active and e.age > GNG_A_MAX:
-            e.active = False
+# only the winner's edges age, so only they can pass GNG_A_MAX
+def delete_old_edges(edges, w):
+    row = edges.cell[w]
+    for nb in [nb for nb in edges.nbr[w] if row[nb] > GNG_A_MAX + 1]:
+        remove_edge_pair(edges, w, nb)
 
 def prune_isolated_nodes(nodes, edges):
     for i, n in enumerate(nodes):
-        if not n.active:
-            continue
-        has_edge = False
-        for e in edges:
-            if not e.active:
-                continue
-            if e.a == i or e.b == i:
-                has_edge = True
-                break
-        if not has_edge:
+        if n.active and not edges.nbr[i]:
             n.active = False
 
 def insert_node(nodes, edges):
@@ -209,15 +201,8 @@ def insert_node(nodes, edges):
 
     f = -1
     max_err = -1.0
-    for e in edges:
-        if not e.active:
-            continue
-        nb = -1
-        if e.a == q:
-            nb = e.b
-        elif e.b == q:
-            nb = e.a
-        if nb >= 0 and nodes[nb].active and nodes[nb].error > max_err:
+    for nb in edges.nbr[q]:
+        if nodes[nb].active and nodes[nb].error > max_err:
             max_err = nodes[nb].error
             f = nb
     if f < 0:
@@ -254,19 +239,15 @@ def train_one_step(nodes, edges, x, y):
     nodes[s1].x += GNG_EPSILON_B * (x - nodes[s1].x)
     nodes[s1].y += GNG_EPSILON_B * (y - nodes[s1].y)
 
-    # move neighbors by scanning edges
-    for e in edges:
-        if not e.active:
-            continue
-        if e.a == s1 or e.b == s1:
-            nb = e.b if e.a == s1 else e.a
-            if 0 <= nb < len(nodes) and nodes[nb].active:
-                nodes[nb].x += GNG_EPSILON_N * (x - nodes[nb].x)
-                nodes[nb].y += GNG_EPSILON_N * (y - nodes[nb].y)
+    # move neighbors of the winner
+    for nb in edges.nbr[s1]:
+        if nodes[nb].active:
+            nodes[nb].x += GNG_EPSILON_N * (x - nodes[nb].x)
+            nodes[nb].y += GNG_EPSILON_N * (y - nodes[nb].y)
 
     connect_or_reset_edge(edges, s1, s2)
 
-    delete_old_edges(edges)
+    delete_old_edges(edges, s1)
     prune_isolated_nodes(nodes, edges)
 
     # decay errors
@@ -279,7 +260,7 @@ def train_one_step(nodes, edges, x, y):
 
 def init_gng():
     nodes = [Node() for _ in range(MAX_NODES)]
-    edges = [Edge() for _ in range(MAX_EDGES)]
+    edges = EdgeTable(MAX_NODES, MAX_EDGES)
 
     # same init as your firmware
     nodes[0].x, nodes[0].y, nodes[0].active = 0.2, 0.2, True
@@ -292,7 +273,7 @@ def count_active_nodes(nodes):
     return sum(1 for n in nodes if n.active)
 
 def count_active_edges(edges):
-    return sum(1 for e in edges if e.active)
+    return edges.count
 
 
 # ===============================
@@ -375,13 +356,9 @@ class GNGApp:
         self.canvas.delete("gng")
 
         # edges
-        for e in self.edges:
-            if not e.active:
-                continue
-            if not (0 <= e.a < MAX_NODES and 0 <= e.b < MAX_NODES):
-                continue
-            na = self.nodes[e.a]
-            nb = self.nodes[e.b]
+        for a, b, _age in self.edges.pairs():
+            na = self.nodes[a]
+            nb = self.nodes[b]
             if not (na.active and nb.active):
                 continue
             x1, y1 = self._to_screen_right(na.x, na.y)
@@ -3,7 +3,13 @@
 -- - Node mem: 40 x 32-bit (packed Q1.15 x,y)
 -- - Winner scan: 1 node per clock
 -- - dist_u = dx^2 + dy^2 in Q2.30 (NO >>15)
--- - Bus: 1-cycle response (registered)
+-- - Bus: ack + read data on the clock after stb, back-to-back accesses
+--   (CPU stores / neorv32_dma word streams) need no idle cycle in between
+-- - Edge table: 80 x 25-bit registers at EDGE_BASE ([7:0]a [15:8]b
+--   [23:16]age [24]active), plus E_CMD ops that match all 80 entries in
+--   parallel: FIND/CONNECT/REMOVE (a,b), AGE(w), DEL_OLD (age > A_MAX),
+--   DEGREE(n), CLEAR. Result in E_RES: [7:0] index/degree, [8] hit,
+--   [23:16] MAX_EDGES (capability), [31] busy
 -- ================================================================================
 library ieee;
 use ieee.std_logic_1164.all;
@@ -44,12 +50,44 @@ architecture neorv32_cfs_rtl of neorv32_cfs is
   constant REG_OUT_MIN1   : natural := 14;
   constant REG_OUT_MIN2   : natural := 15;
 
+  constant REG_E_CMD      : natural := 248; -- [3:0] op, [15:8] a/w/n, [23:16] b
+  constant REG_E_RES      : natural := 249;
+
   constant MAXNODES  : natural := 40;
   constant NODE_BASE : natural := 128;
+  constant MAX_EDGES : natural := 80;
+  constant EDGE_BASE : natural := NODE_BASE + MAXNODES; -- 168
+
+  constant EOP_FIND    : natural := 1; -- index of edge (a,b)
+  constant EOP_CONNECT : natural := 2; -- reset age of (a,b), else take first free
+  constant EOP_REMOVE  : natural := 3; -- deactivate (a,b)
+  constant EOP_AGE     : natural := 4; -- age+1 (saturating) on active edges of w
+  constant EOP_DEL_OLD : natural := 5; -- deactivate edges with age > A_MAX
+  constant EOP_DEGREE  : natural := 6; -- number of active edges of n
+  constant EOP_CLEAR   : natural := 7; -- deactivate all
 
   type node_mem_t is array (0 to MAXNODES-1) of std_ulogic_vector(31 downto 0);
   signal node_mem : node_mem_t := (others => (others => '0'));
 
+  type edge_mem_t is array (0 to MAX_EDGES-1) of std_ulogic_vector(24 downto 0);
+  signal edge_mem : edge_mem_t := (others => (others => '0'));
+
+  -- edge window write / command, latched by the bus, applied by edge_cam
+  signal ew_we   : std_ulogic := '0';
+  signal ew_idx  : natural range 0 to MAX_EDGES-1 := 0;
+  signal ew_data : std_ulogic_vector(24 downto 0) := (others => '0');
+  signal ec_go   : std_ulogic := '0';
+  signal ec_op   : natural range 0 to 15 := 0;
+  signal ec_a    : std_ulogic_vector(7 downto 0) := (others => '0');
+  signal ec_b    : std_ulogic_vector(7 downto 0) := (others => '0');
+  signal a_max_u8 : unsigned(7 downto 0) := to_unsigned(50, 8);
+
+  -- DEGREE: per-8-edge counts registered on the command cycle, summed next
+  type grp_cnt_t is array (0 to (MAX_EDGES+7)/8-1) of unsigned(3 downto 0);
+  signal deg_grp  : grp_cnt_t := (others => (others => '0'));
+  signal deg_sum  : std_ulogic := '0';
+  signal e_res    : std_ulogic_vector(8 downto 0) := (others => '0');
+
   signal xin_q15       : unsigned(15 downto 0) := (others => '0');
   signal yin_q15       : unsigned(15 downto 0) := (others => '0');
   signal node_count_u8 : unsigned(7 downto 0)  := to_unsigned(2, 8);
@@ -70,18 +108,13 @@ architecture neorv32_cfs_rtl of neorv32_cfs is
   signal fsm : fsm_t := IDLE;
   signal i_u : unsigned(7 downto 0) := (others => '0');
 
-  signal stb_prev  : std_ulogic := '0';
-  signal req_valid : std_ulogic := '0';
-  signal req_rw    : std_ulogic := '0';
-  signal req_ben   : std_ulogic_vector(3 downto 0) := (others => '0');
-  signal req_idx_u : unsigned(13 downto 0) := (others => '0');
   signal accept    : std_ulogic;
 
 begin
 
   irq_o <= '0';
 
-  accept <= bus_req_i.stb and (not stb_prev) and (not req_valid);
+  accept <= bus_req_i.stb; -- single-shot strobe, one access per cycle
 
   -- ==========================================================
   -- Winner FSM (1 node/clock) - Q2.30 correct
@@ -178,6 +211,112 @@ begin
     end if;
   end process;
 
+  -- ==========================================================
+  -- Edge table + parallel match commands (1 cycle, DEGREE 2)
+  -- ==========================================================
+  edge_cam: process(clk_i, rstn_i)
+    variable act, pair, touch : std_ulogic_vector(MAX_EDGES-1 downto 0);
+    variable ea, eb           : std_ulogic_vector(7 downto 0);
+    variable p_hit, f_hit     : std_ulogic;
+    variable p_idx, f_idx     : natural range 0 to MAX_EDGES-1;
+    variable g                : unsigned(3 downto 0);
+    variable sum              : unsigned(7 downto 0);
+  begin
+    if rstn_i = '0' then
+      edge_mem <= (others => (others => '0'));
+      deg_sum  <= '0';
+      e_res    <= (others => '0');
+
+    elsif rising_edge(clk_i) then
+      deg_sum <= '0';
+
+      if deg_sum = '1' then
+        sum := (others => '0');
+        for k in deg_grp'range loop
+          sum := sum + deg_grp(k);
+        end loop;
+        e_res <= '0' & std_ulogic_vector(sum);
+      end if;
+
+      if ew_we = '1' then
+        edge_mem(ew_idx) <= ew_data;
+      end if;
+
+      if ec_go = '1' then
+        p_hit := '0'; p_idx := 0;
+        f_hit := '0'; f_idx := 0;
+        for i in MAX_EDGES-1 downto 0 loop -- lowest index wins
+          ea := edge_mem(i)(7 downto 0);
+          eb := edge_mem(i)(15 downto 8);
+          act(i) := edge_mem(i)(24);
+          pair(i) := act(i) and bool_to_ulogic_f(((ea = ec_a) and (eb = ec_b)) or
+                                                  ((ea = ec_b) and (eb = ec_a)));
+          touch(i) := act(i) and bool_to_ulogic_f((ea = ec_a) or (eb = ec_a));
+          if pair(i) = '1' then p_hit := '1'; p_idx := i; end if;
+          if act(i) = '0'  then f_hit := '1'; f_idx := i; end if;
+        end loop;
+
+        case ec_op is
+          when EOP_FIND =>
+            e_res <= p_hit & std_ulogic_vector(to_unsigned(p_idx, 8));
+
+          when EOP_CONNECT =>
+            if p_hit = '1' then
+              edge_mem(p_idx)(23 downto 16) <= (others => '0');
+              e_res <= '1' & std_ulogic_vector(to_unsigned(p_idx, 8));
+            elsif f_hit = '1' then
+              edge_mem(f_idx) <= '1' & x"00" & ec_b & ec_a;
+              e_res <= '1' & std_ulogic_vector(to_unsigned(f_idx, 8));
+            else
+              e_res <= (others => '0'); -- table full
+            end if;
+
+          when EOP_REMOVE =>
+            for i in 0 to MAX_EDGES-1 loop
+              if pair(i) = '1' then edge_mem(i)(24) <= '0'; end if;
+            end loop;
+            e_res <= p_hit & std_ulogic_vector(to_unsigned(p_idx, 8));
+
+          when EOP_AGE =>
+            for i in 0 to MAX_EDGES-1 loop
+              if (touch(i) = '1') and (edge_mem(i)(23 downto 16) /= x"FF") then
+                edge_mem(i)(23 downto 16) <=
+                  std_ulogic_vector(unsigned(edge_mem(i)(23 downto 16)) + 1);
+              end if;
+            end loop;
+
+          when EOP_DEL_OLD =>
+            for i in 0 to MAX_EDGES-1 loop
+              if unsigned(edge_mem(i)(23 downto 16)) > a_max_u8 then
+                edge_mem(i)(24) <= '0';
+              end if;
+            end loop;
+
+          when EOP_DEGREE =>
+            for k in deg_grp'range loop
+              g := (others => '0');
+              for j in 0 to 7 loop
+                if (8*k + j < MAX_EDGES) and (touch((8*k + j) mod MAX_EDGES) = '1') then
+                  g := g + 1;
+                end if;
+              end loop;
+              deg_grp(k) <= g;
+            end loop;
+            deg_sum <= '1';
+
+          when EOP_CLEAR =>
+            for i in 0 to MAX_EDGES-1 loop
+              edge_mem(i)(24) <= '0';
+            end loop;
+
+          when others =>
+            null;
+        end case;
+      end if;
+
+    end if;
+  end process;
+
   -- ==========================================================
   -- Bus (1-cycle response), NO blocking-read
   -- ==========================================================
@@ -186,34 +325,27 @@ begin
     variable di      : natural;
 
     constant C_LAMBDA : std_ulogic_vector(31 downto 0) := std_ulogic_vector(to_unsigned(100,32));
-    constant C_A_MAX  : std_ulogic_vector(31 downto 0) := std_ulogic_vector(to_unsigned(50,32));
   begin
     if rstn_i = '0' then
       bus_rsp_o <= rsp_terminate_c;
-      req_valid <= '0';
-      req_rw    <= '0';
-      req_ben   <= (others => '0');
-      req_idx_u <= (others => '0');
-      stb_prev    <= '0';
       start_pulse <= '0';
       clear_pulse <= '0';
+      ew_we       <= '0';
+      ec_go       <= '0';
+      a_max_u8    <= to_unsigned(50, 8);
 
     elsif rising_edge(clk_i) then
-      stb_prev <= bus_req_i.stb;
-
       bus_rsp_o.ack  <= '0';
       bus_rsp_o.err  <= '0';
       bus_rsp_o.data <= (others => '0');
 
       start_pulse <= '0';
       clear_pulse <= '0';
+      ew_we       <= '0';
+      ec_go       <= '0';
 
       if accept = '1' then
-        req_valid <= '1';
-        req_rw    <= bus_req_i.rw;
-        req_ben   <= bus_req_i.ben;
-        req_idx_u <= unsigned(bus_req_i.addr(15 downto 2));
-
+        bus_rsp_o.ack <= '1';
         reg_idx := to_integer(unsigned(bus_req_i.addr(15 downto 2)));
 
         if (bus_req_i.rw = '1') and (bus_req_i.ben = "1111") then
@@ -221,6 +353,9 @@ begin
             if bus_req_i.data(0) = '1' then clear_pulse <= '1'; end if;
             if bus_req_i.data(1) = '1' then start_pulse <= '1'; end if;
 
+          elsif reg_idx = REG_A_MAX then
+            a_max_u8 <= unsigned(bus_req_i.data(7 downto 0));
+
           elsif reg_idx = REG_XIN then
             xin_q15 <= unsigned(bus_req_i.data(15 downto 0));
           elsif reg_idx = REG_YIN then
@@ -235,16 +370,20 @@ begin
           elsif (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + MAXNODES) then
             di := reg_idx - NODE_BASE;
             node_mem(di) <= bus_req_i.data;
+
+          elsif (reg_idx >= EDGE_BASE) and (reg_idx < EDGE_BASE + MAX_EDGES) then
+            ew_we   <= '1';
+            ew_idx  <= reg_idx - EDGE_BASE;
+            ew_data <= bus_req_i.data(24 downto 0);
+          elsif reg_idx = REG_E_CMD then
+            ec_go <= '1';
+            ec_op <= to_integer(unsigned(bus_req_i.data(3 downto 0)));
+            ec_a  <= bus_req_i.data(15 downto 8);
+            ec_b  <= bus_req_i.data(23 downto 16);
           end if;
         end if;
-      end if;
 
-      if req_valid = '1' then
-        req_valid     <= '0';
-        bus_rsp_o.ack <= '1';
-        reg_idx := to_integer(req_idx_u);
-
-        if req_rw = '0' then
+        if bus_req_i.rw = '0' then
           if reg_idx = REG_CTRL then
             bus_rsp_o.data(16) <= busy;
             bus_rsp_o.data(17) <= done;
@@ -252,7 +391,7 @@ begin
           elsif reg_idx = REG_LAMBDA then
             bus_rsp_o.data <= C_LAMBDA;
           elsif reg_idx = REG_A_MAX then
-            bus_rsp_o.data <= C_A_MAX;
+            bus_rsp_o.data(7 downto 0) <= std_ulogic_vector(a_max_u8);
 
           elsif reg_idx = REG_XIN then
             bus_rsp_o.data(15 downto 0) <= std_ulogic_vector(xin_q15);
@@ -276,6 +415,14 @@ begin
           elsif (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + MAXNODES) then
             di := reg_idx - NODE_BASE;
             bus_rsp_o.data <= node_mem(di);
+
+          elsif (reg_idx >= EDGE_BASE) and (reg_idx < EDGE_BASE + MAX_EDGES) then
+            di := reg_idx - EDGE_BASE;
+            bus_rsp_o.data(24 downto 0) <= edge_mem(di);
+          elsif reg_idx = REG_E_RES then
+            bus_rsp_o.data(8 downto 0)   <= e_res;
+            bus_rsp_o.data(23 downto 16) <= std_ulogic_vector(to_unsigned(MAX_EDGES, 8));
+            bus_rsp_o.data(31)           <= ec_go or deg_sum;
           end if;
         end if;
       end if;
@@ -137,6 +137,7 @@ begin
     IO_GPIO_NUM      => IO_GPIO_NUM,     -- number of GPIO input/output pairs (0..32)
     IO_CLINT_EN      => true,            -- implement core local interruptor (CLINT)?
     IO_UART0_EN      => true,            -- implement primary universal asynchronous receiver/transmitter (UART0)?
+    IO_DMA_EN        => true,            -- implement direct memory access controller (DMA)? (V2 fw edge/data bursts)
     OCD_EN            => true,               -- implement JTAG interface
 
     IO_CFS_EN       => true,
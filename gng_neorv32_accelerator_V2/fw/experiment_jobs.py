@@ -0,0 +1,129 @@
+"""
+Job Runner for the GNG Experiment Scripts
+=========================================
+
+Every experiment point (dataset x config x seed) is one Job: a module-level
+function plus JSON-able keyword arguments. run_jobs() runs them on a process
+pool and caches each result on disk under the hash of its configuration:
+
+    cache/<key>.json      key = sha256(function, kwargs, seed)[:16]
+
+- resumable: a job whose cache file exists is not run again, an interrupted
+  run continues with the missing jobs only
+- per-job seeds: the worker seeds numpy's global RNG (np.random.seed) with
+  the job seed before the call, so a result does not depend on which worker
+  ran it or in which order
+- a result is written as soon as its job finishes (tmp file + os.replace),
+  a crash loses at most the jobs still running
+- reports (tables, figures) are built from cached results only:
+  run_jobs(..., run=False) returns what is cached and lists what is missing
+
+    jobs = [Job("moons/fixed/s0", evaluate_job, {"dataset": "two_moons"}, seed=0)]
+    results = run_jobs(jobs, Path("paper_results/cache"), workers=8)
+    results["moons/fixed/s0"]   # whatever evaluate_job returned
+
+Change CACHE_VERSION when a job function changes its output for the same
+arguments; older cache files are then simply not found.
+"""
+
+import hashlib
+import json
+import os
+import time
+from concurrent.futures import ProcessPoolExecutor, as_completed
+from dataclasses import dataclass, field
+from pathlib import Path
+from typing import Callable, Dict, List
+
+import numpy as np
+
+CACHE_VERSION = 1
+
+
+@dataclass
+class Job:
+    """name: key of the result in run_jobs(); fn(**kwargs) -> JSON-able dict."""
+    name: str
+    fn: Callable
+    kwargs: Dict = field(default_factory=dict)
+    seed: int = 0
+
+    @property
+    def key(self) -> str:
+        # qualname only: the same function hashes alike whether its script
+        # runs as __main__ or is imported
+        spec = {
+            "version": CACHE_VERSION,
+            "fn": self.fn.__qualname__,
+            "kwargs": self.kwargs,
+            "seed": self.seed,
+        }
+        blob = json.dumps(spec, sort_keys=True, default=str).encode()
+        return hashlib.sha256(blob).hexdigest()[:16]
+
+
+def _run_one(fn, kwargs, seed):
+    np.random.seed(seed)
+    t0 = time.perf_counter()
+    out = fn(**kwargs)
+    return out, time.perf_counter() - t0
+
+
+def _store(path: Path, job: Job, result, seconds: float):
+    tmp = path.with_suffix(".tmp")
+    with open(tmp, "w") as f:
+        json.dump({"name": job.name, "fn": job.fn.__qualname__, "kwargs": job.kwargs,
+                   "seed": job.seed, "seconds": seconds, "result": result}, f, indent=1)
+    os.replace(tmp, path)
+
+
+def run_jobs(jobs: List[Job], cache_dir: Path, workers: int = None,
+             run: bool = True, verbose: bool = True) -> Dict[str, dict]:
+    """Results by job name. workers = None -> os.cpu_count(), 1 -> in-process
+    (no pool, easier to debug). run = False: cached results only."""
+    cache_dir = Path(cache_dir)
+    cache_dir.mkdir(parents=True, exist_ok=True)
+
+    results = {}
+    todo = []
+    for job in jobs:
+        path = cache_dir / f"{job.key}.json"
+        if path.exists():
+            with open(path) as f:
+                results[job.name] = json.load(f)["result"]
+        else:
+            todo.append(job)
+
+    if verbose:
+        print(f"    jobs: {len(jobs)} total, {len(results)} cached, {len(todo)} to run")
+    if not todo or not run:
+        if todo and verbose:
+            for job in todo:
+                print(f"    missing: {job.name}")
+        return results
+
+    t0 = time.perf_counter()
+    done = 0
+
+    def finish(job, out, seconds):
+        nonlocal done
+        _store(cache_dir / f"{job.key}.json", job, out, seconds)
+        results[job.name] = out
+        done += 1
+        if verbose:
+            print(f"    [{done}/{len(todo)}] {job.name} ({seconds:.1f} s)")
+
+    if workers == 1:
+        for job in todo:
+            out, seconds = _run_one(job.fn, job.kwargs, job.seed)
+            finish(job, out, seconds)
+    else:
+        with ProcessPoolExecutor(max_workers=workers) as pool:
+            futures = {pool.submit(_run_one, job.fn, job.kwargs, job.seed): job for job in todo}
+            for fut in as_completed(futures):
+                out, seconds = fut.result()
+                finish(futures[fut], out, seconds)
+
+    if verbose:
+        print(f"    ran {len(todo)} jobs in {time.perf_counter() - t0:.1f} s")
+    return results
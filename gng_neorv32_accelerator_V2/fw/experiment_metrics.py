@@ -16,6 +16,8 @@ References:
 [3] Marsland, S., et al. (2002). A self-organising network that grows when required.
 """
 
+import os
+import sys
 import numpy as np
 import time
 import matplotlib.pyplot as plt
@@ -24,6 +26,9 @@ from dataclasses import dataclass, asdict
 import json
 import pickle
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "gng_host"))
+from gngio import metrics as gm
+
 
 @dataclass
 class MetricsResult:
@@ -68,20 +73,8 @@ class GNGMetricsEvaluator:
         
         Reference: Martinetz & Schulten (1994)
         """
-        test_data = np.asarray(test_data, dtype=np.float32)
         weights = gng_model.get_weights_as_float()
-        
-        if len(weights) == 0:
-            return float('inf')
-        
-        total_error = 0.0
-        for sample in test_data:
-            # Find BMU
-            distances = np.linalg.norm(weights - sample, axis=1)
-            min_dist = np.min(distances)
-            total_error += min_dist
-        
-        return total_error / len(test_data)
+        return gm.quantization_error(test_data, weights)
     
     @staticmethod
     def topological_error(gng_model, test_data: np.ndarray) -> float:
@@ -95,31 +88,13 @@ class GNGMetricsEvaluator:
         
         Reference: Martinetz & Schulten (1994)
         """
-        test_data = np.asarray(test_data, dtype=np.float32)
         weights = gng_model.get_weights_as_float()
         edges = gng_model.get_edges_as_list()
         
         if len(weights) < 2:
             return 1.0  # Maximum error
         
-        # Build adjacency set for O(1) lookup
-        adjacency = set()
-        for e1, e2 in edges:
-            adjacency.add((min(e1, e2), max(e1, e2)))
-        
-        topological_errors = 0
-        for sample in test_data:
-            # Find two nearest nodes
-            distances = np.linalg.norm(weights - sample, axis=1)
-            sorted_indices = np.argsort(distances)
-            bmu1, bmu2 = sorted_indices[0], sorted_indices[1]
-            
-            # Check if they are connected
-            edge_key = (min(bmu1, bmu2), max(bmu1, bmu2))
-            if edge_key not in adjacency:
-                topological_errors += 1
-        
-        return topological_errors / len(test_data)
+        return gm.topological_error(test_data, weights, edges)
     
     @staticmethod
     def memory_usage(gng_model) -> Dict[str, int]:
@@ -137,19 +112,8 @@ class GNGMetricsEvaluator:
         
         Higher is better. Measures how well nodes are distributed.
         """
-        test_data = np.asarray(test_data, dtype=np.float32)
         weights = gng_model.get_weights_as_float()
-        
-        if len(weights) == 0:
-            return 0.0
-        
-        used_nodes = set()
-        for sample in test_data:
-            distances = np.linalg.norm(weights - sample, axis=1)
-            bmu = np.argmin(distances)
-            used_nodes.add(bmu)
-        
-        return len(used_nodes) / len(weights)
+        return gm.node_utilization(test_data, weights)
     
     @staticmethod
     def edge_density(gng_model) -> float:
@@ -59,6 +59,19 @@ def generate_moons(
 # =========================================================
 # GNG "biasa" (Fritzke), tapi winner pakai dist2 (L2^2)
 # =========================================================
+# State is preallocated like the V3 firmware (gng_core.h):
+#   W[i], err[i]     node i (slot), valid where act[i]
+#   edge[i, j]       age + 1, 0 = no edge (edge_cell), symmetric
+#   deg[i]           active edges at i
+# A removed node is a tombstone (act = False); the next insertion reuses the
+# lowest free slot, so no index ever shifts. One spare slot holds the node
+# inserted past max_nodes until the prune right after it.
+# Ties go the way the list version (nodes appended, removals shifting the
+# rest down) broke them:
+#   seq[i]           creation order of node i = its old list position order;
+#                    argmin / argmax ties pick the lowest seq
+#   stamp[i, j]      creation order of edge i-j = the old adjacency dict
+#                    order of row i; f ties pick the lowest stamp
 class GNG_Dist2Winner:
     def __init__(
         self,
@@ -83,84 +96,107 @@ class GNG_Dist2Winner:
 
         rng = np.random.default_rng(seed)
 
-        # nodes: list of np.array([x,y])
-        self.nodes = [np.array(init_nodes[0], dtype=np.float64),
-                      np.array(init_nodes[1], dtype=np.float64)]
-
-        # errors
-        self.err = [0.0, 0.0]
-
-        # adjacency: list of dict {neighbor_id: age}
-        self.adj = [dict(), dict()]
+        cap = self.max_nodes + 1
+        self.W = np.zeros((cap, 2), dtype=np.float64)
+        self.err = np.zeros(cap, dtype=np.float64)
+        self.act = np.zeros(cap, dtype=bool)
+        self.edge = np.zeros((cap, cap), dtype=np.int32)
+        self.deg = np.zeros(cap, dtype=np.int32)
+        self.seq = np.zeros(cap, dtype=np.int64)
+        self.stamp = np.zeros((cap, cap), dtype=np.int64)
+        self.seq[:2] = (0, 1)
+        self.next_seq = 2
+        self.next_stamp = 0
+
+        self.W[0] = init_nodes[0]
+        self.W[1] = init_nodes[1]
+        self.act[:2] = True
 
         self.step_count = 0
         self.rng = rng
 
+    @property
+    def nodes(self) -> np.ndarray:
+        """(M, 2) positions of the active nodes, in slot order."""
+        return self.W[self.act]
+
+    @property
+    def n_nodes(self) -> int:
+        return int(self.act.sum())
+
     def _dist2(self, x: np.ndarray) -> np.ndarray:
-        W = np.vstack(self.nodes)  # (M,2)
-        d = W - x[None, :]
-        return (d * d).sum(axis=1)
+        d = self.W - x[None, :]
+        d2 = (d * d).sum(axis=1)
+        d2[~self.act] = np.inf
+        return d2
 
     def _euclid_sq(self, w: np.ndarray, x: np.ndarray) -> float:
         d = x - w
         return float(d[0] * d[0] + d[1] * d[1])
 
-    def _neighbors(self, i: int):
-        return list(self.adj[i].keys())
+    def _neighbors(self, i: int) -> np.ndarray:
+        return np.flatnonzero(self.edge[i])
+
+    def _first(self, v: np.ndarray, best) -> int:
+        # slot with v == best that comes first in node order (seq)
+        idx = np.flatnonzero(v == best)
+        return int(idx[np.argmin(self.seq[idx])])
 
     def _remove_edge(self, i: int, j: int):
-        if j in self.adj[i]:
-            del self.adj[i][j]
-        if i in self.adj[j]:
-            del self.adj[j][i]
+        if self.edge[i, j]:
+            self.edge[i, j] = self.edge[j, i] = 0
+            self.deg[i] -= 1
+            self.deg[j] -= 1
 
     def _add_or_reset_edge(self, i: int, j: int):
-        self.adj[i][j] = 0
-        self.adj[j][i] = 0
+        if not self.edge[i, j]:
+            self.deg[i] += 1
+            self.deg[j] += 1
+            self.stamp[i, j] = self.stamp[j, i] = self.next_stamp
+            self.next_stamp += 1
+        self.edge[i, j] = self.edge[j, i] = 1  # age 0
 
     def _remove_node(self, k: int):
-        # remove all edges connected to k
-        for nb in list(self.adj[k].keys()):
-            self._remove_edge(k, nb)
-
-        # pop node k
-        self.nodes.pop(k)
-        self.err.pop(k)
-        self.adj.pop(k)
-
-        # reindex adjacency (all indices > k shift down by 1)
-        for i in range(len(self.adj)):
-            newd = {}
-            for nb, age in self.adj[i].items():
-                nb2 = nb - 1 if nb > k else nb
-                newd[nb2] = age
-            self.adj[i] = newd
+        # remove all edges connected to k, then tombstone the slot
+        nb = self._neighbors(k)
+        self.deg[nb] -= 1
+        self.edge[k, :] = 0
+        self.edge[:, k] = 0
+        self.deg[k] = 0
+        self.err[k] = 0.0
+        self.act[k] = False
 
     def _age_edges_of(self, s1: int):
-        # increase ages of edges from s1 and prune old ones
-        for nb in list(self.adj[s1].keys()):
-            self.adj[s1][nb] += 1
-            self.adj[nb][s1] += 1
-            if self.adj[s1][nb] > self.a_max:
-                self._remove_edge(s1, nb)
+        # increase ages of edges from s1 and prune old ones (age > a_max)
+        nb = self._neighbors(s1)
+        self.edge[s1, nb] += 1
+        self.edge[nb, s1] += 1
+        old = nb[self.edge[s1, nb] > self.a_max + 1]
+        if len(old):
+            self.edge[s1, old] = 0
+            self.edge[old, s1] = 0
+            self.deg[old] -= 1
+            self.deg[s1] -= len(old)
 
     def _insert_node(self):
         # q = argmax error
-        q = int(np.argmax(self.err))
-        if len(self.adj[q]) == 0:
+        e = np.where(self.act, self.err, -np.inf)
+        q = self._first(e, e.max())
+        if self.deg[q] == 0:
             return  # no neighbor -> cannot insert
 
         # f = neighbor of q with max error
-        f = max(self.adj[q].keys(), key=lambda j: self.err[j])
-
-        # new node r at midpoint
-        r_pos = 0.5 * (self.nodes[q] + self.nodes[f])
-
-        # add r
-        r = len(self.nodes)
-        self.nodes.append(r_pos.copy())
-        self.err.append(self.err[q])
-        self.adj.append(dict())
+        nb = self._neighbors(q)
+        nb = nb[self.err[nb] == self.err[nb].max()]
+        f = int(nb[np.argmin(self.stamp[q, nb])])
+
+        # new node r at midpoint, lowest free slot, last in node order
+        r = int(np.argmin(self.act))
+        self.W[r] = 0.5 * (self.W[q] + self.W[f])
+        self.err[r] = self.err[q]
+        self.act[r] = True
+        self.seq[r] = self.next_seq
+        self.next_seq += 1
 
         # remove edge q-f
         self._remove_edge(q, f)
@@ -174,24 +210,28 @@ class GNG_Dist2Winner:
         self.err[f] *= self.alpha
 
         # if exceed max_nodes, you can stop growing or prune lowest-error node
-        if len(self.nodes) > self.max_nodes:
+        n = self.n_nodes
+        if n > self.max_nodes:
             # prune node with smallest error that is NOT q/f/r if possible
-            idx = int(np.argmin(self.err))
+            # by (error, node order); the list version's argsort was
+            # unstable past 16 nodes, this is its stable order
+            e = np.where(self.act, self.err, np.inf)
+            order = np.lexsort((self.seq, e))
+            idx = int(order[0])
             # avoid deleting the newest one immediately
-            if idx == r and len(self.nodes) > 3:
-                idx = int(np.argsort(self.err)[1])
+            if idx == r and n > 3:
+                idx = int(order[1])
             self._remove_node(idx)
 
     def step(self, x: np.ndarray):
-        M = len(self.nodes)
-        if M < 2:
+        if self.n_nodes < 2:
             return
 
         # 1) find s1,s2 using dist2 (L2^2)
         d1 = self._dist2(x)
-        s1 = int(np.argmin(d1))
+        s1 = self._first(d1, d1.min())
         d1[s1] = np.inf
-        s2 = int(np.argmin(d1))
+        s2 = self._first(d1, d1.min())
 
         # 2) age edges from s1, prune
         self._age_edges_of(s1)
@@ -200,46 +240,37 @@ class GNG_Dist2Winner:
         self._add_or_reset_edge(s1, s2)
 
         # 4) accumulate error at s1 (GNG biasa pakai L2^2)
-        self.err[s1] += self._euclid_sq(self.nodes[s1], x)
+        self.err[s1] += self._euclid_sq(self.W[s1], x)
 
         # (kalau kamu mau error juga ikut Manhattan: ganti jadi:)
-        # self.err[s1] += float(np.abs(self.nodes[s1] - x).sum())
+        # self.err[s1] += float(np.abs(self.W[s1] - x).sum())
 
         # 5) move s1 toward x
-        self.nodes[s1] += self.eps_b * (x - self.nodes[s1])
+        self.W[s1] += self.eps_b * (x - self.W[s1])
 
         # 6) move neighbors of s1 toward x
-        for nb in self._neighbors(s1):
-            self.nodes[nb] += self.eps_n * (x - self.nodes[nb])
-
-        # 7) remove isolated nodes
-        # (loop careful karena index bisa berubah saat remove)
-        k = 0
-        while k < len(self.nodes):
-            if len(self.adj[k]) == 0:
-                self._remove_node(k)
-                # do not increment k (items shifted)
-            else:
-                k += 1
+        nb = self._neighbors(s1)
+        self.W[nb] += self.eps_n * (x - self.W[nb])
+
+        # 7) remove isolated nodes (tombstones, no re-indexing)
+        iso = self.act & (self.deg == 0)
+        if iso.any():
+            self.act[iso] = False
+            self.err[iso] = 0.0
 
         # 8) insert every lambda steps
         self.step_count += 1
-        if self.lamb > 0 and (self.step_count % self.lamb == 0) and (len(self.nodes) >= 2):
+        if self.lamb > 0 and (self.step_count % self.lamb == 0) and (self.n_nodes >= 2):
             self._insert_node()
 
         # 9) global error decay
         if self.beta > 0.0:
-            for i in range(len(self.err)):
-                self.err[i] *= (1.0 - self.beta)
+            self.err *= (1.0 - self.beta)
 
     def get_segments(self):
         """Return line segments for edges (unique)."""
-        segs = []
-        for i in range(len(self.nodes)):
-            for j, age in self.adj[i].items():
-                if j > i:
-                    segs.append([self.nodes[i], self.nodes[j]])
-        return segs
+        i, j = np.nonzero(np.triu(self.edge, 1))
+        return np.stack((self.W[i], self.W[j]), axis=1)
 
 
 # =========================================================
@@ -318,14 +349,13 @@ def main():
             gng.step(X[idx])
             idx = (idx + 1) % len(X)
 
-        W = np.vstack(gng.nodes) if len(gng.nodes) > 0 else np.empty((0, 2))
-        nodes_sc.set_offsets(W)
+        nodes_sc.set_offsets(gng.nodes)
 
         segs = gng.get_segments()
         lc.set_segments(segs)
 
         txt.set_text(
-            f"step={gng.step_count}  nodes={len(gng.nodes)}  edges={len(segs)}"
+            f"step={gng.step_count}  nodes={gng.n_nodes}  edges={len(segs)}"
         )
         return nodes_sc, lc, txt
 
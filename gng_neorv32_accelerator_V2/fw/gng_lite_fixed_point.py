@@ -237,11 +237,26 @@ class GNGLite:
             diff = self.weights[node_idx, :self.cfg.feature_dim] - sample
             return int(np.sum(diff * diff) * FIXED_POINT_SCALE)
     
+    def distances_squared(self, sample: np.ndarray) -> np.ndarray:
+        """distance_squared() of every node at once, same values."""
+        w = self.weights[:self.n_nodes, :self.cfg.feature_dim]
+        if self.cfg.use_fixed_point:
+            sf = np.array([float_to_fixed(v) for v in sample[:self.cfg.feature_dim]], dtype=np.int64)
+            diff = w.astype(np.int64) - sf
+            return ((diff * diff) >> FIXED_POINT_BITS).sum(axis=1)
+        diff = w - sample
+        return ((diff * diff).sum(axis=1) * FIXED_POINT_SCALE).astype(np.int64)
+
     def find_two_nearest(self, sample: np.ndarray) -> Tuple[int, int]:
         """Find indices of two nearest nodes."""
-        distances = np.array([self.distance_squared(i, sample) for i in range(self.n_nodes)])
-        sorted_idx = np.argsort(distances)
+        sorted_idx = np.argsort(self.distances_squared(sample))
         return sorted_idx[0], sorted_idx[1]
+
+    def _find_edge(self, n1: int, n2: int) -> int:
+        """Slot of edge n1-n2 (n1 < n2), -1 if there is none."""
+        e = self.edge_nodes[:self.n_edges]
+        hit = np.flatnonzero((e[:, 0] == n1) & (e[:, 1] == n2))
+        return int(hit[0]) if len(hit) else -1
     
     def add_edge(self, n1: int, n2: int) -> bool:
         """Add edge between nodes n1 and n2."""
@@ -253,10 +268,10 @@ class GNGLite:
             n1, n2 = n2, n1
         
         # Check if edge already exists
-        for i in range(self.n_edges):
-            if self.edge_nodes[i, 0] == n1 and self.edge_nodes[i, 1] == n2:
-                self.edge_ages[i] = 0  # Reset age
-                return True
+        i = self._find_edge(n1, n2)
+        if i >= 0:
+            self.edge_ages[i] = 0  # Reset age
+            return True
         
         # Add new edge if space available
         if self.n_edges < self.cfg.max_edges:
@@ -276,14 +291,11 @@ class GNGLite:
             self.n_edges -= 1
     
     def get_neighbors(self, node_idx: int) -> List[int]:
-        """Get all neighbors of a node."""
-        neighbors = []
-        for i in range(self.n_edges):
-            if self.edge_nodes[i, 0] == node_idx:
-                neighbors.append(self.edge_nodes[i, 1])
-            elif self.edge_nodes[i, 1] == node_idx:
-                neighbors.append(self.edge_nodes[i, 0])
-        return neighbors
+        """Get all neighbors of a node (in edge list order)."""
+        e = self.edge_nodes[:self.n_edges]
+        first = e[:, 0] == node_idx
+        idx = np.flatnonzero(first | (e[:, 1] == node_idx))
+        return list(np.where(first[idx], e[idx, 1], e[idx, 0]))
     
     def update_weights(self, node_idx: int, sample: np.ndarray, learning_rate: int):
         """Update node weights towards sample."""
@@ -323,17 +335,16 @@ class GNGLite:
         self.add_edge(s1, s2)
         
         # Increment age of all edges emanating from s1
-        for i in range(self.n_edges):
-            if self.edge_nodes[i, 0] == s1 or self.edge_nodes[i, 1] == s1:
-                self.edge_ages[i] += 1
-        
-        # Remove edges with age > max_age
-        i = 0
-        while i < self.n_edges:
-            if self.edge_ages[i] > self.cfg.max_age:
-                self.remove_edge(i)
-            else:
-                i += 1
+        e = self.edge_nodes[:self.n_edges]
+        self.edge_ages[:self.n_edges][(e[:, 0] == s1) | (e[:, 1] == s1)] += 1
+        
+        # Remove edges with age > max_age (order of the rest kept)
+        keep = self.edge_ages[:self.n_edges] <= self.cfg.max_age
+        if not keep.all():
+            k = int(keep.sum())
+            self.edge_nodes[:k] = self.edge_nodes[:self.n_edges][keep]
+            self.edge_ages[:k] = self.edge_ages[:self.n_edges][keep]
+            self.n_edges = k
         
         # Remove nodes without edges (isolated)
         self.remove_isolated_nodes()
@@ -354,28 +365,21 @@ class GNGLite:
         """Remove nodes without edges."""
         # Build node usage mask
         used = np.zeros(self.cfg.max_nodes, dtype=bool)
-        for i in range(self.n_edges):
-            used[self.edge_nodes[i, 0]] = True
-            used[self.edge_nodes[i, 1]] = True
+        used[self.edge_nodes[:self.n_edges].ravel()] = True
         
-        # Keep only used nodes (compact)
-        new_idx = 0
+        # Keep only used nodes (compact, order kept)
+        kept = np.flatnonzero(used[:self.n_nodes])
+        if len(kept) == self.n_nodes:
+            return
+        new_n = len(kept)
+        self.weights[:new_n] = self.weights[kept]
+        self.errors[:new_n] = self.errors[kept]
         mapping = np.zeros(self.cfg.max_nodes, dtype=np.int32) - 1
-        
-        for old_idx in range(self.n_nodes):
-            if used[old_idx]:
-                if new_idx != old_idx:
-                    self.weights[new_idx] = self.weights[old_idx]
-                    self.errors[new_idx] = self.errors[old_idx]
-                mapping[old_idx] = new_idx
-                new_idx += 1
-        
-        self.n_nodes = new_idx
+        mapping[kept] = np.arange(new_n, dtype=np.int32)
+        self.n_nodes = new_n
         
         # Update edge indices
-        for i in range(self.n_edges):
-            self.edge_nodes[i, 0] = mapping[self.edge_nodes[i, 0]]
-            self.edge_nodes[i, 1] = mapping[self.edge_nodes[i, 1]]
+        self.edge_nodes[:self.n_edges] = mapping[self.edge_nodes[:self.n_edges]]
     
     def insert_node(self):
         """Insert new node between node with highest error and its neighbor."""
@@ -401,11 +405,9 @@ class GNGLite:
             self.weights[new_idx] = (self.weights[q] + self.weights[f]) / 2
         
         # Remove edge q-f
-        for i in range(self.n_edges):
-            if ((self.edge_nodes[i, 0] == q and self.edge_nodes[i, 1] == f) or
-                (self.edge_nodes[i, 0] == f and self.edge_nodes[i, 1] == q)):
-                self.remove_edge(i)
-                break
+        i = self._find_edge(min(q, f), max(q, f))
+        if i >= 0:
+            self.remove_edge(i)
         
         # Add edges q-new and f-new
         self.add_edge(q, new_idx)
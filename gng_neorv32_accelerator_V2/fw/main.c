@@ -14,21 +14,26 @@
 #define BAUD_RATE 1000000
 
 /**********************************************************************//**
- * ---------------- GNG TUNABLE PARAMETERS (EDIT HERE) ----------------
- **************************************************************************/
-#define GNG_LAMBDA      100
-#define GNG_EPSILON_B   0.3f
-#define GNG_EPSILON_N   0.001f
-#define GNG_ALPHA       0.5f
-#define GNG_A_MAX       50
-#define GNG_D           0.995f
-
-/**********************************************************************//**
- * Limits
+ * GNG core (../../gng_core): parameters GNG_LAMBDA, GNG_EPSILON_B, ... and
+ * the step are shared with every other firmware; gng_cfs.h adds the CFS
+ * winner search (dirty-node flush, DMA node sync) behind gng_step()
+ * GNG_COMPACT: live nodes renumbered to 0..n-1 now and then, NODE_COUNT =
+ * n, so the V1 CFS scans only those (snapshots are full, no remap frame)
+ * V2_EDGE_CAM: edges in the V1 CFS edge CAM (one parallel-match op per
+ * connect / age / delete) instead of the core edge_cell rows; probed at
+ * boot, the core path runs when the bitstream has no CAM
  **************************************************************************/
 #define MAXPTS      100
 #define MAX_NODES    40
-#define MAX_EDGES    80
+#ifndef V2_EDGE_CAM
+#define V2_EDGE_CAM   1
+#endif
+#define MAX_EDGE_PAIRS_PER_FRAME 126  // 2 + 2*count <= 255
+#define GNG_COMPACT   1
+#define COMPACT_EVERY 1000  // steps between two checks
+#define COMPACT_SLACK    2  // holes below the span that start a compaction
+
+#include "gng_cfs.h"
 
 /**********************************************************************//**
  * UART protocol (split frames)
@@ -59,44 +64,18 @@ static uint8_t  rx_index = 0;
 static uint8_t  rx_sum   = 0;
 static uint8_t  rx_payload[256];
 
-// Dataset in CPU (stream points)
-static float dataX[MAXPTS];
-static float dataY[MAXPTS];
+// Dataset in CPU (Q1.15 x | y << 16, the CFS XIN/YIN word)
+static sample_t dataQ[MAXPTS];
 static int   dataCount = 0;
 static bool  dataDone  = false;
 static bool  running   = false;
 
-// Node CPU struct (edges stored in CFS BRAM)
-typedef struct {
-  float x, y;
-  float error;
-  bool  active;
-} Node;
-
-static Node nodes[MAX_NODES];
-
-static int stepCount = 0;
 static int dataIndex = 0;
 static uint8_t frame_id = 0;
 
-// ---------------- Utility ----------------
-static float dist2(float x1, float y1, float x2, float y2) {
-  float dx = x1 - x2;
-  float dy = y1 - y2;
-  return dx*dx + dy*dy;
-}
-
-static int findFreeNode(void) {
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) return i;
-  }
-  return -1;
-}
-
 // ============================================================================
-// ======================  CFS REG MAP (must match VHDL)  ======================
+// ======  V1 CFS registers beyond gng_cfs.h (must match VHDL)  ===============
 // ============================================================================
-#define CFS_REG_CTRL       0
 #define CFS_REG_COUNT      1
 #define CFS_REG_LAMBDA     2
 #define CFS_REG_A_MAX      3
@@ -104,25 +83,31 @@ static int findFreeNode(void) {
 #define CFS_REG_EPS_N      5
 #define CFS_REG_ALPHA      6
 #define CFS_REG_D          7
-#define CFS_REG_XIN        8
-#define CFS_REG_YIN        9
-#define CFS_REG_NODE_COUNT 10
-#define CFS_REG_ACT_LO     11
-#define CFS_REG_ACT_HI     12
-#define CFS_REG_OUT_S12    13
-#define CFS_REG_OUT_MIN1   14
-#define CFS_REG_OUT_MIN2   15
 
 #define CFS_DATA_BASE      16
-#define CFS_NODE_BASE      128
-#define CFS_EDGE_BASE      168  // NEW: must match VHDL EDGE_BASE
 
-#define CFS_CTRL_CLEAR     (1u << 0)
-#define CFS_CTRL_START     (1u << 1)
-#define CFS_STATUS_BUSY    (1u << 16)
-#define CFS_STATUS_DONE    (1u << 17)
-
-static bool g_has_cfs = false;
+#if V2_EDGE_CAM
+#define CFS_EDGE_BASE      168  // must match VHDL EDGE_BASE
+#define CFS_REG_E_CMD      248  // edge op: [3:0] op, [15:8] a/w/n, [23:16] b
+#define CFS_REG_E_RES      249  // [7:0] index/degree, [8] hit, [23:16] MAX_EDGES, [31] busy
+#define CFS_MAX_EDGES      80
+
+#define CFS_EOP_FIND       1u
+#define CFS_EOP_CONNECT    2u
+#define CFS_EOP_REMOVE     3u
+#define CFS_EOP_AGE        4u
+#define CFS_EOP_DEL_OLD    5u   // age > CFS_REG_A_MAX
+#define CFS_EOP_DEGREE     6u
+#define CFS_EOP_CLEAR      7u
+#define CFS_E_HIT          (1u << 8)
+#define CFS_E_BUSY         (1u << 31)
+
+#if GNG_UTILITY || GNG_DRIFT || GNG_PARAMS_RT
+#error "V2_EDGE_CAM: cam_update() mirrors the plain gng_update() (no utility / drift / runtime params)"
+#endif
+#endif
+
+static bool g_edge_cam = false; // CFS matches all edges per op (E_RES reports CFS_MAX_EDGES)
 
 // ===================== Fixed-point helpers =====================
 static inline uint16_t float_to_q16(float v) {
@@ -133,199 +118,152 @@ static inline uint16_t float_to_q16(float v) {
   return (uint16_t)q;
 }
 
-static inline int16_t float_to_q15_pos(float v) {
-  if (v <= 0.0f) return 0;
-  if (v >= 0.9999694824f) return (int16_t)0x7FFF;
-  int32_t q = (int32_t)(v * 32768.0f + 0.5f);
-  if (q > 0x7FFF) q = 0x7FFF;
-  return (int16_t)q;
-}
-
-static inline uint32_t pack_node_q15(float x, float y) {
-  int16_t xq = float_to_q15_pos(x);
-  int16_t yq = float_to_q15_pos(y);
-  return ((uint32_t)(uint16_t)xq) | (((uint32_t)(uint16_t)yq) << 16);
-}
-
-static inline float q30_to_float(uint32_t q30) {
-  return (float)q30 / 1073741824.0f;
-}
+// ---------------- UART frame TX ----------------
+static void uart_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  uint8_t sum = (uint8_t)(cmd + len);
+  for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
+  uint8_t chk = (uint8_t)(~sum);
 
-// ===================== EDGE BRAM packing =====================
-// [7:0]=a, [15:8]=b, [23:16]=age, [24]=active
-static inline uint32_t pack_edge(uint8_t a, uint8_t b, uint8_t age, bool active) {
-  uint32_t v = (uint32_t)a | ((uint32_t)b << 8) | ((uint32_t)age << 16);
-  if (active) v |= (1u << 24);
-  return v;
+  neorv32_uart0_putc((char)UART_HDR);
+  neorv32_uart0_putc((char)UART_HDR);
+  neorv32_uart0_putc((char)cmd);
+  neorv32_uart0_putc((char)len);
+  for (uint8_t i = 0; i < len; i++) neorv32_uart0_putc((char)payload[i]);
+  neorv32_uart0_putc((char)chk);
 }
 
-static inline void unpack_edge(uint32_t v, uint8_t *a, uint8_t *b, uint8_t *age, bool *active) {
-  *a = (uint8_t)(v & 0xFFu);
-  *b = (uint8_t)((v >> 8) & 0xFFu);
-  *age = (uint8_t)((v >> 16) & 0xFFu);
-  *active = ((v >> 24) & 0x1u) ? true : false;
-}
+#if V2_EDGE_CAM
+// ===================== Edge CAM backend (V1 CFS) =====================
+// window word: [7:0] a, [15:8] b, [23:16] age, [24] active; the core
+// nbr rows stay empty, so FOR_EACH_NEIGHBOR walks nothing on this path
 
-static inline uint32_t edge_read_word(int i) {
-  return NEORV32_CFS->REG[CFS_EDGE_BASE + i];
+// one parallel-match op over the whole edge table
+static inline void cam_op(uint32_t op, int a, int b) {
+  CFS_WR(CFS_REG_E_CMD, op | ((uint32_t)(uint8_t)a << 8) | ((uint32_t)(uint8_t)b << 16));
 }
 
-static inline void edge_write_word(int i, uint32_t w) {
-  NEORV32_CFS->REG[CFS_EDGE_BASE + i] = w;
+static inline uint32_t cam_op_res(uint32_t op, int a, int b) {
+  cam_op(op, a, b);
+  uint32_t r;
+  do { r = CFS_RD(CFS_REG_E_RES); } while (r & CFS_E_BUSY);
+  return r;
 }
 
-static inline void edges_clear_all(void) {
-  for (int i = 0; i < MAX_EDGES; i++) edge_write_word(i, 0u);
+// whole edge window into RAM (burst when the SoC has a DMA)
+static void cam_read_all(uint32_t *w) {
+  if (g_has_dma &&
+      dma_copy_words(w, (const uint32_t *)&NEORV32_CFS->REG[CFS_EDGE_BASE], CFS_MAX_EDGES)) return;
+  for (int e = 0; e < CFS_MAX_EDGES; e++) w[e] = CFS_RD(CFS_EDGE_BASE + e);
 }
 
-// return edge index if exists else -1 (EDGE in BRAM)
-static int findEdge(int a, int b) {
-  for (int i = 0; i < MAX_EDGES; i++) {
-    uint8_t ea, eb, age;
-    bool active;
-    unpack_edge(edge_read_word(i), &ea, &eb, &age, &active);
-    if (!active) continue;
-    if ((ea == (uint8_t)a && eb == (uint8_t)b) ||
-        (ea == (uint8_t)b && eb == (uint8_t)a)) {
-      return i;
-    }
+// neighbors of n (window order) into nb[], returns their count
+static int cam_neighbors(const uint32_t *ew, int n, uint8_t *nb) {
+  int k = 0;
+  for (int e = 0; e < CFS_MAX_EDGES; e++) {
+    uint32_t v = ew[e];
+    if (!((v >> 24) & 1u)) continue;
+    int a = (int)(v & 0xFFu), b = (int)((v >> 8) & 0xFFu);
+    if (a == n) nb[k++] = (uint8_t)b;
+    else if (b == n) nb[k++] = (uint8_t)a;
   }
-  return -1;
+  return k;
 }
 
-static void connectOrResetEdge(int a, int b) {
-  int ei = findEdge(a, b);
-  if (ei >= 0) {
-    edge_write_word(ei, pack_edge((uint8_t)a, (uint8_t)b, 0, true));
-    return;
-  }
+// insertNode_fritzke() with the q - f split done by the CAM
+static int cam_insert(void) {
+  int r = findFreeNode();
+  if (r < 0) return -1;
+  int q = emax_top();
+  if (q < 0) return -1;
 
-  for (int i = 0; i < MAX_EDGES; i++) {
-    uint8_t ea, eb, age;
-    bool active;
-    unpack_edge(edge_read_word(i), &ea, &eb, &age, &active);
-    if (!active) {
-      edge_write_word(i, pack_edge((uint8_t)a, (uint8_t)b, 0, true));
-      return;
-    }
+  uint32_t ew[CFS_MAX_EDGES];
+  uint8_t nb[CFS_MAX_EDGES];
+  cam_read_all(ew);
+  int f = -1;
+  const int k = cam_neighbors(ew, q, nb);
+  for (int j = 0; j < k; j++) {
+    // lowest index on a tie, as the core row scan
+    if (f < 0 || err_node_gt(nb[j], f) || (!err_node_gt(f, nb[j]) && nb[j] < f)) f = nb[j];
   }
-}
+  if (f < 0) return -1;
 
-static void removeEdgePair(int a, int b) {
-  int ei = findEdge(a, b);
-  if (ei >= 0) {
-    uint8_t ea, eb, age;
-    bool active;
-    unpack_edge(edge_read_word(ei), &ea, &eb, &age, &active);
-    (void)active;
-    edge_write_word(ei, pack_edge(ea, eb, age, false));
-  }
+  node_mid(r, q, f);
+  node_set_active(r, true);
+  cam_op(CFS_EOP_REMOVE, q, f);
+  cam_op(CFS_EOP_CONNECT, q, r);
+  cam_op(CFS_EOP_CONNECT, r, f);
+
+  err_touch(q);
+  err_touch(f);
+  nodes[q].error = err_scale(nodes[q].error, ALPHA);
+  nodes[f].error = err_scale(nodes[f].error, ALPHA);
+  nodes[r].error = nodes[q].error;
+  err_mark_now(r);
+  emax_update(q);
+  emax_update(f);
+  emax_update(r);
+  return r;
 }
 
-static void ageEdgesFromWinner(int w) {
-  for (int i = 0; i < MAX_EDGES; i++) {
-    uint8_t a, b, age;
-    bool active;
-    unpack_edge(edge_read_word(i), &a, &b, &age, &active);
-    if (!active) continue;
-    if ((int)a == w || (int)b == w) {
-      edge_write_word(i, pack_edge(a, b, (uint8_t)(age + 1u), true));
-    }
-  }
-}
+// gng_update() with the edges in the CAM: steps (C) - (F) are CAM ops, the
+// prune asks DEGREE of the old neighbors of s1 (only they can lose an edge)
+static void cam_update(pos_t x, pos_t y, int s1, int s2, dist_t d1) {
+  uint32_t ew[CFS_MAX_EDGES];
+  uint8_t nb[CFS_MAX_EDGES];
 
-static void deleteOldEdges(void) {
-  for (int i = 0; i < MAX_EDGES; i++) {
-    uint8_t a, b, age;
-    bool active;
-    unpack_edge(edge_read_word(i), &a, &b, &age, &active);
-    if (!active) continue;
-    if (age > (uint8_t)GNG_A_MAX) {
-      edge_write_word(i, pack_edge(a, b, age, false));
-    }
-  }
-}
+  // (A) error accumulate
+  err_accum(s1, d1);
+  qe_track(d1);
 
-static void pruneIsolatedNodes(void) {
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-
-    bool has_edge = false;
-    for (int e = 0; e < MAX_EDGES; e++) {
-      uint8_t a, b, age;
-      bool active;
-      unpack_edge(edge_read_word(e), &a, &b, &age, &active);
-      if (!active) continue;
-      if ((int)a == i || (int)b == i) { has_edge = true; break; }
-    }
-    if (!has_edge) nodes[i].active = false;
-  }
-}
+  // (B) move winner
+  node_step(s1, x, y, EPS_B_STEP);
+  node_mark_dirty(s1);
 
-// Fritzke insertion rule
-// Fritzke insertion rule (FIXED to match Fritzke 1995)
-static int insertNode(void) {
-  int q = -1;
-  float maxErr = -1.0f;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].active && nodes[i].error > maxErr) { maxErr = nodes[i].error; q = i; }
+  // (C) age edges + move neighbors
+  cam_read_all(ew);
+  const int k = cam_neighbors(ew, s1, nb);
+  cam_op(CFS_EOP_AGE, s1, 0);
+  for (int j = 0; j < k; j++) {
+    node_step(nb[j], x, y, EPS_N_STEP);
+    node_mark_dirty(nb[j]);
   }
-  if (q < 0) return -1;
-
-  int f = -1;
-  maxErr = -1.0f;
 
-  for (int i = 0; i < MAX_EDGES; i++) {
-    uint8_t a, b, age; bool active;
-    unpack_edge(edge_read_word(i), &a, &b, &age, &active);
-    if (!active) continue;
+  // (D) connect winners, (E) delete old edges
+  cam_op(CFS_EOP_CONNECT, s1, s2);
+  cam_op(CFS_EOP_DEL_OLD, 0, 0);
 
-    int nb = -1;
-    if ((int)a == q) nb = (int)b;
-    else if ((int)b == q) nb = (int)a;
-
-    if (nb >= 0 && nb < MAX_NODES && nodes[nb].active && nodes[nb].error > maxErr) {
-      maxErr = nodes[nb].error;
-      f = nb;
+  // (F) prune isolated nodes
+  for (int j = 0; j < k; j++) {
+    if (nb[j] != s2 && (cam_op_res(CFS_EOP_DEGREE, nb[j], 0) & 0xFFu) == 0u) {
+      node_set_active(nb[j], false);
     }
   }
-  if (f < 0) return -1;
-
-  int r = findFreeNode();
-  if (r < 0) return -1;
-
-  // new unit position
-  nodes[r].x = 0.5f * (nodes[q].x + nodes[f].x);
-  nodes[r].y = 0.5f * (nodes[q].y + nodes[f].y);
-  nodes[r].active = true;
 
-  // topology update
-  removeEdgePair(q, f);
-  connectOrResetEdge(q, r);
-  connectOrResetEdge(r, f);
+  stepCount++;
 
-  // ---- FIX: error update order (Fritzke 1995) ----
-  nodes[q].error *= GNG_ALPHA;
-  nodes[f].error *= GNG_ALPHA;
-  nodes[r].error  = nodes[q].error;   // r gets the NEW value of q
+  // (G) insert every lambda
+  if (gng_insert_due()) {
+    int r = cam_insert();
+    if (r >= 0) { node_mark_dirty(r); g_inserts++; }
+  }
 
-  return r;
+  // (H) lazy decay update
+  err_decay_step();
+  if (error_renorm_if_needed()) g_renorms++;
+#if GNG_ERR_BFP
+  err_sweep();
+#endif
 }
 
-
-// ---------------- UART frame TX ----------------
-static void uart_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
-  uint8_t sum = (uint8_t)(cmd + len);
-  for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
-  uint8_t chk = (uint8_t)(~sum);
-
-  neorv32_uart0_putc((char)UART_HDR);
-  neorv32_uart0_putc((char)UART_HDR);
-  neorv32_uart0_putc((char)cmd);
-  neorv32_uart0_putc((char)len);
-  for (uint8_t i = 0; i < len; i++) neorv32_uart0_putc((char)payload[i]);
-  neorv32_uart0_putc((char)chk);
+static inline bool cam_step(pos_t x, pos_t y) {
+  int s1 = -1, s2 = -1;
+  dist_t d1 = DIST_MAX;
+  GNG_FIND_WINNERS(x, y, &s1, &s2, &d1);
+  if (s1 < 0 || s2 < 0) return false;
+  cam_update(x, y, s1, s2, d1);
+  return true;
 }
+#endif
 
 static void sendGNGNodes(void) {
   uint8_t payload[2 + MAX_NODES * 5];
@@ -335,11 +273,9 @@ static void sendGNGNodes(void) {
   payload[p++] = 0;
 
   uint8_t node_count = 0;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-
-    int16_t xi = (int16_t)(nodes[i].x * 1000.0f);
-    int16_t yi = (int16_t)(nodes[i].y * 1000.0f);
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    int16_t xi = pos_to_wire(nodes[i].x);
+    int16_t yi = pos_to_wire(nodes[i].y);
 
     payload[p++] = (uint8_t)i;
     payload[p++] = (uint8_t)(xi & 0xFF);
@@ -353,21 +289,33 @@ static void sendGNGNodes(void) {
 }
 
 static void sendGNGEdges(void) {
-  uint8_t payload[2 + MAX_EDGES * 2];
+  uint8_t payload[2 + MAX_EDGE_PAIRS_PER_FRAME * 2];
   uint8_t p = 0;
 
   payload[p++] = frame_id;
   payload[p++] = 0;
 
+  // neighbor rows, j > i so each edge once
   uint8_t edge_count = 0;
-  for (int i = 0; i < MAX_EDGES; i++) {
-    uint8_t a, b, age;
-    bool active;
-    unpack_edge(edge_read_word(i), &a, &b, &age, &active);
-    if (!active) continue;
-    payload[p++] = a;
-    payload[p++] = b;
-    edge_count++;
+#if V2_EDGE_CAM
+  if (g_edge_cam) {
+    uint32_t ew[CFS_MAX_EDGES];
+    cam_read_all(ew);
+    for (int e = 0; e < CFS_MAX_EDGES && edge_count < MAX_EDGE_PAIRS_PER_FRAME; e++) {
+      if (!((ew[e] >> 24) & 1u)) continue;
+      payload[p++] = (uint8_t)(ew[e] & 0xFFu);
+      payload[p++] = (uint8_t)((ew[e] >> 8) & 0xFFu);
+      edge_count++;
+    }
+  }
+#endif
+  FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+    FOR_EACH_NEIGHBOR(j, i, i + 1, MAX_NODES) {
+      if (edge_count == MAX_EDGE_PAIRS_PER_FRAME) continue;  // frame full
+      payload[p++] = (uint8_t)i;
+      payload[p++] = (uint8_t)j;
+      edge_count++;
+    }
   }
 
   payload[1] = edge_count;
@@ -387,8 +335,7 @@ static void handleCommand(uint8_t cmd, const uint8_t *payload, uint8_t len) {
       int16_t yi = (int16_t)((uint16_t)payload[pos + 2] | ((uint16_t)payload[pos + 3] << 8));
       pos += 4;
       if (dataCount < MAXPTS) {
-        dataX[dataCount] = (float)xi / 1000.0f;
-        dataY[dataCount] = (float)yi / 1000.0f;
+        dataQ[dataCount] = q15_from_wire(xi) | (q15_from_wire(yi) << 16);
         dataCount++;
       }
     }
@@ -449,169 +396,41 @@ static void cfs_write_settings(void) {
   NEORV32_CFS->REG[CFS_REG_D]      = (uint32_t)float_to_q16(GNG_D);
 }
 
-static void cfs_sync_nodes_full(void) {
-  for (int i = 0; i < MAX_NODES; i++) {
-    NEORV32_CFS->REG[CFS_NODE_BASE + i] = pack_node_q15(nodes[i].x, nodes[i].y);
-  }
-}
-
-static inline void cfs_write_one_node(int i) {
-  NEORV32_CFS->REG[CFS_NODE_BASE + i] = pack_node_q15(nodes[i].x, nodes[i].y);
-}
-
-static void cfs_build_active_mask(uint32_t *lo, uint32_t *hi8) {
-  uint32_t mlo = 0;
-  uint32_t mhi = 0;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-    if (i < 32) mlo |= (1u << i);
-    else mhi |= (1u << (i - 32));
-  }
-  *lo = mlo;
-  *hi8 = (mhi & 0xFFu);
-}
-
-static bool cfs_find_winners(float x, float y, int *s1, int *s2, float *d1_out) {
-  uint32_t act_lo, act_hi8;
-  cfs_build_active_mask(&act_lo, &act_hi8);
-
-  NEORV32_CFS->REG[CFS_REG_XIN]        = (uint32_t)(uint16_t)float_to_q15_pos(x);
-  NEORV32_CFS->REG[CFS_REG_YIN]        = (uint32_t)(uint16_t)float_to_q15_pos(y);
-  NEORV32_CFS->REG[CFS_REG_NODE_COUNT] = (uint32_t)MAX_NODES;
-  NEORV32_CFS->REG[CFS_REG_ACT_LO]     = act_lo;
-  NEORV32_CFS->REG[CFS_REG_ACT_HI]     = act_hi8;
-
-  NEORV32_CFS->REG[CFS_REG_CTRL] = CFS_CTRL_START;
-
-  const uint32_t TIMEOUT = 20000u;
-  for (uint32_t t = 0; t < TIMEOUT; t++) {
-    uint32_t st = NEORV32_CFS->REG[CFS_REG_CTRL];
-    if (st & CFS_STATUS_DONE) break;
-    if (t == TIMEOUT - 1) return false;
-  }
-
-  uint32_t s12  = NEORV32_CFS->REG[CFS_REG_OUT_S12];
-  uint32_t min1 = NEORV32_CFS->REG[CFS_REG_OUT_MIN1];
-
-  *s1 = (int)(s12 & 0xFFu);
-  *s2 = (int)((s12 >> 8) & 0xFFu);
-  *d1_out = q30_to_float(min1);
-  return true;
-}
-
 // dataset upload optional (kalau VHDL masih punya DATA_BASE)
 static inline uint32_t pack_xy_i16(int16_t xi, int16_t yi) {
   return ((uint32_t)(uint16_t)xi) | (((uint32_t)(uint16_t)yi) << 16);
 }
 
-static bool cfs_edge_sanity_check(void) {
-  // write test to EDGE[0], read back
-  uint32_t w = pack_edge(7, 9, 3, true);
-  edge_write_word(0, w);
-  uint32_t r = edge_read_word(0);
-  return (r == w);
-}
-
 static void cfs_upload_dataset_and_settings_once(void) {
   const int n = (dataCount < MAXPTS) ? dataCount : MAXPTS;
 
   NEORV32_CFS->REG[CFS_REG_CTRL]  = CFS_CTRL_CLEAR;
   NEORV32_CFS->REG[CFS_REG_COUNT] = (uint32_t)n;
 
+  uint32_t xy[MAXPTS];
   for (int i = 0; i < n; i++) {
-    int16_t xi = (int16_t)(dataX[i] * 1000.0f);
-    int16_t yi = (int16_t)(dataY[i] * 1000.0f);
-    NEORV32_CFS->REG[CFS_DATA_BASE + i] = pack_xy_i16(xi, yi);
+    xy[i] = pack_xy_i16(pos_to_wire(sample_x(dataQ[i])), pos_to_wire(sample_y(dataQ[i])));
+  }
+  if (!g_has_dma || !dma_copy_words(&NEORV32_CFS->REG[CFS_DATA_BASE], xy, (uint32_t)n)) {
+    for (int i = 0; i < n; i++) NEORV32_CFS->REG[CFS_DATA_BASE + i] = xy[i];
   }
 
   cfs_write_settings();
   cfs_sync_nodes_full();
-
-  edges_clear_all();
-
-  // IMPORTANT: create initial edge 0-1 (prevent prune on first step if desired)
-  // connectOrResetEdge(0, 1);
-}
-
-// ---------------- GNG step ----------------
-static void trainOneStep(float x, float y) {
-  int   s1 = -1, s2 = -1;
-  float d1 = 1e30f;
-
-  if (!cfs_find_winners(x, y, &s1, &s2, &d1)) {
-    // fallback SW search (still ok)
-    s1 = -1; s2 = -1; d1 = 1e30f;
-    float d2 = 1e30f;
-    for (int i = 0; i < MAX_NODES; i++) {
-      if (!nodes[i].active) continue;
-      float d = dist2(x, y, nodes[i].x, nodes[i].y);
-      if (d < d1) { d2 = d1; s2 = s1; d1 = d; s1 = i; }
-      else if (d < d2) { d2 = d; s2 = i; }
-    }
-  }
-
-  if (s1 < 0 || s2 < 0) return;
-
-  ageEdgesFromWinner(s1);
-
-  nodes[s1].error += d1;
-
-  nodes[s1].x += GNG_EPSILON_B * (x - nodes[s1].x);
-  nodes[s1].y += GNG_EPSILON_B * (y - nodes[s1].y);
-  cfs_write_one_node(s1);
-
-  // move neighbors: scan edges in BRAM
-  for (int i = 0; i < MAX_EDGES; i++) {
-    uint8_t a, b, age;
-    bool active;
-    unpack_edge(edge_read_word(i), &a, &b, &age, &active);
-    if (!active) continue;
-
-    if ((int)a == s1 || (int)b == s1) {
-      int nb = ((int)a == s1) ? (int)b : (int)a;
-      if (nb >= 0 && nb < MAX_NODES && nodes[nb].active) {
-        nodes[nb].x += GNG_EPSILON_N * (x - nodes[nb].x);
-        nodes[nb].y += GNG_EPSILON_N * (y - nodes[nb].y);
-        cfs_write_one_node(nb);
-      }
-    }
-  }
-
-  connectOrResetEdge(s1, s2);
-
-  deleteOldEdges();
-  pruneIsolatedNodes();
-
-  stepCount++;
-
-  if ((stepCount % GNG_LAMBDA) == 0) {
-    (void)insertNode();
-    pruneIsolatedNodes();
-    cfs_sync_nodes_full();
-  }
-
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].active) nodes[i].error *= GNG_D;
-  }
+#if V2_EDGE_CAM
+  if (g_edge_cam) cam_op(CFS_EOP_CLEAR, 0, 0);
+#endif
 }
 
 // ---------------- Init ----------------
 static void initGNG(void) {
-  for (int i = 0; i < MAX_NODES; i++) {
-    nodes[i].x = 0.0f; nodes[i].y = 0.0f;
-    nodes[i].error = 0.0f;
-    nodes[i].active = false;
-  }
+  gng_reset();
 
   dataCount = 0;
   dataDone  = false;
   running   = false;
-  stepCount = 0;
   dataIndex = 0;
   frame_id  = 0;
-
-  nodes[0].x = 0.2f; nodes[0].y = 0.2f; nodes[0].active = true;
-  nodes[1].x = 0.8f; nodes[1].y = 0.8f; nodes[1].active = true;
 }
 
 int main(void) {
@@ -629,6 +448,14 @@ int main(void) {
     while (1) { }
   }
 
+  cfs_setup();
+  neorv32_uart0_puts(g_has_dma ? "DMA=1\n" : "DMA=0\n");
+
+#if V2_EDGE_CAM
+  g_edge_cam = (((CFS_RD(CFS_REG_E_RES) >> 16) & 0xFFu) == (uint32_t)CFS_MAX_EDGES);
+#endif
+  neorv32_uart0_puts(g_edge_cam ? "ECAM=1\n" : "ECAM=0\n");
+
   bool preprocessed = false;
 
   while (1) {
@@ -637,11 +464,6 @@ int main(void) {
     if (dataDone && !preprocessed) {
       cfs_upload_dataset_and_settings_once();
 
-      if (!cfs_edge_sanity_check()) {
-        neorv32_uart0_puts("ERROR: EDGE BRAM not working (check VHDL EDGE_BASE/edge_mem)\n");
-        while (1) { }
-      }
-
       neorv32_uart0_puts("CFS init done\n");
       preprocessed = true;
 
@@ -651,12 +473,21 @@ int main(void) {
 
     if (!dataDone || !running || (dataCount <= 0)) continue;
 
-    float x = dataX[dataIndex];
-    float y = dataY[dataIndex];
+    sample_t smp = dataQ[dataIndex];
     dataIndex++;
     if (dataIndex >= dataCount) dataIndex = 0;
 
-    trainOneStep(x, y);
+#if V2_EDGE_CAM
+    if (g_edge_cam) (void)cam_step(sample_x(smp), sample_y(smp));
+    else
+#endif
+    gng_step(sample_x(smp), sample_y(smp));
+
+    // the CAM keeps node indices in its words: no renumbering under it
+    if (!g_edge_cam && (stepCount % COMPACT_EVERY) == 0 && gng_span() - gng_live() >= COMPACT_SLACK) {
+      uint8_t from[MAX_NODES], to[MAX_NODES];
+      (void)gng_compact(from, to, MAX_NODES);
+    }
 
     if ((stepCount % STREAM_EVERY_N) == 0) {
       frame_id++;
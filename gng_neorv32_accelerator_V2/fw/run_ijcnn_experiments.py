@@ -10,103 +10,220 @@ This script orchestrates all experiments:
 5. Export results tables
 
 Run this to reproduce all paper results.
+
+Every training run is a job (experiment_jobs.py): the jobs run on a process
+pool, each result is cached in <output>/cache/ under its configuration hash,
+and figures / tables are drawn from the cache only. An interrupted run picks
+up where it stopped.
+
+    python run_ijcnn_experiments.py                  # all cores
+    python run_ijcnn_experiments.py --workers 1      # one process (timing)
+    python run_ijcnn_experiments.py --seeds 5        # mean over 5 seeds
+    python run_ijcnn_experiments.py --report-only    # figures / tables from cache
 """
 
+import argparse
 import numpy as np
 import matplotlib.pyplot as plt
 from matplotlib.patches import Circle
 from matplotlib.collections import LineCollection
 import time
 import json
+import itertools
+import os
+import sys
+from functools import lru_cache
 from pathlib import Path
 
 # Import our implementations
 from gng_lite_fixed_point import GNGLite, GNGLiteConfig
 from experiment_metrics import (
-    GNGMetricsEvaluator, 
+    GNGMetricsEvaluator,
     MetricsResult,
     generate_test_datasets
 )
+from experiment_jobs import Job, run_jobs
+
+# V3 firmware host simulator (compiled on first use, needs a C compiler)
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "gng_host"))
+import gngsim
+from gngio import metrics as gm
+
+
+# ============================ Jobs (run in the worker processes) ============
+# Module-level functions with JSON-able arguments and results; the global
+# numpy RNG is seeded per job by experiment_jobs.
+
+@lru_cache(maxsize=None)
+def _dataset(name: str) -> np.ndarray:
+    # generate_test_datasets() seeds itself, every worker builds the same data
+    return generate_test_datasets()[name]
+
+
+def _plain(d: dict) -> dict:
+    return {k: (v.item() if isinstance(v, np.generic) else v) for k, v in d.items()}
+
+
+def evaluate_job(dataset: str, max_nodes: int, fixed: bool, lambda_: int,
+                 epochs: int, network: bool = False) -> dict:
+    """evaluate_full() of one GNGLite config; network=True keeps the graph."""
+    data = _dataset(dataset)
+    gng = GNGLite(GNGLiteConfig(max_nodes=max_nodes, max_edges=max_nodes * 2,
+                                use_fixed_point=fixed, lambda_=lambda_))
+    out = _plain(GNGMetricsEvaluator().evaluate_full(gng, data, data, epochs=epochs).to_dict())
+    if network:
+        out['weights'] = gng.get_weights_as_float().tolist()
+        out['edges'] = gng.get_edges_as_list()
+    return out
+
+
+def convergence_job(dataset: str, fixed: bool, epochs: int) -> dict:
+    """QE of a fresh model after epochs (one point of Figure 5)."""
+    data = _dataset(dataset)
+    gng = GNGLite(GNGLiteConfig(max_nodes=32, max_edges=64,
+                                use_fixed_point=fixed, lambda_=50))
+    gng.train(data, epochs=epochs)
+    return {'qe': GNGMetricsEvaluator.quantization_error(gng, data)}
+
+
+def v3_sweep_job(dataset: str, max_nodes: int, lambda_: int, grid: dict,
+                 epochs: int) -> dict:
+    """V3 simulator over the eps_b x eps_n x a_max grid of one (max_nodes, lambda)."""
+    data = _dataset(dataset)
+    # the board trains on [0, 1] (Q1.15): one uniform scale keeps distances
+    # comparable, QE is reported back in data units
+    lo = data.min(axis=0)
+    span = float((data.max(axis=0) - lo).max())
+    norm = (data - lo) / span
+    # upload order = one fixed shuffle, the firmware cycles it every epoch
+    norm = norm[np.random.default_rng(0).permutation(len(norm))]
+
+    sim = gngsim.Sim(max_nodes)
+    sim.load(norm)
+    rows = []
+    for eps_b, eps_n, a_max in itertools.product(grid['eps_b'], grid['eps_n'], grid['a_max']):
+        sim.config(lambda_=lambda_, eps_b=eps_b, eps_n=eps_n, a_max=a_max)
+        sim.reset()
+        sim.run(epochs * len(norm))
+
+        ids, xy = sim.nodes()
+        edges = [(a, b) for a, b, _ in sim.edges()]
+        rows.append({
+            'max_nodes': max_nodes, 'lambda_': lambda_,
+            'eps_b': eps_b, 'eps_n': eps_n, 'a_max': a_max,
+            'qe': gm.quantization_error(norm, xy) * span,
+            'te': gm.topological_error(norm, xy, edges, ids=ids),
+            'nodes_used': len(ids),
+            'edges': len(edges),
+        })
+    return {'rows': rows}
+
+
+def _mean_result(runs: list) -> MetricsResult:
+    """MetricsResult averaged over seeds (ints stay ints when all seeds agree)."""
+    out = {}
+    for k in MetricsResult.__dataclass_fields__:
+        vals = [r[k] for r in runs]
+        same_int = all(isinstance(v, int) for v in vals) and len(set(vals)) == 1
+        out[k] = vals[0] if same_int else float(np.mean(vals))
+    return MetricsResult(**out)
 
 
 class IJCNNExperimentRunner:
     """Complete experiment runner for IJCNN paper."""
-    
-    def __init__(self, output_dir: str = "paper_results"):
+
+    def __init__(self, output_dir: str = "paper_results", workers: int = None,
+                 seeds: int = 1, report_only: bool = False):
         self.output_dir = Path(output_dir)
         self.output_dir.mkdir(exist_ok=True)
-        
-        self.evaluator = GNGMetricsEvaluator()
+
+        self.cache_dir = self.output_dir / "cache"
+        self.workers = workers
+        self.seeds = seeds
+        self.report_only = report_only
         self.all_results = {}
-        
+
     def run_all_experiments(self):
         """Run all experiments for the paper."""
         print("=" * 70)
         print("IJCNN 2026 - GNG-Lite Experiments")
         print("=" * 70)
-        
-        # 1. Generate datasets
-        print("\n[1/5] Generating test datasets...")
-        datasets = generate_test_datasets()
-        print(f"✓ Generated {len(datasets)} datasets")
-        
-        # 2. Memory efficiency comparison
-        print("\n[2/5] Running memory efficiency comparison...")
-        self.memory_efficiency_experiment(datasets['two_moons'])
-        
-        # 3. Multi-dataset evaluation
-        print("\n[3/5] Evaluating on all datasets...")
-        self.multi_dataset_experiment(datasets)
-        
-        # 4. Hyperparameter sensitivity
-        print("\n[4/5] Running hyperparameter sensitivity analysis...")
-        self.hyperparameter_sensitivity(datasets['two_moons'])
-        
-        # 5. Generate all figures and tables
-        print("\n[5/5] Generating figures and tables...")
+
+        # 1. Job graph of all experiments
+        print("\n[1/5] Building experiment jobs...")
+        datasets = list(generate_test_datasets())
+        experiments = [
+            (self.memory_efficiency_jobs('two_moons'), self.memory_efficiency_experiment),
+            (self.multi_dataset_jobs(datasets), self.multi_dataset_experiment),
+            (self.hyperparameter_jobs('two_moons'), self.hyperparameter_sensitivity),
+            (self.v3_sweep_jobs('two_moons'), self.v3_sensitivity_sweep),
+            (self.convergence_jobs('two_moons'), self.training_convergence),
+        ]
+        jobs = [job for group, _ in experiments for job in group]
+        print(f"✓ {len(jobs)} jobs over {len(datasets)} datasets, {self.seeds} seed(s)")
+
+        # 2. Run (or only load) every job, cached by configuration
+        print("\n[2/5] Running jobs..." if not self.report_only else "\n[2/5] Loading cached results...")
+        results = run_jobs(jobs, self.cache_dir, workers=self.workers, run=not self.report_only)
+
+        # 3. Collect results per experiment (cache only from here on)
+        print("\n[3/5] Collecting results...")
+        for group, collect in experiments:
+            if group and all(job.name in results for job in group):
+                collect(results)
+            elif group:
+                print(f"    {collect.__name__}: incomplete, skipped")
+
+        # 4. Generate all figures and tables
+        print("\n[4/5] Generating figures and tables...")
         self.generate_paper_figures()
         self.generate_latex_tables()
-        
+
+        print("\n[5/5] Done")
         print("\n" + "=" * 70)
         print("All experiments completed!")
         print(f"Results saved to: {self.output_dir.absolute()}")
         print("=" * 70)
-    
-    def memory_efficiency_experiment(self, data: np.ndarray):
+
+    def _seed_jobs(self, name: str, fn, **kwargs) -> list:
+        return [Job(f"{name}/s{s}", fn, kwargs, seed=s) for s in range(self.seeds)]
+
+    def _mean(self, results: dict, name: str) -> MetricsResult:
+        return _mean_result([results[f"{name}/s{s}"] for s in range(self.seeds)])
+
+    # ---------------- 1. memory efficiency ----------------
+    MEMORY_CONFIGS = [
+        ("Fixed-Point (32 nodes)", 32, True),
+        ("Float32 (32 nodes)", 32, False),
+        ("Fixed-Point (16 nodes)", 16, True),
+    ]
+
+    def memory_efficiency_jobs(self, dataset: str) -> list:
+        jobs = []
+        for name, max_nodes, fixed in self.MEMORY_CONFIGS:
+            jobs += self._seed_jobs(f"memory/{name}", evaluate_job, dataset=dataset,
+                                    max_nodes=max_nodes, fixed=fixed, lambda_=50, epochs=10)
+        return jobs
+
+    def memory_efficiency_experiment(self, results: dict):
         """Compare memory usage: Float32 vs Fixed-Point."""
         print("\n  Memory Efficiency Comparison")
         print("  " + "-" * 60)
-        
-        results = []
-        names = []
-        configs = [
-            ("Fixed-Point (32 nodes)", GNGLiteConfig(
-                max_nodes=32, max_edges=64, use_fixed_point=True, lambda_=50
-            )),
-            ("Float32 (32 nodes)", GNGLiteConfig(
-                max_nodes=32, max_edges=64, use_fixed_point=False, lambda_=50
-            )),
-            ("Fixed-Point (16 nodes)", GNGLiteConfig(
-                max_nodes=16, max_edges=32, use_fixed_point=True, lambda_=50
-            )),
-        ]
-        
-        for name, config in configs:
-            print(f"\n  Testing: {name}")
-            gng = GNGLite(config)
-            result = self.evaluator.evaluate_full(gng, data, data, epochs=10)
-            results.append(result)
-            names.append(name)
-            
+
+        names = [name for name, _, _ in self.MEMORY_CONFIGS]
+        results = [self._mean(results, f"memory/{name}") for name in names]
+
+        for name, result in zip(names, results):
+            print(f"\n  {name}")
             print(f"    Memory: {result.memory_bytes} bytes")
             print(f"    QE: {result.quantization_error:.4f}")
             print(f"    Nodes: {result.n_nodes}")
-        
+
         self.all_results['memory_comparison'] = {
             'results': results,
             'names': names
         }
-        
+
         # Save results
         with open(self.output_dir / "memory_comparison.json", 'w') as f:
             json.dump({
@@ -115,65 +232,59 @@ class IJCNNExperimentRunner:
                 'qe': [r.quantization_error for r in results],
                 'te': [r.topological_error for r in results],
             }, f, indent=2)
-        
+
         print(f"\n  ✓ Memory comparison saved")
-    
-    def multi_dataset_experiment(self, datasets: dict):
+
+    # ---------------- 2. multi-dataset ----------------
+    def multi_dataset_jobs(self, datasets: list) -> list:
+        self.multi_datasets = list(datasets)
+        jobs = []
+        for dataset_name in datasets:
+            for kind, fixed in (('fixed', True), ('float', False)):
+                jobs += self._seed_jobs(f"multi/{dataset_name}/{kind}", evaluate_job,
+                                        dataset=dataset_name, max_nodes=32, fixed=fixed,
+                                        lambda_=50, epochs=10, network=True)
+        return jobs
+
+    def multi_dataset_experiment(self, results: dict):
         """Evaluate on all datasets."""
         print("\n  Multi-Dataset Evaluation")
         print("  " + "-" * 60)
-        
+
         results_by_dataset = {}
-        
-        for dataset_name, data in datasets.items():
+        for dataset_name in self.multi_datasets:
+            data = _dataset(dataset_name)
             print(f"\n  Dataset: {dataset_name} ({len(data)} samples)")
-            
-            results_fixed = []
-            results_float = []
-            
-            # Fixed-Point
-            config_fixed = GNGLiteConfig(
-                max_nodes=32, max_edges=64, use_fixed_point=True, lambda_=50
-            )
-            gng_fixed = GNGLite(config_fixed)
-            result_fixed = self.evaluator.evaluate_full(
-                gng_fixed, data, data, epochs=10
-            )
-            
-            # Float32
-            config_float = GNGLiteConfig(
-                max_nodes=32, max_edges=64, use_fixed_point=False, lambda_=50
-            )
-            gng_float = GNGLite(config_float)
-            result_float = self.evaluator.evaluate_full(
-                gng_float, data, data, epochs=10
-            )
-            
+
+            result_fixed = self._mean(results, f"multi/{dataset_name}/fixed")
+            result_float = self._mean(results, f"multi/{dataset_name}/float")
+
             print(f"    Fixed-Point: QE={result_fixed.quantization_error:.4f}, "
                   f"TE={result_fixed.topological_error*100:.2f}%")
             print(f"    Float32:     QE={result_float.quantization_error:.4f}, "
                   f"TE={result_float.topological_error*100:.2f}%")
-            
+
             # Calculate differences
-            qe_diff = ((result_fixed.quantization_error - result_float.quantization_error) 
+            qe_diff = ((result_fixed.quantization_error - result_float.quantization_error)
                       / result_float.quantization_error * 100)
             te_diff = (result_fixed.topological_error - result_float.topological_error) * 100
             mem_saving = ((result_float.memory_bytes - result_fixed.memory_bytes)
                          / result_float.memory_bytes * 100)
-            
+
             print(f"    Difference:  QE={qe_diff:+.2f}%, TE={te_diff:+.2f}pp, "
                   f"Mem=-{mem_saving:.1f}%")
-            
+
+            # networks of seed 0 for Figure 1
             results_by_dataset[dataset_name] = {
                 'fixed': result_fixed,
                 'float': result_float,
                 'data': data,
-                'gng_fixed': gng_fixed,
-                'gng_float': gng_float,
+                'net_fixed': results[f"multi/{dataset_name}/fixed/s0"],
+                'net_float': results[f"multi/{dataset_name}/float/s0"],
             }
-        
+
         self.all_results['multi_dataset'] = results_by_dataset
-        
+
         # Save summary
         summary = {}
         for name, res in results_by_dataset.items():
@@ -185,42 +296,42 @@ class IJCNNExperimentRunner:
                 'fixed_mem': res['fixed'].memory_bytes,
                 'float_mem': res['float'].memory_bytes,
             }
-        
+
         with open(self.output_dir / "multi_dataset_results.json", 'w') as f:
             json.dump(summary, f, indent=2)
-        
+
         print(f"\n  ✓ Multi-dataset results saved")
-    
-    def hyperparameter_sensitivity(self, data: np.ndarray):
+
+    # ---------------- 3. hyperparameter sensitivity ----------------
+    NODE_COUNTS = [8, 16, 32, 48, 64]
+
+    def hyperparameter_jobs(self, dataset: str) -> list:
+        jobs = []
+        for max_nodes in self.NODE_COUNTS:
+            jobs += self._seed_jobs(f"hyper/{max_nodes}", evaluate_job, dataset=dataset,
+                                    max_nodes=max_nodes, fixed=True, lambda_=50, epochs=10)
+        return jobs
+
+    def hyperparameter_sensitivity(self, results: dict):
         """Test different hyperparameter configurations."""
         print("\n  Hyperparameter Sensitivity Analysis")
         print("  " + "-" * 60)
-        
+
         # Test different max_nodes values
-        node_counts = [8, 16, 32, 48, 64]
-        results = []
-        
-        for max_nodes in node_counts:
-            print(f"\n  Testing max_nodes={max_nodes}")
-            config = GNGLiteConfig(
-                max_nodes=max_nodes,
-                max_edges=max_nodes * 2,
-                use_fixed_point=True,
-                lambda_=50
-            )
-            gng = GNGLite(config)
-            result = self.evaluator.evaluate_full(gng, data, data, epochs=10)
-            results.append(result)
-            
+        node_counts = self.NODE_COUNTS
+        results = [self._mean(results, f"hyper/{max_nodes}") for max_nodes in node_counts]
+
+        for max_nodes, result in zip(node_counts, results):
+            print(f"\n  max_nodes={max_nodes}")
             print(f"    Nodes used: {result.n_nodes}/{max_nodes}")
             print(f"    QE: {result.quantization_error:.4f}")
             print(f"    Memory: {result.memory_bytes} bytes")
-        
+
         self.all_results['hyperparameter_sensitivity'] = {
             'node_counts': node_counts,
             'results': results
         }
-        
+
         # Save results
         with open(self.output_dir / "hyperparameter_sensitivity.json", 'w') as f:
             json.dump({
@@ -230,9 +341,80 @@ class IJCNNExperimentRunner:
                 'memory': [r.memory_bytes for r in results],
                 'nodes_used': [r.n_nodes for r in results],
             }, f, indent=2)
-        
+
         print(f"\n  ✓ Hyperparameter sensitivity saved")
-    
+
+    # ---------------- V3 simulator sweep ----------------
+    V3_GRID = {
+        'max_nodes': [8, 16, 32, 48, 64],
+        'lambda_':   [25, 50, 100, 200],
+        'eps_b':     [0.05, 0.1, 0.2, 0.3],
+        'eps_n':     [0.0005, 0.001, 0.006],
+        'a_max':     [25, 50, 100],
+    }
+    V3_EPOCHS = 100
+
+    def v3_sweep_jobs(self, dataset: str) -> list:
+        """One job per (max_nodes, lambda); the simulator is deterministic, no seeds."""
+        grid = self.V3_GRID
+        if not self.report_only:
+            # build the libraries here, not racing in the workers
+            try:
+                for n in grid['max_nodes']:
+                    gngsim.build(n)
+            except RuntimeError as e:
+                print(f"    V3 sweep skipped: {e}")
+                return []
+        sub = {k: grid[k] for k in ('eps_b', 'eps_n', 'a_max')}
+        return [Job(f"v3/{n}/{lam}", v3_sweep_job,
+                    dict(dataset=dataset, max_nodes=n, lambda_=lam, grid=sub, epochs=self.V3_EPOCHS))
+                for n in grid['max_nodes'] for lam in grid['lambda_']]
+
+    def v3_sensitivity_sweep(self, results: dict):
+        """Grid sweep on the V3 firmware simulator (gng_host/gngsim): same
+        integer step as the board, so QE / TE predict the on-device result."""
+        print("\n  V3 Simulator Sensitivity Sweep")
+        print("  " + "-" * 60)
+
+        grid = self.V3_GRID
+        keys = list(grid)
+        rows = [row for n in grid['max_nodes'] for lam in grid['lambda_']
+                for row in results[f"v3/{n}/{lam}"]['rows']]
+
+        best = min(rows, key=lambda r: r['qe'])
+        print(f"    {len(rows)} configurations, {self.V3_EPOCHS} epochs each")
+        print(f"    best QE {best['qe']:.4f} (TE {best['te']:.3f}): "
+              + ", ".join(f"{k}={best[k]}" for k in keys))
+
+        self.all_results['v3_sensitivity_sweep'] = rows
+        with open(self.output_dir / "v3_sensitivity_sweep.json", 'w') as f:
+            json.dump({'grid': grid, 'epochs': self.V3_EPOCHS, 'results': rows}, f, indent=2)
+
+        print(f"\n  ✓ V3 sensitivity sweep saved")
+
+    # ---------------- training convergence (Figure 5) ----------------
+    CONVERGENCE_EPOCHS = range(1, 21)
+
+    def convergence_jobs(self, dataset: str) -> list:
+        jobs = []
+        for epoch in self.CONVERGENCE_EPOCHS:
+            for kind, fixed in (('fixed', True), ('float', False)):
+                jobs += self._seed_jobs(f"conv/{kind}/{epoch}", convergence_job,
+                                        dataset=dataset, fixed=fixed, epochs=epoch)
+        return jobs
+
+    def training_convergence(self, results: dict):
+        """QE over epochs, fresh model per point, averaged over seeds."""
+        def qe(kind, epoch):
+            return float(np.mean([results[f"conv/{kind}/{epoch}/s{s}"]['qe'] for s in range(self.seeds)]))
+
+        self.all_results['convergence'] = {
+            'epochs': list(self.CONVERGENCE_EPOCHS),
+            'fixed': [qe('fixed', e) for e in self.CONVERGENCE_EPOCHS],
+            'float': [qe('float', e) for e in self.CONVERGENCE_EPOCHS],
+        }
+        print("    ✓ Training convergence collected")
+
     def generate_paper_figures(self):
         """Generate all figures for the paper."""
         print("\n  Generating Figures")
@@ -262,15 +444,15 @@ class IJCNNExperimentRunner:
         
         res = self.all_results['multi_dataset']['two_moons']
         data = res['data']
-        gng = res['gng_fixed']
+        net = res['net_fixed']
         
         fig, axes = plt.subplots(1, 2, figsize=(12, 5))
         
         # Fixed-Point
         ax = axes[0]
         ax.scatter(data[:, 0], data[:, 1], alpha=0.3, s=10, c='gray', label='Data')
-        weights = gng.get_weights_as_float()
-        edges = gng.get_edges_as_list()
+        weights = np.asarray(net['weights']).reshape(-1, 2)
+        edges = net['edges']
         
         # Draw edges
         segments = []
@@ -284,7 +466,7 @@ class IJCNNExperimentRunner:
                   marker='o', edgecolors='black', linewidths=1.5,
                   label='Nodes', zorder=10)
         
-        ax.set_title(f'Fixed-Point GNG\n({gng.n_nodes} nodes, {gng.n_edges} edges)', 
+        ax.set_title(f'Fixed-Point GNG\n({net["n_nodes"]} nodes, {net["n_edges"]} edges)', 
                     fontsize=12)
         ax.set_xlabel('Feature 1')
         ax.set_ylabel('Feature 2')
@@ -294,11 +476,11 @@ class IJCNNExperimentRunner:
         ax.set_ylim(-0.1, 1.1)
         
         # Float32
-        gng_float = res['gng_float']
+        net = res['net_float']
         ax = axes[1]
         ax.scatter(data[:, 0], data[:, 1], alpha=0.3, s=10, c='gray', label='Data')
-        weights = gng_float.get_weights_as_float()
-        edges = gng_float.get_edges_as_list()
+        weights = np.asarray(net['weights']).reshape(-1, 2)
+        edges = net['edges']
         
         # Draw edges
         segments = []
@@ -312,7 +494,7 @@ class IJCNNExperimentRunner:
                   marker='o', edgecolors='black', linewidths=1.5,
                   label='Nodes', zorder=10)
         
-        ax.set_title(f'Float32 GNG (Baseline)\n({gng_float.n_nodes} nodes, {gng_float.n_edges} edges)',
+        ax.set_title(f'Float32 GNG (Baseline)\n({net["n_nodes"]} nodes, {net["n_edges"]} edges)',
                     fontsize=12)
         ax.set_xlabel('Feature 1')
         ax.set_ylabel('Feature 2')
@@ -451,36 +633,13 @@ class IJCNNExperimentRunner:
     
     def _plot_training_convergence(self):
         """Figure 5: Training convergence over epochs."""
-        if 'multi_dataset' not in self.all_results:
+        if 'convergence' not in self.all_results:
             return
         
-        # Train fresh models and track QE over epochs
-        data = generate_test_datasets()['two_moons']
-        
-        epochs_list = range(1, 21)
-        qe_fixed_history = []
-        qe_float_history = []
-        
-        print("    Training models for convergence plot...")
-        
-        for epoch in epochs_list:
-            # Fixed-point
-            config_fixed = GNGLiteConfig(
-                max_nodes=32, max_edges=64, use_fixed_point=True, lambda_=50
-            )
-            gng_fixed = GNGLite(config_fixed)
-            gng_fixed.train(data, epochs=epoch)
-            qe = self.evaluator.quantization_error(gng_fixed, data)
-            qe_fixed_history.append(qe)
-            
-            # Float32
-            config_float = GNGLiteConfig(
-                max_nodes=32, max_edges=64, use_fixed_point=False, lambda_=50
-            )
-            gng_float = GNGLite(config_float)
-            gng_float.train(data, epochs=epoch)
-            qe = self.evaluator.quantization_error(gng_float, data)
-            qe_float_history.append(qe)
+        conv = self.all_results['convergence']
+        epochs_list = conv['epochs']
+        qe_fixed_history = conv['fixed']
+        qe_float_history = conv['float']
         
         fig, ax = plt.subplots(figsize=(10, 6))
         
@@ -613,7 +772,15 @@ class IJCNNExperimentRunner:
 
 
 if __name__ == "__main__":
-    runner = IJCNNExperimentRunner(output_dir="paper_results")
+    ap = argparse.ArgumentParser(description=__doc__.split("\n\n")[0])
+    ap.add_argument("--output", default="paper_results", help="results directory (cache in <output>/cache)")
+    ap.add_argument("--workers", type=int, default=None, help="processes (default: all cores, 1 = no pool)")
+    ap.add_argument("--seeds", type=int, default=1, help="seeds per configuration, results are averaged")
+    ap.add_argument("--report-only", action="store_true", help="figures / tables from cached results, run nothing")
+    args = ap.parse_args()
+
+    runner = IJCNNExperimentRunner(output_dir=args.output, workers=args.workers,
+                                   seeds=args.seeds, report_only=args.report_only)
     runner.run_all_experiments()
     
     print("\n" + "=" * 70)
@@ -632,6 +799,7 @@ if __name__ == "__main__":
     print("    - memory_comparison.json")
     print("    - multi_dataset_results.json")
     print("    - hyperparameter_sensitivity.json")
+    print("    - v3_sensitivity_sweep.json")
     print("\nNext Steps:")
     print("  1. Review generated figures in paper_results/")
     print("  2. Copy LaTeX tables to your paper")
@@ -1,13 +1,38 @@
 -- gng.vhd (FULL) : winner + move + age neighbor + connect/reset + prune/iso + insert every LAMBDA + error decay
 -- + SNAPSHOT:
---   1.A) snapshot every SNAP_EVERY iterations (default 20)
+--   1.A) snapshot every SNAP_EVERY iterations (default 50)
+--   1.C) SNAP_ON_CHANGE: also snapshot after a structural change (edge
+--        add/remove, isolated node, insert), at most every SNAP_MIN_GAP
+--        iterations; SNAP_EVERY is then only the keep-alive interval
 --   2.B) edge snapshot sends ONLY active edges (cnt variable)
+--   2.C) SNAP_EDGE_BITMAP: if cnt*3 > EDGE_BM_BYTES the edge snapshot is an
+--        A5 22 adjacency bitmap instead (bit k = edge_idx k != 0, LSB first,
+--        no ages), so a dense graph costs at most 4 + EDGE_BM_BYTES bytes
+--   1.D) SNAP_SHADOW (needs DBG_RING): instead of streaming A5 20/21/22
+--        inline, the core copies node_mem (+deg_r) and edge_mem into shadow
+--        BRAMs (max(MAX_NODES, EDGE_N)+2 cycles, both streams at once) and
+--        goes on training. A dump engine sends the frames from the shadow
+--        copy through the ring drain, which gives it the UART between two
+--        DBG records until the snapshot is out. A snapshot due while a dump
+--        is running waits for the next free iteration; DBG records written
+--        meanwhile are dropped whole once the ring is full
 --
 -- UART stream per iteration:
---   always:  A5 10 ... (DBG TLV fixed 46 bytes)
---   if snap_now=1: then immediately after DBG:
+--   dbg_now=1: A5 10 ... (DBG TLV fixed 54 bytes), every DBG_EVERY iterations
+--              (1 = every iteration, 0 = never)
+--   if snap_now=1: then immediately after DBG (SNAP_SHADOW: a few DBG
+--   records later, from the shadow copy of that iteration):
 --            A5 20 ... (NODE_SNAPSHOT fixed 4 + MAX_NODES*7)
 --            A5 21 ... (EDGE_SNAPSHOT variable 4 + cnt*3)
+--         or A5 22 ... (EDGE_BITMAP 4 + EDGE_BM_BYTES, see 2.C)
+--
+-- DBG_RING (production mode):
+--   all TX bytes go into a DBG_RING_BYTES BRAM FIFO at 1 byte/cycle and a
+--   separate drain process feeds uart_tx whenever it is idle, so the core
+--   never waits on the serial port for DBG. A DBG record that does not fit
+--   in the free space is dropped whole (gap in the A9 sample index / B2..B5
+--   timestamp on the host). Snapshot bytes wait for space, so a snapshot
+--   still costs its UART time, but only once the ring is full.
 --
 -- FIX (important):
 --  - Do NOT deactivate nodes when degree becomes 0 (keep act='1')
@@ -19,6 +44,55 @@
 --      f = neighbor of q (edge exists) with maximum error (or first neighbor if all errors 0)
 --      insert new node r at midpoint(q,f), split edge(q,f), scale err(q),err(f) by 1/2, set err(r)=err(q)
 --    (alpha=0.5 implemented by shift-right 1)
+--
+-- MEMORY:
+--  - node_mem (BRAM, 1W+1R): x, y, act, err; POS_W / ERR_W bits per field
+--    (2*POS_W + 1 + ERR_W per node, gng_layout.vhd of gngio precision).
+--    x / y are value * 1000, so POS_W >= 11 stores [-1.024, 1.024) exactly;
+--    an error above 2^ERR_W - 1 is stored saturated. Widths below 16 / 32
+--    are not simulated yet (sim/run.sh variants false:11:32, false:11:24)
+--  - deg_r (registers): degree; connect/prune/insert update it in one cycle
+--  - edge_mem (BRAM): stored ages
+--  - adj_r (registers): one bit per edge in both rows + edge_cnt_r. The NB
+--    pass visits only the set bits of row s1 (node k and edge(s1,k) read in
+--    the same cycle, 3 cycles per neighbor). The snapshot header takes
+--    edge_cnt_r instead of counting all EDGE_N cells
+--  - error decay is lazy: node_mem holds err * err_scale, with err_scale
+--    (Q1.15, 1..2) grown by 1/(1-2^-ERR_DECAY_SHIFT) per sample and only
+--    the winner's add_err multiplied by it. Once err_scale reaches 2, one
+--    1 node/cycle stream halves every stored error (every ~177 samples
+--    at ERR_DECAY_SHIFT=8) instead of a decay pass on every sample
+--  - capacity: MAX_NODES up to 255 (8-bit node ids, A5 20 count byte).
+--    edge_mem grows as MAX_NODES^2/2 bytes (1 BSRAM per 2048 edges, 64
+--    nodes), adj_r as MAX_NODES^2 registers: on the GW1NR-9 (6693 FF) the
+--    bitmap, not the BRAM, sets the limit (see README, MAX_NODES sweep)
+--  - win_mem (BRAM, PIPE_WIN only): x, y, act copy with its own read port
+--    for the winner engine
+--
+-- PIPELINE (PIPE_WIN generic, default off):
+--  3.A) once the neighbor pass of sample k has written its moves
+--       (after P_S1_WRBACK), sample k+1 is prefetched and a separate winner
+--       engine scans a (x,y,act) replica of node_mem at 1 node/cycle, while
+--       connect/insert/DBG/snapshot of sample k continue on node_mem.
+--       Every replica write in that window marks the node in pos_dirty
+--       (only an insert can do that). At the start of k+1:
+--         - nothing dirty             -> result used as is (0 scan cycles)
+--         - s1/s2 candidate is dirty  -> full rescan on the engine (~MAX_NODES)
+--         - otherwise                 -> fix-up: only dirty nodes re-evaluated
+--                                        and merged into the kept s1/s2
+--       Ties go to the lower index in every path, so s1/s2 are those a serial
+--       scan over the committed positions gives. With a blocking DBG TLV
+--       every iteration (about 14k cycles at 1 Mbaud) that TX, not the scan,
+--       bounds the iteration rate; see DBG_EVERY / DBG_RING.
+--       Not simulated yet: the true:16:32 variant of sim/run.sh (capture
+--       byte for byte equal to the serial build) is the check, and it has
+--       not been run; the V2 max-throughput preset builds PIPE_WIN unverified.
+--
+-- PROFILING:
+--  phase_o = group of the current phase (PHG_* below: winner, update,
+--  neighbors, connect, insert, DBG, snapshot, ...), so a testbench
+--  (gng_neorv32_accelerator_V2/sim) counts cycles per phase without
+--  knowing phase_t. The board leaves it open and synthesis drops it.
 
 library ieee;
 use ieee.std_logic_1164.all;
@@ -27,7 +101,7 @@ use ieee.numeric_std.all;
 entity gng is
   generic (
     MAX_NODES  : natural := 40;
-    DATA_WORDS : natural := 100;
+    DATA_WORDS : natural := 100;   -- 1..1024 (10-bit data_raddr_o)
 
     INIT_X0    : integer := -500;
     INIT_Y0    : integer :=  500;
@@ -39,21 +113,40 @@ entity gng is
 
     ERR_SHIFT : natural := 4;   -- add_err = d2 >> ERR_SHIFT
 
-    -- error decay: err := err - (err >> ERR_DECAY_SHIFT)
+    -- error decay: err := err - (err >> ERR_DECAY_SHIFT), applied lazily
     ERR_DECAY_SHIFT : natural := 8;
 
     -- prune threshold (age in "real age", not stored form)
     A_MAX    : natural := 50;
 
+    -- node_mem field widths (see MEMORY above)
+    POS_W    : natural := 16;   -- 11..16
+    ERR_W    : natural := 32;   -- 8..32
+
     -- insert interval
-    LAMBDA   : natural := 100
+    LAMBDA   : natural := 100;
+
+    -- snapshot trigger (see 1.A / 1.C above)
+    SNAP_EVERY     : natural := 50;
+    SNAP_ON_CHANGE : boolean := false;
+    SNAP_MIN_GAP   : natural := 5;
+    SNAP_EDGE_BITMAP : boolean := true;
+    SNAP_SHADOW      : boolean := false;  -- see 1.D
+
+    -- overlap the next winner search with the current update (see 3.A)
+    PIPE_WIN : boolean := false;
+
+    -- DBG TLV rate and ring buffer (see DBG_RING above)
+    DBG_EVERY      : natural := 1;
+    DBG_RING       : boolean := false;
+    DBG_RING_BYTES : natural := 1024   -- power of 2
   );
   port (
     clk_i   : in  std_logic;
     rstn_i  : in  std_logic;
     start_i : in  std_logic;
 
-    data_raddr_o : out unsigned(6 downto 0);
+    data_raddr_o : out unsigned(9 downto 0);
     data_rdata_i : in  std_logic_vector(31 downto 0);
 
     gng_busy_o : out std_logic;
@@ -62,7 +155,9 @@ entity gng is
     tx_busy_i  : in  std_logic;
     tx_done_i  : in  std_logic;
     tx_start_o : out std_logic;
-    tx_data_o  : out std_logic_vector(7 downto 0)
+    tx_data_o  : out std_logic_vector(7 downto 0);
+
+    phase_o    : out std_logic_vector(3 downto 0)  -- see PROFILING
   );
 end entity;
 
@@ -86,6 +181,11 @@ architecture rtl of gng is
   -- INSERT alpha=0.5
   constant INS_ALPHA_SHIFT : natural := 1;
 
+  -- lazy error decay: err_scale is Q1.15, err_inv Q0.16 (debug readout)
+  constant ERR_SC_FB  : natural := 15;
+  constant ERR_SC_ONE : unsigned(15 downto 0) := to_unsigned(2**ERR_SC_FB, 16);
+  constant ERR_IV_ONE : unsigned(16 downto 0) := to_unsigned(2**16, 17);
+
   -- stored edge value: 0=no edge, 1..255 means connected, stored = age+1
   function age_limit_stored(a : natural) return unsigned is
     variable v : natural;
@@ -100,42 +200,42 @@ architecture rtl of gng is
 
   constant A_MAX_STORED : unsigned(7 downto 0) := age_limit_stored(A_MAX);
 
-  -- Node packing (80-bit)
-  constant NODE_W : natural := 80;
+  -- Node packing (2*POS_W + 1 + ERR_W bits, 65 by default); the degree is
+  -- in deg_r, not in the BRAM word
+  constant NODE_W : natural := 2*POS_W + 1 + ERR_W;
   subtype node_word_t is std_logic_vector(NODE_W-1 downto 0);
 
   constant X_L   : natural := 0;
-  constant X_H   : natural := 15;
-  constant Y_L   : natural := 16;
-  constant Y_H   : natural := 31;
-  constant ACT_B : natural := 32;
-  constant DEG_L : natural := 33;
-  constant DEG_H : natural := 40;
-  constant ERR_L : natural := 41;
-  constant ERR_H : natural := 72;
-
-  function pack_node(x : s16; y : s16; act : std_logic; deg : u8; err : u32)
+  constant X_H   : natural := POS_W-1;
+  constant Y_L   : natural := POS_W;
+  constant Y_H   : natural := 2*POS_W-1;
+  constant ACT_B : natural := 2*POS_W;
+  constant ERR_L : natural := ACT_B+1;
+  constant ERR_H : natural := ACT_B+ERR_W;
+
+  function pack_node(x : s16; y : s16; act : std_logic; err : u32)
     return node_word_t is
     variable w : node_word_t := (others => '0');
   begin
-    w(X_H downto X_L) := std_logic_vector(x);
-    w(Y_H downto Y_L) := std_logic_vector(y);
+    w(X_H downto X_L) := std_logic_vector(resize(x, POS_W));
+    w(Y_H downto Y_L) := std_logic_vector(resize(y, POS_W));
     w(ACT_B) := act;
-    w(DEG_H downto DEG_L) := std_logic_vector(deg);
-    w(ERR_H downto ERR_L) := std_logic_vector(err);
+    if shift_right(err, ERR_W) /= 0 then
+      w(ERR_H downto ERR_L) := (others => '1');
+    else
+      w(ERR_H downto ERR_L) := std_logic_vector(resize(err, ERR_W));
+    end if;
     return w;
   end function;
 
   function get_x(w : node_word_t) return s16 is
-  begin return signed(w(X_H downto X_L)); end;
+  begin return resize(signed(w(X_H downto X_L)), 16); end;
   function get_y(w : node_word_t) return s16 is
-  begin return signed(w(Y_H downto Y_L)); end;
+  begin return resize(signed(w(Y_H downto Y_L)), 16); end;
   function get_act(w : node_word_t) return std_logic is
   begin return w(ACT_B); end;
-  function get_deg(w : node_word_t) return u8 is
-  begin return unsigned(w(DEG_H downto DEG_L)); end;
   function get_err(w : node_word_t) return u32 is
-  begin return unsigned(w(ERR_H downto ERR_L)); end;
+  begin return resize(unsigned(w(ERR_H downto ERR_L)), 32); end;
 
   function sat_s16(v : signed) return s16 is
     variable vi : integer;
@@ -164,12 +264,56 @@ architecture rtl of gng is
     return edge_base(i, N) + (j - i - 1);
   end function;
 
+  function clog2(n : natural) return natural is
+    variable r : natural := 0;
+  begin
+    while (2**r) < n loop
+      r := r + 1;
+    end loop;
+    return r;
+  end function;
+
+  constant EDGE_AW : natural := clog2(EDGE_N);  -- 10 bits at 40 nodes, 13 at 128
+
+  function imax(a : natural; b : natural) return natural is
+  begin
+    if a > b then
+      return a;
+    end if;
+    return b;
+  end function;
+
   attribute syn_ramstyle : string;
 
   type node_mem_t is array (0 to MAX_NODES-1) of node_word_t;
   signal node_mem : node_mem_t;
   attribute syn_ramstyle of node_mem : signal is "block_ram";
 
+  -- node degrees: register file, read without wait state and updated in
+  -- the same cycle (connect deg++, prune deg--, insert, DBG, snapshot)
+  type deg_arr_t is array (0 to MAX_NODES-1) of u8;
+  signal deg_r : deg_arr_t := (others => (others => '0'));
+
+  -- adjacency bitmap: adj_r(i)(j) = adj_r(j)(i) = (edge(i,j) /= 0), kept
+  -- in step with every edge_mem write that creates or removes an edge
+  subtype adj_row_t is std_logic_vector(MAX_NODES-1 downto 0);
+  type adj_arr_t is array (0 to MAX_NODES-1) of adj_row_t;
+  signal adj_r      : adj_arr_t := (others => (others => '0'));
+  signal edge_cnt_r : unsigned(15 downto 0) := (others => '0');  -- set bits / 2
+  signal nb_row     : adj_row_t := (others => '0');
+
+  -- lowest set bit at index >= start, v'length if none
+  function next_set(v : std_logic_vector; start : natural) return natural is
+    variable r : natural := v'length;
+  begin
+    for k in v'high downto v'low loop
+      if (k >= start) and (v(k) = '1') then
+        r := k;
+      end if;
+    end loop;
+    return r;
+  end function;
+
   type edge_mem_t is array (0 to EDGE_N-1) of std_logic_vector(7 downto 0);
   signal edge_mem : edge_mem_t;
   attribute syn_ramstyle of edge_mem : signal is "block_ram";
@@ -182,14 +326,14 @@ architecture rtl of gng is
   signal node_wdata : node_word_t := (others => '0');
 
   -- Edge BRAM ports
-  signal edge_raddr : unsigned(12 downto 0) := (others => '0');
+  signal edge_raddr : unsigned(EDGE_AW-1 downto 0) := (others => '0');
   signal edge_rdata : std_logic_vector(7 downto 0) := (others => '0');
   signal edge_we    : std_logic := '0';
-  signal edge_waddr : unsigned(12 downto 0) := (others => '0');
+  signal edge_waddr : unsigned(EDGE_AW-1 downto 0) := (others => '0');
   signal edge_wdata : std_logic_vector(7 downto 0) := (others => '0');
 
   -- dataset
-  signal data_addr : unsigned(6 downto 0) := (others => '0');
+  signal data_addr : unsigned(9 downto 0) := (others => '0');
   signal sample_x  : s16 := (others => '0');
   signal sample_y  : s16 := (others => '0');
 
@@ -212,6 +356,9 @@ architecture rtl of gng is
     P_WIN_WAIT,
     P_WIN_EVAL,
 
+    -- PIPE_WIN: take / repair the speculative result
+    P_WIN_SPEC, P_WIN_FIX, P_WIN_FIX_WAIT, P_WIN_ACCEPT,
+
     P_UPD_RD,
     P_UPD_WAIT,
     P_UPD_WR,
@@ -220,19 +367,18 @@ architecture rtl of gng is
     P_NB_NODE_REQ,
     P_NB_NODE_WAIT,
     P_NB_NODE_EVAL,
-    P_NB_EDGE_WAIT,
-    P_NB_EDGE_EVAL,
+    P_RENORM_SETUP,
+    P_RENORM_RUN,
 
     P_S1_WRBACK,     -- write s1 with updated deg/err/act
 
+    -- PIPE_WIN: prefetch next sample, start speculative search
+    P_SPEC_REQ, P_SPEC_WAIT, P_SPEC_LATCH,
+
     P_CONN_SETUP,
     P_CONN_EDGE_WAIT,
     P_CONN_EDGE_WR,
-    P_CONN_DEGA_RD,
-    P_CONN_DEGA_WAIT,
     P_CONN_DEGA_WR,
-    P_CONN_DEGB_RD,
-    P_CONN_DEGB_WAIT,
     P_CONN_DEGB_WR,
 
     -- insert every LAMBDA (TRUE GNG: q=max error, f=max-error neighbor of q)
@@ -257,17 +403,12 @@ architecture rtl of gng is
     -- debug reads
     P_DBG_EDGE01_REQ,
     P_DBG_EDGE01_WAIT,
-    P_DBG_DEG_S1_RD,
-    P_DBG_DEG_S1_WAIT,
-    P_DBG_DEG_S1_EVAL,
-    P_DBG_DEG_S2_RD,
-    P_DBG_DEG_S2_WAIT,
-    P_DBG_DEG_S2_EVAL,
     P_DBG_EDGE01_EVAL,
 
     P_TX_PREP,
     P_TX_SEND,
     P_TX_WAIT,
+    P_TX_END,
     P_NEXT,
 
     -- snapshot streaming (A5 20 nodes, A5 21 edges)
@@ -276,16 +417,77 @@ architecture rtl of gng is
     P_SNAP_NODE_B0, P_SNAP_NODE_B1, P_SNAP_NODE_B2, P_SNAP_NODE_B3,
     P_SNAP_NODE_B4, P_SNAP_NODE_B5, P_SNAP_NODE_B6, P_SNAP_NODE_NEXT,
 
-    P_SNAP_EDGE_CNT_INIT, P_SNAP_EDGE_CNT_RD, P_SNAP_EDGE_CNT_WAIT, P_SNAP_EDGE_CNT_EVAL,
     P_SNAP_EDGE_HDR0, P_SNAP_EDGE_HDR1, P_SNAP_EDGE_HDR2, P_SNAP_EDGE_HDR3,
     P_SNAP_EDGE_SEND_INIT, P_SNAP_EDGE_SEND_RD, P_SNAP_EDGE_SEND_WAIT, P_SNAP_EDGE_SEND_EVAL,
     P_SNAP_EDGE_B0, P_SNAP_EDGE_B1, P_SNAP_EDGE_B2, P_SNAP_EDGE_ADV,
+    P_SNAP_EDGE_PICK,
+    P_SNAP_BM_HDR0, P_SNAP_BM_HDR1, P_SNAP_BM_HDR2, P_SNAP_BM_HDR3,
+    P_SNAP_BM_INIT, P_SNAP_BM_RD, P_SNAP_BM_WAIT, P_SNAP_BM_EVAL, P_SNAP_BM_DONE,
+
+    -- SNAP_SHADOW: copy into the shadow BRAMs
+    P_SHC_SETUP, P_SHC_RUN,
 
     -- single-byte TX engine
     P_STX_SEND, P_STX_WAIT
   );
   signal ph : phase_t := P_IDLE;
 
+  -- phase groups of phase_o (order = tb_gng.vhd PHG_NAMES)
+  constant PHG_IDLE   : natural := 0;   -- idle, init, DBG_DELAY_MS wait
+  constant PHG_SAMPLE : natural := 1;
+  constant PHG_WIN    : natural := 2;   -- winner scan / PIPE_WIN take-over
+  constant PHG_UPD    : natural := 3;   -- s1 move + error
+  constant PHG_NB     : natural := 4;   -- neighbor pass + s1 write-back
+  constant PHG_RENORM : natural := 5;
+  constant PHG_SPEC   : natural := 6;   -- PIPE_WIN prefetch
+  constant PHG_CONN   : natural := 7;
+  constant PHG_INS    : natural := 8;
+  constant PHG_DBG    : natural := 9;   -- DBG TLV
+  constant PHG_SNAP   : natural := 10;  -- snapshot stream / shadow copy
+  constant PHG_NEXT   : natural := 11;
+
+  function phase_group(p : phase_t) return natural is
+  begin
+    case p is
+      when P_SAMPLE_REQ | P_SAMPLE_WAIT =>
+        return PHG_SAMPLE;
+      when P_WIN_SETUP | P_WIN_REQ | P_WIN_WAIT | P_WIN_EVAL |
+           P_WIN_SPEC | P_WIN_FIX | P_WIN_FIX_WAIT | P_WIN_ACCEPT =>
+        return PHG_WIN;
+      when P_UPD_RD | P_UPD_WAIT | P_UPD_WR =>
+        return PHG_UPD;
+      when P_NB_SETUP | P_NB_NODE_REQ | P_NB_NODE_WAIT | P_NB_NODE_EVAL | P_S1_WRBACK =>
+        return PHG_NB;
+      when P_RENORM_SETUP | P_RENORM_RUN =>
+        return PHG_RENORM;
+      when P_SPEC_REQ | P_SPEC_WAIT | P_SPEC_LATCH =>
+        return PHG_SPEC;
+      when P_CONN_SETUP | P_CONN_EDGE_WAIT | P_CONN_EDGE_WR | P_CONN_DEGA_WR | P_CONN_DEGB_WR =>
+        return PHG_CONN;
+      when P_INS_CHECK |
+           P_INS_Q_SETUP | P_INS_Q_REQ | P_INS_Q_WAIT | P_INS_Q_EVAL |
+           P_INS_F_SETUP | P_INS_F_NODE_REQ | P_INS_F_NODE_WAIT | P_INS_F_NODE_EVAL |
+           P_INS_F_EDGE_WAIT | P_INS_F_EDGE_EVAL |
+           P_INS_FIND_SETUP | P_INS_FIND_REQ | P_INS_FIND_WAIT | P_INS_FIND_EVAL |
+           P_INS_CLR_EDGE |
+           P_INS_Q_RD | P_INS_Q_WAIT2 | P_INS_Q_LATCH |
+           P_INS_F_RD | P_INS_F_WAIT2 | P_INS_F_LATCH |
+           P_INS_NODE_WR | P_INS_DEL_OLD_WR | P_INS_EDGE1_WR | P_INS_EDGE2_WR |
+           P_INS_Q_ERR_WR | P_INS_F_ERR_WR =>
+        return PHG_INS;
+      when P_DBG_EDGE01_REQ | P_DBG_EDGE01_WAIT | P_DBG_EDGE01_EVAL |
+           P_TX_PREP | P_TX_SEND | P_TX_WAIT | P_TX_END =>
+        return PHG_DBG;
+      when P_NEXT =>
+        return PHG_NEXT;
+      when P_IDLE | P_INIT_CLR_NODE | P_INIT_CLR_EDGE | P_INIT_SEED0 | P_INIT_SEED1 |
+           P_INIT_SEED_EDGE0 | P_INIT_SEED_EDGE1 | P_WAIT_100MS =>
+        return PHG_IDLE;
+      when others =>
+        return PHG_SNAP;   -- P_SNAP_*, P_SHC_*, P_STX_*
+    end case;
+  end function;
+
   signal started : std_logic := '0';
 
   signal init_n : natural range 0 to MAX_NODES-1 := 0;
@@ -296,6 +498,18 @@ architecture rtl of gng is
   constant DELAY_TICKS : natural := (CLOCK_HZ/1000) * DBG_DELAY_MS;
   signal delay_cnt : integer range 0 to integer(DELAY_TICKS) := 0;
 
+  -- error renorm stream (read i, write i-2)
+  type dc_i_t is array (0 to 1) of natural range 0 to MAX_NODES-1;
+  signal dc_rd : natural range 0 to MAX_NODES := 0;
+  signal dc_i  : dc_i_t := (others => 0);
+  signal dc_v  : std_logic_vector(1 downto 0) := (others => '0');
+
+  -- lazy error decay (stored err = err * err_scale)
+  signal err_scale  : unsigned(15 downto 0) := ERR_SC_ONE;
+  signal err_inv    : unsigned(16 downto 0) := ERR_IV_ONE;
+  signal err_renorm : std_logic := '0';
+  signal add_sc     : u32 := (others => '0');
+
   -- winner scan
   signal scan_i : natural range 0 to MAX_NODES := 0;
   signal best_id    : unsigned(7 downto 0) := (others => '0');
@@ -355,7 +569,6 @@ architecture rtl of gng is
 
   signal ins_qx, ins_qy : s16 := (others => '0');
   signal ins_fx, ins_fy : s16 := (others => '0');
-  signal ins_qdeg, ins_fdeg : u8 := (others => '0');
   signal ins_qact, ins_fact : std_logic := '0';
   signal ins_qerr_lat, ins_ferr_lat : u32 := (others => '0');
 
@@ -378,6 +591,30 @@ architecture rtl of gng is
   type tx_buf_t is array (0 to 63) of std_logic_vector(7 downto 0);
   signal tx_buf : tx_buf_t := (others => (others => '0'));
 
+  -- core side of the UART (muxed with the ring drain below)
+  signal core_tx_start : std_logic := '0';
+  signal core_tx_data  : std_logic_vector(7 downto 0) := (others => '0');
+
+  -- DBG decimation
+  signal dbg_cnt : natural range 0 to DBG_EVERY := 0;
+  signal dbg_now : std_logic := '0';
+
+  -- DBG_RING: byte FIFO, pointers carry one wrap bit
+  constant RING_AW : natural := clog2(DBG_RING_BYTES);
+  type ring_mem_t is array (0 to DBG_RING_BYTES-1) of std_logic_vector(7 downto 0);
+  signal ring_mem : ring_mem_t;
+  attribute syn_ramstyle of ring_mem : signal is "block_ram";
+
+  signal ring_we    : std_logic := '0';
+  signal ring_wdata : std_logic_vector(7 downto 0) := (others => '0');
+  signal ring_wr    : unsigned(RING_AW downto 0) := (others => '0');
+  signal ring_rd    : unsigned(RING_AW downto 0) := (others => '0');
+  signal ring_rdata : std_logic_vector(7 downto 0) := (others => '0');
+  signal ring_fill  : unsigned(RING_AW downto 0);
+
+  signal drn_tx_start : std_logic := '0';
+  signal drn_tx_data  : std_logic_vector(7 downto 0) := (others => '0');
+
   -- Tags
   constant B_A5 : std_logic_vector(7 downto 0) := x"A5";
   constant B_A6 : std_logic_vector(7 downto 0) := x"A6";
@@ -414,9 +651,9 @@ architecture rtl of gng is
   -- =========================================================
   -- SNAPSHOT control
   -- =========================================================
-  constant SNAP_EVERY : natural := 50; -- snapshot interval
   signal snap_cnt : natural range 0 to SNAP_EVERY-1 := 0;
   signal snap_now : std_logic := '0';
+  signal topo_chg : std_logic := '0'; -- structural change since last snapshot
 
   -- node snapshot regs
   signal sn_node_i : natural range 0 to MAX_NODES-1 := 0;
@@ -439,12 +676,97 @@ architecture rtl of gng is
 
   constant B_20 : std_logic_vector(7 downto 0) := x"20";
   constant B_21 : std_logic_vector(7 downto 0) := x"21";
+  constant B_22 : std_logic_vector(7 downto 0) := x"22";
+
+  -- adjacency bitmap snapshot (A5 22)
+  constant EDGE_BM_BYTES : natural := (MAX_NODES*(MAX_NODES-1)/2 + 7) / 8;
+  signal sn_bm_byte : std_logic_vector(7 downto 0) := (others => '0');
+  signal sn_bm_bit  : natural range 0 to 7 := 0;
+
+  -- SNAP_SHADOW (see 1.D): shadow node word = y & x & deg & act
+  subtype sh_word_t is std_logic_vector(40 downto 0);
+  type sh_node_mem_t is array (0 to MAX_NODES-1) of sh_word_t;
+  signal sh_node_mem : sh_node_mem_t;
+  attribute syn_ramstyle of sh_node_mem : signal is "block_ram";
+  signal sh_edge_mem : edge_mem_t;
+  attribute syn_ramstyle of sh_edge_mem : signal is "block_ram";
+
+  signal shn_we    : std_logic := '0';
+  signal shn_waddr : unsigned(7 downto 0) := (others => '0');
+  signal shn_wdata : sh_word_t := (others => '0');
+  signal shn_raddr : unsigned(7 downto 0) := (others => '0');
+  signal shn_rdata : sh_word_t := (others => '0');
+  signal she_we    : std_logic := '0';
+  signal she_waddr : unsigned(EDGE_AW-1 downto 0) := (others => '0');
+  signal she_wdata : std_logic_vector(7 downto 0) := (others => '0');
+  signal she_raddr : unsigned(EDGE_AW-1 downto 0) := (others => '0');
+  signal she_rdata : std_logic_vector(7 downto 0) := (others => '0');
+
+  -- copy stream (read i, write i-2)
+  constant SHC_N : natural := imax(MAX_NODES, EDGE_N);
+  type shc_i_t is array (0 to 1) of natural range 0 to SHC_N-1;
+  signal shc_rd : natural range 0 to SHC_N := 0;
+  signal shc_i  : shc_i_t := (others => 0);
+  signal shc_v  : std_logic_vector(1 downto 0) := (others => '0');
+
+  signal snap_pend   : std_logic := '0';  -- due while the dump was busy
+  signal sh_count    : u8 := (others => '0');
+  signal sh_edge_cnt : unsigned(15 downto 0) := (others => '0');
+
+  -- dump engine <-> core (go pulse) and <-> ring drain (byte handshake)
+  signal dmp_go   : std_logic := '0';
+  signal dmp_busy : std_logic := '0';
+  signal dmp_vld  : std_logic := '0';
+  signal dmp_ack  : std_logic := '0';
+  signal dmp_byte : std_logic_vector(7 downto 0) := (others => '0');
+
+  -- =========================================================
+  -- PIPE_WIN: speculative winner search (see 3.A above)
+  -- =========================================================
+  -- position replica (x, y, act) with its own read port for the engine
+  subtype pos_word_t is std_logic_vector(ACT_B downto X_L);
+  type win_mem_t is array (0 to MAX_NODES-1) of pos_word_t;
+  signal win_mem : win_mem_t;
+  attribute syn_ramstyle of win_mem : signal is "block_ram";
+
+  signal win_we    : std_logic := '0';
+  signal win_waddr : unsigned(7 downto 0) := (others => '0');
+  signal win_wdata : pos_word_t := (others => '0');
+  signal win_raddr : unsigned(7 downto 0) := (others => '0');
+  signal win_rdata : pos_word_t := (others => '0');
+
+  -- nodes whose position/act changed since the speculative search started
+  signal pos_dirty  : std_logic_vector(MAX_NODES-1 downto 0) := (others => '0');
+  signal spec_valid : std_logic := '0';
+  signal spec_x     : s16 := (others => '0');
+  signal spec_y     : s16 := (others => '0');
+
+  -- engine handshake (go = 1-cycle pulse, fix = keep result, scan dirty only)
+  signal eng_go   : std_logic := '0';
+  signal eng_fix  : std_logic := '0';
+  signal eng_busy : std_logic := '0';
+  signal eng_best_id   : unsigned(7 downto 0) := (others => '0');
+  signal eng_second_id : unsigned(7 downto 0) := (others => '0');
+  signal eng_best_d2   : unsigned(34 downto 0) := (others => '1');
+  signal eng_second_d2 : unsigned(34 downto 0) := (others => '1');
 
 begin
 
+  assert (MAX_NODES >= 2) and (MAX_NODES <= 255)
+    report "gng: MAX_NODES must be 2..255" severity failure;
+  assert (DATA_WORDS >= 1) and (DATA_WORDS <= 1024)
+    report "gng: DATA_WORDS must be 1..1024" severity failure;
+  assert (ERR_DECAY_SHIFT >= 1) and (ERR_DECAY_SHIFT <= 15)
+    report "gng: ERR_DECAY_SHIFT must be 1..15" severity failure;
+  assert DBG_RING or not SNAP_SHADOW
+    report "gng: SNAP_SHADOW needs DBG_RING (the drain sends the dump)" severity failure;
+  assert (POS_W >= 11) and (POS_W <= 16) and (ERR_W >= 8) and (ERR_W <= 32)
+    report "gng: POS_W must be 11..16, ERR_W 8..32" severity failure;
+
   data_raddr_o <= data_addr;
   gng_busy_o   <= started;
   gng_done_o   <= done_p;
+  phase_o      <= std_logic_vector(to_unsigned(phase_group(ph), 4));
 
   -- Free-running cycle counter
   -- Resets on hardware reset OR soft-reset (start_i='1') so timestamps
@@ -482,6 +804,443 @@ begin
     end if;
   end process;
 
+  -- =========================================================
+  -- PIPE_WIN: position replica + speculative winner engine
+  -- =========================================================
+  g_pipe_win : if PIPE_WIN generate
+    type ev_i_t is array (0 to 1) of natural range 0 to MAX_NODES-1;
+    signal ev_i  : ev_i_t := (others => 0);
+    signal ev_v  : std_logic_vector(1 downto 0) := (others => '0');
+    signal rd_i  : natural range 0 to MAX_NODES := MAX_NODES;
+    signal mask  : std_logic_vector(MAX_NODES-1 downto 0) := (others => '0');
+    signal ex, ey : s16 := (others => '0');
+  begin
+
+    -- replica BRAM (sync read), written with node_mem position changes
+    process(clk_i)
+    begin
+      if rising_edge(clk_i) then
+        win_rdata <= win_mem(to_integer(win_raddr));
+        if win_we = '1' then
+          win_mem(to_integer(win_waddr)) <= win_wdata;
+        end if;
+      end if;
+    end process;
+
+    win_raddr <= to_unsigned(rd_i, 8) when rd_i < MAX_NODES else (others => '0');
+
+    -- one address per cycle; ev_v/ev_i follow the 2-cycle read latency
+    process(clk_i)
+      variable dx_s, dy_s : signed(16 downto 0);
+      variable d2   : unsigned(34 downto 0);
+      variable id   : unsigned(7 downto 0);
+      variable b_id, s_id : unsigned(7 downto 0);
+      variable b_d2, s_d2 : unsigned(34 downto 0);
+    begin
+      if rising_edge(clk_i) then
+        if rstn_i = '0' or start_i = '1' then
+          eng_busy <= '0';
+          rd_i <= MAX_NODES;
+          ev_v <= (others => '0');
+
+        elsif eng_go = '1' then
+          eng_busy <= '1';
+          rd_i <= 0;
+          ev_v <= (others => '0');
+          ex <= spec_x;
+          ey <= spec_y;
+          if eng_fix = '1' then
+            mask <= pos_dirty;
+          else
+            mask <= (others => '1');
+            eng_best_d2   <= (others => '1');
+            eng_second_d2 <= (others => '1');
+            eng_best_id   <= (others => '0');
+            eng_second_id <= (others => '0');
+          end if;
+
+        elsif eng_busy = '1' then
+          if rd_i < MAX_NODES then
+            rd_i <= rd_i + 1;
+            ev_v(0) <= '1';
+            ev_i(0) <= rd_i;
+          else
+            ev_v(0) <= '0';
+          end if;
+          ev_v(1) <= ev_v(0);
+          ev_i(1) <= ev_i(0);
+
+          if ev_v(1) = '1' then
+            b_id := eng_best_id;   b_d2 := eng_best_d2;
+            s_id := eng_second_id; s_d2 := eng_second_d2;
+            id := to_unsigned(ev_i(1), 8);
+
+            if (mask(ev_i(1)) = '1') and (win_rdata(ACT_B) = '1') then
+              dx_s := resize(ex,17) - resize(signed(win_rdata(X_H downto X_L)),17);
+              dy_s := resize(ey,17) - resize(signed(win_rdata(Y_H downto Y_L)),17);
+              d2 := resize(unsigned(dx_s * dx_s),35) + resize(unsigned(dy_s * dy_s),35);
+
+              -- (d2, id) order: a fix-up merges out of index order
+              if (d2 < b_d2) or (d2 = b_d2 and id < b_id) then
+                s_id := b_id; s_d2 := b_d2;
+                b_id := id;   b_d2 := d2;
+              elsif (d2 < s_d2) or (d2 = s_d2 and id < s_id) then
+                s_id := id;   s_d2 := d2;
+              end if;
+            end if;
+
+            eng_best_id   <= b_id; eng_best_d2   <= b_d2;
+            eng_second_id <= s_id; eng_second_d2 <= s_d2;
+
+            if ev_i(1) = MAX_NODES-1 then
+              eng_busy <= '0';
+              ev_v <= (others => '0');
+            end if;
+          end if;
+        end if;
+      end if;
+    end process;
+
+  end generate;
+
+  -- =========================================================
+  -- DBG_RING: TX byte FIFO + drain to uart_tx
+  -- =========================================================
+  ring_fill <= ring_wr - ring_rd;
+
+  tx_start_o <= drn_tx_start when DBG_RING else core_tx_start;
+  tx_data_o  <= drn_tx_data  when DBG_RING else core_tx_data;
+
+  g_dbg_ring : if DBG_RING generate
+    type drn_t is (DR_IDLE, DR_RD, DR_SEND, DR_HOLD, DR_WAIT);
+    signal drn   : drn_t := DR_IDLE;
+    signal waddr : unsigned(RING_AW-1 downto 0) := (others => '0');
+    signal raddr : unsigned(RING_AW-1 downto 0) := (others => '0');
+    signal dmp_own : std_logic := '0';   -- SNAP_SHADOW dump holds the UART
+  begin
+
+    -- ring BRAM (sync read); waddr follows ring_wr by one push
+    process(clk_i)
+    begin
+      if rising_edge(clk_i) then
+        ring_rdata <= ring_mem(to_integer(raddr));
+        if ring_we = '1' then
+          ring_mem(to_integer(waddr)) <= ring_wdata;
+        end if;
+        if rstn_i = '0' then
+          waddr <= (others => '0');
+        elsif ring_we = '1' then
+          waddr <= waddr + 1;
+        end if;
+      end if;
+    end process;
+
+    process(clk_i)
+    begin
+      if rising_edge(clk_i) then
+        drn_tx_start <= '0';
+        dmp_ack <= '0';
+        if rstn_i = '0' then
+          drn <= DR_IDLE;
+          ring_rd <= (others => '0');
+          raddr <= (others => '0');
+          dmp_own <= '0';
+        else
+          case drn is
+            -- ring bytes only start on an empty-ring boundary of the dump,
+            -- so a snapshot never splits a DBG record (or vice versa)
+            when DR_IDLE =>
+              if dmp_own = '1' then
+                if (dmp_vld = '1') and (tx_busy_i = '0') then
+                  drn_tx_start <= '1';
+                  drn_tx_data  <= dmp_byte;
+                  dmp_ack <= '1';
+                  drn <= DR_HOLD;
+                elsif dmp_busy = '0' then
+                  dmp_own <= '0';
+                end if;
+              elsif (ring_fill /= 0) and (tx_busy_i = '0') then
+                raddr <= ring_rd(RING_AW-1 downto 0);
+                drn <= DR_RD;
+              elsif (dmp_vld = '1') and (tx_busy_i = '0') then
+                dmp_own <= '1';
+                drn_tx_start <= '1';
+                drn_tx_data  <= dmp_byte;
+                dmp_ack <= '1';
+                drn <= DR_HOLD;
+              end if;
+
+            when DR_RD =>
+              drn <= DR_SEND;
+
+            when DR_SEND =>
+              drn_tx_start <= '1';
+              drn_tx_data  <= ring_rdata;
+              ring_rd <= ring_rd + 1;
+              drn <= DR_HOLD;
+
+            when DR_HOLD =>
+              drn <= DR_WAIT;            -- tx_busy_i rises one cycle after start
+
+            when DR_WAIT =>
+              if tx_busy_i = '0' then
+                drn <= DR_IDLE;
+              end if;
+          end case;
+        end if;
+      end if;
+    end process;
+
+  end generate;
+
+  -- =========================================================
+  -- SNAP_SHADOW: shadow BRAMs + dump engine (see 1.D)
+  -- =========================================================
+  g_snap_shadow : if SNAP_SHADOW generate
+    type dm_t is (DM_IDLE, DM_NHDR, DM_NODE_RD, DM_NODE_WAIT, DM_NODE_LATCH,
+                  DM_NODE_B, DM_PICK, DM_EHDR, DM_EDGE_RD, DM_EDGE_WAIT,
+                  DM_EDGE_EVAL, DM_EDGE_B, DM_EMIT, DM_DONE);
+    signal dm      : dm_t := DM_IDLE;
+    signal dm_next : dm_t := DM_IDLE;
+    signal dm_b    : natural range 0 to 6 := 0;  -- byte of header / record
+    signal dm_node : natural range 0 to MAX_NODES-1 := 0;
+    signal dm_w    : sh_word_t := (others => '0');
+    signal dm_bm   : std_logic := '0';           -- A5 22 instead of A5 21
+    signal dm_i    : natural range 0 to MAX_NODES-2 := 0;
+    signal dm_j    : natural range 1 to MAX_NODES-1 := 1;
+    signal dm_ej   : natural range 1 to MAX_NODES-1 := 1;
+    signal dm_val  : std_logic_vector(7 downto 0) := (others => '0');
+    signal dm_end  : std_logic := '0';           -- record holds the last edge
+    signal dm_bm_byte : std_logic_vector(7 downto 0) := (others => '0');
+    signal dm_bm_bit  : natural range 0 to 7 := 0;
+  begin
+
+    -- shadow BRAMs (sync read), written by P_SHC_RUN only
+    process(clk_i)
+    begin
+      if rising_edge(clk_i) then
+        shn_rdata <= sh_node_mem(to_integer(shn_raddr));
+        if shn_we = '1' then
+          sh_node_mem(to_integer(shn_waddr)) <= shn_wdata;
+        end if;
+      end if;
+    end process;
+
+    process(clk_i)
+    begin
+      if rising_edge(clk_i) then
+        she_rdata <= sh_edge_mem(to_integer(she_raddr));
+        if she_we = '1' then
+          sh_edge_mem(to_integer(she_waddr)) <= she_wdata;
+        end if;
+      end if;
+    end process;
+
+    -- same frames as P_SNAP_*, one byte per dmp_vld/dmp_ack
+    process(clk_i)
+      variable last : boolean;
+      variable bm_v : std_logic_vector(7 downto 0);
+    begin
+      if rising_edge(clk_i) then
+        if rstn_i = '0' or start_i = '1' then
+          dm <= DM_IDLE;
+          dmp_busy <= '0';
+          dmp_vld <= '0';
+        else
+          case dm is
+            when DM_IDLE =>
+              if dmp_go = '1' then
+                dmp_busy <= '1';
+                dm_b <= 0;
+                dm <= DM_NHDR;
+              end if;
+
+            -- A5 20 MAX_NODES node_count
+            when DM_NHDR =>
+              case dm_b is
+                when 0      => dmp_byte <= B_A5;
+                when 1      => dmp_byte <= B_20;
+                when 2      => dmp_byte <= std_logic_vector(to_unsigned(MAX_NODES, 8));
+                when others => dmp_byte <= std_logic_vector(sh_count);
+              end case;
+              dmp_vld <= '1';
+              if dm_b = 3 then
+                dm_node <= 0;
+                dm_next <= DM_NODE_RD;
+              else
+                dm_b <= dm_b + 1;
+                dm_next <= DM_NHDR;
+              end if;
+              dm <= DM_EMIT;
+
+            when DM_NODE_RD =>
+              shn_raddr <= to_unsigned(dm_node, 8);
+              dm <= DM_NODE_WAIT;
+
+            when DM_NODE_WAIT =>
+              dm <= DM_NODE_LATCH;
+
+            when DM_NODE_LATCH =>
+              dm_w <= shn_rdata;
+              dm_b <= 0;
+              dm <= DM_NODE_B;
+
+            -- id, act, deg, xlo, xhi, ylo, yhi
+            when DM_NODE_B =>
+              case dm_b is
+                when 0      => dmp_byte <= std_logic_vector(to_unsigned(dm_node, 8));
+                when 1      => dmp_byte <= "0000000" & dm_w(0);
+                when 2      => dmp_byte <= dm_w(8 downto 1);
+                when 3      => dmp_byte <= dm_w(16 downto 9);
+                when 4      => dmp_byte <= dm_w(24 downto 17);
+                when 5      => dmp_byte <= dm_w(32 downto 25);
+                when others => dmp_byte <= dm_w(40 downto 33);
+              end case;
+              dmp_vld <= '1';
+              if dm_b = 6 then
+                if dm_node = MAX_NODES-1 then
+                  dm_next <= DM_PICK;
+                else
+                  dm_node <= dm_node + 1;
+                  dm_next <= DM_NODE_RD;
+                end if;
+              else
+                dm_b <= dm_b + 1;
+                dm_next <= DM_NODE_B;
+              end if;
+              dm <= DM_EMIT;
+
+            when DM_PICK =>
+              if SNAP_EDGE_BITMAP and (to_integer(sh_edge_cnt) * 3 > EDGE_BM_BYTES) then
+                dm_bm <= '1';
+              else
+                dm_bm <= '0';
+              end if;
+              dm_b <= 0;
+              dm <= DM_EHDR;
+
+            -- A5 21 cnt_lo cnt_hi  or  A5 22 nbytes_lo nbytes_hi
+            when DM_EHDR =>
+              case dm_b is
+                when 0 =>
+                  dmp_byte <= B_A5;
+                when 1 =>
+                  if dm_bm = '1' then dmp_byte <= B_22; else dmp_byte <= B_21; end if;
+                when 2 =>
+                  if dm_bm = '1' then
+                    dmp_byte <= std_logic_vector(to_unsigned(EDGE_BM_BYTES mod 256, 8));
+                  else
+                    dmp_byte <= std_logic_vector(sh_edge_cnt(7 downto 0));
+                  end if;
+                when others =>
+                  if dm_bm = '1' then
+                    dmp_byte <= std_logic_vector(to_unsigned(EDGE_BM_BYTES / 256, 8));
+                  else
+                    dmp_byte <= std_logic_vector(sh_edge_cnt(15 downto 8));
+                  end if;
+              end case;
+              dmp_vld <= '1';
+              if dm_b = 3 then
+                dm_i <= 0;
+                dm_j <= 1;
+                dm_bm_byte <= (others => '0');
+                dm_bm_bit  <= 0;
+                dm_next <= DM_EDGE_RD;
+              else
+                dm_b <= dm_b + 1;
+                dm_next <= DM_EHDR;
+              end if;
+              dm <= DM_EMIT;
+
+            when DM_EDGE_RD =>
+              she_raddr <= to_unsigned(edge_idx(dm_i, dm_j, MAX_NODES), EDGE_AW);
+              dm <= DM_EDGE_WAIT;
+
+            when DM_EDGE_WAIT =>
+              dm <= DM_EDGE_EVAL;
+
+            when DM_EDGE_EVAL =>
+              last := (dm_i = MAX_NODES-2) and (dm_j = MAX_NODES-1);
+              if not last then
+                if dm_j = MAX_NODES-1 then
+                  dm_i <= dm_i + 1;
+                  dm_j <= dm_i + 2;
+                else
+                  dm_j <= dm_j + 1;
+                end if;
+              end if;
+
+              if dm_bm = '1' then
+                -- one bit per edge_idx, LSB first; flush full / last byte
+                bm_v := dm_bm_byte;
+                if she_rdata /= x"00" then
+                  bm_v(dm_bm_bit) := '1';
+                end if;
+                if last or (dm_bm_bit = 7) then
+                  dmp_byte <= bm_v;
+                  dmp_vld <= '1';
+                  dm_bm_byte <= (others => '0');
+                  dm_bm_bit  <= 0;
+                  if last then
+                    dm_next <= DM_DONE;
+                  else
+                    dm_next <= DM_EDGE_RD;
+                  end if;
+                  dm <= DM_EMIT;
+                else
+                  dm_bm_byte <= bm_v;
+                  dm_bm_bit  <= dm_bm_bit + 1;
+                  dm <= DM_EDGE_RD;
+                end if;
+
+              elsif she_rdata /= x"00" then
+                -- triplet (i, j, ageStored)
+                dmp_byte <= std_logic_vector(to_unsigned(dm_i, 8));
+                dmp_vld <= '1';
+                dm_ej  <= dm_j;
+                dm_val <= she_rdata;
+                if last then dm_end <= '1'; else dm_end <= '0'; end if;
+                dm_b <= 1;
+                dm_next <= DM_EDGE_B;
+                dm <= DM_EMIT;
+              elsif last then
+                dm <= DM_DONE;
+              else
+                dm <= DM_EDGE_RD;
+              end if;
+
+            when DM_EDGE_B =>
+              dmp_vld <= '1';
+              if dm_b = 1 then
+                dmp_byte <= std_logic_vector(to_unsigned(dm_ej, 8));
+                dm_b <= 2;
+                dm_next <= DM_EDGE_B;
+              else
+                dmp_byte <= dm_val;
+                if dm_end = '1' then
+                  dm_next <= DM_DONE;
+                else
+                  dm_next <= DM_EDGE_RD;
+                end if;
+              end if;
+              dm <= DM_EMIT;
+
+            when DM_EMIT =>
+              if dmp_ack = '1' then
+                dmp_vld <= '0';
+                dm <= dm_next;
+              end if;
+
+            when DM_DONE =>
+              dmp_busy <= '0';
+              dm <= DM_IDLE;
+          end case;
+        end if;
+      end if;
+    end process;
+
+  end generate;
+
   process(clk_i)
     variable dx_s : signed(16 downto 0);
     variable dy_s : signed(16 downto 0);
@@ -493,15 +1252,18 @@ begin
     variable d2    : unsigned(34 downto 0);
 
     variable w    : node_word_t;
+    variable wn   : node_word_t;
     variable act  : std_logic;
     variable deg  : u8;
     variable nx   : s16;
     variable ny   : s16;
 
     variable cur_err : u32;
-    variable add_err : u32;
     variable new_err : u32;
     variable dec_err : u32;
+    variable sum_err : unsigned(32 downto 0);
+    variable sc_nx   : unsigned(16 downto 0);
+    variable iv_nx   : unsigned(16 downto 0);
 
     -- winner move
     variable mulx_w : signed(32 downto 0);
@@ -528,8 +1290,24 @@ begin
     variable idxe   : natural;
 
     variable is_s2_edge : boolean;
+    variable k          : natural range 0 to MAX_NODES;
+    variable bm_v       : std_logic_vector(7 downto 0);
 
     constant D2_INF : unsigned(34 downto 0) := (others => '1');
+
+    -- edge(a,b) created ('1') or removed ('0'): bitmap + active-edge count
+    procedure adj_wr(a : natural; b : natural; v : std_logic) is
+    begin
+      if adj_r(a)(b) /= v then
+        if v = '1' then
+          edge_cnt_r <= edge_cnt_r + 1;
+        else
+          edge_cnt_r <= edge_cnt_r - 1;
+        end if;
+      end if;
+      adj_r(a)(b) <= v;
+      adj_r(b)(a) <= v;
+    end procedure;
   begin
     if rising_edge(clk_i) then
       if rstn_i = '0' then
@@ -600,8 +1378,6 @@ begin
         ins_qy <= (others => '0');
         ins_fx <= (others => '0');
         ins_fy <= (others => '0');
-        ins_qdeg <= (others => '0');
-        ins_fdeg <= (others => '0');
         ins_qact <= '0';
         ins_fact <= '0';
         ins_qerr_lat <= (others => '0');
@@ -611,8 +1387,12 @@ begin
         dbg_deg_s1 <= (others => '0');
         dbg_deg_s2 <= (others => '0');
 
-        tx_start_o <= '0';
-        tx_data_o <= (others => '0');
+        core_tx_start <= '0';
+        core_tx_data <= (others => '0');
+        ring_we <= '0';
+        ring_wr <= (others => '0');
+        dbg_cnt <= 0;
+        dbg_now <= '0';
         tx_inflight <= '0';
         tx_idx <= 0;
         tx_len <= 0;
@@ -620,6 +1400,7 @@ begin
         -- snapshot reset
         snap_cnt <= 0;
         snap_now <= '0';
+        topo_chg <= '0';
 
         sn_node_i <= 0;
         sn_act_s  <= '0';
@@ -637,6 +1418,17 @@ begin
         stx_byte <= (others=>'0');
         stx_next <= P_IDLE;
 
+        win_we <= '0';
+        eng_go <= '0';
+        eng_fix <= '0';
+        spec_valid <= '0';
+        pos_dirty <= (others => '0');
+
+        shn_we <= '0';
+        she_we <= '0';
+        dmp_go <= '0';
+        snap_pend <= '0';
+
       elsif start_i = '1' then
         -- -------------------------------------------------------
         -- SOFT RESET: new dataset arrived (fires from any state)
@@ -649,7 +1441,12 @@ begin
         node_we      <= '0';
         edge_we      <= '0';
         done_p       <= '0';
-        tx_start_o   <= '0';
+        err_scale    <= ERR_SC_ONE;
+        err_inv      <= ERR_IV_ONE;
+        err_renorm   <= '0';
+        core_tx_start <= '0';
+        ring_we      <= '0';
+        dbg_cnt      <= 0;
         tx_inflight  <= '0';
         tx_idx       <= 0;
         tx_len       <= 0;
@@ -658,12 +1455,17 @@ begin
         insert_now   <= '0';
         snap_cnt     <= 0;
         snap_now     <= '0';
+        snap_pend    <= '0';
+        topo_chg     <= '0';
         node_count   <= (others => '0');
         rm_flag      <= '0';
         iso_flag     <= '0';
         ins_flag     <= '0';
         ins_f_found  <= '0';
         delay_cnt    <= integer(DELAY_TICKS);
+        win_we       <= '0';
+        eng_go       <= '0';
+        spec_valid   <= '0';
         -- cycle_cnt is driven by its own process (reset via start_i there)
         dbg_ts       <= (others => '0');
 
@@ -672,7 +1474,18 @@ begin
         node_we <= '0';
         edge_we <= '0';
         done_p  <= '0';
-        tx_start_o <= '0';
+        core_tx_start <= '0';
+        ring_we <= '0';
+        win_we  <= '0';
+        eng_go  <= '0';
+        shn_we  <= '0';
+        she_we  <= '0';
+        dmp_go  <= '0';
+
+        -- replica write landing now -> node moved under the speculative search
+        if win_we = '1' then
+          pos_dirty(to_integer(win_waddr)) <= '1';
+        end if;
 
         if tx_inflight = '1' then
           if (tx_done_i = '1') or (tx_busy_i = '0') then
@@ -694,6 +1507,10 @@ begin
             node_we <= '1';
             node_waddr <= to_unsigned(init_n, 8);
             node_wdata <= (others => '0');
+            deg_r(init_n) <= (others => '0');
+            win_we <= '1';
+            win_waddr <= to_unsigned(init_n, 8);
+            win_wdata <= (others => '0');
             if init_n = MAX_NODES-1 then
               init_e <= 0;
               ph <= P_INIT_CLR_EDGE;
@@ -703,8 +1520,10 @@ begin
 
           when P_INIT_CLR_EDGE =>
             edge_we <= '1';
-            edge_waddr <= to_unsigned(init_e, 13);
+            edge_waddr <= to_unsigned(init_e, EDGE_AW);
             edge_wdata <= (others => '0');
+            adj_r <= (others => (others => '0'));
+            edge_cnt_r <= (others => '0');
             if init_e = EDGE_N-1 then
               ph <= P_INIT_SEED0;
             else
@@ -712,32 +1531,37 @@ begin
             end if;
 
           when P_INIT_SEED0 =>
+            wn := pack_node(to_signed(INIT_X0,16), to_signed(INIT_Y0,16), '1', (others=>'0'));
             node_we <= '1';
             node_waddr <= to_unsigned(0,8);
-            node_wdata <= pack_node(to_signed(INIT_X0,16), to_signed(INIT_Y0,16), '1', to_unsigned(0,8), (others=>'0'));
+            node_wdata <= wn;
+            win_we <= '1';
+            win_waddr <= to_unsigned(0,8);
+            win_wdata <= wn(ACT_B downto X_L);
             ph <= P_INIT_SEED1;
 
           when P_INIT_SEED1 =>
+            wn := pack_node(to_signed(INIT_X1,16), to_signed(INIT_Y1,16), '1', (others=>'0'));
             node_we <= '1';
             node_waddr <= to_unsigned(1,8);
-            node_wdata <= pack_node(to_signed(INIT_X1,16), to_signed(INIT_Y1,16), '1', to_unsigned(0,8), (others=>'0'));
+            node_wdata <= wn;
+            win_we <= '1';
+            win_waddr <= to_unsigned(1,8);
+            win_wdata <= wn(ACT_B downto X_L);
             ph <= P_INIT_SEED_EDGE0;
 
           when P_INIT_SEED_EDGE0 =>
             idxe := edge_idx(0,1,MAX_NODES);
             edge_we <= '1';
-            edge_waddr <= to_unsigned(idxe, 13);
+            edge_waddr <= to_unsigned(idxe, EDGE_AW);
             edge_wdata <= x"01";
+            adj_wr(0, 1, '1');
 
-            node_we <= '1';
-            node_waddr <= to_unsigned(0,8);
-            node_wdata <= pack_node(to_signed(INIT_X0,16), to_signed(INIT_Y0,16), '1', to_unsigned(1,8), (others=>'0'));
+            deg_r(0) <= to_unsigned(1,8);
             ph <= P_INIT_SEED_EDGE1;
 
           when P_INIT_SEED_EDGE1 =>
-            node_we <= '1';
-            node_waddr <= to_unsigned(1,8);
-            node_wdata <= pack_node(to_signed(INIT_X1,16), to_signed(INIT_Y1,16), '1', to_unsigned(1,8), (others=>'0'));
+            deg_r(1) <= to_unsigned(1,8);
 
             node_count <= to_unsigned(2,8);
             samp_i <= 0;
@@ -761,23 +1585,44 @@ begin
               insert_now <= '0';
             end if;
 
-            -- decide snapshot for THIS iteration (every SNAP_EVERY)
-            if snap_cnt = SNAP_EVERY-1 then
+            -- decide snapshot for THIS iteration (every SNAP_EVERY, or
+            -- SNAP_ON_CHANGE after a change of the previous iterations)
+            if (snap_cnt = SNAP_EVERY-1) or
+               (SNAP_ON_CHANGE and topo_chg = '1' and snap_cnt + 1 >= SNAP_MIN_GAP) then
               snap_cnt <= 0;
               snap_now <= '1';
+              topo_chg <= '0';
             else
               snap_cnt <= snap_cnt + 1;
               snap_now <= '0';
             end if;
 
+            -- DBG TLV for THIS iteration (every DBG_EVERY, 0 = off)
+            if DBG_EVERY = 0 then
+              dbg_now <= '0';
+            elsif dbg_cnt >= DBG_EVERY-1 then
+              dbg_cnt <= 0;
+              dbg_now <= '1';
+            else
+              dbg_cnt <= dbg_cnt + 1;
+              dbg_now <= '0';
+            end if;
+
             dbg_ts    <= cycle_cnt; -- latch FPGA timestamp for this iteration
-            data_addr <= to_unsigned(samp_i, 7);
+            data_addr <= to_unsigned(samp_i, 10);
             ph <= P_SAMPLE_WAIT;
 
           when P_SAMPLE_WAIT =>
-            sample_x <= signed(data_rdata_i(15 downto 0));
-            sample_y <= signed(data_rdata_i(31 downto 16));
-            ph <= P_WIN_SETUP;
+            if PIPE_WIN and spec_valid = '1' then
+              sample_x <= spec_x;
+              sample_y <= spec_y;
+              spec_valid <= '0';
+              ph <= P_WIN_SPEC;
+            else
+              sample_x <= signed(data_rdata_i(15 downto 0));
+              sample_y <= signed(data_rdata_i(31 downto 16));
+              ph <= P_WIN_SETUP;
+            end if;
 
           when P_WIN_SETUP =>
             rm_flag  <= '0';
@@ -841,32 +1686,97 @@ begin
               ph <= P_WIN_REQ;
             end if;
 
+          -- PIPE_WIN: speculative result of P_SPEC_LATCH (3.A)
+          when P_WIN_SPEC =>
+            rm_flag  <= '0';
+            iso_flag <= '0';
+            ins_flag <= '0';
+
+            if eng_busy = '0' then
+              if (pos_dirty(to_integer(eng_best_id)) = '1') or
+                 ((eng_second_d2 /= D2_INF) and (pos_dirty(to_integer(eng_second_id)) = '1')) then
+                eng_fix <= '0';               -- candidate moved: full rescan
+                eng_go  <= '1';
+                ph <= P_WIN_FIX;
+              elsif unsigned(pos_dirty) /= 0 then
+                eng_fix <= '1';               -- merge the moved nodes only
+                eng_go  <= '1';
+                ph <= P_WIN_FIX;
+              else
+                ph <= P_WIN_ACCEPT;
+              end if;
+            end if;
+
+          when P_WIN_FIX =>
+            ph <= P_WIN_FIX_WAIT;             -- eng_busy valid from next cycle
+
+          when P_WIN_FIX_WAIT =>
+            if eng_busy = '0' then
+              ph <= P_WIN_ACCEPT;
+            end if;
+
+          when P_WIN_ACCEPT =>
+            best_d2   <= eng_best_d2;
+            second_d2 <= eng_second_d2;
+            best_id   <= eng_best_id;
+            second_id <= eng_second_id;
+            s1_id <= eng_best_id;
+            s2_id <= eng_second_id;
+            if eng_second_d2 = D2_INF then
+              s2_valid <= '0';
+            else
+              s2_valid <= '1';
+            end if;
+            ph <= P_UPD_RD;
+
           when P_UPD_RD =>
             node_raddr <= s1_id;
             ph <= P_UPD_WAIT;
 
           when P_UPD_WAIT =>
+            -- add_err in the stored (scaled) domain, off the P_UPD_WR path
+            if best_d2 = D2_INF then
+              add_sc <= (others => '0');
+            else
+              add_sc <= resize(shift_right(
+                          resize(shift_right(best_d2, ERR_SHIFT), 32) * err_scale,
+                          ERR_SC_FB), 32);
+            end if;
             ph <= P_UPD_WR;
 
           when P_UPD_WR =>
             w := node_rdata;
             act := get_act(w);
-            deg := get_deg(w);
+            deg := deg_r(to_integer(s1_id));
             nx  := get_x(w);
             ny  := get_y(w);
             cur_err := get_err(w);
 
-            if best_d2 = D2_INF then
-              add_err := (others=>'0');
+            -- lazy decay: add_sc = add_err * err_scale, the other nodes
+            -- keep their stored error (saturate instead of wrapping)
+            sum_err := resize(cur_err, 33) + resize(add_sc, 33);
+            if sum_err(32) = '1' then
+              new_err := (others => '1');
             else
-              add_err := resize(shift_right(best_d2, ERR_SHIFT), 32);
+              new_err := sum_err(31 downto 0);
             end if;
 
-            new_err := cur_err + add_err;
-            -- error decay on s1
-            new_err := new_err - shift_right(new_err, ERR_DECAY_SHIFT);
-
-            dbg_err32 <= new_err;
+            -- err_scale /= (1 - 2^-ERR_DECAY_SHIFT), 2nd order series;
+            -- at 2.0 halve the scale and (P_RENORM_RUN) every stored error
+            sc_nx := resize(err_scale, 17)
+                   + shift_right(err_scale, ERR_DECAY_SHIFT)
+                   + shift_right(err_scale, 2*ERR_DECAY_SHIFT);
+            iv_nx := err_inv - shift_right(err_inv, ERR_DECAY_SHIFT);
+            if sc_nx(16) = '1' then
+              err_scale  <= sc_nx(16 downto 1);
+              err_inv    <= iv_nx(15 downto 0) & '0';
+              err_renorm <= '1';
+              new_err    := shift_right(new_err, 1);
+            else
+              err_scale  <= sc_nx(15 downto 0);
+              err_inv    <= iv_nx;
+              err_renorm <= '0';
+            end if;
 
             -- move winner
             dx_s := resize(sample_x,17) - resize(nx,17);
@@ -891,77 +1801,62 @@ begin
             s1x_reg    <= sat_s16(nx_new);
             s1y_reg    <= sat_s16(ny_new);
 
+            wn := pack_node(sat_s16(nx_new), sat_s16(ny_new), act, new_err);
             node_we <= '1';
             node_waddr <= s1_id;
-            node_wdata <= pack_node(sat_s16(nx_new), sat_s16(ny_new), act, deg, new_err);
+            node_wdata <= wn;
+            win_we <= '1';
+            win_waddr <= s1_id;
+            win_wdata <= wn(ACT_B downto X_L);
 
             ins_i <= 0;
             ph <= P_NB_SETUP;
 
+          -- neighbors of s1 only: next set bit of the adjacency row
           when P_NB_SETUP =>
             ins_i <= 0;
+            nb_row <= adj_r(to_integer(s1_id));
             ph <= P_NB_NODE_REQ;
 
           when P_NB_NODE_REQ =>
-            node_raddr <= to_unsigned(ins_i, 8);
-            ph <= P_NB_NODE_WAIT;
-
-          when P_NB_NODE_WAIT =>
-            ph <= P_NB_NODE_EVAL;
-
-          when P_NB_NODE_EVAL =>
-            w := node_rdata;
-            act := get_act(w);
-
-            if (ins_i = to_integer(s1_id)) or (act = '0') then
-              if ins_i = MAX_NODES-1 then
-                ph <= P_S1_WRBACK;
+            -- node k and edge(s1, k) live in separate BRAMs: read both at once
+            k := next_set(nb_row, ins_i);
+            if k = MAX_NODES then
+              if err_renorm = '1' then
+                ph <= P_RENORM_SETUP;
               else
-                ins_i <= ins_i + 1;
-                ph <= P_NB_NODE_REQ;
+                ph <= P_S1_WRBACK;
               end if;
             else
-              -- read edge(s1, ins_i)
+              ins_i <= k;
+              node_raddr <= to_unsigned(k, 8);
               i1 := to_integer(s1_id);
-              i2 := ins_i;
-              if i1 < i2 then
-                idxe := edge_idx(i1, i2, MAX_NODES);
+              if i1 < k then
+                idxe := edge_idx(i1, k, MAX_NODES);
               else
-                idxe := edge_idx(i2, i1, MAX_NODES);
+                idxe := edge_idx(k, i1, MAX_NODES);
               end if;
-              edge_raddr <= to_unsigned(idxe, 13);
-              ph <= P_NB_EDGE_WAIT;
+              edge_raddr <= to_unsigned(idxe, EDGE_AW);
+              ph <= P_NB_NODE_WAIT;
             end if;
 
-          when P_NB_EDGE_WAIT =>
-            ph <= P_NB_EDGE_EVAL;
+          when P_NB_NODE_WAIT =>
+            ph <= P_NB_NODE_EVAL;
 
-          when P_NB_EDGE_EVAL =>
-            -- node_rdata still holds this neighbor
+          when P_NB_NODE_EVAL =>
             w := node_rdata;
             act := get_act(w);
-            deg := get_deg(w);
+            deg := deg_r(ins_i);
             nx  := get_x(w);
             ny  := get_y(w);
             cur_err := get_err(w);
 
-            -- error decay for all active nodes (except s1, already decayed)
-            dec_err := cur_err - shift_right(cur_err, ERR_DECAY_SHIFT);
-
             age_u := unsigned(edge_rdata);
 
             -- identify if this edge is (s1,s2) : do NOT prune it here
             is_s2_edge := (s2_valid = '1') and (ins_i = to_integer(s2_id));
 
-            if age_u = 0 then
-              -- not neighbor: only update error decay
-              if dec_err /= cur_err then
-                node_we <= '1';
-                node_waddr <= to_unsigned(ins_i, 8);
-                node_wdata <= pack_node(nx, ny, act, deg, dec_err);
-              end if;
-
-            else
+            if age_u /= 0 then
               -- neighbor edge exists: age++ (unless s1-s2, will be reset by connect)
               if age_u = to_unsigned(255,8) then
                 age_new_u := age_u;
@@ -974,7 +1869,9 @@ begin
                 edge_we <= '1';
                 edge_waddr <= edge_raddr;
                 edge_wdata <= x"00";
+                adj_wr(to_integer(s1_id), ins_i, '0');
                 rm_flag <= '1';
+                topo_chg <= '1';
 
                 if s1_deg_reg > to_unsigned(0,8) then
                   s1_deg_reg <= s1_deg_reg - 1;
@@ -992,9 +1889,7 @@ begin
                   -- no node_count decrement
                 end if;
 
-                node_we <= '1';
-                node_waddr <= to_unsigned(ins_i, 8);
-                node_wdata <= pack_node(nx, ny, act, deg, dec_err);
+                deg_r(ins_i) <= deg;
 
               else
                 -- keep edge (update age if not s1-s2), move neighbor
@@ -1017,19 +1912,61 @@ begin
                 nx_nb_new := resize(nx,18) + resize(delx_n,18);
                 ny_nb_new := resize(ny,18) + resize(dely_n,18);
 
+                -- error decay is lazy (err_scale), see P_UPD_WR
+                wn := pack_node(sat_s16(nx_nb_new), sat_s16(ny_nb_new), act, cur_err);
                 node_we <= '1';
                 node_waddr <= to_unsigned(ins_i, 8);
-                node_wdata <= pack_node(sat_s16(nx_nb_new), sat_s16(ny_nb_new), act, deg, dec_err);
+                node_wdata <= wn;
+                win_we <= '1';
+                win_waddr <= to_unsigned(ins_i, 8);
+                win_wdata <= wn(ACT_B downto X_L);
               end if;
             end if;
 
             if ins_i = MAX_NODES-1 then
-              ph <= P_S1_WRBACK;
+              if err_renorm = '1' then
+                ph <= P_RENORM_SETUP;
+              else
+                ph <= P_S1_WRBACK;
+              end if;
             else
               ins_i <= ins_i + 1;
               ph <= P_NB_NODE_REQ;
             end if;
 
+          -- err_scale wrapped: halve all active errors (except s1, already
+          -- halved in P_UPD_WR), read i, write back i-2, 1 node per cycle
+          when P_RENORM_SETUP =>
+            dc_rd <= 0;
+            dc_v  <= (others => '0');
+            ph <= P_RENORM_RUN;
+
+          when P_RENORM_RUN =>
+            if dc_rd < MAX_NODES then
+              node_raddr <= to_unsigned(dc_rd, 8);
+              dc_i(0) <= dc_rd;
+              dc_v(0) <= '1';
+              dc_rd <= dc_rd + 1;
+            else
+              dc_v(0) <= '0';
+            end if;
+            dc_i(1) <= dc_i(0);
+            dc_v(1) <= dc_v(0);
+
+            if dc_v(1) = '1' then
+              w := node_rdata;
+              cur_err := get_err(w);
+              dec_err := shift_right(cur_err, 1);
+              if (get_act(w) = '1') and (dc_i(1) /= to_integer(s1_id)) and (dec_err /= cur_err) then
+                node_we <= '1';
+                node_waddr <= to_unsigned(dc_i(1), 8);
+                node_wdata <= pack_node(get_x(w), get_y(w), '1', dec_err);
+              end if;
+              if dc_i(1) = MAX_NODES-1 then
+                ph <= P_S1_WRBACK;
+              end if;
+            end if;
+
           when P_S1_WRBACK =>
             -- FIX: keep s1 active even if degree becomes 0; only flag
             if (s1_act_reg = '1') and (s1_deg_reg = to_unsigned(0,8)) then
@@ -1041,7 +1978,36 @@ begin
 
             node_we <= '1';
             node_waddr <= s1_id;
-            node_wdata <= pack_node(s1x_reg, s1y_reg, s1_act_reg, s1_deg_reg, s1_err_reg);
+            node_wdata <= pack_node(s1x_reg, s1y_reg, s1_act_reg, s1_err_reg);
+            deg_r(to_integer(s1_id)) <= s1_deg_reg;
+            -- DBG reports the true error: stored * 1/err_scale
+            dbg_err32 <= resize(shift_right(s1_err_reg * err_inv, 16), 32);
+            if PIPE_WIN then
+              ph <= P_SPEC_REQ;
+            else
+              ph <= P_CONN_SETUP;
+            end if;
+
+          -- PIPE_WIN: all moves of this sample are written; start the
+          -- search for the next one (same index P_NEXT will pick)
+          when P_SPEC_REQ =>
+            if samp_i = DATA_WORDS-1 then
+              data_addr <= to_unsigned(0, 10);
+            else
+              data_addr <= to_unsigned(samp_i + 1, 10);
+            end if;
+            ph <= P_SPEC_WAIT;
+
+          when P_SPEC_WAIT =>
+            ph <= P_SPEC_LATCH;               -- dataset BRAM is registered
+
+          when P_SPEC_LATCH =>
+            spec_x <= signed(data_rdata_i(15 downto 0));
+            spec_y <= signed(data_rdata_i(31 downto 16));
+            spec_valid <= '1';
+            pos_dirty <= (others => '0');
+            eng_fix <= '0';
+            eng_go  <= '1';
             ph <= P_CONN_SETUP;
 
           when P_CONN_SETUP =>
@@ -1055,7 +2021,7 @@ begin
               else
                 idxe := edge_idx(i2, i1, MAX_NODES);
               end if;
-              edge_raddr <= to_unsigned(idxe, 13);
+              edge_raddr <= to_unsigned(idxe, EDGE_AW);
               ph <= P_CONN_EDGE_WAIT;
             end if;
 
@@ -1069,46 +2035,24 @@ begin
             edge_wdata <= x"01";         -- reset age
 
             if edge_rdata = x"00" then
-              ph <= P_CONN_DEGA_RD;      -- new edge -> deg++
+              topo_chg <= '1';
+              adj_wr(to_integer(s1_id), to_integer(s2_id), '1');
+              ph <= P_CONN_DEGA_WR;      -- new edge -> deg++
             else
               ph <= P_INS_CHECK;
             end if;
 
-          when P_CONN_DEGA_RD =>
-            node_raddr <= s1_id;
-            ph <= P_CONN_DEGA_WAIT;
-
-          when P_CONN_DEGA_WAIT =>
-            ph <= P_CONN_DEGA_WR;
-
+          -- degrees are in deg_r: one cycle per read-modify-write
+          -- (s1/s2 come from the winner scan, so both are active)
           when P_CONN_DEGA_WR =>
-            w := node_rdata;
-            act := get_act(w);
-            deg := get_deg(w);
-            if act='1' then
-              if deg < to_unsigned(255,8) then deg := deg + 1; end if;
-              node_we <= '1';
-              node_waddr <= s1_id;
-              node_wdata <= pack_node(get_x(w), get_y(w), act, deg, get_err(w));
+            if deg_r(to_integer(s1_id)) < to_unsigned(255,8) then
+              deg_r(to_integer(s1_id)) <= deg_r(to_integer(s1_id)) + 1;
             end if;
-            ph <= P_CONN_DEGB_RD;
-
-          when P_CONN_DEGB_RD =>
-            node_raddr <= s2_id;
-            ph <= P_CONN_DEGB_WAIT;
-
-          when P_CONN_DEGB_WAIT =>
             ph <= P_CONN_DEGB_WR;
 
           when P_CONN_DEGB_WR =>
-            w := node_rdata;
-            act := get_act(w);
-            deg := get_deg(w);
-            if act='1' then
-              if deg < to_unsigned(255,8) then deg := deg + 1; end if;
-              node_we <= '1';
-              node_waddr <= s2_id;
-              node_wdata <= pack_node(get_x(w), get_y(w), act, deg, get_err(w));
+            if deg_r(to_integer(s2_id)) < to_unsigned(255,8) then
+              deg_r(to_integer(s2_id)) <= deg_r(to_integer(s2_id)) + 1;
             end if;
             ph <= P_INS_CHECK;
 
@@ -1198,7 +2142,7 @@ begin
             if i1 < i2 then idxe := edge_idx(i1,i2,MAX_NODES);
             else idxe := edge_idx(i2,i1,MAX_NODES);
             end if;
-            edge_raddr <= to_unsigned(idxe,13);
+            edge_raddr <= to_unsigned(idxe, EDGE_AW);
             ph <= P_INS_F_EDGE_WAIT;
 
           when P_INS_F_EDGE_WAIT =>
@@ -1269,8 +2213,9 @@ begin
                 idxe := edge_idx(i2, i1, MAX_NODES);
               end if;
               edge_we <= '1';
-              edge_waddr <= to_unsigned(idxe, 13);
+              edge_waddr <= to_unsigned(idxe, EDGE_AW);
               edge_wdata <= x"00";
+              adj_wr(ins_free, ins_j, '0');
 
               if ins_j = MAX_NODES-1 then
                 ph <= P_INS_Q_RD;
@@ -1290,7 +2235,6 @@ begin
           when P_INS_Q_LATCH =>
             w := node_rdata;
             ins_qact <= get_act(w);
-            ins_qdeg <= get_deg(w);
             ins_qx   <= get_x(w);
             ins_qy   <= get_y(w);
             ins_qerr_lat <= get_err(w);
@@ -1307,7 +2251,6 @@ begin
           when P_INS_F_LATCH =>
             w := node_rdata;
             ins_fact <= get_act(w);
-            ins_fdeg <= get_deg(w);
             ins_fx   <= get_x(w);
             ins_fy   <= get_y(w);
             ins_ferr_lat <= get_err(w);
@@ -1315,17 +2258,22 @@ begin
 
           -- write new node at midpoint(q,f)
           when P_INS_NODE_WR =>
-            node_we <= '1';
-            node_waddr <= to_unsigned(ins_free,8);
-            node_wdata <= pack_node(
+            wn := pack_node(
               sat_s16( resize( shift_right( resize(ins_qx,17) + resize(ins_fx,17), 1 ), 18) ),
               sat_s16( resize( shift_right( resize(ins_qy,17) + resize(ins_fy,17), 1 ), 18) ),
               '1',
-              to_unsigned(2,8),
               shift_right(ins_qerr_lat, INS_ALPHA_SHIFT)
             );
+            deg_r(ins_free) <= to_unsigned(2,8);
+            node_we <= '1';
+            node_waddr <= to_unsigned(ins_free,8);
+            node_wdata <= wn;
+            win_we <= '1';
+            win_waddr <= to_unsigned(ins_free,8);
+            win_wdata <= wn(ACT_B downto X_L);
 
             ins_flag <= '1';
+            topo_chg <= '1';
             ins_id_dbg <= to_unsigned(ins_free,8);
 
             if node_count < to_unsigned(MAX_NODES,8) then
@@ -1342,8 +2290,9 @@ begin
             else idxe := edge_idx(i2,i1,MAX_NODES);
             end if;
             edge_we <= '1';
-            edge_waddr <= to_unsigned(idxe, 13);
+            edge_waddr <= to_unsigned(idxe, EDGE_AW);
             edge_wdata <= x"00";
+            adj_wr(to_integer(ins_q_id), to_integer(ins_f_id), '0');
             ph <= P_INS_EDGE1_WR;
 
           -- edge(q,new)=1
@@ -1354,8 +2303,9 @@ begin
             else idxe := edge_idx(i2,i1,MAX_NODES);
             end if;
             edge_we <= '1';
-            edge_waddr <= to_unsigned(idxe, 13);
+            edge_waddr <= to_unsigned(idxe, EDGE_AW);
             edge_wdata <= x"01";
+            adj_wr(to_integer(ins_q_id), ins_free, '1');
             ph <= P_INS_EDGE2_WR;
 
           -- edge(new,f)=1
@@ -1366,21 +2316,22 @@ begin
             else idxe := edge_idx(i2,i1,MAX_NODES);
             end if;
             edge_we <= '1';
-            edge_waddr <= to_unsigned(idxe, 13);
+            edge_waddr <= to_unsigned(idxe, EDGE_AW);
             edge_wdata <= x"01";
+            adj_wr(ins_free, to_integer(ins_f_id), '1');
             ph <= P_INS_Q_ERR_WR;
 
           -- scale down errors of q and f (alpha=0.5)
           when P_INS_Q_ERR_WR =>
             node_we <= '1';
             node_waddr <= ins_q_id;
-            node_wdata <= pack_node(ins_qx, ins_qy, ins_qact, ins_qdeg, shift_right(ins_qerr_lat, INS_ALPHA_SHIFT));
+            node_wdata <= pack_node(ins_qx, ins_qy, ins_qact, shift_right(ins_qerr_lat, INS_ALPHA_SHIFT));
             ph <= P_INS_F_ERR_WR;
 
           when P_INS_F_ERR_WR =>
             node_we <= '1';
             node_waddr <= ins_f_id;
-            node_wdata <= pack_node(ins_fx, ins_fy, ins_fact, ins_fdeg, shift_right(ins_ferr_lat, INS_ALPHA_SHIFT));
+            node_wdata <= pack_node(ins_fx, ins_fy, ins_fact, shift_right(ins_ferr_lat, INS_ALPHA_SHIFT));
             ph <= P_DBG_EDGE01_REQ;
 
           -- =========================================================
@@ -1388,36 +2339,22 @@ begin
           -- =========================================================
           when P_DBG_EDGE01_REQ =>
             idxe := edge_idx(0,1,MAX_NODES);
-            edge_raddr <= to_unsigned(idxe, 13);
-            ph <= P_DBG_EDGE01_WAIT;
+            edge_raddr <= to_unsigned(idxe, EDGE_AW);
+            -- no record this iteration, or no room for it in the ring
+            if (dbg_now = '0') or
+               (DBG_RING and ring_fill > to_unsigned(DBG_RING_BYTES - 54, RING_AW+1)) then
+              ph <= P_TX_END;
+            else
+              ph <= P_DBG_EDGE01_WAIT;
+            end if;
 
           when P_DBG_EDGE01_WAIT =>
             ph <= P_DBG_EDGE01_EVAL;
 
           when P_DBG_EDGE01_EVAL =>
             dbg_e01 <= edge_rdata;
-            ph <= P_DBG_DEG_S1_RD;
-
-          when P_DBG_DEG_S1_RD =>
-            node_raddr <= s1_id;
-            ph <= P_DBG_DEG_S1_WAIT;
-
-          when P_DBG_DEG_S1_WAIT =>
-            ph <= P_DBG_DEG_S1_EVAL;
-
-          when P_DBG_DEG_S1_EVAL =>
-            dbg_deg_s1 <= get_deg(node_rdata);
-            ph <= P_DBG_DEG_S2_RD;
-
-          when P_DBG_DEG_S2_RD =>
-            node_raddr <= s2_id;
-            ph <= P_DBG_DEG_S2_WAIT;
-
-          when P_DBG_DEG_S2_WAIT =>
-            ph <= P_DBG_DEG_S2_EVAL;
-
-          when P_DBG_DEG_S2_EVAL =>
-            dbg_deg_s2 <= get_deg(node_rdata);
+            dbg_deg_s1 <= deg_r(to_integer(s1_id));
+            dbg_deg_s2 <= deg_r(to_integer(s2_id));
             ph <= P_TX_PREP;
 
           when P_TX_PREP =>
@@ -1456,16 +2393,26 @@ begin
             tx_buf(48) <= B_B4; tx_buf(49) <= std_logic_vector(dbg_ts(23 downto 16));
             tx_buf(50) <= B_B5; tx_buf(51) <= std_logic_vector(dbg_ts(31 downto 24));
 
-            tx_buf(52) <= B_A9; tx_buf(53) <= std_logic_vector(to_unsigned(samp_i, 8));
+            tx_buf(52) <= B_A9; tx_buf(53) <= std_logic_vector(to_unsigned(samp_i mod 256, 8));
 
             tx_len <= 54;
             tx_idx <= 0;
             ph <= P_TX_SEND;
 
           when P_TX_SEND =>
-            if (tx_busy_i='0') and (tx_inflight='0') then
-              tx_start_o <= '1';
-              tx_data_o  <= tx_buf(tx_idx);
+            if DBG_RING then
+              -- room was checked in P_DBG_EDGE01_REQ: 1 byte/cycle
+              ring_we <= '1';
+              ring_wdata <= tx_buf(tx_idx);
+              ring_wr <= ring_wr + 1;
+              if tx_idx = tx_len-1 then
+                ph <= P_TX_END;
+              else
+                tx_idx <= tx_idx + 1;
+              end if;
+            elsif (tx_busy_i='0') and (tx_inflight='0') then
+              core_tx_start <= '1';
+              core_tx_data  <= tx_buf(tx_idx);
               tx_inflight <= '1';
               ph <= P_TX_WAIT;
             end if;
@@ -1473,25 +2420,48 @@ begin
           when P_TX_WAIT =>
             if (tx_done_i='1') or (tx_inflight='0') then
               if tx_idx = tx_len-1 then
-                if snap_now = '1' then
-                  ph <= P_SNAP_NODE_HDR0;
-                else
-                  done_p <= '1';
-                  ph <= P_NEXT;
-                end if;
+                ph <= P_TX_END;
               else
                 tx_idx <= tx_idx + 1;
                 ph <= P_TX_SEND;
               end if;
             end if;
 
+          when P_TX_END =>
+            if SNAP_SHADOW then
+              -- copy now if the dump engine is free, else at a later iteration
+              if ((snap_now = '1') or (snap_pend = '1')) and (dmp_busy = '0') then
+                snap_pend <= '0';
+                ph <= P_SHC_SETUP;
+              else
+                if snap_now = '1' then
+                  snap_pend <= '1';
+                end if;
+                done_p <= '1';
+                ph <= P_NEXT;
+              end if;
+            elsif snap_now = '1' then
+              ph <= P_SNAP_NODE_HDR0;
+            else
+              done_p <= '1';
+              ph <= P_NEXT;
+            end if;
+
           -- =========================================================
           -- Single-byte TX engine (stx_byte -> UART)
           -- =========================================================
           when P_STX_SEND =>
-            if (tx_busy_i='0') and (tx_inflight='0') then
-              tx_start_o <= '1';
-              tx_data_o  <= stx_byte;
+            if DBG_RING then
+              -- snapshot bytes wait for space
+              if ring_fill < to_unsigned(DBG_RING_BYTES, RING_AW+1) then
+                ring_we <= '1';
+                ring_wdata <= stx_byte;
+                ring_wr <= ring_wr + 1;
+                ph <= stx_next;
+              end if;
+            elsif (tx_busy_i='0') and (tx_inflight='0') then
+              core_tx_start <= '1';
+              core_tx_data  <= stx_byte;
               tx_inflight <= '1';
               ph <= P_STX_WAIT;
             end if;
@@ -1531,7 +2501,7 @@ begin
           when P_SNAP_NODE_LATCH =>
             w := node_rdata;
             sn_act_s <= get_act(w);
-            sn_deg_s <= get_deg(w);
+            sn_deg_s <= deg_r(sn_node_i);
             sn_x_s   <= get_x(w);
             sn_y_s   <= get_y(w);
             ph <= P_SNAP_NODE_B0;
@@ -1573,46 +2543,24 @@ begin
 
           when P_SNAP_NODE_NEXT =>
             if sn_node_i = MAX_NODES-1 then
-              ph <= P_SNAP_EDGE_CNT_INIT;
+              sn_edge_cnt <= edge_cnt_r;      -- running count, no pre-pass
+              ph <= P_SNAP_EDGE_PICK;
             else
               sn_node_i <= sn_node_i + 1;
               ph <= P_SNAP_NODE_RD;
             end if;
 
           -- =========================================================
-          -- EDGE SNAPSHOT (active-only): 2-pass
-          -- Pass1 count edges!=0  => send header A5 21 cnt_lo cnt_hi
-          -- Pass2 send triplets (i,j,ageStored) only if edge!=0
+          -- EDGE SNAPSHOT (active-only)
+          -- header A5 21 cnt_lo cnt_hi (cnt = edge_cnt_r), then
+          -- triplets (i,j,ageStored) only if edge!=0
           -- =========================================================
-          when P_SNAP_EDGE_CNT_INIT =>
-            sn_edge_cnt <= (others=>'0');
-            sn_e_i <= 0;
-            sn_e_j <= 1;
-            ph <= P_SNAP_EDGE_CNT_RD;
-
-          when P_SNAP_EDGE_CNT_RD =>
-            idxe := edge_idx(sn_e_i, sn_e_j, MAX_NODES);
-            edge_raddr <= to_unsigned(idxe, 13);
-            ph <= P_SNAP_EDGE_CNT_WAIT;
-
-          when P_SNAP_EDGE_CNT_WAIT =>
-            ph <= P_SNAP_EDGE_CNT_EVAL;
-
-          when P_SNAP_EDGE_CNT_EVAL =>
-            if edge_rdata /= x"00" then
-              sn_edge_cnt <= sn_edge_cnt + 1;
-            end if;
-
-            if (sn_e_i = MAX_NODES-2) and (sn_e_j = MAX_NODES-1) then
-              ph <= P_SNAP_EDGE_HDR0;
+          -- list (3 bytes per edge) or bitmap, whichever is shorter
+          when P_SNAP_EDGE_PICK =>
+            if SNAP_EDGE_BITMAP and (to_integer(sn_edge_cnt) * 3 > EDGE_BM_BYTES) then
+              ph <= P_SNAP_BM_HDR0;
             else
-              if sn_e_j = MAX_NODES-1 then
-                sn_e_i <= sn_e_i + 1;
-                sn_e_j <= sn_e_i + 2;
-              else
-                sn_e_j <= sn_e_j + 1;
-              end if;
-              ph <= P_SNAP_EDGE_CNT_RD;
+              ph <= P_SNAP_EDGE_HDR0;
             end if;
 
           when P_SNAP_EDGE_HDR0 =>
@@ -1638,7 +2586,7 @@ begin
 
           when P_SNAP_EDGE_SEND_RD =>
             idxe := edge_idx(sn_e_i, sn_e_j, MAX_NODES);
-            edge_raddr <= to_unsigned(idxe, 13);
+            edge_raddr <= to_unsigned(idxe, EDGE_AW);
             ph <= P_SNAP_EDGE_SEND_WAIT;
 
           when P_SNAP_EDGE_SEND_WAIT =>
@@ -1694,6 +2642,125 @@ begin
               ph <= P_SNAP_EDGE_SEND_RD;
             end if;
 
+          -- =========================================================
+          -- EDGE BITMAP: A5 22 nbytes_lo nbytes_hi, then one bit per
+          -- edge_idx (0 .. MAX_NODES*(MAX_NODES-1)/2-1), LSB first
+          -- =========================================================
+          when P_SNAP_BM_HDR0 =>
+            stx_byte <= x"A5"; stx_next <= P_SNAP_BM_HDR1; ph <= P_STX_SEND;
+
+          when P_SNAP_BM_HDR1 =>
+            stx_byte <= B_22;  stx_next <= P_SNAP_BM_HDR2; ph <= P_STX_SEND;
+
+          when P_SNAP_BM_HDR2 =>
+            stx_byte <= std_logic_vector(to_unsigned(EDGE_BM_BYTES mod 256, 8));
+            stx_next <= P_SNAP_BM_HDR3;
+            ph <= P_STX_SEND;
+
+          when P_SNAP_BM_HDR3 =>
+            stx_byte <= std_logic_vector(to_unsigned(EDGE_BM_BYTES / 256, 8));
+            stx_next <= P_SNAP_BM_INIT;
+            ph <= P_STX_SEND;
+
+          when P_SNAP_BM_INIT =>
+            sn_e_i <= 0;
+            sn_e_j <= 1;
+            sn_bm_byte <= (others=>'0');
+            sn_bm_bit  <= 0;
+            ph <= P_SNAP_BM_RD;
+
+          when P_SNAP_BM_RD =>
+            idxe := edge_idx(sn_e_i, sn_e_j, MAX_NODES);
+            edge_raddr <= to_unsigned(idxe, EDGE_AW);
+            ph <= P_SNAP_BM_WAIT;
+
+          when P_SNAP_BM_WAIT =>
+            ph <= P_SNAP_BM_EVAL;
+
+          when P_SNAP_BM_EVAL =>
+            bm_v := sn_bm_byte;
+            if edge_rdata /= x"00" then
+              bm_v(sn_bm_bit) := '1';
+            end if;
+
+            if (sn_e_i = MAX_NODES-2) and (sn_e_j = MAX_NODES-1) then
+              -- last edge: flush the (partly filled) byte
+              stx_byte <= bm_v;
+              stx_next <= P_SNAP_BM_DONE;
+              ph <= P_STX_SEND;
+            else
+              if sn_e_j = MAX_NODES-1 then
+                sn_e_i <= sn_e_i + 1;
+                sn_e_j <= sn_e_i + 2;
+              else
+                sn_e_j <= sn_e_j + 1;
+              end if;
+
+              if sn_bm_bit = 7 then
+                stx_byte <= bm_v;
+                sn_bm_byte <= (others=>'0');
+                sn_bm_bit  <= 0;
+                stx_next <= P_SNAP_BM_RD;
+                ph <= P_STX_SEND;
+              else
+                sn_bm_byte <= bm_v;
+                sn_bm_bit  <= sn_bm_bit + 1;
+                ph <= P_SNAP_BM_RD;
+              end if;
+            end if;
+
+          when P_SNAP_BM_DONE =>
+            done_p <= '1';
+            ph <= P_NEXT;
+
+          -- =========================================================
+          -- SNAP_SHADOW: node_mem (+deg_r) and edge_mem -> shadow BRAMs,
+          -- read i, write i-2, both memories in the same pass
+          -- =========================================================
+          when P_SHC_SETUP =>
+            shc_rd <= 0;
+            shc_v  <= (others => '0');
+            sh_count    <= node_count;
+            sh_edge_cnt <= edge_cnt_r;
+            ph <= P_SHC_RUN;
+
+          when P_SHC_RUN =>
+            if shc_rd < SHC_N then
+              if shc_rd < MAX_NODES then
+                node_raddr <= to_unsigned(shc_rd, 8);
+              end if;
+              if shc_rd < EDGE_N then
+                edge_raddr <= to_unsigned(shc_rd, EDGE_AW);
+              end if;
+              shc_i(0) <= shc_rd;
+              shc_v(0) <= '1';
+              shc_rd <= shc_rd + 1;
+            else
+              shc_v(0) <= '0';
+            end if;
+            shc_i(1) <= shc_i(0);
+            shc_v(1) <= shc_v(0);
+
+            if shc_v(1) = '1' then
+              if shc_i(1) < MAX_NODES then
+                w := node_rdata;
+                shn_we <= '1';
+                shn_waddr <= to_unsigned(shc_i(1), 8);
+                shn_wdata <= std_logic_vector(get_y(w)) & std_logic_vector(get_x(w))
+                           & std_logic_vector(deg_r(shc_i(1))) & get_act(w);
+              end if;
+              if shc_i(1) < EDGE_N then
+                she_we <= '1';
+                she_waddr <= to_unsigned(shc_i(1), EDGE_AW);
+                she_wdata <= edge_rdata;
+              end if;
+              if shc_i(1) = SHC_N-1 then
+                dmp_go <= '1';
+                done_p <= '1';
+                ph <= P_NEXT;
+              end if;
+            end if;
+
           -- =========================================================
           -- NEXT ITERATION
           -- =========================================================
@@ -14,7 +14,8 @@ entity gng_find_winner is
     busy_o  : out std_logic;
     done_o  : out std_logic;
 
-    -- sample input
+    -- sample input, latched by start_i (the next sample may be set up
+    -- while this one is searched)
     x_i : in signed(15 downto 0);
     y_i : in signed(15 downto 0);
 
@@ -53,6 +54,10 @@ architecture rtl of gng_find_winner is
   signal best_d    : u33_t := (others => '1');
   signal second_d  : u33_t := (others => '1');
 
+  -- sample of the running search (latched at start_i)
+  signal sx_l : signed(15 downto 0) := (others => '0');
+  signal sy_l : signed(15 downto 0) := (others => '0');
+
   -- optional debug latch
   signal nx : signed(15 downto 0) := (others => '0');
   signal ny : signed(15 downto 0) := (others => '0');
@@ -126,6 +131,8 @@ begin
               second_id <= (others => '0');
               best_d    <= (others => '1');
               second_d  <= (others => '1');
+              sx_l      <= x_i;
+              sy_l      <= y_i;
               st        <= ST_RD_SET;
             end if;
 
@@ -145,8 +152,8 @@ begin
             ny <= node_y;
 
             -- dx,dy in 17-bit to avoid overflow
-            dx17 := resize(x_i, 17) - resize(node_x, 17);
-            dy17 := resize(y_i, 17) - resize(node_y, 17);
+            dx17 := resize(sx_l, 17) - resize(node_x, 17);
+            dy17 := resize(sy_l, 17) - resize(node_y, 17);
 
             adx := abs_u16(dx17);
             ady := abs_u16(dy17);
@@ -0,0 +1,10 @@
+-- gng_layout.vhd : node_mem field widths of gng.vhd (V2)
+-- full widths (65-bit node word), the reference build
+-- generated by python -m gngio precision (gng_host/gngio/precision.py),
+-- re-run it with --vhd instead of editing
+
+package gng_layout is
+  constant LAYOUT_POS_W : natural := 16;  -- x / y (value * 1000, signed)
+  constant LAYOUT_ERR_W : natural := 32;  -- saturating error
+  constant LAYOUT_A_MAX : natural := 50;  -- A_MAX <= 2^8 - 2
+end package;
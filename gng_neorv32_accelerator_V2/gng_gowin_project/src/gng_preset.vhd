@@ -0,0 +1,14 @@
+-- gng_preset.vhd : build preset "default" (V2)
+-- DBG every iteration, blocking UART (the reference build)
+-- generated by gng_neorv32_accelerator_V3/gng_gowin_project/presets.py,
+-- re-run `python presets.py apply v2 <name>` instead of editing
+
+package gng_preset is
+  constant PRESET_NAME        : string := "default";
+  constant PRESET_MAX_NODES   : natural := 40;
+  constant PRESET_PIPE_WIN    : boolean := false;
+  constant PRESET_DBG_EVERY   : natural := 1;
+  constant PRESET_DBG_RING    : boolean := false;
+  constant PRESET_SNAP_SHADOW : boolean := false;
+  constant PRESET_SNAP_EVERY  : natural := 50;
+end package;
@@ -0,0 +1,113 @@
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+-- rx_word_store: UART bytes -> 32-bit dataset BRAM, ping-pong halves
+--
+-- Every 4 received bytes (xL xH yL yH) are written as one word straight
+-- into the half that GNG is NOT reading (wr_bank). After WORDS words the
+-- halves swap: bank_o (the read half) takes the new dataset, full_o pulses,
+-- and the next upload goes into the other half. No copy pass and no RX
+-- hold: a dataset can stream in while the core trains on the old one.
+--
+-- BRAM address = bank & word index (AW bits, 2**AW >= WORDS per half).
+entity rx_word_store is
+  generic (
+    WORDS : natural := 100;
+    AW    : natural := 7
+  );
+  port (
+    clk_i   : in  std_logic;
+    rstn_i  : in  std_logic; -- active-low
+
+    -- from UART RX
+    rx_valid_i : in  std_logic; -- pulse/level ok
+    rx_data_i  : in  std_logic_vector(7 downto 0);
+
+    -- pulse 1 clk when a full dataset landed (bank_o already switched)
+    full_o     : out std_logic;
+
+    -- half holding the last complete dataset (read side)
+    bank_o     : out std_logic;
+
+    -- some bytes of the next dataset received
+    busy_o     : out std_logic;
+
+    -- memory interface OUT (WRITE PORT), registered
+    mem_we_o    : out std_logic;
+    mem_waddr_o : out unsigned(AW downto 0);
+    mem_wdata_o : out std_logic_vector(31 downto 0)
+  );
+end entity;
+
+architecture rtl of rx_word_store is
+  signal word_i : natural range 0 to WORDS-1 := 0;
+  signal byte_k : unsigned(1 downto 0) := (others => '0');
+  signal b0, b1, b2 : std_logic_vector(7 downto 0) := (others => '0');
+
+  signal rd_bank : std_logic := '0';
+
+  -- edge detect rx_valid_i
+  signal v_d : std_logic := '0';
+  signal v_p : std_logic := '0';
+
+  signal we_r    : std_logic := '0';
+  signal waddr_r : unsigned(AW downto 0) := (others => '0');
+  signal wdata_r : std_logic_vector(31 downto 0) := (others => '0');
+  signal full    : std_logic := '0';
+
+begin
+  assert (WORDS >= 1) and (WORDS <= 2**AW)
+    report "rx_word_store: WORDS must fit in 2**AW" severity failure;
+
+  full_o <= full;
+  bank_o <= rd_bank;
+  busy_o <= '0' when (word_i = 0) and (byte_k = "00") else '1';
+
+  mem_we_o    <= we_r;
+  mem_waddr_o <= waddr_r;
+  mem_wdata_o <= wdata_r;
+
+  process(clk_i)
+  begin
+    if rising_edge(clk_i) then
+      -- defaults
+      full <= '0';
+      we_r <= '0';
+
+      -- edge detect
+      v_p <= rx_valid_i and (not v_d);
+      v_d <= rx_valid_i;
+
+      if rstn_i = '0' then
+        word_i  <= 0;
+        byte_k  <= (others => '0');
+        rd_bank <= '0';
+        v_d     <= '0';
+        v_p     <= '0';
+
+      elsif v_p = '1' then
+        case byte_k is
+          when "00"   => b0 <= rx_data_i;
+          when "01"   => b1 <= rx_data_i;
+          when "10"   => b2 <= rx_data_i;
+          when others =>
+            -- 4th byte: one word into the write half (= not rd_bank)
+            we_r    <= '1';
+            waddr_r <= (not rd_bank) & to_unsigned(word_i, AW);
+            wdata_r <= rx_data_i & b2 & b1 & b0; -- payload order: xL xH yL yH
+
+            if word_i = WORDS-1 then
+              word_i  <= 0;
+              rd_bank <= not rd_bank;
+              full    <= '1';
+            else
+              word_i <= word_i + 1;
+            end if;
+        end case;
+        byte_k <= byte_k + 1;
+      end if;
+    end if;
+  end process;
+
+end architecture;
@@ -2,11 +2,19 @@ library ieee;
 use ieee.std_logic_1164.all;
 use ieee.numeric_std.all;
 
+-- build preset (presets.py apply v2 <name>), see u_gng below
+use work.gng_preset.all;
+-- node_mem field widths (python -m gngio precision --vhd)
+use work.gng_layout.all;
+
 entity tang_nano_9k is
   generic (
     CLOCK_FREQUENCY : natural := 27_000_000;
     BAUD            : natural := 1_000_000;
-    IO_GPIO_NUM     : natural := 6
+    IO_GPIO_NUM     : natural := 6;
+    -- a new dataset restarts GNG (soft reset); false: keep the graph and
+    -- continue training on the new samples
+    DATA_SWAP_RESET : boolean := true
   );
   port (
     clk_i      : in  std_logic;
@@ -23,8 +31,19 @@ architecture rtl of tang_nano_9k is
   -- Dataset BRAM settings
   ---------------------------------------------------------------------------
   constant DEPTH_BYTES : natural := 400;
-  constant WORDS_C     : natural := DEPTH_BYTES/4; -- 100
-  constant GNG_MAX_NODES : natural := 40;
+  constant WORDS_C     : natural := DEPTH_BYTES/4; -- 100, up to 1024
+  constant GNG_MAX_NODES : natural := PRESET_MAX_NODES;
+
+  function clog2(n : natural) return natural is
+    variable r : natural := 0;
+  begin
+    while (2**r) < n loop
+      r := r + 1;
+    end loop;
+    return r;
+  end function;
+
+  constant DATA_AW : natural := clog2(WORDS_C);  -- word index of one half
 
   ---------------------------------------------------------------------------
   -- UART RX
@@ -44,48 +63,25 @@ architecture rtl of tang_nano_9k is
   signal txd      : std_logic;
 
   ---------------------------------------------------------------------------
-  -- BRAM_A (RX store 8-bit)
-  ---------------------------------------------------------------------------
-  type mem_a_t is array (0 to DEPTH_BYTES-1) of std_logic_vector(7 downto 0);
-  signal mem_a : mem_a_t;
-
-  signal a_we    : std_logic;
-  signal a_waddr : unsigned(8 downto 0);
-  signal a_wdata : std_logic_vector(7 downto 0);
-
-  signal a_raddr : unsigned(8 downto 0) := (others => '0');
-  signal a_rdata : std_logic_vector(7 downto 0);
-
-  signal full_p      : std_logic;
-  signal locked      : std_logic;
-  signal full_p_dly  : std_logic := '0';
-  signal full_p_rise : std_logic := '0';
-
-  -- NEW: clear pulse to re-arm rx_store for next upload
-  signal store_clear_p : std_logic := '0';
-
-  ---------------------------------------------------------------------------
-  -- BRAM_C (word32 dataset)
+  -- BRAM_C (word32 dataset, two halves: bank & word index)
   ---------------------------------------------------------------------------
-  type mem_c_t is array (0 to WORDS_C-1) of std_logic_vector(31 downto 0);
+  type mem_c_t is array (0 to 2*(2**DATA_AW)-1) of std_logic_vector(31 downto 0);
   signal mem_c : mem_c_t;
 
-  -- write from copy
-  signal c_we_copy    : std_logic;
-  signal c_waddr_copy : unsigned(6 downto 0);
-  signal c_wdata_copy : std_logic_vector(31 downto 0);
+  -- write from rx_word_store (into the half GNG is not reading)
+  signal c_we    : std_logic;
+  signal c_waddr : unsigned(DATA_AW downto 0);
+  signal c_wdata : std_logic_vector(31 downto 0);
 
   -- read for gng
-  signal c_raddr_gng : unsigned(6 downto 0) := (others => '0');
+  signal c_raddr_gng : unsigned(9 downto 0) := (others => '0');
   signal c_rdata_gng : std_logic_vector(31 downto 0) := (others => '0');
+  signal c_bank      : std_logic;
 
-  ---------------------------------------------------------------------------
-  -- copy flags
-  ---------------------------------------------------------------------------
-  signal copying   : std_logic;
-  signal copy_done : std_logic;
-
+  signal full_p    : std_logic;
+  signal rx_loading : std_logic;
   signal have_data : std_logic := '0';
+  signal data_take : std_logic := '0';  -- dataset used without soft reset
 
   ---------------------------------------------------------------------------
   -- GNG control
@@ -100,77 +96,17 @@ architecture rtl of tang_nano_9k is
   type sm_t is (WAIT_DATA, RUN_GNG, WAIT_GNG);
   signal sm : sm_t := WAIT_DATA;
 
-  ---------------------------------------------------------------------------
-  -- debug latch for LED
-  ---------------------------------------------------------------------------
-  signal full_rx_store : std_logic := '0';
-
-  ---------------------------------------------------------------------------
-  -- system hold (prevent overwrite while busy)
-  ---------------------------------------------------------------------------
-  signal sys_hold : std_logic;
-
 begin
 
-  -- Only hold RX store during active copy (BRAM A is being read).
-  -- GNG-busy is intentionally NOT in hold: a new dataset arriving mid-training
-  -- will trigger a soft-reset of GNG via gng_start_p, so we allow the bytes in.
-  sys_hold <= copying;
-
-  ---------------------------------------------------------------------------
-  -- Debug latch: remember full (for LED), clear when store_clear_p
-  ---------------------------------------------------------------------------
-  process(clk_i)
-  begin
-    if rising_edge(clk_i) then
-      if rstn_i = '0' then
-        full_rx_store <= '0';
-      elsif store_clear_p = '1' then
-        full_rx_store <= '0';
-      elsif full_p = '1' then
-        full_rx_store <= '1';
-      end if;
-    end if;
-  end process;
-
-  ---------------------------------------------------------------------------
-  -- full_p rising edge pulse
-  ---------------------------------------------------------------------------
-  process(clk_i)
-  begin
-    if rising_edge(clk_i) then
-      if rstn_i = '0' then
-        full_p_dly  <= '0';
-        full_p_rise <= '0';
-      else
-        full_p_rise <= full_p and (not full_p_dly); -- 1-cycle pulse
-        full_p_dly  <= full_p;
-      end if;
-    end if;
-  end process;
-
-  ---------------------------------------------------------------------------
-  -- BRAM_A (READ-FIRST)
-  ---------------------------------------------------------------------------
-  process(clk_i)
-  begin
-    if rising_edge(clk_i) then
-      a_rdata <= mem_a(to_integer(a_raddr));
-      if a_we = '1' then
-        mem_a(to_integer(a_waddr)) <= a_wdata;
-      end if;
-    end if;
-  end process;
-
   ---------------------------------------------------------------------------
   -- BRAM_C (READ-FIRST)
   ---------------------------------------------------------------------------
   process(clk_i)
   begin
     if rising_edge(clk_i) then
-      c_rdata_gng <= mem_c(to_integer(c_raddr_gng));
-      if c_we_copy = '1' then
-        mem_c(to_integer(c_waddr_copy)) <= c_wdata_copy;
+      c_rdata_gng <= mem_c(to_integer(c_bank & c_raddr_gng(DATA_AW-1 downto 0)));
+      if c_we = '1' then
+        mem_c(to_integer(c_waddr)) <= c_wdata;
       end if;
     end if;
   end process;
@@ -194,69 +130,26 @@ begin
     );
 
   ---------------------------------------------------------------------------
-  -- RX STORE (BRAM_A)
-  -- NOTE: hold while sys_hold, clear pulse after copy_done so can accept next dataset
+  -- RX -> 32-bit words straight into BRAM_C (ping-pong halves)
+  -- a dataset streams into one half while GNG reads the other
   ---------------------------------------------------------------------------
-  u_store : entity work.rx_store_ext
-    generic map ( DEPTH => DEPTH_BYTES )
+  u_store : entity work.rx_word_store
+    generic map ( WORDS => WORDS_C, AW => DATA_AW )
     port map (
       clk_i        => clk_i,
       rstn_i       => rstn_i,
       rx_valid_i   => rx_valid,
       rx_data_i    => rx_data,
-      hold_i       => sys_hold,
-      clear_i      => store_clear_p,
-      full_o       => full_p,
-
-      mem_we_o     => a_we,
-      mem_waddr_o  => a_waddr,
-      mem_wdata_o  => a_wdata,
-
-      mem_raddr_i  => a_raddr,
-      mem_rdata_i  => a_rdata,
-
-      rdata_o      => open,
-      locked_o     => locked
-    );
 
-  ---------------------------------------------------------------------------
-  -- COPY 8->32 (A -> C)
-  ---------------------------------------------------------------------------
-  u_copy_8to32 : entity work.bram_copy_8to32
-    generic map ( DEPTH_BYTES => DEPTH_BYTES )
-    port map (
-      clk_i     => clk_i,
-      rstn_i    => rstn_i,
-      start_i   => full_p_rise,  -- pulse, not level
-
-      a_raddr_o => a_raddr,
-      a_rdata_i => a_rdata,
-
-      c_we_o    => c_we_copy,
-      c_waddr_o => c_waddr_copy,
-      c_wdata_o => c_wdata_copy,
+      full_o       => full_p,
+      bank_o       => c_bank,
+      busy_o       => rx_loading,
 
-      done_o    => copy_done,
-      busy_o    => copying
+      mem_we_o     => c_we,
+      mem_waddr_o  => c_waddr,
+      mem_wdata_o  => c_wdata
     );
 
-  ---------------------------------------------------------------------------
-  -- store_clear_p: 1-cycle pulse after copy_done to re-arm RX store for next upload
-  ---------------------------------------------------------------------------
-  process(clk_i)
-  begin
-    if rising_edge(clk_i) then
-      if rstn_i = '0' then
-        store_clear_p <= '0';
-      else
-        store_clear_p <= '0';
-        if copy_done = '1' then
-          store_clear_p <= '1';
-        end if;
-      end if;
-    end if;
-  end process;
-
   ---------------------------------------------------------------------------
   -- have_data latch
   ---------------------------------------------------------------------------
@@ -266,10 +159,10 @@ begin
       if rstn_i='0' then
         have_data <= '0';
       else
-        if copy_done='1' then
+        if full_p='1' then
           have_data <= '1';
         end if;
-        if gng_start_p='1' then
+        if gng_start_p='1' or data_take='1' then
           have_data <= '0';
         end if;
       end if;
@@ -291,10 +184,14 @@ begin
         gng_start_p <= '0';
       else
         gng_start_p <= '0';
+        data_take   <= '0';
 
         case sm is
           when WAIT_DATA =>
-            if have_data='1' then
+            if have_data='1' and gng_busy='1' and not DATA_SWAP_RESET then
+              -- bank already switched: GNG goes on with the new samples
+              data_take <= '1';
+            elsif have_data='1' then
               sm <= RUN_GNG;
             end if;
 
@@ -308,7 +205,7 @@ begin
 
           when WAIT_GNG =>
             -- New dataset arrived while GNG running: soft-reset GNG
-            if have_data='1' then
+            if have_data='1' and DATA_SWAP_RESET then
               gng_start_p <= '1';  -- triggers soft-reset via start_i
             elsif gng_done_p='1' then
               sm <= WAIT_DATA;
@@ -330,7 +227,15 @@ begin
       MAX_NODES  => GNG_MAX_NODES,
       DATA_WORDS => WORDS_C,
       INIT_X0    => -500, INIT_Y0 =>  500,
-      INIT_X1    =>  500, INIT_Y1 => -500
+      INIT_X1    =>  500, INIT_Y1 => -500,
+      SNAP_EVERY  => PRESET_SNAP_EVERY,
+      SNAP_SHADOW => PRESET_SNAP_SHADOW,
+      PIPE_WIN    => PRESET_PIPE_WIN,
+      DBG_EVERY   => PRESET_DBG_EVERY,
+      DBG_RING    => PRESET_DBG_RING,
+      A_MAX       => LAYOUT_A_MAX,
+      POS_W       => LAYOUT_POS_W,
+      ERR_W       => LAYOUT_ERR_W
     )
     port map (
       clk_i   => clk_i,
@@ -375,16 +280,16 @@ begin
   ---------------------------------------------------------------------------
   -- LEDs active-low
   -- 0: UART TX busy (byte-level activity)
-  -- 1: copying
-  -- 2: locked (rx_store)
-  -- 3: full_rx_store latch
+  -- 1: dataset bank GNG reads
+  -- 2: dataset upload in progress
+  -- 3: have_data (dataset waiting for the scheduler)
   -- 4: gng_busy (incl dump)
   ---------------------------------------------------------------------------
   gpio_o <= (
     0      => std_ulogic(not tx_busy),
-    1      => std_ulogic(not copying),
-    2      => std_ulogic(not locked),
-    3      => std_ulogic(not full_rx_store),
+    1      => std_ulogic(not c_bank),
+    2      => std_ulogic(not rx_loading),
+    3      => std_ulogic(not have_data),
     4      => std_ulogic(not gng_busy),
     5      => '1',
     others => '1'
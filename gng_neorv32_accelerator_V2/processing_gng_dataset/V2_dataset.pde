@@ -2,9 +2,12 @@
 // GNG Viewer (Processing) : A5 RX (DBG + NODE/EDGE) + Two-Moons TX
 // - RX expects:
 //    A5 10 : DBG fixed 46 bytes (with markers)
-//    A5 20 : NODE_SNAPSHOT fixed: 4 + MAX_NODES*7 bytes
+//    A5 20 : NODE_SNAPSHOT: 4 + N*7 bytes, N = header byte 2 (gng MAX_NODES)
 //    A5 21 : EDGE_SNAPSHOT variable: 4 + cnt*3 bytes
+//    A5 22 : EDGE_BITMAP: 4 + nbytes, bit k = edge (i<j, row-major), no ages
 // - TX sends dataset as raw points: [xi_lo xi_hi yi_lo yi_hi] * MOONS_N
+// - serialEvent() parses and logs on the serial thread; draw() renders the
+//   latest published GraphView from retained shapes and never reads the port
 //
 // IMPORTANT: dataset generator here matches your "paper style" version:
 //   second moon uses: y = -sin(t) + 0.5   (NOT -0.5)
@@ -28,9 +31,12 @@ final int WIN_H = 1000;
 final int DBG_H = 140;
 
 // -------------------------------
-// GNG limits (MUST MATCH FPGA/VHDL)
+// GNG limits
 // -------------------------------
-final int MAX_NODES = 40;
+// array capacity; the real node count (gng MAX_NODES, up to 255) comes with
+// every A5 20 header and also sets the A5 22 bitmap layout
+final int MAX_NODES = 255;
+int snapN = 40;
 
 // VHDL node coordinate scale (0..1000 typical)
 final float NODE_SCALE = 1000.0;
@@ -72,8 +78,15 @@ float[][] dataTx;
 int[] dataLabel = new int[MOONS_N]; // 0 = moon A (blue), 1 = moon B (yellow)
 
 // -------------------------------
-// CSV logging
+// Logging: binary run log (gng_host/gngio/runlog.py) and/or CSV
 // -------------------------------
+final boolean LOG_BIN = true;   // dataset_/gng_dbg_/gng_nodes_/gng_edges_/gng_snap_<ts>.bin
+final boolean LOG_CSV = false;  // the older CSV set (same names, .csv)
+
+BinLog binDataset, binDbg, binNodes, binEdges, binSnap;
+int binNodeOff = 0, binNodeN = 0; // node records of the pending snapshot
+int binT0 = 0;                    // millis() at log start
+
 PrintWriter csvDataset;
 PrintWriter csvDbg;
 PrintWriter csvNodes;
@@ -85,6 +98,37 @@ int csvSnapIdx = 0;
 // -------------------------------
 byte[] rx = new byte[1 << 16];
 int rxLen = 0;
+byte[] rxChunk = new byte[1 << 14];
+
+// rx[], the parsed state below and the log writers belong to the serial
+// thread; the draw thread takes rxLock only to reset them (dataset send, Q)
+final Object rxLock = new Object();
+
+// -------------------------------
+// Parser -> draw handoff
+// -------------------------------
+// Immutable copy of one complete graph, published through a volatile field
+// after each serial read that changed it; draw() keeps the reference it read
+// for the whole frame and never waits on the parser.
+static class GraphView {
+  int seq;
+  float[] x, y;       // node coordinates (NODE_SCALE units)
+  boolean[] act;
+  int[] deg;          // degree reported in the node snapshot
+  int[] degE;         // degree counted from the edge snapshot
+  Edge[] edges;       // stored edges only
+  int actN, isoByEdges, isoByNodeDeg;
+  int nodesSeen, edgesSeen;
+  GraphView(int n) {
+    x = new float[n]; y = new float[n]; act = new boolean[n];
+    deg = new int[n]; degE = new int[n]; edges = new Edge[0];
+  }
+}
+volatile GraphView graphView = new GraphView(MAX_NODES);
+volatile String dbgLine = "A5 DBG: -";
+int graphSeq = 0;
+boolean graphDirty = false;  // serial thread: an edge frame (end of a snapshot) since the last publish
+boolean dbgDirty = false;
 
 // -------------------------------
 // Parsed DBG state (from A5 10 frame)
@@ -141,18 +185,23 @@ int snapEdgesSeen = 0;
 // -------------------------------
 boolean hideIsolated = true;        // press 'I' to toggle
 boolean showMismatchPrint = true;    // press 'M' to toggle
+PFont uiFont;
 
 // ======================================================
 // Setup / Draw
 // ======================================================
+void settings() {
+  // P2D: edges / nodes are retained PShapes, redrawn from GPU buffers
+  size(WIN_W, WIN_H, P2D);
+  smooth(4);
+}
+
 void setup() {
-  // IMPORTANT: do NOT call size()
-  surface.setSize(WIN_W, WIN_H);
   surface.setTitle("GNG on Two-Moons (A5 RX)");
 
   frameRate(60);
-  smooth(4);
-  textFont(createFont("Consolas", 13));
+  uiFont = createFont("Consolas", 13);
+  textFont(uiFont);
 
   // Build dataset (MATCH paper style) and pack to txBuf
   buildTwoMoonsAndPack();
@@ -176,22 +225,28 @@ void setup() {
 
 void draw() {
   background(255);
-
-  // read serial bytes
-  if (myPort != null) {
-    while (myPort.available() > 0) {
-      int b = myPort.read();
-      if (b < 0) break;
-      if (rxLen < rx.length) rx[rxLen++] = (byte)b;
-    }
-    parseRx();
-  }
+  GraphView v = graphView;  // one snapshot for the whole frame
 
   // plot (upper area)
-  renderPlot(g, 0, 0, width, height - DBG_H, true);
+  renderPlot(g, 0, 0, width, height - DBG_H, true, v);
 
   // debug bar bottom
-  drawDebugPanel();
+  drawDebugPanel(v);
+}
+
+// serial thread: append what arrived, parse whole frames, publish
+void serialEvent(Serial p) {
+  synchronized (rxLock) {
+    int n = p.readBytes(rxChunk);
+    n = min(n, rx.length - rxLen);  // full buffer: drop, the parser resyncs on A5
+    if (n > 0) {
+      arrayCopy(rxChunk, 0, rx, rxLen, n);
+      rxLen += n;
+    }
+    parseRx();
+    if (graphDirty) publishGraph();
+    if (dbgDirty) publishDbg();
+  }
 }
 
 // ======================================================
@@ -202,28 +257,32 @@ void keyPressed() {
   if (key=='s' || key=='S') { sendDatasetOnce(); }
   if (key=='i' || key=='I') { hideIsolated = !hideIsolated; println("hideIsolated=" + hideIsolated); }
   if (key=='m' || key=='M') { showMismatchPrint = !showMismatchPrint; println("showMismatchPrint=" + showMismatchPrint); }
-  if (key=='q' || key=='Q') { closeCSV(); println("CSV files closed/flushed."); }
+  if (key=='q' || key=='Q') { synchronized (rxLock) { closeLogs(); } println("Log files closed/flushed."); }
   if (key=='1') { DATASET_MODE = 0; buildDatasetAndPack(); sendDatasetOnce(); }
   if (key=='2') { DATASET_MODE = 1; buildDatasetAndPack(); sendDatasetOnce(); }
 }
 
 void sendDatasetOnce() {
-  // Fresh CSV for every dataset send.
-  // Snapshot data from before this send (old GNG state) will NOT appear in the new files.
-  closeCSV();
-  setupCSV();
-  csvSnapIdx = 0;
-  writeDatasetCSV();
-
-  if (myPort != null) {
-    dbg_fpga_ts_prev = -1; // reset delta so first iter_us is not garbage
-    myPort.write(txBuf);
-    // Wait for all 400 bytes to be transmitted (at 1Mbaud: ~4ms) plus FPGA INIT time.
-    // Then flush any stale snapshot bytes that arrived before the soft-reset.
-    delay(50);
-    myPort.clear();
-    rxLen = 0;
-    println("RX buffer flushed after dataset send.");
+  // held across the send: the serial thread must not log old-state frames
+  // into the new set or parse bytes that are about to be flushed
+  synchronized (rxLock) {
+    // Fresh log set for every dataset send.
+    // Snapshot data from before this send (old GNG state) will NOT appear in the new files.
+    closeLogs();
+    setupLogs();
+    csvSnapIdx = 0;
+    writeDatasetLog();
+
+    if (myPort != null) {
+      dbg_fpga_ts_prev = -1; // reset delta so first iter_us is not garbage
+      myPort.write(txBuf);
+      // Wait for all 400 bytes to be transmitted (at 1Mbaud: ~4ms) plus FPGA INIT time.
+      // Then flush any stale snapshot bytes that arrived before the soft-reset.
+      delay(50);
+      myPort.clear();
+      rxLen = 0;
+      println("RX buffer flushed after dataset send.");
+    }
   }
 }
 
@@ -255,6 +314,7 @@ void buildDatasetAndPack() {
     txBuf[p++] = (byte)(yi & 0xFF);
     txBuf[p++] = (byte)((yi>>8)&0xFF);
   }
+  datasetSeq++;
 }
 
 void buildTwoMoonsAndPack() {
@@ -394,7 +454,8 @@ float[][] generateCircles(int N, float factor, float noiseStd, int seed,
 // ======================================================
 // Plot rendering (paper style)
 // ======================================================
-void renderPlot(PGraphics gg, int x0, int y0, int w, int h, boolean title) {
+// square plot area of a w x h region: {sx0, sy0, side}
+int[] plotSquare(int x0, int y0, int w, int h, boolean title) {
   int marginL = 85;
   int marginR = 30;
   int marginT = title ? 60 : 30;
@@ -407,10 +468,46 @@ void renderPlot(PGraphics gg, int x0, int y0, int w, int h, boolean title) {
 
   // force square
   int side = min(pw, ph);
-  int sx0  = px0 + (pw - side)/2;
-  int sy0  = py0 + (ph - side)/2;
-  int sw   = side;
-  int sh   = side;
+  return new int[] { px0 + (pw - side)/2, py0 + (ph - side)/2, side };
+}
+
+// Static parts (frame, grid, labels, dataset, legend) live in plotBg, redrawn
+// only when the dataset changes; edges and nodes are one retained PShape,
+// rebuilt only for a new GraphView or a hideIsolated toggle.
+PGraphics plotBg;
+int plotBgSeq = -1;
+int datasetSeq = 0;        // bumped by buildDatasetAndPack()
+PShape graphShape;
+int graphShapeSeq = -1;
+boolean graphShapeHide;
+
+void renderPlot(PGraphics gg, int x0, int y0, int w, int h, boolean title, GraphView v) {
+  if (plotBg == null || plotBgSeq != datasetSeq || plotBg.width != w || plotBg.height != h) {
+    if (plotBg == null || plotBg.width != w || plotBg.height != h) plotBg = createGraphics(w, h, P2D);
+    plotBg.beginDraw();
+    plotBg.background(255);
+    plotBg.textFont(uiFont);
+    renderPlotStatic(plotBg, 0, 0, w, h, title);
+    plotBg.endDraw();
+    plotBgSeq = datasetSeq;
+  }
+  gg.image(plotBg, x0, y0);
+
+  if (graphShape == null || graphShapeSeq != v.seq || graphShapeHide != hideIsolated) {
+    int[] sq = plotSquare(x0, y0, w, h, title);
+    graphShape = buildGraphShape(v, sq[0], sq[1], sq[2], sq[2]);
+    graphShapeSeq = v.seq;
+    graphShapeHide = hideIsolated;
+  }
+  gg.shape(graphShape);
+}
+
+void renderPlotStatic(PGraphics gg, int x0, int y0, int w, int h, boolean title) {
+  int[] sq = plotSquare(x0, y0, w, h, title);
+  int sx0 = sq[0];
+  int sy0 = sq[1];
+  int sw  = sq[2];
+  int sh  = sq[2];
 
   gg.pushStyle();
 
@@ -480,44 +577,53 @@ void renderPlot(PGraphics gg, int x0, int y0, int w, int h, boolean title) {
     gg.rect(x-2, y-2, 4, 4);
   }
 
-  // edges
-  gg.strokeWeight(2);
-  for (Edge e : edges) {
-    if (e.ageStored == 0) continue;
+  // legend
+  drawLegend(gg, sx0, sy0, sw, sh);
+
+  gg.popStyle();
+}
+
+PShape buildGraphShape(GraphView v, int sx0, int sy0, int sw, int sh) {
+  PShape grp = createShape(GROUP);
+
+  // edges, alpha by age
+  PShape es = createShape();
+  es.beginShape(LINES);
+  es.noFill();
+  es.strokeWeight(2);
+  for (Edge e : v.edges) {
     if (e.a < 0 || e.a >= MAX_NODES || e.b < 0 || e.b >= MAX_NODES) continue;
-    if (!nodeAct[e.a] || !nodeAct[e.b]) continue;
+    if (!v.act[e.a] || !v.act[e.b]) continue;
 
     int age = max(0, e.ageStored - 1);
     float alpha = map(constrain(age, 0, A_MAX), 0, A_MAX, 220, 40);
-    gg.stroke(110, alpha);
-
-    float x1 = mapN11x(nodeX[e.a]/NODE_SCALE, sx0, sw);
-    float y1 = mapN11y(nodeY[e.a]/NODE_SCALE, sy0, sh);
-    float x2 = mapN11x(nodeX[e.b]/NODE_SCALE, sx0, sw);
-    float y2 = mapN11y(nodeY[e.b]/NODE_SCALE, sy0, sh);
-    gg.line(x1,y1,x2,y2);
+    es.stroke(110, alpha);
+    es.vertex(mapN11x(v.x[e.a]/NODE_SCALE, sx0, sw), mapN11y(v.y[e.a]/NODE_SCALE, sy0, sh));
+    es.vertex(mapN11x(v.x[e.b]/NODE_SCALE, sx0, sw), mapN11y(v.y[e.b]/NODE_SCALE, sy0, sh));
   }
+  es.endShape();
+  grp.addChild(es);
 
   // nodes (red X) + (optional) hide isolated (from edge list)
-  gg.stroke(220, 0, 0);
-  gg.strokeWeight(3);
+  PShape ns = createShape();
+  ns.beginShape(LINES);
+  ns.noFill();
+  ns.stroke(220, 0, 0);
+  ns.strokeWeight(3);
   for (int i=0;i<MAX_NODES;i++) {
-    if (!nodeAct[i]) continue;
-
-    int dEdge = degFromEdges(i);
-    if (hideIsolated && dEdge == 0) continue;
+    if (!v.act[i]) continue;
+    if (hideIsolated && v.degE[i] == 0) continue;
 
-    float x = mapN11x(nodeX[i]/NODE_SCALE, sx0, sw);
-    float y = mapN11y(nodeY[i]/NODE_SCALE, sy0, sh);
+    float x = mapN11x(v.x[i]/NODE_SCALE, sx0, sw);
+    float y = mapN11y(v.y[i]/NODE_SCALE, sy0, sh);
     float r = 8;
-    gg.line(x-r, y-r, x+r, y+r);
-    gg.line(x-r, y+r, x+r, y-r);
+    ns.vertex(x-r, y-r); ns.vertex(x+r, y+r);
+    ns.vertex(x-r, y+r); ns.vertex(x+r, y-r);
   }
+  ns.endShape();
+  grp.addChild(ns);
 
-  // legend
-  drawLegend(gg, sx0, sy0, sw, sh);
-
-  gg.popStyle();
+  return grp;
 }
 
 void drawLegend(PGraphics gg, int sx0, int sy0, int sw, int sh) {
@@ -582,79 +688,86 @@ float mapN11y(float v, int py0, int ph) {
 // ======================================================
 // Debug panel + mismatch detector
 // ======================================================
-void drawDebugPanel() {
+void drawDebugPanel(GraphView v) {
   int y0 = height - DBG_H;
 
   fill(0, 160);
   noStroke();
   rect(0, y0, width, DBG_H);
 
-  // counts
-  int actN = 0;
-  for (int i=0;i<MAX_NODES;i++) if (nodeAct[i]) actN++;
-
-  int isoByEdges = 0;
-  int isoByNodeDeg = 0;
-  for (int i=0;i<MAX_NODES;i++){
-    if(!nodeAct[i]) continue;
-    if(degFromEdges(i) == 0) isoByEdges++;
-    if(nodeDeg[i] == 0) isoByNodeDeg++;
-  }
-
-  // mismatch prints (optional)
-  if (showMismatchPrint) {
-    for (int i=0;i<MAX_NODES;i++){
-      if(!nodeAct[i]) continue;
-      int dE = degFromEdges(i);
-      int dN = nodeDeg[i];
-      // "mismatch" heuristics: nodeDeg says connected but edges snapshot says 0, or vice versa
-      if ((dE==0 && dN>0) || (dE>0 && dN==0)) {
-        println("DEG MISMATCH node=" + i + "  nodeDeg=" + dN + "  degFromEdges=" + dE +
-                "  (snapNodes=" + snapNodesSeen + " snapEdges=" + snapEdgesSeen + ")");
-      }
-    }
-  }
-
   fill(255);
   textSize(13);
   textAlign(LEFT, TOP);
 
-  String s1 =
-    "A5 DBG: s1=" + dbg_s1 + " s2=" + dbg_s2 +
-    " deg=(" + dbg_deg_s1 + "," + dbg_deg_s2 + ")" +
-    " conn=" + (dbg_conn?"Y":"N") +
-    " rm=" + (dbg_rm?1:0) +
-    " iso=" + (dbg_iso?1:0) + "(id=" + dbg_iso_id + ")" +
-    " nodes=" + dbg_node_count +
-    " ins=" + (dbg_ins?1:0) + "(id=" + dbg_ins_id + ")" +
-    " err32=" + dbg_err32 +
-    " samp=" + dbg_sample +
-    "  |  FPGA: elapsed=" + fpgaFmtTime(dbg_fpga_ts) + "  iter=" + fpgaFmtIter(dbg_iter_us);
-
   String s2 =
-    "SNAP: active=" + actN +
-    " edges=" + edges.size() +
-    " iso(nodeDeg)=" + isoByNodeDeg +
-    " iso(edges)=" + isoByEdges +
-    " | snapNodesSeen=" + snapNodesSeen +
-    " snapEdgesSeen=" + snapEdgesSeen +
+    "SNAP: active=" + v.actN +
+    " edges=" + v.edges.length +
+    " iso(nodeDeg)=" + v.isoByNodeDeg +
+    " iso(edges)=" + v.isoByEdges +
+    " | snapNodesSeen=" + v.nodesSeen +
+    " snapEdgesSeen=" + v.edgesSeen +
     " | hideIsolated=" + hideIsolated + " (toggle I)";
 
-  text(s1, 12, y0 + 12);
+  text(dbgLine, 12, y0 + 12);
   text(s2, 12, y0 + 34);
   text("Keys: [R]=rebuild+send dataset  [S]=send dataset  [I]=hide isolated(by edges)  [M]=toggle mismatch print",
        12, y0 + 58);
 }
 
-// degree computed from current edges snapshot
-int degFromEdges(int id) {
-  int d = 0;
+// ======================================================
+// Publish (serial thread, under rxLock)
+// ======================================================
+// copy the working snapshot into a fresh GraphView; counts and edge degrees
+// are computed here once per snapshot instead of on every frame
+void publishGraph() {
+  GraphView v = new GraphView(MAX_NODES);
+  arrayCopy(nodeX, v.x);
+  arrayCopy(nodeY, v.y);
+  arrayCopy(nodeAct, v.act);
+  arrayCopy(nodeDeg, v.deg);
+
+  ArrayList<Edge> stored = new ArrayList<Edge>(edges.size());
   for (Edge e : edges) {
     if (e.ageStored == 0) continue;
-    if (e.a == id) d++;
-    else if (e.b == id) d++;
+    stored.add(e);  // parsers allocate fresh Edges, never mutated after
+    if (e.a >= 0 && e.a < MAX_NODES) v.degE[e.a]++;
+    if (e.b >= 0 && e.b < MAX_NODES) v.degE[e.b]++;
   }
-  return d;
+  v.edges = stored.toArray(new Edge[0]);
+
+  for (int i=0;i<MAX_NODES;i++) {
+    if (!v.act[i]) continue;
+    v.actN++;
+    if (v.degE[i] == 0) v.isoByEdges++;
+    if (v.deg[i] == 0) v.isoByNodeDeg++;
+    // "mismatch" heuristics: nodeDeg says connected but edges snapshot says 0, or vice versa
+    if (showMismatchPrint && ((v.degE[i]==0 && v.deg[i]>0) || (v.degE[i]>0 && v.deg[i]==0))) {
+      println("DEG MISMATCH node=" + i + "  nodeDeg=" + v.deg[i] + "  degFromEdges=" + v.degE[i] +
+              "  (snapNodes=" + snapNodesSeen + " snapEdges=" + snapEdgesSeen + ")");
+    }
+  }
+  v.nodesSeen = snapNodesSeen;
+  v.edgesSeen = snapEdgesSeen;
+  v.seq = ++graphSeq;
+
+  graphView = v;
+  graphDirty = false;
+}
+
+// latest DBG frame of the read, as the panel line
+void publishDbg() {
+  dbgLine =
+    "A5 DBG: s1=" + dbg_s1 + " s2=" + dbg_s2 +
+    " deg=(" + dbg_deg_s1 + "," + dbg_deg_s2 + ")" +
+    " conn=" + (dbg_conn?"Y":"N") +
+    " rm=" + (dbg_rm?1:0) +
+    " iso=" + (dbg_iso?1:0) + "(id=" + dbg_iso_id + ")" +
+    " nodes=" + dbg_node_count +
+    " ins=" + (dbg_ins?1:0) + "(id=" + dbg_ins_id + ")" +
+    " err32=" + dbg_err32 +
+    " samp=" + dbg_sample +
+    "  |  FPGA: elapsed=" + fpgaFmtTime(dbg_fpga_ts) + "  iter=" + fpgaFmtIter(dbg_iter_us);
+  dbgDirty = false;
 }
 
 // ======================================================
@@ -730,6 +843,7 @@ void parseDbgFrame(byte[] b, int off) {
   dbg_fpga_ts      = ts;
 
   dbg_sample = u8(b[off+53]); // moved from [45] to [53]
+  dbgDirty = true;
 }
 
 void parseNodeSnap(byte[] b, int off) {
@@ -742,7 +856,7 @@ void parseNodeSnap(byte[] b, int off) {
   }
 
   int p = off + 4;
-  for (int k=0; k<MAX_NODES; k++) {
+  for (int k=0; k<snapN; k++) {
     int id  = u8(b[p+0]);
     int act = u8(b[p+1]);
     int deg = u8(b[p+2]);
@@ -771,6 +885,21 @@ void parseEdgeSnap(byte[] b, int off, int cnt) {
     p += 3;
   }
   snapEdgesSeen++;
+  graphDirty = true;
+}
+
+// bitmap edges carry no age: stored as ageStored=1 (age 0)
+void parseEdgeBitmap(byte[] b, int off, int nbytes) {
+  edges.clear();
+  int k = 0;
+  for (int i = 0; i < snapN - 1; i++) {
+    for (int j = i + 1; j < snapN; j++, k++) {
+      if ((k >> 3) >= nbytes) break;
+      if (((u8(b[off + 4 + (k >> 3)]) >> (k & 7)) & 1) != 0) edges.add(new Edge(i, j, 1));
+    }
+  }
+  snapEdgesSeen++;
+  graphDirty = true;
 }
 
 void parseRx() {
@@ -785,14 +914,18 @@ void parseRx() {
       if (i + frameLen > rxLen) break;
       if (!checkDbgFixed(rx, i)) { i++; continue; }
       parseDbgFrame(rx, i);
-      writeDbgCSV();
+      writeDbgLog();
       i += frameLen;
 
     } else if (type == 0x20) {
-      int frameLen = 4 + MAX_NODES * 7;
+      if (i + 4 > rxLen) break;
+      int n = u8(rx[i+2]);
+      if (n < 2) { i++; continue; }
+      int frameLen = 4 + n * 7;
       if (i + frameLen > rxLen) break;
+      snapN = n;
       parseNodeSnap(rx, i);
-      writeNodeSnapCSV();
+      writeNodeSnapLog();
       i += frameLen;
 
     } else if (type == 0x21) {
@@ -801,7 +934,16 @@ void parseRx() {
       int frameLen = 4 + cnt * 3;
       if (i + frameLen > rxLen) break;
       parseEdgeSnap(rx, i, cnt);
-      writeEdgeSnapCSV();
+      writeEdgeSnapLog();
+      i += frameLen;
+
+    } else if (type == 0x22) {
+      if (i + 4 > rxLen) break;
+      int nbytes = u8(rx[i+2]) | (u8(rx[i+3]) << 8);
+      int frameLen = 4 + nbytes;
+      if (i + frameLen > rxLen) break;
+      parseEdgeBitmap(rx, i, nbytes);
+      writeEdgeSnapLog();
       i += frameLen;
 
     } else {
@@ -855,11 +997,7 @@ String csvNow() {
     year(), month(), day(), hour(), minute(), second(), millis() % 1000);
 }
 
-void setupCSV() {
-  // Ensure logs/ directory exists
-  new java.io.File(sketchPath("logs")).mkdirs();
-
-  String ts = csvTimestamp();
+void setupCSV(String ts) {
   csvDataset = createWriter(sketchPath("logs/dataset_"   + ts + ".csv"));
   csvDbg     = createWriter(sketchPath("logs/gng_dbg_"   + ts + ".csv"));
   csvNodes   = createWriter(sketchPath("logs/gng_nodes_" + ts + ".csv"));
@@ -870,13 +1008,6 @@ void setupCSV() {
   csvNodes.println("timestamp,snap_idx,node_id,active,degree,x_int,y_int,x_norm,y_norm,fpga_ts_cycles");
   csvEdges.println("timestamp,snap_idx,node_a,node_b,age_stored,true_age");
 
-  // Save dataset name metadata for replay
-  String dsName = (DATASET_MODE == 1) ? "Concentric Circles" : "Two Moons";
-  PrintWriter meta = createWriter(sketchPath("logs/meta_" + ts + ".txt"));
-  meta.println(dsName);
-  meta.flush();
-  meta.close();
-
   println("CSV logging started: logs/*_" + ts + ".csv");
 }
 
@@ -938,3 +1069,148 @@ void closeCSV() {
   if (csvNodes   != null) { csvNodes.flush();   csvNodes.close();   csvNodes = null;   }
   if (csvEdges   != null) { csvEdges.flush();   csvEdges.close();   csvEdges = null;   }
 }
+
+// ======================================================
+// Log set (binary and/or CSV, one per dataset send)
+// ======================================================
+void setupLogs() {
+  // Ensure logs/ directory exists
+  new java.io.File(sketchPath("logs")).mkdirs();
+
+  String ts = csvTimestamp();
+  if (LOG_BIN) setupBinLog(ts);
+  if (LOG_CSV) setupCSV(ts);
+
+  // Save dataset name metadata for replay
+  String dsName = (DATASET_MODE == 1) ? "Concentric Circles" : "Two Moons";
+  PrintWriter meta = createWriter(sketchPath("logs/meta_" + ts + ".txt"));
+  meta.println(dsName);
+  meta.flush();
+  meta.close();
+}
+
+void writeDatasetLog()  { writeDatasetBin();  writeDatasetCSV(); }
+void writeDbgLog()      { writeDbgBin();      writeDbgCSV(); }
+void writeNodeSnapLog() { writeNodeSnapBin(); writeNodeSnapCSV(); }
+// the CSV writer advances csvSnapIdx, so the binary index record goes first
+void writeEdgeSnapLog() { writeEdgeSnapBin(); writeEdgeSnapCSV(); }
+
+void closeLogs() {
+  closeBinLog();
+  closeCSV();
+}
+
+// ======================================================
+// Binary run log: fixed records behind a 16-byte header
+//   b"GNGB" u16 version u16 record size u32 unix start 4s kind
+// layouts: DSET/DBG/NODE/EDGE/SNAP_DTYPE in gng_host/gngio/runlog.py
+// ======================================================
+class BinLog {
+  java.io.OutputStream out;
+  java.nio.ByteBuffer rec;
+  int count = 0;
+
+  BinLog(String path, String kind, int recSize) {
+    out = createOutput(path);   // buffered
+    java.nio.ByteBuffer h = java.nio.ByteBuffer.allocate(16).order(java.nio.ByteOrder.LITTLE_ENDIAN);
+    h.put((byte)'G').put((byte)'N').put((byte)'G').put((byte)'B');
+    h.putShort((short)1).putShort((short)recSize);
+    h.putInt((int)(System.currentTimeMillis() / 1000L));
+    for (int k = 0; k < 4; k++) h.put((byte)kind.charAt(k));
+    rec = java.nio.ByteBuffer.allocate(recSize).order(java.nio.ByteOrder.LITTLE_ENDIAN);
+    write(h.array());
+  }
+
+  java.nio.ByteBuffer begin() { rec.clear(); java.util.Arrays.fill(rec.array(), (byte)0); return rec; }
+  void end() { write(rec.array()); count++; }
+
+  void write(byte[] b) {
+    try { out.write(b); } catch (java.io.IOException e) { println("log write failed: " + e); }
+  }
+  void flush() {
+    try { out.flush(); } catch (java.io.IOException e) { }
+  }
+  void close() {
+    try { out.flush(); out.close(); } catch (java.io.IOException e) { }
+  }
+}
+
+void setupBinLog(String ts) {
+  binDataset = new BinLog(sketchPath("logs/dataset_"   + ts + ".bin"), "dset", 16);
+  binDbg     = new BinLog(sketchPath("logs/gng_dbg_"   + ts + ".bin"), "dbg ", 32);
+  binNodes   = new BinLog(sketchPath("logs/gng_nodes_" + ts + ".bin"), "node", 8);
+  binEdges   = new BinLog(sketchPath("logs/gng_edges_" + ts + ".bin"), "edge", 4);
+  binSnap    = new BinLog(sketchPath("logs/gng_snap_"  + ts + ".bin"), "snap", 32);
+  binNodeOff = 0;
+  binNodeN   = 0;
+  binT0      = millis();
+  println("Binary logging started: logs/*_" + ts + ".bin");
+}
+
+void writeDatasetBin() {
+  if (binDataset == null) return;
+  for (int i = 0; i < MOONS_N; i++) {
+    java.nio.ByteBuffer r = binDataset.begin();
+    r.putFloat(dataTx[i][0]).putFloat(dataTx[i][1]);
+    r.putShort((short)round(dataTx[i][0] * SCALE)).putShort((short)round(dataTx[i][1] * SCALE));
+    r.put((byte)dataLabel[i]);
+    binDataset.end();
+  }
+  binDataset.flush();
+}
+
+void writeDbgBin() {
+  if (binDbg == null) return;
+  int flags = (dbg_conn?1:0) | (dbg_rm?2:0) | (dbg_iso?4:0) | (dbg_ins?8:0);
+  java.nio.ByteBuffer r = binDbg.begin();
+  r.put((byte)dbg_sample).put((byte)dbg_s1).put((byte)dbg_s2);
+  r.put((byte)dbg_deg_s1).put((byte)dbg_deg_s2).put((byte)dbg_node_count);
+  r.put((byte)flags).put((byte)dbg_iso_id).put((byte)dbg_ins_id);
+  r.position(12);
+  r.putInt((int)dbg_err32).putShort((short)dbg_s1x_raw).putShort((short)dbg_s1y_raw);
+  r.putInt((int)dbg_fpga_ts).putInt(millis() - binT0).putFloat(dbg_iter_us);
+  binDbg.end();
+}
+
+// nodes 0..snapN-1 of the last A5 20; the index record follows with the edges
+void writeNodeSnapBin() {
+  if (binNodes == null) return;
+  binNodeOff = binNodes.count;
+  for (int i = 0; i < snapN; i++) {
+    java.nio.ByteBuffer r = binNodes.begin();
+    r.put((byte)i).put((byte)(nodeAct[i]?1:0)).put((byte)nodeDeg[i]).put((byte)0);
+    r.putShort((short)nodeX[i]).putShort((short)nodeY[i]);
+    binNodes.end();
+  }
+  binNodeN = snapN;
+}
+
+void writeEdgeSnapBin() {
+  if (binEdges == null) return;
+  int off = binEdges.count;
+  for (Edge e : edges) {
+    if (e.ageStored == 0) continue;
+    java.nio.ByteBuffer r = binEdges.begin();
+    r.put((byte)e.a).put((byte)e.b).put((byte)e.ageStored);
+    binEdges.end();
+  }
+  binNodes.flush();
+  binEdges.flush();
+  // index record last: a reader never sees a snapshot whose records are missing
+  java.nio.ByteBuffer r = binSnap.begin();
+  r.putInt(csvSnapIdx).putInt(binNodeOff).putInt(off);
+  r.putShort((short)binNodeN).putShort((short)(binEdges.count - off));
+  r.putInt((int)dbg_fpga_ts).putInt(binDbg.count).putInt(millis() - binT0);
+  binSnap.end();
+  binSnap.flush();
+  binDbg.flush();
+  if (!LOG_CSV) csvSnapIdx++;
+}
+
+void closeBinLog() {
+  if (binDataset != null) { binDataset.close(); binDataset = null; }
+  if (binDbg     != null) { binDbg.close();     binDbg = null;     }
+  if (binNodes   != null) { binNodes.close();   binNodes = null;   }
+  if (binEdges   != null) { binEdges.close();   binEdges = null;   }
+  if (binSnap    != null) { binSnap.close();    binSnap = null;    }
+}
@@ -1,6 +1,7 @@
 """
 compute_metrics.py
-Computes QE, TE, and runtime metrics from GNG CSV logs.
+Computes QE, TE, and runtime metrics from the GNG logs of V2_dataset.pde
+(binary run log, memory-mapped; older CSV sets are read as well).
 
 Usage:
   python compute_metrics.py                       # auto-detect latest
@@ -8,7 +9,13 @@ Usage:
   python compute_metrics.py 20260413_180644 20260413_180416   # multiple
 """
 
-import os, sys, csv, math, glob
+import os, sys
+
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "gng_host"))
+from gngio import metrics as gm
+from gngio import runlog
 
 LOGS_PATH   = os.path.join(os.path.dirname(__file__), "logs")
 SCALE       = 1000.0
@@ -16,119 +23,32 @@ DATA_WORDS  = 100
 SNAP_EVERY  = 50
 CLOCK_HZ    = 27_000_000
 
-def find_latest(logs_path):
-    files = glob.glob(os.path.join(logs_path, "dataset_*.csv"))
-    if not files:
-        raise FileNotFoundError(f"No dataset_*.csv in {logs_path}")
-    return os.path.basename(max(files)).replace("dataset_","").replace(".csv","")
-
-def load_dataset(ts):
-    path = os.path.join(LOGS_PATH, f"dataset_{ts}.csv")
-    pts = []
-    with open(path, newline="") as f:
-        for row in csv.DictReader(f):
-            pts.append((float(row["x_norm"]), float(row["y_norm"])))
-    return pts
-
-def load_final_nodes(ts):
-    path = os.path.join(LOGS_PATH, f"gng_nodes_{ts}.csv")
-    snaps = {}
-    with open(path, newline="") as f:
-        for row in csv.DictReader(f):
-            sid = int(row["snap_idx"])
-            nid = int(row["node_id"])
-            active = row["active"] == "1"
-            x = float(row["x_norm"])
-            y = float(row["y_norm"])
-            deg = int(row["degree"])
-            if sid not in snaps:
-                snaps[sid] = {}
-            snaps[sid][nid] = {"x": x, "y": y, "active": active, "deg": deg}
-    last_sid = max(snaps.keys())
-    return snaps[last_sid], last_sid
-
-def load_final_edges(ts, snap_idx):
-    path = os.path.join(LOGS_PATH, f"gng_edges_{ts}.csv")
-    edges = set()
-    with open(path, newline="") as f:
-        for row in csv.DictReader(f):
-            if int(row["snap_idx"]) == snap_idx:
-                a, b = int(row["node_a"]), int(row["node_b"])
-                edges.add((min(a,b), max(a,b)))
-    return edges
-
-def load_dbg(ts):
-    path = os.path.join(LOGS_PATH, f"gng_dbg_{ts}.csv")
-    rows = []
-    with open(path, newline="") as f:
-        for row in csv.DictReader(f):
-            try:
-                rows.append({
-                    "sample_idx": int(row["sample_idx"]),
-                    "fpga_ts_cycles": int(row["fpga_ts_cycles"]),
-                    "iter_us": float(row["iter_us"]),
-                })
-            except (TypeError, ValueError):
-                pass
-    return rows
-
-def load_meta(ts):
-    path = os.path.join(LOGS_PATH, f"meta_{ts}.txt")
-    if os.path.exists(path):
-        with open(path) as f:
-            return f.readline().strip()
-    return "Unknown"
-
-def compute_qe(dataset, nodes):
+def compute_qe(dataset, xy):
     """QE = mean distance from each sample to its BMU."""
-    active_nodes = [(n["x"], n["y"]) for n in nodes.values() if n["active"]]
-    total = 0.0
-    for sx, sy in dataset:
-        min_d = float("inf")
-        for nx, ny in active_nodes:
-            d = math.sqrt((sx - nx)**2 + (sy - ny)**2)
-            if d < min_d:
-                min_d = d
-        total += min_d
-    return total / len(dataset)
-
-def compute_te(dataset, nodes, edges):
+    return gm.quantization_error(dataset, xy)
+
+def compute_te(dataset, ids, xy, edges):
     """TE = fraction of samples whose BMU and 2nd BMU are NOT connected."""
-    active_nodes = [(nid, n["x"], n["y"]) for nid, n in nodes.items() if n["active"]]
-    misses = 0
-    for sx, sy in dataset:
-        dists = []
-        for nid, nx, ny in active_nodes:
-            d = (sx - nx)**2 + (sy - ny)**2
-            dists.append((d, nid))
-        dists.sort()
-        s1 = dists[0][1]
-        s2 = dists[1][1]
-        edge_key = (min(s1, s2), max(s1, s2))
-        if edge_key not in edges:
-            misses += 1
-    return misses / len(dataset)
-
-def compute_runtime(dbg_rows):
-    """Compute runtime metrics from DBG rows."""
-    # Per-sample cycles: difference between consecutive fpga_ts_cycles
-    deltas = []
-    for i in range(1, len(dbg_rows)):
-        dc = dbg_rows[i]["fpga_ts_cycles"] - dbg_rows[i-1]["fpga_ts_cycles"]
-        if dc > 0:
-            deltas.append(dc)
-
-    if not deltas:
+    return gm.topological_error(dataset, xy, edges, ids)
+
+def compute_runtime(dbg):
+    """Compute runtime metrics from the DBG records."""
+    # Per-sample cycles: difference between consecutive fpga_ts cycles
+    ts = dbg["fpga_ts"].astype(np.int64)
+    deltas = np.diff(ts)
+    deltas = deltas[deltas > 0]
+
+    if len(deltas) == 0:
         return None
 
-    avg_cycles = sum(deltas) / len(deltas)
+    avg_cycles = float(deltas.mean())
     avg_us = avg_cycles / (CLOCK_HZ / 1e6)
     throughput = CLOCK_HZ / avg_cycles if avg_cycles > 0 else 0
 
     # Total training time
-    total_cycles = dbg_rows[-1]["fpga_ts_cycles"] - dbg_rows[0]["fpga_ts_cycles"]
+    total_cycles = int(ts[-1] - ts[0])
     total_s = total_cycles / CLOCK_HZ
-    total_iters = len(dbg_rows)
+    total_iters = len(dbg)
     total_epochs = total_iters / DATA_WORDS
 
     return {
@@ -142,21 +62,22 @@ def compute_runtime(dbg_rows):
     }
 
 def analyze(ts):
-    meta = load_meta(ts)
+    log = runlog.open_log(LOGS_PATH, ts)
+    meta = log.name
     print(f"\n{'='*60}")
     print(f"  Dataset: {meta}  |  Log: {ts}")
     print(f"{'='*60}")
 
-    dataset = load_dataset(ts)
-    nodes, last_sid = load_final_nodes(ts)
-    edges = load_final_edges(ts, last_sid)
-    dbg = load_dbg(ts)
+    dataset = np.column_stack((log.dataset["x"], log.dataset["y"]))
+    last = log.n_snaps - 1
+    last_sid = int(log.snaps["snap_idx"][last])
+    ids, xy, edges = log.active(last)
 
-    active_count = sum(1 for n in nodes.values() if n["active"])
-    edge_count = len(edges)
+    active_count = len(ids)
+    edge_count = len({(min(a, b), max(a, b)) for a, b in edges.tolist()})
 
-    qe = compute_qe(dataset, nodes)
-    te = compute_te(dataset, nodes, edges)
+    qe = compute_qe(dataset, xy)
+    te = compute_te(dataset, ids, xy, edges)
 
     print(f"\n  Topology (final snapshot idx={last_sid}):")
     print(f"    Active nodes : {active_count}")
@@ -164,7 +85,7 @@ def analyze(ts):
     print(f"    QE           : {qe:.6f}")
     print(f"    TE           : {te:.4f} ({int(te*len(dataset))}/{len(dataset)} samples)")
 
-    rt = compute_runtime(dbg)
+    rt = compute_runtime(log.dbg)
     if rt:
         print(f"\n  Runtime ({int(rt['total_epochs'])} epochs, {rt['total_iters']} iterations):")
         print(f"    Avg cycles/sample : {rt['avg_cycles_per_sample']:.0f}")
@@ -177,7 +98,7 @@ def analyze(ts):
             "nodes": active_count, "edges": edge_count, "runtime": rt}
 
 if __name__ == "__main__":
-    timestamps = sys.argv[1:] if len(sys.argv) > 1 else [find_latest(LOGS_PATH)]
+    timestamps = sys.argv[1:] if len(sys.argv) > 1 else [runlog.find_latest(LOGS_PATH)]
     results = []
     for ts in timestamps:
         results.append(analyze(ts))
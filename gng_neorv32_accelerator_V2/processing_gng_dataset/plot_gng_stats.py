@@ -1,6 +1,6 @@
 """
 plot_gng_stats.py
-Reads the latest GNG CSV logs and plots:
+Reads the latest GNG log set (binary run log or CSV) and plots:
   Left   : Network Growth  (node count + edge count vs epoch)
   Middle : Convergence     (quantization error vs epoch)
   Right  : Topological Err (TE vs epoch)
@@ -11,10 +11,16 @@ Usage:
   python plot_gng_stats.py 20260413_145711 30    # specific timestamp + max epochs
 """
 
-import os, sys, glob, csv, math
+import os, sys
+
+import numpy as np
 import matplotlib.pyplot as plt
 import matplotlib.ticker as ticker
 
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "..", "gng_host"))
+from gngio import metrics as gm
+from gngio import runlog
+
 # -------------------------------------------------------
 # Config — must match VHDL generics
 # -------------------------------------------------------
@@ -28,92 +34,32 @@ MAX_EPOCHS = 64
 SNAPS_PER_EPOCH = DATA_WORDS // SNAP_EVERY   # = 2
 
 # -------------------------------------------------------
-# Find log timestamp
+# Open log set (binary run log is memory-mapped, CSV sets parsed)
 # -------------------------------------------------------
-def find_latest(logs_path):
-    files = glob.glob(os.path.join(logs_path, "dataset_*.csv"))
-    if not files:
-        raise FileNotFoundError(f"No dataset_*.csv in {logs_path}")
-    return os.path.basename(max(files)).replace("dataset_","").replace(".csv","")
-
-ts = sys.argv[1] if len(sys.argv) > 1 else find_latest(LOGS_PATH)
+ts = sys.argv[1] if len(sys.argv) > 1 else runlog.find_latest(LOGS_PATH)
 if len(sys.argv) > 2:
     MAX_EPOCHS = int(sys.argv[2])
 print(f"Log set: {ts}  (max epochs: {MAX_EPOCHS})")
 
-dataset_file = os.path.join(LOGS_PATH, f"dataset_{ts}.csv")
-nodes_file   = os.path.join(LOGS_PATH, f"gng_nodes_{ts}.csv")
-edges_file   = os.path.join(LOGS_PATH, f"gng_edges_{ts}.csv")
-dbg_file     = os.path.join(LOGS_PATH, f"gng_dbg_{ts}.csv")
+log = runlog.open_log(LOGS_PATH, ts)
+dataset = np.column_stack((log.dataset["x"], log.dataset["y"]))
 
 # -------------------------------------------------------
-# Load dataset (for TE computation)
-# -------------------------------------------------------
-dataset = []
-with open(dataset_file, newline="") as f:
-    for row in csv.DictReader(f):
-        dataset.append((float(row["x_norm"]), float(row["y_norm"])))
-
-# -------------------------------------------------------
-# 1. Node counts + positions per snap_idx
+# 1./2. Node and edge counts per snap_idx, TE per snapshot (incremental:
+#       only moved / added / removed nodes are re-scored against the dataset)
 # -------------------------------------------------------
 node_counts = {}                # snap_idx -> active node count
-nodes_by_snap = {}              # snap_idx -> {node_id: (x, y)}
-with open(nodes_file, newline="") as f:
-    for row in csv.DictReader(f):
-        sid = int(row["snap_idx"])
-        if row["active"] == "1":
-            node_counts[sid] = node_counts.get(sid, 0) + 1
-            nid = int(row["node_id"])
-            x = float(row["x_norm"])
-            y = float(row["y_norm"])
-            nodes_by_snap.setdefault(sid, {})[nid] = (x, y)
-
-# -------------------------------------------------------
-# 2. Edge counts + edge sets per snap_idx
-# -------------------------------------------------------
 edge_counts = {}                # snap_idx -> active edge count
-edges_by_snap = {}              # snap_idx -> set((a,b))
-with open(edges_file, newline="") as f:
-    for row in csv.DictReader(f):
-        sid = int(row["snap_idx"])
-        edge_counts[sid] = edge_counts.get(sid, 0) + 1
-        a = int(row["node_a"])
-        b = int(row["node_b"])
-        edges_by_snap.setdefault(sid, set()).add((min(a, b), max(a, b)))
-
-# -------------------------------------------------------
-# 3. Compute TE per snapshot
-# -------------------------------------------------------
-def compute_te(nodes_dict, edges_set, samples):
-    if len(nodes_dict) < 2:
-        return float("nan")
-    items = list(nodes_dict.items())  # [(nid, (x, y)), ...]
-    misses = 0
-    for sx, sy in samples:
-        d1 = d2 = float("inf")
-        s1 = s2 = -1
-        for nid, (nx, ny) in items:
-            d = (sx - nx)**2 + (sy - ny)**2
-            if d < d1:
-                d2, s2 = d1, s1
-                d1, s1 = d, nid
-            elif d < d2:
-                d2, s2 = d, nid
-        if s2 < 0:
-            continue
-        key = (min(s1, s2), max(s1, s2))
-        if key not in edges_set:
-            misses += 1
-    return misses / len(samples)
-
 te_by_snap = {}
-for sid in sorted(nodes_by_snap.keys()):
-    te_by_snap[sid] = compute_te(
-        nodes_by_snap[sid],
-        edges_by_snap.get(sid, set()),
-        dataset,
-    )
+scorer = gm.SnapshotScorer(dataset)
+for k in range(log.n_snaps):
+    sid = int(log.snaps["snap_idx"][k])
+    ids, xy, edges = log.active(k)
+    if len(ids):
+        node_counts[sid] = len(ids)
+        _, te_by_snap[sid] = scorer.update(ids, xy, edges)
+    if len(edges):
+        edge_counts[sid] = len({(min(a, b), max(a, b)) for a, b in edges.tolist()})
 
 # -------------------------------------------------------
 # Aggregate to epoch level: take last snap of each epoch
@@ -132,25 +78,12 @@ for sid in all_snaps:
         te_by_epoch[epoch] = te_by_snap[sid]
 
 # -------------------------------------------------------
-# 4. Quantization error per epoch from DBG CSV
+# 4. Quantization error per epoch from the DBG records
 # -------------------------------------------------------
-epoch_err = {}
-row_idx   = 0
-with open(dbg_file, newline="") as f:
-    for row in csv.DictReader(f):
-        epoch = row_idx // DATA_WORDS
-        row_idx += 1
-        if epoch >= MAX_EPOCHS:
-            break
-        try:
-            err32 = int(row["err32"])
-        except (TypeError, ValueError):
-            continue
-        d2_approx = max(err32, 0) * (2 ** ERR_SHIFT)
-        qe = math.sqrt(d2_approx) / SCALE
-        epoch_err.setdefault(epoch, []).append(qe)
-
-qe_by_epoch = {e: sum(v)/len(v) for e, v in epoch_err.items()}
+err32 = log.dbg["err32"][:MAX_EPOCHS * DATA_WORDS].astype(np.float64)
+qe_rows = np.sqrt(err32 * (2 ** ERR_SHIFT)) / SCALE
+qe_by_epoch = {int(e): float(qe_rows[e * DATA_WORDS:(e + 1) * DATA_WORDS].mean())
+               for e in range((len(qe_rows) + DATA_WORDS - 1) // DATA_WORDS)}
 
 # -------------------------------------------------------
 # Build plot arrays
@@ -1,6 +1,12 @@
 // ======================================================
 // GNG Replay Viewer
-// Loads CSV logs from V2_dataset and replays GNG training
+// Loads the logs of V2_dataset (binary run log, or older CSV sets) and
+// replays GNG training. Snapshots are decoded when they are shown:
+//   - binary set: files memory-mapped, the snapshot index gives the records
+//   - CSV set: one scan records the byte range of every snapshot, a frame
+//     is then read with a single seek
+//   - decoded frames sit in an LRU cache (SNAP_CACHE), playback decodes the
+//     next PREFETCH frames on a background thread
 //
 // Controls:
 //   Left / Right arrow  : prev / next snapshot
@@ -8,12 +14,12 @@
 //   P                   : play / pause auto-advance
 //   +  /  -             : speed up / slow down playback
 //   S                   : save screenshot (PNG)
-//   R                   : reload CSV files
+//   R                   : reload log files
 //   1..9                : jump to ~10%..90% of timeline
 // ======================================================
 
 import java.io.File;
-import java.util.Arrays;
+import java.util.*;
 
 // -------------------------------------------------------
 // CONFIG  –  point to the logs folder
@@ -23,7 +29,7 @@ import java.util.Arrays;
 // Use absolute path if needed, e.g. "C:/Users/you/.../logs"
 final String LOGS_PATH = "../processing_gng_dataset/logs";
 
-// Leave blank ("") to auto-pick the LATEST set of CSV files.
+// Leave blank ("") to auto-pick the LATEST log set (.bin or .csv).
 // Or set a specific timestamp prefix, e.g. "20260413_103045"
 String LOG_TIMESTAMP = "";
 
@@ -33,7 +39,7 @@ String LOG_TIMESTAMP = "";
 final int WIN_W      = 1060;
 final int WIN_H      = 960;
 final int INFO_H     = 110;
-final int MAX_NODES  = 40;
+final int MAX_NODES  = 255;   // node id cap (gng MAX_NODES <= 255)
 final float NODE_SCALE = 1000.0;
 final int A_MAX      = 50;
 
@@ -68,8 +74,28 @@ int[]     dataLabel;
 int       dataN = 0;
 String    datasetName = "GNG";
 
-// All snapshot frames, sorted by snapIdx
-ArrayList<SnapFrame> snaps = new ArrayList<SnapFrame>();
+// binary sets: mapped gng_nodes_/gng_edges_/gng_snap_<ts>.bin, see loadBinLog()
+java.nio.MappedByteBuffer binNodes, binEdges, binSnap;
+int binSnapN = 0;              // complete snapshots in the index
+boolean useBin = false;
+
+// CSV sets: byte range of each snapshot in gng_nodes_/gng_edges_<ts>.csv, see indexCSV()
+int csvSnapN = 0;
+int[]  csvSnapIdx;
+long[] csvNodeOff, csvNodeEnd;
+long[] csvEdgeOff, csvEdgeEnd; // off = end: snapshot without edges
+java.io.RandomAccessFile csvNodesRaf, csvEdgesRaf;
+
+// decoded snapshots: LRU cache + background prefetch during playback
+final int SNAP_CACHE = 256;    // frames kept
+final int PREFETCH   = 16;     // frames decoded ahead while playing
+final Object decodeLock = new Object();
+LinkedHashMap<Integer, SnapFrame> snapCache = new LinkedHashMap<Integer, SnapFrame>(SNAP_CACHE, 0.75, true) {
+  protected boolean removeEldestEntry(Map.Entry<Integer, SnapFrame> e) { return size() > SNAP_CACHE; }
+};
+HashSet<Integer> prefetchPending = new HashSet<Integer>();
+java.util.concurrent.ExecutorService prefetcher = java.util.concurrent.Executors.newSingleThreadExecutor();
+volatile int logGen = 0;       // bumped on reload, stale prefetches are dropped
 
 // Playback state
 int     currentSnap  = 0;
@@ -98,7 +124,7 @@ void setup() {
   frameRate(30);
   smooth(4);
   textFont(createFont("Consolas", 13));
-  loadCSVFiles();
+  loadLogFiles();
 }
 
 // -------------------------------------------------------
@@ -107,7 +133,7 @@ void setup() {
 void draw() {
   background(255);
 
-  if (snaps.isEmpty()) {
+  if (snapCount() == 0) {
     fill(80); textSize(18); textAlign(CENTER, CENTER);
     text("No snapshot data loaded.\nCheck LOGS_PATH and press R to reload.", width/2, height/2);
     return;
@@ -115,9 +141,10 @@ void draw() {
 
   // Auto-play
   if (playing && (millis() - lastPlayMs) >= playInterval) {
-    currentSnap = (currentSnap + 1) % snaps.size();
+    currentSnap = (currentSnap + 1) % snapCount();
     lastPlayMs  = millis();
   }
+  if (playing) prefetch(currentSnap);
 
   renderPlot();
   renderInfoBar();
@@ -183,7 +210,7 @@ void renderPlot() {
 
   // Title
   textSize(18); textAlign(CENTER, CENTER);
-  SnapFrame sf = snaps.get(currentSnap);
+  SnapFrame sf = snapAt(currentSnap);
   int iterNum  = sf.snapIdx * SNAP_EVERY;
   int epochNum = iterNum / DATA_WORDS;
   text("GNG " + datasetName + "  —  Epoch " + epochNum + "  |  FPGA: " + fpgaFmtTime(sf.fpgaTsCycles),
@@ -234,8 +261,8 @@ void renderPlot() {
 // Info bar
 // -------------------------------------------------------
 void renderInfoBar() {
-  if (snaps.isEmpty()) return;
-  SnapFrame sf = snaps.get(currentSnap);
+  if (snapCount() == 0) return;
+  SnapFrame sf = snapAt(currentSnap);
 
   int actN = 0;
   for (NodeState n : sf.nodes) if (n.active) actN++;
@@ -243,7 +270,7 @@ void renderInfoBar() {
   int y0 = height - INFO_H;
 
   // Progress bar — sits just above the info bar, inside the dark region
-  float frac = (snaps.size() > 1) ? (float)currentSnap / (snaps.size() - 1) : 0;
+  float frac = (snapCount() > 1) ? (float)currentSnap / (snapCount() - 1) : 0;
   int barH = 6, barPad = 10;
   fill(30); noStroke();
   rect(0, y0 - barH - barPad, width, barH + barPad); // background strip
@@ -259,7 +286,7 @@ void renderInfoBar() {
   int lh = 20;
   int iter  = sf.snapIdx * SNAP_EVERY;
   int epoch = iter / DATA_WORDS;
-  int totalEpochs = (snaps.size()-1) * SNAP_EVERY / DATA_WORDS;
+  int totalEpochs = (snapCount()-1) * SNAP_EVERY / DATA_WORDS;
   text("Epoch    : " + epoch + " / " + totalEpochs +
        "   (iter " + iter + ")" +
        "   FPGA: " + fpgaFmtTime(sf.fpgaTsCycles), 12, y0 + 6);
@@ -329,9 +356,9 @@ float py(float v, int sy0, int sh) {
 // -------------------------------------------------------
 void keyPressed() {
   if (keyCode == LEFT)  { currentSnap = max(0, currentSnap - 1); playing = false; }
-  if (keyCode == RIGHT) { currentSnap = min(snaps.size()-1, currentSnap + 1); playing = false; }
+  if (keyCode == RIGHT) { currentSnap = min(snapCount()-1, currentSnap + 1); playing = false; }
   if (keyCode == 36 /*HOME*/) { currentSnap = 0; playing = false; }
-  if (keyCode == 35 /*END*/)  { currentSnap = max(0, snaps.size()-1); playing = false; }
+  if (keyCode == 35 /*END*/)  { currentSnap = max(0, snapCount()-1); playing = false; }
 
   if (key == 'p' || key == 'P') {
     playing = !playing;
@@ -342,13 +369,13 @@ void keyPressed() {
 
   if (key == 's') saveScreenshot(false);   // plot area or crop selection
   if (key == 'S') saveScreenshot(true);    // full window
-  if (key == 'r' || key == 'R') { loadCSVFiles(); status("Reloaded CSV files."); }
+  if (key == 'r' || key == 'R') { loadLogFiles(); status("Reloaded log files."); }
   if (keyCode == ESC) { selActive = false; key = 0; } // clear selection, suppress quit
 
   // Jump to 10%..90% of timeline
-  if (key >= '1' && key <= '9' && !snaps.isEmpty()) {
+  if (key >= '1' && key <= '9' && snapCount() > 0) {
     float frac = (key - '0') / 10.0;
-    currentSnap = (int)(frac * (snaps.size() - 1));
+    currentSnap = (int)(frac * (snapCount() - 1));
     playing = false;
   }
 }
@@ -407,8 +434,8 @@ void drawSelectionOverlay() {
 // fullWindow=true  : save entire window (S key)
 void saveScreenshot(boolean fullWindow) {
   String base;
-  if (!snaps.isEmpty()) {
-    SnapFrame sf = snaps.get(currentSnap);
+  if (snapCount() > 0) {
+    SnapFrame sf = snapAt(currentSnap);
     base = "screenshot_snap" + nf(sf.snapIdx, 4) + "_" + timestamp();
   } else {
     base = "screenshot_" + timestamp();
@@ -454,29 +481,82 @@ String timestamp() {
 }
 
 // -------------------------------------------------------
-// CSV loading
+// Log loading
 // -------------------------------------------------------
-void loadCSVFiles() {
-  snaps.clear(); dataPoints = null; dataN = 0;
+int snapCount() { return useBin ? binSnapN : csvSnapN; }
 
-  // Find log timestamp
-  String ts = LOG_TIMESTAMP.trim();
-  if (ts.equals("")) ts = findLatestTimestamp();
-  if (ts.equals("")) { status("No CSV files found in: " + LOGS_PATH); return; }
-  LOG_TIMESTAMP = ts;
-  println("Loading log set: " + ts);
+SnapFrame snapAt(int k) {
+  synchronized (snapCache) {
+    SnapFrame sf = snapCache.get(k);
+    if (sf != null) return sf;
+  }
+  SnapFrame sf = decodeSnap(k);
+  synchronized (snapCache) { snapCache.put(k, sf); }
+  return sf;
+}
+
+// one decoder at a time: the CSV path seeks shared file handles
+SnapFrame decodeSnap(int k) {
+  synchronized (decodeLock) {
+    if (k < 0 || k >= snapCount()) return null;   // queued before a reload
+    return useBin ? binSnapAt(k) : csvSnapAt(k);
+  }
+}
+
+// queue the PREFETCH frames after k that are neither cached nor queued
+void prefetch(int k) {
+  final int n = snapCount();
+  for (int j = 1; j <= min(PREFETCH, n - 1); j++) {
+    final int f = (k + j) % n;
+    synchronized (snapCache) {
+      if (snapCache.containsKey(f) || prefetchPending.contains(f)) continue;
+      prefetchPending.add(f);
+    }
+    final int gen = logGen;
+    prefetcher.submit(new Runnable() {
+      public void run() {
+        SnapFrame sf = (gen == logGen) ? decodeSnap(f) : null;
+        synchronized (snapCache) {
+          prefetchPending.remove(f);
+          if (sf != null && gen == logGen) snapCache.put(f, sf);
+        }
+      }
+    });
+  }
+}
 
-  loadDataset(LOGS_PATH + "/dataset_"   + ts + ".csv");
-  loadNodes  (LOGS_PATH + "/gng_nodes_" + ts + ".csv");
-  loadEdges  (LOGS_PATH + "/gng_edges_" + ts + ".csv");
-  loadMeta   (LOGS_PATH + "/meta_"      + ts + ".txt");
+void loadLogFiles() {
+  synchronized (decodeLock) {
+    logGen++;
+    synchronized (snapCache) { snapCache.clear(); prefetchPending.clear(); }
+    dataPoints = null; dataN = 0;
+    useBin = false; binSnapN = 0; csvSnapN = 0;
+    closeCSVIndex();
+
+    // Find log timestamp
+    String ts = LOG_TIMESTAMP.trim();
+    if (ts.equals("")) ts = findLatestTimestamp();
+    if (ts.equals("")) { status("No log files found in: " + LOGS_PATH); return; }
+    LOG_TIMESTAMP = ts;
+    println("Loading log set: " + ts);
+
+    int t0 = millis();
+    if (new File(sketchPath(LOGS_PATH + "/dataset_" + ts + ".bin")).exists()) {
+      loadBinLog(ts);
+    } else {
+      loadDataset(LOGS_PATH + "/dataset_" + ts + ".csv");
+      indexCSV(ts);
+    }
+    loadMeta(LOGS_PATH + "/meta_" + ts + ".txt");
 
-  currentSnap = 0;
-  surface.setTitle("GNG " + datasetName + " Replay");
-  status("Loaded " + snaps.size() + " snapshots, " + dataN + " dataset pts  [" + ts + "]");
+    currentSnap = 0;
+    surface.setTitle("GNG " + datasetName + " Replay");
+    status("Loaded " + snapCount() + " snapshots, " + dataN + " dataset pts  [" + ts + "]  " +
+           (millis() - t0) + " ms");
+  }
 }
 
-// Find latest timestamp by listing files matching dataset_*.csv
+// Find latest timestamp by listing files matching dataset_*.bin / .csv
 String findLatestTimestamp() {
   File dir = new File(sketchPath(LOGS_PATH));
   if (!dir.exists()) { println("LOGS_PATH not found: " + dir.getAbsolutePath()); return ""; }
@@ -487,8 +567,8 @@ String findLatestTimestamp() {
   String latest = "";
   for (File f : files) {
     String name = f.getName();
-    if (name.startsWith("dataset_") && name.endsWith(".csv")) {
-      String ts = name.replace("dataset_", "").replace(".csv", "");
+    if (name.startsWith("dataset_") && (name.endsWith(".csv") || name.endsWith(".bin"))) {
+      String ts = name.substring(8, name.length() - 4);
       if (ts.compareTo(latest) > 0) latest = ts;
     }
   }
@@ -523,91 +603,148 @@ void loadDataset(String path) {
   println("Dataset loaded: " + dataN + " points");
 }
 
-void loadNodes(String path) {
-  String[] lines = loadStrings(sketchPath(path));
-  if (lines == null) { println("Cannot load: " + path); return; }
+// -------------------------------------------------------
+// CSV index: one pass over the bytes, only the snap_idx column is parsed
+// -------------------------------------------------------
+// ranges of consecutive rows with the same snap_idx: {snap_idx, first byte, end byte}
+ArrayList<long[]> scanSnapRanges(String path) {
+  ArrayList<long[]> out = new ArrayList<long[]>();
+  try {
+    java.io.InputStream in = new java.io.BufferedInputStream(
+      new java.io.FileInputStream(sketchPath(path)), 1 << 16);
+    byte[] buf = new byte[1 << 16];
+    long pos = 0, lineStart = 0;
+    int field = 0, val = 0;
+    boolean header = true, digits = false;
+    long[] cur = null;
+    int nr;
+    while ((nr = in.read(buf)) > 0) {
+      for (int i = 0; i < nr; i++, pos++) {
+        byte c = buf[i];
+        if (c == '\n') {
+          // timestamp,snap_idx,...: field 1 is the snapshot
+          if (!header && digits) {
+            if (cur == null || cur[0] != val) {
+              if (cur != null) out.add(cur);
+              cur = new long[] { val, lineStart, pos + 1 };
+            } else {
+              cur[2] = pos + 1;
+            }
+          }
+          header = false; field = 0; val = 0; digits = false;
+          lineStart = pos + 1;
+        } else if (c == ',') {
+          field++;
+        } else if (field == 1 && c >= '0' && c <= '9') {
+          val = val * 10 + (c - '0');
+          digits = true;
+        }
+      }
+    }
+    if (cur != null) out.add(cur);
+    in.close();
+  } catch (Exception e) {
+    println("Cannot index: " + path + " (" + e + ")");
+  }
+  return out;
+}
 
-  // Parse all rows, group by snap_idx
-  // timestamp,snap_idx,node_id,active,degree,x_int,y_int,x_norm,y_norm[,fpga_ts_cycles]
-  java.util.TreeMap<Integer, SnapFrame> frameMap = new java.util.TreeMap<Integer, SnapFrame>();
+void indexCSV(String ts) {
+  String np = LOGS_PATH + "/gng_nodes_" + ts + ".csv";
+  String ep = LOGS_PATH + "/gng_edges_" + ts + ".csv";
+  ArrayList<long[]> nr = scanSnapRanges(np);
+  ArrayList<long[]> er = scanSnapRanges(ep);
+  HashMap<Integer, long[]> edgeBySnap = new HashMap<Integer, long[]>();
+  for (long[] r : er) edgeBySnap.put((int)r[0], r);
+
+  int n = nr.size();
+  csvSnapIdx = new int[n];
+  csvNodeOff = new long[n]; csvNodeEnd = new long[n];
+  csvEdgeOff = new long[n]; csvEdgeEnd = new long[n];
+  for (int k = 0; k < n; k++) {
+    long[] r = nr.get(k);
+    csvSnapIdx[k] = (int)r[0];
+    csvNodeOff[k] = r[1]; csvNodeEnd[k] = r[2];
+    long[] e = edgeBySnap.get((int)r[0]);
+    if (e != null) { csvEdgeOff[k] = e[1]; csvEdgeEnd[k] = e[2]; }
+  }
+  try {
+    csvNodesRaf = new java.io.RandomAccessFile(sketchPath(np), "r");
+    csvEdgesRaf = new java.io.File(sketchPath(ep)).exists() ? new java.io.RandomAccessFile(sketchPath(ep), "r") : null;
+  } catch (Exception e) {
+    println("Cannot open: " + np + " (" + e + ")");
+    n = 0;
+  }
+  csvSnapN = n;
+  println("CSV index: " + n + " snapshots");
+}
 
-  for (int i = 1; i < lines.length; i++) {
-    String line = lines[i].trim();
-    if (line.length() == 0) continue;
-    String[] tok = line.split(",");
+void closeCSVIndex() {
+  try {
+    if (csvNodesRaf != null) csvNodesRaf.close();
+    if (csvEdgesRaf != null) csvEdgesRaf.close();
+  } catch (Exception e) { }
+  csvNodesRaf = null;
+  csvEdgesRaf = null;
+}
+
+String[] readLines(java.io.RandomAccessFile f, long off, long end) {
+  if (f == null || end <= off) return new String[0];
+  try {
+    byte[] b = new byte[(int)(end - off)];
+    f.seek(off);
+    f.readFully(b);
+    return new String(b, "UTF-8").split("\n");
+  } catch (Exception e) {
+    return new String[0];
+  }
+}
+
+// timestamp,snap_idx,node_id,active,degree,x_int,y_int,x_norm,y_norm[,fpga_ts_cycles]
+// timestamp,snap_idx,node_a,node_b,age_stored,true_age
+SnapFrame csvSnapAt(int k) {
+  SnapFrame sf    = new SnapFrame();
+  sf.snapIdx      = csvSnapIdx[k];
+  sf.timestamp    = "";
+  sf.fpgaTsCycles = -1;
+  sf.nodes        = new NodeState[MAX_NODES];
+  for (int i = 0; i < MAX_NODES; i++) sf.nodes[i] = new NodeState();
+
+  for (String line : readLines(csvNodesRaf, csvNodeOff[k], csvNodeEnd[k])) {
+    String[] tok = line.trim().split(",");
     if (tok.length < 9) continue;
     try {
-      String ts    = tok[0];
-      int snapIdx  = int(tok[1]);
-      int nodeId   = int(tok[2]);
+      int nodeId = int(tok[2]);
       if (nodeId < 0 || nodeId >= MAX_NODES) continue;
-
-      if (!frameMap.containsKey(snapIdx)) {
-        SnapFrame sf     = new SnapFrame();
-        sf.snapIdx       = snapIdx;
-        sf.timestamp     = ts;
-        sf.fpgaTsCycles  = -1;
-        sf.nodes         = new NodeState[MAX_NODES];
-        for (int k = 0; k < MAX_NODES; k++) sf.nodes[k] = new NodeState();
-        sf.edges         = new EdgeState[0];
-        frameMap.put(snapIdx, sf);
-      }
-      SnapFrame sf      = frameMap.get(snapIdx);
-      NodeState n       = sf.nodes[nodeId];
-      n.id              = nodeId;
-      n.active          = (int(tok[3]) == 1);
-      n.degree          = int(tok[4]);
-      n.x_int           = int(tok[5]);
-      n.y_int           = int(tok[6]);
-      n.x_norm          = float(tok[7]);
-      n.y_norm          = float(tok[8]);
+      if (sf.timestamp.equals("")) sf.timestamp = tok[0];
+      NodeState n = sf.nodes[nodeId];
+      n.id     = nodeId;
+      n.active = (int(tok[3]) == 1);
+      n.degree = int(tok[4]);
+      n.x_int  = int(tok[5]);
+      n.y_int  = int(tok[6]);
+      n.x_norm = float(tok[7]);
+      n.y_norm = float(tok[8]);
       // fpga_ts_cycles is the same for all nodes in a snap; read from first node row
-      if (tok.length >= 10 && sf.fpgaTsCycles < 0) {
-        sf.fpgaTsCycles = Long.parseLong(tok[9].trim());
-      }
+      if (tok.length >= 10 && sf.fpgaTsCycles < 0) sf.fpgaTsCycles = Long.parseLong(tok[9].trim());
     } catch (Exception e) { /* skip */ }
   }
 
-  snaps.addAll(frameMap.values());
-  println("Node snapshots loaded: " + snaps.size() + " frames");
-}
-
-void loadEdges(String path) {
-  String[] lines = loadStrings(sketchPath(path));
-  if (lines == null) { println("Cannot load: " + path); return; }
-
-  // Build a map snapIdx -> list of edges
-  java.util.HashMap<Integer, ArrayList<EdgeState>> edgeMap =
-    new java.util.HashMap<Integer, ArrayList<EdgeState>>();
-
-  // timestamp,snap_idx,node_a,node_b,age_stored,true_age
-  for (int i = 1; i < lines.length; i++) {
-    String line = lines[i].trim();
-    if (line.length() == 0) continue;
-    String[] tok = line.split(",");
+  ArrayList<EdgeState> list = new ArrayList<EdgeState>();
+  for (String line : readLines(csvEdgesRaf, csvEdgeOff[k], csvEdgeEnd[k])) {
+    String[] tok = line.trim().split(",");
     if (tok.length < 6) continue;
     try {
-      int snapIdx = int(tok[1]);
       EdgeState e = new EdgeState();
       e.a         = int(tok[2]);
       e.b         = int(tok[3]);
       e.ageStored = int(tok[4]);
       e.trueAge   = int(tok[5]);
-      if (!edgeMap.containsKey(snapIdx)) edgeMap.put(snapIdx, new ArrayList<EdgeState>());
-      edgeMap.get(snapIdx).add(e);
+      list.add(e);
     } catch (Exception e2) { /* skip */ }
   }
-
-  // Attach edges to snap frames
-  for (SnapFrame sf : snaps) {
-    ArrayList<EdgeState> list = edgeMap.get(sf.snapIdx);
-    if (list != null) {
-      sf.edges = list.toArray(new EdgeState[0]);
-    } else {
-      sf.edges = new EdgeState[0];
-    }
-  }
-  println("Edges loaded and attached.");
+  sf.edges = list.toArray(new EdgeState[0]);
+  return sf;
 }
 
 void loadMeta(String path) {
@@ -618,3 +755,104 @@ void loadMeta(String path) {
   }
   println("Dataset name: " + datasetName);
 }
+
+// -------------------------------------------------------
+// Binary run log (V2_dataset LOG_BIN, gng_host/gngio/runlog.py)
+//   16-byte header: "GNGB" u16 version u16 record size u32 start 4s kind
+//   dset 16 B: f32 x, f32 y, i16 x_int, i16 y_int, u8 label
+//   node  8 B: u8 id, act, deg, pad, i16 x_int, y_int
+//   edge  4 B: u8 a, b, age_stored, pad
+//   snap 32 B: u32 snap_idx, node_off, edge_off, u16 node_n, edge_n, u32 fpga_ts, ...
+// -------------------------------------------------------
+final int BIN_HDR = 16;
+
+// read-only map of a log file, null if missing or of another kind / layout
+java.nio.MappedByteBuffer mapLog(String path, String kind, int recSize) {
+  try {
+    java.io.RandomAccessFile f = new java.io.RandomAccessFile(sketchPath(path), "r");
+    java.nio.MappedByteBuffer m = f.getChannel().map(
+      java.nio.channels.FileChannel.MapMode.READ_ONLY, 0, f.length());
+    f.close();   // the mapping stays valid
+    m.order(java.nio.ByteOrder.LITTLE_ENDIAN);
+    String magic = "" + (char)m.get(0) + (char)m.get(1) + (char)m.get(2) + (char)m.get(3);
+    String k = "" + (char)m.get(12) + (char)m.get(13) + (char)m.get(14) + (char)m.get(15);
+    if (!magic.equals("GNGB") || !k.equals(kind) || m.getShort(6) != recSize) {
+      println("Not a GNGB '" + kind + "' file: " + path);
+      return null;
+    }
+    return m;
+  } catch (Exception e) {
+    println("Cannot map: " + path + " (" + e + ")");
+    return null;
+  }
+}
+
+int binRecords(java.nio.MappedByteBuffer m, int recSize) {
+  return (m == null) ? 0 : (m.capacity() - BIN_HDR) / recSize;
+}
+
+void loadBinLog(String ts) {
+  java.nio.MappedByteBuffer ds = mapLog(LOGS_PATH + "/dataset_" + ts + ".bin", "dset", 16);
+  binNodes = mapLog(LOGS_PATH + "/gng_nodes_" + ts + ".bin", "node", 8);
+  binEdges = mapLog(LOGS_PATH + "/gng_edges_" + ts + ".bin", "edge", 4);
+  binSnap  = mapLog(LOGS_PATH + "/gng_snap_"  + ts + ".bin", "snap", 32);
+
+  int n = binRecords(ds, 16);
+  dataPoints = new float[n][2];
+  dataLabel  = new int[n];
+  for (int i = 0; i < n; i++) {
+    int p = BIN_HDR + i * 16;
+    dataPoints[i][0] = ds.getFloat(p);
+    dataPoints[i][1] = ds.getFloat(p + 4);
+    dataLabel[i]     = ds.get(p + 12) & 0xFF;
+  }
+  dataN = n;
+
+  // a log still being written: drop index records whose node/edge records are not there yet
+  int nodeN = binRecords(binNodes, 8), edgeN = binRecords(binEdges, 4);
+  binSnapN = (binNodes == null || binEdges == null) ? 0 : binRecords(binSnap, 32);
+  while (binSnapN > 0) {
+    int p = BIN_HDR + (binSnapN - 1) * 32;
+    if (binSnap.getInt(p + 4) + (binSnap.getShort(p + 12) & 0xFFFF) <= nodeN &&
+        binSnap.getInt(p + 8) + (binSnap.getShort(p + 14) & 0xFFFF) <= edgeN) break;
+    binSnapN--;
+  }
+  useBin = true;
+  println("Binary log: " + dataN + " points, " + binSnapN + " snapshots (mapped)");
+}
+
+// snapshot k straight from the maps (absolute reads only)
+SnapFrame binSnapAt(int k) {
+  int p = BIN_HDR + k * 32;
+  SnapFrame sf    = new SnapFrame();
+  sf.snapIdx      = binSnap.getInt(p);
+  sf.timestamp    = "";
+  sf.fpgaTsCycles = binSnap.getInt(p + 16) & 0xFFFFFFFFL;
+  int nodeOff = binSnap.getInt(p + 4), edgeOff = binSnap.getInt(p + 8);
+  int nodeN   = binSnap.getShort(p + 12) & 0xFFFF, edgeN = binSnap.getShort(p + 14) & 0xFFFF;
+
+  sf.nodes = new NodeState[MAX_NODES];
+  for (int i = 0; i < MAX_NODES; i++) { sf.nodes[i] = new NodeState(); sf.nodes[i].id = i; }
+  for (int i = 0; i < nodeN; i++) {
+    int q = BIN_HDR + (nodeOff + i) * 8;
+    int id = binNodes.get(q) & 0xFF;
+    NodeState n = sf.nodes[id];
+    n.active = binNodes.get(q + 1) != 0;
+    n.degree = binNodes.get(q + 2) & 0xFF;
+    n.x_int  = binNodes.getShort(q + 4);
+    n.y_int  = binNodes.getShort(q + 6);
+    n.x_norm = n.x_int / NODE_SCALE;
+    n.y_norm = n.y_int / NODE_SCALE;
+  }
+  sf.edges = new EdgeState[edgeN];
+  for (int i = 0; i < edgeN; i++) {
+    int q = BIN_HDR + (edgeOff + i) * 4;
+    EdgeState e = new EdgeState();
+    e.a         = binEdges.get(q) & 0xFF;
+    e.b         = binEdges.get(q + 1) & 0xFF;
+    e.ageStored = binEdges.get(q + 2) & 0xFF;
+    e.trueAge   = e.ageStored - 1;
+    sf.edges[i] = e;
+  }
+  return sf;
+}
@@ -0,0 +1,91 @@
+#!/usr/bin/env bash
+
+set -e
+
+# Cycle-count testbenches of the V2 HDL (GHDL, or NVC with SIM=nvc).
+#   tb_gng_find_winner : s1 / s2 / d1 against the reference scan, cycles/search
+#   tb_gng             : gng.vhd phase profile + TX capture, then the capture
+#                        is replayed against the gng.vhd model (gngio tb check),
+#                        once per VARIANTS entry PIPE_WIN:POS_W:ERR_W:
+#     false:16:32  serial, full node word (the reference capture)
+#     true:16:32   PIPE_WIN (overlapped winner search)
+#     false:11:32  narrowest exact position field (gng_layout.vhd)
+#     false:11:24  narrow position and saturating error field
+#                        every capture is checked on its own; those with
+#                        ERR_W = 32 keep the reference s1 / s2 / q / f and must
+#                        also be the reference capture byte for byte
+#
+# Usage:   sh run.sh [dataset] [iterations]
+# Example: SIM=nvc MAX_NODES=40 TX_CYCLES=1 sh run.sh circles 500
+#          PIPE_WIN=true sh run.sh          (one variant: PIPE_WIN / POS_W / ERR_W,
+#          POS_W=11 ERR_W=24 sh run.sh       the rest at their defaults)
+#          VARIANTS="false:16:32 true:12:20" sh run.sh
+#
+# Not run yet: no GHDL / NVC result exists for these benches.
+
+HERE="$(cd "$(dirname "$0")" && pwd)"
+SRC="$HERE/../gng_gowin_project/src"
+HOST="$HERE/../../gng_host"
+DATASET="${1:-circles}"
+ITERATIONS="${2:-300}"
+MAX_NODES="${MAX_NODES:-40}"
+TX_CYCLES="${TX_CYCLES:-270}"
+if [ -n "$PIPE_WIN$POS_W$ERR_W" ]
+then
+  VARIANTS="${PIPE_WIN:-false}:${POS_W:-16}:${ERR_W:-32}"
+fi
+VARIANTS="${VARIANTS:-false:16:32 true:16:32 false:11:32 false:11:24}"
+SIM="${SIM:-ghdl}"
+WORK="$HERE/build"
+
+# vectors need gng_host's numpy, the benches GHDL or NVC on PATH
+command -v "$SIM" >/dev/null || { echo "run.sh: $SIM not found (SIM=ghdl or SIM=nvc)" >&2; exit 1; }
+python3 -c "import numpy" 2>/dev/null || { echo "run.sh: gngio needs numpy (pip install numpy)" >&2; exit 1; }
+
+mkdir -p "$WORK"
+cd "$WORK"
+rm -f gng_tx_*.txt
+
+(cd "$HOST" && python3 -m gngio tb vectors v2 "$WORK/winner_v2.txt" --dataset "$DATASET" --max-nodes "$MAX_NODES")
+WORDS=$(cd "$HOST" && python3 -m gngio tb data "$WORK/gng_data.txt" --dataset "$DATASET" | sed 's/.*DATA_WORDS=\([0-9]*\).*/\1/')
+
+FILES="$SRC/gng_find_winner.vhd $SRC/gng.vhd $HERE/tb_gng_find_winner.vhd $HERE/tb_gng.vhd"
+
+# run_gng PIPE_WIN POS_W ERR_W -> gng_tx_<PIPE_WIN>_<POS_W>_<ERR_W>.txt
+run_gng() {
+  G="-gMAX_NODES=$MAX_NODES -gDATA=gng_data.txt -gDATA_WORDS=$WORDS -gITERATIONS=$ITERATIONS"
+  G="$G -gTX_CYCLES=$TX_CYCLES -gPIPE_WIN=$1 -gPOS_W=$2 -gERR_W=$3 -gTX_OUT=gng_tx_$1_$2_$3.txt"
+  if [ "$SIM" = "nvc" ]
+  then
+    nvc --std=2008 -e $G tb_gng -r
+  else
+    ghdl -r --std=08 tb_gng $G
+  fi
+}
+
+if [ "$SIM" = "nvc" ]
+then
+  nvc --std=2008 -a $FILES
+  nvc --std=2008 -e -gMAX_NODES="$MAX_NODES" -gVECTORS=winner_v2.txt tb_gng_find_winner -r
+else
+  ghdl -a --std=08 $FILES
+  ghdl -e --std=08 tb_gng_find_winner
+  ghdl -r --std=08 tb_gng_find_winner -gMAX_NODES="$MAX_NODES" -gVECTORS=winner_v2.txt
+  ghdl -e --std=08 tb_gng
+fi
+
+for v in $VARIANTS; do
+  p="${v%%:*}"; r="${v#*:}"
+  run_gng "$p" "${r%%:*}" "${r#*:}"
+done
+
+for v in $VARIANTS; do
+  tx="gng_tx_$(echo "$v" | tr : _).txt"
+  echo "PIPE_WIN:POS_W:ERR_W $v:"
+  (cd "$HOST" && python3 -m gngio tb check "$WORK/$tx" "$WORK/gng_data.txt")
+  # PIPE_WIN keeps the serial s1 / s2, POS_W >= 11 the positions, ERR_W = 32 the q / f
+  if [ "${v##*:}" = "32" ] && [ "$tx" != gng_tx_false_16_32.txt ] && [ -f gng_tx_false_16_32.txt ]
+  then
+    cmp gng_tx_false_16_32.txt "$tx" && echo "  TX stream = false:16:32"
+  fi
+done
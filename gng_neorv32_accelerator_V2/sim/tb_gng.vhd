@@ -0,0 +1,209 @@
+-- ============================================================================
+-- tb_gng.vhd - cycle profile and TX capture of gng.vhd
+--
+-- Runs gng.vhd on the dataset of "python -m gngio tb data" (one "x y" int16
+-- line per sample, DATA_WORDS = line count) with SNAP_EVERY = 1 and edge
+-- list snapshots, so every iteration streams DBG + NODES + EDGES:
+--   - data memory: sync 1-cycle read like mem_c in tang_nano_9k.vhd
+--   - UART model: tx_start_o -> busy for TX_CYCLES, then a done pulse
+--     (270 = 1 Mbaud at 27 MHz; 1 profiles the compute phases alone)
+--   - every TX byte goes to TX_OUT, one decimal per line; the stream is
+--     then checked bit-exactly by "python -m gngio tb check TX_OUT DATA"
+--   - cycles are counted per phase_o group (PHG_* in gng.vhd) and printed
+--     as a table with cycles per iteration (gng_done_o pulses)
+--   - POS_W / ERR_W: node_mem field widths (gng_layout.vhd); POS_W >= 11
+--     is exact. Errors are not in the stream (the check takes q / f from
+--     the capture), so a saturating ERR_W passes too; run.sh compares the
+--     ERR_W = 32 captures byte for byte instead
+--
+--   ghdl -r --std=08 tb_gng -gDATA=gng_data.txt -gDATA_WORDS=100
+-- ============================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library std;
+use std.textio.all;
+
+entity tb_gng is
+  generic (
+    MAX_NODES  : natural := 40;
+    DATA       : string  := "gng_data.txt";
+    DATA_WORDS : natural := 100;
+    ITERATIONS : natural := 300;
+    A_MAX      : natural := 50;
+    LAMBDA     : natural := 100;
+    PIPE_WIN   : boolean := false;
+    POS_W      : natural := 16;
+    ERR_W      : natural := 32;
+    TX_CYCLES  : natural := 270;
+    TX_OUT     : string  := "gng_tx.txt"
+  );
+end entity;
+
+architecture sim of tb_gng is
+
+  constant CLK_PERIOD : time := 37 ns;  -- 27 MHz
+
+  -- phase_o groups, order = PHG_* in gng.vhd
+  constant PHG_COUNT : natural := 12;
+  type names_t is array (0 to PHG_COUNT-1) of string(1 to 8);
+  constant PHG_NAMES : names_t := (
+    "idle    ", "sample  ", "winner  ", "update  ", "nbr     ", "renorm  ",
+    "spec    ", "connect ", "insert  ", "dbg tx  ", "snapshot", "next    ");
+  type cnt_t is array (0 to PHG_COUNT-1) of natural;
+
+  type mem_t is array (0 to 1023) of std_logic_vector(31 downto 0);
+
+  impure function load_data return mem_t is
+    file     f  : text;
+    variable l  : line;
+    variable m  : mem_t := (others => (others => '0'));
+    variable vx, vy : integer;
+    variable i  : natural := 0;
+  begin
+    file_open(f, DATA, read_mode);
+    while not endfile(f) and i < 1024 loop
+      readline(f, l);
+      next when l'length = 0;
+      read(l, vx);
+      read(l, vy);
+      m(i) := std_logic_vector(to_signed(vy, 16)) & std_logic_vector(to_signed(vx, 16));
+      i := i + 1;
+    end loop;
+    file_close(f);
+    assert i = DATA_WORDS
+      report DATA & " has " & integer'image(i) & " samples, DATA_WORDS=" & integer'image(DATA_WORDS)
+      severity failure;
+    return m;
+  end function;
+
+  constant MEM : mem_t := load_data;
+
+  signal clk     : std_logic := '0';
+  signal rstn    : std_logic := '0';
+  signal running : boolean := true;
+
+  signal start    : std_logic := '0';
+  signal raddr    : unsigned(9 downto 0);
+  signal rdata    : std_logic_vector(31 downto 0) := (others => '0');
+  signal busy     : std_logic;
+  signal done     : std_logic;
+  signal tx_start : std_logic;
+  signal tx_data  : std_logic_vector(7 downto 0);
+  signal tx_busy  : std_logic := '0';
+  signal tx_done  : std_logic := '0';
+  signal phase    : std_logic_vector(3 downto 0);
+
+begin
+
+  clk <= not clk after CLK_PERIOD / 2 when running else '0';
+
+  process(clk)
+  begin
+    if rising_edge(clk) then
+      rdata <= MEM(to_integer(raddr));
+    end if;
+  end process;
+
+  dut : entity work.gng
+    generic map (
+      MAX_NODES        => MAX_NODES,
+      DATA_WORDS       => DATA_WORDS,
+      A_MAX            => A_MAX,
+      LAMBDA           => LAMBDA,
+      SNAP_EVERY       => 1,
+      SNAP_EDGE_BITMAP => false,
+      PIPE_WIN         => PIPE_WIN,
+      POS_W            => POS_W,
+      ERR_W            => ERR_W
+    )
+    port map (
+      clk_i => clk, rstn_i => rstn, start_i => start,
+      data_raddr_o => raddr, data_rdata_i => rdata,
+      gng_busy_o => busy, gng_done_o => done,
+      tx_busy_i => tx_busy, tx_done_i => tx_done,
+      tx_start_o => tx_start, tx_data_o => tx_data,
+      phase_o => phase
+    );
+
+  -- UART model + capture
+  uart : process
+    file     f : text;
+    variable l : line;
+  begin
+    file_open(f, TX_OUT, write_mode);
+    loop
+      wait until rising_edge(clk) or not running;
+      exit when not running;
+      if tx_start = '1' then
+        write(l, to_integer(unsigned(tx_data)));
+        writeline(f, l);
+        tx_busy <= '1';
+        for c in 1 to TX_CYCLES loop
+          wait until rising_edge(clk);
+        end loop;
+        tx_busy <= '0';
+        tx_done <= '1';
+        wait until rising_edge(clk);
+        tx_done <= '0';
+      end if;
+    end loop;
+    file_close(f);
+    wait;
+  end process;
+
+  stim : process
+    variable cnt   : cnt_t := (others => 0);
+    variable its   : natural := 0;
+    variable total : natural := 0;
+    variable o     : line;
+    variable g     : natural;
+  begin
+    rstn <= '0';
+    wait for 5 * CLK_PERIOD;
+    wait until rising_edge(clk);
+    rstn <= '1';
+    wait until rising_edge(clk);
+    start <= '1';
+    wait until rising_edge(clk);
+    start <= '0';
+
+    while its < ITERATIONS loop
+      wait until rising_edge(clk);
+      g := to_integer(unsigned(phase));
+      if g < PHG_COUNT then
+        cnt(g) := cnt(g) + 1;
+      end if;
+      total := total + 1;
+      if done = '1' then
+        its := its + 1;
+      end if;
+    end loop;
+
+    write(o, string'("gng MAX_NODES=") & integer'image(MAX_NODES) & " DATA_WORDS="
+             & integer'image(DATA_WORDS) & " PIPE_WIN=" & boolean'image(PIPE_WIN)
+             & " TX_CYCLES=" & integer'image(TX_CYCLES) & ": " & integer'image(its)
+             & " iterations, " & integer'image(total) & " cycles, "
+             & integer'image(total / its) & " cycles/iteration");
+    writeline(output, o);
+    write(o, string'("  phase       cycles   per it      %"));
+    writeline(output, o);
+    for k in 0 to PHG_COUNT-1 loop
+      if cnt(k) > 0 then
+        write(o, string'("  ") & PHG_NAMES(k));
+        write(o, cnt(k), right, 11);
+        write(o, cnt(k) / its, right, 9);
+        write(o, real(cnt(k)) * 100.0 / real(total), right, 7, 1);
+        writeline(output, o);
+      end if;
+    end loop;
+
+    -- let the last frames drain, then stop the clock
+    wait for 2000 * (TX_CYCLES + 2) * CLK_PERIOD;
+    running <= false;
+    wait;
+  end process;
+
+end architecture;
@@ -0,0 +1,175 @@
+-- ============================================================================
+-- tb_gng_find_winner.vhd - self-checking bench for gng_find_winner.vhd
+--
+-- Reads the vector file of "python -m gngio tb vectors v2" (format in
+-- gng_host/gngio/tb.py): every N record loads the node memory (sync 1-cycle
+-- read, word = y & x) and the active mask, every S line starts one search
+-- and compares s1 / s2 / d1 with the sequential reference scan. s2 is only
+-- compared when the set has two usable nodes (otherwise it is "don't care"
+-- in gng.vhd as well).
+--
+-- Prints cycles per search (start_i -> done_o) min / mean / max and fails
+-- with severity failure on any mismatch.
+--
+--   ghdl -r --std=08 tb_gng_find_winner -gVECTORS=winner_v2.txt
+-- ============================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library std;
+use std.textio.all;
+
+entity tb_gng_find_winner is
+  generic (
+    MAX_NODES : natural := 40;
+    VECTORS   : string  := "winner_v2.txt"
+  );
+end entity;
+
+architecture sim of tb_gng_find_winner is
+
+  constant CLK_PERIOD : time := 37 ns;  -- 27 MHz
+
+  type mem_t is array (0 to 255) of std_logic_vector(31 downto 0);
+  signal mem : mem_t := (others => (others => '0'));
+
+  signal clk     : std_logic := '0';
+  signal rstn    : std_logic := '0';
+  signal running : boolean := true;
+
+  signal start   : std_logic := '0';
+  signal busy    : std_logic;
+  signal done    : std_logic;
+  signal x, y    : signed(15 downto 0) := (others => '0');
+  signal count   : unsigned(7 downto 0) := (others => '0');
+  signal mask    : std_logic_vector(MAX_NODES-1 downto 0) := (others => '0');
+  signal raddr   : unsigned(7 downto 0);
+  signal rdata   : std_logic_vector(31 downto 0) := (others => '0');
+  signal s1, s2  : unsigned(7 downto 0);
+  signal d1      : unsigned(32 downto 0);
+
+begin
+
+  clk <= not clk after CLK_PERIOD / 2 when running else '0';
+
+  -- node memory, sync 1-cycle read like the BRAM in gng.vhd
+  process(clk)
+  begin
+    if rising_edge(clk) then
+      rdata <= mem(to_integer(raddr));
+    end if;
+  end process;
+
+  dut : entity work.gng_find_winner
+    generic map (MAX_NODES => MAX_NODES)
+    port map (
+      clk_i => clk, rstn_i => rstn,
+      start_i => start, busy_o => busy, done_o => done,
+      x_i => x, y_i => y,
+      node_count_i => count, active_mask_i => mask,
+      node_raddr_o => raddr, node_rdata_i => rdata,
+      s1_o => s1, s2_o => s2, d1_o => d1
+    );
+
+  stim : process
+    file     f      : text;
+    variable l      : line;
+    variable o      : line;
+    variable c      : character;
+    variable n, m   : integer;
+    variable vx, vy, va           : integer;
+    variable e1, e2, h1, l1, h2, l2 : integer;
+    variable want_d1              : unsigned(32 downto 0);
+    variable usable               : natural;
+    variable cyc, cmin, cmax      : natural;
+    variable total, searches      : natural := 0;
+    variable errors               : natural := 0;
+  begin
+    cmin := natural'high;
+    cmax := 0;
+    rstn <= '0';
+    wait for 5 * CLK_PERIOD;
+    wait until rising_edge(clk);
+    rstn <= '1';
+
+    file_open(f, VECTORS, read_mode);
+    while not endfile(f) loop
+      readline(f, l);
+      if l'length = 0 then
+        next;
+      end if;
+      read(l, c);
+      if c = 'N' then
+        read(l, n);
+        read(l, m);
+        assert m = MAX_NODES
+          report "vector file is for MAX_NODES=" & integer'image(m) severity failure;
+        count <= to_unsigned(n, 8);
+        usable := 0;
+        for i in 0 to m - 1 loop
+          readline(f, l);
+          read(l, vx);
+          read(l, vy);
+          read(l, va);
+          mem(i) <= std_logic_vector(to_signed(vy, 16)) & std_logic_vector(to_signed(vx, 16));
+          mask(i) <= '1' when va /= 0 else '0';
+          if va /= 0 and i < n then
+            usable := usable + 1;
+          end if;
+        end loop;
+      elsif c = 'S' then
+        read(l, m);
+        for k in 1 to m loop
+          readline(f, l);
+          read(l, vx);
+          read(l, vy);
+          read(l, e1);
+          read(l, e2);
+          read(l, h1);
+          read(l, l1);
+          read(l, h2);
+          read(l, l2);
+          want_d1 := shift_left(to_unsigned(h1, 33), 16) + to_unsigned(l1, 33);
+
+          x <= to_signed(vx, 16);
+          y <= to_signed(vy, 16);
+          wait until rising_edge(clk);
+          start <= '1';
+          wait until rising_edge(clk);
+          start <= '0';
+          cyc := 1;
+          while done /= '1' loop
+            wait until rising_edge(clk);
+            cyc := cyc + 1;
+          end loop;
+
+          if to_integer(s1) /= e1 or d1 /= want_d1 or (usable >= 2 and to_integer(s2) /= e2) then
+            errors := errors + 1;
+            report "sample (" & integer'image(vx) & ", " & integer'image(vy) & "): s1/s2/d1 "
+                   & integer'image(to_integer(s1)) & "/" & integer'image(to_integer(s2)) & "/"
+                   & to_hstring(d1) & ", want " & integer'image(e1) & "/" & integer'image(e2)
+                   & "/" & to_hstring(want_d1) severity error;
+          end if;
+
+          total := total + cyc;
+          searches := searches + 1;
+          if cyc < cmin then cmin := cyc; end if;
+          if cyc > cmax then cmax := cyc; end if;
+        end loop;
+      end if;
+    end loop;
+    file_close(f);
+
+    write(o, string'("gng_find_winner MAX_NODES=") & integer'image(MAX_NODES)
+             & ": " & integer'image(searches) & " searches, cycles min/mean/max "
+             & integer'image(cmin) & "/" & integer'image(total / maximum(searches, 1)) & "/"
+             & integer'image(cmax) & ", " & integer'image(errors) & " errors");
+    writeline(output, o);
+    assert errors = 0 report "gng_find_winner: mismatches" severity failure;
+    running <= false;
+    wait;
+  end process;
+
+end architecture;
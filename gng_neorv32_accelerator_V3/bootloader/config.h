@@ -37,6 +37,16 @@
 #define UART_BAUD 256000
 #endif
 
+// Block upload 'f': CRC-checked page blocks at a negotiated baud rate (0,1)
+#ifndef UART_FAST_EN
+#define UART_FAST_EN 1
+#endif
+
+// Largest deviation of the negotiated baud rate from the requested one (ppm)
+#ifndef UART_FAST_MAX_ERR_PPM
+#define UART_FAST_MAX_ERR_PPM 20000
+#endif
+
 /**********************************************************************
  * Status LED (high-active)
  **********************************************************************/
@@ -65,6 +75,38 @@
 #define AUTO_BOOT_TIMEOUT 1
 #endif
 
+// Boot strap: GPIO input that selects the full AUTO_BOOT_TIMEOUT window (0,1);
+// released, the bootloader only listens AUTO_BOOT_FAST_MS for a key
+#ifndef BOOT_STRAP_EN
+#define BOOT_STRAP_EN 1
+#endif
+
+// GPIO input pin of the boot strap (0..31, high-active; S1 key on the Tang Nano 9K)
+#ifndef BOOT_STRAP_PIN
+#define BOOT_STRAP_PIN 0
+#endif
+
+// Key window without the strap (in milliseconds, 0 = none); uart_upload.py
+// keeps sending while the board resets, so a few ms catch it
+#ifndef AUTO_BOOT_FAST_MS
+#define AUTO_BOOT_FAST_MS 5
+#endif
+
+/**********************************************************************
+ * Executable in user flash (execute in place from the XBUS uflash)
+ **********************************************************************/
+
+// Image area (in KB) at EXE_BASE_ADDR, = ROM_KB of the application makefile;
+// its last 16 bytes hold the image descriptor (signature, size, CRC-32)
+#ifndef UFLASH_IMG_KB
+#define UFLASH_IMG_KB 56
+#endif
+
+// Check the image CRC-32 before auto-boot (0,1)
+#ifndef UFLASH_IMG_CRC_EN
+#define UFLASH_IMG_CRC_EN 1
+#endif
+
 /**********************************************************************
  * TWI flash
  **********************************************************************/
@@ -23,6 +23,10 @@
 #define BIN_OFFSET_DATA       12 // offset to data start
 #define BIN_SIGNATURE 0xB007C0DE // executable identifier
 
+// image descriptor in user flash (last 16 bytes of the image area)
+#define IMG_DESC_ADDR      ((uint32_t)EXE_BASE_ADDR + (uint32_t)UFLASH_IMG_KB * 1024u - 16u)
+#define IMG_DESC_SIGNATURE 0x49474E47 // "GNGI"
+
 // helper macros
 #define xstr(a) str(a)
 #define str(a) #a
@@ -32,5 +36,9 @@ void system_setup(void);
 int  system_exe_load(int (*dev_init)(void), int (*stream_get)(uint32_t* rdata));
 int  system_exe_store(int (*dev_init)(void), int (*dev_erase)(void), int (*stream_put)(uint32_t wdata));
 void system_boot_app(void);
+int  system_boot_strap(void);
+int  system_image_seal(void);
+int  system_image_check(void);
+uint32_t system_crc(uint32_t addr, uint32_t size);
 
 #endif // SYSTEM_H
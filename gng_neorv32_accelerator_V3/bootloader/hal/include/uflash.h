@@ -0,0 +1,42 @@
+// ================================================================================ //
+// The NEORV32 RISC-V Processor - https://github.com/stnolting/neorv32              //
+// Copyright (c) NEORV32 contributors.                                              //
+// Copyright (c) 2020 - 2025 Stephan Nolting. All rights reserved.                  //
+// Licensed under the BSD-3-Clause license, see LICENSE for details.                //
+// SPDX-License-Identifier: BSD-3-Clause                                            //
+// ================================================================================ //
+
+/**
+ * @file uflash.h
+ * @brief Tang Nano 9K user flash and block upload.
+ */
+
+#ifndef UFLASH_H
+#define UFLASH_H
+
+#include <stdint.h>
+
+// user flash layout (gng_gowin_project/src/uflash.vhd)
+#define UFLASH_BASE_ADDR  ((uint32_t)0x00000000u)
+#define UFLASH_PAGE_SIZE  ((uint32_t)2048u)
+#define UFLASH_NUM_PAGES  ((uint32_t)38u)
+#define UFLASH_IMG_PAGES  ((uint32_t)UFLASH_IMG_KB * 1024u / UFLASH_PAGE_SIZE)
+
+// block upload protocol ('f'), host -> bootloader opcodes
+#define FAST_OP_SYNC  0x55 // -> FAST_ACK
+#define FAST_OP_HASH  'H'  // + size u32 -> 'H' + CRC-32 u32 of every image page
+#define FAST_OP_PAGE  'P'  // + page u8 + 2048 bytes + CRC-32 u32 -> ack
+#define FAST_OP_END   'E'  // + size u32 + CRC-32 u32 -> ack, seals the image
+#define FAST_OP_GO    'G'  // boot the image
+#define FAST_OP_QUIT  'Q'  // -> FAST_ACK, back to the console at UART_BAUD
+
+// bootloader -> host answers
+#define FAST_ACK      'A'  // done
+#define FAST_NAK      'N'  // block CRC / flash verify failed, send it again
+#define FAST_BAD      'X'  // page index or size out of range
+#define FAST_DESC     'D'  // image descriptor page must be sent first (END)
+
+void uflash_erase_all(void);
+void uflash_fast_upload(void);
+
+#endif // UFLASH_H
@@ -256,6 +256,111 @@ int system_exe_store(int (*dev_init)(void), int (*dev_erase)(void), int (*stream
 }
 
 
+/**********************************************************************//**
+ * Boot strap (GPIO input BOOT_STRAP_PIN) asserted?
+ *
+ * @return 1 if the strap is set (or BOOT_STRAP_EN = 0), 0 otherwise.
+ **************************************************************************/
+int system_boot_strap(void) {
+#if (BOOT_STRAP_EN == 1)
+  if (neorv32_gpio_available()) {
+    return (neorv32_gpio_pin_get(BOOT_STRAP_PIN) != 0) ? 1 : 0;
+  }
+  return 0;
+#else
+  return 1;
+#endif
+}
+
+
+/**********************************************************************//**
+ * CRC-32 (IEEE, reflected) of memory read word-wide, 4 bits per step.
+ *
+ * @param addr Start address (32-bit aligned).
+ * @param size Size in bytes (multiple of 4).
+ * @return CRC-32 (same as zlib.crc32 of the bytes).
+ **************************************************************************/
+uint32_t system_crc(uint32_t addr, uint32_t size) {
+
+  static const uint32_t crc_nibble[16] = {
+    0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+    0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+  };
+
+  uint32_t crc = 0xFFFFFFFF;
+  uint32_t i, b;
+  for (i = 0; i < size; i += 4) {
+    uint32_t w = neorv32_cpu_load_unsigned_word(addr + i); // word-wide uflash read
+    for (b = 0; b < 8; b++) {
+      crc = crc_nibble[(crc ^ w) & 0xF] ^ (crc >> 4);
+      w >>= 4;
+    }
+  }
+  return ~crc;
+}
+
+
+/**********************************************************************//**
+ * CRC-32 of the executable in place.
+ *
+ * @param size Image size in bytes (multiple of 4).
+ * @return CRC-32.
+ **************************************************************************/
+static uint32_t system_image_crc(uint32_t size) {
+  return system_crc((uint32_t)EXE_BASE_ADDR, size);
+}
+
+
+/**********************************************************************//**
+ * Write the image descriptor after a successful upload to user flash.
+ * The descriptor area must be erased ('z'), as for the image itself.
+ *
+ * @return 0 if success, non-zero if error.
+ **************************************************************************/
+int system_image_seal(void) {
+
+  if ((g_exe_size == 0) || (g_exe_size > (uint32_t)UFLASH_IMG_KB * 1024 - 16)) {
+    uart_puts("\aERROR_SIZE\n");
+    return 1;
+  }
+
+  uint32_t crc = system_image_crc(g_exe_size);
+  neorv32_cpu_store_unsigned_word(IMG_DESC_ADDR + 4, g_exe_size);
+  neorv32_cpu_store_unsigned_word(IMG_DESC_ADDR + 8, crc);
+  neorv32_cpu_store_unsigned_word(IMG_DESC_ADDR + 0, IMG_DESC_SIGNATURE); // last: valid only when complete
+
+  if (system_image_check() != 0) {
+    return 1;
+  }
+  uart_puts("Image sealed, CRC ");
+  uart_puth(crc);
+  uart_putc('\n');
+  return 0;
+}
+
+
+/**********************************************************************//**
+ * Check the executable in user flash against its descriptor.
+ * Images written by older bootloaders have no descriptor and pass.
+ *
+ * @return 0 if bootable, non-zero if the CRC does not match.
+ **************************************************************************/
+int system_image_check(void) {
+
+  if (neorv32_cpu_load_unsigned_word(IMG_DESC_ADDR) != (uint32_t)IMG_DESC_SIGNATURE) {
+    return 0; // unsealed image, boot unchecked as before
+  }
+
+  uint32_t size = neorv32_cpu_load_unsigned_word(IMG_DESC_ADDR + 4);
+  uint32_t crc  = neorv32_cpu_load_unsigned_word(IMG_DESC_ADDR + 8);
+  if ((size == 0) || (size > (uint32_t)UFLASH_IMG_KB * 1024 - 16) || (system_image_crc(size) != crc)) {
+    uart_puts("\aERROR_IMAGE_CRC\n");
+    return 1;
+  }
+  return 0;
+}
+
+
 /**********************************************************************//**
  * Boot application program.
  **************************************************************************/
@@ -0,0 +1,320 @@
+// ================================================================================ //
+// The NEORV32 RISC-V Processor - https://github.com/stnolting/neorv32              //
+// Copyright (c) NEORV32 contributors.                                              //
+// Copyright (c) 2020 - 2025 Stephan Nolting. All rights reserved.                  //
+// Licensed under the BSD-3-Clause license, see LICENSE for details.                //
+// SPDX-License-Identifier: BSD-3-Clause                                            //
+// ================================================================================ //
+
+/**
+ * @file uflash.c
+ * @brief Tang Nano 9K user flash and block upload.
+ *
+ * See gng_gowin_project/src/tang_nano_9k.vhd and uflash.vhd: an 8-bit write
+ * to a 32-bit aligned address erases its 2048-byte page (~120 ms, the bus is
+ * held meanwhile), a 32-bit write programs one word (once per erase). Leave
+ * at least 10 ms between a program and an erase.
+ *
+ * Block upload ('f'), all binary, little-endian:
+ *   host: baud u32 (0 = keep)      -> 'B' + baud u32 both sides use from now
+ *   host: FAST_OP_SYNC at the new rate until FAST_ACK comes back
+ *   then opcodes (uflash.h) until FAST_OP_GO / FAST_OP_QUIT or 5 s silence.
+ * A page block is received into RAM and checked before its page is erased,
+ * so a NAK'd block costs one retransmit and no flash cycle. The host asks
+ * for the page hashes first and only sends the pages that differ; END checks
+ * the whole image CRC and seals it (system_image_seal()); its text lines
+ * come before the answer byte, which is the first byte or follows a '\n'.
+ */
+
+#include <neorv32.h>
+#include <config.h>
+#include <system.h>
+#include <uart.h>
+#include <uflash.h>
+
+extern uint32_t g_exe_size;
+
+#if (UART_FAST_EN == 1)
+static uint32_t fast_buf[UFLASH_PAGE_SIZE / 4]; // one page block
+#endif
+static uint64_t uflash_prog_time = 0; // CLINT time of the last program write
+static uint32_t uflash_erased = 0;    // image pages erased by this upload
+
+
+/**********************************************************************//**
+ * Erase one page, at least 10 ms after the last program write.
+ *
+ * @param page Page index.
+ **************************************************************************/
+static void uflash_page_erase(uint32_t page) {
+
+  if (neorv32_clint_available()) {
+    uint64_t t = uflash_prog_time + (NEORV32_SYSINFO->CLK / 100);
+    while (neorv32_clint_time_get() < t);
+  }
+
+  // 8-bit write to a 32-bit-aligned address in the page triggers erase
+  *(volatile uint8_t*)(UFLASH_BASE_ADDR + page * UFLASH_PAGE_SIZE) = 0x00;
+
+  if (page < 32) {
+    uflash_erased |= (uint32_t)1 << page;
+  }
+}
+
+
+/**********************************************************************//**
+ * Erase all pages so a new application image can be programmed cleanly.
+ **************************************************************************/
+void uflash_erase_all(void) {
+  uint32_t page;
+
+  uart_puts("Erasing uflash (" xstr(UFLASH_NUM_PAGES) " pages)...\n");
+
+  for (page = 0; page < UFLASH_NUM_PAGES; page++) {
+    uflash_page_erase(page);
+    uart_putc('.');
+  }
+
+  uart_puts("\nDone erasing uflash.\n");
+}
+
+
+#if (UART_FAST_EN == 1)
+/**********************************************************************//**
+ * Raw byte to UART0 (no LF conversion).
+ **************************************************************************/
+static void fast_putc(uint8_t c) {
+  neorv32_uart_putc(NEORV32_UART0, (char)c);
+}
+
+
+/**********************************************************************//**
+ * Raw 32-bit word to UART0, little-endian.
+ **************************************************************************/
+static void fast_put32(uint32_t w) {
+  int i;
+  for (i = 0; i < 4; i++) {
+    fast_putc((uint8_t)(w >> (8 * i)));
+  }
+}
+
+
+/**********************************************************************//**
+ * Receive n bytes before a deadline.
+ *
+ * @param dst Destination.
+ * @param n Number of bytes.
+ * @param ms Time for all of them.
+ * @return 0 if success, non-zero on timeout.
+ **************************************************************************/
+static int fast_get(uint8_t *dst, uint32_t n, uint32_t ms) {
+
+  uint64_t t_end = neorv32_clint_time_get() + (uint64_t)ms * (NEORV32_SYSINFO->CLK / 1000);
+  while (n) {
+    if (neorv32_uart_char_received(NEORV32_UART0)) {
+      *dst++ = (uint8_t)neorv32_uart_char_received_get(NEORV32_UART0);
+      n--;
+    }
+    else if (neorv32_clint_time_get() >= t_end) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+
+/**********************************************************************//**
+ * Receive a 32-bit word, little-endian.
+ **************************************************************************/
+static int fast_get32(uint32_t *w, uint32_t ms) {
+  subwords32_t tmp;
+  int rc = fast_get(&tmp.uint8[0], 4, ms);
+  *w = tmp.uint32;
+  return rc;
+}
+
+
+/**********************************************************************//**
+ * Baud rate neorv32_uart_setup() really produces (same divider search).
+ *
+ * @param baud Requested rate.
+ * @return Actual rate, 0 if not reachable within UART_FAST_MAX_ERR_PPM.
+ **************************************************************************/
+static uint32_t fast_baud(uint32_t baud) {
+
+  static const uint16_t prsc[8] = {2, 4, 8, 64, 128, 1024, 2048, 4096};
+  uint32_t clk = NEORV32_SYSINFO->CLK;
+  if (baud == 0) {
+    return 0;
+  }
+  uint32_t i = clk / (2 * baud);
+  uint32_t p = 0;
+  while (i >= 0x3FE) {
+    i >>= ((p == 2) || (p == 4)) ? 3 : 1;
+    p++;
+  }
+  if ((i == 0) || (p > 7)) {
+    return 0;
+  }
+  uint32_t actual = clk / ((uint32_t)prsc[p] * i);
+  uint32_t diff = (actual > baud) ? (actual - baud) : (baud - actual);
+  if ((uint64_t)diff * 1000000 > (uint64_t)baud * UART_FAST_MAX_ERR_PPM) {
+    return 0;
+  }
+  return actual;
+}
+
+
+/**********************************************************************//**
+ * Page block: receive, check, erase, program, verify.
+ *
+ * @return Answer byte (FAST_ACK, FAST_NAK, FAST_BAD).
+ **************************************************************************/
+static uint8_t fast_page(void) {
+
+  uint8_t hdr[3];
+  uint32_t crc;
+  if (fast_get(hdr, 3, 1000)) {
+    return FAST_NAK;
+  }
+  uint32_t page = hdr[0];
+  uint32_t len = (uint32_t)hdr[1] | ((uint32_t)hdr[2] << 8);
+  uint32_t addr = UFLASH_BASE_ADDR + page * UFLASH_PAGE_SIZE;
+  if ((len > UFLASH_PAGE_SIZE) || (len & 3)) {
+    return FAST_BAD; // the stream is out of step, the host restarts
+  }
+  if (fast_get((uint8_t*)fast_buf, len, 1000) || fast_get32(&crc, 1000)) {
+    return FAST_NAK;
+  }
+  if ((page >= UFLASH_IMG_PAGES) || (addr + len > IMG_DESC_ADDR) || (len == 0)) {
+    return FAST_BAD;
+  }
+  if (system_crc((uint32_t)fast_buf, len) != crc) {
+    return FAST_NAK; // flash untouched
+  }
+
+  uflash_page_erase(page);
+  uint32_t i;
+  for (i = 0; i < len; i += 4) {
+    neorv32_cpu_store_unsigned_word(addr + i, fast_buf[i / 4]);
+  }
+  uflash_prog_time = neorv32_clint_time_get();
+
+  return (system_crc(addr, len) == crc) ? FAST_ACK : FAST_NAK;
+}
+
+
+/**********************************************************************//**
+ * End of upload: check the whole image, seal it unless already sealed.
+ *
+ * @return Answer byte (FAST_ACK, FAST_NAK, FAST_BAD, FAST_DESC).
+ **************************************************************************/
+static uint8_t fast_end(void) {
+
+  uint32_t size, crc;
+  if (fast_get32(&size, 1000) || fast_get32(&crc, 1000)) {
+    return FAST_NAK;
+  }
+  if ((size == 0) || (size & 3) || (size > (uint32_t)UFLASH_IMG_KB * 1024 - 16)) {
+    return FAST_BAD;
+  }
+  if (system_crc((uint32_t)EXE_BASE_ADDR, size) != crc) {
+    return FAST_NAK; // a skipped page differs after all
+  }
+  g_exe_size = size;
+
+  if ((neorv32_cpu_load_unsigned_word(IMG_DESC_ADDR) == (uint32_t)IMG_DESC_SIGNATURE) &&
+      (neorv32_cpu_load_unsigned_word(IMG_DESC_ADDR + 4) == size) &&
+      (neorv32_cpu_load_unsigned_word(IMG_DESC_ADDR + 8) == crc)) {
+    return FAST_ACK; // nothing changed
+  }
+
+  // the descriptor words can only be programmed into an erased page
+  uint32_t page = (IMG_DESC_ADDR - UFLASH_BASE_ADDR) / UFLASH_PAGE_SIZE;
+  if ((uflash_erased & ((uint32_t)1 << page)) == 0) {
+    if (size > page * UFLASH_PAGE_SIZE) {
+      return FAST_DESC; // image data shares the page, host sends it
+    }
+    uflash_page_erase(page);
+  }
+  if (system_image_seal()) {
+    return FAST_NAK;
+  }
+  return FAST_ACK;
+}
+#endif
+
+
+/**********************************************************************//**
+ * Block upload console command ('f'), see file header.
+ **************************************************************************/
+void uflash_fast_upload(void) {
+
+#if (UART_FAST_EN == 1)
+  uint32_t baud, actual;
+
+  if (neorv32_clint_available() == 0) {
+    uart_puts("\aERROR_DEVICE\n");
+    return;
+  }
+  if (fast_get32(&baud, 2000)) {
+    uart_puts("\aERROR_TIMEOUT\n");
+    return;
+  }
+
+  actual = fast_baud(baud);
+  fast_putc('B');
+  fast_put32(actual ? actual : (uint32_t)UART_BAUD);
+  while (neorv32_uart_tx_busy(NEORV32_UART0));
+  if (actual) {
+    neorv32_uart0_setup(actual, 0);
+  }
+
+  uflash_erased = 0;
+  uint8_t op = 0;
+  while (1) {
+    if (fast_get(&op, 1, 5000)) {
+      break; // host gone
+    }
+
+    if (op == FAST_OP_SYNC) {
+      fast_putc(FAST_ACK);
+    }
+    else if (op == FAST_OP_HASH) {
+      uint32_t size, i;
+      if (fast_get32(&size, 1000) || (size > (uint32_t)UFLASH_IMG_KB * 1024)) {
+        fast_putc(FAST_BAD);
+        continue;
+      }
+      fast_putc('H');
+      for (i = 0; i < size; i += UFLASH_PAGE_SIZE) {
+        uint32_t len = ((size - i) < UFLASH_PAGE_SIZE) ? (size - i) : UFLASH_PAGE_SIZE;
+        fast_put32(system_crc((uint32_t)EXE_BASE_ADDR + i, len & ~3u));
+      }
+    }
+    else if (op == FAST_OP_PAGE) {
+      fast_putc(fast_page());
+    }
+    else if (op == FAST_OP_END) {
+      uint8_t a = fast_end();
+      fast_putc(a);
+      if (a == FAST_DESC) {
+        fast_putc((uint8_t)((IMG_DESC_ADDR - UFLASH_BASE_ADDR) / UFLASH_PAGE_SIZE));
+      }
+    }
+    else if (op == FAST_OP_GO) {
+      system_boot_app();
+    }
+    else if (op == FAST_OP_QUIT) {
+      fast_putc(FAST_ACK);
+      break;
+    }
+    // anything else: line noise around the baud switch, ignored
+  }
+
+  while (neorv32_uart_tx_busy(NEORV32_UART0));
+  neorv32_uart0_setup(UART_BAUD, 0);
+#else
+  uart_puts("\aERROR_DEVICE\n");
+#endif
+}
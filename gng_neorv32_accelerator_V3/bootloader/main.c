@@ -17,6 +17,7 @@
 #include <spi_flash.h>
 #include <sdcard.h>
 #include <twi_flash.h>
+#include <uflash.h>
 
 /**********************************************************************//**
  * User flash (uflash) layout on Tang Nano 9K
@@ -27,31 +28,22 @@
  * - To ERASE a page: do an 8-bit write (SEL = 0001) to any
  *   32-bit-aligned address inside that page.
  *
- * We provide a small helper that erases all pages so a new
+ * uflash.c has the page helpers: 'z' erases all pages so a new
  * application image can be programmed cleanly.
+ *
+ * The application executes in place from the uflash (IMEM_EN = false).
+ * After an upload 'u' seals the image with a descriptor in the last
+ * 16 bytes of the image area (UFLASH_IMG_KB): signature, size, CRC-32.
+ * Auto-boot checks it word-wide in place, without copying anything.
+ *
+ * Block upload: 'f' takes the image as CRC-checked page blocks at a
+ * negotiated baud rate and only rewrites the pages that changed
+ * (uart_upload.py --fast, see uflash.c).
+ *
+ * Fast boot: without the boot strap (BOOT_STRAP_PIN) the key window is
+ * AUTO_BOOT_FAST_MS instead of AUTO_BOOT_TIMEOUT.
  **************************************************************************/
 
-#define UFLASH_BASE_ADDR  ((uint32_t)0x00000000u)
-#define UFLASH_PAGE_SIZE  ((uint32_t)2048u)
-#define UFLASH_NUM_PAGES  ((uint32_t)38u)
-
-static void uflash_erase_all(void) {
-  uint32_t page;
-
-  uart_puts("Erasing uflash (" xstr(UFLASH_NUM_PAGES) " pages)...\n");
-
-  for (page = 0; page < UFLASH_NUM_PAGES; page++) {
-    volatile uint8_t *addr = (volatile uint8_t*)(UFLASH_BASE_ADDR + page * UFLASH_PAGE_SIZE);
-
-    // 8-bit write to a 32-bit-aligned address in the page triggers erase
-    *addr = 0x00;
-
-    uart_putc('.');
-  }
-
-  uart_puts("\nDone erasing uflash.\n");
-}
-
 /**********************************************************************//**
  * Bootloader main. "naked" because this is free-standing.
  **************************************************************************/
@@ -75,10 +67,18 @@ int __attribute__((naked)) main(void) {
 #if (AUTO_BOOT_EN == 1)
   uart_puts("Auto-boot");
 
-  // wait for timeout or user abort
+  // wait for timeout or user abort (full window only with the boot strap set)
   if (neorv32_clint_available()) {
-    uart_puts(" in "xstr(AUTO_BOOT_TIMEOUT)"s. Press any key to abort.\n");
-    uint64_t timeout_time = neorv32_clint_time_get() + (uint64_t)(AUTO_BOOT_TIMEOUT * NEORV32_SYSINFO->CLK);
+    uint64_t wait;
+    if (system_boot_strap()) {
+      uart_puts(" in "xstr(AUTO_BOOT_TIMEOUT)"s. Press any key to abort.\n");
+      wait = (uint64_t)AUTO_BOOT_TIMEOUT * NEORV32_SYSINFO->CLK;
+    }
+    else {
+      uart_puts(".\n");
+      wait = (uint64_t)AUTO_BOOT_FAST_MS * (NEORV32_SYSINFO->CLK / 1000);
+    }
+    uint64_t timeout_time = neorv32_clint_time_get() + wait;
     while (1) {
 
       // wait for user input via UART0
@@ -118,7 +118,12 @@ int __attribute__((naked)) main(void) {
   if (system_exe_load(sdcard_setup, sdcard_stream_get) == 0) { system_boot_app(); }
 #endif
 
-system_boot_app();
+  // executable in place from uflash
+#if (UFLASH_IMG_CRC_EN == 1)
+  if (system_image_check() == 0) { system_boot_app(); }
+#else
+  system_boot_app();
+#endif
 skip_auto_boot:
 
 #endif
@@ -149,8 +154,17 @@ skip_auto_boot:
       if (system_exe_load(uart_setup, uart_stream_get)) {
         break; // halt (to prevent garbage stream to trigger stuff)
       }
+      system_image_seal(); // image went straight into uflash
+
     }
 
+    /**** block upload, changed pages only ****/
+#if (UART_FAST_EN == 1)
+    if (cmd == 'f') {
+      uflash_fast_upload();
+    }
+#endif
+
     /**** start application program from main memory ****/
     if (cmd == 'e') {
       system_boot_app();
@@ -170,6 +184,9 @@ skip_auto_boot:
         "z: Erase user flash (uflash)\n"
         "r: Restart\n"
         "u: Upload via UART\n"
+#if (UART_FAST_EN == 1)
+        "f: Block upload via UART (changed pages)\n"
+#endif
 #if (TWI_FLASH_EN == 1)
         "t: TWI flash - load\n"
 #if (TWI_FLASH_PROG_EN == 1)
@@ -109,7 +109,7 @@ DSTATUS disk_initialize (void)
   UINT tmr;
 
 #if PF_USE_WRITE
-  if (CardType != 0 && is_cs_low) disk_writep(0, 0);  /* Finalize write process if it is in progress */
+  if (CardType != 0 && is_cs_low()) disk_writep(0, 0);  /* Finalize write process if it is in progress */
 #endif
   neorv32_spi_cs_dis();
   for (n = 10; n; n--) (BYTE)neorv32_spi_transfer(0xff);  /* 80 dummy clocks with CS=H */
@@ -11,8 +11,14 @@
 
 #define  PF_USE_READ   1  /* pf_read() function */
 #define  PF_USE_DIR    0  /* pf_opendir() and pf_readdir() function */
+/* the application (fw/makefile SD_CARD=1) builds these files too and
+/  enables lseek / write with -D, the bootloader keeps the defaults */
+#ifndef PF_USE_LSEEK
 #define  PF_USE_LSEEK  0  /* pf_lseek() function */
+#endif
+#ifndef PF_USE_WRITE
 #define  PF_USE_WRITE  0  /* pf_write() function */
+#endif
 
 #define PF_FS_FAT12    0  /* FAT12 */
 #define PF_FS_FAT16    0  /* FAT16 */
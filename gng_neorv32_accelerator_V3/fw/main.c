@@ -2,34 +2,495 @@
 // NEORV32 main.c - GNG Fritzke (CPU does full GNG)
 // CFS ONLY does: winner finder (s1,s2,min1,min2) using active mask + node_mem
 //
-// EDGE STORAGE (HALF ADJ MATRIX, NO FLAG BIT):
-//   edge_cell[ei] = 0            -> no edge (inactive)
-//   edge_cell[ei] = (age + 1)    -> edge active with true age = edge_cell - 1
-//
-// Therefore:
-//   reset age to 0   -> edge_cell = 1
-//   age++            -> edge_cell++   (only if edge_cell != 0)
-//   delete old edges -> if edge_cell > (A_MAX + 1) then edge_cell = 0
-//
-// DEGREE COUNTER:
-//   degree[i] = number of active edges incident to node i
-//   prune isolated -> if degree[i] == 0 then nodes[i].active=false
-//
-// LAZY DECAY (GLOBAL SCALING):
-//   - remove per-step O(N) decay loop "error *= D"
-//   - keep global scaling g_err_inv = 1 / (D^k) since last renorm
-//   - accumulate as: error[s1] += d1 * g_err_inv
-//   - each step: g_err_inv *= (1/D)
-//   - occasional renorm: error[i] *= (1/g_err_inv), then g_err_inv = 1
+// GNG CORE (../../gng_core/gng_core.h, shared with every other firmware):
+//   half adjacency matrix + degree + neighbor rows, max-error tournament,
+//   lazy decay, fixed-point path, active bitmask; this file only adds the
+//   V3 CFS search (gng_cfs.h: dirty-node flush, DMA sync, IRQ), the batch
+//   mode and the host protocol
 //
 // STREAMING COMPATIBILITY (KEEP OLD PROCESSING FORMAT):
 //   CMD_GNG_EDGES payload:
 //     [frame_id][count][a0][b0][a1][b1]... (count pairs)
 //   Because UART len <= 255, max pairs per frame = 126.
+//   More edges -> CMD_GNG_EDGES_CHUNK instead (same frame_id on every chunk):
+//     [frame_id][flags][chunk][n_chunks][total lo][total hi][count][pairs...]
+//     flags b0 = 16-bit node ids (MAX_NODES > 256), pair = a lo,a hi,b lo,b hi
+//   Host commits the edge set when chunk n_chunks-1 arrives with all pairs.
+//   CMD_GNG_EDGES_BITMAP (EDGE_PACKED=1) when it is shorter than the list:
+//     [frame_id][n_nodes][flags][data], bit k <-> edge_index_ij order
+//     flags 0: data = half-matrix bitmap, bit k = byte k/8 bit k%8
+//     flags 1: data = gap code, byte g < 255 = g zero bits then an edge,
+//              g = 255 = 255 zero bits, no edge (sparse graphs)
+//
+// DELTA STREAM (CMD_GNG_DELTA):
+//   - keyframe (old GNG_NODES + GNG_EDGES) every STREAM_KEYFRAME_EVERY frames
+//   - in between only nodes that moved > STREAM_DELTA_TH (wire units) or
+//     changed active, and edges added/removed since the last frame
+//   - edge events = nbr[] XOR sent_nbr[] (what the host has), no matrix walk
+//   - payload: [frame_id][n_node][n_add][n_rem]
+//              n_node * [id|0x80 if removed][x lo][x hi][y lo][y hi]
+//              n_add * [a][b], n_rem * [a][b]
+//   - host applies a delta only if frame_id == last frame + 1, else waits
+//     for the next keyframe; a delta > 255 bytes is replaced by a keyframe
+//
+// NON-BLOCKING UART TX (UART_TX_IRQ=1):
+//   - frames are copied into tx_ring[]; the UART0 IRQ (TX FIFO empty) refills
+//     the 16-byte hardware FIFO, so training runs while a snapshot goes out
+//   - the main loop only blocks when the ring is full; those cycles are
+//     summed in g_tx_stall and reported (then cleared) by the PROF frame
+//   - same IRQ moves received bytes into rx_ring[] (RX FIFO not empty), so a
+//     long step does not overrun the UART RX FIFO
+//
+// STREAMING DATASET (CMD_STREAM 0x04):
+//   - host sends CMD_STREAM instead of DATA_BATCH + DONE, then
+//     CMD_DATA_BATCH frames that go into the smp_q ring (STREAM_RING)
+//   - training pops one sample per step, waits when the ring is empty
+//   - back-pressure: CMD_CREDIT (0x15) [n lo][n hi] = host may send n more
+//     samples; STREAM_RING at start, then per STREAM_CREDIT_CHUNK consumed
+//   - samples beyond the credit are dropped and counted (PROF smp_dropped)
+//
+// ZERO-COPY SAMPLES (sample_t = CFS word, Q1.15 x | y << 16):
+//   - readSerial() decodes CMD_DATA_BATCH while it arrives: every 4 payload
+//     bytes become one sample_t written straight into its final slot
+//     (dataQ[] or the stream ring) behind the committed end, nothing goes
+//     through rx_payload[]
+//   - the checksum byte commits them (dataCount / smp_head += n); a bad
+//     frame leaves the slots uncommitted and they are overwritten later
+//   - training hands the word to the CFS as-is and only widens it for the
+//     CPU update (Q16.16 = q15 << 1); 4 bytes per sample instead of 8
+//   - samples are clamped to [0, 1) like the CFS always did
+//   - GNG_DIM > 2: 2 bytes per component, GNG_WORDS words per sample
+//
+// BAUD RENEGOTIATION (CMD_SET_BAUD 0x05 [u32 baud]):
+//   - fw answers CMD_BAUD_ACK (0x16) [u32 actual] at the old rate, drains
+//     TX, then reprograms UART0; actual = clk / (prsc * div) of the divider
+//     neorv32_uart0_setup() picks (27 MHz: 13.5M, 6.75M, 4.5M, 3.375M, ...)
+//   - actual = 0: rate error > BAUD_MAX_ERR_PPM, link stays as it is
+//   - host switches its port to 'actual' after the ACK
+//
+// RX FRAMING / LINK COUNTERS (CMD_LINK 0x23 [op]):
+//   - FF FF frames resync on the next FF FF, which a lost byte may find
+//     inside a payload (0xFF is a valid sample byte), so one hit can cost
+//     several frames; op 2 switches host -> board to COBS frames instead:
+//       COBS(CMD LEN PAYLOAD CHK) 00      (no 0x00 inside, 00 = frame end)
+//     every 00 restarts the parser, a damaged frame never takes the next one
+//     with it; op 1 switches back, a reset boots with FF FF frames
+//   - op 0 = counters only, op 3 = pad frame (link tests, no ACK);
+//     op | 0x80 clears the counters after the ACK
+//   - CMD_LINK_ACK (0x24): [framing][rx_ok][rx_bad][rx_skip][rx_lost] u32:
+//     good frames, bad checksum / cut by a 00, bytes dropped between frames,
+//     dataset samples beyond MAXPTS (they were truncated silently before;
+//     stream samples beyond the credit stay PROF smp_dropped)
+//   - board -> host frames keep FF FF framing
+//
+// HEALTH STATS (CMD_STATS 0x25 [ms lo][ms hi]):
+//   - CMD_STATS_FRAME (0x26) every 'ms' of wall clock, also while idle, so a
+//     monitor gets a heartbeat without snapshots (snap mask 0 is fine);
+//     ms = 0 stops them, no payload = one frame now; boot: STATS_MS (0 = off)
+//   - [steps][cycles][steps_s] u32: steps and mcycle since the last one,
+//     steps / s = steps * CPU_HZ / cycles
+//     [nodes][edges] u16: active nodes, sum(degree) / 2
+//     [rx_ok][rx_bad] u32: CMD_LINK counters (totals)
+//     [tx_queued][tx_sent] u32: bytes waiting in the TX rings now, UART0
+//     bytes handed to the FIFO (total, wraps)
+//     [inserts][renorms] u32: node insertions and error renorms (totals;
+//     GNG_ERR_BFP: steps of the shared exponent)
+//     [snap_every][snap_io] u32: snapshot interval in steps now (follows
+//     SNAP_TRIG_AUTO) and the cycles of the last snapshot per mille of its
+//     interval (SNAPSHOT TRIGGERS)
+//
+// NETWORK SEED (CMD_SEED 0x27 [op] ..., gngio shard merges):
+//   - replaces the view model with a host-built network (the merge of
+//     several boards' snapshots), training goes on from it
+//   - op 0: begin, clears the staged network; op 1 [first][n]: nodes
+//     first.. then n samples in the CMD_DATA_BATCH layout; op 2 [n]: n edges
+//     [a][b]; op 3: commit. Up to SEED_EDGES edges are staged, the rest count
+//     as lost; the host keeps every frame within SMP_CMD_MAX (GNG_SMP)
+//   - the commit runs between two steps like CMD_CKPT: the graph is cleared
+//     (gng_clear: step count, QE and drift state stay), the nodes come up
+//     with error 0 and fresh edges (age 0), the CFS gets a full node sync
+//     and the next snapshot is a keyframe; fewer than 2 nodes keep the old
+//     network
+//   - CMD_SEED_ACK (0x28) after the commit: [ok][nodes][edges lo][edges hi]
+//     [lost], edges = sum(degree) / 2 as loaded (GNG_MAX_DEGREE evicts)
+//
+// SDI SNAPSHOT PATH (SNAPSHOT_SDI=1, tang_nano_9k.vhd SNAPSHOT_SDI=true):
+//   - NODES/EDGES/DELTA/PROF frames go to the SDI (SPI slave) TX FIFO,
+//     clocked out by an external SPI master; same FF FF CMD LEN .. CHK frames
+//   - UART keeps text, CREDIT and BAUD_ACK; bytes outside frames are idle
+//
+// SNAPSHOT TRIGGERS (CMD_SNAP_MODE 0x06):
+//   - payload [mask][every lo][every hi][gap lo][gap hi][qe_pct][ms lo][ms hi]
+//     [io_pct] (only [mask] -> keep the other settings; a 0 field keeps its
+//     value; io_pct is optional)
+//   - mask b0 SNAP_TRIG_EVERY: every 'every' steps (default, STREAM_EVERY_N)
+//          b1 SNAP_TRIG_TOPO : node insert/prune or edge add/delete since
+//                              the last snapshot (g_topo_changes)
+//          b2 SNAP_TRIG_QE   : running QE (EMA of d1) qe_pct % below the
+//                              value at the last snapshot
+//          b3 SNAP_TRIG_TIME : 'ms' of wall clock (rdcycle64) passed
+//          b4 SNAP_TRIG_AUTO : like b0, but 'every' follows the measured
+//                              cost: after each snapshot the interval is
+//                              set so that snapshots take io_pct % (default
+//                              SNAP_IO_PCT) of the cycles (snap_auto)
+//   - event triggers (TOPO, QE) wait at least 'gap' steps after a snapshot
+//   - mask 0 = no snapshots at all (pure training / benchmarking)
+//   - cost: rdcycle64 around snap_send (blocking on a full TX ring included;
+//     with GNG_SMP the hart 0 publish only) against the cycles between two
+//     snapshots; both go through an EMA of 1/8 (keyframes and deltas mix),
+//     the interval is clamped to SNAP_AUTO_MIN .. SNAP_AUTO_MAX steps
+//   - CMD_STATS_FRAME carries the interval in use and the I/O share of the
+//     last one (any mask, so a fixed 'every' can be checked as well)
 //
 // PROFILING (EXCLUDE UART STREAM TIME):
 //   - Measure cycles inside trainOneStep only
 //   - Send CMD_PROF (0x12) as separate frame (after trainOneStep)
+//   - 'cache' = SYSINFO cache word: a log records the i-cache profile of its
+//     bitstream next to misa / mxisa (gngio bench prints the cyc_* deltas)
+//   - 'idle' / 'time' = CLINT ticks asleep (total) and CLINT time: between two
+//     PROF frames awake ticks = d(time) - d(idle), per step that is the
+//     energy figure gngio bench reports (awake cycles / step)
+//   - PROF cycles are those of the last step before the snapshot; CMD_PROF_AGG
+//     (0x1C, GNG_PROF_AGG=1, ../../gng_core/gng_prof.h) follows a PROF every
+//     PROF_AGG_MS with count / min / max / sum and a log2 histogram of every
+//     phase over all steps since the last one (batch: per update, DBL: per
+//     epoch), one frame per phase that ran, reset when sent
+//
+// EXECUTION TRACE (CMD_TRACE 0x0F, GNG_TRACE=1, tang_nano_9k.vhd CPU_TRACER > 0):
+//   - [steps]: the next steps (1 if 0) run with neorv32_tracer recording
+//     hart 0's non-linear control flow (taken branches, jumps, traps) as
+//     (src, dst) PC pairs; the tracer drops the oldest pair when full, so a
+//     step longer than CPU_TRACER pairs keeps its tail
+//   - after each traced step CMD_TRACE_DATA (0x22) [step u32][cycles u32]
+//     [first u16][n][flags] + n * [src u32][dst u32] drains the buffer,
+//     flags b0 = last frame of the step, b1 = no tracer in the bitstream;
+//     src bit 0 = first pair of the capture, dst bit 0 = trap entry
+//   - cycles = mcycle over the whole traced step; the tracer itself does
+//     not stall the CPU, the UART drain runs after the step
+//   - gngio trace maps the pairs onto main.elf: instructions per function
+//     and per loop (backward branch), cycles apportioned by instruction share
+//
+// CUSTOM INSTRUCTIONS (GNG_CFU=1, tang_nano_9k.vhd CPU_CFU = true, presets.py "cfu"):
+//   - dist2, the Q16 lerp of node_step, pack_node_q15 and edge_index_ij run as
+//     one-cycle CFU instructions (../../gng_core/gng_cfu.h), bit-exact with
+//     the plain C, so training and frames do not change
+//   - boot stops with "ERROR: CFU missing" when mxisa has no Zxcfu
+//
+// CODE / DATA PLACEMENT (tang_nano_9k.vhd CPU_ICACHE):
+//   - no IMEM: the image executes from the uflash on the XBUS (uflash.vhd,
+//     ~5 cycles per fetch), all data lives in the 16 KB DMEM (1 cycle)
+//   - CPU_ICACHE blocks of 32 bytes in front of the fetches; the working set
+//     is one step (trainOneStep / gng_update and what they call), size it
+//     with presets.py CPU_ICACHE and the gngio bench cycle deltas
+//   - nodes[] stays an array of structs: with single-cycle DMEM a
+//     struct-of-arrays saves no cycles, and g_act already is the active bitmap
+//
+// CFS WINNER IRQ (CFS_USE_IRQ=1, see gng_cfs.h):
+//   - while the search runs the CPU drains the UART RX FIFO (readSerial)
+//   - cyc_winner = search wall time minus overlapped work (cyc_overlap)
+//
+// SAMPLE PRELOAD (CFS_PRELOAD=1, default; CFS INFO bit 25, see gng_cfs.h):
+//   - right after START the next sample (peek_sample: dataQ position or
+//     stream ring head) goes into the CFS staging registers, the next step
+//     then starts with no XIN/YIN/VEC writes
+//   - a wrong guess (new upload, query, model turn) costs the writes it
+//     saved, the step always searches its own sample; card runs do not peek
+//
+// CFS PERF COUNTERS (CMD_CFS_PERF 0x0E, CFS_PERF=1, default; CFS INFO bit 26):
+//   - [op]: 0 read, 1 read and clear; CMD_CFS_PERF_ACK (0x21) [ok][7 * u32]
+//     between steps, one frozen burst in gng_cfs.h CFS_PERF_* order: START
+//     writes, SMP_PUSH samples, busy / idle cycles, node window writes, bus
+//     accesses, stalls; ok = 0 (counters 0) on bitstreams without them
+//   - busy / (busy + idle) is the engine duty, bus / START the register
+//     traffic per search, node writes / START what dirty flushes cost
+//
+// CFS BATCH MODE (CFS_BATCH_N > 0):
+//   - push N packed samples into CFS_REG_SMP_PUSH, CTRL.BATCH scans them
+//     back-to-back and fills the result ring (s1,s2,min1)
+//   - winners of one batch see the node positions of the batch start
+//     (mini-batch approximation); CPU then applies the N updates in order
+//   - cyc_winner = batch search wall time / N
+//
+// CFS MOVE UNIT (GNG_CFS_MOVE=1, bitstream CFS_MOVE = true, presets "hw-move"):
+//   - training searches start with CTRL.MOVE: the CFS moves s1 by EPS_B and
+//     its neighbors by EPS_N (adj_mem mirrors nbr[]), gng_update() reads the
+//     moved words back and only ages the edges (gng_cfs.h MOVE UNIT)
+//   - implies GNG_POS16 (the node words are the positions, bit-exact with
+//     the CPU move); 2D without GNG_GRID_BITS or CFS_BATCH_N; queries, DBL
+//     epochs and batch scans search without moving
+//   - cyc_move_w = read-back of the moved words, cyc_nb = the aging store
+//
+// CFS SNAPSHOT DUMP (GNG_CFS_DUMP=1, bitstream CFS_DUMP = true, preset "hw-snapshot"):
+//   - probed at boot (REG_DIM bit 17, "DUMP=1"): keyframes come from the CFS
+//     framer, CMD_GNG_NODES out of node_mem and with GNG_CFS_MOVE the edge
+//     pairs out of adj_mem, same bytes as sendGNGNodes / sendGNGEdges
+//     (GNG_POS16, +-1 otherwise; list format, no EDGE_PACKED); without GNG_CFS_MOVE the CPU queues the
+//     edges, UART0 CTS holds them until the framer is done
+//   - only on an idle line (TX ring empty, UART0 not busy, no SD log),
+//     otherwise the CPU sends the keyframe as before; deltas, PROF and
+//     components stay on the CPU
+//   - the framer reads the node words while training goes on, so a keyframe
+//     may be a few steps newer than sent_x / sent_y (the next delta is
+//     against those); CMD_SET_BAUD waits for it and sets its bit time too
+//   - off with GNG_SMP, SNAPSHOT_SDI or MAX_NODES > 50
+//
+// DBL-GNG EPOCH MODE (CMD_TRAIN_MODE 0x07 [mode][order], ../../gng_core/gng_dbl.h):
+//   - mode 1: one batch update per pass over dataQ instead of one Fritzke
+//     step per sample; mode 0 (default) = online steps; ignored when streaming
+//   - winners of an epoch see the node positions of the epoch start, so the
+//     CFS batch scans are exact here: CFS_SMP_DEPTH samples per scan, the CPU
+//     sums batch k while the CFS scans batch k+1 (GNG_CFS=0: CPU search)
+//   - PROF per epoch: cyc_winner = search wait, cyc_nb = accumulate,
+//     cyc_move_w / cyc_connect / cyc_prune / cyc_insert = dbl_apply phases
+//
+// UFLASH CHECKPOINT (CMD_CKPT 0x08 [op], GNG_CKPT=1, ../../gng_core/gng_ckpt.h):
+//   - op 0 save, 1 load, 2 erase; answered by CMD_CKPT_ACK (0x18)
+//     [op][ok][seq u32], run from the main loop between two steps
+//   - two slots of CKPT_SLOT_PAGES pages at the top of the user flash, above
+//     the image (makefile ROM_KB); a save erases and rewrites the older slot,
+//     so an interrupted save leaves the previous checkpoint intact
+//   - at boot the newest valid slot (magic, format, MAX_NODES, CRC) is loaded
+//     instead of the two seed nodes ("CKPT=1\n", cold start "CKPT=0\n")
+//   - an erase holds the bus ~120 ms per page (nothing runs, RX is not
+//     drained): the host sends nothing until the ACK
+//
+// TF CARD RUNS (CMD_SD 0x09 [op][arg], SD_CARD=1, tang_nano_9k.vhd SD_CARD=true):
+//   - Petit FatFs of the bootloader on SPI CS 1, FAT32, 8.3 names in the root
+//   - op 1 [passes]: train online from GNGDATA.BIN (CMD_DATA_BATCH samples,
+//     x, y int16 LE, any length), passes 0 = endless, default 1; overrides
+//     dataQ and the stream ring until the run stops
+//   - two 512-byte sector buffers: training reads one, the next sector is
+//     read into the other while the CFS searches (cfs_overlap_work, SPI is
+//     CPU-clocked), one CMD17 per 128 samples
+//   - op 2 [tee]: snapshot / PROF frames go into GNGLOG.BIN instead of the
+//     wire (tee 1: both), same bytes as on the wire from sector 1, zeros
+//     between; sector 0 = "GNGL", version, frame sectors, samples. The file
+//     must exist (Petit FatFs does not grow files): gngio sdlog --alloc
+//   - op 0 stops both, the log is flushed and its header written; also sent
+//     once the last pass is done. CMD_SD_ACK (0x19) [op][status][samples
+//     u32][log sectors u32], status 0 ok, 1 no card, 2 data file, 3 log file
+//   - SD_AUTORUN: at boot a card with GNGDATA.BIN starts one pass on its own
+//     and logs into GNGLOG.BIN if present ("SD RUN LOG\n"), no host needed
+//   - log sector writes block the main loop; counted in PROF tx_stall
+//
+// RUNTIME PARAMETERS (CMD_SET_PARAMS 0x0A, GNG_PARAMS_RT=1, gng_core.h g_par):
+//   - payload 6 * u32 LE: [lambda][a_max][eps_b][eps_n][alpha][d], rates in
+//     Q16 (1.0 = 65536); an empty payload only asks for the current values
+//   - applied from the main loop between two steps: gng_params_set() clamps
+//     them (eps_b / eps_n at most 0.5, alpha and d at most 1.0) and
+//     precomputes 1/D - 1 and the renorm threshold, then the values go into
+//     CFS REG_LAMBDA..REG_D as well (read back by a debugger / host)
+//   - answered by CMD_PARAMS_ACK (0x1A) with the values now in use, same layout
+//   - the gng_core.h defines are the boot values; a checkpoint does not store
+//     them, the host sets them again after a reset
+//   - GNG_DRIFT: 5 more u32 after [d], in the ACK too: [drift_rise Q16, 0 =
+//     off][drift_hold steps][drift_eps Q16][lambda div][a_max div]; a
+//     24-byte SET_PARAMS keeps the drift settings
+//
+// TIME-SLICED MODELS (CMD_MODEL 0x0B, GNG_MODELS > 1, ../../gng_core/gng_ctx.h):
+//   - GNG_MODELS independent networks; the live one is the gng_core.h state,
+//     the others are parked gng_ctx_t copies (nodes, edges, errors, params)
+//   - [1][m]: the following CMD_DATA_BATCH samples are model m's, appended
+//     to dataQ as its own section (upload the models one after the other)
+//   - [0][k][slice lo][slice hi]: models 0..k-1 take turns of 'slice' steps
+//     (default MODEL_SLICE), models without samples are skipped; k = 1 trains
+//     the view model alone, and so do streams, card runs and DBL epochs
+//   - [2][m]: view model of snapshots, PROF, CMD_CKPT and CMD_SET_PARAMS;
+//     a new view restarts the delta stream with a keyframe
+//   - CFS with CTX >= GNG_MODELS node banks (tang_nano_9k.vhd CFS_CTX):
+//     a switch flushes the dirty nodes into the live bank and writes REG_CTX,
+//     no node upload; fewer banks: cfs_sync_nodes_full() on every switch
+//   - CMD_MODEL_ACK (0x1B) after every CMD_MODEL (empty = query):
+//     [models][k][view][upload m][banks][slice lo][slice hi] then per model
+//     [steps u32][samples lo][samples hi], then [hier]
+//
+// HIERARCHICAL MODELS (CMD_MODEL [3][on], GNG_MODELS >= 3):
+//   - model 0 is a coarse GNG of at most GNG_MODELS - 1 nodes (g_node_cap),
+//     its winner c picks the fine model 1 + c; every sample from dataQ (model
+//     0's section), a stream, the generator or the card trains the coarse
+//     model and is queued for its fine model
+//   - a queue of HIER_Q samples trains its fine model in one go, so the
+//     switch (one REG_CTX write with a bank per model) is paid once per
+//     HIER_Q steps; a sample costs a search over the coarse nodes plus one
+//     over one fine bank, the other banks are never scanned
+//   - GNG_MODELS 8 / MAX_NODES 16 (presets.py hierarchical): 7 * 16 = 112
+//     nodes for 7 + 16 node searches; DMEM, not the CFS, bounds it, every
+//     model parks a full gng_ctx_t copy
+//   - [3][0] trains the queued samples and gives model 0 MAX_NODES again;
+//     RUN k and DBL epochs do not apply while it is on, the view
+//     selects any level, CMD_QUERY / CMD_EVAL answer for the view model
+//
+// DUAL-HART SPLIT (GNG_SMP=1, tang_nano_9k.vhd CPU_DUAL_CORE=true):
+//   - hart 0 trains: commands, steps / epochs, snapshot triggers; hart 1
+//     (neorv32_smp_launch) owns UART0 and its IRQ: readSerial(), snapshot
+//     encoding, TX; the step no longer waits for a frame to be queued
+//   - CMD_DATA_BATCH is decoded by hart 1 straight into dataQ / smp_q, the
+//     indices (dataCount, smp_head / smp_tail) have one writer each
+//   - CMD_SET_BAUD is run by hart 1, every other command goes through an
+//     SMP_CMD_RING-deep command ring and runs on hart 0 between two steps
+//   - hart 0's own frames (CREDIT, ACKs, text) go through a byte ring that
+//     hart 1 copies into the TX ring between its frames (uart_tx_end)
+//   - a snapshot trigger copies positions, active mask and adjacency into
+//     one of two buffers (snap_publish); hart 1 encodes the newest one. While
+//     it still sends the older one the trigger is dropped, the delta stream
+//     stays consistent because hart 1 diffs against what it really sent
+//   - PROF tx_stall is hart 1's wait for the TX ring; SD_CARD is not supported
+//
+// IDLE SLEEP (GNG_IDLE_WFI=1, default):
+//   - not running, or no samples (stream ring below one step / batch): the
+//     main loop sleeps in wfi instead of spinning; UART0 RX and TX-drained
+//     IRQs wake it, every wake-up runs one loop pass and sleeps again
+//   - CFS CTRL.SLEEP gates the engine clock (DCE after the rPLL, only with
+//     CFS_CLK_MUL > 1); any later CTRL write ungates it
+//   - mcycle stops in wfi, so the cyc_* profile is unchanged; the sleep is
+//     counted on the CLINT (PROF idle)
+//   - GNG_SMP: hart 0 keeps polling its rings (no wake-up from hart 1 yet)
+//   - CFS_WAIT_WFI=1 (gng_cfs.h, with CFS_USE_IRQ) also sleeps through a
+//     search; at V3 search lengths the wake-up costs more than it saves
+//
+// QUERY SERVICE (CMD_QUERY 0x0C, inference only):
+//   - [seq][flags] then up to 63 samples in the CMD_DATA_BATCH layout; the
+//     winners are looked up on the view model, nothing is trained and the
+//     network does not change, with or without CMD_RUN
+//   - CMD_QUERY_ACK (0x1D): [seq][first][n] then n * [s1][label][min1 u32]
+//     (42 per frame, several frames per query); min1 is CFS OUT_MIN1 Q2.30,
+//     s1 = 0xFF with fewer than 2 active nodes
+//   - flags bit 0 (QRY_LABEL): label = g_comp[s1], the lowest node index of
+//     s1's component (the CMD_GNG_COMPONENTS label); otherwise, or with
+//     GNG_COMPONENTS=0, 0xFF
+//   - 2D CFS builds push the samples through the batch FIFO, CFS_SMP_DEPTH
+//     per scan back-to-back; otherwise one GNG_FIND_WINNERS per sample
+//   - QRY_RING queries are buffered, so a host keeps 2 in flight; a query on
+//     a full ring is dropped (no ACK), served between two steps like CMD_CKPT
+//
+// EVALUATION SWEEP (CMD_EVAL 0x2B [every u32], no snapshot needed):
+//   - the view model's resident samples (its dataQ section; with CMD_GEN
+//     EVAL_GEN_N fixed samples of the generator far from the trained
+//     indices) go through the winner search like CMD_QUERY, nothing is
+//     trained: QE = mean |x - s1| and TE = share of samples whose s1 and
+//     s2 share no edge, the compute_metrics.py compute_qe / compute_te
+//   - min1 (Q2.30) -> distance by an integer square root on the CPU, TE
+//     from edge_on(s1, s2); a stream or a card run has no resident set
+//     (n = 0)
+//   - every 0 / none: one sweep between two steps; every > 0: one now and
+//     then one per every view-model steps until CMD_EVAL 0; the convergence
+//     stop then averages the sweeps' mean min1 instead of the QE EMA
+//   - CMD_EVAL_ACK (0x2C): [step u32][n u16][qe u32][mse u32][te u16]
+//     [cycles u32], qe = mean distance Q16.16, mse = mean min1 Q2.30,
+//     te = samples with s1-s2 unconnected (TE = te / n), cycles of the sweep
+//
+// CONNECTED COMPONENTS (GNG_COMPONENTS=1, default; gng_core.h g_comp[]):
+//   - labels follow every edge change in the step (union on connect, a
+//     flood that stops at the other end on delete), so nothing is
+//     recomputed per snapshot and the host needs no edge pass for clusters
+//   - CMD_GNG_COMPONENTS (0x1E) after the PROF frame of a snapshot whenever
+//     the labels changed since the last one, and after every keyframe:
+//     [frame_id][count][first][n] then n labels of nodes first.., 0xFF =
+//     inactive; label = lowest node index of the component, count =
+//     components; more than 251 nodes take several frames
+//
+// GRID INDEX (GNG_GRID_BITS=b, make GNG_GRID_BITS=b; default 0 = off):
+//   - gng_core.h keeps a 2^b x 2^b cell bitset of the nodes; the per-step
+//     CFS search gets the mask of the sample's 3x3 cells instead of g_act,
+//     so the engine scans only those lane groups
+//   - OUT_MIN2 below the distance to the block border proves the winners
+//     equal to a full scan; otherwise the same sample runs again on g_act
+//   - pays for large MAX_NODES (b = 3 from ~100 nodes); at 40 nodes a 4x4
+//     grid still scans about half of them plus the occasional rerun
+//   - DBL epochs and CMD_QUERY batches keep the full mask (SMP_PUSH)
+//
+// SATURATION (GNG_UTILITY=1, default; gng_core.h GNG-U):
+//   - at MAX_NODES an insertion evicts the least useful node (utility =
+//     decayed sum of d2 - d1 of the samples it won) when the max-error
+//     node's error is above GNG_UTIL_K times that utility, and reuses its
+//     slot; a stream that drifts keeps a full table that follows it instead
+//     of one frozen on regions it left
+//   - the step pays one extra distance (d2), node_dist on the CPU
+//   - the eviction is a node pruning plus an insertion for the host: the
+//     snapshot/delta frames need nothing new; checkpoints carry the
+//     utilities (format bit b10, older records start cold)
+//
+// DRIFT BOOST (GNG_DRIFT=1, default; gng_core.h g_drift):
+//   - the step keeps a fast (~256 steps) and a slow (~4096) EMA of d1; fast
+//     above drift_rise * slow starts a boost: rates * drift_eps decaying to 1
+//     over drift_hold steps, insertion every lambda / div steps, edges
+//     dropped at a_max / div (CMD_SET_PARAMS sets all of it at run time)
+//   - meant for CMD_STREAM: an uploaded dataQ is replayed as it is, a
+//     stream (gngio bench --feed stream --dataset temporal) really drifts
+//   - PROF carries qe / qe_slow (Q2.30), boosts started, the latency of the
+//     last one (steps until fast fell back under (1 + rise) / 2 * slow) and
+//     the boost steps left, so a host reads adaptation in steps, not seconds
+//
+// SHUFFLED PASSES (GNG_SHUFFLE=1, default; ../../gng_core/gng_perm.h):
+//   - online training walks dataQ through a keyed Feistel permutation, a new
+//     key every pass: no index table, no host re-upload for a new order
+//   - CMD_TRAIN_MODE 0x07 [mode][order]: order 0 = upload order, 1 = shuffled
+//     (default); a frame with [mode] only keeps the order
+//   - PROF passes: online passes over the dataset (the live model's section)
+//     since reset; a model keeps its own count and position while parked
+//   - streams and card runs keep their arrival order, DBL epochs are order-free
+//
+// ON-BOARD GENERATORS (CMD_GEN 0x29 [kind][seed u32], GNG_GEN=1, default
+// with GNG_DIM 2; ../../gng_core/gng_gen.h):
+//   - kind 1 uniform square, 2 two moons, 3 concentric circles, 4 Gaussian
+//     mixture; Q1.15 samples drawn per step, endless, nothing stored, no
+//     upload (no MAXPTS limit); kind 0 goes back to dataQ / the stream
+//   - seed 0 or none: 4 bytes of the NEORV32 TRNG (tang_nano_9k.vhd
+//     TRNG_EN), without one GEN_SEED; the same seed replays the same stream
+//   - started between two steps like CMD_SD, training runs (CMD_RUN is
+//     implied), online steps only (no DBL epochs, no model rotation); a
+//     card run still takes precedence
+//   - CMD_GEN_ACK (0x2A): [kind][seed u32][trng], trng 1 = the seed came
+//     from the TRNG
+//
+// CONVERGENCE STOP (CMD_CONVERGE 0x0D, GNG_CONVERGE=1, default; off until set):
+//   - [action][window u16][qe_pct][churn u16][windows]: every window steps
+//     the view model is quiet if its mean QE over the window is within
+//     qe_pct % of the previous window's and it made at most churn topology
+//     changes (nodes + edges made or removed) per 1000 steps; churn is taken
+//     as sent (0 = none at all); windows quiet windows in a row converge it
+//   - the mean, not the QE EMA at the window end: the EMA (~256 steps) wanders
+//     by +-5 % on a converged network, a 4000-step mean by ~1 %; edges keep
+//     flipping at ~40 (GNG-U eviction: ~130) per 1000 steps at convergence
+//   - action 0 off, 1 notify (keep training), 2 stop: training halts, the
+//     network stays frozen for CMD_QUERY until CMD_RUN (which re-arms);
+//     only [action] (or a 0 field) keeps the other settings
+//   - on convergence CMD_CONVERGED (0x1F) [step u32][since u32][qe u32]
+//     [churn u32][action] (since = first step of the quiet run, qe = mean
+//     of the last window Q2.30, churn per 1000 steps of it), then a keyframe
+//     snapshot with PROF
+//   - a GNG_DRIFT boost breaks the quiet run
+//
+// COMPACTION (GNG_COMPACT=1, default; gng_core.h gng_compact()):
+//   - every COMPACT_EVERY steps, with COMPACT_SLACK or more holes below the
+//     highest active node, the live nodes move to a dense prefix 0..n-1;
+//     CFS NODE_COUNT follows gng_span() and the engine visits fewer lane
+//     groups (LANES neighbors share one), new nodes fill index n
+//   - CMD_GNG_REMAP (0x20) [frame_id][n][(from, to) * n] right after it
+//     (view model only), the next snapshot is a keyframe and the
+//     components are sent again; a host keeping per-node state renames it
+//   - moved nodes are dirty, the CFS gets them with the next flush
+//
+// N-DIMENSIONAL SAMPLES (GNG_DIM=D > 2, make GNG_DIM=D / preset.mk):
+//   - CMD_DATA_BATCH: [count] then count * D int16 LE components (1/1000),
+//     so one frame carries up to 254 / (2D) samples; a sample_t is
+//     GNG_WORDS words (gng_core.h), MAXPTS and STREAM_RING shrink to keep
+//     dataQ / smp_q at the 2D byte size
+//   - the CFS (DIM generic, same GNG_WORDS) gets the extra words at
+//     CFS_REG_VEC_BASE and streams them per node, checked at boot against
+//     REG_DIM; DBL epochs search one sample at a time (the batch FIFO is 2D)
+//   - snapshots, deltas and checkpoints: snapshots show components 0 / 1,
+//     checkpoints keep every component
+//   - not with CFS_BATCH_N or SD_CARD (GNGDATA.BIN holds x, y pairs)
+//
+// FIXED-POINT PATH (GNG_FIXED=1, default; make GNG_FIXED=0 for float):
+//   - distances taken as-is from CFS OUT_MIN1 (Q2.30, same as dist2)
+//   - ctz is one instruction with Zbb, see makefile GNG_ISA
+//
+// SOFTWARE-ONLY BUILD (GNG_CFS=0):
+//   - same GNG core (edge_cell, degree, lazy decay, tournament) on a plain
+//     NEORV32 without the CFS bitstream: winners come from gng_find_winners_sw,
+//     no CFS / DMA access at all (gng_neorv32/fw builds this file that way)
 // ================================================================================
 
 #include <neorv32.h>
@@ -37,20 +498,26 @@
 #include <stdbool.h>
 #include <stdint.h>
 
-#define BAUD_RATE 1000000
+#ifndef BAUD_RATE
+#define BAUD_RATE 1000000  // boot rate, CMD_SET_BAUD changes it at runtime
+#endif
+#define BAUD_MAX_ERR_PPM 40000  // 1 Mbaud itself is +3.8% at 27 MHz
 
-// ---------------- GNG parameters (Fritzke) ----------------
-#define GNG_LAMBDA      100
-#define GNG_EPSILON_B   0.3f
-#define GNG_EPSILON_N   0.001f
-#define GNG_ALPHA       0.5f
-#define GNG_A_MAX       50
-#define GNG_D           0.995f
+#ifndef SNAPSHOT_SDI
+#define SNAPSHOT_SDI    0  // 1 = snapshot frames on SDI (SPI slave) instead of UART
+#endif
+
+#ifndef GNG_CFS
+#define GNG_CFS         1  // 0 = software-only backend (CPU winner search)
+#endif
+
+// GNG parameters (GNG_LAMBDA, GNG_EPSILON_B, ...) and GNG_FIXED: gng_core.h
 
 // ---------------- Limits ----------------
-#define MAXPTS        100
-#define MAX_NODES      20
-#define MAX_EDGES_FULL ((MAX_NODES * (MAX_NODES - 1)) / 2)
+#define MAXPTS       (1000 / GNG_WORDS)  // dataset upload limit (4 * GNG_WORDS bytes per sample)
+#ifndef MAX_NODES
+#define MAX_NODES      20  // make MAX_NODES=N / preset.mk
+#endif
 
 // ---------------- CPU clock (for Processing conversion) ----------------
 #define CPU_HZ 27000000u
@@ -60,22 +527,414 @@
 #define CMD_DATA_BATCH  0x01u
 #define CMD_DONE        0x02u
 #define CMD_RUN         0x03u
+#define CMD_STREAM      0x04u
+#define CMD_SET_BAUD    0x05u
+#define CMD_SNAP_MODE   0x06u
+#define CMD_TRAIN_MODE  0x07u
+#define CMD_CKPT        0x08u
+#define CMD_SD          0x09u
+#define CMD_SET_PARAMS  0x0Au
+#define CMD_MODEL       0x0Bu
+#define CMD_QUERY       0x0Cu
+#define CMD_CONVERGE    0x0Du
+#define CMD_CFS_PERF    0x0Eu
+#define CMD_TRACE       0x0Fu
 #define CMD_GNG_NODES   0x10u
 #define CMD_GNG_EDGES   0x11u
 #define CMD_PROF        0x12u
+#define CMD_GNG_DELTA   0x13u
+#define CMD_GNG_EDGES_CHUNK 0x14u
+#define CMD_CREDIT      0x15u
+#define CMD_BAUD_ACK    0x16u
+#define CMD_GNG_EDGES_BITMAP 0x17u
+#define CMD_CKPT_ACK    0x18u
+#define CMD_SD_ACK      0x19u
+#define CMD_PARAMS_ACK  0x1Au
+#define CMD_MODEL_ACK   0x1Bu
+#define CMD_PROF_AGG    0x1Cu
+#define CMD_QUERY_ACK   0x1Du
+#define CMD_GNG_COMPONENTS 0x1Eu
+#define CMD_CONVERGED   0x1Fu
+#define CMD_GNG_REMAP   0x20u
+#define CMD_CFS_PERF_ACK 0x21u
+#define CMD_TRACE_DATA  0x22u
+#define CMD_LINK        0x23u
+#define CMD_LINK_ACK    0x24u
+#define CMD_STATS       0x25u
+#define CMD_STATS_FRAME 0x26u
+#define CMD_SEED        0x27u
+#define CMD_SEED_ACK    0x28u
+#define CMD_GEN         0x29u
+#define CMD_GEN_ACK     0x2Au
+#define CMD_EVAL        0x2Bu
+#define CMD_EVAL_ACK    0x2Cu
+
+// CMD_LINK ops and RX framings
+#define LINK_OP_STATS   0u
+#define LINK_OP_LEGACY  1u
+#define LINK_OP_COBS    2u
+#define LINK_OP_PAD     3u
+#define LINK_OP_CLEAR   0x80u
+#define RX_FRAMING_FF   0u
+#define RX_FRAMING_COBS 1u
 
 #define STREAM_EVERY_N  100  // stream every N steps
+#ifndef STREAM_KEYFRAME_EVERY
+#define STREAM_KEYFRAME_EVERY 20  // full NODES/EDGES every N stream frames
+#endif
+#define STREAM_DELTA_TH        2  // node resend threshold (wire units, 1/1000)
+
+// Snapshot triggers (CMD_SNAP_MODE), defaults = old fixed STREAM_EVERY_N
+#define SNAP_TRIG_EVERY  0x01u
+#define SNAP_TRIG_TOPO   0x02u
+#define SNAP_TRIG_QE     0x04u
+#define SNAP_TRIG_TIME   0x08u
+#define SNAP_TRIG_AUTO   0x10u
+#define SNAP_MIN_GAP       10  // steps between event-triggered snapshots
+#define SNAP_QE_PCT        10  // QE drop that triggers a snapshot
+#define SNAP_PERIOD_MS    100  // SNAP_TRIG_TIME interval
+#define SNAP_IO_PCT        10  // SNAP_TRIG_AUTO: snapshot share of the cycles, %
+#define SNAP_AUTO_MIN      10  // SNAP_TRIG_AUTO interval limits, steps
+#define SNAP_AUTO_MAX   50000
+
+// convergence stop (CMD_CONVERGE)
+#ifndef GNG_CONVERGE
+#define GNG_CONVERGE    1
+#endif
+#define CONV_OFF        0u
+#define CONV_NOTIFY     1u
+#define CONV_STOP       2u
+#define CONV_WINDOW    4000  // steps per window
+#define CONV_QE_PCT       3  // mean QE change of a quiet window, %
+#define CONV_CHURN      250  // topology changes per 1000 steps of a quiet window
+#define CONV_WINDOWS      3  // quiet windows in a row
+#define QE_EMA_SHIFT        8  // QE EMA over ~256 steps
+
+// 1 = TX/RX rings served by UART0 IRQ, 0 = blocking neorv32_uart0_putc/getc()
+// (the host build, gng_host/fwhost)
+#ifndef UART_TX_IRQ
+#define UART_TX_IRQ     1
+#endif
+#define UART_TX_RING    1024 // bytes, power of two
+#define UART_RX_RING    1024 // bytes, power of two (>= one credit window)
+
+// idle sleep: wfi in the main loop while there is nothing to train, the UART
+// IRQ (RX byte, TX ring drained) wakes it; the CFS engine clock is gated meanwhile
+#ifndef GNG_IDLE_WFI
+#define GNG_IDLE_WFI    1
+#endif
+#if GNG_IDLE_WFI && !UART_TX_IRQ
+#error "GNG_IDLE_WFI needs UART_TX_IRQ (RX by interrupt)"
+#endif
+
+// Streaming dataset ring (CMD_STREAM)
+#define STREAM_RING          (256 >> GNG_DIST_SHIFT) // samples, power of two (1 KB of words)
+#define STREAM_CREDIT_CHUNK  (STREAM_RING / 4) // credits are returned in steps of this size
 
 // Old edge streaming header = 2 bytes: [frame_id][count]
 // => 2 + 2*count <= 255 => count <= 126
 #define MAX_EDGE_PAIRS_PER_FRAME 126
 
-// ---------------- Lazy decay control ----------------
-#define GNG_D_INV (1.0f / GNG_D)
-// renorm threshold; 1e6 kira-kira renorm setiap ~2.7k step utk D=0.995
-#define ERR_INV_RENORM_TH  1.0e6f
+// Chunked edges: 7 header bytes, 8-bit ids unless MAX_NODES > 256
+#define EDGE_ID16             (MAX_NODES > 256)
+#define EDGE_CHUNK_HDR        7
+#define EDGE_PAIRS_PER_CHUNK  ((255 - EDGE_CHUNK_HDR) / (EDGE_ID16 ? 4 : 2))
+
+// Bitmap / gap-coded edges: smaller of list, bitmap, gap code is sent
+#ifndef EDGE_PACKED
+#define EDGE_PACKED           1  // 0 = pair lists only (hosts without 0x17)
+#endif
+#define EDGE_BM_HDR           3
+#define EDGE_BM_BYTES         ((MAX_EDGES_FULL + 7) / 8)
+#define EDGE_BM_FITS          (EDGE_BM_HDR + EDGE_BM_BYTES <= 255)
+#define EDGE_GAP_ESC          255u
+
+// ---------------- CFS backend config ----------------
+// 1 = wait for CFS DONE interrupt (overlap work), 0 = busy-poll CTRL.DONE
+#define CFS_USE_IRQ        1
+
+// 1 = write the next sample while the CFS searches (double-buffered bitstreams)
+#ifndef CFS_PRELOAD
+#define CFS_PRELOAD        1
+#endif
+
+// 1 = CMD_CFS_PERF reads the CFS perf counters (bitstreams with INFO bit 26)
+#ifndef CFS_PERF
+#define CFS_PERF           1
+#endif
+
+// CMD_STATS_FRAME interval at boot, ms (0 = only on CMD_STATS)
+#ifndef STATS_MS
+#define STATS_MS           0
+#endif
+
+// 1 = CMD_TRACE captures steps with neorv32_tracer (tang_nano_9k.vhd CPU_TRACER > 0)
+#ifndef GNG_TRACE
+#define GNG_TRACE          0
+#endif
+
+// 0 = one CFS search per step (exact), N = batched searches (1..CFS_SMP_DEPTH)
+#define CFS_BATCH_N        0
+#define CFS_SMP_DEPTH      32
+
+// 1 = the CFS moves s1 and its neighbors after the search (bitstream CFS_MOVE)
+#ifndef GNG_CFS_MOVE
+#define GNG_CFS_MOVE       0
+#endif
+
+// 1 = keyframes from the CFS framer when the bitstream has one (CFS_DUMP)
+#ifndef GNG_CFS_DUMP
+#define GNG_CFS_DUMP       1
+#endif
+#if SNAPSHOT_SDI || MAX_NODES > 50
+#undef  GNG_CFS_DUMP
+#define GNG_CFS_DUMP       0  // frames not on UART0 / more nodes than one NODES frame
+#endif
+
+#if !GNG_CFS
+#undef  GNG_CFS_MOVE
+#define GNG_CFS_MOVE       0
+#undef  GNG_CFS_DUMP
+#define GNG_CFS_DUMP       0
+#undef  CFS_USE_IRQ
+#define CFS_USE_IRQ        0
+#undef  CFS_BATCH_N
+#define CFS_BATCH_N        0
+#undef  CFS_PRELOAD
+#define CFS_PRELOAD        0
+#undef  CFS_PERF
+#define CFS_PERF           0
+#endif
+
+// node field widths of python -m gngio precision (make LAYOUT=gng_layout.h):
+// GNG_POS_BITS, GNG_ERR_BITS, GNG_AGE_BITS, GNG_MAX_DEGREE, GNG_POS16
+#ifdef GNG_LAYOUT_FILE
+#include GNG_LAYOUT_FILE
+#endif
+
+// ---------------- GNG core (gng_core/) ----------------
+#define GNG_PROFILE     1
+#define GNG_CYCLES()    neorv32_cpu_csr_read(CSR_MCYCLE)
+#ifndef GNG_PARAMS_RT
+#define GNG_PARAMS_RT   1  // CMD_SET_PARAMS; 0 = the gng_core.h constants only
+#endif
+#ifndef GNG_COMPONENTS
+#define GNG_COMPONENTS  1  // g_comp[] labels, CMD_GNG_COMPONENTS, CMD_QUERY labels
+#endif
+#ifndef GNG_GRID_BITS
+#define GNG_GRID_BITS   0  // 3x3-cell candidate mask per CFS search (2^b x 2^b grid)
+#endif
+#ifndef GNG_UTILITY
+#define GNG_UTILITY     1  // GNG-U eviction at MAX_NODES instead of no insertion
+#endif
+#ifndef GNG_DRIFT
+#define GNG_DRIFT       1  // QE-triggered boost of rates / insertion / aging
+#endif
+#ifndef GNG_COMPACT
+#define GNG_COMPACT     1  // periodic dense renumbering, CMD_GNG_REMAP
+#endif
+#ifndef GNG_ERR_BFP
+#define GNG_ERR_BFP     GNG_FIXED  // shared error exponent: O(1) renorm, no division
+#endif
+#define COMPACT_EVERY  1000  // steps between two checks
+#define COMPACT_SLACK     2  // holes below the span that start a compaction
+#define COMPACT_MAX     126  // moves per CMD_GNG_REMAP frame
+#if GNG_CFS_MOVE && !defined(GNG_POS16)
+#define GNG_POS16       1  // node_mem words are the positions
+#endif
+
+#if GNG_CFS
+#include "gng_cfs.h"      // CFS winner search, dirty-node flush, DMA sync
+#else
+#include "gng_core.h"
+#endif
+#include "gng_dbl.h"      // DBL-GNG epochs (CMD_TRAIN_MODE)
+
+#if GNG_DIM > 2
+#undef  GNG_GEN
+#define GNG_GEN         0  // the generators draw x / y only
+#endif
+#if GNG_DIM > 2 && CFS_BATCH_N > 0
+#error "CFS_BATCH_N: the CFS sample FIFO holds 2D words, GNG_DIM must be 2"
+#endif
+#if GNG_CFS_MOVE && CFS_BATCH_N > 0
+#error "GNG_CFS_MOVE: batch scans do not move, set CFS_BATCH_N to 0"
+#endif
+#define SMP_WIRE_BYTES  (2 * GNG_DIM)  // CMD_DATA_BATCH bytes per sample
+
+// per-phase interval statistics (CMD_PROF_AGG), next to the last-step PROF
+#ifndef GNG_PROF_AGG
+#define GNG_PROF_AGG    1
+#endif
+#define PROF_AGG_MS     500  // interval of one CMD_PROF_AGG set (at a snapshot)
+
+#if GNG_PROF_AGG
+#include "gng_prof.h"     // g_prof_agg: count / min / max / sum / log2 histogram
+#else
+static inline void gng_prof_commit(void) { }
+static inline void gng_prof_agg_reset(void) { }
+#endif
 
-enum { RX_WAIT_H1=0, RX_WAIT_H2, RX_WAIT_CMD, RX_WAIT_LEN, RX_WAIT_PAYLOAD, RX_WAIT_CHK };
+// CFS parameter registers beyond gng_cfs.h (neorv32_cfs.vhd, RW, Q16 rates,
+// CFS_REG_EPS_B / CFS_REG_EPS_N = 4 / 5 there); the winner engine does not
+// read them, they mirror what the CPU step uses (the move unit reads the EPS
+// pair, cfs_start_move() writes the step rates)
+#define CFS_REG_LAMBDA  2
+#define CFS_REG_A_MAX   3
+#define CFS_REG_ALPHA   6
+#define CFS_REG_D       7
+
+// ---------------- User flash checkpoint (CMD_CKPT) ----------------
+#ifndef GNG_CKPT
+#define GNG_CKPT        1  // 0 = no checkpoints (board without Gowin user flash)
+#endif
+
+#if GNG_CKPT
+#include "gng_ckpt.h"     // record format + CRC
+
+// uflash.vhd on the XBUS: 38 pages of 2048 bytes from 0, see bootloader/main.c
+#define UFLASH_BASE_ADDR  0x00000000u
+#define UFLASH_PAGE_SIZE  2048u
+#define UFLASH_NUM_PAGES  38u
+#ifndef UFLASH_ROM_KB
+#define UFLASH_ROM_KB     56u  // = __neorv32_rom_size, makefile ROM_KB
+#endif
+
+#define CKPT_SLOT_PAGES   ((GNG_CKPT_WORDS * 4u + UFLASH_PAGE_SIZE - 1u) / UFLASH_PAGE_SIZE)
+#define CKPT_PAGE0        (UFLASH_NUM_PAGES - 2u * CKPT_SLOT_PAGES)
+#if CKPT_PAGE0 * UFLASH_PAGE_SIZE < UFLASH_ROM_KB * 1024u
+#error "checkpoint slots overlap the image: lower ROM_KB or MAX_NODES, or GNG_CKPT=0"
+#endif
+
+#define CKPT_SAVE  0u
+#define CKPT_LOAD  1u
+#define CKPT_ERASE 2u
+#endif
+
+// ---------------- Time-sliced models (CMD_MODEL) ----------------
+#ifndef GNG_MODELS
+#define GNG_MODELS      1  // independent GNG instances, make GNG_MODELS=N / preset.mk
+#endif
+#if GNG_MODELS < 1 || GNG_MODELS > 8
+#error "GNG_MODELS must be 1..8 (CFS REG_CTX is 3 bits)"
+#endif
+
+// ---------------- Shuffled passes (CMD_TRAIN_MODE order) ----------------
+#ifndef GNG_SHUFFLE
+#define GNG_SHUFFLE     1  // dataQ in a new permuted order every pass
+#endif
+#ifndef SHUFFLE_SEED
+#define SHUFFLE_SEED    0x5EEDu
+#endif
+
+#if GNG_SHUFFLE
+#include "gng_perm.h"     // Feistel bijection of [0, n), keyed per pass
+#endif
+
+// ---------------- On-board generators (CMD_GEN) ----------------
+#ifndef GNG_GEN
+#define GNG_GEN         1  // CMD_GEN synthetic streams (2D only)
+#endif
+#ifndef GEN_SEED
+#define GEN_SEED        0x6E6Eu  // seed 0 without a TRNG
+#endif
+#if GNG_GEN
+#include "gng_gen.h"      // two moons / circles / mixture / uniform in Q1.15
+#endif
+#define ORDER_UPLOAD    0u
+#define ORDER_SHUFFLE   1u
+
+#if GNG_MODELS > 1
+#include "gng_ctx.h"      // parked copies of the gng_core.h state
+
+#define MODEL_SLICE     64  // default steps per turn
+#define MODEL_OP_RUN    0u
+#define MODEL_OP_DATA   1u
+#define MODEL_OP_VIEW   2u
+#define MODEL_OP_HIER   3u
+#if GNG_MODELS > 2
+#define HIER_FINE       (GNG_MODELS - 1)  // fine models 1.. under coarse model 0
+#ifndef HIER_Q
+#define HIER_Q          16  // routed samples a fine model collects per turn
+#endif
+#endif
+#endif
+
+// ---------------- Query service (CMD_QUERY) ----------------
+#define QRY_RING        2  // buffered queries, power of two
+#define QRY_HDR         2  // [seq][flags]
+#define QRY_LABEL    0x01u // flags: connected component of s1
+#define QRY_ACK_HDR     3  // [seq][first][n]
+#define QRY_ACK_REC     6  // [s1][label][min1 u32]
+#define QRY_ACK_MAX   ((255 - QRY_ACK_HDR) / QRY_ACK_REC)
+
+// ---------------- Evaluation sweep (CMD_EVAL) ----------------
+#define EVAL_GEN_N      1024u         // generator samples per sweep
+#define EVAL_GEN_BASE   0x80000000u   // their stream indices (held out)
+
+// ---------------- Network seed (CMD_SEED) ----------------
+#define SEED_OP_BEGIN   0u
+#define SEED_OP_NODES   1u
+#define SEED_OP_EDGES   2u
+#define SEED_OP_COMMIT  3u
+#define SEED_EDGES      (3 * MAX_NODES)  // staged edges (a 2D GNG stays near planar)
+
+// dual-hart split (GNG_SMP=1, tang_nano_9k.vhd CPU_DUAL_CORE=true)
+#ifndef GNG_SMP
+#define GNG_SMP         0  // 1 = hart 0 trains, hart 1 does RX, snapshot encoding and TX
+#endif
+
+#if GNG_SMP
+#if SD_CARD
+#error "GNG_SMP: the TF card is not shared between the harts, build with SD_CARD=0"
+#endif
+#undef  GNG_CFS_DUMP
+#define GNG_CFS_DUMP    0  // hart 1 encodes a copy, node_mem is ahead of it
+#define SMP_STACK       2048 // hart 1 stack, bytes
+#define SMP_XQ_RING      512 // hart 0 -> hart 1 TX bytes (credits, ACKs, text), power of two
+#define SMP_CMD_RING       8 // command frames hart 1 -> hart 0, power of two
+#define SMP_CMD_MAX       48 // payload bytes per queued command (CMD_SET_PARAMS: 44)
+#define SMP_SHARED  volatile // written by one hart, read by the other
+#else
+#define SMP_SHARED
+#endif
+
+// ---------------- TF card (CMD_SD) ----------------
+#ifndef SD_CARD
+#define SD_CARD         0  // 1 = card samples / frame log, makefile SD_CARD (needs SPI)
+#endif
+
+#if SD_CARD
+#if GNG_DIM > 2
+#error "SD_CARD: GNGDATA.BIN samples are x, y pairs, GNG_DIM must be 2"
+#endif
+#include <pff.h>          // Petit FatFs of the bootloader, SPI CS = config.h SPI_SDCARD_CS
+
+#define SD_DATA_FILE      "GNGDATA.BIN" // samples as in CMD_DATA_BATCH: x, y int16 LE (1/1000)
+#define SD_LOG_FILE       "GNGLOG.BIN"  // preallocated, Petit FatFs cannot grow a file
+#define SD_SECTOR         512u
+#define SD_SMP_PER_SECTOR (SD_SECTOR / 4u)
+#define SD_LOG_MAGIC      0x4C474E47u   // "GNGL", log header in sector 0
+#define SD_LOG_VERSION    1u
+#define SD_SPI_INIT_PRSC  CLK_PRSC_64   // card init below 400 kHz: 27 MHz / 128
+#define SD_SPI_PRSC       CLK_PRSC_2    // after the mount: 27 MHz / 4
+#ifndef SD_AUTORUN
+#define SD_AUTORUN        1  // at boot: train from SD_DATA_FILE (and log) if the card has it
+#endif
+#define SD_AUTORUN_PASSES 1
+
+#define SD_OP_STOP   0u
+#define SD_OP_TRAIN  1u
+#define SD_OP_LOG    2u
+#define SD_OK        0u
+#define SD_ERR_CARD  1u   // no SPI / no card / no FAT32
+#define SD_ERR_DATA  2u   // SD_DATA_FILE missing, empty or unreadable
+#define SD_ERR_LOG   3u   // SD_LOG_FILE missing or too small
+#endif
+
+// RX_WAIT_END: COBS framing, frame done or damaged, bytes up to the next 00 are dropped
+enum { RX_WAIT_H1=0, RX_WAIT_H2, RX_WAIT_CMD, RX_WAIT_LEN, RX_WAIT_PAYLOAD, RX_WAIT_BATCH, RX_WAIT_CHK,
+       RX_WAIT_END };
 
 static uint8_t  rx_state = RX_WAIT_H1;
 static uint8_t  rx_cmd   = 0;
@@ -84,68 +943,49 @@ static uint8_t  rx_index = 0;
 static uint8_t  rx_sum   = 0;
 static uint8_t  rx_payload[256];
 
+// CMD_LINK: framing and counters (RX side, hart 1 with GNG_SMP)
+static uint8_t  rx_framing = RX_FRAMING_FF;
+static uint8_t  cobs_left  = 0;      // data bytes left in the current COBS group
+static bool     cobs_zero  = false;  // the group ends in an encoded 0x00
+static uint32_t g_rx_ok = 0, g_rx_bad = 0, g_rx_skip = 0;
+static uint32_t g_rx_lost = 0;       // dataset samples beyond MAXPTS
+
 // Dataset
-static float dataX[MAXPTS];
-static float dataY[MAXPTS];
-static int   dataCount = 0;
+static sample_t dataQ[MAXPTS];
+static SMP_SHARED int dataCount = 0;
 static bool  dataDone  = false;
 static bool  running   = false;
 
-// Node CPU struct (full CPU GNG)
-typedef struct {
-  float x, y;
-  float error;   // NOTE: scaled error under lazy decay
-  bool  active;
-} Node;
-
-static Node nodes[MAX_NODES];
+// Streaming samples: filled by handleCommand, popped by training
+static bool     g_stream = false;
+static sample_t smp_q[STREAM_RING];
+static SMP_SHARED uint32_t smp_head = 0; // written by RX (GNG_SMP: hart 1)
+static SMP_SHARED uint32_t smp_tail = 0; // written by training (hart 0)
+static uint32_t smp_granted = 0;   // samples the host has been allowed to send
+static uint32_t g_smp_dropped = 0; // sent beyond the credit (ring full)
 
-// Degree counter: number of active edges incident to each node
-static uint8_t degree[MAX_NODES];
-
-static int stepCount = 0;
 static int dataIndex = 0;
 static uint8_t frame_id = 0;
-static bool g_has_cfs = false;
-
-// global scaling for lazy decay: g_err_inv = 1/(D^k) since last renorm
-static float g_err_inv = 1.0f;
-
-// ============================ CFS REG MAP (match VHDL) ============================
-#define CFS_REG_CTRL       0
-#define CFS_REG_XIN        8
-#define CFS_REG_YIN        9
-#define CFS_REG_NODE_COUNT 10
-#define CFS_REG_ACT_LO     11
-#define CFS_REG_ACT_HI     12
-#define CFS_REG_OUT_S12    13
-#define CFS_REG_OUT_MIN1   14
-#define CFS_REG_OUT_MIN2   15
-
-#define CFS_NODE_BASE      128
 
-#define CFS_CTRL_CLEAR     (1u << 0)
-#define CFS_CTRL_START     (1u << 1)
-#define CFS_STATUS_BUSY    (1u << 16)
-#define CFS_STATUS_DONE    (1u << 17)
+// Training mode (CMD_TRAIN_MODE)
+#define TRAIN_ONLINE 0u
+#define TRAIN_DBL    1u
+static uint8_t  train_mode = TRAIN_ONLINE;
+static uint32_t g_epochs = 0;  // DBL epochs run
+static uint32_t g_passes = 0;  // online passes over dataQ (the live model's section)
+#if GNG_SHUFFLE
+static uint8_t    train_order = ORDER_SHUFFLE;
+static gng_perm_t g_perm;      // order of pass g_passes
+#endif
 
-// ============================ EDGE storage (Half adjacency matrix) ================
-static uint8_t edge_cell[MAX_EDGES_FULL];
+// the order of a new pass (or of the model that just became live)
+static inline void pass_rekey(void) {
+#if GNG_SHUFFLE
+  gng_perm_key(&g_perm, SHUFFLE_SEED, g_passes);
+#endif
+}
 
-// ============================ PROF struct ========================================
-typedef struct {
-  uint32_t cyc_total;
-  uint32_t cyc_winner;     // cfs_find_winners
-  uint32_t cyc_move_w;     // move winner
-  uint32_t cyc_nb;         // age edges + move neighbors
-  uint32_t cyc_connect;    // connectOrResetEdge
-  uint32_t cyc_delete;     // deleteOldEdgesFromWinner
-  uint32_t cyc_prune;      // pruneIsolatedNodes_degree
-  uint32_t cyc_insert;     // insertNode_fritzke (only when called)
-  uint32_t cyc_renorm;     // error_renorm_if_needed (only when renorm)
-} Prof;
-
-static Prof g_prof = {0};
+static uint32_t g_idle_ticks = 0; // CLINT ticks asleep in idle_wait, total (PROF idle)
 
 // ============================ Cycle read (64-bit) ================================
 static inline uint64_t rdcycle64(void) {
@@ -158,237 +998,446 @@ static inline uint64_t rdcycle64(void) {
   return ((uint64_t)hi0 << 32) | (uint64_t)lo;
 }
 
-// ============================ Utility ===========================================
-static inline float dist2(float x1, float y1, float x2, float y2) {
-  float dx = x1 - x2;
-  float dy = y1 - y2;
-  return dx*dx + dy*dy;
+static inline void wr_u32_le(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xFFu);
+  p[1] = (uint8_t)((v >> 8) & 0xFFu);
+  p[2] = (uint8_t)((v >> 16) & 0xFFu);
+  p[3] = (uint8_t)((v >> 24) & 0xFFu);
+}
+
+// ============================ UART TX ===========================================
+static uint32_t g_tx_stall = 0; // cycles blocked on a full TX ring since last PROF
+
+#if UART_TX_IRQ
+static uint8_t           tx_ring[UART_TX_RING];
+static volatile uint32_t tx_head = 0; // written by main
+static volatile uint32_t tx_tail = 0; // written by ISR
+
+static uint8_t           rx_ring[UART_RX_RING];
+static volatile uint32_t rx_head = 0; // written by ISR
+static volatile uint32_t rx_tail = 0; // written by main
+
+#if GNG_SMP
+// hart 0 -> hart 1: whole frames / text lines, hart 1 moves them into tx_ring
+static uint8_t           xq_ring[SMP_XQ_RING];
+static volatile uint32_t xq_head = 0; // published by hart 0 (uart_tx_end)
+static volatile uint32_t xq_tail = 0; // written by hart 1
+static uint32_t          xq_wr   = 0; // hart 0 write position, ahead of xq_head
+
+static inline bool on_io_hart(void) { return neorv32_cpu_csr_read(CSR_MHARTID) != 0; }
+
+static inline void xq_put(uint8_t b) {
+  while ((xq_wr - xq_tail) >= SMP_XQ_RING) { }
+  xq_ring[xq_wr & (SMP_XQ_RING - 1u)] = b;
+  xq_wr++;
 }
+#endif
+
+// UART0 FIRQ: RX FIFO -> rx_ring (drop on full ring);
+// TX FIFO empty -> refill from the ring, mask itself when drained
+static void uart0_irq_handler(void) {
+  uint32_t h = rx_head;
+  while (NEORV32_UART0->CTRL & (1u << UART_CTRL_RX_NEMPTY)) {
+    uint8_t b = (uint8_t)NEORV32_UART0->DATA;
+    if ((h - rx_tail) < UART_RX_RING) rx_ring[(h++) & (UART_RX_RING - 1u)] = b;
+  }
+  rx_head = h;
 
-static inline uint16_t float_to_q15_pos(float v) {
-  if (v <= 0.0f) return 0;
-  if (v >= 0.9999694824f) return 0x7FFF;
-  int32_t q = (int32_t)(v * 32768.0f + 0.5f);
-  if (q > 0x7FFF) q = 0x7FFF;
-  return (uint16_t)q;
+  uint32_t t = tx_tail;
+  while ((t != tx_head) && (NEORV32_UART0->CTRL & (1u << UART_CTRL_TX_NFULL))) {
+    NEORV32_UART0->DATA = (uint32_t)tx_ring[t & (UART_TX_RING - 1u)];
+    t++;
+  }
+  tx_tail = t;
+  if (t == tx_head) NEORV32_UART0->CTRL &= ~(1u << UART_CTRL_IRQ_TX_EMPTY);
 }
 
-static inline uint32_t pack_node_q15(float x, float y) {
-  uint16_t xq = float_to_q15_pos(x);
-  uint16_t yq = float_to_q15_pos(y);
-  return ((uint32_t)xq) | (((uint32_t)yq) << 16);
+static void uart_tx_setup(void) {
+  neorv32_rte_handler_install(UART0_TRAP_CODE, uart0_irq_handler);
+  NEORV32_UART0->CTRL |= (1u << UART_CTRL_IRQ_RX_NEMPTY);
+  neorv32_cpu_csr_set(CSR_MIE, 1 << UART0_FIRQ_ENABLE);
+  neorv32_cpu_csr_set(CSR_MSTATUS, 1 << CSR_MSTATUS_MIE);
 }
 
-static inline float q30_to_float(uint32_t q30) {
-  return (float)q30 / 1073741824.0f; // 2^30
+static inline void uart_tx_put(uint8_t b) {
+#if GNG_SMP
+  if (!on_io_hart()) { xq_put(b); return; }
+#endif
+  uint32_t h = tx_head;
+  if ((h - tx_tail) >= UART_TX_RING) {
+    uint64_t t0 = rdcycle64();
+    while ((h - tx_tail) >= UART_TX_RING) { }
+    g_tx_stall += (uint32_t)(rdcycle64() - t0);
+  }
+  tx_ring[h & (UART_TX_RING - 1u)] = b;
+  tx_head = h + 1u;
 }
 
-static int findFreeNode(void) {
-  for (int i = 0; i < MAX_NODES; i++) if (!nodes[i].active) return i;
-  return -1;
+// bytes not yet in the UART0 FIFO / handed to it since boot (wraps)
+static inline uint32_t uart_tx_queued(void) {
+#if GNG_SMP
+  return (tx_head - tx_tail) + (xq_wr - xq_tail);
+#else
+  return tx_head - tx_tail;
+#endif
 }
 
-// edge index for i<j
-static inline int edge_index_ij(int i, int j) {
-  // ASSUME i < j
-  return (i * (2*MAX_NODES - i - 1)) / 2 + (j - i - 1);
+static inline uint32_t uart_tx_sent(void) { return tx_tail; }
+
+// (re)arm the TX-empty IRQ after queueing; the ISR disarms when drained
+static inline void uart_tx_kick(void) {
+#if GNG_SMP
+  if (!on_io_hart()) return; // UART0 CTRL belongs to hart 1
+#endif
+  NEORV32_UART0->CTRL |= (1u << UART_CTRL_IRQ_TX_EMPTY);
 }
 
-// general index with swap
-static inline int edge_index(int i, int j) {
-  if (i == j) return -1;
-  if (i > j) { int t=i; i=j; j=t; }
-  return edge_index_ij(i, j);
+static inline bool uart_rx_get(uint8_t *b) {
+  uint32_t t = rx_tail;
+  if (t == rx_head) return false;
+  *b = rx_ring[t & (UART_RX_RING - 1u)];
+  rx_tail = t + 1u;
+  return true;
 }
+#else
+static uint32_t g_tx_sent = 0;
 
-static void edges_init_full(void) {
-  for (int i = 0; i < MAX_EDGES_FULL; i++) edge_cell[i] = 0;
-  for (int i = 0; i < MAX_NODES; i++) degree[i] = 0;
+static inline void uart_tx_put(uint8_t b) {
+  neorv32_uart0_putc((char)b);
+  g_tx_sent++;
 }
 
-// Lazy decay renormalization: keep g_err_inv bounded
-static inline bool error_renorm_if_needed(void) {
-  if (g_err_inv <= ERR_INV_RENORM_TH) return false;
+static inline uint32_t uart_tx_queued(void) { return 0; }
+static inline uint32_t uart_tx_sent(void) { return g_tx_sent; }
 
-  float g = 1.0f / g_err_inv;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-    nodes[i].error *= g;
-  }
-  g_err_inv = 1.0f;
+static inline void uart_tx_kick(void) { }
+
+static inline bool uart_rx_get(uint8_t *b) {
+  if (!neorv32_uart0_char_received()) return false;
+  *b = (uint8_t)neorv32_uart0_getc();
   return true;
 }
+#endif
 
-// Connect/reset (age=0 encoded as 1). If previously disconnected, increment degree.
-static inline void connectOrResetEdge(int a, int b) {
-  int ei = edge_index(a, b);
-  if (ei < 0) return;
+#if GNG_SMP
+static inline void smp_fence(void) { asm volatile ("fence" ::: "memory"); }
 
-  bool was_conn = (edge_cell[ei] != 0);
-  edge_cell[ei] = 1; // age=0 -> store 1
+// end of a frame / text line: hart 0 hands it to hart 1 in one piece
+static inline void uart_tx_end(void) {
+  if (on_io_hart()) return;
+  smp_fence();
+  xq_head = xq_wr;
+}
 
-  if (!was_conn) {
-    if (degree[a] < 255u) degree[a]++;
-    if (degree[b] < 255u) degree[b]++;
-  }
+// hart 1: queue what hart 0 has published, between two of its own frames
+static void xq_drain(void) {
+  uint32_t t = xq_tail;
+  const uint32_t h = xq_head;
+  if (t == h) return;
+  smp_fence();
+  for (; t != h; t++) uart_tx_put(xq_ring[t & (SMP_XQ_RING - 1u)]);
+  xq_tail = t;
+  uart_tx_kick();
+}
+#else
+static inline void smp_fence(void) { }
+static inline void uart_tx_end(void) { }
+#endif
+
+static void uart_tx_puts(const char *str) {
+  while (*str) uart_tx_put((uint8_t)*str++);
+  uart_tx_kick();
+  uart_tx_end();
 }
 
-// Remove edge. If previously connected, decrement degree.
-static inline void removeEdgePair(int a, int b) {
-  int ei = edge_index(a, b);
-  if (ei < 0) return;
+static void uart_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  uint8_t sum = (uint8_t)(cmd + len);
+  for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
+  uint8_t chk = (uint8_t)(~sum);
 
-  bool was_conn = (edge_cell[ei] != 0);
-  edge_cell[ei] = 0;
+  uart_tx_put(UART_HDR);
+  uart_tx_put(UART_HDR);
+  uart_tx_put(cmd);
+  uart_tx_put(len);
+  uart_tx_kick(); // start sending while the payload is still being queued
+  for (uint8_t i = 0; i < len; i++) uart_tx_put(payload[i]);
+  uart_tx_put(chk);
+  uart_tx_kick();
+  uart_tx_end();
+}
 
-  if (was_conn) {
-    if (degree[a] > 0u) degree[a]--;
-    if (degree[b] > 0u) degree[b]--;
+#if SNAPSHOT_SDI
+// same frame on the SDI TX FIFO; spins (counted in g_tx_stall) while full
+static inline void sdi_put(uint8_t b) {
+  if (neorv32_sdi_put_nonblocking(b) != 0) {
+    uint64_t t0 = rdcycle64();
+    while (neorv32_sdi_put_nonblocking(b) != 0) { }
+    g_tx_stall += (uint32_t)(rdcycle64() - t0);
   }
 }
 
-// ============================ COMBINED: age edges + move neighbors (winner-only) ==
-static inline void age_edges_and_move_neighbors(int s1, float x, float y) {
-  // i < s1  --> edge(i, s1)
-  for (int i = 0; i < s1; i++) {
-    if (!nodes[i].active) continue;
-
-    int ei = edge_index_ij(i, s1);
-    uint8_t v = edge_cell[ei];
-    if (v == 0) continue; // not a neighbor
+static void snap_wire_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  uint8_t sum = (uint8_t)(cmd + len);
+  for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
 
-    // age++ (cap at 255)
-    if (v < 255u) edge_cell[ei] = (uint8_t)(v + 1u);
+  sdi_put(UART_HDR);
+  sdi_put(UART_HDR);
+  sdi_put(cmd);
+  sdi_put(len);
+  for (uint8_t i = 0; i < len; i++) sdi_put(payload[i]);
+  sdi_put((uint8_t)(~sum));
+}
+#else
+#define snap_wire_frame uart_send_frame
+#endif
 
-    // move neighbor
-    nodes[i].x += GNG_EPSILON_N * (x - nodes[i].x);
-    nodes[i].y += GNG_EPSILON_N * (y - nodes[i].y);
-    NEORV32_CFS->REG[CFS_NODE_BASE + i] = pack_node_q15(nodes[i].x, nodes[i].y);
-  }
+#if SD_CARD
+// ============================ TF card frame log =================================
+// pff.c works on one open file (sd_fs); the other one waits in sd_alt and
+// the two are swapped around each log write. sd_fs = data file, sd_alt = log.
+static FATFS    sd_fs, sd_alt;
+static bool     sd_mounted = false;
+static bool     sd_log_open = false;
+static bool     sd_log = false;      // frames go to the log (false again when it is full)
+static bool     sd_tee = false;      // ... and to the wire as well
+static uint8_t  sd_logbuf[SD_SECTOR];
+static uint16_t sd_log_n = 0;
+static uint32_t sd_log_sectors = 0;  // frame sectors behind the header
+static uint32_t sd_samples = 0;      // samples trained from the card
 
-  // i > s1  --> edge(s1, i)
-  for (int i = s1 + 1; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
+static inline void sd_swap(void) { FATFS t = sd_fs; sd_fs = sd_alt; sd_alt = t; }
 
-    int ei = edge_index_ij(s1, i);
-    uint8_t v = edge_cell[ei];
-    if (v == 0) continue;
+// one whole sector at the log's file pointer, false when the file is full
+static bool sd_log_write(const uint8_t *buf) {
+  UINT bw = 0;
+  sd_swap();
+  FRESULT rc = pf_write(buf, SD_SECTOR, &bw);
+  sd_swap();
+  return (rc == FR_OK) && (bw == SD_SECTOR);
+}
 
-    if (v < 255u) edge_cell[ei] = (uint8_t)(v + 1u);
+// sector 0: magic, version, frame sectors (0 = not closed), card samples
+static bool sd_log_header(uint32_t sectors) {
+  for (uint32_t i = 0; i < SD_SECTOR; i++) sd_logbuf[i] = 0;
+  wr_u32_le(&sd_logbuf[0], SD_LOG_MAGIC);
+  wr_u32_le(&sd_logbuf[4], SD_LOG_VERSION);
+  wr_u32_le(&sd_logbuf[8], sectors);
+  wr_u32_le(&sd_logbuf[12], sd_samples);
+  return sd_log_write(sd_logbuf);
+}
 
-    nodes[i].x += GNG_EPSILON_N * (x - nodes[i].x);
-    nodes[i].y += GNG_EPSILON_N * (y - nodes[i].y);
-    NEORV32_CFS->REG[CFS_NODE_BASE + i] = pack_node_q15(nodes[i].x, nodes[i].y);
-  }
+// zero-padded (bytes outside frames), the wait counts as TX stall
+static void sd_log_sector(void) {
+  uint64_t t0 = rdcycle64();
+  while (sd_log_n < SD_SECTOR) sd_logbuf[sd_log_n++] = 0;
+  sd_log_n = 0;
+  if (sd_log_write(sd_logbuf)) sd_log_sectors++;
+  else sd_log = false;
+  g_tx_stall += (uint32_t)(rdcycle64() - t0);
 }
 
-// ============================ deleteOldEdgesFromWinner (two-loop) ================
-static void deleteOldEdgesFromWinner(int w) {
-  const uint8_t TH = (uint8_t)(GNG_A_MAX + 1); // encoded threshold
+static inline void sd_log_put(uint8_t b) {
+  sd_logbuf[sd_log_n++] = b;
+  if (sd_log_n == SD_SECTOR) sd_log_sector();
+}
 
-  // i < w
-  for (int i = 0; i < w; i++) {
-    int ei = edge_index_ij(i, w);
-    uint8_t v = edge_cell[ei];
-    if (v == 0) continue;
-    if (v > TH) {
-      edge_cell[ei] = 0;
-      if (degree[i] > 0u) degree[i]--;
-      if (degree[w] > 0u) degree[w]--;
-    }
-  }
-  // i > w
-  for (int i = w + 1; i < MAX_NODES; i++) {
-    int ei = edge_index_ij(w, i);
-    uint8_t v = edge_cell[ei];
-    if (v == 0) continue;
-    if (v > TH) {
-      edge_cell[ei] = 0;
-      if (degree[i] > 0u) degree[i]--;
-      if (degree[w] > 0u) degree[w]--;
-    }
+// same FF FF CMD LEN .. CHK bytes as on the wire
+static void sd_log_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  uint8_t sum = (uint8_t)(cmd + len);
+  sd_log_put(UART_HDR);
+  sd_log_put(UART_HDR);
+  sd_log_put(cmd);
+  sd_log_put(len);
+  for (uint8_t i = 0; i < len; i++) {
+    sd_log_put(payload[i]);
+    sum = (uint8_t)(sum + payload[i]);
   }
+  sd_log_put((uint8_t)(~sum));
 }
 
-// ============================ pruneIsolatedNodes (degree) ========================
-static void pruneIsolatedNodes_degree(void) {
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-    if (degree[i] == 0u) nodes[i].active = false;
+static void snap_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  if (sd_log) {
+    sd_log_frame(cmd, payload, len);
+    if (!sd_tee) return;
   }
+  snap_wire_frame(cmd, payload, len);
 }
+#else
+#define snap_send_frame snap_wire_frame
+#endif
 
-// ============================ Fritzke insertion (incident to q only) ==============
-static int insertNode_fritzke(void) {
-  int q = -1;
-  float maxErr = -1.0f;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (nodes[i].active && nodes[i].error > maxErr) {
-      maxErr = nodes[i].error;
-      q = i;
-    }
+// baud rate neorv32_uart_setup() really produces for 'baud' (same divider search)
+static uint32_t uart_baud_actual(uint32_t baud) {
+  static const uint16_t prsc[8] = {2, 4, 8, 64, 128, 1024, 2048, 4096};
+  uint32_t clk = neorv32_sysinfo_get_clk();
+  if (baud == 0) return 0;
+  uint32_t i = clk / (2u * baud);
+  uint32_t p = 0;
+  while (i >= 0x3FEu) {
+    i >>= ((p == 2) || (p == 4)) ? 3 : 1;
+    p++;
   }
-  if (q < 0) return -1;
+  if ((i == 0) || (p > 7)) return 0;
+  return clk / ((uint32_t)prsc[p] * i);
+}
 
-  int f = -1;
-  maxErr = -1.0f;
+#if GNG_PROF_AGG
+// ============================ Interval profile (CMD_PROF_AGG) ===================
+// Every PROF_AGG_MS (checked at the snapshots) the g_prof_agg interval goes
+// out as one frame per phase that ran, then restarts. With GNG_SMP hart 0
+// copies it into prof_agg_out for hart 1; while hart 1 has not sent the last
+// copy yet the interval just goes on.
+static uint64_t prof_agg_cyc = 0;  // hart 0: start of the interval
+#if GNG_SMP
+static gng_phase_agg_t prof_agg_out[GNG_PROF_PHASES];
+static volatile bool   prof_agg_full = false;
+#define PROF_AGG_SRC   prof_agg_out
+#else
+#define PROF_AGG_SRC   g_prof_agg
+#endif
 
-  // i < q -> edge(i,q)
-  for (int i = 0; i < q; i++) {
-    if (!nodes[i].active) continue;
-    int ei = edge_index_ij(i, q);
-    if (edge_cell[ei] == 0) continue;
-    if (nodes[i].error > maxErr) { maxErr = nodes[i].error; f = i; }
-  }
-  // i > q -> edge(q,i)
-  for (int i = q + 1; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-    int ei = edge_index_ij(q, i);
-    if (edge_cell[ei] == 0) continue;
-    if (nodes[i].error > maxErr) { maxErr = nodes[i].error; f = i; }
-  }
-  if (f < 0) return -1;
+// hart 0: interval over (and the hand-over copy free)?
+static bool prof_agg_due(void) {
+  if ((rdcycle64() - prof_agg_cyc) < (uint64_t)PROF_AGG_MS * (CPU_HZ / 1000u)) return false;
+#if GNG_SMP
+  smp_fence();
+  if (prof_agg_full) return false;
+  for (int i = 0; i < GNG_PROF_PHASES; i++) prof_agg_out[i] = g_prof_agg[i];
+  gng_prof_agg_reset();
+  smp_fence();
+  prof_agg_full = true;
+#endif
+  prof_agg_cyc = rdcycle64();
+  return true;
+}
+#endif // GNG_PROF_AGG
 
-  int r = findFreeNode();
-  if (r < 0) return -1;
+// ============================ Snapshot source ===================================
+// What the encoders below read: the live network, or with GNG_SMP the copy
+// hart 0 published last. Two buffers; hart 0 fills the one that is not the
+// newest and skips a snapshot when hart 1 still holds that one, hart 1 takes
+// the newest, re-checks that it is still the newest after claiming it
+// (seqlock-style retry) and encodes it while training goes on.
+#if GNG_SMP
+#define SNAP_FREE 2u
 
-  nodes[r].x = 0.5f * (nodes[q].x + nodes[f].x);
-  nodes[r].y = 0.5f * (nodes[q].y + nodes[f].y);
-  nodes[r].active = true;
+typedef struct {
+  uint32_t seq;
+  bool     resync;                // keyframe first (view switch, checkpoint load)
+  int16_t  x[MAX_NODES], y[MAX_NODES];
+  uint32_t act[ACT_WORDS];
+  uint32_t nbr[MAX_NODES][ACT_WORDS];
+  Prof     prof;
+  uint32_t step;
+  uint32_t epochs;
+  uint32_t passes;
+  dist_t   qe;
+#if GNG_DRIFT
+  gng_drift_t drift;
+#endif
+#if GNG_COMPONENTS
+  uint8_t  comp[MAX_NODES];
+  uint16_t comp_count;
+  uint32_t comp_changes;
+#endif
+} snap_buf_t;
 
-  removeEdgePair(q, f);
-  connectOrResetEdge(q, r);
-  connectOrResetEdge(r, f);
+static snap_buf_t        snap_buf[2];
+static volatile uint32_t snap_pub  = 0;         // newest complete buffer (hart 0)
+static volatile uint32_t snap_hold = SNAP_FREE; // buffer hart 1 encodes from
+static uint32_t          snap_seq  = 0;         // hart 0: last published
+static uint32_t          snap_seen = 0;         // hart 1: last taken
+static bool              snap_kf   = false;     // hart 0: next buffer asks for a keyframe
+static const snap_buf_t *snap_rd;
 
-  // Under lazy decay, still OK (global scaling cancels)
-  nodes[q].error *= GNG_ALPHA;
-  nodes[f].error *= GNG_ALPHA;
-  nodes[r].error  = nodes[q].error;
+// hart 0, at a snapshot trigger: copy what the encoders read; dropped while
+// hart 1 is still sending the older buffer (the link is the bottleneck then)
+static bool snap_publish(void) {
+  const uint32_t w = snap_pub ^ 1u;
+  smp_fence();
+  if (snap_hold == w) return false;
 
-  return r;
+  snap_buf_t *b = &snap_buf[w];
+  for (int i = 0; i < MAX_NODES; i++) {
+    b->x[i] = pos_to_wire(nodes[i].x);
+    b->y[i] = pos_to_wire(nodes[i].y);
+    for (int k = 0; k < ACT_WORDS; k++) b->nbr[i][k] = nbr[i][k];
+  }
+  for (int k = 0; k < ACT_WORDS; k++) b->act[k] = g_act[k];
+#if GNG_COMPONENTS
+  for (int i = 0; i < MAX_NODES; i++) b->comp[i] = g_comp[i];
+  b->comp_count   = g_comp_count;
+  b->comp_changes = g_comp_changes;
+#endif
+  b->prof   = g_prof;
+#if GNG_PROF_AGG
+  prof_agg_due();  // hands the interval to hart 1 when it is over
+#endif
+  b->step   = stepCount;
+  b->epochs = g_epochs;
+  b->passes = g_passes;
+  b->qe     = g_qe_ema;
+#if GNG_DRIFT
+  b->drift  = g_drift;
+#endif
+  b->resync = snap_kf;
+  b->seq    = ++snap_seq;
+  snap_kf = false;
+  smp_fence();
+  snap_pub = w;
+  return true;
 }
 
-// ============================ UART TX ===========================================
-static void uart_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
-  uint8_t sum = (uint8_t)(cmd + len);
-  for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
-  uint8_t chk = (uint8_t)(~sum);
-
-  neorv32_uart0_putc((char)UART_HDR);
-  neorv32_uart0_putc((char)UART_HDR);
-  neorv32_uart0_putc((char)cmd);
-  neorv32_uart0_putc((char)len);
-  for (uint8_t i = 0; i < len; i++) neorv32_uart0_putc((char)payload[i]);
-  neorv32_uart0_putc((char)chk);
+// hart 1: claim the newest buffer if it has not been sent yet
+static bool snap_take(void) {
+  const uint32_t h = snap_pub;
+  snap_hold = h;
+  smp_fence();
+  if (snap_pub != h || snap_buf[h].seq == snap_seen) {
+    snap_hold = SNAP_FREE;
+    return false;
+  }
+  snap_rd = &snap_buf[h];
+  snap_seen = snap_rd->seq;
+  return true;
 }
 
-static inline void wr_u32_le(uint8_t *p, uint32_t v) {
-  p[0] = (uint8_t)(v & 0xFFu);
-  p[1] = (uint8_t)((v >> 8) & 0xFFu);
-  p[2] = (uint8_t)((v >> 16) & 0xFFu);
-  p[3] = (uint8_t)((v >> 24) & 0xFFu);
+static inline void snap_release(void) {
+  smp_fence();
+  snap_hold = SNAP_FREE;
 }
 
+#define SNAP_ON(i)   ((snap_rd->act[(i) >> 5] >> ((i) & 31)) & 1u)
+#define SNAP_X(i)    (snap_rd->x[i])
+#define SNAP_Y(i)    (snap_rd->y[i])
+#define SNAP_ACT     (snap_rd->act)
+#define SNAP_NBR     (snap_rd->nbr)
+#define SNAP_PROF    (snap_rd->prof)
+#define SNAP_STEP    (snap_rd->step)
+#define SNAP_EPOCHS  (snap_rd->epochs)
+#define SNAP_PASSES  (snap_rd->passes)
+#define SNAP_QE      (snap_rd->qe)
+#define SNAP_DRIFT   (snap_rd->drift)
+#define SNAP_COMP    (snap_rd->comp)
+#define SNAP_COMP_COUNT   (snap_rd->comp_count)
+#define SNAP_COMP_CHANGES (snap_rd->comp_changes)
+#else
+#define SNAP_ON(i)   (nodes[i].active)
+#define SNAP_X(i)    pos_to_wire(nodes[i].x)
+#define SNAP_Y(i)    pos_to_wire(nodes[i].y)
+#define SNAP_ACT     g_act
+#define SNAP_NBR     nbr
+#define SNAP_PROF    g_prof
+#define SNAP_STEP    stepCount
+#define SNAP_EPOCHS  g_epochs
+#define SNAP_PASSES  g_passes
+#define SNAP_QE      g_qe_ema
+#define SNAP_DRIFT   g_drift
+#define SNAP_COMP    g_comp
+#define SNAP_COMP_COUNT   g_comp_count
+#define SNAP_COMP_CHANGES g_comp_changes
+#endif
+
 static void sendPROF(void) {
   // payload:
   // [0] frame_id
@@ -402,24 +1451,103 @@ static void sendPROF(void) {
   // [29..32]cyc_insert
   // [33..36]cyc_renorm
   // [37..40]stepCount (optional)
-  uint8_t payload[1 + 9*4 + 4];
+  // [41..44]cyc_overlap (optional)
+  // [45..48]misa  (optional, b12 = M)
+  // [49..52]mxisa (optional, NEORV32 Z* flags: Zba/Zbb)
+  // [53..56]tx_stall (optional, cycles blocked on the TX ring since last PROF)
+  // [57..60]smp_dropped (optional, stream samples lost on a full ring, total)
+  // [61..64]epochs (optional, DBL epochs run, total)
+  // [65..68]cache (optional, SYSINFO cache word: b3..0 log2 i-cache block, b7..4 log2 blocks)
+  // [69..72]idle  (optional, CLINT ticks asleep waiting for work, total)
+  // [73..76]time  (optional, CLINT time low word: awake = d(time) - d(idle))
+  // [77..80]qe    (optional, running QE: EMA of d1, Q2.30)
+  // [81..84]qe_slow (optional, GNG_DRIFT reference EMA, 0 without)
+  // [85..88]drift_events (optional, boosts started, total)
+  // [89..92]drift_lat (optional, steps of the last boost until QE settled)
+  // [93..96]drift_left (optional, boost steps to go, 0 = normal rates)
+  // [97..100]passes (optional, online passes over dataQ, total)
+  // [101..104]rx_bad (optional, host frames with a bad checksum, total)
+  // [105..108]rx_lost (optional, dataset samples beyond MAXPTS, total)
+  uint8_t payload[1 + 9*4 + 4 + 4 + 4 + 4 + 4 + 4 + 4 + 4 + 4 + 4 + 5*4 + 4 + 2*4];
   uint8_t p = 0;
   payload[p++] = frame_id;
 
-  wr_u32_le(&payload[p], g_prof.cyc_total);   p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_winner);  p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_move_w);  p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_nb);      p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_connect); p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_delete);  p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_prune);   p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_insert);  p += 4;
-  wr_u32_le(&payload[p], g_prof.cyc_renorm);  p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_total);   p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_winner);  p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_move_w);  p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_nb);      p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_connect); p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_delete);  p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_prune);   p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_insert);  p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_renorm);  p += 4;
+
+  wr_u32_le(&payload[p], SNAP_STEP);             p += 4;
+  wr_u32_le(&payload[p], SNAP_PROF.cyc_overlap); p += 4;
+  wr_u32_le(&payload[p], neorv32_cpu_csr_read(CSR_MISA));  p += 4;
+  wr_u32_le(&payload[p], neorv32_cpu_csr_read(CSR_MXISA)); p += 4;
+  wr_u32_le(&payload[p], g_tx_stall); p += 4;
+  g_tx_stall = 0;
+  wr_u32_le(&payload[p], g_smp_dropped); p += 4;
+  wr_u32_le(&payload[p], SNAP_EPOCHS); p += 4;
+  wr_u32_le(&payload[p], NEORV32_SYSINFO->CACHE); p += 4;
+  wr_u32_le(&payload[p], g_idle_ticks); p += 4;
+  wr_u32_le(&payload[p], (uint32_t)neorv32_clint_time_get()); p += 4;
+  wr_u32_le(&payload[p], dist_to_q30(SNAP_QE)); p += 4;
+#if GNG_DRIFT
+  wr_u32_le(&payload[p], dist_to_q30(SNAP_DRIFT.qe_slow)); p += 4;
+  wr_u32_le(&payload[p], SNAP_DRIFT.events);  p += 4;
+  wr_u32_le(&payload[p], SNAP_DRIFT.latency); p += 4;
+  wr_u32_le(&payload[p], SNAP_DRIFT.left);    p += 4;
+#else
+  for (int k = 0; k < 4; k++) { wr_u32_le(&payload[p], 0u); p += 4; }
+#endif
+  wr_u32_le(&payload[p], SNAP_PASSES); p += 4;
+  wr_u32_le(&payload[p], g_rx_bad);  p += 4;
+  wr_u32_le(&payload[p], g_rx_lost); p += 4;
 
-  wr_u32_le(&payload[p], (uint32_t)stepCount); p += 4;
+  snap_send_frame(CMD_PROF, payload, p);
+}
 
-  uart_send_frame(CMD_PROF, payload, p);
+#if GNG_PROF_AGG
+static void sendPROF_AGG(void) {
+  // payload per phase:
+  // [0] frame_id (of the PROF frame it follows)
+  // [1] phase: Prof field index (cyc_total, cyc_winner, ... cyc_renorm, cyc_overlap)
+  // [2] b0: first bucket sent, [3] nb: buckets sent
+  // [4..7] count  [8..11] min  [12..15] max  [16..23] sum (u64)
+  // [24..] nb x u16: steps with cycles in [2^b, 2^(b+1)), b = b0 .. b0+nb-1
+  uint8_t payload[24 + 2 * GNG_PROF_BUCKETS];
+  for (int i = 0; i < GNG_PROF_PHASES; i++) {
+    const gng_phase_agg_t *a = &PROF_AGG_SRC[i];
+    if (a->count == 0) continue;
+    int b0 = 0, b1 = GNG_PROF_BUCKETS;
+    while (a->hist[b0] == 0) b0++;
+    while (a->hist[b1 - 1] == 0) b1--;
+    uint8_t p = 0;
+    payload[p++] = frame_id;
+    payload[p++] = (uint8_t)i;
+    payload[p++] = (uint8_t)b0;
+    payload[p++] = (uint8_t)(b1 - b0);
+    wr_u32_le(&payload[p], a->count); p += 4;
+    wr_u32_le(&payload[p], a->min);   p += 4;
+    wr_u32_le(&payload[p], a->max);   p += 4;
+    wr_u32_le(&payload[p], (uint32_t)a->sum);         p += 4;
+    wr_u32_le(&payload[p], (uint32_t)(a->sum >> 32)); p += 4;
+    for (int b = b0; b < b1; b++) {
+      payload[p++] = (uint8_t)(a->hist[b] & 0xFFu);
+      payload[p++] = (uint8_t)(a->hist[b] >> 8);
+    }
+    snap_send_frame(CMD_PROF_AGG, payload, p);
+  }
+#if GNG_SMP
+  smp_fence();
+  prof_agg_full = false;
+#else
+  gng_prof_agg_reset();
+#endif
 }
+#endif // GNG_PROF_AGG
 
 static void sendGNGNodes(void) {
   uint8_t payload[2 + MAX_NODES * 5];
@@ -429,9 +1557,9 @@ static void sendGNGNodes(void) {
 
   uint8_t node_count = 0;
   for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-    int16_t xi = (int16_t)(nodes[i].x * 1000.0f);
-    int16_t yi = (int16_t)(nodes[i].y * 1000.0f);
+    if (!SNAP_ON(i)) continue;
+    int16_t xi = SNAP_X(i);
+    int16_t yi = SNAP_Y(i);
     payload[p++] = (uint8_t)i;
     payload[p++] = (uint8_t)(xi & 0xFF);
     payload[p++] = (uint8_t)((xi >> 8) & 0xFF);
@@ -440,11 +1568,19 @@ static void sendGNGNodes(void) {
     node_count++;
   }
   payload[1] = node_count;
-  uart_send_frame(CMD_GNG_NODES, payload, p);
+  snap_send_frame(CMD_GNG_NODES, payload, p);
+}
+
+static int edge_count_total(void) {
+  int n = 0;
+  for (int i = 0; i < MAX_NODES; i++) {
+    for (int w = 0; w < ACT_WORDS; w++) n += __builtin_popcount(SNAP_NBR[i][w]);
+  }
+  return n / 2;
 }
 
 // OLD FORMAT (Processing-compatible): [frame_id][count][(a,b)...]
-static void sendGNGEdges(void) {
+static void sendGNGEdges_single(void) {
   uint8_t payload[2 + MAX_EDGE_PAIRS_PER_FRAME * 2];
   uint8_t p = 0;
 
@@ -454,301 +1590,2529 @@ static void sendGNGEdges(void) {
   uint8_t edge_count = 0;
 
   for (int i = 0; i < MAX_NODES; i++) {
-    for (int j = i + 1; j < MAX_NODES; j++) {
-      int ei = edge_index_ij(i, j);
-      if (edge_cell[ei] == 0) continue;
-
+    FOR_EACH_BIT(j, SNAP_NBR[i], i + 1, MAX_NODES) {
       payload[p++] = (uint8_t)i;
       payload[p++] = (uint8_t)j;
       edge_count++;
-
-      if (edge_count >= MAX_EDGE_PAIRS_PER_FRAME) {
-        payload[1] = edge_count;
-        uart_send_frame(CMD_GNG_EDGES, payload, p);
-        return;
-      }
     }
   }
 
   payload[1] = edge_count;
-  uart_send_frame(CMD_GNG_EDGES, payload, p);
+  snap_send_frame(CMD_GNG_EDGES, payload, p);
 }
 
-// ============================ UART RX ===========================================
-static void handleCommand(uint8_t cmd, const uint8_t *payload, uint8_t len) {
-  if (cmd == CMD_DATA_BATCH) {
-    if (len < 1) return;
-    uint8_t count = payload[0];
-    if (len < (uint8_t)(1 + count * 4u)) return;
-
-    uint8_t pos = 1;
-    for (uint8_t i = 0; i < count; i++) {
-      int16_t xi = (int16_t)((uint16_t)payload[pos] | ((uint16_t)payload[pos + 1] << 8));
-      int16_t yi = (int16_t)((uint16_t)payload[pos + 2] | ((uint16_t)payload[pos + 3] << 8));
-      pos += 4;
-      if (dataCount < MAXPTS) {
-        dataX[dataCount] = (float)xi / 1000.0f;
-        dataY[dataCount] = (float)yi / 1000.0f;
-        dataCount++;
+static void sendGNGEdges_chunked(int total) {
+  uint8_t payload[255];
+  const int n_chunks = (total + EDGE_PAIRS_PER_CHUNK - 1) / EDGE_PAIRS_PER_CHUNK;
+  int chunk = 0;
+  uint8_t p = 0;
+  uint8_t count = 0;
+
+  for (int i = 0; i < MAX_NODES; i++) {
+    FOR_EACH_BIT(j, SNAP_NBR[i], i + 1, MAX_NODES) {
+      if (count == 0) {
+        p = 0;
+        payload[p++] = frame_id;
+        payload[p++] = EDGE_ID16 ? 1u : 0u;
+        payload[p++] = (uint8_t)chunk;
+        payload[p++] = (uint8_t)n_chunks;
+        payload[p++] = (uint8_t)(total & 0xFF);
+        payload[p++] = (uint8_t)((total >> 8) & 0xFF);
+        payload[p++] = 0; // count placeholder
+      }
+      payload[p++] = (uint8_t)(i & 0xFF);
+      if (EDGE_ID16) payload[p++] = (uint8_t)((i >> 8) & 0xFF);
+      payload[p++] = (uint8_t)(j & 0xFF);
+      if (EDGE_ID16) payload[p++] = (uint8_t)((j >> 8) & 0xFF);
+      count++;
+
+      if (count == EDGE_PAIRS_PER_CHUNK) {
+        payload[EDGE_CHUNK_HDR - 1] = count;
+        snap_send_frame(CMD_GNG_EDGES_CHUNK, payload, p);
+        chunk++;
+        count = 0;
       }
     }
-  } else if (cmd == CMD_DONE) {
-    dataDone = true;
-  } else if (cmd == CMD_RUN) {
-    running = true;
+  }
+  if (count != 0) {
+    payload[EDGE_CHUNK_HDR - 1] = count;
+    snap_send_frame(CMD_GNG_EDGES_CHUNK, payload, p);
   }
 }
 
-static void readSerial(void) {
-  while (neorv32_uart0_char_received()) {
-    uint8_t b = (uint8_t)neorv32_uart0_getc();
-    switch (rx_state) {
-      case RX_WAIT_H1:
-        if (b == UART_HDR) rx_state = RX_WAIT_H2;
-        break;
-      case RX_WAIT_H2:
-        if (b == UART_HDR) rx_state = RX_WAIT_CMD;
-        else rx_state = RX_WAIT_H1;
-        break;
-      case RX_WAIT_CMD:
-        rx_cmd = b; rx_sum = b; rx_state = RX_WAIT_LEN;
-        break;
-      case RX_WAIT_LEN:
-        rx_len = b;
-        rx_sum = (uint8_t)(rx_sum + b);
-        rx_index = 0;
-        if (rx_len == 0) rx_state = RX_WAIT_CHK;
-        else if (rx_len > sizeof(rx_payload)) rx_state = RX_WAIT_H1;
-        else rx_state = RX_WAIT_PAYLOAD;
-        break;
-      case RX_WAIT_PAYLOAD:
-        rx_payload[rx_index++] = b;
-        rx_sum = (uint8_t)(rx_sum + b);
-        if (rx_index >= rx_len) rx_state = RX_WAIT_CHK;
-        break;
-      case RX_WAIT_CHK: {
-        uint8_t expected = (uint8_t)(~rx_sum);
-        if (b == expected) handleCommand(rx_cmd, rx_payload, rx_len);
-        rx_state = RX_WAIT_H1;
-        break;
-      }
-      default:
-        rx_state = RX_WAIT_H1;
-        break;
+#if EDGE_PACKED
+// bitmap or gap code if shorter than the pair list; false -> send the list
+static bool sendGNGEdges_packed(int total) {
+  uint8_t payload[255];
+  const int list_len = (!EDGE_ID16 && total <= MAX_EDGE_PAIRS_PER_FRAME)
+      ? 2 + 2 * total
+      : EDGE_CHUNK_HDR * ((total + EDGE_PAIRS_PER_CHUNK - 1) / EDGE_PAIRS_PER_CHUNK) +
+        (EDGE_ID16 ? 4 : 2) * total;
+
+  // gap code, abandoned when it outgrows the frame
+  int p = EDGE_BM_HDR;
+  int last = -1;
+  for (int i = 0; i < MAX_NODES && p < 255; i++) {
+    FOR_EACH_BIT(j, SNAP_NBR[i], i + 1, MAX_NODES) {
+      int k = edge_index_ij(i, j);
+      uint32_t gap = (uint32_t)(k - last - 1);
+      for (; gap >= EDGE_GAP_ESC && p < 255; gap -= EDGE_GAP_ESC) payload[p++] = EDGE_GAP_ESC;
+      if (p < 255) payload[p++] = (uint8_t)gap;
+      last = k;
     }
   }
-}
+  const int gap_len = (p < 255) ? p : 0x7FFF;
+#if EDGE_BM_FITS
+  const int bm_len  = EDGE_BM_HDR + EDGE_BM_BYTES;
+#else
+  const int bm_len  = 0x7FFF;  // no bitmap frame for this MAX_NODES
+#endif
 
-// ============================ CFS helpers =======================================
-static void cfs_sync_nodes_full(void) {
-  for (int i = 0; i < MAX_NODES; i++) {
-    NEORV32_CFS->REG[CFS_NODE_BASE + i] = pack_node_q15(nodes[i].x, nodes[i].y);
+  if (list_len <= gap_len && list_len <= bm_len) return false;
+
+  uint8_t flags = 1;
+#if EDGE_BM_FITS
+  if (bm_len < gap_len) {
+    flags = 0;
+    p = EDGE_BM_HDR + EDGE_BM_BYTES;
+    for (int b = EDGE_BM_HDR; b < p; b++) payload[b] = 0;
+    for (int i = 0; i < MAX_NODES; i++) {
+      FOR_EACH_BIT(j, SNAP_NBR[i], i + 1, MAX_NODES) {
+        int k = edge_index_ij(i, j);
+        payload[EDGE_BM_HDR + (k >> 3)] |= (uint8_t)(1u << (k & 7));
+      }
+    }
   }
+#endif
+  payload[0] = frame_id;
+  payload[1] = (uint8_t)MAX_NODES;
+  payload[2] = flags;
+  snap_send_frame(CMD_GNG_EDGES_BITMAP, payload, (uint8_t)p);
+  return true;
 }
+#endif
 
-static void cfs_build_active_mask(uint32_t *lo, uint32_t *hi8) {
-  uint32_t mlo = 0;
-  uint32_t mhi = 0;
-  for (int i = 0; i < MAX_NODES; i++) {
-    if (!nodes[i].active) continue;
-    if (i < 32) mlo |= (1u << i);
-    else mhi |= (1u << (i - 32));
-  }
-  *lo = mlo;
-  *hi8 = (mhi & 0xFFu);
+static void sendGNGEdges(void) {
+  int total = edge_count_total();
+#if EDGE_PACKED
+  if (MAX_NODES <= 255 && sendGNGEdges_packed(total)) return;
+#endif
+  if (!EDGE_ID16 && total <= MAX_EDGE_PAIRS_PER_FRAME) sendGNGEdges_single();
+  else sendGNGEdges_chunked(total);
 }
 
-static bool cfs_find_winners(float x, float y, int *s1, int *s2, float *d1_out) {
-  uint32_t act_lo, act_hi8;
-  cfs_build_active_mask(&act_lo, &act_hi8);
+// ============================ Delta stream =======================================
+// what the host currently shows (valid after the first keyframe)
+static bool     sent_valid = false;
+static int16_t  sent_x[MAX_NODES], sent_y[MAX_NODES];
+static uint32_t sent_act[ACT_WORDS];
+static uint32_t sent_nbr[MAX_NODES][ACT_WORDS];
 
-  NEORV32_CFS->REG[CFS_REG_XIN]        = (uint32_t)float_to_q15_pos(x);
-  NEORV32_CFS->REG[CFS_REG_YIN]        = (uint32_t)float_to_q15_pos(y);
-  NEORV32_CFS->REG[CFS_REG_NODE_COUNT] = (uint32_t)MAX_NODES;
-  NEORV32_CFS->REG[CFS_REG_ACT_LO]     = act_lo;
-  NEORV32_CFS->REG[CFS_REG_ACT_HI]     = act_hi8;
+// next snapshot is a keyframe (GNG_SMP: sent_* belongs to hart 1, the flag
+// travels with the next published buffer)
+static inline void snap_resync(void) {
+#if GNG_SMP
+  snap_kf = true;
+#else
+  sent_valid = false;
+#endif
+}
 
-  NEORV32_CFS->REG[CFS_REG_CTRL] = CFS_CTRL_START;
+#if GNG_COMPONENTS
+// ============================ Component labels (CMD_GNG_COMPONENTS) =============
+#define COMP_HDR  4  // [frame_id][count][first][n]
+#define COMP_MAX  (255 - COMP_HDR)
 
-  const uint32_t TIMEOUT = 200000u;
-  for (uint32_t t = 0; t < TIMEOUT; t++) {
-    uint32_t st = NEORV32_CFS->REG[CFS_REG_CTRL];
-    if (st & CFS_STATUS_DONE) break;
-    if (t == TIMEOUT - 1) return false;
-  }
+static uint32_t comp_sent    = 0;     // SNAP_COMP_CHANGES of the last frame
+static bool     comp_sent_ok = false; // false: send at the next snapshot
 
-  uint32_t s12  = NEORV32_CFS->REG[CFS_REG_OUT_S12];
-  uint32_t min1 = NEORV32_CFS->REG[CFS_REG_OUT_MIN1];
+static void sendComponents(void) {
+  uint8_t payload[COMP_HDR + COMP_MAX];
+  const uint16_t cnt = SNAP_COMP_COUNT;
+  for (int first = 0; first < MAX_NODES; first += COMP_MAX) {
+    int n = (MAX_NODES - first < COMP_MAX) ? MAX_NODES - first : COMP_MAX;
+    payload[0] = frame_id;
+    payload[1] = (uint8_t)(cnt > 255u ? 255u : cnt);
+    payload[2] = (uint8_t)first;
+    payload[3] = (uint8_t)n;
+    for (int k = 0; k < n; k++) payload[COMP_HDR + k] = SNAP_ON(first + k) ? SNAP_COMP[first + k] : 0xFFu;
+    snap_send_frame(CMD_GNG_COMPONENTS, payload, (uint8_t)(COMP_HDR + n));
+  }
+  comp_sent = SNAP_COMP_CHANGES;
+  comp_sent_ok = true;
+}
+#endif
 
-  *s1 = (int)(s12 & 0xFFu);
-  *s2 = (int)((s12 >> 8) & 0xFFu);
+#if GNG_CFS_DUMP
+static bool g_cfs_dump = false;  // REG_DIM bit 17, UART0 CTRL.HWFC_EN is set
 
-  *d1_out = q30_to_float(min1);
-  return true;
+// the framer may take the line: nothing queued, nothing on the wire
+static bool cfs_dump_ok(void) {
+  if (!g_cfs_dump) return false;
+#if SD_CARD
+  if (sd_log) return false;
+#endif
+  if (uart_tx_queued() != 0) return false;
+  if (NEORV32_UART0->CTRL & (1u << UART_CTRL_TX_BUSY)) return false;
+  return !cfs_dump_busy();
 }
+#endif
 
-// ============================ GNG Step (CPU Fritzke-ish) =========================
-static void trainOneStep(float x, float y) {
-  // clear prof
-  g_prof.cyc_total = g_prof.cyc_winner = g_prof.cyc_move_w = 0;
-  g_prof.cyc_nb = g_prof.cyc_connect = g_prof.cyc_delete = 0;
-  g_prof.cyc_prune = g_prof.cyc_insert = g_prof.cyc_renorm = 0;
+static void sendKeyframe(void) {
+#if GNG_CFS_DUMP
+  if (cfs_dump_ok() && cfs_dump_start(frame_id, GNG_CFS_MOVE != 0)) {
+#if !GNG_CFS_MOVE
+    sendGNGEdges(); // no adj_mem: CPU pairs, held behind the dump (CTS)
+#endif
+  } else
+#endif
+  {
+    sendGNGNodes();
+    sendGNGEdges(); // Processing-compatible (old format)
+  }
+#if GNG_COMPONENTS
+  comp_sent_ok = false;  // labels follow the keyframe
+#endif
 
-  uint64_t t_total0 = rdcycle64();
+  for (int i = 0; i < MAX_NODES; i++) {
+    sent_x[i] = SNAP_X(i);
+    sent_y[i] = SNAP_Y(i);
+    for (int w = 0; w < ACT_WORDS; w++) sent_nbr[i][w] = SNAP_NBR[i][w];
+  }
+  for (int w = 0; w < ACT_WORDS; w++) sent_act[w] = SNAP_ACT[w];
+  sent_valid = true;
+}
 
-  int s1=-1, s2=-1;
-  float d1 = 1e30f;
+static inline int16_t abs16(int16_t v) { return (v < 0) ? (int16_t)-v : v; }
 
-  // (1) winners
-  uint64_t t0 = rdcycle64();
-  bool ok = cfs_find_winners(x, y, &s1, &s2, &d1);
-  uint64_t t1 = rdcycle64();
-  g_prof.cyc_winner = (uint32_t)(t1 - t0);
+// false -> did not fit in one frame, caller sends a keyframe instead
+static bool sendGNGDelta(void) {
+  uint8_t payload[255];
+  uint8_t upd[MAX_NODES];
+  uint8_t ea[2][MAX_EDGE_PAIRS_PER_FRAME], eb[2][MAX_EDGE_PAIRS_PER_FRAME];
+  int n_upd = 0, n_ev[2] = {0, 0};
 
-  if (!ok) {
-    // fallback (rare)
-    float best1=1e30f, best2=1e30f;
-    for (int i=0;i<MAX_NODES;i++){
-      if(!nodes[i].active) continue;
-      float d = dist2(x,y,nodes[i].x,nodes[i].y);
-      if (d < best1) { best2=best1; s2=s1; best1=d; s1=i; }
-      else if (d < best2) { best2=d; s2=i; }
+  for (int i = 0; i < MAX_NODES; i++) {
+    bool act  = SNAP_ON(i);
+    bool sact = (sent_act[i >> 5] >> (i & 31)) & 1u;
+    if (act != sact) { upd[n_upd++] = (uint8_t)i; continue; }
+    if (!act) continue;
+    if (abs16((int16_t)(SNAP_X(i) - sent_x[i])) > STREAM_DELTA_TH ||
+        abs16((int16_t)(SNAP_Y(i) - sent_y[i])) > STREAM_DELTA_TH) {
+      upd[n_upd++] = (uint8_t)i;
     }
-    d1 = best1;
   }
 
-  if (s1 < 0 || s2 < 0) {
-    uint64_t t_total1 = rdcycle64();
-    g_prof.cyc_total = (uint32_t)(t_total1 - t_total0);
-    return;
+  // edge events (i < j only): [0] = added, [1] = removed
+  for (int i = 0; i < MAX_NODES; i++) {
+    for (int w = 0; w < ACT_WORDS; w++) {
+      uint32_t diff = set_word_range(SNAP_NBR[i], w, i + 1, MAX_NODES) ^
+                      set_word_range(sent_nbr[i], w, i + 1, MAX_NODES);
+      for (; diff; diff &= diff - 1u) {
+        int j = w * 32 + __builtin_ctz(diff);
+        int k = ((SNAP_NBR[i][w] >> (j & 31)) & 1u) ? 0 : 1;
+        if (n_ev[k] >= MAX_EDGE_PAIRS_PER_FRAME) return false;
+        ea[k][n_ev[k]] = (uint8_t)i;
+        eb[k][n_ev[k]] = (uint8_t)j;
+        n_ev[k]++;
+      }
+    }
   }
 
-  // (A) error accumulate (LAZY DECAY: scale increment)
-  nodes[s1].error += d1 * g_err_inv;
-
-  // (B) move winner
-  t0 = rdcycle64();
-  nodes[s1].x += GNG_EPSILON_B * (x - nodes[s1].x);
-  nodes[s1].y += GNG_EPSILON_B * (y - nodes[s1].y);
-  NEORV32_CFS->REG[CFS_NODE_BASE + s1] = pack_node_q15(nodes[s1].x, nodes[s1].y);
-  t1 = rdcycle64();
-  g_prof.cyc_move_w = (uint32_t)(t1 - t0);
-
-  // (C) age edges + move neighbors
-  t0 = rdcycle64();
-  age_edges_and_move_neighbors(s1, x, y);
-  t1 = rdcycle64();
-  g_prof.cyc_nb = (uint32_t)(t1 - t0);
-
-  // (D) connect winners
-  t0 = rdcycle64();
-  connectOrResetEdge(s1, s2);
-  t1 = rdcycle64();
-  g_prof.cyc_connect = (uint32_t)(t1 - t0);
-
-  // (E) delete old edges (winner-only)
-  t0 = rdcycle64();
-  deleteOldEdgesFromWinner(s1);
-  t1 = rdcycle64();
-  g_prof.cyc_delete = (uint32_t)(t1 - t0);
-
-  // (F) prune isolated nodes (degree)
-  t0 = rdcycle64();
-  pruneIsolatedNodes_degree();
-  t1 = rdcycle64();
-  g_prof.cyc_prune = (uint32_t)(t1 - t0);
-
-  stepCount++;
-
-  // (G) insert every lambda
-  if ((stepCount % GNG_LAMBDA) == 0) {
-    t0 = rdcycle64();
-    (void)insertNode_fritzke();
-    pruneIsolatedNodes_degree();
-    cfs_sync_nodes_full();
-    t1 = rdcycle64();
-    g_prof.cyc_insert = (uint32_t)(t1 - t0);
-  }
+  if (4 + 5 * n_upd + 2 * (n_ev[0] + n_ev[1]) > (int)sizeof(payload)) return false;
 
-  // (H) lazy decay update
-  g_err_inv *= GNG_D_INV;
+  uint8_t p = 0;
+  payload[p++] = frame_id;
+  payload[p++] = (uint8_t)n_upd;
+  payload[p++] = (uint8_t)n_ev[0];
+  payload[p++] = (uint8_t)n_ev[1];
 
-  // renorm (optional)
-  t0 = rdcycle64();
-  bool did_renorm = error_renorm_if_needed();
-  t1 = rdcycle64();
-  if (did_renorm) g_prof.cyc_renorm = (uint32_t)(t1 - t0);
-  else g_prof.cyc_renorm = 0;
+  for (int u = 0; u < n_upd; u++) {
+    int i = upd[u];
+    int16_t xi = SNAP_X(i);
+    int16_t yi = SNAP_Y(i);
+    payload[p++] = SNAP_ON(i) ? (uint8_t)i : (uint8_t)(i | 0x80);
+    payload[p++] = (uint8_t)(xi & 0xFF);
+    payload[p++] = (uint8_t)((xi >> 8) & 0xFF);
+    payload[p++] = (uint8_t)(yi & 0xFF);
+    payload[p++] = (uint8_t)((yi >> 8) & 0xFF);
+    sent_x[i] = xi;
+    sent_y[i] = yi;
+  }
+  for (int k = 0; k < 2; k++) {
+    for (int e = 0; e < n_ev[k]; e++) {
+      payload[p++] = ea[k][e];
+      payload[p++] = eb[k][e];
+    }
+  }
+  snap_send_frame(CMD_GNG_DELTA, payload, p);
 
-  uint64_t t_total1 = rdcycle64();
-  g_prof.cyc_total = (uint32_t)(t_total1 - t_total0);
+  for (int i = 0; i < MAX_NODES; i++) {
+    for (int w = 0; w < ACT_WORDS; w++) sent_nbr[i][w] = SNAP_NBR[i][w];
+  }
+  for (int w = 0; w < ACT_WORDS; w++) sent_act[w] = SNAP_ACT[w];
+  return true;
 }
 
-// ============================ Init ===============================================
-static void initGNG(void) {
-  for (int i=0;i<MAX_NODES;i++){
-    nodes[i].x=0.0f; nodes[i].y=0.0f;
-    nodes[i].error=0.0f;
-    nodes[i].active=false;
+// one snapshot: delta (keyframe every STREAM_KEYFRAME_EVERY or if it does not fit), PROF
+static void snap_send(void) {
+#if GNG_SMP
+  if (snap_rd->resync) sent_valid = false;
+#endif
+  frame_id++;
+  if (!sent_valid || (frame_id % STREAM_KEYFRAME_EVERY) == 0 || !sendGNGDelta()) {
+    sendKeyframe();
   }
-  edges_init_full();
+  sendPROF();     // profiling frame
+#if GNG_COMPONENTS
+  if (!comp_sent_ok || comp_sent != SNAP_COMP_CHANGES) sendComponents();
+#endif
+#if GNG_PROF_AGG
+#if GNG_SMP
+  if (prof_agg_full) sendPROF_AGG();
+#else
+  if (prof_agg_due()) sendPROF_AGG();
+#endif
+#endif
+}
 
-  dataCount=0; dataDone=false; running=false;
-  stepCount=0; dataIndex=0; frame_id=0;
+// ============================ Snapshot triggers =================================
+static uint8_t  snap_mask    = SNAP_TRIG_EVERY;
+static uint32_t snap_every   = STREAM_EVERY_N;
+static uint32_t snap_min_gap = SNAP_MIN_GAP;
+static uint32_t snap_qe_pct  = SNAP_QE_PCT;
+static uint64_t snap_period  = (uint64_t)SNAP_PERIOD_MS * (CPU_HZ / 1000u);
+static uint32_t snap_io_pct  = SNAP_IO_PCT;
+
+// state at the last snapshot
+static uint32_t snap_step = 0;
+static uint64_t snap_cyc = 0;
+static uint32_t snap_topo = 0;
+static dist_t   snap_qe = 0;   // 0 = not seen yet, next QE becomes the reference
+
+// snapshot cost (SNAP_TRIG_AUTO, STATS): EMAs x 8 of the cycles one snapshot
+// takes and of the cycles per step in between
+static uint64_t snap_end   = 0;  // mcycle after the last measured snapshot, 0 = none
+static uint32_t snap_end_step = 0;
+static uint32_t snap_io8   = 0;
+static uint32_t snap_step8 = 0;
+static uint32_t snap_io_pm = 0;  // last snapshot / its interval, per mille
+
+static void snap_mode_set(const uint8_t *p, uint8_t len) {
+  snap_mask = p[0];
+  if (len < 8) return;
+  uint32_t every = (uint32_t)p[1] | ((uint32_t)p[2] << 8);
+  uint32_t gap   = (uint32_t)p[3] | ((uint32_t)p[4] << 8);
+  uint32_t ms    = (uint32_t)p[6] | ((uint32_t)p[7] << 8);
+  if (every) snap_every = every;
+  if (gap) snap_min_gap = gap;
+  if (p[5] && p[5] < 100u) snap_qe_pct = p[5];
+  if (ms) snap_period = (uint64_t)ms * (CPU_HZ / 1000u);
+  if (len >= 9 && p[8] && p[8] < 100u) snap_io_pct = p[8];
+}
+
+static inline bool qe_dropped(void) {
+  if (snap_qe == 0) snap_qe = g_qe_ema;
+#if GNG_FIXED
+  return (uint64_t)g_qe_ema * 100u <= (uint64_t)snap_qe * (100u - snap_qe_pct);
+#else
+  return g_qe_ema * 100.0f <= snap_qe * (float)(100u - snap_qe_pct);
+#endif
+}
+
+static bool snap_due(void) {
+  uint32_t steps = (uint32_t)(stepCount - snap_step);
+  if ((snap_mask & (SNAP_TRIG_EVERY | SNAP_TRIG_AUTO)) && steps >= snap_every) return true;
+  if ((snap_mask & SNAP_TRIG_TIME) && (rdcycle64() - snap_cyc) >= snap_period) return true;
+  if (steps < snap_min_gap) return false;
+  if ((snap_mask & SNAP_TRIG_TOPO) && g_topo_changes != snap_topo) return true;
+  if ((snap_mask & SNAP_TRIG_QE) && qe_dropped()) return true;
+  return false;
+}
+
+static inline void snap_mark(void) {
+  snap_step = stepCount;
+  snap_cyc  = rdcycle64();
+  snap_topo = g_topo_changes;
+  snap_qe   = g_qe_ema;
+}
+
+// after a snapshot that started at mcycle t0: the cycles from the previous
+// one to t0 are the run, t0 to now the I/O. SNAP_TRIG_AUTO:
+// io / (io + every * step) = io_pct / 100 -> every = io * (100 - io_pct) / (io_pct * step)
+static void snap_auto(uint64_t t0) {
+  const uint64_t now = rdcycle64();
+  const uint64_t run = t0 - snap_end;
+  const uint32_t io = (uint32_t)(now - t0);
+  const uint32_t steps = (uint32_t)(stepCount - snap_end_step);
+  const bool first = (snap_end == 0);
+  snap_end = now;
+  snap_end_step = stepCount;
+  if (first || !steps || (int32_t)steps < 0) return;
+  snap_io_pm = (uint32_t)((uint64_t)io * 1000u / (run + io));
+
+  uint64_t step = run / steps;
+  if (step > 0xFFFFFFu) step = 0xFFFFFFu;   // a pause, not a step
+  snap_io8   = snap_io8   ? snap_io8   - (snap_io8   >> 3) + io             : io * 8u;
+  snap_step8 = snap_step8 ? snap_step8 - (snap_step8 >> 3) + (uint32_t)step : (uint32_t)step * 8u;
+  if (!(snap_mask & SNAP_TRIG_AUTO) || !snap_step8) return;
+
+  uint64_t every = ((uint64_t)snap_io8 * (100u - snap_io_pct)) /
+                   ((uint64_t)snap_step8 * snap_io_pct);
+  if (every < SNAP_AUTO_MIN) every = SNAP_AUTO_MIN;
+  if (every > SNAP_AUTO_MAX) every = SNAP_AUTO_MAX;
+  snap_every = (uint32_t)every;
+}
+
+// CMD_EVAL state; the sweep (eval_serve) follows the query service
+static bool     eval_req   = false;  // one sweep, served by the main loop
+static uint32_t eval_every = 0;      // steps between sweeps, 0 = on request only
+static uint32_t eval_step  = 0;      // view-model step of the last sweep
+static dist_t   eval_d1    = 0;      // mean min1 of the last sweep
+static bool     eval_fresh = false;  // eval_d1 not yet taken by conv_check
+
+#if GNG_CONVERGE
+// ============================ Convergence stop ==================================
+static uint8_t  conv_action = CONV_OFF;
+static uint16_t conv_window = CONV_WINDOW;
+static uint8_t  conv_qe_pct = CONV_QE_PCT;
+static uint16_t conv_churn  = CONV_CHURN;
+static uint8_t  conv_need   = CONV_WINDOWS;
+
+// window in progress (view model counters) and the quiet run so far
+#if GNG_FIXED
+typedef uint64_t conv_sum_t;
+#else
+typedef float    conv_sum_t;
+#endif
+static uint32_t   conv_step0 = 0;
+static uint32_t   conv_topo0 = 0;
+static conv_sum_t conv_acc   = 0;   // QE EMA summed over the checks of the window
+static uint32_t   conv_n     = 0;
+static dist_t     conv_ref   = 0;   // mean QE of the previous window, 0 = none yet
+static dist_t     conv_mean  = 0;
+static uint32_t   conv_since = 0;
+static uint32_t   conv_last  = 0;   // churn per 1000 steps of the last window
+static uint8_t    conv_quiet = 0;
+static bool       conv_done  = false;
+
+static void conv_arm(void) {
+  conv_step0 = conv_since = stepCount;
+  conv_topo0 = g_topo_changes;
+  conv_acc   = 0;
+  conv_n     = 0;
+  conv_ref   = 0;
+  conv_quiet = 0;
+  conv_done  = false;
+}
+
+static void conv_set(const uint8_t *p, uint8_t len) {
+  conv_action = (p[0] <= CONV_STOP) ? p[0] : CONV_OFF;
+  if (len >= 7) {
+    uint16_t w = (uint16_t)(p[1] | (p[2] << 8));
+    if (w) conv_window = w;
+    if (p[3] && p[3] < 100u) conv_qe_pct = p[3];
+    conv_churn = (uint16_t)(p[4] | (p[5] << 8));
+    if (p[6]) conv_need = p[6];
+  }
+  conv_arm();
+}
+
+// mean QE of this window within qe_pct % of the previous window's
+static inline bool conv_qe_flat(void) {
+  if (conv_ref == 0) return false;
+  dist_t d = (conv_mean > conv_ref) ? conv_mean - conv_ref : conv_ref - conv_mean;
+#if GNG_FIXED
+  return (uint64_t)d * 100u <= (uint64_t)conv_ref * conv_qe_pct;
+#else
+  return d * 100.0f <= conv_ref * (float)conv_qe_pct;
+#endif
+}
+
+// after a step (DBL: an epoch) of the view model: true once the quiet run
+// is long enough
+static bool conv_check(void) {
+  if (conv_done) return false;
+  if (!eval_every) {
+    conv_acc += g_qe_ema;
+    conv_n++;
+  } else if (eval_fresh) {        // periodic sweeps: the fixed sample set
+    conv_acc += eval_d1;
+    conv_n++;
+    eval_fresh = false;
+  }
+  uint32_t steps = (uint32_t)(stepCount - conv_step0);
+  if (steps < conv_window || conv_n == 0) return false;
+
+  conv_mean = (dist_t)(conv_acc / conv_n);
+  conv_last = (uint32_t)((uint64_t)(g_topo_changes - conv_topo0) * 1000u / steps);
+  bool quiet = conv_qe_flat() && conv_last <= conv_churn && !drift_boosted();
+  if (!quiet) {
+    conv_quiet = 0;
+    conv_since = stepCount;
+  } else if (conv_quiet < 0xFFu) {
+    conv_quiet++;
+  }
+  conv_ref   = conv_mean;
+  conv_step0 = stepCount;
+  conv_topo0 = g_topo_changes;
+  conv_acc   = 0;
+  conv_n     = 0;
+  return conv_quiet >= conv_need;
+}
+
+// CMD_CONVERGED, the final keyframe, and the stop
+static void conv_fire(void) {
+  uint8_t payload[17];
+  conv_done = true;
+  wr_u32_le(&payload[0],  stepCount);
+  wr_u32_le(&payload[4],  conv_since);
+  wr_u32_le(&payload[8],  dist_to_q30(conv_mean));
+  wr_u32_le(&payload[12], conv_last);
+  payload[16] = conv_action;
+  uart_send_frame(CMD_CONVERGED, payload, sizeof(payload));
+
+  snap_resync();
+  snap_mark();
+#if GNG_SMP
+  while (!snap_publish()) { }  // must not be dropped: hart 1 frees the older buffer
+#else
+  snap_send();
+#endif
+  if (conv_action == CONV_STOP) running = false;
+}
+#endif // GNG_CONVERGE
+
+// ============================ Sample source =====================================
+#if GNG_GEN
+// ---- on-board generator: a sample per step from (seed, index) ----
+static gng_gen_t g_gen;
+static bool      gen_src  = false; // samples come from g_gen
+static uint8_t   gen_req  = 0;     // CMD_GEN kind + 1, served by the main loop
+static uint32_t  gen_seed = 0;
+
+// 4 TRNG bytes, false without a TRNG (or one that stays empty for 10 ms)
+static bool gen_trng_seed(uint32_t *seed) {
+  if (neorv32_trng_available() == 0) return false;
+  neorv32_trng_enable();
+  uint32_t s = 0;
+  for (int k = 0; k < 4; k++) {
+    uint8_t b = 0;
+    const uint64_t t0 = rdcycle64();
+    while (neorv32_trng_get(&b) != 0) {
+      if (rdcycle64() - t0 > CPU_HZ / 100u) { neorv32_trng_disable(); return false; }
+    }
+    s = (s << 8) | b;
+  }
+  neorv32_trng_disable();
+  *seed = s ? s : GEN_SEED;
+  return true;
+}
+
+static void gen_serve(void) {
+  const uint8_t kind = (uint8_t)(gen_req - 1u);
+  uint32_t seed = gen_seed;
+  bool trng = false;
+  gen_req = 0;
+  if (kind == GNG_GEN_OFF || kind >= GNG_GEN_KINDS) {
+    gen_src = false;
+  } else {
+    if (!seed) {
+      trng = gen_trng_seed(&seed);
+      if (!trng) seed = GEN_SEED;
+    }
+    gng_gen_init(&g_gen, kind, seed);
+    gen_src = true;
+    running = true;
+#if GNG_CONVERGE
+    conv_arm();
+#endif
+  }
+
+  uint8_t payload[6];
+  payload[0] = gen_src ? kind : (uint8_t)GNG_GEN_OFF;
+  wr_u32_le(&payload[1], gen_src ? seed : 0u);
+  payload[5] = trng ? 1u : 0u;
+  uart_send_frame(CMD_GEN_ACK, payload, 6);
+}
+#endif
+
+static void sendCredit(uint32_t n) {
+  uint8_t payload[2];
+  payload[0] = (uint8_t)(n & 0xFFu);
+  payload[1] = (uint8_t)((n >> 8) & 0xFFu);
+  smp_granted += n;
+  uart_send_frame(CMD_CREDIT, payload, 2);
+}
+
+static void stream_start(void) {
+#if GNG_GEN
+  gen_src = false;
+#endif
+  g_stream = true;
+  smp_head = smp_tail = 0;
+  smp_granted = 0;
+  dataDone = true;
+  running = true;
+  sendCredit(STREAM_RING);
+}
+
+// hand consumed slots back to the host once a chunk is free
+static inline void stream_credit_update(void) {
+  uint32_t free_slots = smp_tail + STREAM_RING - smp_granted;
+  if (free_slots >= STREAM_CREDIT_CHUNK) sendCredit(free_slots);
+}
+
+#if SD_CARD
+// ---- TF card samples: two sector buffers, the CFS search fills the back one ----
+static uint32_t sd_buf[2][SD_SMP_PER_SECTOR]; // raw CMD_DATA_BATCH words
+static uint16_t sd_n[2];        // samples in a full buffer
+static bool     sd_full[2];
+static uint8_t  sd_front = 0;   // buffer training reads
+static uint16_t sd_pos = 0;     // next sample in it
+static bool     sd_src = false; // samples come from SD_DATA_FILE
+static bool     sd_eof = false; // this pass has been read to the end
+static uint8_t  sd_passes = 0;  // passes left, 0 = endless
+static uint8_t  sd_req = 0;     // CMD_SD op + 1, served by the main loop
+static uint8_t  sd_arg = 0;
+
+static void sd_send_ack(uint8_t op, uint8_t status) {
+  uint8_t payload[10];
+  payload[0] = op;
+  payload[1] = status;
+  wr_u32_le(&payload[2], sd_samples);
+  wr_u32_le(&payload[6], sd_log_sectors);
+  uart_send_frame(CMD_SD_ACK, payload, 10);
+}
+
+// SPI mode 0: init at SD_SPI_INIT_PRSC, then full speed
+static bool sd_mount(void) {
+  if (sd_mounted) return true;
+  if (neorv32_spi_available() == 0) return false;
+  neorv32_spi_setup(SD_SPI_INIT_PRSC, 0, 0, 0);
+  if (pf_mount(&sd_fs) != FR_OK) return false;
+  neorv32_spi_setup(SD_SPI_PRSC, 0, 0, 0);
+  sd_alt = sd_fs;
+  sd_mounted = true;
+  return true;
+}
+
+// next sector of the data file into buffer b; false on a read error
+static bool sd_fill(int b) {
+  UINT br = 0;
+  if (pf_read(sd_buf[b], SD_SECTOR, &br) != FR_OK) return false;
+  if (br < SD_SECTOR) sd_eof = true;         // last, partial sector of the pass
+  sd_n[b] = (uint16_t)(br / 4u);
+  sd_full[b] = (sd_n[b] != 0);
+  return true;
+}
 
-  // reset lazy decay scaling
-  g_err_inv = 1.0f;
+// buffer that wants the next sector (front first), -1 = both full or end of pass
+static inline int sd_empty_buf(void) {
+  if (sd_eof) return -1;
+  if (!sd_full[sd_front]) return sd_front;
+  if (!sd_full[sd_front ^ 1u]) return sd_front ^ 1u;
+  return -1;
+}
+
+static inline uint32_t sd_avail(void) {
+  uint32_t n = sd_full[sd_front] ? (uint32_t)(sd_n[sd_front] - sd_pos) : 0u;
+  if (sd_full[sd_front ^ 1u]) n += sd_n[sd_front ^ 1u];
+  return n;
+}
 
-  nodes[0].x=0.2f; nodes[0].y=0.2f; nodes[0].active=true;
-  nodes[1].x=0.8f; nodes[1].y=0.8f; nodes[1].active=true;
+// CPU-clocked SPI: this is what overlaps the CFS search (cfs_overlap_work)
+static inline void sd_prefetch(void) {
+  int b = sd_src ? sd_empty_buf() : -1;
+  if (b >= 0) (void)sd_fill(b);  // an error is retried (and reported) by sd_service
+}
+
+static sample_t sd_next(void) {
+  uint32_t w = sd_buf[sd_front][sd_pos++];
+  if (sd_pos >= sd_n[sd_front]) {
+    sd_full[sd_front] = false;
+    sd_front ^= 1u;
+    sd_pos = 0;
+  }
+  sd_samples++;
+  return q15_from_wire((int16_t)(w & 0xFFFFu)) | (q15_from_wire((int16_t)(w >> 16)) << 16);
+}
+
+static uint8_t sd_train_start(uint8_t passes) {
+  sd_src = false;
+  if (!sd_mount()) return SD_ERR_CARD;
+  if (pf_open(SD_DATA_FILE) != FR_OK || sd_fs.fsize < 4u) return SD_ERR_DATA;
+  sd_full[0] = sd_full[1] = false;
+  sd_front = 0;
+  sd_pos = 0;
+  sd_eof = false;
+  sd_passes = passes;
+  sd_samples = 0;
+  sd_src = true;
+  running = true;
+  return SD_OK;
+}
+
+// sector 0 = header (count 0 until closed), frames from sector 1
+static uint8_t sd_log_start(bool tee) {
+  sd_tee = tee;
+  if (sd_log_open) return SD_OK;
+  if (!sd_mount()) return SD_ERR_CARD;
+  sd_swap();
+  FRESULT rc = pf_open(SD_LOG_FILE);
+  if (rc == FR_OK && sd_fs.fsize < 2u * SD_SECTOR) rc = FR_NO_FILE;
+  sd_swap();
+  if (rc != FR_OK) return SD_ERR_LOG;
+  sd_log_n = 0;
+  sd_log_sectors = 0;
+  if (!sd_log_header(0)) return SD_ERR_LOG;
+  sd_log_open = sd_log = true;
+  return SD_OK;
+}
+
+// last partial sector, then the header with the final count
+static void sd_log_close(void) {
+  if (!sd_log_open) return;
+  if (sd_log && sd_log_n) sd_log_sector();
+  sd_swap();
+  FRESULT rc = pf_lseek(0);
+  sd_swap();
+  if (rc == FR_OK) sd_log_header(sd_log_sectors);
+  sd_log_open = sd_log = false;
+}
+
+// end of a card run (CMD_SD stop, last pass done, read error): ACK [0][status]
+static void sd_stop(uint8_t status) {
+  sd_src = false;
+  sd_log_close();
+  sd_send_ack(SD_OP_STOP, status);
+}
+
+// between steps: refill what the CFS overlap did not, rewind at the end of a pass
+static void sd_service(int need) {
+  if (sd_avail() >= (uint32_t)need) return;
+  int b = sd_empty_buf();
+  if (b >= 0) {
+    if (!sd_fill(b)) sd_stop(SD_ERR_DATA);
+    return;
+  }
+  if (!sd_eof) return;
+  if (sd_passes == 1u) { sd_stop(SD_OK); return; }
+  if (sd_passes) sd_passes--;
+  if (pf_lseek(0) != FR_OK) { sd_stop(SD_ERR_DATA); return; }
+  sd_eof = false;
+}
+
+static void sd_serve(void) {
+  uint8_t op = (uint8_t)(sd_req - 1u);
+  sd_req = 0;
+  if (op == SD_OP_TRAIN) {
+    sd_send_ack(op, sd_train_start(sd_arg));
+  } else if (op == SD_OP_LOG) {
+    sd_send_ack(op, sd_log_start(sd_arg != 0));
+  } else {
+    sd_stop(SD_OK);
+  }
+}
+#endif // SD_CARD
+
+#if GNG_MODELS > 1
+// ============================ Time-sliced models ================================
+static gng_ctx_t mdl_ctx[GNG_MODELS];     // parked instances (the live one's is stale)
+static int       mdl_lo[GNG_MODELS];      // dataQ section [lo, hi) of each model
+static int       mdl_hi[GNG_MODELS];
+static int       mdl_idx[GNG_MODELS];     // its dataIndex while parked
+static uint32_t  mdl_pass[GNG_MODELS];    // its g_passes while parked
+static uint8_t   mdl_k     = 1;           // models 0..k-1 take turns
+static uint8_t   mdl_live  = 0;           // instance in the gng_core.h state
+static uint8_t   mdl_view  = 0;           // snapshots, PROF, CKPT, SET_PARAMS
+static uint8_t   mdl_shown = 0;           // instance of sent_* / snap_* state
+static uint8_t   mdl_up    = 0;           // CMD_DATA_BATCH target
+static uint16_t  mdl_slice = MODEL_SLICE;
+static uint16_t  mdl_steps = 0;           // steps of the live model in this turn
+static bool      mdl_req   = false;       // CMD_MODEL ACK, served by the main loop
+#if GNG_MODELS > 2
+static bool      mdl_hier  = false;       // model 0 routes the samples to 1..
+static uint8_t   hier_req  = 0;           // CMD_MODEL HIER: 1 + on, served with the ACK
+static sample_t  hier_q[HIER_FINE][HIER_Q];  // routed samples not trained yet
+static uint8_t   hier_n[HIER_FINE];
+#endif
+#if GNG_CFS
+static uint32_t  mdl_banks  = 1;          // CFS node banks (REG_INFO CTX)
+static uint32_t  mdl_synced = 0;          // banks that hold their model's nodes
+static uint32_t  mdl_shadow[GNG_MODELS][MAX_NODES * GNG_WORDS]; // cfs_shadow of each bank
+#endif
+
+// after gng_reset(): every instance starts from the same two seed nodes
+static void models_init(void) {
+  g_node_cap = MAX_NODES;
+  for (int m = 0; m < GNG_MODELS; m++) {
+    gng_ctx_save(&mdl_ctx[m]);
+    mdl_lo[m] = mdl_hi[m] = mdl_idx[m] = 0;
+    mdl_pass[m] = 0;
+  }
+  mdl_k = 1;
+  mdl_live = mdl_view = mdl_shown = mdl_up = 0;
+  mdl_slice = MODEL_SLICE;
+  mdl_steps = 0;
+#if GNG_MODELS > 2
+  mdl_hier = false;
+  memset(hier_n, 0, sizeof(hier_n));
+#endif
+}
+
+#if GNG_CFS
+// after cfs_setup(): bank 0 holds the live model 0
+static void models_cfs_setup(void) {
+  mdl_banks = cfs_ctx_banks();
+  if (mdl_banks > 1u) CFS_WR(CFS_REG_CTX, 0);
+  mdl_synced = 1u;
+}
+#endif
+
+static inline bool model_has_data(int m) { return mdl_hi[m] > mdl_lo[m]; }
+
+// park the live model and make m live; with a CFS bank per model that is
+// one REG_CTX write, one shared bank is rewritten (cfs_sync_nodes_full)
+static void model_switch(uint8_t m) {
+  if (m == mdl_live) return;
+#if GNG_CFS
+  bool banked = g_has_cfs && (mdl_banks >= (uint32_t)GNG_MODELS);
+  if (g_has_cfs) cfs_flush_dirty();       // the live bank gets the last moves
+  if (banked) memcpy(mdl_shadow[mdl_live], cfs_shadow, sizeof(cfs_shadow));
+#endif
+  mdl_idx[mdl_live] = dataIndex;
+  mdl_pass[mdl_live] = g_passes;
+  gng_ctx_switch(&mdl_ctx[mdl_live], &mdl_ctx[m]);
+  mdl_live = m;
+  dataIndex = mdl_idx[m];
+  g_passes = mdl_pass[m];
+  pass_rekey();
+  mdl_steps = 0;
+#if GNG_CFS
+  if (banked) {
+    CFS_WR(CFS_REG_CTX, m);
+    if (mdl_synced & (1u << m)) {
+      memcpy(cfs_shadow, mdl_shadow[m], sizeof(cfs_shadow));
+    } else {
+      cfs_sync_nodes_full();
+      mdl_synced |= 1u << m;
+    }
+  } else if (g_has_cfs) {
+    cfs_sync_nodes_full();
+  }
+#endif
+}
+
+// before a step: the view model alone (k = 1, streams, card runs), else the
+// next model with samples once the live one used its slice
+static void model_turn(void) {
+#if GNG_MODELS > 2
+  if (mdl_hier) return;                   // hier_step() picks the models
+#endif
+  bool rotate = (mdl_k > 1) && !g_stream;
+#if SD_CARD
+  if (sd_src) rotate = false;
+#endif
+#if GNG_GEN
+  if (gen_src) rotate = false;
+#endif
+  if (!rotate) { model_switch(mdl_view); return; }
+  if (mdl_live < mdl_k && mdl_steps < mdl_slice && model_has_data(mdl_live)) return;
+  mdl_steps = 0;
+  for (int k = 1; k <= mdl_k; k++) {
+    uint8_t m = (uint8_t)((mdl_live + k) % mdl_k);
+    if (model_has_data(m)) { model_switch(m); return; }
+  }
+}
+
+static inline bool model_viewed(void) { return mdl_live == mdl_view; }
+
+#if GNG_MODELS > 2
+static void hier_set(bool on);            // after trainOneStep()
+#endif
+
+// CMD_MODEL [op][arg]..: RUN [k][slice lo][slice hi], DATA [m], VIEW [m], HIER [on]
+static void model_cmd(const uint8_t *p, uint8_t len) {
+  if (len >= 2) {
+    uint8_t op = p[0], a = p[1];
+    if (op == MODEL_OP_RUN) {
+      if (a) mdl_k = (a > GNG_MODELS) ? (uint8_t)GNG_MODELS : a;
+      uint16_t slice = (len >= 4) ? (uint16_t)(p[2] | (p[3] << 8)) : 0u;
+      if (slice) mdl_slice = slice;
+    } else if (op == MODEL_OP_DATA && a < GNG_MODELS) {
+      mdl_up = a;                          // its section restarts at the end of dataQ
+      mdl_lo[a] = mdl_hi[a] = mdl_idx[a] = dataCount;
+      mdl_pass[a] = 0;
+      if (a == mdl_live) { dataIndex = dataCount; g_passes = 0; pass_rekey(); }
+    } else if (op == MODEL_OP_VIEW && a < GNG_MODELS) {
+      mdl_view = a;
+#if GNG_MODELS > 2
+    } else if (op == MODEL_OP_HIER) {
+      hier_req = (uint8_t)(1u + (a != 0));
+#endif
+    }
+  }
+  mdl_req = true;   // the view switch and the ACK wait for the end of the step
+}
+
+static void model_serve(void) {
+  mdl_req = false;
+#if GNG_MODELS > 2
+  if (hier_req) {
+    hier_set(hier_req > 1u);
+    hier_req = 0;
+  }
+#endif
+  if (mdl_view != mdl_shown) {
+    model_switch(mdl_view);
+    mdl_shown = mdl_view;
+    snap_resync();         // the host gets a keyframe of the new view
+    snap_mark();
+  }
+
+  uint8_t payload[8 + 6 * GNG_MODELS];
+  uint8_t p = 0;
+  payload[p++] = (uint8_t)GNG_MODELS;
+  payload[p++] = mdl_k;
+  payload[p++] = mdl_view;
+  payload[p++] = mdl_up;
+#if GNG_CFS
+  payload[p++] = g_has_cfs ? (uint8_t)mdl_banks : 0u;
+#else
+  payload[p++] = 0u;
+#endif
+  payload[p++] = (uint8_t)(mdl_slice & 0xFFu);
+  payload[p++] = (uint8_t)(mdl_slice >> 8);
+  for (int m = 0; m < GNG_MODELS; m++) {
+    uint32_t steps = (m == mdl_live) ? stepCount : mdl_ctx[m].step_count;
+    uint32_t n = (uint32_t)(mdl_hi[m] - mdl_lo[m]);
+    wr_u32_le(&payload[p], steps);
+    payload[p + 4] = (uint8_t)(n & 0xFFu);
+    payload[p + 5] = (uint8_t)(n >> 8);
+    p = (uint8_t)(p + 6u);
+  }
+#if GNG_MODELS > 2
+  payload[p++] = mdl_hier ? 1u : 0u;
+#else
+  payload[p++] = 0u;
+#endif
+  uart_send_frame(CMD_MODEL_ACK, payload, p);
+}
+#else
+static inline bool model_viewed(void) { return true; }
+#endif // GNG_MODELS > 1
+
+#if GNG_COMPACT
+// ============================ Compaction ========================================
+static uint32_t compact_step = 0;  // stepCount of the last check
+
+// between two steps: dense renumbering once enough holes piled up
+static void compact_serve(void) {
+  compact_step = stepCount;
+  if (gng_span() - gng_live() < COMPACT_SLACK) return;
+  uint8_t from[COMPACT_MAX], to[COMPACT_MAX];
+  int n = gng_compact(from, to, COMPACT_MAX);
+  if (n == 0 || !model_viewed()) return;  // other models are not on screen
+
+  uint8_t payload[2 + 2 * COMPACT_MAX];
+  payload[0] = frame_id;
+  payload[1] = (uint8_t)n;
+  for (int k = 0; k < n; k++) {
+    payload[2 + 2 * k] = from[k];
+    payload[3 + 2 * k] = to[k];
+  }
+  uart_send_frame(CMD_GNG_REMAP, payload, (uint8_t)(2 + 2 * n));
+  snap_resync();  // the delta state still has the old ids
+}
+#endif
+
+static inline bool samples_ready(int n) {
+#if SD_CARD
+  if (sd_src) return sd_avail() >= (uint32_t)n;
+#endif
+#if GNG_GEN
+  if (gen_src) return true;
+#endif
+  if (g_stream) return (smp_head - smp_tail) >= (uint32_t)n;
+#if GNG_MODELS > 2
+  return dataDone && model_has_data(mdl_hier ? 0 : mdl_live);  // hier: model 0 reads dataQ
+#elif GNG_MODELS > 1
+  return dataDone && model_has_data(mdl_live);
+#else
+  return dataDone && (dataCount > 0);
+#endif
+}
+
+// next training sample: card file, generator, stream ring, or cycle over the uploaded dataset
+static inline sample_t next_sample(void) {
+#if SD_CARD
+  if (sd_src) return sd_next();
+#endif
+#if GNG_GEN
+  if (gen_src) return gng_gen_next(&g_gen);
+#endif
+  smp_fence();  // GNG_SMP: the sample behind smp_head / dataCount, not a stale copy
+  if (g_stream) return smp_q[(smp_tail++) & (STREAM_RING - 1u)];
+#if GNG_MODELS > 1
+  const int lo = mdl_lo[mdl_live], hi = mdl_hi[mdl_live];
+#else
+  const int lo = 0, hi = dataCount;
+#endif
+  int i = dataIndex;
+#if GNG_SHUFFLE
+  if (train_order == ORDER_SHUFFLE)
+    i = lo + (int)gng_perm_at(&g_perm, (uint32_t)(dataIndex - lo), (uint32_t)(hi - lo));
+#endif
+  sample_t s = dataQ[i];
+  if (++dataIndex >= hi) {
+    dataIndex = lo;
+    g_passes++;
+    pass_rekey();
+  }
+  return s;
+}
+
+#if CFS_PRELOAD
+// the sample next_sample() would return, without taking it; false if unknown
+static inline bool peek_sample(sample_t *s) {
+#if SD_CARD
+  if (sd_src) return false;
+#endif
+#if GNG_GEN
+  if (gen_src) { *s = gng_gen_at(&g_gen, g_gen.n); return true; }
+#endif
+  if (g_stream) {
+    if (smp_head == smp_tail) return false;
+    *s = smp_q[smp_tail & (STREAM_RING - 1u)];
+    return true;
+  }
+#if GNG_MODELS > 1
+  const int lo = mdl_lo[mdl_live], hi = mdl_hi[mdl_live];
+#else
+  const int lo = 0, hi = dataCount;
+#endif
+  if (hi <= lo) return false;
+  int i = dataIndex;
+#if GNG_SHUFFLE
+  if (train_order == ORDER_SHUFFLE)
+    i = lo + (int)gng_perm_at(&g_perm, (uint32_t)(dataIndex - lo), (uint32_t)(hi - lo));
+#endif
+  *s = dataQ[i];
+  return true;
+}
+#endif
+
+// ACK at the old rate, let it leave the wire, then switch
+static void uart_set_baud(uint32_t baud) {
+  uint32_t actual = uart_baud_actual(baud);
+  uint32_t diff = (actual > baud) ? (actual - baud) : (baud - actual);
+  if ((actual == 0) || ((uint64_t)diff * 1000000u > (uint64_t)baud * BAUD_MAX_ERR_PPM)) actual = 0;
+
+  uint8_t payload[4];
+  wr_u32_le(payload, actual);
+  uart_send_frame(CMD_BAUD_ACK, payload, 4);
+  if (actual == 0) return;
+
+#if UART_TX_IRQ
+  while (tx_tail != tx_head) { }
+#endif
+  while (NEORV32_UART0->CTRL & (1u << UART_CTRL_TX_BUSY)) { }
+#if GNG_CFS_DUMP
+  while (g_cfs_dump && cfs_dump_busy()) { }
+#endif
+  neorv32_uart0_setup(baud, 0);
+#if UART_TX_IRQ
+  NEORV32_UART0->CTRL |= (1u << UART_CTRL_IRQ_RX_NEMPTY);
+#endif
+#if GNG_CFS_DUMP
+  if (g_cfs_dump) {
+    NEORV32_UART0->CTRL |= (1u << UART_CTRL_HWFC_EN);
+    cfs_dump_setup(baud);
+  }
+#endif
+}
+
+// ACK first (board->host frames keep FF FF), then clear / switch. The COBS
+// parser starts in RX_WAIT_END: the host sends a 00 before its first frame.
+static void link_command(uint8_t op) {
+  uint8_t code = (uint8_t)(op & (uint8_t)~LINK_OP_CLEAR);
+  if (code == LINK_OP_PAD) return;
+  if (code == LINK_OP_COBS) {
+    rx_framing = RX_FRAMING_COBS;
+    rx_state = RX_WAIT_END;
+  } else if (code == LINK_OP_LEGACY) {
+    rx_framing = RX_FRAMING_FF;
+    rx_state = RX_WAIT_H1;
+  }
+  uint8_t payload[17];
+  payload[0] = rx_framing;
+  wr_u32_le(&payload[1], g_rx_ok);
+  wr_u32_le(&payload[5], g_rx_bad);
+  wr_u32_le(&payload[9], g_rx_skip);
+  wr_u32_le(&payload[13], g_rx_lost);
+  uart_send_frame(CMD_LINK_ACK, payload, sizeof(payload));
+  if (op & LINK_OP_CLEAR) {
+    g_rx_ok = 0; g_rx_bad = 0; g_rx_skip = 0; g_rx_lost = 0;
+  }
+}
+
+#if GNG_PARAMS_RT
+// ============================ Runtime parameters ================================
+#if GNG_DRIFT
+#define PAR_WORDS  11            // + drift rise, hold, eps, lambda div, a_max div
+#else
+#define PAR_WORDS  6
+#endif
+
+static uint8_t  par_req = 0;     // CMD_SET_PARAMS: 1 = query, 2 = set, 3 = set + drift
+static uint32_t par_new[PAR_WORDS];  // lambda, a_max, eps_b, eps_n, alpha, d (Q16), drift
+
+static inline uint32_t par_q16(coef_t c) {
+#if GNG_FIXED
+  return (uint32_t)c;
+#else
+  return (uint32_t)(c * 65536.0f + 0.5f);
+#endif
+}
+
+// the values in use, in CMD_SET_PARAMS order
+static void params_get(uint32_t v[PAR_WORDS]) {
+  v[0] = g_par.lambda;
+  v[1] = g_par.a_max;
+  v[2] = par_q16(g_par.eps_b);
+  v[3] = par_q16(g_par.eps_n);
+  v[4] = par_q16(g_par.alpha);
+  v[5] = g_par.d_q16;
+#if GNG_DRIFT
+  v[6] = g_par.drift_rise;
+  v[7] = g_par.drift_hold;
+  v[8] = g_par.drift_eps;
+  v[9] = g_par.drift_lambda_div;
+  v[10] = g_par.drift_amax_div;
+#endif
+}
+
+static void params_to_cfs(void) {
+#if GNG_CFS
+  if (!g_has_cfs) return;
+  uint32_t v[PAR_WORDS];
+  params_get(v);
+  for (int k = 0; k < 6; k++) CFS_WR(CFS_REG_LAMBDA + k, v[k]);
+#if GNG_CFS_MOVE
+  g_cfs_eps[0] = g_cfs_eps[1] = ~0u;  // the next cfs_start_move() rewrites the step rates
+#endif
+#endif
+}
+
+static void params_serve(void) {
+#if GNG_MODELS > 1
+  model_switch(mdl_view);          // the parameters belong to the instance
+#endif
+  if (par_req >= 2u) {
+#if GNG_DRIFT
+    if (par_req == 3u) gng_drift_set(par_new[6], par_new[7], par_new[8], par_new[9], par_new[10]);
+#endif
+    gng_params_set(par_new[0], par_new[1], par_new[2], par_new[3], par_new[4], par_new[5]);
+    params_to_cfs();
+  }
+  par_req = 0;
+
+  uint32_t v[PAR_WORDS];
+  uint8_t payload[4 * PAR_WORDS];
+  params_get(v);
+  for (int k = 0; k < PAR_WORDS; k++) wr_u32_le(&payload[4 * k], v[k]);
+  uart_send_frame(CMD_PARAMS_ACK, payload, 4 * PAR_WORDS);
+}
+#endif // GNG_PARAMS_RT
+
+#if CFS_PERF
+// ============================ CFS perf counters =================================
+static bool    g_cfs_perf = false;  // INFO bit 26
+static uint8_t perf_req   = 0;      // CMD_CFS_PERF op + 1, served by the main loop
+
+static void perf_serve(void) {
+  const bool clear = (perf_req == 2u);
+  perf_req = 0;
+
+  uint32_t v[CFS_PERF_N] = {0};
+  uint8_t payload[1 + 4 * CFS_PERF_N];
+  if (g_cfs_perf) cfs_perf_read(v, clear);
+  payload[0] = g_cfs_perf ? 1u : 0u;
+  for (int k = 0; k < CFS_PERF_N; k++) wr_u32_le(&payload[1 + 4 * k], v[k]);
+  uart_send_frame(CMD_CFS_PERF_ACK, payload, sizeof payload);
+}
+#endif // CFS_PERF
+
+// ============================ Health stats ======================================
+static uint16_t stats_ms    = STATS_MS;  // 0 = off
+static bool     stats_req   = false;     // CMD_STATS without payload: one now
+static uint64_t stats_cyc   = 0;         // mcycle of the last frame
+static uint32_t stats_steps = 0;         // steps run since then (all models)
+
+static void stats_send(void) {
+  const uint64_t now = rdcycle64();
+  const uint32_t cyc = (uint32_t)(now - stats_cyc);
+  const uint32_t sps = cyc ? (uint32_t)((uint64_t)stats_steps * CPU_HZ / cyc) : 0u;
+  uint32_t deg = 0;
+  for (int i = 0; i < MAX_NODES; i++)
+    if (nodes[i].active) deg += degree[i];
+
+  uint8_t payload[48];
+  wr_u32_le(&payload[0], stats_steps);
+  wr_u32_le(&payload[4], cyc);
+  wr_u32_le(&payload[8], sps);
+  payload[12] = (uint8_t)gng_live();  payload[13] = (uint8_t)(gng_live() >> 8);
+  payload[14] = (uint8_t)(deg / 2u);  payload[15] = (uint8_t)((deg / 2u) >> 8);
+  wr_u32_le(&payload[16], g_rx_ok);
+  wr_u32_le(&payload[20], g_rx_bad);
+  wr_u32_le(&payload[24], uart_tx_queued());
+  wr_u32_le(&payload[28], uart_tx_sent());
+  wr_u32_le(&payload[32], g_inserts);
+  wr_u32_le(&payload[36], g_renorms);
+  wr_u32_le(&payload[40], snap_every);
+  wr_u32_le(&payload[44], snap_io_pm);
+  uart_send_frame(CMD_STATS_FRAME, payload, sizeof payload);
+
+  stats_cyc = now;
+  stats_steps = 0;
+  stats_req = false;
+}
+
+static inline void stats_poll(void) {
+  if (stats_req ||
+      (stats_ms && (rdcycle64() - stats_cyc) >= (uint64_t)stats_ms * (CPU_HZ / 1000u)))
+    stats_send();
+}
+
+#if GNG_TRACE
+// ============================ Execution trace (neorv32_tracer) ==================
+#define TRACE_HDR      13   // step, cycles, first, n, flags
+#define TRACE_REC_MAX  ((255 - TRACE_HDR) / 8)
+#define TRACE_LAST     0x01u
+#define TRACE_NONE     0x02u
+#define TRACE_NO_STOP  0xFFFFFFFEu  // IO space, never executed: no auto-stop
+
+static uint8_t  trace_left = 0;     // CMD_TRACE: steps still to capture
+static uint64_t trace_t0;
+
+// tracer cleared (EN = 0 flushes the buffer) and started on hart 0; a pass
+// that runs no step (no samples yet) simply starts it again
+static void trace_start(void) {
+  if (!neorv32_tracer_available()) return;  // trace_dump() reports it
+  NEORV32_TRACER->CTRL = 0;
+  NEORV32_TRACER->STOP_ADDR = TRACE_NO_STOP;
+  NEORV32_TRACER->CTRL = (1u << TRACER_CTRL_EN) | (1u << TRACER_CTRL_START);
+  trace_t0 = rdcycle64();
+}
+
+static void trace_frame(uint32_t cycles, uint16_t first, const uint32_t *rec, uint8_t n, uint8_t flags) {
+  uint8_t payload[TRACE_HDR + 8 * TRACE_REC_MAX];
+  wr_u32_le(&payload[0], stepCount);
+  wr_u32_le(&payload[4], cycles);
+  payload[8]  = (uint8_t)(first & 0xFFu);
+  payload[9]  = (uint8_t)(first >> 8);
+  payload[10] = n;
+  payload[11] = flags;
+  payload[12] = 0;
+  for (int k = 0; k < 2 * n; k++) wr_u32_le(&payload[TRACE_HDR + 4 * k], rec[k]);
+  uart_send_frame(CMD_TRACE_DATA, payload, (uint8_t)(TRACE_HDR + 8 * n));
+}
+
+// stop, then drain the buffer oldest first (a DELTA_DST read pops the pair)
+static void trace_dump(void) {
+  trace_left--;
+  if (!neorv32_tracer_available()) {
+    trace_frame(0, 0, 0, 0, TRACE_LAST | TRACE_NONE);
+    trace_left = 0;
+    return;
+  }
+  NEORV32_TRACER->CTRL = (1u << TRACER_CTRL_EN) | (1u << TRACER_CTRL_STOP);
+  const uint32_t cycles = (uint32_t)(rdcycle64() - trace_t0);
+
+  uint32_t rec[2 * TRACE_REC_MAX];
+  uint16_t first = 0;
+  uint8_t n = 0;
+  while (NEORV32_TRACER->CTRL & (1u << TRACER_CTRL_AVAIL)) {
+    rec[2 * n]     = NEORV32_TRACER->DELTA_SRC;
+    rec[2 * n + 1] = NEORV32_TRACER->DELTA_DST;
+    if (++n == TRACE_REC_MAX) {
+      trace_frame(cycles, first, rec, n, 0);
+      first = (uint16_t)(first + n);
+      n = 0;
+    }
+  }
+  trace_frame(cycles, first, rec, n, TRACE_LAST);
+  NEORV32_TRACER->CTRL = 0;
+}
+#endif // GNG_TRACE
+
+#if GNG_CKPT
+// ============================ User flash checkpoint =============================
+static uint32_t ckpt_seq  = 0;   // newest valid record, 0 = none
+static int      ckpt_slot = -1;
+static uint8_t  ckpt_req  = 0;   // CMD_CKPT op + 1, served by the main loop
+static uint64_t ckpt_last_wr = 0;
+static volatile uint32_t *ckpt_dst;
+
+static inline volatile uint32_t *ckpt_slot_addr(int s) {
+  return (volatile uint32_t *)(UFLASH_BASE_ADDR +
+                               (CKPT_PAGE0 + (uint32_t)s * CKPT_SLOT_PAGES) * UFLASH_PAGE_SIZE);
+}
+
+// 32-bit write = program (once per erase)
+static void ckpt_put(int k, uint32_t w) { ckpt_dst[k] = w; }
+
+static void ckpt_scan(void) {
+  ckpt_seq = 0;
+  ckpt_slot = -1;
+  for (int s = 0; s < 2; s++) {
+    uint32_t q = gng_ckpt_check(ckpt_slot_addr(s));
+    if (q > ckpt_seq) { ckpt_seq = q; ckpt_slot = s; }
+  }
+}
+
+// 8-bit write into a page erases it; uflash wants 10 ms after the last program
+static void ckpt_erase_slot(int s) {
+  while (rdcycle64() - ckpt_last_wr < CPU_HZ / 100u) { }
+  volatile uint8_t *p = (volatile uint8_t *)ckpt_slot_addr(s);
+  for (uint32_t g = 0; g < CKPT_SLOT_PAGES; g++) p[g * UFLASH_PAGE_SIZE] = 0;
+}
+
+// older slot <- current state, read back before it counts
+static bool ckpt_save(void) {
+  int s = (ckpt_slot == 0) ? 1 : 0;
+  uint32_t seq = ckpt_seq + 1u;
+  ckpt_erase_slot(s);
+  ckpt_dst = ckpt_slot_addr(s);
+  gng_ckpt_write(ckpt_put, seq);
+  ckpt_last_wr = rdcycle64();
+  if (gng_ckpt_check(ckpt_dst) != seq) return false;
+  ckpt_seq = seq;
+  ckpt_slot = s;
+  return true;
+}
+
+static bool ckpt_load(void) {
+  ckpt_scan();
+  if (ckpt_slot < 0) return false;
+  gng_ckpt_load(ckpt_slot_addr(ckpt_slot));
+#if GNG_CFS
+  if (g_has_cfs) cfs_sync_nodes_full();  // at boot cfs_setup() does it
+#endif
+  snap_resync();                         // next snapshot is a keyframe
+  snap_mark();
+  return true;
+}
+
+static void ckpt_serve(void) {
+  uint8_t op = (uint8_t)(ckpt_req - 1u);
+  bool ok = true;
+  ckpt_req = 0;
+#if GNG_MODELS > 1
+  model_switch(mdl_view);          // a record holds one instance
+#endif
+  if (op == CKPT_SAVE) {
+    ok = ckpt_save();
+  } else if (op == CKPT_LOAD) {
+    ok = ckpt_load();
+  } else {
+    ckpt_erase_slot(0);
+    ckpt_erase_slot(1);
+    ckpt_scan();
+    ok = (ckpt_slot < 0);
+  }
+
+  uint8_t payload[6];
+  payload[0] = op;
+  payload[1] = ok ? 1u : 0u;
+  wr_u32_le(&payload[2], ckpt_seq);
+  uart_send_frame(CMD_CKPT_ACK, payload, 6);
+}
+#endif // GNG_CKPT
+
+// ============================ Query ring (CMD_QUERY) ============================
+// written by the RX side (hart 1 under GNG_SMP: too long for the command
+// ring), served by the main loop between two steps
+typedef struct {
+  uint8_t len;
+  uint8_t payload[255];
+} qry_t;
+
+static qry_t               qry_q[QRY_RING];
+static SMP_SHARED uint32_t qry_head = 0;
+static SMP_SHARED uint32_t qry_tail = 0;
+
+static void qry_accept(const uint8_t *payload, uint8_t len) {
+  const uint32_t h = qry_head;
+  if (len < QRY_HDR || (h - qry_tail) >= QRY_RING) return;
+  qry_t *q = &qry_q[h & (QRY_RING - 1u)];
+  memcpy(q->payload, payload, len);
+  q->len = len;
+  smp_fence();
+  qry_head = h + 1u;
+}
+
+static inline bool qry_pending(void) { return qry_tail != qry_head; }
+
+// ============================ Network seed staging (CMD_SEED) ===================
+// the frames only fill the staging area (readSerial also runs during a CFS
+// search), seed_serve() swaps the network in between two steps
+static uint8_t  seed_wire[MAX_NODES][SMP_WIRE_BYTES];  // wire samples as received
+static uint32_t seed_has[ACT_WORDS];
+static uint8_t  seed_edge[SEED_EDGES][2];
+static uint16_t seed_ne   = 0;
+static uint8_t  seed_lost = 0;
+static bool     seed_req  = false;
+
+static void seed_accept(const uint8_t *p, uint8_t len) {
+  if (p[0] == SEED_OP_BEGIN) {
+    for (int w = 0; w < ACT_WORDS; w++) seed_has[w] = 0;
+    seed_ne = 0;
+    seed_lost = 0;
+  } else if (p[0] == SEED_OP_NODES && len >= 3) {
+    int n = p[2];
+    if (n > (len - 3) / SMP_WIRE_BYTES) n = (len - 3) / SMP_WIRE_BYTES;
+    for (int k = 0, i = p[1]; k < n && i < MAX_NODES; k++, i++) {
+      memcpy(seed_wire[i], &p[3 + k * SMP_WIRE_BYTES], SMP_WIRE_BYTES);
+      seed_has[i >> 5] |= GNG_BIT(i);
+    }
+  } else if (p[0] == SEED_OP_EDGES && len >= 2) {
+    int n = p[1];
+    if (n > (len - 2) / 2) n = (len - 2) / 2;
+    for (int k = 0; k < n; k++) {
+      uint8_t a = p[2 + 2 * k], b = p[3 + 2 * k];
+      if (a >= MAX_NODES || b >= MAX_NODES || a == b) continue;
+      if (seed_ne >= SEED_EDGES) { if (seed_lost < 255u) seed_lost++; continue; }
+      seed_edge[seed_ne][0] = a;
+      seed_edge[seed_ne][1] = b;
+      seed_ne++;
+    }
+  } else if (p[0] == SEED_OP_COMMIT) {
+    seed_req = true;
+  }
+}
+
+// ============================ UART RX ===========================================
+// CMD_DATA_BATCH in place: [count] then count * [x lo][x hi][y lo][y hi]
+// (GNG_DIM > 2: count * GNG_DIM components)
+static uint8_t  rx_batch_cnt = 0;
+static uint32_t rx_batch_stored = 0; // slots written behind the committed end
+static uint32_t rx_batch_raw = 0;
+
+// k-th sample of this frame, 0 when the destination is full
+static inline sample_t *rx_batch_slot(uint32_t k) {
+  if (g_stream) {
+    if ((smp_head + k - smp_tail) >= STREAM_RING) return 0;
+    return &smp_q[(smp_head + k) & (STREAM_RING - 1u)];
+  }
+  if ((uint32_t)dataCount + k >= MAXPTS) return 0;
+  return &dataQ[dataCount + k];
+}
+
+#if GNG_DIM > 2
+static inline void rx_batch_byte(uint8_t idx, uint8_t b) {
+  if (idx == 0) { rx_batch_cnt = b; return; }
+  uint32_t j = (uint32_t)(idx - 1u);
+  if (!(j & 1u)) { rx_batch_raw = b; return; }
+  rx_batch_raw |= (uint32_t)b << 8;
+
+  uint32_t k = j / SMP_WIRE_BYTES;
+  uint32_t c = (j % SMP_WIRE_BYTES) >> 1;
+  sample_t *slot = (k < rx_batch_cnt) ? rx_batch_slot(k) : 0;
+  if (slot && k == rx_batch_stored) {
+    uint32_t q = q15_from_wire((int16_t)rx_batch_raw);
+    if (c & 1u) slot->w[c >> 1] |= q << 16;
+    else        slot->w[c >> 1] = q;  // high half 0 until its component (odd D: stays 0)
+    if (c == GNG_DIM - 1u) rx_batch_stored++;
+  }
+  rx_batch_raw = 0;
+}
+#else
+static inline void rx_batch_byte(uint8_t idx, uint8_t b) {
+  if (idx == 0) { rx_batch_cnt = b; return; }
+  uint32_t j = (uint32_t)(idx - 1u) & 3u;
+  rx_batch_raw |= (uint32_t)b << (8u * j);
+  if (j != 3u) return;
+
+  uint32_t k = (uint32_t)(idx - 1u) >> 2;
+  sample_t *slot = (k < rx_batch_cnt) ? rx_batch_slot(k) : 0;
+  if (slot && k == rx_batch_stored) {
+    *slot = q15_from_wire((int16_t)(rx_batch_raw & 0xFFFFu)) |
+            (q15_from_wire((int16_t)(rx_batch_raw >> 16)) << 16);
+    rx_batch_stored++;
+  }
+  rx_batch_raw = 0;
+}
+#endif
+
+static void rx_batch_commit(uint8_t len) {
+  if (len < 1 || len < 1u + rx_batch_cnt * SMP_WIRE_BYTES) return;
+  smp_fence();  // GNG_SMP: slots before the index hart 0 reads them behind
+  if (g_stream) {
+    smp_head += rx_batch_stored;
+    g_smp_dropped += rx_batch_cnt - rx_batch_stored;
+  } else {
+    dataCount += (int)rx_batch_stored;
+    g_rx_lost += rx_batch_cnt - rx_batch_stored;
+#if GNG_MODELS > 1
+    mdl_hi[mdl_up] = dataCount;
+#endif
+  }
+}
+
+static void handleCommand(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  if (cmd == CMD_DONE) {
+    dataDone = true;
+  } else if (cmd == CMD_RUN) {
+    running = true;
+#if GNG_CONVERGE
+    conv_arm();
+#endif
+  } else if (cmd == CMD_STREAM) {
+    stream_start();
+  } else if (cmd == CMD_SNAP_MODE) {
+    if (len < 1) return;
+    snap_mode_set(payload, len);
+#if GNG_CONVERGE
+  } else if (cmd == CMD_CONVERGE) {
+    if (len < 1) return;
+    conv_set(payload, len);
+#endif
+  } else if (cmd == CMD_TRAIN_MODE) {
+    if (len < 1) return;
+    train_mode = payload[0] ? TRAIN_DBL : TRAIN_ONLINE;
+#if GNG_SHUFFLE
+    if (len >= 2) train_order = payload[1] ? ORDER_SHUFFLE : ORDER_UPLOAD;
+#endif
+#if GNG_CKPT
+  } else if (cmd == CMD_CKPT) {
+    if (len < 1) return;
+    ckpt_req = (uint8_t)(payload[0] + 1u);  // not mid-step: readSerial also runs during a CFS search
+#endif
+#if SD_CARD
+  } else if (cmd == CMD_SD) {
+    if (len < 1) return;
+    sd_arg = (len >= 2) ? payload[1] : (payload[0] == SD_OP_TRAIN ? 1u : 0u);
+    sd_req = (uint8_t)(payload[0] + 1u);    // same: the sample source only changes between steps
+#endif
+#if GNG_PARAMS_RT
+  } else if (cmd == CMD_SET_PARAMS) {
+    const int n = (len >= 4 * PAR_WORDS) ? PAR_WORDS : (len >= 24) ? 6 : 0;
+    for (int k = 0; k < n; k++) {
+      const uint8_t *p = &payload[4 * k];
+      par_new[k] = (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+    }
+    par_req = (n > 6) ? 3u : n ? 2u : 1u;   // between steps, like CMD_CKPT
+#endif
+#if GNG_MODELS > 1
+  } else if (cmd == CMD_MODEL) {
+    model_cmd(payload, len);
+#endif
+  } else if (cmd == CMD_QUERY) {
+    qry_accept(payload, len);
+  } else if (cmd == CMD_SEED) {
+    if (len < 1) return;
+    seed_accept(payload, len);
+  } else if (cmd == CMD_EVAL) {
+    eval_every = (len >= 4) ? ((uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+                               ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24)) : 0u;
+    eval_req = true;               // between two steps, like CMD_QUERY
+#if GNG_GEN
+  } else if (cmd == CMD_GEN) {
+    if (len < 1) return;
+    gen_seed = (len >= 5) ? ((uint32_t)payload[1] | ((uint32_t)payload[2] << 8) |
+                             ((uint32_t)payload[3] << 16) | ((uint32_t)payload[4] << 24)) : 0u;
+    gen_req = (uint8_t)(payload[0] + 1u);  // the sample source only changes between steps
+#endif
+#if GNG_TRACE
+  } else if (cmd == CMD_TRACE) {
+    trace_left = (len >= 1 && payload[0]) ? payload[0] : 1u;
+#endif
+#if CFS_PERF
+  } else if (cmd == CMD_CFS_PERF) {
+    perf_req = (len >= 1 && payload[0]) ? 2u : 1u;  // ACK between steps, like CMD_CKPT
+#endif
+  } else if (cmd == CMD_STATS) {
+    if (len >= 2) stats_ms = (uint16_t)(payload[0] | (payload[1] << 8));
+    else stats_req = true;
+  } else if (cmd == CMD_LINK) {
+    if (len < 1) return;
+    link_command(payload[0]);
+  } else if (cmd == CMD_SET_BAUD) {
+    if (len < 4) return;
+    uart_set_baud((uint32_t)payload[0] | ((uint32_t)payload[1] << 8) |
+                  ((uint32_t)payload[2] << 16) | ((uint32_t)payload[3] << 24));
+  }
+}
+
+#if GNG_SMP
+// ============================ Command ring (hart 1 -> hart 0) ===================
+typedef struct {
+  uint8_t cmd, len;
+  uint8_t payload[SMP_CMD_MAX];
+} smp_cmd_t;
+
+static smp_cmd_t         cmdq[SMP_CMD_RING];
+static volatile uint32_t cmdq_head = 0; // written by hart 1
+static volatile uint32_t cmdq_tail = 0; // written by hart 0
+
+// hart 1: dropped on a full ring, the host's request times out and is sent again
+static void cmdq_push(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  const uint32_t h = cmdq_head;
+  if ((h - cmdq_tail) >= SMP_CMD_RING) return;
+  smp_cmd_t *c = &cmdq[h & (SMP_CMD_RING - 1u)];
+  if (len > SMP_CMD_MAX) len = SMP_CMD_MAX;
+  c->cmd = cmd;
+  c->len = len;
+  for (uint8_t i = 0; i < len; i++) c->payload[i] = payload[i];
+  smp_fence();
+  cmdq_head = h + 1u;
+}
+
+// hart 0, between two steps: what readSerial() would have run
+static void cmdq_poll(void) {
+  uint32_t t = cmdq_tail;
+  while (t != cmdq_head) {
+    smp_fence();
+    const smp_cmd_t *c = &cmdq[t & (SMP_CMD_RING - 1u)];
+    handleCommand(c->cmd, c->payload, c->len);
+    cmdq_tail = ++t;
+  }
+}
+#endif
+
+// one frame byte: FF FF CMD LEN PAYLOAD CHK, or CMD .. CHK of a COBS frame
+static inline void rx_frame_byte(uint8_t b) {
+  switch (rx_state) {
+    case RX_WAIT_H1:
+      if (b == UART_HDR) rx_state = RX_WAIT_H2;
+      else g_rx_skip++;
+      break;
+    case RX_WAIT_H2:
+      if (b == UART_HDR) rx_state = RX_WAIT_CMD;
+      else { rx_state = RX_WAIT_H1; g_rx_skip += 2u; }
+      break;
+    case RX_WAIT_CMD:
+      rx_cmd = b; rx_sum = b; rx_state = RX_WAIT_LEN;
+      break;
+    case RX_WAIT_LEN:
+      rx_len = b;
+      rx_sum = (uint8_t)(rx_sum + b);
+      rx_index = 0;
+      rx_batch_cnt = 0; rx_batch_stored = 0; rx_batch_raw = 0;
+      if (rx_len == 0) rx_state = RX_WAIT_CHK;
+      else if (rx_len > sizeof(rx_payload)) {
+        g_rx_bad++;
+        rx_state = (rx_framing == RX_FRAMING_COBS) ? RX_WAIT_END : RX_WAIT_H1;
+      }
+      else if (rx_cmd == CMD_DATA_BATCH) rx_state = RX_WAIT_BATCH;
+      else rx_state = RX_WAIT_PAYLOAD;
+      break;
+    case RX_WAIT_PAYLOAD:
+      rx_payload[rx_index++] = b;
+      rx_sum = (uint8_t)(rx_sum + b);
+      if (rx_index >= rx_len) rx_state = RX_WAIT_CHK;
+      break;
+    case RX_WAIT_BATCH:
+      rx_batch_byte(rx_index++, b);
+      rx_sum = (uint8_t)(rx_sum + b);
+      if (rx_index >= rx_len) rx_state = RX_WAIT_CHK;
+      break;
+    case RX_WAIT_CHK: {
+      uint8_t expected = (uint8_t)(~rx_sum);
+      // set before the dispatch: CMD_LINK switches the framing
+      rx_state = (rx_framing == RX_FRAMING_COBS) ? RX_WAIT_END : RX_WAIT_H1;
+      if (b != expected) {
+        g_rx_bad++;  // bad frame: written batch slots stay uncommitted
+        break;
+      }
+      g_rx_ok++;
+      if (rx_cmd == CMD_DATA_BATCH) {
+        rx_batch_commit(rx_len);
+#if GNG_SMP
+      } else if (rx_cmd == CMD_QUERY) {
+        qry_accept(rx_payload, rx_len);         // hart 0 serves it from the ring
+      } else if (rx_cmd != CMD_SET_BAUD && rx_cmd != CMD_LINK) {
+        cmdq_push(rx_cmd, rx_payload, rx_len);  // hart 0 owns the GNG state
+#endif
+      } else {
+        handleCommand(rx_cmd, rx_payload, rx_len);
+      }
+      break;
+    }
+    case RX_WAIT_END:
+      g_rx_skip++;
+      break;
+    default:
+      rx_state = RX_WAIT_H1;
+      break;
+  }
+}
+
+// COBS framing: 00 ends a frame and restarts the parser, each group code
+// gives the data bytes up to the next encoded 00 (0xFF: no 00 after them)
+static inline void rx_cobs_byte(uint8_t b) {
+  if (b == 0) {
+    if (rx_state != RX_WAIT_END && rx_state != RX_WAIT_CMD) g_rx_bad++;  // cut short
+    rx_state = RX_WAIT_CMD;
+    cobs_left = 0;
+    cobs_zero = false;
+    return;
+  }
+  if (rx_state == RX_WAIT_END) { g_rx_skip++; return; }
+  if (cobs_left == 0) {
+    if (cobs_zero) rx_frame_byte(0u);
+    cobs_left = (uint8_t)(b - 1u);
+    cobs_zero = (b != 0xFFu);
+    return;
+  }
+  cobs_left--;
+  rx_frame_byte(b);
+}
+
+static void readSerial(void) {
+  uint8_t b;
+  while (uart_rx_get(&b)) {
+    if (rx_framing == RX_FRAMING_COBS) rx_cobs_byte(b);
+    else rx_frame_byte(b);
+  }
+}
+
+#if GNG_CFS
+// ============================ CFS helpers =======================================
+// Work that does not touch node positions / active mask, safe to run while
+// the CFS searches. Returns cycles spent (charged to cyc_overlap, not winner).
+static uint32_t cfs_overlap_work(void) {
+#if CFS_USE_IRQ
+  uint64_t t0 = rdcycle64();
+#if !GNG_SMP
+  readSerial();
+#endif
+#if SD_CARD
+  sd_prefetch();
+#endif
+  return (uint32_t)(rdcycle64() - t0);
+#else
+  return 0;
+#endif
+}
+
+#if GNG_DIM == 2
+// push bs[0 .. n) (n <= CFS_SMP_DEPTH) and start a batch scan
+static void cfs_batch_start(const sample_t *bs, int n) {
+  for (int k = 0; k < n; k++) CFS_WR(CFS_REG_SMP_PUSH, bs[k]);
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_BATCH);
+}
+
+// wait for n results and pop them; false (FIFOs flushed) on timeout
+static bool cfs_batch_read(int n, uint32_t *s12, uint32_t *d1) {
+  const uint32_t TIMEOUT = 200000u;
+  bool ok = false;
+  for (uint32_t t = 0; t < TIMEOUT; t++) {
+    if (((CFS_RD(CFS_REG_BATCH) >> 8) & 0x3Fu) >= (uint32_t)n) { ok = true; break; }
+  }
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_CLEAR | CFS_CTRL_MODE); // leave batch mode
+  if (!ok) {
+    CFS_WR(CFS_REG_CTRL, CFS_CTRL_FLUSH | CFS_CTRL_MODE);
+    return false;
+  }
+  for (int k = 0; k < n; k++) {
+    s12[k] = CFS_RD(CFS_REG_RES_S12);
+    d1[k]  = CFS_RD(CFS_REG_RES_MIN1); // pops
+  }
+  return true;
+}
+#endif
+
+#endif // GNG_CFS
+
+// ============================ GNG Step (CPU Fritzke-ish) =========================
+// returns the winner s1 (-1: none)
+static int trainOneStep(sample_t smp) {
+  const pos_t x = sample_x(smp), y = sample_y(smp);
+  sample_load_z(&smp);
+  gng_prof_clear();
+
+  uint64_t t_total0 = rdcycle64();
+
+  int s1=-1, s2=-1;
+  dist_t d1 = DIST_MAX;
+
+  // (1) winners
+  uint64_t t0 = rdcycle64();
+#if GNG_CFS
+#if GNG_CFS_MOVE
+  cfs_start_move(smp);             // gng_update() picks up the moves
+#else
+  cfs_start_winners(smp);
+#endif
+#if CFS_PRELOAD
+  sample_t nx;
+  if (g_cfs_dbuf && peek_sample(&nx)) cfs_preload(nx);
+#endif
+  g_prof.cyc_overlap = cfs_overlap_work();
+  bool ok = cfs_wait_winners(&s1, &s2, &d1);
+  uint64_t t1 = rdcycle64();
+  g_prof.cyc_winner = (uint32_t)(t1 - t0) - g_prof.cyc_overlap;
+
+  if (!ok) {
+    // fallback (rare)
+    gng_find_winners_sw(x, y, &s1, &s2, &d1);
+  }
+#else
+  gng_find_winners_sw(x, y, &s1, &s2, &d1);
+  uint64_t t1 = rdcycle64();
+  g_prof.cyc_winner = (uint32_t)(t1 - t0);
+#endif
+
+  if (s1 >= 0 && s2 >= 0) {
+    gng_update(x, y, s1, s2, d1);
+  }
+
+  uint64_t t_total1 = rdcycle64();
+  g_prof.cyc_total = (uint32_t)(t_total1 - t_total0);
+  gng_prof_commit();
+  return s1;
+}
+
+#if GNG_MODELS > 2
+// ============================ Hierarchical models (CMD_MODEL HIER) ============
+// the queued samples of fine model 1 + f, one switch for all of them
+static uint32_t hier_flush(int f) {
+  uint32_t n = hier_n[f];
+  if (n == 0) return 0;
+  model_switch((uint8_t)(1 + f));
+  for (uint32_t i = 0; i < n; i++) trainOneStep(hier_q[f][i]);
+  hier_n[f] = 0;
+  return n;
+}
+
+// one sample: a step of the coarse model 0, its winner queues the sample for
+// a fine model; a full queue trains that model. Returns the steps run.
+static uint32_t hier_step(void) {
+  model_switch(0);
+  sample_t smp = next_sample();
+  int c = trainOneStep(smp);
+  if (c < 0) return 1;
+  int f = c % HIER_FINE;                  // c < HIER_FINE unless it predates the cap
+  hier_q[f][hier_n[f]++] = smp;
+  return 1u + ((hier_n[f] == HIER_Q) ? hier_flush(f) : 0u);
+}
+
+// on: model 0 is capped at one node per fine model; off: the queues are
+// trained and every model gets MAX_NODES again
+static void hier_set(bool on) {
+  if (!on)
+    for (int f = 0; f < HIER_FINE; f++) stats_steps += hier_flush(f);
+  model_switch(0);
+  g_node_cap = on ? HIER_FINE : MAX_NODES;
+  mdl_hier = on;
+}
+#endif
+
+#if CFS_BATCH_N > 0
+// ============================ GNG Batch (CFS_BATCH_N searches per CFS run) ======
+static void trainBatch(void) {
+  sample_t bs[CFS_BATCH_N];
+
+  gng_prof_clear();
+  uint64_t t0 = rdcycle64();
+
+  cfs_flush_dirty();
+  cfs_write_active_mask();
+
+  // burst the next N samples into the CFS sample FIFO
+  for (int k = 0; k < CFS_BATCH_N; k++) {
+    bs[k] = next_sample();
+    CFS_WR(CFS_REG_SMP_PUSH, bs[k]);
+  }
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_BATCH);
+
+  const uint32_t TIMEOUT = 200000u;
+  bool ok = false;
+  for (uint32_t t = 0; t < TIMEOUT; t++) {
+    if (((CFS_RD(CFS_REG_BATCH) >> 8) & 0x3Fu) >= (uint32_t)CFS_BATCH_N) { ok = true; break; }
+  }
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_CLEAR | CFS_CTRL_MODE); // leave batch mode
+
+  int   rs1[CFS_BATCH_N], rs2[CFS_BATCH_N];
+  dist_t rd1[CFS_BATCH_N];
+  for (int k = 0; k < CFS_BATCH_N; k++) {
+    if (ok) {
+      uint32_t s12 = CFS_RD(CFS_REG_RES_S12);
+      rd1[k] = dist_from_q30(CFS_RD(CFS_REG_RES_MIN1)); // pops
+      rs1[k] = (int)(s12 & 0xFFu);
+      rs2[k] = (int)((s12 >> 8) & 0xFFu);
+    } else {
+      rs1[k] = rs2[k] = -1;
+      gng_find_winners_sw(sample_x(bs[k]), sample_y(bs[k]), &rs1[k], &rs2[k], &rd1[k]);
+    }
+  }
+  if (!ok) CFS_WR(CFS_REG_CTRL, CFS_CTRL_FLUSH | CFS_CTRL_MODE);
+
+  uint64_t t1 = rdcycle64();
+  g_prof.cyc_winner = (uint32_t)(t1 - t0) / (uint32_t)CFS_BATCH_N;
+
+  // updates in sample order (positions move, winners stay those of the batch start);
+  // every update is one step of the profile, with its share of the batch search.
+  // An earlier update of the batch can prune a winner: that sample is searched
+  // again on the CPU, an edge to a free slot would outlive its reuse
+  const uint32_t cyc_winner = g_prof.cyc_winner;
+  for (int k = 0; k < CFS_BATCH_N; k++) {
+    gng_prof_clear();
+    g_prof.cyc_winner = cyc_winner;
+    if (rs1[k] >= 0 && rs2[k] >= 0 && !(nodes[rs1[k]].active && nodes[rs2[k]].active)) {
+      rs1[k] = rs2[k] = -1;
+      gng_find_winners_sw(sample_x(bs[k]), sample_y(bs[k]), &rs1[k], &rs2[k], &rd1[k]);
+    }
+    if (rs1[k] >= 0 && rs2[k] >= 0) gng_update(sample_x(bs[k]), sample_y(bs[k]), rs1[k], rs2[k], rd1[k]);
+    g_prof.cyc_total = g_prof.cyc_winner + g_prof.cyc_move_w + g_prof.cyc_nb +
+                       g_prof.cyc_connect + g_prof.cyc_delete + g_prof.cyc_prune +
+                       g_prof.cyc_insert + g_prof.cyc_renorm;
+    gng_prof_commit();
+  }
+}
+#endif
+
+// ============================ DBL-GNG epoch (whole dataQ, gng_dbl.h) ============
+static void trainEpochDBL(void) {
+  gng_prof_clear();
+  uint64_t t_total0 = rdcycle64();
+  uint32_t cyc_acc = 0;
+
+  dbl_reset();
+
+#if GNG_CFS && GNG_DIM == 2
+  uint32_t s12[CFS_SMP_DEPTH], rd1[CFS_SMP_DEPTH];
+  cfs_flush_dirty();
+  cfs_write_active_mask();
+
+  int k0 = 0;
+  int n  = (dataCount < CFS_SMP_DEPTH) ? dataCount : CFS_SMP_DEPTH;
+  cfs_batch_start(&dataQ[0], n);
+  while (n > 0) {
+    bool ok = cfs_batch_read(n, s12, rd1);
+
+    // CFS scans the next batch while the CPU sums this one
+    int k1 = k0 + n;
+    int n1 = (dataCount - k1 < CFS_SMP_DEPTH) ? dataCount - k1 : CFS_SMP_DEPTH;
+    if (n1 > 0) cfs_batch_start(&dataQ[k1], n1);
+
+    uint64_t t0 = rdcycle64();
+    for (int k = 0; k < n; k++) {
+      const pos_t x = sample_x(dataQ[k0 + k]), y = sample_y(dataQ[k0 + k]);
+      int s1 = -1, s2 = -1;
+      dist_t d1 = DIST_MAX;
+      if (ok) {
+        s1 = (int)(s12[k] & 0xFFu);
+        s2 = (int)((s12[k] >> 8) & 0xFFu);
+        d1 = dist_from_q30(rd1[k]);
+      } else {
+        gng_find_winners_sw(x, y, &s1, &s2, &d1);
+      }
+      if (s1 >= 0 && s2 >= 0) dbl_accum(x, y, s1, s2, d1);
+    }
+    cyc_acc += (uint32_t)(rdcycle64() - t0);
+
+    k0 = k1;
+    n  = n1;
+  }
+#else
+  // one search per sample: CPU, or the CFS word by word (GNG_DIM > 2)
+  for (int k = 0; k < dataCount; k++) {
+    const pos_t x = sample_x(dataQ[k]), y = sample_y(dataQ[k]);
+    int s1 = -1, s2 = -1;
+    dist_t d1 = DIST_MAX;
+    sample_load_z(&dataQ[k]);
+    GNG_FIND_WINNERS(x, y, &s1, &s2, &d1);
+    uint64_t t0 = rdcycle64();
+    if (s1 >= 0 && s2 >= 0) dbl_accum(x, y, s1, s2, d1);
+    cyc_acc += (uint32_t)(rdcycle64() - t0);
+  }
+#endif
+  g_prof.cyc_nb = cyc_acc;
+  g_prof.cyc_winner = (uint32_t)(rdcycle64() - t_total0) - cyc_acc;
+
+  dbl_apply();
+  stepCount += (uint32_t)dataCount;
+  g_epochs++;
+
+  g_prof.cyc_total = (uint32_t)(rdcycle64() - t_total0);
+  gng_prof_commit();
+}
+
+// ============================ Query service (CMD_QUERY) =========================
+#define QRY_MAX  ((255 - QRY_HDR) / SMP_WIRE_BYTES)  // samples per query (2D: 63)
+
+// CMD_DATA_BATCH wire sample at p -> sample_t
+static sample_t qry_sample(const uint8_t *p) {
+#if GNG_DIM > 2
+  sample_t smp;
+  memset(&smp, 0, sizeof(smp));
+  for (int c = 0; c < GNG_DIM; c++) {
+    uint32_t q = q15_from_wire((int16_t)(p[2 * c] | (p[2 * c + 1] << 8)));
+    smp.w[c >> 1] |= q << (16u * (uint32_t)(c & 1));
+  }
+  return smp;
+#else
+  return q15_from_wire((int16_t)(p[0] | (p[1] << 8))) |
+         (q15_from_wire((int16_t)(p[2] | (p[3] << 8))) << 16);
+#endif
+}
+
+static void qry_serve(void) {
+  sample_t bs[QRY_MAX];
+  uint32_t s12[QRY_MAX], rd1[QRY_MAX];
+
+  smp_fence();
+  const qry_t *q = &qry_q[qry_tail & (QRY_RING - 1u)];
+  const uint8_t seq = q->payload[0], flags = q->payload[1];
+  int n = (q->len - QRY_HDR) / SMP_WIRE_BYTES;
+  for (int k = 0; k < n; k++) bs[k] = qry_sample(&q->payload[QRY_HDR + k * SMP_WIRE_BYTES]);
+  smp_fence();
+  qry_tail++;                      // payload copied, the ring slot is free again
+
+#if GNG_MODELS > 1
+  model_switch(mdl_view);          // winners of the model the snapshots show
+#endif
+  int act = 0;
+  for (int w = 0; w < ACT_WORDS; w++) act += __builtin_popcount(g_act[w]);
+
+  if (act < 2) {
+    for (int k = 0; k < n; k++) { s12[k] = 0xFFu; rd1[k] = 0xFFFFFFFFu; }
+  } else {
+#if GNG_CFS && GNG_DIM == 2
+    cfs_flush_dirty();
+    cfs_write_active_mask();
+    int k0 = 0;
+    int m  = (n < CFS_SMP_DEPTH) ? n : CFS_SMP_DEPTH;
+    if (m > 0) cfs_batch_start(&bs[0], m);
+    while (m > 0) {
+      bool ok = cfs_batch_read(m, &s12[k0], &rd1[k0]);
+      // next scan first; a timed-out one is redone on the CPU meanwhile
+      int k1 = k0 + m;
+      int m1 = (n - k1 < CFS_SMP_DEPTH) ? n - k1 : CFS_SMP_DEPTH;
+      if (m1 > 0) cfs_batch_start(&bs[k1], m1);
+      for (int k = k0; !ok && k < k1; k++) {
+        int s1 = -1, s2 = -1;
+        dist_t d1 = DIST_MAX;
+        gng_find_winners_sw(sample_x(bs[k]), sample_y(bs[k]), &s1, &s2, &d1);
+        s12[k] = (uint32_t)(s1 & 0xFF);
+        rd1[k] = dist_to_q30(d1);
+      }
+      k0 = k1;
+      m  = m1;
+    }
+#else
+    for (int k = 0; k < n; k++) {
+      int s1 = -1, s2 = -1;
+      dist_t d1 = DIST_MAX;
+      sample_load_z(&bs[k]);
+      GNG_FIND_WINNERS(sample_x(bs[k]), sample_y(bs[k]), &s1, &s2, &d1);
+      s12[k] = (uint32_t)(s1 & 0xFF);
+      rd1[k] = dist_to_q30(d1);
+    }
+#endif
+  }
+
+  uint8_t payload[QRY_ACK_HDR + QRY_ACK_MAX * QRY_ACK_REC];
+  for (int k0 = 0; k0 < n || k0 == 0; k0 += QRY_ACK_MAX) {
+    int m = (n - k0 < QRY_ACK_MAX) ? n - k0 : QRY_ACK_MAX;
+    payload[0] = seq;
+    payload[1] = (uint8_t)k0;
+    payload[2] = (uint8_t)m;
+    for (int k = 0; k < m; k++) {
+      uint8_t *r = &payload[QRY_ACK_HDR + k * QRY_ACK_REC];
+      uint8_t s1 = (uint8_t)(s12[k0 + k] & 0xFFu);
+      r[0] = s1;
+#if GNG_COMPONENTS
+      r[1] = (flags & QRY_LABEL) && s1 < MAX_NODES ? g_comp[s1] : 0xFFu;
+#else
+      r[1] = 0xFFu;
+      (void)flags;
+#endif
+      wr_u32_le(&r[2], rd1[k0 + k]);
+    }
+    uart_send_frame(CMD_QUERY_ACK, payload, (uint8_t)(QRY_ACK_HDR + m * QRY_ACK_REC));
+  }
+}
+
+// ============================ Evaluation sweep (CMD_EVAL) =======================
+// floor(sqrt(v)): min1 Q2.30 -> distance Q1.15
+static uint32_t eval_isqrt(uint32_t v) {
+  uint32_t r = 0, b = 1u << 30;
+  while (b > v) b >>= 2;
+  while (b) {
+    if (v >= r + b) { v -= r + b; r = (r >> 1) + b; }
+    else r >>= 1;
+    b >>= 2;
+  }
+  return r;
+}
+
+// view model's resident set: [lo, hi) of dataQ, or the generator
+static int eval_range(int *lo) {
+  *lo = 0;
+#if GNG_GEN
+  if (gen_src) return (int)EVAL_GEN_N;
+#endif
+#if SD_CARD
+  if (sd_src) return 0;
+#endif
+  if (g_stream) return 0;
+#if GNG_MODELS > 1
+  *lo = mdl_lo[mdl_view];
+  return mdl_hi[mdl_view] - mdl_lo[mdl_view];
+#else
+  return dataCount;
+#endif
+}
+
+static inline sample_t eval_sample(int lo, int k) {
+#if GNG_GEN
+  if (gen_src) return gng_gen_at(&g_gen, EVAL_GEN_BASE + (uint32_t)k);
+#endif
+  return dataQ[lo + k];
+}
+
+typedef struct {
+  uint64_t mse;   // sum of min1, Q2.30
+  uint32_t qe;    // sum of |x - s1|, Q1.15
+  uint32_t te;    // s1-s2 without an edge
+} eval_acc_t;
+
+static inline void eval_add(eval_acc_t *a, int s1, int s2, uint32_t q30) {
+  a->mse += q30;
+  a->qe  += eval_isqrt(q30);
+  if (s1 < 0 || s2 < 0 || s1 >= MAX_NODES || s2 >= MAX_NODES || !edge_on(s1, s2)) a->te++;
+}
+
+static void eval_serve(void) {
+  eval_req = false;
+#if GNG_MODELS > 1
+  model_switch(mdl_view);
+#endif
+  const uint64_t t0 = rdcycle64();
+  eval_acc_t a = { 0, 0, 0 };
+  int lo, n = eval_range(&lo);
+  int act = 0;
+  for (int w = 0; w < ACT_WORDS; w++) act += __builtin_popcount(g_act[w]);
+  if (act < 2) n = 0;
+
+#if GNG_CFS && GNG_DIM == 2
+  // CFS_SMP_DEPTH per scan, the next one runs while the CPU sums this one
+  sample_t bs[2][CFS_SMP_DEPTH];
+  uint32_t s12[CFS_SMP_DEPTH], rd1[CFS_SMP_DEPTH];
+  if (n > 0) {
+    cfs_flush_dirty();
+    cfs_write_active_mask();
+  }
+  int k0 = 0, b = 0;
+  int m  = (n < CFS_SMP_DEPTH) ? n : CFS_SMP_DEPTH;
+  for (int k = 0; k < m; k++) bs[0][k] = eval_sample(lo, k);
+  if (m > 0) cfs_batch_start(bs[0], m);
+  while (m > 0) {
+    bool ok = cfs_batch_read(m, s12, rd1);
+    int k1 = k0 + m;
+    int m1 = (n - k1 < CFS_SMP_DEPTH) ? n - k1 : CFS_SMP_DEPTH;
+    for (int k = 0; k < m1; k++) bs[b ^ 1][k] = eval_sample(lo, k1 + k);
+    if (m1 > 0) cfs_batch_start(bs[b ^ 1], m1);
+    for (int k = 0; k < m; k++) {
+      int s1 = (int)(s12[k] & 0xFFu), s2 = (int)((s12[k] >> 8) & 0xFFu);
+      uint32_t q30 = rd1[k];
+      if (!ok) {
+        dist_t d1 = DIST_MAX;
+        s1 = s2 = -1;
+        gng_find_winners_sw(sample_x(bs[b][k]), sample_y(bs[b][k]), &s1, &s2, &d1);
+        q30 = dist_to_q30(d1);
+      }
+      eval_add(&a, s1, s2, q30);
+    }
+    k0 = k1;
+    m  = m1;
+    b ^= 1;
+  }
+#else
+  for (int k = 0; k < n; k++) {
+    sample_t smp = eval_sample(lo, k);
+    int s1 = -1, s2 = -1;
+    dist_t d1 = DIST_MAX;
+    sample_load_z(&smp);
+    GNG_FIND_WINNERS(sample_x(smp), sample_y(smp), &s1, &s2, &d1);
+    eval_add(&a, s1, s2, dist_to_q30(d1));
+  }
+#endif
+
+  eval_step = stepCount;
+  if (n > 0) {
+    eval_d1 = dist_from_q30((uint32_t)(a.mse / (uint32_t)n));
+    eval_fresh = true;
+  }
+  uint8_t payload[20];
+  wr_u32_le(&payload[0], stepCount);
+  payload[4] = (uint8_t)(n & 0xFF);
+  payload[5] = (uint8_t)((n >> 8) & 0xFF);
+  wr_u32_le(&payload[6], n ? (uint32_t)(((uint64_t)a.qe << 1) / (uint32_t)n) : 0u);
+  wr_u32_le(&payload[10], n ? (uint32_t)(a.mse / (uint32_t)n) : 0u);
+  payload[14] = (uint8_t)(a.te & 0xFFu);
+  payload[15] = (uint8_t)((a.te >> 8) & 0xFFu);
+  wr_u32_le(&payload[16], (uint32_t)(rdcycle64() - t0));
+  uart_send_frame(CMD_EVAL_ACK, payload, sizeof(payload));
+}
+
+// ============================ Network seed (CMD_SEED) ===========================
+// staged network -> view model, like ckpt_load() but built through the
+// incremental paths (activation, connect), so labels / grid / emax follow
+static void seed_serve(void) {
+  seed_req = false;
+#if GNG_MODELS > 1
+  model_switch(mdl_view);
+#endif
+  int n = 0;
+  for (int w = 0; w < ACT_WORDS; w++) n += __builtin_popcount(seed_has[w]);
+
+  uint32_t ne = 0;
+  if (n >= 2) {
+    gng_clear();
+    for (int i = 0; i < MAX_NODES; i++) {
+      if (!(seed_has[i >> 5] & GNG_BIT(i))) continue;
+      sample_t s = qry_sample(seed_wire[i]);
+      nodes[i].x = sample_x(s);
+      nodes[i].y = sample_y(s);
+#if GNG_DIM > 2
+      sample_load_z(&s);
+      for (int k = 0; k < GNG_DIM - 2; k++) nodes[i].z[k] = g_in_z[k];
+#endif
+      node_set_active(i, true);
+      node_mark_dirty(i);
+    }
+    for (int k = 0; k < seed_ne; k++) {
+      int a = seed_edge[k][0], b = seed_edge[k][1];
+      if (nodes[a].active && nodes[b].active) connectOrResetEdge(a, b);
+    }
+    for (int i = 0; i < MAX_NODES; i++) ne += degree[i];
+    ne /= 2u;
+#if GNG_CFS
+    if (g_has_cfs) cfs_sync_nodes_full();
+#endif
+#if GNG_CONVERGE
+    conv_arm();                    // a new plateau to find
+#endif
+    snap_resync();                 // next snapshot is a keyframe
+    snap_mark();
+  }
+
+  uint8_t payload[5];
+  payload[0] = (n >= 2) ? 1u : 0u;
+  payload[1] = (uint8_t)n;
+  payload[2] = (uint8_t)(ne & 0xFFu);
+  payload[3] = (uint8_t)(ne >> 8);
+  payload[4] = seed_lost;
+  uart_send_frame(CMD_SEED_ACK, payload, 5);
+}
+
+#if GNG_SMP
+// ============================ I/O hart (hart 1) =================================
+static uint8_t smp_stack[SMP_STACK] __attribute__((aligned(16)));
+
+// UART0 RX/TX rings and IRQ, CMD_DATA_BATCH into dataQ / smp_q, snapshot
+// frames; never touches the GNG state except through snap_buf
+static void io_main(void) {
+  neorv32_rte_setup();  // mtvec and MIE of this hart, the handler table is hart 0's
+  uart_tx_setup();
+  while (1) {
+    readSerial();
+    xq_drain();
+    if (snap_take()) {
+      snap_send();
+      snap_release();
+    }
+  }
+}
+#endif
+
+// ============================ Idle sleep ==========================================
+#if GNG_IDLE_WFI && !GNG_SMP
+// nothing to train: sleep until an IRQ. MIE is cleared around the check so a
+// byte arriving in between is not missed (wfi still wakes on the pending IRQ,
+// the handler runs once MIE is set again); the CLINT keeps counting meanwhile
+static void idle_wait(void) {
+#if SD_CARD
+  if (sd_src) return;  // card samples are polled
+#endif
+  neorv32_cpu_csr_clr(CSR_MSTATUS, 1 << CSR_MSTATUS_MIE);
+  if (rx_head == rx_tail) {
+    uint64_t t0 = neorv32_clint_time_get();
+    // CMD_STATS_FRAME due: the CLINT compare wakes the wfi (MTIE is off
+    // again before MIE is set, so no timer trap is taken)
+    if (stats_ms) {
+      uint64_t due = stats_cyc + (uint64_t)stats_ms * (CPU_HZ / 1000u), now = rdcycle64();
+      neorv32_clint_mtimecmp_set(t0 + ((due > now) ? (due - now) : 0u));
+      neorv32_cpu_csr_set(CSR_MIE, 1 << CSR_MIE_MTIE);
+    }
+#if GNG_CFS
+    // gate the engine clock; the next CTRL write (START / BATCH / CLEAR) ungates it
+    if (!(CFS_RD(CFS_REG_CTRL) & CFS_STATUS_BUSY))
+      CFS_WR(CFS_REG_CTRL, CFS_CTRL_SLEEP | CFS_CTRL_MODE);
+#endif
+    neorv32_cpu_sleep();
+    neorv32_cpu_csr_clr(CSR_MIE, 1 << CSR_MIE_MTIE);
+    g_idle_ticks += (uint32_t)(neorv32_clint_time_get() - t0);
+  }
+  neorv32_cpu_csr_set(CSR_MSTATUS, 1 << CSR_MSTATUS_MIE);
+}
+#else
+// GNG_SMP: hart 1 does not signal hart 0 yet, hart 0 keeps polling its rings
+static inline void idle_wait(void) { }
+#endif
+
+// ============================ Init ===============================================
+static void initGNG(void) {
+  gng_reset();
+
+  dataCount=0; dataDone=false; running=false;
+  dataIndex=0; frame_id=0;
+  train_mode=TRAIN_ONLINE; g_epochs=0; g_passes=0;
+#if GNG_SHUFFLE
+  train_order=ORDER_SHUFFLE;
+#endif
+  pass_rekey();
+  sent_valid=false;
+  g_stream=false; smp_head=smp_tail=0; smp_granted=0;
+#if GNG_GEN
+  gen_src=false;
+#endif
+  snap_mark();
+  snap_end = 0;  // step count restarts: no interval to measure yet
+  gng_prof_agg_reset();
+#if GNG_MODELS > 1
+  models_init();
+#endif
+  eval_step=0; eval_fresh=false;
+#if GNG_CONVERGE
+  conv_action = CONV_OFF;
+  conv_arm();
+#endif
 }
 
 int main(void) {
   neorv32_rte_setup();
   neorv32_uart0_setup(BAUD_RATE, 0);
-
   initGNG();
-  neorv32_uart0_puts("READY\n");
 
+#if GNG_SMP
+  // hart 1 takes UART0 (and drains what hart 0 queues from here on)
+  if (NEORV32_SYSINFO->MISC[SYSINFO_MISC_HART] < 2 ||
+      neorv32_smp_launch(io_main, smp_stack, sizeof(smp_stack)) != 0) {
+    neorv32_uart0_puts("ERROR: GNG_SMP needs CPU_DUAL_CORE\n");
+    while (1) { }
+  }
+#elif UART_TX_IRQ
+  uart_tx_setup();
+#endif
+  uart_tx_puts("READY\n");
+
+#if GNG_CKPT
+  // warm start from the newest checkpoint
+  uart_tx_puts(ckpt_load() ? "CKPT=1\n" : "CKPT=0\n");
+#endif
+
+#if GNG_CFS
   g_has_cfs = (neorv32_cfs_available() != 0);
-  neorv32_uart0_puts(g_has_cfs ? "CFS=1\n" : "CFS=0\n");
+  uart_tx_puts(g_has_cfs ? "CFS=1\n" : "CFS=0\n");
+#else
+  uart_tx_puts("CFS=0 (software build)\n");
+#endif
+
+#if SNAPSHOT_SDI
+  if (neorv32_sdi_available()) {
+    neorv32_sdi_setup(0);
+    uart_tx_puts("SDI=1\n");
+  } else {
+    uart_tx_puts("ERROR: SDI missing\n");
+    while (1) { }
+  }
+#endif
+#if GNG_CFU
+  if (!(neorv32_cpu_csr_read(CSR_MXISA) & (1u << CSR_MXISA_ZXCFU))) {
+    uart_tx_puts("ERROR: CFU missing\n");
+    while (1) { }
+  }
+#endif
+#if GNG_CFS
   if (!g_has_cfs) {
-    neorv32_uart0_puts("ERROR: CFS missing\n");
+    uart_tx_puts("ERROR: CFS missing\n");
     while (1) { }
   }
 
-  // Clear CFS flags
-  NEORV32_CFS->REG[CFS_REG_CTRL] = CFS_CTRL_CLEAR;
-  cfs_sync_nodes_full();
+  // CFS node capacity (generic MAXNODES); bitstreams without REG_INFO hold 40
+  uint32_t cfs_info = CFS_RD(CFS_REG_INFO);
+  uint32_t cfs_cap  = (cfs_info & 0xFFFFu) ? (cfs_info & 0xFFFFu) : 40u;
+  if ((uint32_t)MAX_NODES > cfs_cap) {
+    uart_tx_puts("ERROR: MAX_NODES > CFS MAXNODES\n");
+    while (1) { }
+  }
+  if (!cfs_dim_ok()) {
+    uart_tx_puts("ERROR: GNG_DIM words != CFS DIM words\n");
+    while (1) { }
+  }
+#if GNG_CFS_MOVE
+  if (!(CFS_RD(CFS_REG_DIM) & CFS_DIM_MOVE)) {
+    uart_tx_puts("ERROR: CFS MOVE missing\n");
+    while (1) { }
+  }
+#endif
+#if GNG_CFS_DUMP
+  // the framer holds UART0 by CTS while it sends
+  g_cfs_dump = (CFS_RD(CFS_REG_DIM) & CFS_DIM_DUMP) != 0;
+  if (g_cfs_dump) {
+    NEORV32_UART0->CTRL |= (1u << UART_CTRL_HWFC_EN);
+    cfs_dump_setup(BAUD_RATE);
+  }
+  uart_tx_puts(g_cfs_dump ? "DUMP=1\n" : "DUMP=0\n");
+#endif
+  g_cfs_dbuf = (cfs_info & CFS_INFO_DBUF) != 0;
+#if CFS_PERF
+  g_cfs_perf = (cfs_info & CFS_INFO_PERF) != 0;
+#endif
+
+  // DMA probe, clear CFS flags, node window, CFS IRQ
+  cfs_setup();
+  uart_tx_puts(g_has_dma ? "DMA=1\n" : "DMA=0\n");
+#if GNG_MODELS > 1
+  models_cfs_setup();
+#endif
+#endif // GNG_CFS
+#if GNG_PARAMS_RT
+  params_to_cfs();
+#endif
+
+#if SD_CARD
+  uart_tx_puts(sd_mount() ? "SD=1\n" : "SD=0\n");
+#if SD_AUTORUN
+  // offline run: card samples, frames only into the log (if the card has one)
+  if (sd_mounted && sd_train_start(SD_AUTORUN_PASSES) == SD_OK) {
+    sd_log_start(false);
+    uart_tx_puts(sd_log ? "SD RUN LOG\n" : "SD RUN\n");
+  }
+#endif
+#endif
 
   bool preprocessed = false;
 
   while (1) {
+#if GNG_SMP
+    cmdq_poll();
+#else
     readSerial();
+#endif
+#if GNG_PARAMS_RT
+    if (par_req) params_serve();
+#endif
+#if GNG_CKPT
+    if (ckpt_req) ckpt_serve();
+#endif
+    if (qry_pending()) qry_serve();
+    if (seed_req) seed_serve();
+#if GNG_GEN
+    if (gen_req) gen_serve();
+#endif
+    if (eval_req) eval_serve();
+#if GNG_MODELS > 1
+    if (mdl_req) model_serve();
+#endif
+#if CFS_PERF
+    if (perf_req) perf_serve();
+#endif
+#if SD_CARD
+    if (sd_req) sd_serve();
+    if (sd_src) sd_service(CFS_BATCH_N > 0 ? CFS_BATCH_N : 1);
+#endif
+
+    stats_poll();
 
     if (dataDone && !preprocessed) {
-      neorv32_uart0_puts("DATA OK\n");
+      uart_tx_puts("DATA OK\n");
       preprocessed = true;
       running = true; // auto-run
     }
 
-    if (!dataDone || !running || (dataCount <= 0)) continue;
-
-    float x = dataX[dataIndex];
-    float y = dataY[dataIndex];
-    dataIndex++;
-    if (dataIndex >= dataCount) dataIndex = 0;
+    if (!running) { idle_wait(); continue; }
 
-    // compute-only (profiling inside trainOneStep)
-    trainOneStep(x, y);
+#if GNG_MODELS > 1
+    model_turn();
+#endif
+    bool dbl = (train_mode == TRAIN_DBL) && !g_stream;
+#if SD_CARD
+    if (sd_src) dbl = false;  // card runs train online
+#endif
+#if GNG_GEN
+    if (gen_src) dbl = false;  // no dataset to sweep
+#endif
+#if GNG_MODELS > 1
+    if (mdl_k > 1) dbl = false;  // epochs sweep the whole dataQ, one model only
+#endif
+#if GNG_MODELS > 2
+    if (mdl_hier) dbl = false;
+#endif
+#if GNG_TRACE
+    const bool traced = (trace_left != 0);
+    if (traced) trace_start();
+#endif
+    uint32_t steps0 = stepCount;  // this model's count, stats_steps sums all
+    if (dbl) {
+      if (!samples_ready(1)) { idle_wait(); continue; }
+      trainEpochDBL();
+#if GNG_MODELS > 2
+    } else if (mdl_hier) {
+      if (!samples_ready(1)) { idle_wait(); continue; }
+      stats_steps += hier_step();  // coarse + fine steps, across switches
+      steps0 = stepCount;
+#endif
+    } else {
+#if CFS_BATCH_N > 0
+      if (!samples_ready(CFS_BATCH_N)) { idle_wait(); continue; }
+      // compute-only (profiling inside trainBatch)
+      trainBatch();
+#else
+      if (!samples_ready(1)) { idle_wait(); continue; }
+      // compute-only (profiling inside trainOneStep)
+      trainOneStep(next_sample());
+#endif
+    }
+    stats_steps += stepCount - steps0;
+#if GNG_TRACE
+    if (traced) trace_dump();
+#endif
+    if (g_stream) stream_credit_update();
+#if GNG_MODELS > 1
+    mdl_steps = (uint16_t)(mdl_steps + (CFS_BATCH_N > 0 ? CFS_BATCH_N : 1));
+#endif
 
-    // stream (UART cost NOT included in g_prof)
-    if ((stepCount % STREAM_EVERY_N) == 0) {
-      frame_id++;
-      sendGNGNodes();
-      sendGNGEdges(); // Processing-compatible (old format)
-      sendPROF();     // profiling frame
+    // stream (UART cost NOT included in g_prof); only the view model is shown
+    if (snap_mask && model_viewed() && snap_due()) {
+      const uint64_t t_snap = rdcycle64();
+      snap_mark();
+#if GNG_SMP
+      snap_publish(); // hart 1 encodes it
+#else
+      snap_send();
+#endif
+      snap_auto(t_snap);
     }
+    if (eval_every && model_viewed() && (uint32_t)(stepCount - eval_step) >= eval_every)
+      eval_serve();
+#if GNG_CONVERGE
+    if (conv_action && model_viewed() && conv_check()) conv_fire();
+#endif
+#if GNG_COMPACT && GNG_MODELS > 2
+    // renumbering the coarse nodes would move the regions of the fine models
+    if (!(mdl_hier && mdl_live == 0) && (uint32_t)(stepCount - compact_step) >= COMPACT_EVERY)
+      compact_serve();
+#elif GNG_COMPACT
+    if ((uint32_t)(stepCount - compact_step) >= COMPACT_EVERY) compact_serve();
+#endif
   }
 
   return 0;
@@ -1,12 +1,42 @@
 import sys
 import time
+import zlib
+from pathlib import Path
+
 import serial
 
+# CMD_SET_BAUD helper shared with the other host tools (repo root /gng_host)
+sys.path.insert(0, str(Path(__file__).resolve().parents[2] / "gng_host"))
+
+APP_BOOT_BAUD = 1000000  # main.c BAUD_RATE
+
 def print_usage():
     print("Upload and execute application image via serial port (UART) to the NEORV32 bootloader.")
     print("Reset processor before starting the upload.\n")
-    print("Usage:   python uart_upload.py <serial port> <NEORV32 executable>")
+    print("Usage:   python uart_upload.py <serial port> <NEORV32 executable> [app baud] [--fast[=baud]]")
     print("Example: python uart_upload.py /dev/ttyS6 path/to/project/neorv32_exe.bin")
+    print("         python uart_upload.py /dev/ttyS6 neorv32_exe.bin 3375000")
+    print("         python uart_upload.py /dev/ttyS6 neorv32_exe.bin --fast")
+    print("[app baud]: after boot, switch the GNG firmware UART (CMD_SET_BAUD) to this rate")
+    print("--fast: bootloader block upload 'f' (default 2250000 baud), only changed pages")
+
+def switch_app_baud(port, baud):
+    import gngio
+
+    ser = serial.Serial(port, APP_BOOT_BAUD, timeout=0.1)
+    # wait for the firmware banner (READY / CFS=1) before sending frames
+    t_end = time.time() + 3.0
+    text = ""
+    while time.time() < t_end and "CFS=" not in text:
+        text += ser.read(64).decode(errors='ignore')
+    print("Switching application baud...", end='')
+    actual = gngio.set_baud(ser, baud)
+    ser.close()
+    if actual == 0:
+        print(f" refused ({baud} not reachable within the fw tolerance), staying at {APP_BOOT_BAUD}")
+        return APP_BOOT_BAUD
+    print(f" OK, {actual} baud (open the host tools with this rate)")
+    return actual
 
 def configure_serial_port(port):
     ser = serial.Serial(
@@ -22,13 +52,26 @@ def configure_serial_port(port):
     )
     return ser
 
+def fast_upload(ser, executable_path, baud):
+    from gngio.bootload import FAST_BAUD, fast_upload
+
+    print("Block upload...")
+    with open(executable_path, 'rb') as exe_file:
+        exe = exe_file.read()
+    sent, total = fast_upload(ser, exe, baud or FAST_BAUD, log=lambda s: print("  " + s))
+    print(f"{sent} of {total} pages written, booting application... OK")
+
 def main():
-    if len(sys.argv) != 3:
+    fast = [a for a in sys.argv[1:] if a.startswith("--fast")]
+    args = [a for a in sys.argv[1:] if not a.startswith("--fast")]
+    if len(args) not in (2, 3):
         print_usage()
         sys.exit(0)
 
-    serial_port = sys.argv[1]
-    executable_path = sys.argv[2]
+    serial_port = args[0]
+    executable_path = args[1]
+    app_baud = int(args[2]) if len(args) == 3 else 0
+    fast_baud = int(fast[0].split("=", 1)[1]) if fast and "=" in fast[0] else 0
 
     try:
         ser = configure_serial_port(serial_port)
@@ -37,15 +80,24 @@ def main():
         sys.exit(1)
 
     try:
-        # Abort autoboot sequence
-        print("Aborting autoboot...", end='')
-        ser.write(b' ')
-        while True:
-            response = ser.read_all().decode(errors='ignore')
-            print(response)
+        # Abort autoboot sequence: without the boot strap (S1) the bootloader
+        # listens only a few ms, so keep sending until the console answers
+        print("Aborting autoboot (reset the board now)...", end='')
+        response = ""
+        while "CMD:>" not in response:
+            ser.write(b' ')
+            time.sleep(0.002)
+            response += ser.read_all().decode(errors='ignore')
+        print(response)
+        time.sleep(0.05)
+        ser.read_all()
 
-            if "CMD:>" in response:
-                break
+        if fast:
+            fast_upload(ser, executable_path, fast_baud)
+            ser.close()
+            if app_baud:
+                switch_app_baud(serial_port, app_baud)
+            sys.exit(0)
 
                # Erase flash memory
         print("Erasing flash memory...", end='')
@@ -95,10 +147,18 @@ def main():
             ser.close()
             sys.exit(1)
 
+        # the bootloader seals the image with its CRC-32 (checked at every boot)
+        with open(executable_path, 'rb') as exe_file:
+            crc = zlib.crc32(exe_file.read()[12:])
+        if f"CRC 0x{crc:08x}" not in response:
+            print(f"Image seal missing or CRC mismatch (expected 0x{crc:08x})")
+
         print ("Booting application...", end='')
         ser.write(b'e')
         print(" OK")
         ser.close()
+        if app_baud:
+            switch_app_baud(serial_port, app_baud)
         sys.exit(0)
 
     except Exception as e:
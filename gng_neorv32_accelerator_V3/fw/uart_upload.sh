@@ -16,8 +16,10 @@ fi
 # configure serial port (match Python uploader: 256000 baud)
 stty -F "$1" 230400 -hup raw -echo -echoe -echok -echoctl -echoke -ixon cs8 -cstopb noflsh clocal cread
 
-# abort autoboot sequence
-printf " " > $1 # send any char that triggers no command
+# abort autoboot sequence: the bootloader only listens a few ms unless the
+# S1 boot strap is held, so keep sending while the board is reset
+printf "Reset the board now...\n"
+for i in $(seq 1 1500); do printf " " > $1; sleep 0.002; done # chars that trigger no command
 
 # erase flash memory (same as Python uploader 'z' command)
 printf "Erasing flash memory..." 
@@ -0,0 +1,35 @@
+// gng_model.h - pretrained GNG network for fw_infer (python -m gngio export)
+// 20 nodes, 45 edges, 1 component, from fwhost CMD_GEN circles, seed 4242
+
+#ifndef GNG_MODEL_H
+#define GNG_MODEL_H
+
+#include <stdint.h>
+
+#define GNG_MODEL_NODES 20
+#define GNG_MODEL_EDGES 45
+
+// Q1.15 x | y << 16
+static const uint32_t gng_model_node[GNG_MODEL_NODES] = {
+  0x73335666u, 0x51CB07F0u, 0x1CAC57F0u, 0x2EFA4646u, 0x36876333u, 0x37F0326Fu,
+  0x0BC72DF4u, 0x1C2937AEu, 0x583162B0u, 0x43541AC1u, 0x4EB839BAu, 0x74BC2FDFu,
+  0x447B50E5u, 0x5C4A26A8u, 0x1ED96C8Bu, 0x3EFA7604u, 0x1F5C1A1Du, 0x66C93E77u,
+  0x69FC1E56u, 0x08D546E9u,
+};
+
+// lowest node index of the component
+static const uint8_t gng_model_label[GNG_MODEL_NODES] = {
+    0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,   0,
+    0,   0,   0,   0,
+};
+
+static const uint8_t gng_model_edge[GNG_MODEL_EDGES ? GNG_MODEL_EDGES : 1][2] = {
+  {  0,   8}, {  0,  11}, {  0,  17}, {  1,   5}, {  1,   9}, {  1,  13}, {  1,  18}, {  2,   3},
+  {  2,   4}, {  2,   7}, {  2,  14}, {  2,  19}, {  3,   4}, {  3,   5}, {  3,   7}, {  3,  12},
+  {  4,  12}, {  4,  14}, {  4,  15}, {  5,   9}, {  5,  10}, {  5,  13}, {  5,  16}, {  6,   7},
+  {  6,   9}, {  6,  16}, {  6,  19}, {  7,  16}, {  7,  19}, {  8,  10}, {  8,  12}, {  8,  15},
+  {  8,  17}, {  9,  13}, {  9,  16}, { 10,  12}, { 10,  13}, { 10,  17}, { 11,  13}, { 11,  17},
+  { 11,  18}, { 12,  15}, { 13,  17}, { 13,  18}, { 14,  15},
+};
+
+#endif // GNG_MODEL_H
@@ -0,0 +1,286 @@
+// ================================================================================
+// NEORV32 fw_infer/main.c - GNG inference image (CMD_QUERY only)
+//
+// A network trained elsewhere (V3 board, fwhost, GNGLite ...) is baked into the
+// image as const data (gng_model.h, written by python -m gngio export) and
+// loaded into the CFS node window at boot; no training code is linked:
+//   - no gng_core.h: no step, no dataset RAM, no snapshot stream, no
+//     checkpoints; the CFS register map comes from gng_cfs_regs.h
+//   - gng_model.h: GNG_MODEL_NODES packed Q1.15 words (x | y << 16), the
+//     component label of each node (lowest node index of its component,
+//     the fw/main.c CMD_GNG_COMPONENTS label) and GNG_MODEL_EDGES pairs
+//
+// BOOT:
+//   - "READY\n", "CFS=1\n" or "CFS=0\n", "MODEL=<nodes>\n"
+//   - CFS: node window words 0 .. n-1, NODE_COUNT = n, the first n ACT bits;
+//     a bitstream without the CFS, with a smaller MAXNODES or with another
+//     DIM leaves the search to the CPU (same answers, ties to the lower id)
+//   - one keyframe, CMD_GNG_NODES + CMD_GNG_EDGES (frame 0), so a recorder or
+//     the GUI shows the baked network
+//
+// QUERY SERVICE (frames and limits of fw/main.c QUERY SERVICE):
+//   - CMD_QUERY (0x0C) [seq][flags] then up to 63 samples in the
+//     CMD_DATA_BATCH layout
+//   - CMD_QUERY_ACK (0x1D) [seq][first][n] then n * [s1][label][min1 u32],
+//     42 per frame; s1 = model node index, min1 = OUT_MIN1 Q2.30; label
+//     (flags bit 0) from gng_model.h, otherwise 0xFF
+//   - CFS: CFS_SMP_DEPTH samples per batch scan; RX bytes are drained while
+//     the answers go out, so a host keeps 2 queries in flight (gngio query)
+//   - legacy FF FF framing, fixed BAUD_RATE; anything but CMD_QUERY is ignored
+// ================================================================================
+
+#include <neorv32.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "gng_cfs_regs.h"  // register map only
+
+#ifndef GNG_MODEL_FILE
+#define GNG_MODEL_FILE  "gng_model.h"  // make MODEL=<exported header>
+#endif
+#include GNG_MODEL_FILE
+
+#ifndef BAUD_RATE
+#define BAUD_RATE       1000000
+#endif
+
+#if GNG_MODEL_NODES < 2 || GNG_MODEL_NODES > 255
+#error "gng_model.h: 2 .. 255 nodes (8-bit s1)"
+#endif
+#if GNG_MODEL_EDGES > 126
+#error "gng_model.h: more edges than one CMD_GNG_EDGES frame"
+#endif
+
+#define UART_HDR        0xFFu
+#define CMD_QUERY       0x0Cu
+#define CMD_GNG_NODES   0x10u
+#define CMD_GNG_EDGES   0x11u
+#define CMD_QUERY_ACK   0x1Du
+
+#define QRY_HDR         2  // [seq][flags]
+#define QRY_LABEL    0x01u // flags: connected component of s1
+#define QRY_ACK_HDR     3  // [seq][first][n]
+#define QRY_ACK_REC     6  // [s1][label][min1 u32]
+#define QRY_ACK_MAX   ((255 - QRY_ACK_HDR) / QRY_ACK_REC)
+#define SMP_WIRE_BYTES  4  // int16 x, y (1/1000)
+#define QRY_MAX       ((255 - QRY_HDR) / SMP_WIRE_BYTES)
+
+#define CFS_SMP_DEPTH   32  // neorv32_cfs.vhd sample FIFO / result ring
+#define CFS_TIMEOUT     200000u
+
+#define ACT_WORDS     ((GNG_MODEL_NODES + 31) / 32)
+#define RX_RING         512  // power of two
+
+static bool g_has_cfs = false;
+
+// ============================ UART (polled) =====================================
+static uint8_t  rx_ring[RX_RING];
+static uint32_t rx_head = 0, rx_tail = 0;
+
+static inline void rx_poll(void) {
+  // a full ring leaves the rest in the UART FIFO
+  while ((rx_head - rx_tail) < RX_RING && neorv32_uart0_char_received())
+    rx_ring[(rx_head++) & (RX_RING - 1u)] = (uint8_t)neorv32_uart0_getc();
+}
+
+static inline bool rx_get(uint8_t *b) {
+  if (rx_head == rx_tail) rx_poll();
+  if (rx_head == rx_tail) return false;
+  *b = rx_ring[(rx_tail++) & (RX_RING - 1u)];
+  return true;
+}
+
+// the RX FIFO (16 deep) is drained every 8 TX bytes: 80 us at 1 Mbaud, well
+// before a frame in flight fills it
+static inline void uart_put(uint8_t b) {
+  static uint8_t n = 0;
+  if (!(++n & 7u)) rx_poll();
+  neorv32_uart0_putc((char)b);
+}
+
+static void uart_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  uint8_t sum = (uint8_t)(cmd + len);
+  for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
+  uart_put(UART_HDR);
+  uart_put(UART_HDR);
+  uart_put(cmd);
+  uart_put(len);
+  for (uint8_t i = 0; i < len; i++) uart_put(payload[i]);
+  uart_put((uint8_t)~sum);
+}
+
+static inline void wr_u32_le(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)v; p[1] = (uint8_t)(v >> 8); p[2] = (uint8_t)(v >> 16); p[3] = (uint8_t)(v >> 24);
+}
+
+// ============================ Wire <-> Q1.15 ====================================
+// gng_core.h q15_from_wire: 1/1000 units -> Q1.15 in [0, 0x7FFF]
+static inline uint32_t q15_from_wire(int16_t v) {
+  if (v <= 0) return 0;
+  uint32_t q = ((uint32_t)v * 4096u + 62u) / 125u;
+  return (q > 0x7FFFu) ? 0x7FFFu : q;
+}
+
+static inline int16_t wire_from_q15(uint32_t q) {
+  return (int16_t)((q * 125u + 2048u) >> 12);
+}
+
+// ============================ Winner search =====================================
+// Q2.30 squared distance of two packed Q1.15 words (neorv32_cfs_engine, 2D)
+static inline uint32_t dist2_q30(uint32_t a, uint32_t b) {
+  int32_t dx = (int32_t)(a & 0xFFFFu) - (int32_t)(b & 0xFFFFu);
+  int32_t dy = (int32_t)(a >> 16) - (int32_t)(b >> 16);
+  return (uint32_t)(dx * dx) + (uint32_t)(dy * dy);
+}
+
+static uint32_t cpu_winner(uint32_t smp, uint32_t *min1) {
+  uint32_t s1 = 0, d1 = 0xFFFFFFFFu;
+  for (uint32_t i = 0; i < GNG_MODEL_NODES; i++) {
+    uint32_t d = dist2_q30(gng_model_node[i], smp);
+    if (d < d1) { d1 = d; s1 = i; }
+  }
+  *min1 = d1;
+  return s1;
+}
+
+// node window, count and mask once; the search only reads them from here on
+static bool cfs_load_model(void) {
+  uint32_t info = CFS_RD(CFS_REG_INFO);
+  uint32_t cap  = (info & 0xFFFFu) ? (info & 0xFFFFu) : 40u;
+  uint32_t dim  = CFS_RD(CFS_REG_DIM) & 0xFFu;
+  if (cap < GNG_MODEL_NODES || (dim != 0u && dim != 2u)) return false;
+
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_CLEAR);
+  for (uint32_t i = 0; i < GNG_MODEL_NODES; i++) CFS_WR(CFS_NODE_BASE + i, gng_model_node[i]);
+  CFS_WR(CFS_REG_NODE_COUNT, GNG_MODEL_NODES);
+  uint32_t m[ACT_WORDS > 2 ? ACT_WORDS : 2] = { 0 };
+  for (uint32_t i = 0; i < GNG_MODEL_NODES; i++) m[i >> 5] |= 1u << (i & 31u);
+#if ACT_WORDS <= 2
+  CFS_WR(CFS_REG_ACT_LO, m[0]);
+  CFS_WR(CFS_REG_ACT_HI, m[1]);
+#else
+  for (int w = 0; w < ACT_WORDS; w++) CFS_WR(CFS_REG_ACT_BASE + w, m[w]);
+#endif
+  return true;
+}
+
+// one batch scan of n <= CFS_SMP_DEPTH samples; false (FIFOs flushed) on timeout
+static bool cfs_batch(const uint32_t *bs, int n, uint32_t *s1, uint32_t *min1) {
+  for (int k = 0; k < n; k++) CFS_WR(CFS_REG_SMP_PUSH, bs[k]);
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_BATCH);
+  bool ok = false;
+  for (uint32_t t = 0; t < CFS_TIMEOUT; t++) {
+    if (((CFS_RD(CFS_REG_BATCH) >> 8) & 0x3Fu) >= (uint32_t)n) { ok = true; break; }
+  }
+  CFS_WR(CFS_REG_CTRL, CFS_CTRL_CLEAR);
+  if (!ok) {
+    CFS_WR(CFS_REG_CTRL, CFS_CTRL_FLUSH);
+    return false;
+  }
+  for (int k = 0; k < n; k++) {
+    s1[k]   = CFS_RD(CFS_REG_RES_S12) & 0xFFu;
+    min1[k] = CFS_RD(CFS_REG_RES_MIN1);  // pops
+  }
+  return true;
+}
+
+// ============================ Query service =====================================
+static void qry_serve(const uint8_t *q, uint8_t len) {
+  uint32_t bs[QRY_MAX], s1[QRY_MAX], min1[QRY_MAX];
+  const uint8_t seq = q[0], flags = q[1];
+  const int n = (len - QRY_HDR) / SMP_WIRE_BYTES;
+  for (int k = 0; k < n; k++) {
+    const uint8_t *p = &q[QRY_HDR + k * SMP_WIRE_BYTES];
+    bs[k] = q15_from_wire((int16_t)(p[0] | (p[1] << 8))) |
+            (q15_from_wire((int16_t)(p[2] | (p[3] << 8))) << 16);
+  }
+
+  for (int k0 = 0; k0 < n; k0 += CFS_SMP_DEPTH) {
+    const int m = (n - k0 < CFS_SMP_DEPTH) ? n - k0 : CFS_SMP_DEPTH;
+    if (g_has_cfs && cfs_batch(&bs[k0], m, &s1[k0], &min1[k0])) continue;
+    for (int k = k0; k < k0 + m; k++) s1[k] = cpu_winner(bs[k], &min1[k]);
+  }
+
+  uint8_t payload[QRY_ACK_HDR + QRY_ACK_MAX * QRY_ACK_REC];
+  for (int k0 = 0; k0 < n || k0 == 0; k0 += QRY_ACK_MAX) {
+    const int m = (n - k0 < QRY_ACK_MAX) ? n - k0 : QRY_ACK_MAX;
+    payload[0] = seq;
+    payload[1] = (uint8_t)k0;
+    payload[2] = (uint8_t)m;
+    for (int k = 0; k < m; k++) {
+      uint8_t *r = &payload[QRY_ACK_HDR + k * QRY_ACK_REC];
+      r[0] = (uint8_t)s1[k0 + k];
+      r[1] = (flags & QRY_LABEL) ? gng_model_label[s1[k0 + k]] : 0xFFu;
+      wr_u32_le(&r[2], min1[k0 + k]);
+    }
+    uart_send_frame(CMD_QUERY_ACK, payload, (uint8_t)(QRY_ACK_HDR + m * QRY_ACK_REC));
+  }
+}
+
+// ============================ Keyframe ==========================================
+static void send_model(void) {
+  uint8_t payload[2 + 5 * GNG_MODEL_NODES];
+  payload[0] = 0;  // frame_id
+  payload[1] = (uint8_t)GNG_MODEL_NODES;
+  for (uint32_t i = 0; i < GNG_MODEL_NODES; i++) {
+    uint8_t *r = &payload[2 + 5 * i];
+    int16_t x = wire_from_q15(gng_model_node[i] & 0xFFFFu);
+    int16_t y = wire_from_q15(gng_model_node[i] >> 16);
+    r[0] = (uint8_t)i;
+    r[1] = (uint8_t)x; r[2] = (uint8_t)((uint16_t)x >> 8);
+    r[3] = (uint8_t)y; r[4] = (uint8_t)((uint16_t)y >> 8);
+  }
+  uart_send_frame(CMD_GNG_NODES, payload, (uint8_t)(2 + 5 * GNG_MODEL_NODES));
+
+  payload[1] = (uint8_t)GNG_MODEL_EDGES;
+  for (int e = 0; e < GNG_MODEL_EDGES; e++) {
+    payload[2 + 2 * e] = gng_model_edge[e][0];
+    payload[3 + 2 * e] = gng_model_edge[e][1];
+  }
+  uart_send_frame(CMD_GNG_EDGES, payload, (uint8_t)(2 + 2 * GNG_MODEL_EDGES));
+}
+
+// ============================ Main ==============================================
+int main(void) {
+  neorv32_rte_setup();
+  neorv32_uart0_setup(BAUD_RATE, 0);
+  neorv32_uart0_puts("READY\n");
+
+  g_has_cfs = (neorv32_cfs_available() != 0) && cfs_load_model();
+  neorv32_uart0_puts(g_has_cfs ? "CFS=1\n" : "CFS=0\n");
+  char msg[] = "MODEL=000\n";
+  msg[6] = (char)('0' + GNG_MODEL_NODES / 100);
+  msg[7] = (char)('0' + GNG_MODEL_NODES / 10 % 10);
+  msg[8] = (char)('0' + GNG_MODEL_NODES % 10);
+  neorv32_uart0_puts(msg);
+  send_model();
+
+  // FF FF CMD LEN PAYLOAD CHK, chk = ~(cmd + len + sum(payload))
+  static uint8_t frame[255];
+  uint8_t state = 0, cmd = 0, len = 0, idx = 0, sum = 0, b;
+  while (1) {
+    if (!rx_get(&b)) continue;
+    switch (state) {
+      case 0: state = (b == UART_HDR) ? 1 : 0; break;
+      case 1: state = (b == UART_HDR) ? 2 : 0; break;
+      case 2:
+        if (b == UART_HDR) break;  // longer preamble
+        cmd = b; state = 3;
+        break;
+      case 3:
+        len = b; idx = 0; sum = (uint8_t)(cmd + len);
+        state = len ? 4 : 5;
+        break;
+      case 4:
+        frame[idx++] = b;
+        sum = (uint8_t)(sum + b);
+        if (idx >= len) state = 5;
+        break;
+      default:
+        state = 0;
+        if (b == (uint8_t)~sum && cmd == CMD_QUERY && len >= QRY_HDR) qry_serve(frame, len);
+        break;
+    }
+  }
+  return 0;
+}
@@ -0,0 +1,63 @@
+"""
+PnR summary for a MAX_NODES / LANES sweep
+=========================================
+
+Reads the Gowin reports of one or more runs and prints one markdown table
+row each (Logic, Register, BSRAM, DSP, Fmax):
+
+    python pnr_summary.py impl                        # this project
+    python pnr_summary.py n40=impl n64=../runs/n64    # label=impl_dir
+
+A run's directory is the project `impl` folder (it holds pnr/<top>.rpt.txt
+and pnr/<top>_tr_content.html). Copy it after each Gowin run to keep the
+sweep, e.g. runs/n64 after setting MAXNODES => 64.
+"""
+
+import glob
+import os
+import re
+import sys
+
+RES = ("Logic", "Register", "BSRAM", "DSP")
+
+
+def read_run(impl_dir: str) -> dict:
+    pnr = os.path.join(impl_dir, "pnr")
+    out = {}
+    rpt = glob.glob(os.path.join(pnr, "*.rpt.txt"))
+    if rpt:
+        with open(rpt[0], errors="ignore") as f:
+            for line in f:
+                m = re.match(r"\s*(\w+)\s*\|\s*(\d+)/(\d+)\s*\|", line)
+                if m and m.group(1) in RES and m.group(1) not in out:
+                    out[m.group(1)] = (int(m.group(2)), int(m.group(3)))
+    tr = glob.glob(os.path.join(pnr, "*_tr_content.html"))
+    if tr:
+        with open(tr[0], errors="ignore") as f:
+            # clock table: constraint first, then "Actual Fmax"
+            mhz = re.findall(r"<td>([0-9.]+)\(MHz\)</td>", f.read())
+        if len(mhz) >= 2:
+            out["Fmax"] = float(mhz[1])
+    return out
+
+
+def row(label: str, r: dict) -> str:
+    cells = [label]
+    for k in RES:
+        cells.append("%d/%d" % r[k] if k in r else "-")
+    cells.append("%.3f" % r["Fmax"] if "Fmax" in r else "-")
+    return "| " + " | ".join(cells) + " |"
+
+
+def main(args):
+    if not args:
+        args = ["impl"]
+    print("| run | Logic | Register | BSRAM | DSP | Fmax (MHz) |")
+    print("|-----|-------|----------|-------|-----|------------|")
+    for a in args:
+        label, _, d = a.rpartition("=")
+        print(row(label or d, read_run(d)))
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
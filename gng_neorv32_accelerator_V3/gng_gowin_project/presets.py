@@ -0,0 +1,298 @@
+"""
+Build presets for the Gowin projects (V2 gng.vhd, V3 NEORV32 + CFS)
+===================================================================
+
+Named generic sets that trade lanes, node capacity, pipelining and debug
+traffic against the GW1NR-9 (8640 LUT, 6693 FF, 26 BSRAM, 10 DSP).
+`apply` writes src/gng_preset.vhd, the package the top-level generics take
+their defaults from, and for V3 also fw/preset.mk (GNG_ISA, SNAPSHOT_SDI,
+SD_CARD, MAX_NODES, GNG_MODELS, GNG_SMP, GNG_DIM, GNG_TRACE, GNG_CFU,
+GNG_CFS_MOVE), so a bitstream is picked
+by name instead of by editing VHDL:
+
+    python presets.py list
+    python presets.py apply v3 max-throughput      # then Gowin: Run All
+    python presets.py summary v3 max-throughput=runs/v3_tp,tp.gnglog default=impl
+
+`summary` takes label=impl_dir[,log]. It prints the pnr_summary.py columns
+plus samples/s, measured from a gngio log recorded with that bitstream
+(python -m gngio record ...): V3 uses the PROF `step` counter over host
+time, V2 the A5 DBG sample index over the 27 MHz timestamp (assumes fewer
+than DATA_WORDS iterations between two DBG records, true for the presets).
+Copy `impl` after each run (runs/<board>_<preset>) to keep the results.
+"""
+
+import os
+import sys
+
+from pnr_summary import RES, read_run
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+ROOT = os.path.normpath(os.path.join(HERE, "..", ".."))
+sys.path.insert(0, os.path.join(ROOT, "gng_host"))
+
+PROJECTS = {
+    "v2": os.path.join(ROOT, "gng_neorv32_accelerator_V2", "gng_gowin_project"),
+    "v3": HERE,
+}
+
+CLOCK_HZ = 27_000_000
+
+# V3: CFS winner engine + firmware; LANES = DSPs, CPU_FAST_MUL competes for them,
+# CPU_DMA = neorv32_dma for the node window sync (fw falls back to stores),
+# CPU_ICACHE = i-cache blocks of 32 B for the code in the uflash (0 = off),
+# CPU_TRACER = neorv32_tracer buffer in (src, dst) pairs (0 = off, power of 2),
+# CFS_DIM = components per node / sample (fw GNG_DIM, 2 = the x, y plane)
+# CFS_COARSE = coarse-pass lanes on LUTs ahead of the exact scan (0 = off, power of 2)
+# CPU_CFU = GNG custom instructions in the CPU (neorv32_cpu_cp_cfu, 2 DSPs, fw GNG_CFU)
+# CFS_MOVE = s1 / neighbor move unit in the CFS (2 DSPs, CFS_DIM 2, CFS_CLK_MUL 1, fw GNG_CFS_MOVE)
+# CFS_DUMP = keyframe framer in the CFS on the UART0 pin (edges with CFS_MOVE, fw probes REG_DIM)
+V3 = {
+    "default": dict(
+        CFS_LANES=4, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="4 lanes at 27 MHz, 20 nodes (the reference build)"),
+    "max-throughput": dict(
+        CFS_LANES=8, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=2, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=40,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="8 lanes on the 54 MHz PLL clock (5 rows per scan at 40 nodes)"),
+    "max-nodes": dict(
+        CFS_LANES=2, CFS_MAXNODES=128, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=32, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=128,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="128 nodes (DMEM edge table limit), 2 lanes to leave LUTs for the node memory"),
+    "low-power": dict(
+        CFS_LANES=1, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=False, CPU_DUAL_CORE=False,
+        CPU_ICACHE=32, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="1 lane, no PLL: fewest DSPs and toggling registers"),
+    "offline-sd": dict(
+        CFS_LANES=4, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=True, MAX_NODES=40,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="default + TF card: samples from GNGDATA.BIN, frames logged to GNGLOG.BIN"),
+    "multi-model": dict(
+        CFS_LANES=4, CFS_MAXNODES=20, CFS_CTX=4, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=4, CFS_MOVE=False, CFS_DUMP=False,
+        doc="4 time-sliced GNG instances of 20 nodes, one CFS node bank each"),
+    "hierarchical": dict(
+        CFS_LANES=4, CFS_MAXNODES=16, CFS_CTX=8, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=16,
+        GNG_MODELS=8, CFS_MOVE=False, CFS_DUMP=False,
+        doc="coarse model 0 (7 nodes) routes to 7 fine banks of 16: 112 nodes, CMD_MODEL HIER"),
+    "dual-core": dict(
+        CFS_LANES=2, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=True,
+        CPU_ICACHE=32, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="hart 0 trains, hart 1 streams (GNG_SMP); 2 lanes to make room for the core"),
+    "point-cloud-3d": dict(
+        CFS_LANES=4, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=3, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=40,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="3D samples (x, y, z): 2 words per node, 40 nodes in 10 rows * 2 clocks"),
+    "profile-trace": dict(
+        CFS_LANES=4, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=512, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="default + neorv32_tracer (512 branch pairs) for gngio trace, fw GNG_TRACE=1"),
+    "coarse-lut": dict(
+        CFS_LANES=1, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=16,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=40,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="1 DSP lane behind a 16 lane LUT coarse pass (8-bit bounds, exact refine)"),
+    "cfu": dict(
+        CFS_LANES=4, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=True, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=1, CFS_MOVE=False, CFS_DUMP=False,
+        doc="default + GNG custom instructions (dist2, lerp, edge index; 2 DSPs), fw GNG_CFU=1"),
+    "hw-move": dict(
+        CFS_LANES=4, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=1, CFS_MOVE=True, CFS_DUMP=False,
+        doc="default + CFS move unit (s1 / neighbors after the search; 2 DSPs), fw GNG_CFS_MOVE=1"),
+    "hw-snapshot": dict(
+        CFS_LANES=4, CFS_MAXNODES=40, CFS_CTX=1, CFS_DIM=2, CFS_CLK_MUL=1, CFS_COARSE=0,
+        CPU_EXT_M=True, CPU_EXT_B=True, CPU_FAST_MUL=False, CPU_DMA=True, CPU_DUAL_CORE=False,
+        CPU_ICACHE=64, CPU_TRACER=0, CPU_CFU=False, SNAPSHOT_SDI=False, SD_CARD=False, MAX_NODES=20,
+        GNG_MODELS=1, CFS_MOVE=True, CFS_DUMP=True,
+        doc="hw-move + CFS snapshot framer (keyframes from node_mem / adj_mem onto the UART pin)"),
+}
+
+# V2: all-hardware GNG; MAX_NODES is bounded by the adj_r bitmap (~64)
+V2 = {
+    "default": dict(
+        MAX_NODES=40, PIPE_WIN=False, DBG_EVERY=1, DBG_RING=False,
+        SNAP_SHADOW=False, SNAP_EVERY=50,
+        doc="DBG every iteration, blocking UART (the reference build)"),
+    "max-throughput": dict(
+        MAX_NODES=40, PIPE_WIN=True, DBG_EVERY=16, DBG_RING=True,
+        SNAP_SHADOW=True, SNAP_EVERY=50,
+        doc="speculative winner, DBG 1/16 through the ring, shadow snapshots"),
+    "max-nodes": dict(
+        MAX_NODES=64, PIPE_WIN=False, DBG_EVERY=1, DBG_RING=True,
+        SNAP_SHADOW=False, SNAP_EVERY=100,
+        doc="64 nodes, no replica / shadow BRAMs"),
+    "low-power": dict(
+        MAX_NODES=40, PIPE_WIN=False, DBG_EVERY=64, DBG_RING=True,
+        SNAP_SHADOW=False, SNAP_EVERY=200,
+        doc="minimal UART traffic, no replica"),
+}
+
+PRESETS = {"v2": V2, "v3": V3}
+FW_KEYS = ("MAX_NODES", "GNG_MODELS")  # V3: firmware only, not VHDL constants
+
+
+def vhdl_value(v) -> str:
+    if isinstance(v, bool):
+        return "true" if v else "false"
+    return str(v)
+
+
+def write_vhdl(board: str, name: str, p: dict, path: str):
+    keys = [k for k in p if k != "doc" and not (board == "v3" and k in FW_KEYS)]
+    w = max(len(k) for k in keys) + len("PRESET_")
+    lines = [
+        "-- gng_preset.vhd : build preset \"%s\" (%s)" % (name, board.upper()),
+        "-- %s" % p["doc"],
+        "-- generated by gng_neorv32_accelerator_V3/gng_gowin_project/presets.py,",
+        "-- re-run `python presets.py apply %s <name>` instead of editing" % board,
+        "",
+        "package gng_preset is",
+        "  constant %-*s : string := \"%s\";" % (w, "PRESET_NAME", name),
+    ]
+    for k in keys:
+        t = "boolean" if isinstance(p[k], bool) else "natural"
+        lines.append("  constant %-*s : %s := %s;" % (w, "PRESET_" + k, t, vhdl_value(p[k])))
+    lines += ["end package;", ""]
+    with open(path, "w", newline="\n") as f:
+        f.write("\n".join(lines))
+
+
+def write_fw_mk(name: str, p: dict, path: str):
+    if p["CPU_EXT_M"] and p["CPU_EXT_B"]:
+        isa = "mb"
+    elif not (p["CPU_EXT_M"] or p["CPU_EXT_B"]):
+        isa = "base"
+    else:
+        raise SystemExit("preset %s: fw/makefile has no GNG_ISA for M without B" % name)
+    if p["MAX_NODES"] > p["CFS_MAXNODES"]:
+        raise SystemExit("preset %s: MAX_NODES > CFS_MAXNODES" % name)
+    if p["CPU_ICACHE"] & (p["CPU_ICACHE"] - 1):
+        raise SystemExit("preset %s: CPU_ICACHE must be 0 or a power of two" % name)
+    if p["CFS_COARSE"] > 32 or p["CFS_COARSE"] & (p["CFS_COARSE"] - 1):
+        raise SystemExit("preset %s: CFS_COARSE must be 0 or a power of two <= 32" % name)
+    if p["CPU_TRACER"] & (p["CPU_TRACER"] - 1):
+        raise SystemExit("preset %s: CPU_TRACER must be 0 or a power of two" % name)
+    if p["CPU_DUAL_CORE"] and p["SD_CARD"]:
+        raise SystemExit("preset %s: fw GNG_SMP has no SD_CARD" % name)
+    if p["CFS_MOVE"] and (p["CFS_DIM"] != 2 or p["CFS_CLK_MUL"] != 1):
+        raise SystemExit("preset %s: CFS_MOVE needs CFS_DIM = 2 and CFS_CLK_MUL = 1" % name)
+    if p["CFS_DUMP"] and p["CPU_DUAL_CORE"]:
+        raise SystemExit("preset %s: fw GNG_SMP sends its snapshots without CFS_DUMP" % name)
+    if p["CFS_DIM"] > 2 and p["SD_CARD"]:
+        raise SystemExit("preset %s: GNGDATA.BIN samples are 2D, no SD_CARD with CFS_DIM > 2" % name)
+    with open(path, "w", newline="\n") as f:
+        f.write("# fw build preset \"%s\", generated by presets.py\n" % name)
+        f.write("GNG_ISA ?= %s\n" % isa)
+        f.write("SNAPSHOT_SDI ?= %d\n" % int(p["SNAPSHOT_SDI"]))
+        f.write("SD_CARD ?= %d\n" % int(p["SD_CARD"]))
+        f.write("MAX_NODES ?= %d\n" % p["MAX_NODES"])
+        f.write("GNG_MODELS ?= %d\n" % p["GNG_MODELS"])
+        f.write("GNG_SMP ?= %d\n" % int(p["CPU_DUAL_CORE"]))
+        f.write("GNG_DIM ?= %d\n" % p["CFS_DIM"])
+        f.write("GNG_TRACE ?= %d\n" % int(p["CPU_TRACER"] > 0))
+        f.write("GNG_CFU ?= %d\n" % int(p["CPU_CFU"]))
+        f.write("GNG_CFS_MOVE ?= %d\n" % int(p["CFS_MOVE"]))
+
+
+def apply(board: str, name: str):
+    p = PRESETS[board][name]
+    prj = PROJECTS[board]
+    write_vhdl(board, name, p, os.path.join(prj, "src", "gng_preset.vhd"))
+    print("wrote", os.path.join(prj, "src", "gng_preset.vhd"))
+    if board == "v3":
+        mk = os.path.join(prj, "..", "fw", "preset.mk")
+        write_fw_mk(name, p, mk)
+        print("wrote", os.path.normpath(mk), "(rebuild the firmware too)")
+
+
+def _wrap(d: int, m: int) -> int:
+    return d % m
+
+
+def samples_per_s(board: str, log: str, data_words: int = 100) -> float:
+    import gngio
+    n = 0
+    t = 0.0
+    prev = None
+    for t_ns, fr in gngio.replay(log):
+        if board == "v3" and fr.kind == "ff" and fr.cmd == gngio.CMD_PROF:
+            d = gngio.decode_prof(fr.payload)
+            if "step" not in d:
+                continue
+            cur = (d["step"], t_ns)
+            if prev is not None:
+                n += _wrap(cur[0] - prev[0], 1 << 32)
+                t += (cur[1] - prev[1]) / 1e9
+        elif board == "v2" and fr.kind == "a5" and fr.cmd == gngio.A5_DBG:
+            d = gngio.decode_a5_dbg(fr.payload)
+            cur = (d["sample"], d["ts"])
+            if prev is not None:
+                n += _wrap(cur[0] - prev[0], min(data_words, 256))
+                t += _wrap(cur[1] - prev[1], 1 << 32) / CLOCK_HZ
+        else:
+            continue
+        prev = cur
+    return n / t if t > 0 else float("nan")
+
+
+def summary(board: str, args):
+    cols = ["preset"] + list(RES) + ["Fmax (MHz)", "samples/s"]
+    print("| " + " | ".join(cols) + " |")
+    print("|" + "|".join("-" * (len(c) + 2) for c in cols) + "|")
+    for a in args:
+        label, _, rest = a.rpartition("=")
+        d, _, log = rest.partition(",")
+        r = read_run(d)
+        cells = [label or d]
+        cells += ["%d/%d" % r[k] if k in r else "-" for k in RES]
+        cells.append("%.3f" % r["Fmax"] if "Fmax" in r else "-")
+        cells.append("%.0f" % samples_per_s(board, log) if log else "-")
+        print("| " + " | ".join(cells) + " |")
+
+
+def main(argv):
+    if not argv or argv[0] == "list":
+        for board, tab in PRESETS.items():
+            for name, p in tab.items():
+                print("%s %-15s %s" % (board, name, p["doc"]))
+        return
+    op, board = argv[0], argv[1] if len(argv) > 1 else ""
+    if board not in PRESETS:
+        raise SystemExit("board must be v2 or v3")
+    if op == "apply":
+        apply(board, argv[2])
+    elif op == "summary":
+        summary(board, argv[2:] or ["impl" if board == "v3" else os.path.join(PROJECTS["v2"], "impl")])
+    else:
+        raise SystemExit(__doc__)
+
+
+if __name__ == "__main__":
+    main(sys.argv[1:])
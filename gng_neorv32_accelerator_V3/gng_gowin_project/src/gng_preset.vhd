@@ -0,0 +1,26 @@
+-- gng_preset.vhd : build preset "default" (V3)
+-- 4 lanes at 27 MHz, 20 nodes (the reference build)
+-- generated by gng_neorv32_accelerator_V3/gng_gowin_project/presets.py,
+-- re-run `python presets.py apply v3 <name>` instead of editing
+
+package gng_preset is
+  constant PRESET_NAME          : string := "default";
+  constant PRESET_CFS_LANES     : natural := 4;
+  constant PRESET_CFS_MAXNODES  : natural := 40;
+  constant PRESET_CFS_CTX       : natural := 1;
+  constant PRESET_CFS_DIM       : natural := 2;
+  constant PRESET_CFS_CLK_MUL   : natural := 1;
+  constant PRESET_CFS_COARSE    : natural := 0;
+  constant PRESET_CPU_EXT_M     : boolean := true;
+  constant PRESET_CPU_EXT_B     : boolean := true;
+  constant PRESET_CPU_FAST_MUL  : boolean := false;
+  constant PRESET_CPU_DMA       : boolean := true;
+  constant PRESET_CPU_DUAL_CORE : boolean := false;
+  constant PRESET_CPU_ICACHE    : natural := 64;
+  constant PRESET_CPU_TRACER    : natural := 0;
+  constant PRESET_CPU_CFU       : boolean := false;
+  constant PRESET_SNAPSHOT_SDI  : boolean := false;
+  constant PRESET_SD_CARD       : boolean := false;
+  constant PRESET_CFS_MOVE      : boolean := false;
+  constant PRESET_CFS_DUMP      : boolean := false;
+end package;
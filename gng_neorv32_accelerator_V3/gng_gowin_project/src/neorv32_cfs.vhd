@@ -1,9 +1,106 @@
 -- ================================================================================
 -- NEORV32 CFS (Winner Finder) - SAFE (NO blocking-read), Q2.30 correct
--- - Node mem: 40 x 32-bit (packed Q1.15 x,y)
--- - Winner scan: 1 node per clock
+-- - Node mem: MAXNODES x WS x 32-bit (packed Q1.15 x,y), LANES banks (node i -> bank i mod LANES)
+-- - Winner scan (neorv32_cfs_engine): LANES nodes per clock through a
+--   read -> diff -> square -> sum -> tree -> merge pipeline,
+--   only lane groups holding an active node are visited (find-first-set skip)
 -- - dist_u = dx^2 + dy^2 in Q2.30 (NO >>15)
--- - Bus: 1-cycle response (registered)
+-- - Bus: ack + read data on the clock after stb, back-to-back accesses
+--   (CPU stores / neorv32_dma word streams) need no idle cycle in between
+-- - IRQ: irq_o = DONE and CTRL.IRQ_EN (level, dropped by CTRL.CLEAR / START)
+-- - Batch: CTRL.BATCH scans SMP_PUSH FIFO samples back-to-back (same node_mem /
+--   ACT mask), each result (s1,s2,min1) goes to a ring read via RES_S12/RES_MIN1.
+--   DONE with SMP level 0 = batch finished
+-- - Capacity: MAXNODES generic (1..256, 8-bit ids). The active mask is
+--   ceil(MAXNODES/32) words at ACT_BASE+w; ACT_LO/ACT_HI stay as words 0/1.
+--   INFO reads back MAXNODES | LANES<<16 | CLK_ASYNC<<24 | DBUF<<25 | PERF<<26 so the
+--   firmware can check its build
+-- - Contexts: CTX generic node_mem banks of MAXNODES words (1..8), one per
+--   GNG instance of the firmware (gng_core/gng_ctx.h). REG_CTX selects the
+--   bank the node window and the engine use, so a model switch is one
+--   register write. INFO bits 31..28 read back CTX (0 on older bitstreams)
+-- - Parameters: REG_LAMBDA..REG_D are plain RW words (reset = the gng_core.h
+--   defaults, rates Q16). The engine does not use them; the firmware mirrors
+--   its CMD_SET_PARAMS values there. The move unit reads EPS_B / EPS_N
+-- - Clocking: CLK_ASYNC = false runs the engine on clk_i. With true it runs
+--   on clk_cfs_i (PLL, any ratio). Crossings:
+--     START / CLEAR / FLUSH  : toggles, 2-FF synchronizer
+--     engine ack / busy      : 2-FF synchronizer back to clk_i
+--     FIFO / ring pointers   : Gray code, 2-FF synchronizer
+--     node_mem, ACT, the
+--     XIN/YIN / VEC copy
+--     of START, NODE_COUNT,
+--     OUT_*, CTX             : quasi-static, only written by the side that
+--                              is not using them (fw flushes nodes before
+--                              START, reads OUT_* after DONE)
+--   tang_nano_9k.sdc must declare the two clocks asynchronous
+-- - Sleep: CTRL.SLEEP (b5, rewritten on every CTRL write like IRQ_EN / BATCH)
+--   drops clk_en_o; tang_nano_9k gates clk_cfs_i with it (DCE). START /
+--   CLEAR / FLUSH writes leave b5 clear, so they wake the engine first and
+--   the toggles cross once its clock runs. Without CLK_ASYNC nothing is gated
+-- - Dimension: DIM generic (2..64 components). A node / sample is WORDS =
+--   ceil(DIM/2) packed Q1.15 pairs, node i word w at NODE_BASE + i*WS + w
+--   (WS = WORDS rounded up to a power of two, 1 for DIM = 2), sample word
+--   w >= 1 at VEC_BASE + w (word 0 is XIN/YIN; the unused half of an odd
+--   DIM is 0 on both sides). The engine streams the WORDS of a lane group
+--   through the pipeline and sums (dx^2 + dy^2) >> log2(WS) per word, so
+--   min1 stays 32 bit and a search takes active groups * WORDS + 5 clocks.
+--   REG_DIM reads back DIM (0 on older bitstreams = 2). Batch samples
+--   (SMP_PUSH) are one word: CTRL.BATCH needs DIM = 2
+-- - Input double buffer: XIN / YIN and the VEC words are staging registers,
+--   a START write latches them into the copy the engine scans. The firmware
+--   may write sample k+1 while sample k is searched. XIN / YIN are copied
+--   (a START without new writes scans the same sample again); the VEC words
+--   sit in two banks that swap at a START when one was written since the
+--   last START, so a new sample writes all of its VEC words. INFO bit 25
+--   reads '1' on bitstreams with the double buffer
+-- - Perf counters (24..31, clk_i domain, 32 bit, wrap): START writes, SMP_PUSH
+--   samples accepted, cycles busy / idle (not busy, not SLEEP), node window
+--   writes, bus accesses, stalls (CTRL reads while busy = polling, SMP_PUSH
+--   writes dropped on a full FIFO, RES_MIN1 reads of an empty ring).
+--   PERF_CTRL W: b0 clear all, b1 FREEZE (sticky, counters hold so a burst
+--   read is one consistent set); R: b1 FREEZE, 15..8 counter count.
+--   INFO bit 26 reads '1' on bitstreams with the block
+-- - Coarse pass: COARSE generic (0 = off, else 1..32 lanes, power of two).
+--   coarse_mem shadows node_mem with the top byte of each Q1.15 component
+--   (written with the node window, COARSE banks, node i -> bank i mod
+--   COARSE). The engine first bounds every active node from the top bytes,
+--   COARSE nodes per clock on LUT multipliers, then runs the exact LANES
+--   scan over the nodes that can still be s1 / s2 (see
+--   neorv32_cfs_engine), with the same results. The point is LANES = 1 or
+--   2 (1 to 2 of the 10 DSPs) with COARSE = 8 or 16: at LANES = 1, COARSE =
+--   16 a 40 node search is 3 coarse groups + ~3 candidates + 10 clocks
+--   instead of 45 once the map has spread out (a node pile-up refines
+--   more). INFO bit 27 reads '1' and REG_DIM bits 15..8 COARSE on
+--   bitstreams with the pass
+-- - Move unit: MOVE generic (DIM = 2, not CLK_ASYNC). adj_mem mirrors the
+--   firmware's neighbor rows (gng_core.h nbr[]), row r word w at ADJ_BASE +
+--   r*8 + w (RW, CTX banks like node_mem). A START with CTRL.MOVE (b6, not
+--   with BATCH) runs the search and then, on clk_i, moves s1 by EPS_B and
+--   every active node of row s1 by EPS_N towards the latched XIN / YIN:
+--   p + ((eps * (t - p) + 32768) >> 16) per Q1.15 half, gng_core.h
+--   pos_step of GNG_POS16, on two 18 x 18 multipliers. node_mem (and
+--   coarse_mem) get the moved words, DONE waits for the last one: 3 clocks
+--   per node plus 1 per row word. Fewer than two active nodes (OUT_MIN2 =
+--   all ones) move nothing. Edge aging and the connect / delete / insert
+--   policy stay with the firmware, which reads the moved words back through
+--   the node window. REG_DIM bit 16 reads '1' on bitstreams with the unit
+-- - Snapshot dump: DUMP generic (clk_i). A REG_DUMP write with START (b8)
+--   latches ACT and CTX and sends a keyframe on the UART0 pin, Processing
+--   frames with the firmware's checksum: CMD_GNG_NODES [fid][n] then
+--   [id][x][y] per active node (word 0 of node_mem, (q15 * 1000) >> 15 =
+--   gng_core.h pos_to_wire of GNG_POS16, at most 50 nodes) and, with EDGES
+--   (b9, MOVE only), the i < j pairs of adj_mem as one CMD_GNG_EDGES frame
+--   (up to 126) or CMD_GNG_EDGES_CHUNK frames of 124. The pairs are
+--   collected into pair_mem first (DP_PAIRS, 1 clock per word + 1 per
+--   pair), so the counts in the headers hold while training goes on; node
+--   words are read as they are sent. The line is shared with UART0:
+--   uart_ctsn_o holds UART0 (CTS, the firmware sets UART0 CTRL.HWFC_EN)
+--   from the START write to the last stop bit, the framer waits for 11 idle
+--   bit times on uart_txd_i, then owns uart_txd_o. REG_DUMP_DIV = clk_i
+--   cycles per bit (0 = START ignored). REG_DUMP reads busy (0), own (1),
+--   pair_mem overflow (2), nodes (15..8) and pairs (31..16) of the last
+--   dump. REG_DIM bit 17 reads '1' on bitstreams with the unit
 -- ================================================================================
 library ieee;
 use ieee.std_logic_1164.all;
@@ -13,12 +110,27 @@ library neorv32;
 use neorv32.neorv32_package.all;
 
 entity neorv32_cfs is
+  generic (
+    LANES     : natural := 4;     -- distance lanes: 1, 2, 4 or 8 (one MULTADDALU18X18 DSP each)
+    MAXNODES  : natural := 40;    -- node capacity, 1..256
+    CTX       : natural := 1;     -- node_mem banks (GNG instances), 1..8
+    DIM       : natural := 2;     -- components per node / sample, 2..64
+    COARSE    : natural := 0;     -- coarse-pass lanes (LUT only): 0 = off, 1..32, power of two
+    MOVE      : boolean := false; -- s1 / neighbor move after the search (CTRL.MOVE)
+    DUMP      : boolean := false; -- keyframe framer on the UART0 pin (REG_DUMP)
+    CLK_ASYNC : boolean := false  -- winner engine on clk_cfs_i instead of clk_i
+  );
   port (
     clk_i     : in  std_ulogic;
+    clk_cfs_i : in  std_ulogic := '0'; -- engine clock, used if CLK_ASYNC
     rstn_i    : in  std_ulogic;
     bus_req_i : in  bus_req_t;
     bus_rsp_o : out bus_rsp_t;
-    irq_o     : out std_ulogic
+    irq_o     : out std_ulogic;
+    clk_en_o  : out std_ulogic; -- '0' = engine clock may stop (CTRL.SLEEP)
+    uart_txd_i  : in  std_ulogic := '1'; -- UART0 TX
+    uart_txd_o  : out std_ulogic;        -- TX pin: UART0 or the dump framer
+    uart_ctsn_o : out std_ulogic         -- '1' = UART0 must not start a byte (DUMP)
   );
 end neorv32_cfs;
 
@@ -44,139 +156,824 @@ architecture neorv32_cfs_rtl of neorv32_cfs is
   constant REG_OUT_MIN1   : natural := 14;
   constant REG_OUT_MIN2   : natural := 15;
 
-  constant MAXNODES  : natural := 40;
+  constant REG_SMP_PUSH   : natural := 16; -- W: push x | y<<16 (Q1.15)
+  constant REG_BATCH      : natural := 17; -- R: SMP level (7..0), RES level (15..8)
+  constant REG_RES_S12    : natural := 18; -- R: ring head s1 | s2<<8 (no pop)
+  constant REG_RES_MIN1   : natural := 19; -- R: ring head min1, pops the entry
+  constant REG_INFO       : natural := 20; -- R: MAXNODES (15..0) | LANES (23..16) | CLK_ASYNC (24) | DBUF (25) | PERF (26) | COARSE (27) | CTX (31..28)
+  constant REG_CTX        : natural := 21; -- RW: node_mem bank of the node window and the engine
+  constant REG_DIM        : natural := 22; -- R: DIM (7..0) | COARSE lanes (15..8) | MOVE (16) | DUMP (17)
+  constant REG_DUMP       : natural := 23; -- W: frame id (7..0) | START (8) | EDGES (9); R: busy (0) | own (1) | ovf (2) | nodes (15..8) | pairs (31..16)
+  constant REG_PERF_CTRL  : natural := 24; -- W: b0 clear, b1 freeze; R: b1 freeze, count (15..8)
+  constant REG_PERF_BASE  : natural := 25; -- R: counter k at 25 + k (PERF_* below)
+  constant REG_DUMP_DIV   : natural := 32; -- RW: clk_i cycles per UART bit (15..0), 0 = no dump
+  constant REG_ACT_BASE   : natural := 64; -- RW: ACT word w (nodes 32w..32w+31)
+
+  constant SMP_DEPTH : natural := 32; -- sample FIFO / result ring entries
+
+  -- perf counters, index k = word REG_PERF_BASE + k
+  constant PERF_START   : natural := 0;
+  constant PERF_SMP     : natural := 1;
+  constant PERF_BUSY    : natural := 2;
+  constant PERF_IDLE    : natural := 3;
+  constant PERF_NODE_WR : natural := 4;
+  constant PERF_BUS     : natural := 5;
+  constant PERF_STALL   : natural := 6;
+  constant PERF_N       : natural := 7;
   constant NODE_BASE : natural := 128;
+  constant VEC_BASE  : natural := 4096; -- RW: sample word w (1..WORDS-1) at VEC_BASE + w
+  constant ADJ_BASE  : natural := 8192; -- RW: neighbor row r word w at ADJ_BASE + r*ADJ_WS + w (MOVE)
+  constant ADJ_WS    : natural := 8;    -- row stride, 256 nodes
+
+  function log2ceil(n : natural) return natural is
+    variable r : natural := 0;
+  begin
+    while (2**r) < n loop
+      r := r + 1;
+    end loop;
+    return r;
+  end function;
+
+  constant ROWS      : natural := (MAXNODES + LANES - 1) / LANES;
+  constant ACT_WORDS : natural := (MAXNODES + 31) / 32;
+  constant WORDS     : natural := (DIM + 1) / 2;   -- Q1.15 pairs per node / sample
+  constant DSHIFT    : natural := log2ceil(WORDS); -- per-word sum >> DSHIFT
+  constant WS        : natural := 2**DSHIFT;       -- node window / bank stride
+  constant CLANES    : natural := COARSE + boolean'pos(COARSE = 0); -- coarse_mem banks (1 if unused)
+  constant CROWS     : natural := (MAXNODES + CLANES - 1) / CLANES;
+
+  -- node i lives in bank (i mod LANES), row (i / LANES): every lane reads its own bank;
+  -- context c adds c * ROWS to the row, word w of the row is at row * WS + w
+  type node_bank_t is array (0 to CTX*ROWS*WS-1) of std_ulogic_vector(31 downto 0);
+  type node_mem_t  is array (0 to LANES-1) of node_bank_t;
+  signal node_mem  : node_mem_t := (others => (others => (others => '0')));
+  signal node_row  : natural range 0 to ROWS-1;
+  signal node_word : natural range 0 to WORDS-1;
+  signal node_rd   : std_ulogic_vector(LANES*32-1 downto 0);
+  signal ctx_sel   : natural range 0 to CTX-1 := 0;
+
+  -- top bytes x(15..8) | y(15..8) << 8 of every node_mem word, same layout
+  -- with COARSE banks of CROWS rows (see Coarse pass)
+  type coarse_bank_t is array (0 to CTX*CROWS*WS-1) of std_ulogic_vector(15 downto 0);
+  type coarse_mem_t  is array (0 to CLANES-1) of coarse_bank_t;
+  signal coarse_mem : coarse_mem_t := (others => (others => (others => '0')));
+  signal coarse_row : natural range 0 to CROWS-1;
+  signal coarse_rd  : std_ulogic_vector(CLANES*16-1 downto 0);
+
+  -- sample words 1..WORDS-1 (word 0 = XIN/YIN), two banks: the bus writes
+  -- vec_wb, the engine reads vec_rb (see Input double buffer)
+  type vec_mem_t is array (0 to 2*WS-1) of std_ulogic_vector(31 downto 0);
+  signal vec_mem : vec_mem_t := (others => (others => '0'));
+  signal vin_rd  : std_ulogic_vector(31 downto 0);
+  signal vec_wb  : natural range 0 to 1 := 1;
+  signal vec_rb  : natural range 0 to 1 := 0;
+  signal vec_new : std_ulogic := '0'; -- vec_wb written since the last START
 
-  type node_mem_t is array (0 to MAXNODES-1) of std_ulogic_vector(31 downto 0);
-  signal node_mem : node_mem_t := (others => (others => '0'));
+  -- neighbor rows (ACT_WORDS words each, CTX banks), a single word without MOVE
+  constant ADJ_N : natural := cond_sel_natural_f(MOVE, CTX*MAXNODES*ACT_WORDS, 1);
+  type adj_mem_t is array (0 to ADJ_N-1) of std_ulogic_vector(31 downto 0);
+  signal adj_mem : adj_mem_t := (others => (others => '0'));
+
+  -- move unit: MV_WAIT for the search, then LOAD / STORE per node and NEXT
+  -- for the next neighbor of row mv_s1 (mv_bits = word mv_wc of it & act)
+  type mv_state_t is (MV_IDLE, MV_WAIT, MV_LOAD, MV_STORE, MV_NEXT);
+  signal mv_st   : mv_state_t := MV_IDLE;
+  signal mv_s1   : natural range 0 to MAXNODES-1 := 0;
+  signal mv_id   : natural range 0 to MAXNODES-1 := 0;
+  signal mv_w    : natural range 0 to ACT_WORDS := 0;
+  signal mv_wc   : natural range 0 to ACT_WORDS-1 := 0;
+  signal mv_bits : std_ulogic_vector(31 downto 0) := (others => '0');
+  signal mv_eps  : unsigned(16 downto 0) := (others => '0');
+  signal mv_p    : std_ulogic_vector(31 downto 0) := (others => '0');
+  signal moving  : std_ulogic;
+
+  -- snapshot dump (see Snapshot dump): pair_mem holds the collected i < j pairs
+  constant DP_PAIRS  : natural := cond_sel_natural_f(DUMP and MOVE, 512, 1);
+  constant DP_NODES  : natural := 50;  -- node records in one CMD_GNG_NODES frame
+  constant DP_SINGLE : natural := 126; -- pairs in one CMD_GNG_EDGES frame
+  constant DP_CHUNK  : natural := 124; -- pairs per CMD_GNG_EDGES_CHUNK frame
+  signal dump_stat : std_ulogic_vector(31 downto 0) := (others => '0');
+  signal dump_div  : unsigned(15 downto 0) := (others => '0');
+
+  -- p + ((eps * (t - p) + 32768) >> 16) of one Q1.15 component, mod 2^16
+  -- (gng_core.h pos_step with GNG_POS16)
+  function lerp_q15(p, t : std_ulogic_vector(15 downto 0); eps : unsigned(16 downto 0)) return std_ulogic_vector is
+    variable d : signed(17 downto 0);
+    variable m : signed(35 downto 0);
+  begin
+    d := resize(signed(t), 18) - resize(signed(p), 18);
+    m := d * signed('0' & eps) + 32768;
+    return std_ulogic_vector(signed(p) + m(31 downto 16));
+  end function;
+
+  -- (v * 1000) >> 15 of a Q1.15 component (gng_core.h pos_to_wire, GNG_POS16)
+  function q15_to_wire(v : std_ulogic_vector(15 downto 0)) return std_ulogic_vector is
+    variable p : signed(25 downto 0);
+  begin
+    p := shift_left(resize(signed(v), 26), 10) - shift_left(resize(signed(v), 26), 4) -
+         shift_left(resize(signed(v), 26), 3);
+    return std_ulogic_vector(resize(shift_right(p, 15), 16));
+  end function;
+
+  function popcount(m : std_ulogic_vector(31 downto 0)) return natural is
+    variable n : natural range 0 to 32 := 0;
+  begin
+    for i in 0 to 31 loop
+      if m(i) = '1' then
+        n := n + 1;
+      end if;
+    end loop;
+    return n;
+  end function;
 
-  signal xin_q15       : unsigned(15 downto 0) := (others => '0');
+  -- bits j > r of ACT word w (the i < j half of adj row r)
+  function upper_mask(r, w : natural) return std_ulogic_vector is
+    variable m : std_ulogic_vector(31 downto 0);
+  begin
+    for b in 0 to 31 loop
+      if 32*w + b > r then
+        m(b) := '1';
+      else
+        m(b) := '0';
+      end if;
+    end loop;
+    return m;
+  end function;
+
+  -- index of the lowest set bit, 32 if none
+  function find_first_set(m : std_ulogic_vector(31 downto 0)) return natural is
+  begin
+    for i in 0 to 31 loop
+      if m(i) = '1' then
+        return i;
+      end if;
+    end loop;
+    return 32;
+  end function;
+
+  function bin2gray(b : unsigned) return std_ulogic_vector is
+  begin
+    return std_ulogic_vector(b xor shift_right(b, 1));
+  end function;
+
+  function gray2bin(g : std_ulogic_vector) return unsigned is
+    variable b : unsigned(g'length-1 downto 0);
+  begin
+    b(b'high) := g(g'high);
+    for i in b'high-1 downto 0 loop
+      b(i) := b(i+1) xor g(g'low + i);
+    end loop;
+    return b;
+  end function;
+
+  -- batch sample FIFO (bus -> engine), 1 extra pointer bit; the result ring
+  -- sits in the engine
+  type smp_mem_t is array (0 to SMP_DEPTH-1) of std_ulogic_vector(31 downto 0);
+  signal smp_mem   : smp_mem_t;
+  signal smp_wp    : unsigned(5 downto 0) := (others => '0');
+  signal res_rp    : unsigned(5 downto 0) := (others => '0');
+  signal smp_wp_g  : std_ulogic_vector(5 downto 0) := (others => '0');
+  signal res_rp_g  : std_ulogic_vector(5 downto 0) := (others => '0');
+  signal smp_level : unsigned(5 downto 0);
+  signal res_level : unsigned(5 downto 0);
+  signal smp_push  : std_ulogic;
+  signal smp_raddr : unsigned(4 downto 0);
+  signal smp_rdata : std_ulogic_vector(31 downto 0);
+  signal res_head  : std_ulogic_vector(47 downto 0);
+  signal batch_en  : std_ulogic := '0';
+
+  type perf_t is array (0 to PERF_N-1) of unsigned(31 downto 0);
+  signal perf        : perf_t := (others => (others => '0'));
+  signal perf_freeze : std_ulogic := '0';
+
+  signal xin_q15       : unsigned(15 downto 0) := (others => '0'); -- staging (bus)
   signal yin_q15       : unsigned(15 downto 0) := (others => '0');
-  signal node_count_u8 : unsigned(7 downto 0)  := to_unsigned(2, 8);
-  signal act_lo        : std_ulogic_vector(31 downto 0) := (others => '0');
-  signal act_hi        : std_ulogic_vector(7 downto 0)  := (others => '0');
-
-  signal out_s1   : unsigned(7 downto 0)  := (others => '0');
-  signal out_s2   : unsigned(7 downto 0)  := (others => '0');
-  signal out_min1 : unsigned(31 downto 0) := (others => '1');
-  signal out_min2 : unsigned(31 downto 0) := (others => '1');
-
-  signal busy        : std_ulogic := '0';
-  signal done        : std_ulogic := '0';
-  signal start_pulse : std_ulogic := '0';
-  signal clear_pulse : std_ulogic := '0';
-
-  type fsm_t is (IDLE, RUN);
-  signal fsm : fsm_t := IDLE;
-  signal i_u : unsigned(7 downto 0) := (others => '0');
-
-  signal stb_prev  : std_ulogic := '0';
-  signal req_valid : std_ulogic := '0';
-  signal req_rw    : std_ulogic := '0';
-  signal req_ben   : std_ulogic_vector(3 downto 0) := (others => '0');
-  signal req_idx_u : unsigned(13 downto 0) := (others => '0');
+  signal xin_run       : unsigned(15 downto 0) := (others => '0'); -- latched by START (engine)
+  signal yin_run       : unsigned(15 downto 0) := (others => '0');
+  signal node_count_u  : unsigned(8 downto 0)  := to_unsigned(2, 9);
+  signal act           : std_ulogic_vector(ACT_WORDS*32-1 downto 0) := (others => '0');
+
+  signal out_s1   : unsigned(7 downto 0);
+  signal out_s2   : unsigned(7 downto 0);
+  signal out_min1 : unsigned(31 downto 0);
+  signal out_min2 : unsigned(31 downto 0);
+
+  -- bus side control: toggles to the engine, DONE = engine ack of the last START
+  signal start_t    : std_ulogic := '0';
+  signal clear_t    : std_ulogic := '0';
+  signal flush_t    : std_ulogic := '0';
+  signal armed      : std_ulogic := '0'; -- START seen, not yet CLEARed
+  signal bdone      : std_ulogic := '0'; -- a batch scan finished since START / CLEAR
+  signal bdone_seen : std_ulogic := '0';
+  signal flushing   : std_ulogic := '0';
+  signal done       : std_ulogic;
+  signal busy       : std_ulogic;
+  signal irq_en     : std_ulogic := '0';
+  signal sleep      : std_ulogic := '0';
+
+  -- GNG parameters REG_LAMBDA..REG_D (lambda, a_max, eps_b, eps_n, alpha, d)
+  type par_regs_t is array (REG_LAMBDA to REG_D) of std_ulogic_vector(31 downto 0);
+  constant PAR_RESET : par_regs_t := (
+    std_ulogic_vector(to_unsigned(100, 32)),    -- lambda
+    std_ulogic_vector(to_unsigned(50, 32)),     -- a_max
+    std_ulogic_vector(to_unsigned(19661, 32)),  -- eps_b 0.3
+    std_ulogic_vector(to_unsigned(66, 32)),     -- eps_n 0.001
+    std_ulogic_vector(to_unsigned(32768, 32)),  -- alpha 0.5
+    std_ulogic_vector(to_unsigned(65208, 32))); -- d 0.995
+  signal par_regs : par_regs_t := PAR_RESET;
+
+  -- engine side (e_*) and its clk_i view (b_*)
+  signal e_rstn : std_ulogic;
+  signal e_start_t, e_clear_t, e_flush_t, e_batch_en : std_ulogic;
+  signal e_smp_wp_g, e_res_rp_g : std_ulogic_vector(5 downto 0);
+  signal e_ack, e_bdone_t, e_flush_ack, e_busy : std_ulogic;
+  signal e_smp_rp_g, e_res_wp_g : std_ulogic_vector(5 downto 0);
+  signal b_ack, b_bdone_t, b_flush_ack, b_busy : std_ulogic;
+  signal b_smp_rp_g, b_res_wp_g : std_ulogic_vector(5 downto 0);
+
   signal accept    : std_ulogic;
 
 begin
 
-  irq_o <= '0';
+  assert (LANES = 1) or (LANES = 2) or (LANES = 4) or (LANES = 8)
+    report "neorv32_cfs: LANES must be 1, 2, 4 or 8" severity failure;
+  assert (MAXNODES >= 1) and (MAXNODES <= 256)
+    report "neorv32_cfs: MAXNODES must be 1..256" severity failure;
+  assert (CTX >= 1) and (CTX <= 8)
+    report "neorv32_cfs: CTX must be 1..8" severity failure;
+  assert (DIM >= 2) and (DIM <= 64)
+    report "neorv32_cfs: DIM must be 2..64" severity failure;
+  assert (COARSE = 0) or (COARSE = 1) or (COARSE = 2) or (COARSE = 4) or (COARSE = 8) or
+         (COARSE = 16) or (COARSE = 32)
+    report "neorv32_cfs: COARSE must be 0, 1, 2, 4, 8, 16 or 32" severity failure;
+  assert NODE_BASE + MAXNODES*WS <= VEC_BASE
+    report "neorv32_cfs: node window (MAXNODES * WS) runs into VEC_BASE" severity failure;
+  assert (not MOVE) or ((DIM = 2) and (not CLK_ASYNC))
+    report "neorv32_cfs: MOVE needs DIM = 2 and CLK_ASYNC = false" severity failure;
 
-  accept <= bus_req_i.stb and (not stb_prev) and (not req_valid);
+  -- level IRQ: stays high until firmware acks with CTRL.CLEAR (or next START)
+  irq_o <= done and irq_en;
+
+  clk_en_o <= not sleep;
+
+  moving <= '0' when mv_st = MV_IDLE else '1';
+
+  done <= '1' when ((armed = '1') and (b_ack = start_t) and (moving = '0')) or (bdone = '1') else '0';
+  busy <= '1' when ((armed = '1') and (b_ack /= start_t)) or (b_busy = '1') or (flushing = '1') or
+                   (moving = '1') else '0';
+
+  accept <= bus_req_i.stb; -- single-shot strobe, one access per cycle
+
+  smp_level <= smp_wp - gray2bin(b_smp_rp_g);
+  res_level <= gray2bin(b_res_wp_g) - res_rp;
+
+  smp_push <= '1' when (accept = '1') and (bus_req_i.rw = '1') and (bus_req_i.ben = "1111") and
+                       (unsigned(bus_req_i.addr(15 downto 2)) = REG_SMP_PUSH) and
+                       (smp_level /= SMP_DEPTH) and (flushing = '0') else '0';
+
+  -- engine read ports: node_mem row word (one per lane), sample word and FIFO head
+  node_rd_gen:
+  for l in 0 to LANES-1 generate
+    node_rd(32*l+31 downto 32*l) <= node_mem(l)((ctx_sel * ROWS + node_row) * WS + node_word);
+  end generate;
+  coarse_rd_gen:
+  if COARSE > 0 generate
+    coarse_lane_gen:
+    for l in 0 to CLANES-1 generate
+      coarse_rd(16*l+15 downto 16*l) <= coarse_mem(l)((ctx_sel * CROWS + coarse_row) * WS + node_word);
+    end generate;
+  end generate;
+  coarse_off_gen:
+  if COARSE = 0 generate
+    coarse_rd <= (others => '0');
+  end generate;
+  vin_rd    <= vec_mem(vec_rb * WS + node_word);
+  smp_rdata <= smp_mem(to_integer(smp_raddr));
+
+  -- sample FIFO storage + write pointer (no reset on the array -> distributed RAM)
+  smp_fifo_wr: process(clk_i)
+  begin
+    if rising_edge(clk_i) then
+      if smp_push = '1' then
+        smp_mem(to_integer(smp_wp(4 downto 0))) <= bus_req_i.data;
+      end if;
+      if rstn_i = '0' then
+        smp_wp <= (others => '0');
+      elsif smp_push = '1' then
+        smp_wp <= smp_wp + 1;
+      end if;
+    end if;
+  end process;
+
+  -- perf counters: decode the bus request themselves (like smp_push), only
+  -- PERF_CTRL writes and the reads live in bus_access
+  perf_cnt: process(clk_i)
+    variable reg_idx : natural;
+    variable wr, rd  : boolean;
+  begin
+    if rising_edge(clk_i) then
+      reg_idx := to_integer(unsigned(bus_req_i.addr(15 downto 2)));
+      wr := (accept = '1') and (bus_req_i.rw = '1') and (bus_req_i.ben = "1111");
+      rd := (accept = '1') and (bus_req_i.rw = '0');
+      if rstn_i = '0' then
+        perf        <= (others => (others => '0'));
+        perf_freeze <= '0';
+      elsif wr and (reg_idx = REG_PERF_CTRL) then
+        if bus_req_i.data(0) = '1' then
+          perf <= (others => (others => '0'));
+        end if;
+        perf_freeze <= bus_req_i.data(1);
+      elsif perf_freeze = '0' then
+        if wr and (reg_idx = REG_CTRL) and (bus_req_i.data(1) = '1') then
+          perf(PERF_START) <= perf(PERF_START) + 1;
+        end if;
+        if smp_push = '1' then
+          perf(PERF_SMP) <= perf(PERF_SMP) + 1;
+        end if;
+        if busy = '1' then
+          perf(PERF_BUSY) <= perf(PERF_BUSY) + 1;
+        elsif sleep = '0' then
+          perf(PERF_IDLE) <= perf(PERF_IDLE) + 1;
+        end if;
+        if wr and (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + MAXNODES*WS) then
+          perf(PERF_NODE_WR) <= perf(PERF_NODE_WR) + 1;
+        end if;
+        if accept = '1' then
+          perf(PERF_BUS) <= perf(PERF_BUS) + 1;
+        end if;
+        if (rd and (reg_idx = REG_CTRL) and (busy = '1')) or
+           (wr and (reg_idx = REG_SMP_PUSH) and (smp_push = '0')) or
+           (rd and (reg_idx = REG_RES_MIN1) and (res_level = 0)) then
+          perf(PERF_STALL) <= perf(PERF_STALL) + 1;
+        end if;
+      end if;
+    end if;
+  end process;
 
   -- ==========================================================
-  -- Winner FSM (1 node/clock) - Q2.30 correct
+  -- Winner engine: same clock, or clk_cfs_i behind synchronizers
   -- ==========================================================
-  winner_fsm: process(clk_i, rstn_i)
-    variable idx_i      : natural;
-    variable ncnt       : natural;
-    variable active_bit : std_ulogic;
+  engine_sync:
+  if not CLK_ASYNC generate
+    e_rstn      <= rstn_i;
+    e_start_t   <= start_t;
+    e_clear_t   <= clear_t;
+    e_flush_t   <= flush_t;
+    e_batch_en  <= batch_en;
+    e_smp_wp_g  <= smp_wp_g;
+    e_res_rp_g  <= res_rp_g;
+    b_ack       <= e_ack;
+    b_bdone_t   <= e_bdone_t;
+    b_flush_ack <= e_flush_ack;
+    b_busy      <= e_busy;
+    b_smp_rp_g  <= e_smp_rp_g;
+    b_res_wp_g  <= e_res_wp_g;
 
-    variable xi_u, yi_u : unsigned(15 downto 0);
+    engine_inst: entity neorv32.neorv32_cfs_engine
+    generic map (
+      LANES => LANES, MAXNODES => MAXNODES, ROWS => ROWS, ACT_WORDS => ACT_WORDS, SMP_DEPTH => SMP_DEPTH,
+      WORDS => WORDS, DSHIFT => DSHIFT, COARSE => COARSE > 0, CLANES => CLANES, CROWS => CROWS
+    )
+    port map (
+      clk_i => clk_i, rstn_i => e_rstn,
+      act_i => act, ncnt_i => node_count_u, xin_i => xin_run, yin_i => yin_run,
+      node_row_o => node_row, node_word_o => node_word, node_rd_i => node_rd, vin_rd_i => vin_rd,
+      crow_o => coarse_row, coarse_rd_i => coarse_rd,
+      start_t_i => e_start_t, clear_t_i => e_clear_t, flush_t_i => e_flush_t, batch_en_i => e_batch_en,
+      ack_o => e_ack, bdone_t_o => e_bdone_t, flush_ack_o => e_flush_ack, busy_o => e_busy,
+      smp_wp_g_i => e_smp_wp_g, smp_rp_g_o => e_smp_rp_g, smp_raddr_o => smp_raddr, smp_rdata_i => smp_rdata,
+      res_rp_g_i => e_res_rp_g, res_wp_g_o => e_res_wp_g, res_raddr_i => res_rp(4 downto 0), res_rdata_o => res_head,
+      out_s1_o => out_s1, out_s2_o => out_s2, out_min1_o => out_min1, out_min2_o => out_min2
+    );
+  end generate;
 
-    variable dx18, dy18 : signed(17 downto 0);
-    variable dx2_36, dy2_36 : unsigned(35 downto 0);
-    variable dist_u      : unsigned(31 downto 0);
+  engine_async:
+  if CLK_ASYNC generate
+    -- 15: start/ack, 14: clear/bdone, 13: flush/flush_ack, 12: batch_en/busy,
+    -- 11..6: smp_wp/smp_rp (Gray), 5..0: res_rp/res_wp (Gray)
+    type sync_t is array (0 to 1) of std_ulogic_vector(15 downto 0);
+    signal e_sync : sync_t := (others => (others => '0')); -- clk_i -> clk_cfs_i
+    signal b_sync : sync_t := (others => (others => '0')); -- clk_cfs_i -> clk_i
+    signal e_rst  : std_ulogic_vector(1 downto 0) := "00";
   begin
-    if rstn_i = '0' then
-      fsm      <= IDLE;
-      busy     <= '0';
-      done     <= '0';
-      i_u      <= (others => '0');
-      out_s1   <= (others => '0');
-      out_s2   <= (others => '0');
-      out_min1 <= (others => '1');
-      out_min2 <= (others => '1');
-
-    elsif rising_edge(clk_i) then
+    -- reset: asynchronous assert, release synchronized to clk_cfs_i
+    e_reset: process(clk_cfs_i, rstn_i)
+    begin
+      if rstn_i = '0' then
+        e_rst <= "00";
+      elsif rising_edge(clk_cfs_i) then
+        e_rst <= e_rst(0) & '1';
+      end if;
+    end process;
+    e_rstn <= e_rst(1);
 
-      if clear_pulse = '1' then
-        done <= '0';
-        busy <= '0';
-        fsm  <= IDLE;
+    e_cdc: process(clk_cfs_i)
+    begin
+      if rising_edge(clk_cfs_i) then
+        e_sync(0) <= start_t & clear_t & flush_t & batch_en & smp_wp_g & res_rp_g;
+        e_sync(1) <= e_sync(0);
       end if;
+    end process;
+    e_start_t  <= e_sync(1)(15);
+    e_clear_t  <= e_sync(1)(14);
+    e_flush_t  <= e_sync(1)(13);
+    e_batch_en <= e_sync(1)(12);
+    e_smp_wp_g <= e_sync(1)(11 downto 6);
+    e_res_rp_g <= e_sync(1)(5 downto 0);
 
-      if start_pulse = '1' then
-        busy     <= '1';
-        done     <= '0';
-        fsm      <= RUN;
-        i_u      <= (others => '0');
-        out_min1 <= (others => '1');
-        out_min2 <= (others => '1');
-        out_s1   <= (others => '0');
-        out_s2   <= (others => '0');
+    b_cdc: process(clk_i)
+    begin
+      if rising_edge(clk_i) then
+        b_sync(0) <= e_ack & e_bdone_t & e_flush_ack & e_busy & e_smp_rp_g & e_res_wp_g;
+        b_sync(1) <= b_sync(0);
       end if;
+    end process;
+    b_ack       <= b_sync(1)(15);
+    b_bdone_t   <= b_sync(1)(14);
+    b_flush_ack <= b_sync(1)(13);
+    b_busy      <= b_sync(1)(12);
+    b_smp_rp_g  <= b_sync(1)(11 downto 6);
+    b_res_wp_g  <= b_sync(1)(5 downto 0);
 
-      if fsm = RUN then
-        ncnt := to_integer(node_count_u8);
-        if ncnt > MAXNODES then
-          ncnt := MAXNODES;
+    engine_inst: entity neorv32.neorv32_cfs_engine
+    generic map (
+      LANES => LANES, MAXNODES => MAXNODES, ROWS => ROWS, ACT_WORDS => ACT_WORDS, SMP_DEPTH => SMP_DEPTH,
+      WORDS => WORDS, DSHIFT => DSHIFT, COARSE => COARSE > 0, CLANES => CLANES, CROWS => CROWS
+    )
+    port map (
+      clk_i => clk_cfs_i, rstn_i => e_rstn,
+      act_i => act, ncnt_i => node_count_u, xin_i => xin_run, yin_i => yin_run,
+      node_row_o => node_row, node_word_o => node_word, node_rd_i => node_rd, vin_rd_i => vin_rd,
+      crow_o => coarse_row, coarse_rd_i => coarse_rd,
+      start_t_i => e_start_t, clear_t_i => e_clear_t, flush_t_i => e_flush_t, batch_en_i => e_batch_en,
+      ack_o => e_ack, bdone_t_o => e_bdone_t, flush_ack_o => e_flush_ack, busy_o => e_busy,
+      smp_wp_g_i => e_smp_wp_g, smp_rp_g_o => e_smp_rp_g, smp_raddr_o => smp_raddr, smp_rdata_i => smp_rdata,
+      res_rp_g_i => e_res_rp_g, res_wp_g_o => e_res_wp_g, res_raddr_i => res_rp(4 downto 0), res_rdata_o => res_head,
+      out_s1_o => out_s1, out_s2_o => out_s2, out_min1_o => out_min1, out_min2_o => out_min2
+    );
+  end generate;
+
+  -- ==========================================================
+  -- Snapshot dump: keyframe framer + UART TX on clk_i
+  -- ==========================================================
+  dump_on:
+  if DUMP generate
+    type dp_state_t is (DP_IDLE, DP_COUNT, DP_COLLECT, DP_GUARD, DP_FRAME, DP_HDR, DP_NEXT, DP_READ,
+                        DP_CONV, DP_REC, DP_CHK, DP_DRAIN);
+    type dp_bytes_t is array (0 to 10) of std_ulogic_vector(7 downto 0);
+    type pair_mem_t is array (0 to DP_PAIRS-1) of std_ulogic_vector(15 downto 0);
+    constant ACT_VALID : std_ulogic_vector(ACT_WORDS*32-1 downto 0) := (MAXNODES-1 downto 0 => '1', others => '0');
+    signal pair_mem   : pair_mem_t;                     -- a << 8 | b, no reset -> BSRAM
+    signal dp_st      : dp_state_t := DP_IDLE;
+    signal dp_fid     : std_ulogic_vector(7 downto 0) := (others => '0');
+    signal dp_edges   : std_ulogic := '0';              -- EDGES frames after NODES
+    signal dp_act     : std_ulogic_vector(ACT_WORDS*32-1 downto 0) := (others => '0');
+    signal dp_ctx     : natural range 0 to CTX-1 := 0;
+    signal dp_nodes   : natural range 0 to ACT_WORDS*32 := 0; -- node records (<= DP_NODES once counted)
+    signal dp_pairs   : natural range 0 to DP_PAIRS := 0;
+    signal dp_ovf     : std_ulogic := '0';              -- more pairs than pair_mem holds
+    signal dp_nch     : natural range 0 to 255 := 0;    -- CMD_GNG_EDGES_CHUNK frames
+    signal dp_cmod    : natural range 0 to DP_CHUNK-1 := 0;
+    signal dp_row     : natural range 0 to MAXNODES-1 := 0;
+    signal dp_w       : natural range 0 to ACT_WORDS := 0;
+    signal dp_wc      : natural range 0 to ACT_WORDS-1 := 0;
+    signal dp_bits    : std_ulogic_vector(31 downto 0) := (others => '0');
+    signal dp_edge_fr : std_ulogic := '0';              -- frame being sent: '0' NODES, '1' edges
+    signal dp_chunk   : natural range 0 to 255 := 0;
+    signal dp_pr      : natural range 0 to DP_PAIRS := 0; -- next pair to send
+    signal dp_cnt     : natural range 0 to 255 := 0;    -- records left in the frame
+    signal dp_id      : natural range 0 to MAXNODES-1 := 0;
+    signal dp_q       : std_ulogic_vector(31 downto 0) := (others => '0');
+    signal dp_buf     : dp_bytes_t := (others => (others => '0')); -- header or record bytes
+    signal dp_bn      : natural range 0 to 11 := 0;
+    signal dp_bi      : natural range 0 to 10 := 0;
+    signal dp_sum     : unsigned(7 downto 0) := (others => '0');
+    signal dp_byte    : std_ulogic_vector(7 downto 0) := (others => '0');
+    signal dp_bval    : std_ulogic := '0';              -- dp_byte waits for the transmitter
+    signal dp_own     : std_ulogic := '0';              -- uart_txd_o = the framer
+    signal dp_tick    : unsigned(15 downto 0) := (others => '0');
+    signal dp_gbits   : natural range 0 to 10 := 0;
+    signal tx_sreg    : std_ulogic_vector(9 downto 0) := (others => '1');
+    signal tx_bits    : natural range 0 to 10 := 0;
+    signal tx_tick    : unsigned(15 downto 0) := (others => '0');
+    signal txd        : std_ulogic := '1';
+  begin
+
+    uart_txd_o  <= txd;
+    uart_ctsn_o <= '0' when dp_st = DP_IDLE else '1';
+
+    dump_stat(0)            <= '0' when dp_st = DP_IDLE else '1';
+    dump_stat(1)            <= dp_own;
+    dump_stat(2)            <= dp_ovf;
+    dump_stat(7 downto 3)   <= (others => '0');
+    dump_stat(15 downto 8)  <= std_ulogic_vector(to_unsigned(dp_nodes, 8)) when dp_nodes <= DP_NODES else
+                               std_ulogic_vector(to_unsigned(DP_NODES, 8));
+    dump_stat(31 downto 16) <= std_ulogic_vector(to_unsigned(dp_pairs, 16));
+
+    -- decodes its own bus writes (REG_DUMP, REG_DUMP_DIV) like perf_cnt,
+    -- the reads live in bus_access
+    dump_unit: process(clk_i, rstn_i)
+      variable reg_idx : natural;
+      variable wr      : boolean;
+      variable n       : natural;
+      variable wx, wy  : std_ulogic_vector(15 downto 0);
+
+      -- hand one byte to the transmitter (only with dp_bval = '0'), sum it up
+      procedure put(b : std_ulogic_vector(7 downto 0)) is
+      begin
+        dp_byte <= b;
+        dp_bval <= '1';
+        dp_sum  <= dp_sum + unsigned(b);
+      end procedure;
+    begin
+      if rstn_i = '0' then
+        dump_div <= (others => '0');
+        dp_st    <= DP_IDLE;
+        dp_own   <= '0';
+        dp_bval  <= '0';
+        tx_bits  <= 0;
+        txd      <= '1';
+
+      elsif rising_edge(clk_i) then
+        reg_idx := to_integer(unsigned(bus_req_i.addr(15 downto 2)));
+        wr := (accept = '1') and (bus_req_i.rw = '1') and (bus_req_i.ben = "1111");
+        if wr and (reg_idx = REG_DUMP_DIV) then
+          dump_div <= unsigned(bus_req_i.data(15 downto 0));
         end if;
 
-        if to_integer(i_u) >= ncnt then
-          busy <= '0';
-          done <= '1';
-          fsm  <= IDLE;
-        else
-          idx_i := to_integer(i_u);
+        case dp_st is
+          when DP_IDLE =>
+            if wr and (reg_idx = REG_DUMP) and (bus_req_i.data(8) = '1') and (dump_div /= 0) then
+              dp_fid <= bus_req_i.data(7 downto 0);
+              if MOVE then
+                dp_edges <= bus_req_i.data(9);
+              else
+                dp_edges <= '0';
+              end if;
+              dp_act   <= act and ACT_VALID;
+              dp_ctx   <= ctx_sel;
+              dp_nodes <= 0;
+              dp_pairs <= 0;
+              dp_ovf   <= '0';
+              dp_nch   <= 0;
+              dp_cmod  <= 0;
+              dp_row   <= 0;
+              dp_w     <= 0;
+              dp_bits  <= (others => '0');
+              dp_pr    <= 0;
+              dp_tick  <= (others => '0');
+              dp_gbits <= 0;
+              dp_st    <= DP_COUNT;
+            end if;
 
-          if idx_i < 32 then
-            active_bit := act_lo(idx_i);
-          else
-            active_bit := act_hi(idx_i-32);
-          end if;
+          -- node records: active nodes of the latched mask, one word per clock
+          when DP_COUNT =>
+            n := dp_nodes;
+            for w in 0 to ACT_WORDS-1 loop
+              if w = dp_w then
+                n := dp_nodes + popcount(dp_act(32*w+31 downto 32*w));
+              end if;
+            end loop;
+            if dp_w = ACT_WORDS-1 then
+              if n > DP_NODES then
+                n := DP_NODES;
+              end if;
+              dp_w <= 0;
+              if dp_edges = '1' then
+                dp_st <= DP_COLLECT;
+              else
+                dp_st <= DP_GUARD;
+              end if;
+            else
+              dp_w <= dp_w + 1;
+            end if;
+            dp_nodes <= n;
+
+          -- i < j pairs of adj_mem into pair_mem: NEXT-style word / bit walk per row
+          when DP_COLLECT =>
+            if MOVE then
+              if dp_bits /= x"00000000" then
+                n := dp_wc * 32 + find_first_set(dp_bits);
+                dp_bits <= dp_bits and std_ulogic_vector(unsigned(dp_bits) - 1); -- lowest bit off
+                if dp_pairs < DP_PAIRS then
+                  pair_mem(dp_pairs) <= std_ulogic_vector(to_unsigned(dp_row, 8)) & std_ulogic_vector(to_unsigned(n, 8));
+                  dp_pairs <= dp_pairs + 1;
+                  if dp_cmod = 0 then
+                    dp_nch <= dp_nch + 1;
+                  end if;
+                  if dp_cmod = DP_CHUNK-1 then
+                    dp_cmod <= 0;
+                  else
+                    dp_cmod <= dp_cmod + 1;
+                  end if;
+                else
+                  dp_ovf <= '1';
+                end if;
+              elsif dp_w = ACT_WORDS then
+                dp_w <= 0;
+                if dp_row = MAXNODES-1 then
+                  dp_st <= DP_GUARD;
+                else
+                  dp_row <= dp_row + 1;
+                end if;
+              else
+                for w in 0 to ACT_WORDS-1 loop
+                  if w = dp_w then
+                    dp_bits <= adj_mem((dp_ctx * MAXNODES + dp_row) * ACT_WORDS + w) and
+                               upper_mask(dp_row, w) and ACT_VALID(32*w+31 downto 32*w);
+                  end if;
+                end loop;
+                dp_wc <= dp_w;
+                dp_w  <= dp_w + 1;
+              end if;
+            end if;
+
+          -- UART0 is held (CTS): take the line after 11 idle bit times
+          when DP_GUARD =>
+            if uart_txd_i = '0' then
+              dp_tick  <= (others => '0');
+              dp_gbits <= 0;
+            elsif dp_tick >= dump_div - 1 then
+              dp_tick <= (others => '0');
+              if dp_gbits = 10 then
+                dp_own     <= '1';
+                dp_edge_fr <= '0';
+                dp_st      <= DP_FRAME;
+              else
+                dp_gbits <= dp_gbits + 1;
+              end if;
+            else
+              dp_tick <= dp_tick + 1;
+            end if;
+
+          -- FF FF CMD LEN + payload header of the next frame into dp_buf
+          when DP_FRAME =>
+            dp_buf(0) <= x"FF";
+            dp_buf(1) <= x"FF";
+            dp_buf(4) <= dp_fid;
+            dp_bi     <= 0;
+            dp_w      <= 0;
+            dp_bits   <= (others => '0');
+            if dp_edge_fr = '0' then
+              dp_buf(2) <= x"10"; -- CMD_GNG_NODES [fid][n] n * [id][x lo][x hi][y lo][y hi]
+              dp_buf(3) <= std_ulogic_vector(to_unsigned(2 + 5*dp_nodes, 8));
+              dp_buf(5) <= std_ulogic_vector(to_unsigned(dp_nodes, 8));
+              dp_bn     <= 6;
+              dp_cnt    <= dp_nodes;
+            elsif dp_pairs <= DP_SINGLE then
+              dp_buf(2) <= x"11"; -- CMD_GNG_EDGES [fid][n] n * [a][b]
+              dp_buf(3) <= std_ulogic_vector(to_unsigned(2 + 2*dp_pairs, 8));
+              dp_buf(5) <= std_ulogic_vector(to_unsigned(dp_pairs, 8));
+              dp_bn     <= 6;
+              dp_cnt    <= dp_pairs;
+            else
+              n := dp_pairs - dp_pr;
+              if n > DP_CHUNK then
+                n := DP_CHUNK;
+              end if;
+              dp_buf(2)  <= x"14"; -- CMD_GNG_EDGES_CHUNK [fid][flags][chunk][n_chunks][total lo][total hi][n]
+              dp_buf(3)  <= std_ulogic_vector(to_unsigned(7 + 2*n, 8));
+              dp_buf(5)  <= x"00"; -- 8-bit ids
+              dp_buf(6)  <= std_ulogic_vector(to_unsigned(dp_chunk, 8));
+              dp_buf(7)  <= std_ulogic_vector(to_unsigned(dp_nch, 8));
+              dp_buf(8)  <= std_ulogic_vector(to_unsigned(dp_pairs mod 256, 8));
+              dp_buf(9)  <= std_ulogic_vector(to_unsigned(dp_pairs / 256, 8));
+              dp_buf(10) <= std_ulogic_vector(to_unsigned(n, 8));
+              dp_bn      <= 11;
+              dp_cnt     <= n;
+            end if;
+            dp_st <= DP_HDR;
+
+          when DP_HDR =>
+            if dp_bval = '0' then
+              put(dp_buf(dp_bi));
+              if dp_bi < 2 then
+                dp_sum <= (others => '0'); -- CHK = ~(CMD + LEN + payload)
+              end if;
+              if dp_bi = dp_bn - 1 then
+                dp_st <= DP_NEXT;
+              else
+                dp_bi <= dp_bi + 1;
+              end if;
+            end if;
+
+          -- next record: a node of the latched mask or the next pair_mem entry
+          when DP_NEXT =>
+            if dp_cnt = 0 then
+              dp_st <= DP_CHK;
+            elsif dp_edge_fr = '1' then
+              dp_st <= DP_READ;
+            elsif dp_bits /= x"00000000" then
+              dp_id   <= dp_wc * 32 + find_first_set(dp_bits);
+              dp_bits <= dp_bits and std_ulogic_vector(unsigned(dp_bits) - 1);
+              dp_st   <= DP_READ;
+            elsif dp_w = ACT_WORDS then
+              dp_st <= DP_CHK; -- not reached, dp_cnt comes from dp_act
+            else
+              for w in 0 to ACT_WORDS-1 loop
+                if w = dp_w then
+                  dp_bits <= dp_act(32*w+31 downto 32*w);
+                end if;
+              end loop;
+              dp_wc <= dp_w;
+              dp_w  <= dp_w + 1;
+            end if;
+
+          when DP_READ =>
+            if dp_edge_fr = '1' then
+              dp_q(15 downto 0) <= pair_mem(dp_pr);
+              dp_pr <= dp_pr + 1;
+            else
+              dp_q <= node_mem(dp_id mod LANES)((dp_ctx * ROWS + dp_id / LANES) * WS);
+            end if;
+            dp_st <= DP_CONV;
+
+          when DP_CONV =>
+            dp_bi <= 0;
+            if dp_edge_fr = '1' then
+              dp_buf(0) <= dp_q(15 downto 8);
+              dp_buf(1) <= dp_q(7 downto 0);
+              dp_bn     <= 2;
+            else
+              wx := q15_to_wire(dp_q(15 downto 0));
+              wy := q15_to_wire(dp_q(31 downto 16));
+              dp_buf(0) <= std_ulogic_vector(to_unsigned(dp_id, 8));
+              dp_buf(1) <= wx(7 downto 0);
+              dp_buf(2) <= wx(15 downto 8);
+              dp_buf(3) <= wy(7 downto 0);
+              dp_buf(4) <= wy(15 downto 8);
+              dp_bn     <= 5;
+            end if;
+            dp_st <= DP_REC;
+
+          when DP_REC =>
+            if dp_bval = '0' then
+              put(dp_buf(dp_bi));
+              if dp_bi = dp_bn - 1 then
+                dp_cnt <= dp_cnt - 1;
+                dp_st  <= DP_NEXT;
+              else
+                dp_bi <= dp_bi + 1;
+              end if;
+            end if;
 
-          if active_bit = '1' then
-            xi_u := unsigned(node_mem(idx_i)(15 downto 0));
-            yi_u := unsigned(node_mem(idx_i)(31 downto 16));
-
-            dx18 := resize(signed(std_ulogic_vector(xin_q15)), 18) -
-                    resize(signed(std_ulogic_vector(xi_u   )), 18);
-            dy18 := resize(signed(std_ulogic_vector(yin_q15)), 18) -
-                    resize(signed(std_ulogic_vector(yi_u   )), 18);
-
-            dx2_36 := unsigned(dx18 * dx18);
-            dy2_36 := unsigned(dy18 * dy18);
-
-            -- Q2.30 (no shift): (Q1.15)^2 => Q2.30
-            dist_u := resize(dx2_36, 32) + resize(dy2_36, 32);
-
-            if dist_u < out_min1 then
-              out_min2 <= out_min1;
-              out_s2   <= out_s1;
-              out_min1 <= dist_u;
-              out_s1   <= to_unsigned(idx_i, 8);
-            elsif dist_u < out_min2 then
-              out_min2 <= dist_u;
-              out_s2   <= to_unsigned(idx_i, 8);
+          when DP_CHK =>
+            if dp_bval = '0' then
+              put(std_ulogic_vector(not dp_sum));
+              if (dp_edge_fr = '0') and (dp_edges = '1') then
+                dp_edge_fr <= '1';
+                dp_chunk   <= 0;
+                dp_st      <= DP_FRAME;
+              elsif (dp_edge_fr = '1') and (dp_pr < dp_pairs) then
+                dp_chunk <= dp_chunk + 1;
+                dp_st    <= DP_FRAME;
+              else
+                dp_st <= DP_DRAIN;
+              end if;
             end if;
+
+          -- last stop bit out: the line goes back to UART0, CTS drops
+          when DP_DRAIN =>
+            if (dp_bval = '0') and (tx_bits = 0) then
+              dp_own <= '0';
+              dp_st  <= DP_IDLE;
+            end if;
+        end case;
+
+        -- 8N1 transmitter, dump_div clocks per bit
+        if tx_bits = 0 then
+          if dp_bval = '1' then
+            tx_sreg <= '1' & dp_byte & '0'; -- stop & data & start
+            tx_bits <= 10;
+            tx_tick <= (others => '0');
+            dp_bval <= '0';
           end if;
+        elsif tx_tick >= dump_div - 1 then
+          tx_tick <= (others => '0');
+          tx_sreg <= '1' & tx_sreg(9 downto 1);
+          tx_bits <= tx_bits - 1;
+        else
+          tx_tick <= tx_tick + 1;
+        end if;
 
-          i_u <= i_u + 1;
+        if dp_own = '0' then
+          txd <= uart_txd_i;
+        elsif tx_bits = 0 then
+          txd <= '1';
+        else
+          txd <= tx_sreg(0);
         end if;
       end if;
+    end process;
+  end generate;
 
-    end if;
-  end process;
+  dump_off:
+  if not DUMP generate
+    uart_txd_o  <= uart_txd_i;
+    uart_ctsn_o <= '0';
+    dump_stat   <= (others => '0');
+    dump_div    <= (others => '0');
+  end generate;
 
   -- ==========================================================
   -- Bus (1-cycle response), NO blocking-read
@@ -184,86 +981,227 @@ begin
   bus_access: process(clk_i, rstn_i)
     variable reg_idx : natural;
     variable di      : natural;
-
-    constant C_LAMBDA : std_ulogic_vector(31 downto 0) := std_ulogic_vector(to_unsigned(100,32));
-    constant C_A_MAX  : std_ulogic_vector(31 downto 0) := std_ulogic_vector(to_unsigned(50,32));
+    variable ni      : natural;
+    variable mv_q    : std_ulogic_vector(31 downto 0);
   begin
     if rstn_i = '0' then
       bus_rsp_o <= rsp_terminate_c;
-      req_valid <= '0';
-      req_rw    <= '0';
-      req_ben   <= (others => '0');
-      req_idx_u <= (others => '0');
-      stb_prev    <= '0';
-      start_pulse <= '0';
-      clear_pulse <= '0';
+      start_t     <= '0';
+      clear_t     <= '0';
+      flush_t     <= '0';
+      armed       <= '0';
+      bdone       <= '0';
+      bdone_seen  <= '0';
+      flushing    <= '0';
+      irq_en      <= '0';
+      sleep       <= '0';
+      batch_en    <= '0';
+      res_rp      <= (others => '0');
+      smp_wp_g    <= (others => '0');
+      res_rp_g    <= (others => '0');
+      par_regs    <= PAR_RESET;
+      ctx_sel     <= 0;
+      vec_wb      <= 1;
+      vec_rb      <= 0;
+      vec_new     <= '0';
+      mv_st       <= MV_IDLE;
 
     elsif rising_edge(clk_i) then
-      stb_prev <= bus_req_i.stb;
-
       bus_rsp_o.ack  <= '0';
       bus_rsp_o.err  <= '0';
       bus_rsp_o.data <= (others => '0');
 
-      start_pulse <= '0';
-      clear_pulse <= '0';
+      smp_wp_g <= bin2gray(smp_wp);
+      res_rp_g <= bin2gray(res_rp);
 
-      if accept = '1' then
-        req_valid <= '1';
-        req_rw    <= bus_req_i.rw;
-        req_ben   <= bus_req_i.ben;
-        req_idx_u <= unsigned(bus_req_i.addr(15 downto 2));
+      if b_bdone_t /= bdone_seen then
+        bdone_seen <= b_bdone_t;
+        bdone      <= '1';
+      end if;
 
+      -- FLUSH done on the engine side: drop the unread results
+      if (flushing = '1') and (b_flush_ack = flush_t) then
+        flushing <= '0';
+        res_rp   <= gray2bin(b_res_wp_g);
+      end if;
+
+      -- move unit (see Move unit); the firmware leaves the node and neighbor
+      -- windows alone from START to DONE
+      if MOVE then
+        case mv_st is
+          when MV_WAIT =>
+            if b_ack = start_t then
+              if (out_min2 = x"FFFFFFFF") or (to_integer(out_s1) >= MAXNODES) then
+                mv_st <= MV_IDLE; -- no s1 / s2 pair, nothing to move
+              else
+                mv_s1   <= to_integer(out_s1);
+                mv_id   <= to_integer(out_s1);
+                mv_eps  <= unsigned(par_regs(REG_EPS_B)(16 downto 0));
+                mv_w    <= 0;
+                mv_bits <= (others => '0');
+                mv_st   <= MV_LOAD;
+              end if;
+            end if;
+          when MV_LOAD =>
+            mv_p  <= node_mem(mv_id mod LANES)(ctx_sel * ROWS + mv_id / LANES);
+            mv_st <= MV_STORE;
+          when MV_STORE =>
+            mv_q := lerp_q15(mv_p(31 downto 16), std_ulogic_vector(yin_run), mv_eps) &
+                    lerp_q15(mv_p(15 downto 0), std_ulogic_vector(xin_run), mv_eps);
+            node_mem(mv_id mod LANES)(ctx_sel * ROWS + mv_id / LANES) <= mv_q;
+            if COARSE > 0 then
+              coarse_mem(mv_id mod CLANES)(ctx_sel * CROWS + mv_id / CLANES) <= mv_q(31 downto 24) & mv_q(15 downto 8);
+            end if;
+            mv_eps <= unsigned(par_regs(REG_EPS_N)(16 downto 0));
+            mv_st  <= MV_NEXT;
+          when MV_NEXT =>
+            if mv_bits /= x"00000000" then
+              ni := mv_wc * 32 + find_first_set(mv_bits);
+              mv_bits <= mv_bits and std_ulogic_vector(unsigned(mv_bits) - 1); -- lowest bit off
+              if ni < MAXNODES then
+                mv_id <= ni;
+                mv_st <= MV_LOAD;
+              end if;
+            elsif mv_w = ACT_WORDS then
+              mv_st <= MV_IDLE;
+            else
+              for w in 0 to ACT_WORDS-1 loop
+                if w = mv_w then
+                  mv_bits <= adj_mem((ctx_sel * MAXNODES + mv_s1) * ACT_WORDS + w) and act(32*w+31 downto 32*w);
+                end if;
+              end loop;
+              mv_wc <= mv_w;
+              mv_w  <= mv_w + 1;
+            end if;
+          when others =>
+            null;
+        end case;
+      end if;
+
+      if accept = '1' then
+        bus_rsp_o.ack <= '1';
         reg_idx := to_integer(unsigned(bus_req_i.addr(15 downto 2)));
 
         if (bus_req_i.rw = '1') and (bus_req_i.ben = "1111") then
           if reg_idx = REG_CTRL then
-            if bus_req_i.data(0) = '1' then clear_pulse <= '1'; end if;
-            if bus_req_i.data(1) = '1' then start_pulse <= '1'; end if;
+            if bus_req_i.data(0) = '1' then
+              clear_t <= not clear_t;
+              armed   <= '0';
+              bdone   <= '0';
+            end if;
+            if bus_req_i.data(1) = '1' then
+              start_t <= not start_t;
+              armed   <= '1';
+              bdone   <= '0';
+              -- latch the staged sample for this search
+              xin_run <= xin_q15;
+              yin_run <= yin_q15;
+              if vec_new = '1' then
+                vec_rb  <= vec_wb;
+                vec_wb  <= vec_rb;
+                vec_new <= '0';
+              end if;
+              if MOVE and (bus_req_i.data(6) = '1') and (bus_req_i.data(3) = '0') then
+                mv_st <= MV_WAIT;
+              end if;
+            end if;
+            irq_en <= bus_req_i.data(2); -- sticky config bit, rewritten on every CTRL write
+            batch_en <= bus_req_i.data(3); -- sticky: scan SMP_PUSH FIFO back-to-back
+            sleep    <= bus_req_i.data(5); -- sticky: gate the engine clock until the next CTRL write
+            if (bus_req_i.data(4) = '1') and (flushing = '0') then
+              flush_t  <= not flush_t;
+              flushing <= '1';
+            end if;
 
           elsif reg_idx = REG_XIN then
             xin_q15 <= unsigned(bus_req_i.data(15 downto 0));
           elsif reg_idx = REG_YIN then
             yin_q15 <= unsigned(bus_req_i.data(15 downto 0));
           elsif reg_idx = REG_NODE_COUNT then
-            node_count_u8 <= unsigned(bus_req_i.data(7 downto 0));
-          elsif reg_idx = REG_ACT_LO then
-            act_lo <= bus_req_i.data;
-          elsif reg_idx = REG_ACT_HI then
-            act_hi <= bus_req_i.data(7 downto 0);
+            node_count_u <= unsigned(bus_req_i.data(8 downto 0));
+          elsif (reg_idx >= REG_LAMBDA) and (reg_idx <= REG_D) then
+            par_regs(reg_idx) <= bus_req_i.data;
+          elsif reg_idx = REG_CTX then
+            if to_integer(unsigned(bus_req_i.data(2 downto 0))) < CTX then
+              ctx_sel <= to_integer(unsigned(bus_req_i.data(2 downto 0)));
+            end if;
 
-          elsif (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + MAXNODES) then
+          elsif (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + MAXNODES*WS) then
             di := reg_idx - NODE_BASE;
-            node_mem(di) <= bus_req_i.data;
+            ni := di / WS;
+            node_mem(ni mod LANES)((ctx_sel * ROWS + ni / LANES) * WS + di mod WS) <= bus_req_i.data;
+            if COARSE > 0 then
+              coarse_mem(ni mod CLANES)((ctx_sel * CROWS + ni / CLANES) * WS + di mod WS) <=
+                bus_req_i.data(31 downto 24) & bus_req_i.data(15 downto 8);
+            end if;
+          elsif (reg_idx > VEC_BASE) and (reg_idx < VEC_BASE + WORDS) then
+            vec_mem(vec_wb * WS + reg_idx - VEC_BASE) <= bus_req_i.data;
+            vec_new <= '1';
+          elsif MOVE and (reg_idx >= ADJ_BASE) and (reg_idx < ADJ_BASE + MAXNODES*ADJ_WS) then
+            di := reg_idx - ADJ_BASE;
+            if di mod ADJ_WS < ACT_WORDS then
+              adj_mem((ctx_sel * MAXNODES + di / ADJ_WS) * ACT_WORDS + di mod ADJ_WS) <= bus_req_i.data;
+            end if;
           end if;
-        end if;
-      end if;
 
-      if req_valid = '1' then
-        req_valid     <= '0';
-        bus_rsp_o.ack <= '1';
-        reg_idx := to_integer(req_idx_u);
+          -- active mask: ACT_BASE+w, with ACT_LO / ACT_HI aliasing words 0 / 1
+          for w in 0 to ACT_WORDS-1 loop
+            if (reg_idx = REG_ACT_BASE + w) or
+               ((w = 0) and (reg_idx = REG_ACT_LO)) or ((w = 1) and (reg_idx = REG_ACT_HI)) then
+              act(32*w+31 downto 32*w) <= bus_req_i.data;
+            end if;
+          end loop;
+        end if;
 
-        if req_rw = '0' then
+        if bus_req_i.rw = '0' then
           if reg_idx = REG_CTRL then
             bus_rsp_o.data(16) <= busy;
             bus_rsp_o.data(17) <= done;
+            bus_rsp_o.data(18) <= irq_en;
+            bus_rsp_o.data(19) <= batch_en;
+            bus_rsp_o.data(20) <= sleep;
 
-          elsif reg_idx = REG_LAMBDA then
-            bus_rsp_o.data <= C_LAMBDA;
-          elsif reg_idx = REG_A_MAX then
-            bus_rsp_o.data <= C_A_MAX;
+          elsif (reg_idx >= REG_LAMBDA) and (reg_idx <= REG_D) then
+            bus_rsp_o.data <= par_regs(reg_idx);
 
           elsif reg_idx = REG_XIN then
             bus_rsp_o.data(15 downto 0) <= std_ulogic_vector(xin_q15);
           elsif reg_idx = REG_YIN then
             bus_rsp_o.data(15 downto 0) <= std_ulogic_vector(yin_q15);
           elsif reg_idx = REG_NODE_COUNT then
-            bus_rsp_o.data(7 downto 0) <= std_ulogic_vector(node_count_u8);
-          elsif reg_idx = REG_ACT_LO then
-            bus_rsp_o.data <= act_lo;
-          elsif reg_idx = REG_ACT_HI then
-            bus_rsp_o.data(7 downto 0) <= act_hi;
+            bus_rsp_o.data(8 downto 0) <= std_ulogic_vector(node_count_u);
+          elsif reg_idx = REG_INFO then
+            bus_rsp_o.data(15 downto 0)  <= std_ulogic_vector(to_unsigned(MAXNODES, 16));
+            bus_rsp_o.data(23 downto 16) <= std_ulogic_vector(to_unsigned(LANES, 8));
+            if CLK_ASYNC then
+              bus_rsp_o.data(24) <= '1';
+            end if;
+            bus_rsp_o.data(25) <= '1'; -- input double buffer
+            bus_rsp_o.data(26) <= '1'; -- perf counters
+            if COARSE > 0 then
+              bus_rsp_o.data(27) <= '1';
+            end if;
+            bus_rsp_o.data(31 downto 28) <= std_ulogic_vector(to_unsigned(CTX, 4));
+          elsif reg_idx = REG_CTX then
+            bus_rsp_o.data(2 downto 0) <= std_ulogic_vector(to_unsigned(ctx_sel, 3));
+          elsif reg_idx = REG_DIM then
+            bus_rsp_o.data(7 downto 0)  <= std_ulogic_vector(to_unsigned(DIM, 8));
+            bus_rsp_o.data(15 downto 8) <= std_ulogic_vector(to_unsigned(COARSE, 8));
+            if MOVE then
+              bus_rsp_o.data(16) <= '1';
+            end if;
+            if DUMP then
+              bus_rsp_o.data(17) <= '1';
+            end if;
+          elsif reg_idx = REG_DUMP then
+            bus_rsp_o.data <= dump_stat;
+          elsif reg_idx = REG_DUMP_DIV then
+            bus_rsp_o.data(15 downto 0) <= std_ulogic_vector(dump_div);
+          elsif reg_idx = REG_PERF_CTRL then
+            bus_rsp_o.data(1)           <= perf_freeze;
+            bus_rsp_o.data(15 downto 8) <= std_ulogic_vector(to_unsigned(PERF_N, 8));
+          elsif (reg_idx >= REG_PERF_BASE) and (reg_idx < REG_PERF_BASE + PERF_N) then
+            bus_rsp_o.data <= std_ulogic_vector(perf(reg_idx - REG_PERF_BASE));
 
           elsif reg_idx = REG_OUT_S12 then
             bus_rsp_o.data(7 downto 0)  <= std_ulogic_vector(out_s1);
@@ -273,10 +1211,41 @@ begin
           elsif reg_idx = REG_OUT_MIN2 then
             bus_rsp_o.data <= std_ulogic_vector(out_min2);
 
-          elsif (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + MAXNODES) then
+          elsif reg_idx = REG_BATCH then
+            bus_rsp_o.data(5 downto 0)  <= std_ulogic_vector(smp_level);
+            bus_rsp_o.data(13 downto 8) <= std_ulogic_vector(res_level);
+          elsif reg_idx = REG_RES_S12 then
+            bus_rsp_o.data(15 downto 0) <= res_head(47 downto 32);
+          elsif reg_idx = REG_RES_MIN1 then
+            bus_rsp_o.data <= res_head(31 downto 0);
+            if (res_level /= 0) and (flushing = '0') then
+              res_rp <= res_rp + 1;
+            end if;
+
+          elsif (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + MAXNODES*WS) then
             di := reg_idx - NODE_BASE;
-            bus_rsp_o.data <= node_mem(di);
+            ni := di / WS;
+            bus_rsp_o.data <= node_mem(ni mod LANES)((ctx_sel * ROWS + ni / LANES) * WS + di mod WS);
+          elsif (reg_idx > VEC_BASE) and (reg_idx < VEC_BASE + WORDS) then
+            -- what the next START scans: the staging bank once written
+            if vec_new = '1' then
+              bus_rsp_o.data <= vec_mem(vec_wb * WS + reg_idx - VEC_BASE);
+            else
+              bus_rsp_o.data <= vec_mem(vec_rb * WS + reg_idx - VEC_BASE);
+            end if;
+          elsif MOVE and (reg_idx >= ADJ_BASE) and (reg_idx < ADJ_BASE + MAXNODES*ADJ_WS) then
+            di := reg_idx - ADJ_BASE;
+            if di mod ADJ_WS < ACT_WORDS then
+              bus_rsp_o.data <= adj_mem((ctx_sel * MAXNODES + di / ADJ_WS) * ACT_WORDS + di mod ADJ_WS);
+            end if;
           end if;
+
+          for w in 0 to ACT_WORDS-1 loop
+            if (reg_idx = REG_ACT_BASE + w) or
+               ((w = 0) and (reg_idx = REG_ACT_LO)) or ((w = 1) and (reg_idx = REG_ACT_HI)) then
+              bus_rsp_o.data <= act(32*w+31 downto 32*w);
+            end if;
+          end loop;
         end if;
       end if;
 
@@ -0,0 +1,663 @@
+-- ================================================================================
+-- NEORV32 CFS winner engine (instantiated by neorv32_cfs)
+-- - Runs on its own clock: clk_i of the SoC, or the CFS PLL clock when
+--   neorv32_cfs CLK_ASYNC = true (all control inputs then arrive synchronized)
+-- - Distance pipeline, one lane group word per clock:
+--     E0 issue  : find-first-set on scan_mask, pick the lane group, then
+--                 its WORDS words one after the other
+--     E1 read   : node_mem row word (async read in neorv32_cfs), dx/dy 18-bit
+--     E2 square : dx^2, dy^2 (36-bit, DSP output register)
+--     E3 sum    : (dx^2 + dy^2) >> DSHIFT summed over the words in Q2.30,
+--                 leaf pairs after the last word
+--     E4 tree   : log2(LANES) merge levels of the lane group
+--     E5 merge  : running min1/min2 (lower indices) vs lane group
+--   Groups leave E5 in issue order, so s1/s2 and ties are those of the
+--   old single-cycle scan; a search takes (active groups * WORDS + 5)
+--   clocks. WORDS = 1 (2D) is the plain dx^2 + dy^2 of one word
+-- - Words w >= 1 of the sample come from vin_rd_i (VEC, quasi-static);
+--   batch FIFO samples are word 0 only
+-- - Control: START / CLEAR / FLUSH are toggles, ack_o echoes the START
+--   toggle of the finished (or cleared) search
+-- - Batch FIFO read pointer and result ring write pointer are exported
+--   Gray coded; res_mem lives here (written on this clock, read async)
+-- - COARSE = true: a coarse pass over CLANES nodes per clock runs first,
+--   on the top bytes of the Q1.15 components (coarse_rd_i, 8 x 8 bit
+--   LUT multipliers, no DSP):
+--     C0 issue  : like E0 on the coarse rows (CLANES nodes, own mask)
+--     C1 diff   : a = |x >> 8 - nx >> 8| per component (0..255)
+--     C2 square : lo = (a-1)^2, hi = (a+1)^2 = lo + 4a (a = 0: 0 / 1),
+--                 so lo << 16 <= dx^2 <= hi << 16
+--     C3 sum    : lo / hi summed over the components and words
+--     C4 tree   : two smallest hi of the group
+--     C5 mark   : running hi2 (second smallest hi so far); a node whose
+--                 lo <= hi2 is a refine candidate
+--   hi2 bounds the exact second smallest distance from above and a node
+--   left out has an exact distance >= its lo > hi2 (the per-word >> DSHIFT
+--   keeps both sides 2^(16-DSHIFT) multiples of the coarse sums), so it can
+--   be neither s1 nor s2. The E0..E5 scan then runs over the candidates
+--   only and gives the s1/s2/min1/min2 (ties included) of the full scan in
+--   (coarse groups + candidate groups) * WORDS + 10 clocks
+-- ================================================================================
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+entity neorv32_cfs_engine is
+  generic (
+    LANES     : natural := 4;
+    MAXNODES  : natural := 40;
+    ROWS      : natural := 10;
+    ACT_WORDS : natural := 2;
+    SMP_DEPTH : natural := 32;
+    WORDS     : natural := 1;   -- node / sample words (Q1.15 pairs)
+    DSHIFT    : natural := 0;   -- per-word sum >> DSHIFT (log2 of the node stride)
+    COARSE    : boolean := false; -- coarse pass before the exact scan
+    CLANES    : natural := 1;   -- coarse lanes (nodes per coarse row)
+    CROWS     : natural := 1    -- coarse rows
+  );
+  port (
+    clk_i       : in  std_ulogic;
+    rstn_i      : in  std_ulogic;
+    -- configuration, written by the CPU while the engine is idle
+    act_i       : in  std_ulogic_vector(ACT_WORDS*32-1 downto 0);
+    ncnt_i      : in  unsigned(8 downto 0);
+    xin_i       : in  unsigned(15 downto 0);
+    yin_i       : in  unsigned(15 downto 0);
+    -- node_mem read port (one row = one lane group) and sample word of node_word_o
+    node_row_o  : out natural range 0 to ROWS-1;
+    node_word_o : out natural range 0 to WORDS-1;
+    node_rd_i   : in  std_ulogic_vector(LANES*32-1 downto 0);
+    vin_rd_i    : in  std_ulogic_vector(31 downto 0);
+    -- coarse_mem read port (COARSE): top bytes x(15..8) | y(15..8) << 8 per node
+    crow_o      : out natural range 0 to CROWS-1;
+    coarse_rd_i : in  std_ulogic_vector(CLANES*16-1 downto 0);
+    -- control (toggles / level, synchronized to clk_i)
+    start_t_i   : in  std_ulogic;
+    clear_t_i   : in  std_ulogic;
+    flush_t_i   : in  std_ulogic;
+    batch_en_i  : in  std_ulogic;
+    ack_o       : out std_ulogic;
+    bdone_t_o   : out std_ulogic;
+    flush_ack_o : out std_ulogic;
+    busy_o      : out std_ulogic;
+    -- batch sample FIFO (storage in neorv32_cfs)
+    smp_wp_g_i  : in  std_ulogic_vector(5 downto 0);
+    smp_rp_g_o  : out std_ulogic_vector(5 downto 0);
+    smp_raddr_o : out unsigned(4 downto 0);
+    smp_rdata_i : in  std_ulogic_vector(31 downto 0);
+    -- result ring
+    res_rp_g_i  : in  std_ulogic_vector(5 downto 0);
+    res_wp_g_o  : out std_ulogic_vector(5 downto 0);
+    res_raddr_i : in  unsigned(4 downto 0);
+    res_rdata_o : out std_ulogic_vector(47 downto 0);
+    -- last result, stable while ack_o = START toggle
+    out_s1_o    : out unsigned(7 downto 0);
+    out_s2_o    : out unsigned(7 downto 0);
+    out_min1_o  : out unsigned(31 downto 0);
+    out_min2_o  : out unsigned(31 downto 0)
+  );
+end neorv32_cfs_engine;
+
+architecture neorv32_cfs_engine_rtl of neorv32_cfs_engine is
+
+  constant MASK_W  : natural := ROWS * LANES;
+  constant CMASK_W : natural := CROWS * CLANES;
+  constant CW      : natural := 24; -- coarse sums: <= 2 * WORDS * 2^16
+
+  -- min1/min2 candidate pairs for the lane merge tree
+  type cand_t is record
+    d  : unsigned(31 downto 0);
+    id : unsigned(7 downto 0);
+  end record;
+  type pair_t is record
+    m1 : cand_t;
+    m2 : cand_t;
+  end record;
+  type pair_arr_t is array (0 to LANES-1) of pair_t;
+
+  constant CAND_NONE : cand_t := (d => (others => '1'), id => (others => '0'));
+  constant PAIR_NONE : pair_t := (m1 => CAND_NONE, m2 => CAND_NONE);
+
+  function log2_lanes(n : natural) return natural is
+    variable r : natural := 0;
+  begin
+    while (2**r) < n loop
+      r := r + 1;
+    end loop;
+    return r;
+  end function;
+
+  constant LANE_LVLS : natural := log2_lanes(LANES);
+  constant CLANE_LVLS : natural := log2_lanes(CLANES);
+
+  -- two smallest coarse upper bounds (u1 <= u2)
+  type upair_t is record
+    u1 : unsigned(CW-1 downto 0);
+    u2 : unsigned(CW-1 downto 0);
+  end record;
+  constant UPAIR_NONE : upair_t := (u1 => (others => '1'), u2 => (others => '1'));
+  type upair_arr_t is array (0 to CLANES-1) of upair_t;
+
+  function merge_upair(a, b : upair_t) return upair_t is
+    variable r : upair_t;
+  begin
+    if b.u1 < a.u1 then
+      r.u1 := b.u1;
+      if a.u1 <= b.u2 then r.u2 := a.u1; else r.u2 := b.u2; end if;
+    else
+      r.u1 := a.u1;
+      if b.u1 < a.u2 then r.u2 := b.u1; else r.u2 := a.u2; end if;
+    end if;
+    return r;
+  end function;
+
+  -- coarse bounds of one component, a = |dx >> 8| (see the header)
+  function coarse_lo(a : unsigned(7 downto 0)) return unsigned is
+    variable m : unsigned(7 downto 0);
+  begin
+    if a = 0 then
+      return to_unsigned(0, 17);
+    end if;
+    m := a - 1;
+    return resize(m * m, 17);
+  end function;
+
+  function coarse_hi(a : unsigned(7 downto 0)) return unsigned is
+  begin
+    if a = 0 then
+      return to_unsigned(1, 17);
+    end if;
+    return coarse_lo(a) + shift_left(resize(a, 17), 2);
+  end function;
+
+  -- index of the lowest set bit (priority encoder), m'length if none
+  function find_first_set(m : std_ulogic_vector) return natural is
+  begin
+    for i in 0 to m'length-1 loop
+      if m(m'low + i) = '1' then
+        return i;
+      end if;
+    end loop;
+    return m'length;
+  end function;
+
+  -- merge two sorted pairs (m1 <= m2); a holds the lower node indices so ties
+  -- resolve exactly like the sequential 1-node/clock scan
+  function merge_pair(a, b : pair_t) return pair_t is
+    variable r : pair_t;
+  begin
+    if b.m1.d < a.m1.d then
+      r.m1 := b.m1;
+      if a.m1.d <= b.m2.d then r.m2 := a.m1; else r.m2 := b.m2; end if;
+    else
+      r.m1 := a.m1;
+      if b.m1.d < a.m2.d then r.m2 := b.m1; else r.m2 := a.m2; end if;
+    end if;
+    return r;
+  end function;
+
+  function bin2gray(b : unsigned) return std_ulogic_vector is
+  begin
+    return std_ulogic_vector(b xor shift_right(b, 1));
+  end function;
+
+  function gray2bin(g : std_ulogic_vector) return unsigned is
+    variable b : unsigned(g'length-1 downto 0);
+  begin
+    b(b'high) := g(g'high);
+    for i in b'high-1 downto 0 loop
+      b(i) := b(i+1) xor g(g'low + i);
+    end loop;
+    return b;
+  end function;
+
+  type res_mem_t is array (0 to SMP_DEPTH-1) of std_ulogic_vector(47 downto 0);
+  signal res_mem   : res_mem_t;
+  signal res_wp    : unsigned(5 downto 0) := (others => '0');
+  signal smp_rp    : unsigned(5 downto 0) := (others => '0');
+  signal smp_level : unsigned(5 downto 0);
+  signal res_level : unsigned(5 downto 0);
+  signal res_we    : std_ulogic := '0';
+  signal res_wdata : std_ulogic_vector(47 downto 0) := (others => '0');
+
+  signal start_seen : std_ulogic := '0';
+  signal clear_seen : std_ulogic := '0';
+  signal flush_seen : std_ulogic := '0';
+  signal flush_pend : std_ulogic_vector(1 downto 0) := "00";
+  signal ack        : std_ulogic := '0';
+  signal bdone_t    : std_ulogic := '0';
+  signal in_batch   : std_ulogic := '0'; -- current scan came from the FIFO
+
+  type fsm_t is (IDLE, CSCAN, RUN); -- CSCAN = coarse pass (COARSE)
+  signal fsm : fsm_t := IDLE;
+  signal scan_mask : std_ulogic_vector(MASK_W-1 downto 0) := (others => '0'); -- active nodes not yet issued
+
+  -- sample under test, latched at START (XIN/YIN) or from the FIFO (batch)
+  signal scan_x : unsigned(15 downto 0) := (others => '0');
+  signal scan_y : unsigned(15 downto 0) := (others => '0');
+
+  -- pipeline registers (pN_v = stage N holds a lane group)
+  type s18_arr_t is array (0 to LANES-1) of signed(17 downto 0);
+  type u36_arr_t is array (0 to LANES-1) of unsigned(35 downto 0);
+  signal p0_v, p1_v, p2_v, p3_v, p4_v : std_ulogic := '0';
+  signal p0_row  : natural range 0 to ROWS-1 := 0;
+  signal p0_w, p1_w, p2_w : natural range 0 to WORDS-1 := 0;
+  signal p0_base, p1_base, p2_base : natural range 0 to MASK_W-1 := 0;
+  signal p0_lv, p1_lv, p2_lv : std_ulogic_vector(LANES-1 downto 0) := (others => '0');
+  signal p1_dx, p1_dy : s18_arr_t := (others => (others => '0'));
+  signal p2_sx, p2_sy : u36_arr_t := (others => (others => '0'));
+  signal p3_acc  : u36_arr_t := (others => (others => '0')); -- word sums of the group so far
+  signal p3_lane : pair_arr_t := (others => PAIR_NONE);
+  signal p4_best : pair_t := PAIR_NONE;
+
+  -- coarse pass (cN_v = stage N holds a coarse group, word in p0_w at C0)
+  type u8c_arr_t is array (0 to CLANES-1) of unsigned(7 downto 0);
+  type ucw_arr_t is array (0 to CLANES-1) of unsigned(CW-1 downto 0);
+  signal c_mask : std_ulogic_vector(CMASK_W-1 downto 0) := (others => '0'); -- active nodes not yet issued
+  signal c_cand : std_ulogic_vector(MASK_W-1 downto 0) := (others => '0');  -- refine candidates
+  signal c_best : upair_t := UPAIR_NONE;
+  signal c0_v, c1_v, c2_v, c3_v, c4_v : std_ulogic := '0';
+  signal c0_row : natural range 0 to CROWS-1 := 0;
+  signal c1_w, c2_w : natural range 0 to WORDS-1 := 0;
+  signal c0_base, c1_base, c2_base, c3_base, c4_base : natural range 0 to CMASK_W-1 := 0;
+  signal c0_lv, c1_lv, c2_lv, c3_lv, c4_lv : std_ulogic_vector(CLANES-1 downto 0) := (others => '0');
+  signal c1_ax, c1_ay : u8c_arr_t := (others => (others => '0'));
+  signal c2_lo, c2_hi : ucw_arr_t := (others => (others => '0'));
+  signal c3_acc_lo, c3_acc_hi : ucw_arr_t := (others => (others => '0'));
+  signal c3_lo, c3_hi, c4_lo : ucw_arr_t := (others => (others => '0'));
+  signal c4_best : upair_t := UPAIR_NONE;
+
+  -- GowinSynthesis: the 8 x 8 bit coarse squares go to LUTs, the DSPs stay with the lanes
+  attribute syn_dspstyle : string;
+  attribute syn_dspstyle of c2_lo : signal is "logic";
+  attribute syn_dspstyle of c2_hi : signal is "logic";
+
+  signal out_s1   : unsigned(7 downto 0)  := (others => '0');
+  signal out_s2   : unsigned(7 downto 0)  := (others => '0');
+  signal out_min1 : unsigned(31 downto 0) := (others => '1');
+  signal out_min2 : unsigned(31 downto 0) := (others => '1');
+
+begin
+
+  smp_level <= gray2bin(smp_wp_g_i) - smp_rp;
+  res_level <= res_wp - gray2bin(res_rp_g_i);
+
+  smp_raddr_o <= smp_rp(4 downto 0);
+  node_row_o  <= p0_row;
+  node_word_o <= p0_w;
+  crow_o      <= c0_row;
+  res_rdata_o <= res_mem(to_integer(res_raddr_i));
+
+  ack_o       <= ack;
+  bdone_t_o   <= bdone_t;
+  busy_o      <= '1' when fsm /= IDLE else '0';
+  out_s1_o    <= out_s1;
+  out_s2_o    <= out_s2;
+  out_min1_o  <= out_min1;
+  out_min2_o  <= out_min2;
+
+  -- result ring storage (no reset on the array -> distributed RAM)
+  res_ring_wr: process(clk_i)
+  begin
+    if rising_edge(clk_i) then
+      if res_we = '1' then
+        res_mem(to_integer(res_wp(4 downto 0))) <= res_wdata;
+      end if;
+    end if;
+  end process;
+
+  -- ==========================================================
+  -- Issue / control + pipeline (one lane group per clock)
+  -- ==========================================================
+  engine: process(clk_i, rstn_i)
+    variable ncnt   : natural;
+    variable ffs_i  : natural;
+    variable idx_i  : natural;
+    variable mask_v : std_ulogic_vector(MASK_W-1 downto 0);
+    variable cmask_v : std_ulogic_vector(CMASK_W-1 downto 0);
+    variable go     : boolean;
+    variable xi, yi : signed(17 downto 0);
+    variable sx, sy : unsigned(15 downto 0);
+    variable acc_v  : unsigned(35 downto 0);
+    variable lane   : pair_arr_t;
+    variable best   : pair_t;
+    variable sxh, syh : signed(8 downto 0);
+    variable dxh, dyh : signed(8 downto 0);
+    variable clo, chi : unsigned(CW-1 downto 0);
+    variable cl     : upair_arr_t;
+    variable cbest  : upair_t;
+  begin
+    if rstn_i = '0' then
+      fsm        <= IDLE;
+      scan_mask  <= (others => '0');
+      start_seen <= '0';
+      clear_seen <= '0';
+      flush_seen <= '0';
+      flush_pend <= "00";
+      flush_ack_o <= '0';
+      ack        <= '0';
+      bdone_t    <= '0';
+      in_batch   <= '0';
+      smp_rp     <= (others => '0');
+      res_wp     <= (others => '0');
+      smp_rp_g_o <= (others => '0');
+      res_wp_g_o <= (others => '0');
+      res_we     <= '0';
+      p0_v <= '0'; p1_v <= '0'; p2_v <= '0'; p3_v <= '0'; p4_v <= '0';
+      c0_v <= '0'; c1_v <= '0'; c2_v <= '0'; c3_v <= '0'; c4_v <= '0';
+      out_s1     <= (others => '0');
+      out_s2     <= (others => '0');
+      out_min1   <= (others => '1');
+      out_min2   <= (others => '1');
+
+    elsif rising_edge(clk_i) then
+      res_we <= '0';
+      if res_we = '1' then
+        res_wp <= res_wp + 1;
+      end if;
+      smp_rp_g_o <= bin2gray(smp_rp);
+      res_wp_g_o <= bin2gray(res_wp);
+
+      -- FLUSH: drop the queued samples, ack two clocks later (pointers final)
+      flush_pend <= flush_pend(0) & '0';
+      if flush_pend(1) = '1' then
+        flush_ack_o <= flush_seen;
+      end if;
+
+      -- ---------------- C5: running hi2, refine candidates ----------------
+      if c4_v = '1' then
+        cbest := merge_upair(c_best, c4_best);
+        c_best <= cbest;
+        for l in 0 to CLANES-1 loop
+          if (c4_base + l < MAXNODES) and (c4_lv(l) = '1') and (c4_lo(l) <= cbest.u2) then
+            c_cand(c4_base + l) <= '1';
+          end if;
+        end loop;
+      end if;
+
+      -- ---------------- C4: two smallest hi, log2(CLANES) levels ----------------
+      c4_v    <= c3_v;
+      c4_base <= c3_base;
+      c4_lv   <= c3_lv;
+      c4_lo   <= c3_lo;
+      for l in 0 to CLANES-1 loop
+        cl(l) := (u1 => c3_hi(l), u2 => (others => '1'));
+      end loop;
+      for lv in 0 to CLANE_LVLS-1 loop
+        for l in 0 to CLANES-1 loop
+          if (l mod (2**(lv+1))) = 0 then
+            cl(l) := merge_upair(cl(l), cl(l + 2**lv));
+          end if;
+        end loop;
+      end loop;
+      c4_best <= cl(0);
+
+      -- ---------------- C3: lo / hi sums over the words ----------------
+      c3_v <= '0';
+      if c2_v = '1' then
+        for l in 0 to CLANES-1 loop
+          clo := c2_lo(l);
+          chi := c2_hi(l);
+          if c2_w /= 0 then
+            clo := clo + c3_acc_lo(l);
+            chi := chi + c3_acc_hi(l);
+          end if;
+          c3_acc_lo(l) <= clo;
+          c3_acc_hi(l) <= chi;
+          if c2_w = WORDS-1 then
+            if c2_lv(l) = '1' then
+              c3_lo(l) <= clo;
+              c3_hi(l) <= chi;
+            else
+              c3_lo(l) <= (others => '1');
+              c3_hi(l) <= (others => '1');
+            end if;
+          end if;
+        end loop;
+        if c2_w = WORDS-1 then
+          c3_v    <= '1';
+          c3_base <= c2_base;
+          c3_lv   <= c2_lv;
+        end if;
+      end if;
+
+      -- ---------------- C2: coarse squares (LUT) ----------------
+      c2_v    <= c1_v;
+      c2_w    <= c1_w;
+      c2_base <= c1_base;
+      c2_lv   <= c1_lv;
+      for l in 0 to CLANES-1 loop
+        c2_lo(l) <= resize(coarse_lo(c1_ax(l)), CW) + resize(coarse_lo(c1_ay(l)), CW);
+        c2_hi(l) <= resize(coarse_hi(c1_ax(l)), CW) + resize(coarse_hi(c1_ay(l)), CW);
+      end loop;
+
+      -- ---------------- C1: coarse row word read, |differences| of the top bytes ----------------
+      c1_v    <= c0_v;
+      c1_w    <= p0_w;
+      c1_base <= c0_base;
+      c1_lv   <= c0_lv;
+      if p0_w = 0 then
+        sxh := resize(signed(std_ulogic_vector(scan_x(15 downto 8))), 9);
+        syh := resize(signed(std_ulogic_vector(scan_y(15 downto 8))), 9);
+      else
+        sxh := resize(signed(vin_rd_i(15 downto 8)), 9);
+        syh := resize(signed(vin_rd_i(31 downto 24)), 9);
+      end if;
+      for l in 0 to CLANES-1 loop
+        dxh := sxh - resize(signed(coarse_rd_i(16*l+7 downto 16*l)), 9);
+        dyh := syh - resize(signed(coarse_rd_i(16*l+15 downto 16*l+8)), 9);
+        c1_ax(l) <= resize(unsigned(abs(dxh)), 8);
+        c1_ay(l) <= resize(unsigned(abs(dyh)), 8);
+      end loop;
+
+      -- ---------------- E5: running result vs lane group ----------------
+      if p4_v = '1' then
+        best := merge_pair((m1 => (d => out_min1, id => out_s1),
+                            m2 => (d => out_min2, id => out_s2)), p4_best);
+        out_min1 <= best.m1.d;
+        out_s1   <= best.m1.id;
+        out_min2 <= best.m2.d;
+        out_s2   <= best.m2.id;
+      end if;
+
+      -- ---------------- E4: merge tree, log2(LANES) levels ----------------
+      p4_v <= p3_v;
+      lane := p3_lane;
+      for lv in 0 to LANE_LVLS-1 loop
+        for l in 0 to LANES-1 loop
+          if (l mod (2**(lv+1))) = 0 then
+            lane(l) := merge_pair(lane(l), lane(l + 2**lv));
+          end if;
+        end loop;
+      end loop;
+      p4_best <= lane(0);
+
+      -- ---------------- E3: Q2.30 sum (NO >>15) over the words, leaf pairs ----------------
+      p3_v <= '0';
+      if p2_v = '1' then
+        for l in 0 to LANES-1 loop
+          acc_v := shift_right(p2_sx(l) + p2_sy(l), DSHIFT);
+          if p2_w /= 0 then
+            acc_v := acc_v + p3_acc(l);
+          end if;
+          p3_acc(l) <= acc_v;
+          if p2_w = WORDS-1 then
+            p3_lane(l) <= PAIR_NONE;
+            if p2_lv(l) = '1' then
+              p3_lane(l).m1.id <= to_unsigned(p2_base + l, 8);
+              if acc_v(35 downto 32) /= 0 then
+                p3_lane(l).m1.d <= (others => '1'); -- saturate (not reachable for 0 <= x, y < 1)
+              else
+                p3_lane(l).m1.d <= acc_v(31 downto 0);
+              end if;
+            end if;
+          end if;
+        end loop;
+        if p2_w = WORDS-1 then
+          p3_v <= '1';
+        end if;
+      end if;
+
+      -- ---------------- E2: squares ----------------
+      p2_v    <= p1_v;
+      p2_w    <= p1_w;
+      p2_base <= p1_base;
+      p2_lv   <= p1_lv;
+      for l in 0 to LANES-1 loop
+        p2_sx(l) <= unsigned(p1_dx(l) * p1_dx(l));
+        p2_sy(l) <= unsigned(p1_dy(l) * p1_dy(l));
+      end loop;
+
+      -- ---------------- E1: node row word read, differences ----------------
+      p1_v    <= p0_v;
+      p1_w    <= p0_w;
+      p1_base <= p0_base;
+      p1_lv   <= p0_lv;
+      if p0_w = 0 then
+        sx := scan_x;
+        sy := scan_y;
+      else
+        sx := unsigned(vin_rd_i(15 downto 0));
+        sy := unsigned(vin_rd_i(31 downto 16));
+      end if;
+      for l in 0 to LANES-1 loop
+        xi := resize(signed(node_rd_i(32*l+15 downto 32*l)), 18);
+        yi := resize(signed(node_rd_i(32*l+31 downto 32*l+16)), 18);
+        p1_dx(l) <= resize(signed(std_ulogic_vector(sx)), 18) - xi;
+        p1_dy(l) <= resize(signed(std_ulogic_vector(sy)), 18) - yi;
+      end loop;
+
+      -- ---------------- E0: issue the next word / active lane group ----------------
+      p0_v <= '0';
+      if (fsm = RUN) and (p0_v = '1') and (p0_w /= WORDS-1) then
+        p0_v <= '1'; -- same lane group, next word
+        p0_w <= p0_w + 1;
+      elsif fsm = RUN then
+        ffs_i := find_first_set(scan_mask);
+        if ffs_i >= MAXNODES then
+          -- nothing left to issue: done once the pipeline has drained
+          if (p0_v = '0') and (p1_v = '0') and (p2_v = '0') and (p3_v = '0') and (p4_v = '0') then
+            fsm <= IDLE;
+            if in_batch = '1' then
+              res_we    <= '1';
+              res_wdata <= std_ulogic_vector(out_s2) & std_ulogic_vector(out_s1) & std_ulogic_vector(out_min1);
+              bdone_t   <= not bdone_t;
+            else
+              ack <= start_seen;
+            end if;
+          end if;
+        else
+          mask_v := scan_mask;
+          p0_v    <= '1';
+          p0_w    <= 0;
+          p0_row  <= ffs_i / LANES;
+          p0_base <= (ffs_i / LANES) * LANES;
+          for l in 0 to LANES-1 loop
+            idx_i    := (ffs_i / LANES) * LANES + l;
+            p0_lv(l) <= scan_mask(idx_i);
+            mask_v(idx_i) := '0';
+          end loop;
+          scan_mask <= mask_v;
+        end if;
+      end if;
+
+      -- ---------------- C0: issue the next word / active coarse group ----------------
+      c0_v <= '0';
+      if (fsm = CSCAN) and (c0_v = '1') and (p0_w /= WORDS-1) then
+        c0_v <= '1';
+        p0_w <= p0_w + 1;
+      elsif fsm = CSCAN then
+        ffs_i := find_first_set(c_mask);
+        if ffs_i >= MAXNODES then
+          -- coarse pass drained (C5 done): exact scan of the candidates
+          if (c0_v = '0') and (c1_v = '0') and (c2_v = '0') and (c3_v = '0') and (c4_v = '0') then
+            fsm       <= RUN;
+            scan_mask <= c_cand;
+          end if;
+        else
+          cmask_v := c_mask;
+          c0_v    <= '1';
+          p0_w    <= 0;
+          c0_row  <= ffs_i / CLANES;
+          c0_base <= (ffs_i / CLANES) * CLANES;
+          for l in 0 to CLANES-1 loop
+            idx_i    := (ffs_i / CLANES) * CLANES + l;
+            c0_lv(l) <= c_mask(idx_i);
+            cmask_v(idx_i) := '0';
+          end loop;
+          c_mask <= cmask_v;
+        end if;
+      end if;
+
+      -- ---------------- control: CLEAR / FLUSH abort, then START / batch ----------------
+      if clear_t_i /= clear_seen then
+        clear_seen <= clear_t_i;
+        fsm  <= IDLE;
+        ack  <= start_seen;
+        p0_v <= '0'; p1_v <= '0'; p2_v <= '0'; p3_v <= '0'; p4_v <= '0';
+        c0_v <= '0'; c1_v <= '0'; c2_v <= '0'; c3_v <= '0'; c4_v <= '0';
+      end if;
+
+      if flush_t_i /= flush_seen then
+        flush_seen <= flush_t_i;
+        flush_pend <= flush_pend(0) & '1';
+        fsm    <= IDLE;
+        smp_rp <= gray2bin(smp_wp_g_i);
+        p0_v <= '0'; p1_v <= '0'; p2_v <= '0'; p3_v <= '0'; p4_v <= '0';
+        c0_v <= '0'; c1_v <= '0'; c2_v <= '0'; c3_v <= '0'; c4_v <= '0';
+      end if;
+
+      go := start_t_i /= start_seen;
+      if (not go) and (batch_en_i = '1') and (fsm = IDLE) and (res_we = '0') and
+         (flush_t_i = flush_seen) and (flush_pend = "00") and
+         (smp_level /= 0) and (res_level /= SMP_DEPTH) then
+        go := true;
+      end if;
+
+      if go then
+        ncnt := to_integer(ncnt_i);
+        if ncnt > MAXNODES then
+          ncnt := MAXNODES;
+        end if;
+        mask_v  := (others => '0');
+        cmask_v := (others => '0');
+        for i in 0 to MAXNODES-1 loop
+          if i < ncnt then
+            mask_v(i)  := act_i(i);
+            cmask_v(i) := act_i(i);
+          end if;
+        end loop;
+
+        if start_t_i /= start_seen then
+          start_seen <= start_t_i;
+          scan_x   <= xin_i;
+          scan_y   <= yin_i;
+          in_batch <= '0';
+        else
+          scan_x   <= unsigned(smp_rdata_i(15 downto 0));
+          scan_y   <= unsigned(smp_rdata_i(31 downto 16));
+          smp_rp   <= smp_rp + 1;
+          in_batch <= '1';
+        end if;
+
+        if COARSE then
+          fsm       <= CSCAN;
+          scan_mask <= (others => '0');
+          c_mask    <= cmask_v;
+          c_cand    <= (others => '0');
+          c_best    <= UPAIR_NONE;
+        else
+          fsm       <= RUN;
+          scan_mask <= mask_v;
+        end if;
+        p0_v <= '0'; p1_v <= '0'; p2_v <= '0'; p3_v <= '0'; p4_v <= '0';
+        c0_v <= '0'; c1_v <= '0'; c2_v <= '0'; c3_v <= '0'; c4_v <= '0';
+        out_min1  <= (others => '1');
+        out_min2  <= (others => '1');
+        out_s1    <= (others => '0');
+        out_s2    <= (others => '0');
+      end if;
+    end if;
+  end process;
+
+end architecture;
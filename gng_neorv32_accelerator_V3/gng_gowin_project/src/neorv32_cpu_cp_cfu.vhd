@@ -1,8 +1,8 @@
 -- ================================================================================ --
 -- NEORV32 CPU - Co-Processor: Custom (RISC-V Instructions) Functions Unit (CFU)    --
 -- -------------------------------------------------------------------------------- --
--- See the CPU's data sheet for more information. Also take a look at the "software --
--- counterpart" of this CFU example in sw/example/demo_cfu.                         --
+-- See the CPU's data sheet for more information. GNG version: the XTEA example is --
+-- replaced by the step helpers of gng_core/gng_cfu.h (software counterpart).       --
 -- -------------------------------------------------------------------------------- --
 -- The NEORV32 RISC-V Processor - https://github.com/stnolting/neorv32              --
 -- Copyright (c) NEORV32 contributors.                                              --
@@ -36,15 +36,19 @@ entity neorv32_cpu_cp_cfu is
 end neorv32_cpu_cp_cfu;
 
   -- **********************************************************
-  -- CFU Example: XTEA - Extended Tiny Encryption Algorithm
+  -- GNG step helpers (gng_core/gng_cfu.h)
   -- **********************************************************
 
-  -- This CFU example implements the Extended Tiny Encryption Algorithm (XTEA).
-  -- The CFU provides five R-type instructions for encryption and decryption.
-  -- andfour I-type instruction are used for reading/writing the XTEA key registers.
-
-  -- The RTL code was implemented according to an open-source C reference:
-  -- https://de.wikipedia.org/wiki/Extended_Tiny_Encryption_Algorithm
+  -- R-type (custom-0, funct7 = 0), result in the same cycle:
+  --   000 DIST2 : (dx^2 + dy^2) mod 2^32 of two packed Q1.15 words x | y << 16 (signed halves)
+  --   001 LERP  : p + ((eps * (t - p) + 32768) >> 16) on int32 (Q16.16), rs1 = p, rs2 = t,
+  --               the product wraps at 32 bit like the RV32 mul of the C code
+  --   010 LERP2 : the same on each int16 half of two packed Q1.15 words
+  --   011 PACK  : Q16.16 -> Q1.15 of rs1 (x) and rs2 (y), v <= 0 -> 0, (v >> 1) > 0x7FFF -> 0x7FFF
+  --   100 EIDX  : half adjacency matrix index i * (2N - i - 1) / 2 + j - i - 1, rs1 = i < rs2 = j
+  -- I-type (custom-1): funct3(0) = 1 writes rs1 to slot imm12(0), every I-type reads the slot:
+  --   slot 0 = eps (Q16 rate, 17 bit), slot 1 = N (MAX_NODES of the edge table, 9 bit)
+  -- Two 18 x 18 multipliers are shared by the operations (operand mux on funct3).
 
 architecture neorv32_cpu_cp_cfu_rtl of neorv32_cpu_cp_cfu is
 
@@ -53,115 +57,137 @@ architecture neorv32_cpu_cp_cfu_rtl of neorv32_cpu_cp_cfu is
   constant i_type_c : std_ulogic := '1'; -- I-type CFU instructions (custom-1 opcode)
 
   -- instruction identifiers (funct3 bit-field) --
-  constant xtea_enc_v0_c : std_ulogic_vector(2 downto 0) := "000";
-  constant xtea_enc_v1_c : std_ulogic_vector(2 downto 0) := "001";
-  constant xtea_dec_v0_c : std_ulogic_vector(2 downto 0) := "010";
-  constant xtea_dec_v1_c : std_ulogic_vector(2 downto 0) := "011";
-  constant xtea_init_c   : std_ulogic_vector(2 downto 0) := "100";
-
-  -- round-key update --
-  constant xtea_delta_c : std_ulogic_vector(31 downto 0) := x"9e3779b9";
-
-  -- key storage (accessed via special r4-type instructions) --
-  type key_mem_t is array (0 to 3) of std_ulogic_vector(31 downto 0);
-  signal key_mem : key_mem_t;
-
-  -- processing logic --
-  type xtea_t is record
-    done : std_ulogic_vector(1 downto 0); -- multi-cycle done shift register; 2 stages = 2 cyles latency
-    opa  : std_ulogic_vector(31 downto 0); -- input operand a
-    opb  : std_ulogic_vector(31 downto 0); -- input operand b
-    sum  : std_ulogic_vector(31 downto 0); -- round key buffer
-    res  : std_ulogic_vector(31 downto 0); -- operation results
-  end record;
-  signal xtea : xtea_t;
-
-  -- helpers --
-  signal tmp_a, tmp_b, tmp_x, tmp_y, tmp_z, tmp_r : std_ulogic_vector(31 downto 0);
+  constant gng_dist2_c : std_ulogic_vector(2 downto 0) := "000";
+  constant gng_lerp_c  : std_ulogic_vector(2 downto 0) := "001";
+  constant gng_lerp2_c : std_ulogic_vector(2 downto 0) := "010";
+  constant gng_pack_c  : std_ulogic_vector(2 downto 0) := "011";
+  constant gng_eidx_c  : std_ulogic_vector(2 downto 0) := "100";
+
+  -- slots (accessed via I-type instructions) --
+  signal eps  : unsigned(16 downto 0); -- Q16 rate, 0..65536
+  signal nmax : unsigned(8 downto 0);  -- edge table N
+
+  -- shared multipliers --
+  signal ma0, mb0, ma1, mb1 : signed(17 downto 0);
+  signal mp0, mp1           : signed(35 downto 0);
+
+  -- Q16.16 -> Q1.15 with the pos_to_q15() clamp --
+  function to_q15(v : std_ulogic_vector(31 downto 0)) return std_ulogic_vector is
+    variable r : std_ulogic_vector(15 downto 0) := (others => '0');
+  begin
+    if (v(31) = '1') or (v = x"00000000") then
+      r := (others => '0');
+    elsif (v(30 downto 16) /= "000000000000000") then
+      r := x"7FFF";
+    else
+      r(14 downto 0) := v(15 downto 1);
+    end if;
+    return r;
+  end function to_q15;
 
 begin
 
-  -- XTEA Processing Core ------------------------------------------------------------------
+  -- Slot Registers -------------------------------------------------------------------------
   -- -------------------------------------------------------------------------------------------
-  xtea_core: process(rstn_i, clk_i)
+  slot_regs: process(rstn_i, clk_i)
   begin
     if (rstn_i = '0') then
-      xtea.done <= (others => '0');
-      xtea.opa  <= (others => '0');
-      xtea.opb  <= (others => '0');
-      xtea.sum  <= (others => '0');
-      xtea.res  <= (others => '0');
-      key_mem   <= (others => (others => '0'));
+      eps  <= (others => '0');
+      nmax <= (others => '0');
     elsif rising_edge(clk_i) then
-      -- "operation-done" shift register: module has 2 cycles latency --
-      xtea.done(0) <= '0'; -- default: no operation trigger
-      xtea.done(1) <= xtea.done(0); -- arbitration shift register
-
-      -- trigger new operation --
-      if (start_i = '1') then
-        if (type_i = r_type_c) then -- R-type for computational instructions
-          xtea.opa     <= rs1_i; -- buffer input operand rs1
-          xtea.opb     <= rs2_i; -- buffer input operand rs2
-          xtea.done(0) <= '1'; -- start data processing
-        else -- I-type is used for key access instructions
-          if (funct3_i(0) = '1') then -- key write-enable
-            key_mem(to_integer(unsigned(imm12_i(1 downto 0)))) <= rs1_i; -- write key data at imm12(1:0)
-          end if;
-        end if;
-      end if;
-
-      -- data processing --
-      if (xtea.done(0) = '1') then -- second-stage execution trigger
-        -- update "sum" round key --
-        if (funct3_i(2) = '1') then -- initialize
-          xtea.sum <= xtea.opa; -- set initial round key
-        elsif (funct3_i(1 downto 0) = xtea_enc_v0_c(1 downto 0)) then -- encrypt v0
-          xtea.sum <= std_ulogic_vector(unsigned(xtea.sum) + unsigned(xtea_delta_c));
-        elsif (funct3_i(1 downto 0) = xtea_dec_v1_c(1 downto 0)) then -- decrypt v1
-          xtea.sum <= std_ulogic_vector(unsigned(xtea.sum) - unsigned(xtea_delta_c));
-        end if;
-        -- process "v" operands --
-        if (funct3_i(1) = '0') then -- encrypt
-          xtea.res <= std_ulogic_vector(unsigned(tmp_b) + unsigned(tmp_r));
-        else -- decrypt
-          xtea.res <= std_ulogic_vector(unsigned(tmp_b) - unsigned(tmp_r));
+      if (start_i = '1') and (type_i = i_type_c) and (funct3_i(0) = '1') then -- slot write-enable
+        if (imm12_i(0) = '0') then
+          eps <= unsigned(rs1_i(16 downto 0));
+        else
+          nmax <= unsigned(rs1_i(8 downto 0));
         end if;
       end if;
-
     end if;
-  end process xtea_core;
+  end process slot_regs;
+
 
-  -- helpers --
-  tmp_a <= xtea.opb when (funct3_i(0) = '0') else xtea.opa; -- v1 / v0 select
-  tmp_b <= xtea.opa when (funct3_i(0) = '0') else xtea.opb; -- v0 / v1 select
-  tmp_x <= xtea.opb(27 downto 0) & "0000"  when (funct3_i(0) = '0') else xtea.opa(27 downto 0) & "0000";  -- v << 4
-  tmp_y <= "00000" & xtea.opb(31 downto 5) when (funct3_i(0) = '0') else "00000" & xtea.opa(31 downto 5); -- v >> 5
-  tmp_z <= key_mem(to_integer(unsigned(xtea.sum(1 downto 0)))) when (funct3_i(0) = '0') else -- key[sum & 3]
-           key_mem(to_integer(unsigned(xtea.sum(12 downto 11)))); -- key[(sum >> 11) & 3]
-  tmp_r <= std_ulogic_vector(unsigned(tmp_x xor tmp_y) + unsigned(tmp_a)) xor std_ulogic_vector(unsigned(xtea.sum) + unsigned(tmp_z));
+  -- Multiplier Operands --------------------------------------------------------------------
+  -- -------------------------------------------------------------------------------------------
+  operands: process(funct3_i, rs1_i, rs2_i, eps, nmax)
+    variable d : unsigned(31 downto 0);
+  begin
+    ma0 <= (others => '0'); mb0 <= (others => '0');
+    ma1 <= (others => '0'); mb1 <= (others => '0');
+    case funct3_i is
+      when gng_dist2_c => -- dx^2, dy^2 (17-bit differences)
+        ma0 <= resize(signed(rs1_i(15 downto 0)), 18) - resize(signed(rs2_i(15 downto 0)), 18);
+        mb0 <= resize(signed(rs1_i(15 downto 0)), 18) - resize(signed(rs2_i(15 downto 0)), 18);
+        ma1 <= resize(signed(rs1_i(31 downto 16)), 18) - resize(signed(rs2_i(31 downto 16)), 18);
+        mb1 <= resize(signed(rs1_i(31 downto 16)), 18) - resize(signed(rs2_i(31 downto 16)), 18);
+      when gng_lerp_c => -- eps * (t - p): low and high half of the 32-bit difference
+        d   := unsigned(rs2_i) - unsigned(rs1_i);
+        ma0 <= signed("00" & d(15 downto 0));
+        ma1 <= signed("00" & d(31 downto 16));
+        mb0 <= signed('0' & eps);
+        mb1 <= signed('0' & eps);
+      when gng_lerp2_c => -- eps * (t - p) per half
+        ma0 <= resize(signed(rs2_i(15 downto 0)), 18) - resize(signed(rs1_i(15 downto 0)), 18);
+        ma1 <= resize(signed(rs2_i(31 downto 16)), 18) - resize(signed(rs1_i(31 downto 16)), 18);
+        mb0 <= signed('0' & eps);
+        mb1 <= signed('0' & eps);
+      when gng_eidx_c => -- i * (2N - i - 1)
+        ma0 <= signed("000000000" & rs1_i(8 downto 0));
+        mb0 <= signed(resize((nmax & '0') - unsigned(rs1_i(8 downto 0)) - 1, 18));
+      when others =>
+        null;
+    end case;
+  end process operands;
+
+  mp0 <= ma0 * mb0;
+  mp1 <= ma1 * mb1;
 
 
   -- Function Result Select -----------------------------------------------------------------
   -- -------------------------------------------------------------------------------------------
-  result_select: process(type_i, funct3_i, imm12_i, xtea, key_mem)
+  result_select: process(type_i, funct3_i, funct7_i, imm12_i, rs1_i, rs2_i, mp0, mp1, eps, nmax)
+    variable m0, m1 : unsigned(31 downto 0);
+    variable s0, s1 : signed(31 downto 0);
   begin -- no need for a register stage here; the CFU output is registered inside the ALU module anyway
-    if (type_i = r_type_c) then -- R-type instructions; function select via "funct3" and ""funct7
+    result_o <= (others => '0');
+    valid_o  <= '0'; -- unspecified operations cause an illegal instruction exception
+    if (type_i = r_type_c) then -- R-type instructions; function select via "funct3", "funct7" = 0
     -- ----------------------------------------------------------------------
-      case funct3_i is -- just check "funct3" here; "funct7" bit-field is ignored in this example
-        when xtea_enc_v0_c | xtea_enc_v1_c | xtea_dec_v0_c | xtea_dec_v1_c => -- encryption/decryption
-          result_o <= xtea.res; -- processing result
-          valid_o  <= xtea.done(1); -- multi-cycle processing done when set
-        when xtea_init_c => -- xtea initialization
-          result_o <= (others => '0'); -- just output zero
-          valid_o  <= '1'; -- pure-combinatorial, so we are done "immediately"
-        when others => -- all unspecified operations
-          result_o <= (others => '0'); -- no logic implemented
-          valid_o  <= '0'; -- this will cause an illegal instruction exception
-      end case;
-    else -- I-type instructions; used for key access
+      if (funct7_i = "0000000") then
+        case funct3_i is
+          when gng_dist2_c =>
+            result_o <= std_ulogic_vector(unsigned(mp0(31 downto 0)) + unsigned(mp1(31 downto 0)));
+            valid_o  <= '1';
+          when gng_lerp_c =>
+            m0 := unsigned(mp0(31 downto 0)) + shift_left(unsigned(mp1(31 downto 0)), 16) + 32768;
+            result_o <= std_ulogic_vector(unsigned(rs1_i) + unsigned(shift_right(signed(m0), 16)));
+            valid_o  <= '1';
+          when gng_lerp2_c =>
+            m0 := unsigned(mp0(31 downto 0)) + 32768;
+            m1 := unsigned(mp1(31 downto 0)) + 32768;
+            s0 := shift_right(signed(m0), 16);
+            s1 := shift_right(signed(m1), 16);
+            result_o(15 downto 0)  <= std_ulogic_vector(unsigned(rs1_i(15 downto 0)) + unsigned(s0(15 downto 0)));
+            result_o(31 downto 16) <= std_ulogic_vector(unsigned(rs1_i(31 downto 16)) + unsigned(s1(15 downto 0)));
+            valid_o  <= '1';
+          when gng_pack_c =>
+            result_o <= to_q15(rs2_i) & to_q15(rs1_i);
+            valid_o  <= '1';
+          when gng_eidx_c =>
+            result_o <= std_ulogic_vector(resize(unsigned(mp0(19 downto 1)), 32) + unsigned(rs2_i) -
+                                          unsigned(rs1_i) - 1);
+            valid_o  <= '1';
+          when others =>
+            null;
+        end case;
+      end if;
+    else -- I-type instructions; slot access
     -- ----------------------------------------------------------------------
-      result_o <= key_mem(to_integer(unsigned(imm12_i(1 downto 0))));
-      valid_o  <= '1'; -- pure-combinatorial, so we are done "immediately"
+      if (imm12_i(0) = '0') then
+        result_o(16 downto 0) <= std_ulogic_vector(eps);
+      else
+        result_o(8 downto 0) <= std_ulogic_vector(nmax);
+      end if;
+      valid_o <= '1'; -- pure-combinatorial, so we are done "immediately"
     end if;
   end process result_select;
 
@@ -126,6 +126,14 @@ entity neorv32_top is
     IO_TRNG_EN            : boolean                        := false;       -- implement true random number generator (TRNG)
     IO_TRNG_FIFO          : natural range 1 to 2**15       := 1;           -- data FIFO depth, has to be a power of two, min 1
     IO_CFS_EN             : boolean                        := false;       -- implement custom functions subsystem (CFS)
+    IO_CFS_CLK_ASYNC      : boolean                        := false;       -- CFS winner engine on cfs_clk_i (own clock domain)
+    IO_CFS_LANES          : natural range 1 to 8           := 4;           -- CFS distance lanes: 1, 2, 4 or 8
+    IO_CFS_MAXNODES       : natural range 1 to 256         := 40;          -- CFS node capacity
+    IO_CFS_CTX            : natural range 1 to 8           := 1;           -- CFS node_mem banks (GNG instances)
+    IO_CFS_DIM            : natural range 2 to 64          := 2;           -- CFS components per node / sample
+    IO_CFS_COARSE         : natural range 0 to 32          := 0;           -- CFS coarse-pass lanes (LUT only, 0 = off)
+    IO_CFS_MOVE           : boolean                        := false;       -- CFS s1 / neighbor move unit (CTRL.MOVE)
+    IO_CFS_DUMP           : boolean                        := false;       -- CFS keyframe framer on the UART0 TX pin (REG_DUMP)
     IO_NEOLED_EN          : boolean                        := false;       -- implement NeoPixel-compatible smart LED interface (NEOLED)
     IO_NEOLED_TX_FIFO     : natural range 1 to 2**15       := 1;           -- NEOLED FIFO depth, has to be a power of two, min 1
     IO_GPTMR_NUM          : natural range 0 to 16          := 0;           -- number of GPTMR timer slices to implement (0..16)
@@ -230,6 +238,8 @@ entity neorv32_top is
     pwm_o          : out std_ulogic_vector(31 downto 0);                    -- pwm channels
 
     -- Custom Functions Subsystem IO (available if IO_CFS_EN = true) --
+    cfs_clk_i      : in  std_ulogic := 'L';                                 -- CFS engine clock (IO_CFS_CLK_ASYNC = true)
+    cfs_clk_en_o   : out std_ulogic;                                        -- CFS engine clock enable (CTRL.SLEEP clear)
 --    cfs_in_i       : in  std_ulogic_vector(255 downto 0) := (others => 'L'); -- custom CFS inputs conduit
 --    cfs_out_o      : out std_ulogic_vector(255 downto 0);                    -- custom CFS outputs conduit
 
@@ -329,6 +339,11 @@ architecture neorv32_top_rtl of neorv32_top is
   signal mtime_irq : std_ulogic_vector(num_cores_c-1 downto 0);
   signal msw_irq   : std_ulogic_vector(num_cores_c-1 downto 0);
 
+  -- UART0 TX through the CFS (the snapshot dump shares the pin, CTS holds UART0)
+  signal uart0_txd  : std_ulogic;
+  signal uart0_ctsn : std_ulogic;
+  signal cfs_ctsn   : std_ulogic;
+
 begin
 
   -- **************************************************************************************************************************
@@ -1030,12 +1045,27 @@ begin
     neorv32_cfs_enabled:
     if IO_CFS_EN generate
       neorv32_cfs_inst: entity neorv32.neorv32_cfs
+      generic map (
+        LANES       => IO_CFS_LANES,
+        MAXNODES    => IO_CFS_MAXNODES,
+        CTX         => IO_CFS_CTX,
+        DIM         => IO_CFS_DIM,
+        COARSE      => IO_CFS_COARSE,
+        MOVE        => IO_CFS_MOVE,
+        DUMP        => IO_CFS_DUMP,
+        CLK_ASYNC   => IO_CFS_CLK_ASYNC
+      )
       port map (
         clk_i       => clk_i,
+        clk_cfs_i   => cfs_clk_i,
         rstn_i      => rstn_sys,
         bus_req_i   => iodev_req(IODEV_CFS),
         bus_rsp_o   => iodev_rsp(IODEV_CFS),
-        irq_o       => firq(FIRQ_CFS)
+        irq_o       => firq(FIRQ_CFS),
+        clk_en_o    => cfs_clk_en_o,
+        uart_txd_i  => uart0_txd,
+        uart_txd_o  => uart0_txd_o,
+        uart_ctsn_o => cfs_ctsn
 --        cfs_in_i    => cfs_in_i,
 --        cfs_out_o   => cfs_out_o
       );
@@ -1045,6 +1075,9 @@ begin
     if not IO_CFS_EN generate
       iodev_rsp(IODEV_CFS) <= rsp_terminate_c;
       firq(FIRQ_CFS)       <= '0';
+      cfs_clk_en_o         <= '1';
+      uart0_txd_o          <= uart0_txd;
+      cfs_ctsn             <= '0';
 --      cfs_out_o            <= (others => '0');
     end generate;
 
@@ -1159,6 +1192,9 @@ begin
 
     -- Primary Universal Asynchronous Receiver/Transmitter (UART0) ----------------------------
     -- -------------------------------------------------------------------------------------------
+    -- CTS: the external pin or the CFS snapshot dump while it sends
+    uart0_ctsn <= uart0_ctsn_i or cfs_ctsn;
+
     neorv32_uart0_enabled:
     if IO_UART0_EN generate
       neorv32_uart0_inst: entity neorv32.neorv32_uart
@@ -1174,10 +1210,10 @@ begin
         bus_req_i   => iodev_req(IODEV_UART0),
         bus_rsp_o   => iodev_rsp(IODEV_UART0),
         clkgen_i    => clk_gen,
-        uart_txd_o  => uart0_txd_o,
+        uart_txd_o  => uart0_txd,
         uart_rxd_i  => uart0_rxd_i,
         uart_rtsn_o => uart0_rtsn_o,
-        uart_ctsn_i => uart0_ctsn_i,
+        uart_ctsn_i => uart0_ctsn,
         irq_o       => firq(FIRQ_UART0)
       );
     end generate;
@@ -1185,7 +1221,7 @@ begin
     neorv32_uart0_disabled:
     if not IO_UART0_EN generate
       iodev_rsp(IODEV_UART0) <= rsp_terminate_c;
-      uart0_txd_o            <= '0';
+      uart0_txd              <= '0';
       uart0_rtsn_o           <= '1';
       firq(FIRQ_UART0)       <= '0';
     end generate;
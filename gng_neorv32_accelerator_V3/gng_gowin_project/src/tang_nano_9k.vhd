@@ -14,6 +14,9 @@ use ieee.numeric_std.all;
 
 library neorv32;
 
+-- build preset (presets.py apply v3 <name>), defaults of the generics below
+use work.gng_preset.all;
+
 entity neorv32_ProcessorTop_MinimalBoot is
   generic (
     -- Clocking --
@@ -27,6 +30,36 @@ entity neorv32_ProcessorTop_MinimalBoot is
     DMEM_SIZE       : natural := 16*1024; -- size of processor-internal data memory in bytes --default 64
     -- Processor peripherals --
     IO_GPIO_NUM     : natural := 6;       -- number of GPIO input/output pairs (0..32)
+    -- RISC-V CPU Extensions (keep in sync with fw/makefile GNG_ISA) --
+    CPU_EXT_M       : boolean := PRESET_CPU_EXT_M;     -- hardware mul/div (neorv32_cpu_cp_muldiv)
+    CPU_EXT_B       : boolean := PRESET_CPU_EXT_B;     -- Zba + Zbb bit-manipulation (neorv32_cpu_cp_bitmanip)
+    CPU_FAST_MUL    : boolean := PRESET_CPU_FAST_MUL;  -- multiplier on DSPs (competes with CFS LANES)
+    CPU_DMA         : boolean := PRESET_CPU_DMA;       -- neorv32_dma (fw copies the node window with it)
+    CPU_DUAL_CORE   : boolean := PRESET_CPU_DUAL_CORE; -- second hart for RX / snapshots / TX (fw GNG_SMP = 1)
+    CPU_ICACHE      : natural := PRESET_CPU_ICACHE;    -- i-cache blocks of 32 bytes in front of the uflash code (0 = off, power of 2)
+    CPU_TRACER      : natural := PRESET_CPU_TRACER;    -- neorv32_tracer buffer, (src, dst) pairs (0 = off, power of 2; fw GNG_TRACE = 1)
+    CPU_CFU         : boolean := PRESET_CPU_CFU;       -- GNG custom instructions (neorv32_cpu_cp_cfu, 2 DSPs; fw GNG_CFU = 1)
+    -- Snapshot stream on SDI (SPI slave, keep in sync with fw/makefile SNAPSHOT_SDI) --
+    SNAPSHOT_SDI    : boolean := PRESET_SNAPSHOT_SDI;
+    -- TF card on SPI (keep in sync with fw/makefile SD_CARD) --
+    SD_CARD         : boolean := PRESET_SD_CARD;
+    -- TRNG (fw CMD_GEN seeds the on-board generators with it, GEN_SEED without) --
+    TRNG_EN         : boolean := true;
+    -- CFS winner engine clock: 1 = clk_i, 2 / 3 = rPLL 54 / 81 MHz (own clock domain) --
+    CFS_CLK_MUL     : natural := PRESET_CFS_CLK_MUL;
+    -- CFS distance lanes (1 DSP each) and node capacity (fw MAX_NODES <= this) --
+    CFS_LANES       : natural := PRESET_CFS_LANES;
+    CFS_MAXNODES    : natural := PRESET_CFS_MAXNODES;
+    -- CFS node banks, one per GNG instance (fw GNG_MODELS <= this, else full syncs) --
+    CFS_CTX         : natural := PRESET_CFS_CTX;
+    -- CFS components per node / sample (fw GNG_DIM: same ceil(DIM/2) words) --
+    CFS_DIM         : natural := PRESET_CFS_DIM;
+    -- CFS coarse-pass lanes on LUTs ahead of the exact LANES scan (0 = off) --
+    CFS_COARSE      : natural := PRESET_CFS_COARSE;
+    -- CFS s1 / neighbor move after the search (fw GNG_CFS_MOVE, CFS_DIM = 2, CFS_CLK_MUL = 1) --
+    CFS_MOVE        : boolean := PRESET_CFS_MOVE;
+    -- CFS keyframe framer on uart_txd_o (edges from adj_mem with CFS_MOVE, fw probes REG_DIM) --
+    CFS_DUMP        : boolean := PRESET_CFS_DUMP;
 
     BOOT_MODE_SELECT : natural := 0;
     UFLASH_BASE : std_logic_vector(31 downto 0) := x"00000000";
@@ -36,11 +69,23 @@ entity neorv32_ProcessorTop_MinimalBoot is
     -- Global control --
     clk_i      : in  std_logic;
     rstn_i     : in  std_logic;
+    -- boot strap key (S1, low-active when pressed): bootloader waits for a console key --
+    boot_key_n_i : in std_ulogic := '1';
     -- GPIO (available if IO_GPIO_EN = true) --
     gpio_o     : out std_ulogic_vector(IO_GPIO_NUM-1 downto 0);
     -- primary UART0 (available if IO_UART0_EN = true) --
     uart_txd_o : out std_ulogic; -- UART0 send data
     uart_rxd_i : in  std_ulogic := '0'; -- UART0 receive data
+    -- SDI (SPI slave) snapshot stream, idle when SNAPSHOT_SDI = false --
+    sdi_clk_i  : in  std_ulogic := '0'; -- SPI clock from the host master
+    sdi_csn_i  : in  std_ulogic := '1'; -- chip select, low-active
+    sdi_dat_i  : in  std_ulogic := '0'; -- MOSI (unused by the fw)
+    sdi_dat_o  : out std_ulogic;         -- MISO, snapshot frames
+    -- TF card slot in SPI mode, idle when SD_CARD = false --
+    sd_clk_o   : out std_ulogic;         -- SD_CLK
+    sd_cmd_o   : out std_ulogic;         -- SD_CMD = MOSI
+    sd_dat0_i  : in  std_ulogic := '1';  -- SD_DAT0 = MISO
+    sd_dat3_o  : out std_ulogic;         -- SD_DAT3 = chip select, low-active
     -- PWM (available if IO_PWM_NUM > 0) --
 --    pwm_o      : out std_ulogic_vector(IO_PWM_NUM-1 downto 0)
     -- JTAG --
@@ -56,6 +101,8 @@ architecture neorv32_ProcessorTop_MinimalBoot_rtl of neorv32_ProcessorTop_Minima
   -- internal IO connection --
 --  signal con_gpio_o, con_pwm_o : std_ulogic_vector(31 downto 0);
   signal con_gpio_o : std_ulogic_vector(31 downto 0);
+  signal con_gpio_i : std_ulogic_vector(31 downto 0);
+  signal con_spi_csn : std_ulogic_vector(7 downto 0);
 
    --Xbus signals
   signal xbus_adr_o : std_ulogic_vector(31 downto 0);
@@ -81,8 +128,106 @@ architecture neorv32_ProcessorTop_MinimalBoot_rtl of neorv32_ProcessorTop_Minima
   signal cfs_in_i_r       : std_ulogic_vector(255 downto 0);
   signal cfs_out_o_r      : std_ulogic_vector(255 downto 0);
 
+  -- CFS engine clock (CFS_CLK_MUL > 1), gated by CFS CTRL.SLEEP
+  signal cfs_clk     : std_ulogic := '0';
+  signal cfs_pll_clk : std_ulogic;
+  signal cfs_clk_en  : std_ulogic;
+
+  component rPLL
+    generic (
+      FCLKIN           : string  := "100.0";
+      DEVICE           : string  := "GW1N-4";
+      DYN_IDIV_SEL     : string  := "false";
+      IDIV_SEL         : integer := 0;
+      DYN_FBDIV_SEL    : string  := "false";
+      FBDIV_SEL        : integer := 0;
+      DYN_ODIV_SEL     : string  := "false";
+      ODIV_SEL         : integer := 8;
+      PSDA_SEL         : string  := "0000";
+      DYN_DA_EN        : string  := "false";
+      DUTYDA_SEL       : string  := "1000";
+      CLKOUT_FT_DIR    : bit     := '1';
+      CLKOUTP_FT_DIR   : bit     := '1';
+      CLKOUT_DLY_STEP  : integer := 0;
+      CLKOUTP_DLY_STEP : integer := 0;
+      CLKFB_SEL        : string  := "internal";
+      CLKOUT_BYPASS    : string  := "false";
+      CLKOUTP_BYPASS   : string  := "false";
+      CLKOUTD_BYPASS   : string  := "false";
+      DYN_SDIV_SEL     : integer := 2;
+      CLKOUTD_SRC      : string  := "CLKOUT";
+      CLKOUTD3_SRC     : string  := "CLKOUT"
+    );
+    port (
+      CLKOUT   : out std_logic;
+      LOCK     : out std_logic;
+      CLKOUTP  : out std_logic;
+      CLKOUTD  : out std_logic;
+      CLKOUTD3 : out std_logic;
+      RESET    : in  std_logic;
+      RESET_P  : in  std_logic;
+      CLKIN    : in  std_logic;
+      CLKFB    : in  std_logic;
+      FBDSEL   : in  std_logic_vector(5 downto 0);
+      IDSEL    : in  std_logic_vector(5 downto 0);
+      ODSEL    : in  std_logic_vector(5 downto 0);
+      PSDA     : in  std_logic_vector(3 downto 0);
+      DUTYDA   : in  std_logic_vector(3 downto 0);
+      FDLY     : in  std_logic_vector(3 downto 0)
+    );
+  end component;
+
+  component DCE
+    port (
+      CLKIN  : in  std_logic;
+      CE     : in  std_logic;
+      CLKOUT : out std_logic
+    );
+  end component;
+
 begin
 
+  assert (CFS_CLK_MUL >= 1) and (CFS_CLK_MUL <= 3)
+    report "tang_nano_9k: CFS_CLK_MUL must be 1, 2 or 3" severity failure;
+
+  -- CFS engine clock: 27 MHz * CFS_CLK_MUL, VCO = 8 * CLKOUT (432 / 648 MHz)
+  cfs_pll_gen:
+  if CFS_CLK_MUL > 1 generate
+    cfs_pll: rPLL
+    generic map (
+      FCLKIN    => "27",
+      DEVICE    => "GW1NR-9C",
+      IDIV_SEL  => 0,
+      FBDIV_SEL => CFS_CLK_MUL - 1,
+      ODIV_SEL  => 8
+    )
+    port map (
+      CLKOUT   => cfs_pll_clk,
+      LOCK     => open,
+      CLKOUTP  => open,
+      CLKOUTD  => open,
+      CLKOUTD3 => open,
+      RESET    => '0',
+      RESET_P  => '0',
+      CLKIN    => clk_i,
+      CLKFB    => '0',
+      FBDSEL   => (others => '0'),
+      IDSEL    => (others => '0'),
+      ODSEL    => (others => '0'),
+      PSDA     => (others => '0'),
+      DUTYDA   => (others => '0'),
+      FDLY     => (others => '0')
+    );
+
+    -- glitch-free clock enable: the idle firmware stops the engine (CTRL.SLEEP)
+    cfs_dce: DCE
+    port map (
+      CLKIN  => cfs_pll_clk,
+      CE     => cfs_clk_en,
+      CLKOUT => cfs_clk
+    );
+  end generate;
+
    --Check if address is in uflash range
   sel_uflash <= '1' when (
       (unsigned(xbus_adr_o) >= unsigned(UFLASH_BASE)) and
@@ -123,10 +268,22 @@ begin
   generic map (
     -- Clocking --
     CLOCK_FREQUENCY  => CLOCK_FREQUENCY, -- clock frequency of clk_i in Hz
+    -- Dual-Core Configuration --
+    DUAL_CORE_EN     => CPU_DUAL_CORE,   -- second hart (needs the CLINT, IO_CLINT_EN below)
     -- Boot Configuration --
     BOOT_MODE_SELECT => BOOT_MODE_SELECT,               -- boot via internal bootloader
     -- RISC-V CPU Extensions --
     RISCV_ISA_Zicntr => true,            -- implement base counters?
+    RISCV_ISA_M      => CPU_EXT_M,       -- implement mul/div extension?
+    RISCV_ISA_Zba    => CPU_EXT_B,       -- implement shifted-add bit-manipulation extension?
+    RISCV_ISA_Zbb    => CPU_EXT_B,       -- implement basic bit-manipulation extension?
+    RISCV_ISA_Zxcfu  => CPU_CFU,         -- implement custom (instr.) functions unit?
+    CPU_FAST_MUL_EN  => CPU_FAST_MUL,    -- use DSPs for M extension's multiplier
+    -- CPU Caches (the code runs from the uflash, ~5 cycles per uncached fetch) --
+    ICACHE_EN         => CPU_ICACHE > 0,
+    ICACHE_NUM_BLOCKS => CPU_ICACHE + boolean'pos(CPU_ICACHE = 0),
+    CACHE_BLOCK_SIZE  => 32,             -- 8 uflash words per miss
+    CACHE_BURSTS_EN   => false,          -- uflash.vhd answers single reads only
     -- Internal Instruction memory --
     IMEM_EN          => IMEM_EN,         -- implement processor-internal instruction memory
     IMEM_SIZE        => IMEM_SIZE,       -- size of processor-internal instruction memory in bytes
@@ -137,9 +294,28 @@ begin
     IO_GPIO_NUM      => IO_GPIO_NUM,     -- number of GPIO input/output pairs (0..32)
     IO_CLINT_EN      => true,            -- implement core local interruptor (CLINT)?
     IO_UART0_EN      => true,            -- implement primary universal asynchronous receiver/transmitter (UART0)?
+    IO_UART0_RX_FIFO => 16,              -- RX FIFO depth (fw drains it from the RX-not-empty IRQ)
+    IO_UART0_TX_FIFO => 16,              -- TX FIFO depth (fw refills it from the TX-empty IRQ)
+    IO_SDI_EN        => SNAPSHOT_SDI,    -- implement serial data interface (SDI)?
+    IO_SDI_FIFO      => 64,              -- SDI TX/RX FIFO depth
+    IO_DMA_EN        => CPU_DMA,         -- implement direct memory access controller (DMA)?
+    IO_SPI_EN        => SD_CARD,         -- implement serial peripheral interface (SPI)?
+    IO_SPI_FIFO      => 1,               -- SPI RTX FIFO depth (diskio.c moves single bytes)
+    IO_TRNG_EN       => TRNG_EN,         -- implement true random number generator (TRNG)?
+    IO_TRNG_FIFO     => 1,               -- TRNG data FIFO depth (one word per CMD_GEN)
     OCD_EN            => true,               -- implement JTAG interface
+    IO_TRACER_EN      => CPU_TRACER > 0,     -- execution tracer, hart 0 branch pairs (fw CMD_TRACE, or over JTAG)
+    IO_TRACER_BUFFER  => CPU_TRACER + boolean'pos(CPU_TRACER = 0),
 
     IO_CFS_EN       => true,
+    IO_CFS_CLK_ASYNC => CFS_CLK_MUL > 1,    -- engine on cfs_clk_i (see neorv32_cfs)
+    IO_CFS_LANES     => CFS_LANES,
+    IO_CFS_MAXNODES  => CFS_MAXNODES,
+    IO_CFS_CTX       => CFS_CTX,
+    IO_CFS_DIM       => CFS_DIM,
+    IO_CFS_COARSE    => CFS_COARSE,
+    IO_CFS_MOVE      => CFS_MOVE,
+    IO_CFS_DUMP      => CFS_DUMP,
 
     XBUS_EN           => true,              -- implement X-Bus interface
     XBUS_TIMEOUT      => 0                  -- Disable timeout, flash erase can take a long time
@@ -150,10 +326,23 @@ begin
     rstn_i      => rstn_i,                       -- global reset, low-active, async
     -- GPIO (available if IO_GPIO_NUM > 0) --
     gpio_o      => con_gpio_o,                   -- parallel output
-    gpio_i      => (others => '0'),              -- parallel input
+    gpio_i      => con_gpio_i,                   -- parallel input (bit 0 = boot strap)
     -- primary UART0 (available if IO_UART0_EN = true) --
     uart0_txd_o => uart_txd_o,                   -- UART0 send data
     uart0_rxd_i => uart_rxd_i,                   -- UART0 receive data
+    -- SDI (available if IO_SDI_EN = true) --
+    sdi_clk_i   => sdi_clk_i,                    -- SDI serial clock
+    sdi_dat_o   => sdi_dat_o,                    -- controller data in, peripheral data out
+    sdi_dat_i   => sdi_dat_i,                    -- controller data out, peripheral data in
+    sdi_csn_i   => sdi_csn_i,                    -- chip-select, low-active
+    -- SPI (available if IO_SPI_EN = true) --
+    spi_clk_o   => sd_clk_o,                     -- SPI serial clock
+    spi_dat_o   => sd_cmd_o,                     -- controller data out, peripheral data in
+    spi_dat_i   => sd_dat0_i,                    -- controller data in, peripheral data out
+    spi_csn_o   => con_spi_csn,                  -- chip-select, low-active
+    -- CFS engine clock (used if CFS_CLK_MUL > 1) --
+    cfs_clk_i   => cfs_clk,
+    cfs_clk_en_o => cfs_clk_en,
     -- PWM (available if IO_PWM_NUM > 0) --
 --    pwm_o       => con_pwm_o                     -- pwm channels
 
@@ -182,6 +371,10 @@ begin
 
   -- GPIO --
   gpio_o <= con_gpio_o(IO_GPIO_NUM-1 downto 0);
+  con_gpio_i <= (0 => not boot_key_n_i, others => '0'); -- bootloader BOOT_STRAP_PIN
+
+  -- TF card = SPI CS 1 (bootloader config.h SPI_SDCARD_CS, diskio.c in both images) --
+  sd_dat3_o <= con_spi_csn(1);
 
   -- PWM --
 --  pwm_o <= con_pwm_o(IO_PWM_NUM-1 downto 0);
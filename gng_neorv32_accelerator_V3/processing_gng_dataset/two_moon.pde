@@ -35,6 +35,19 @@ final float   MOONS_NOISE_STD    = 0.06;
 final boolean MOONS_SHUFFLE      = true;
 final boolean MOONS_NORMALIZE01  = true;
 
+// Streaming mode: CMD_STREAM, then samples paced by CMD_CREDIT from the fw
+// (dataset is cycled endlessly, no MAXPTS limit on MOONS_N)
+final boolean STREAM_MODE        = false;
+final int     STREAM_BATCH       = 63;  // points per DATA_BATCH frame (255-byte limit)
+
+// Snapshot triggers (CMD_SNAP_MODE), OR of: 0x01 every SNAP_EVERY steps,
+// 0x02 topology change, 0x04 QE drop of SNAP_QE_PCT %, 0x08 every SNAP_MS ms
+final int     SNAP_MASK          = 0x01;
+final int     SNAP_EVERY         = 100;
+final int     SNAP_MIN_GAP       = 10;  // steps between event-triggered snapshots
+final int     SNAP_QE_PCT        = 10;
+final int     SNAP_MS            = 100;
+
 // ===============================
 // Dataset upload state
 // ===============================
@@ -53,8 +66,24 @@ int gngNodeCount = 0;
 int gngEdgeCount = 0;
 int lastFrameNodes = -1;
 int lastFrameEdges = -1;
+
+// delta stream: deltas apply only on top of the frame before them
+boolean streamSynced = false;
+int lastAppliedFrame = -1;
+int deltasDropped = 0;
+
+// chunked edges: collected here, copied to adj[] on the last chunk
+boolean[][] chunkAdj = new boolean[MAX_NODES][MAX_NODES];
+int chunkFrame = -1;
+int chunkNext  = 0;
+int chunkGot   = 0;
 int lastFrameProf  = -1;
 
+// streaming: samples the fw still accepts, next dataset index to send
+int streamCredits = 0;
+int streamIdx     = 0;
+long streamSent   = 0;
+
 // ===============================
 // TIMER (ms)
 // ===============================
@@ -70,10 +99,16 @@ final int UART_HDR       = 0xFF;
 final int CMD_DATA_BATCH = 0x01;
 final int CMD_DONE       = 0x02;
 final int CMD_RUN        = 0x03;
+final int CMD_STREAM     = 0x04;
+final int CMD_SNAP_MODE  = 0x06;
 
 final int CMD_GNG_NODES  = 0x10;
 final int CMD_GNG_EDGES  = 0x11;
 final int CMD_PROF       = 0x12;
+final int CMD_GNG_DELTA  = 0x13;
+final int CMD_GNG_EDGES_CHUNK = 0x14;
+final int CMD_CREDIT     = 0x15;
+final int CMD_GNG_EDGES_BITMAP = 0x17;
 
 // RX state machine
 final int RX_WAIT_H1      = 0;
@@ -116,6 +151,10 @@ int edgesN = 0;
 static class Prof {
   int cyc_total, cyc_winner, cyc_move_w, cyc_nb, cyc_connect, cyc_delete, cyc_prune, cyc_insert, cyc_renorm;
   int stepCount;
+  int cyc_overlap; // optional (CFS_USE_IRQ firmware)
+  int misa, mxisa; // optional (ISA profile of the build, fw makefile GNG_ISA)
+  int tx_stall;    // optional (cycles fw blocked on a full UART TX ring)
+  int smp_dropped; // optional (stream samples the fw dropped, total)
 }
 Prof prof = new Prof();
 
@@ -151,6 +190,7 @@ void setup() {
   myPort = new processing.serial.Serial(this, PORT_NAME, BAUD);
   myPort.clear();
   delay(1200);
+  sendSnapMode();
 
   data = generateMoons(
     MOONS_N,
@@ -189,7 +229,8 @@ void draw() {
 
   processSerial();
 
-  if (!uploaded) uploadDataset();
+  if (STREAM_MODE) streamDataset();
+  else if (!uploaded) uploadDataset();
   else if (!running) sendRunCommand();
 
   // plot area (keep it square inside the upper region)
@@ -243,6 +284,56 @@ void uploadDataset() {
   idx += count;
 }
 
+// ===============================
+// Streaming mode: send only what the fw has granted
+// ===============================
+void streamDataset() {
+  if (!uploaded) {
+    sendFrame((byte)CMD_STREAM, new byte[0]);
+    lastTX = "STREAM";
+    uploaded = true;
+    running = true;
+    tRunStartMs = millis();
+    println("[TX] STREAM");
+    return;
+  }
+
+  while (streamCredits > 0) {
+    int count = min(STREAM_BATCH, streamCredits);
+
+    byte[] payload = new byte[1 + count * 4];
+    payload[0] = (byte)count;
+
+    int p = 1;
+    for (int i = 0; i < count; i++) {
+      short xi = (short)(data[streamIdx][0] * 1000.0);
+      short yi = (short)(data[streamIdx][1] * 1000.0);
+      streamIdx = (streamIdx + 1) % data.length;
+
+      payload[p++] = (byte)(xi & 0xFF);
+      payload[p++] = (byte)((xi >> 8) & 0xFF);
+      payload[p++] = (byte)(yi & 0xFF);
+      payload[p++] = (byte)((yi >> 8) & 0xFF);
+    }
+
+    sendFrame((byte)CMD_DATA_BATCH, payload);
+    streamCredits -= count;
+    streamSent += count;
+  }
+  lastTX = "STREAM sent=" + streamSent + " credits=" + streamCredits;
+}
+
+void sendSnapMode() {
+  byte[] p = new byte[8];
+  p[0] = (byte)SNAP_MASK;
+  p[1] = (byte)(SNAP_EVERY & 0xFF);   p[2] = (byte)((SNAP_EVERY >> 8) & 0xFF);
+  p[3] = (byte)(SNAP_MIN_GAP & 0xFF); p[4] = (byte)((SNAP_MIN_GAP >> 8) & 0xFF);
+  p[5] = (byte)SNAP_QE_PCT;
+  p[6] = (byte)(SNAP_MS & 0xFF);      p[7] = (byte)((SNAP_MS >> 8) & 0xFF);
+  sendFrame((byte)CMD_SNAP_MODE, p);
+  println("[TX] SNAP_MODE mask=" + SNAP_MASK);
+}
+
 void sendRunCommand() {
   sendFrame((byte)CMD_RUN, new byte[0]);
   lastTX = "RUN";
@@ -323,6 +414,12 @@ void handleAsciiByte(int b) {
 // ===============================
 void handleFrame(int cmd, byte[] payload, int len) {
 
+  if (cmd == CMD_CREDIT) {
+    if (len < 2) return;
+    streamCredits += (payload[0] & 0xFF) | ((payload[1] & 0xFF) << 8);
+    return;
+  }
+
   if (cmd == CMD_GNG_NODES) {
     if (len < 2) return;
 
@@ -389,6 +486,143 @@ void handleFrame(int cmd, byte[] payload, int len) {
 
     lastFrameEdges = frameId;
     lastRX = "EDGES frame=" + frameId + " e=" + edgeCount;
+
+    // NODES + EDGES of one frame = keyframe
+    streamSynced = (lastFrameNodes == frameId);
+    lastAppliedFrame = frameId;
+  }
+
+  else if (cmd == CMD_GNG_DELTA) {
+    if (len < 4) return;
+
+    int frameId = payload[0] & 0xFF;
+    int nUpd    = payload[1] & 0xFF;
+    int nAdd    = payload[2] & 0xFF;
+    int nRem    = payload[3] & 0xFF;
+    if (len < 4 + nUpd*5 + (nAdd + nRem)*2) return;
+
+    if (!streamSynced || frameId != ((lastAppliedFrame + 1) & 0xFF)) {
+      // lost a frame: keep the old picture until the next keyframe
+      streamSynced = false;
+      deltasDropped++;
+      lastRX = "DELTA frame=" + frameId + " dropped (waiting keyframe)";
+      return;
+    }
+
+    int pos = 4;
+    for (int u = 0; u < nUpd; u++) {
+      int id = payload[pos++] & 0xFF;
+      int xi = (payload[pos++] & 0xFF) | ((payload[pos++] & 0xFF) << 8);
+      int yi = (payload[pos++] & 0xFF) | ((payload[pos++] & 0xFF) << 8);
+      if (xi >= 32768) xi -= 65536;
+      if (yi >= 32768) yi -= 65536;
+      boolean removed = (id & 0x80) != 0;
+      id &= 0x7F;
+      if (id >= MAX_NODES) continue;
+      nodes[id].active = !removed;
+      nodes[id].x = xi / 1000.0;
+      nodes[id].y = yi / 1000.0;
+    }
+    for (int e = 0; e < nAdd + nRem; e++) {
+      int a = payload[pos++] & 0xFF;
+      int b = payload[pos++] & 0xFF;
+      if (a >= MAX_NODES || b >= MAX_NODES || a == b) continue;
+      adj[a][b] = adj[b][a] = (e < nAdd);
+    }
+    rebuildEdgesFromAdj();
+
+    gngNodeCount = 0;
+    for (int i = 0; i < MAX_NODES; i++) if (nodes[i].active) gngNodeCount++;
+    gngEdgeCount = edgesN;
+
+    lastAppliedFrame = frameId;
+    lastFrameNodes = frameId;
+    lastFrameEdges = frameId;
+    lastRX = "DELTA frame=" + frameId + " n=" + nUpd + " +" + nAdd + " -" + nRem;
+  }
+
+  else if (cmd == CMD_GNG_EDGES_CHUNK) {
+    if (len < 7) return;
+
+    int frameId = payload[0] & 0xFF;
+    boolean id16 = (payload[1] & 0x01) != 0;
+    int chunk   = payload[2] & 0xFF;
+    int nChunks = payload[3] & 0xFF;
+    int total   = (payload[4] & 0xFF) | ((payload[5] & 0xFF) << 8);
+    int count   = payload[6] & 0xFF;
+    int pairLen = id16 ? 4 : 2;
+    if (len < 7 + count*pairLen) return;
+
+    if (chunk == 0) {
+      for (int i = 0; i < MAX_NODES; i++) Arrays.fill(chunkAdj[i], false);
+      chunkFrame = frameId;
+      chunkNext  = 0;
+      chunkGot   = 0;
+    }
+    if (frameId != chunkFrame || chunk != chunkNext) {
+      // lost a chunk: drop the set, EDGES/keyframe of a later frame resyncs
+      chunkFrame = -1;
+      lastRX = "EDGES_CHUNK frame=" + frameId + " chunk=" + chunk + " dropped";
+      return;
+    }
+
+    int pos = 7;
+    for (int e = 0; e < count; e++) {
+      int a = payload[pos++] & 0xFF;
+      if (id16) a |= (payload[pos++] & 0xFF) << 8;
+      int b = payload[pos++] & 0xFF;
+      if (id16) b |= (payload[pos++] & 0xFF) << 8;
+      chunkGot++;
+      if (a >= MAX_NODES || b >= MAX_NODES || a == b) continue;
+      chunkAdj[a][b] = chunkAdj[b][a] = true;
+    }
+    chunkNext++;
+    lastRX = "EDGES_CHUNK frame=" + frameId + " " + chunkNext + "/" + nChunks;
+
+    if (chunkNext < nChunks) return;
+    chunkFrame = -1;
+    if (chunkGot != total) return;
+
+    for (int i = 0; i < MAX_NODES; i++) arrayCopy(chunkAdj[i], adj[i]);
+    rebuildEdgesFromAdj();
+    gngEdgeCount = total;
+
+    lastFrameEdges = frameId;
+    lastRX = "EDGES frame=" + frameId + " e=" + total + " (" + nChunks + " chunks)";
+
+    // same as CMD_GNG_EDGES: NODES + all chunks of one frame = keyframe
+    streamSynced = (lastFrameNodes == frameId);
+    lastAppliedFrame = frameId;
+  }
+
+  else if (cmd == CMD_GNG_EDGES_BITMAP) {
+    if (len < 3) return;
+
+    int frameId = payload[0] & 0xFF;
+    int n       = payload[1] & 0xFF;
+    boolean gapCoded = (payload[2] & 1) != 0;
+
+    for (int i = 0; i < MAX_NODES; i++) Arrays.fill(adj[i], false);
+
+    // bit k walks the half matrix in edge_index_ij order: (0,1) (0,2) .. (1,2) ..
+    int a = 0, b = 1, k = 0, total = 0;
+    for (int pos = 3; pos < len && a < n - 1; pos++) {
+      int v = payload[pos] & 0xFF;
+      int bits = gapCoded ? ((v == 255) ? 255 : v + 1) : 8;
+      for (int t = 0; t < bits && a < n - 1; t++, k++) {
+        boolean set = gapCoded ? (v != 255 && t == bits - 1) : (((v >> t) & 1) != 0);
+        if (set && a < MAX_NODES && b < MAX_NODES) { adj[a][b] = adj[b][a] = true; total++; }
+        if (++b >= n) { a++; b = a + 1; }
+      }
+    }
+    rebuildEdgesFromAdj();
+    gngEdgeCount = total;
+
+    lastFrameEdges = frameId;
+    lastRX = "EDGES frame=" + frameId + " e=" + total + (gapCoded ? " (gap)" : " (bitmap)");
+
+    streamSynced = (lastFrameNodes == frameId);
+    lastAppliedFrame = frameId;
   }
 
   else if (cmd == CMD_PROF) {
@@ -407,6 +641,11 @@ void handleFrame(int cmd, byte[] payload, int len) {
     prof.cyc_insert  = rdU32LE(payload, pos); pos += 4;
     prof.cyc_renorm  = rdU32LE(payload, pos); pos += 4;
     prof.stepCount   = rdU32LE(payload, pos); pos += 4;
+    prof.cyc_overlap = (len >= pos + 4) ? rdU32LE(payload, pos) : 0; pos += 4;
+    prof.misa        = (len >= pos + 4) ? rdU32LE(payload, pos) : 0; pos += 4;
+    prof.mxisa       = (len >= pos + 4) ? rdU32LE(payload, pos) : 0; pos += 4;
+    prof.tx_stall    = (len >= pos + 4) ? rdU32LE(payload, pos) : 0; pos += 4;
+    prof.smp_dropped = (len >= pos + 4) ? rdU32LE(payload, pos) : 0;
 
     lastFrameProf = frameId;
     lastRX = "PROF frame=" + frameId + " cyc_total=" + prof.cyc_total;
@@ -415,6 +654,25 @@ void handleFrame(int cmd, byte[] payload, int len) {
   }
 }
 
+void rebuildEdgesFromAdj() {
+  edgesN = 0;
+  for (int i = 0; i < MAX_NODES; i++) deg[i] = 0;
+  for (int a = 0; a < MAX_NODES; a++) {
+    for (int b = a + 1; b < MAX_NODES; b++) {
+      if (!adj[a][b]) continue;
+      deg[a]++;
+      deg[b]++;
+      if (edgesN < edges.length) {
+        if (edges[edgesN] == null) edges[edgesN] = new Edge();
+        edges[edgesN].a = a;
+        edges[edgesN].b = b;
+        edges[edgesN].active = true;
+        edgesN++;
+      }
+    }
+  }
+}
+
 int rdU32LE(byte[] p, int off) {
   return (p[off] & 0xFF) |
          ((p[off+1] & 0xFF) << 8) |
@@ -803,7 +1061,9 @@ void drawDebugPanel() {
 
   Metrics m = computeMetrics();
   text("Nodes=" + m.nodeActive + "  Edges=" + m.edgeCount + "  Isolated=" + m.isolated + "  AvgDeg=" + nf(m.avgDegree,1,4), 12, y0 + 96);
-  text("PROF: frame=" + lastCompleteFrame + " cyc_total=" + prof.cyc_total + " (~" + nf(usTotal,1,3) + " us)  winner=" + prof.cyc_winner + "  nb=" + prof.cyc_nb + "  insert=" + prof.cyc_insert, 12, y0 + 116);
+  text("PROF: frame=" + lastCompleteFrame + " cyc_total=" + prof.cyc_total + " (~" + nf(usTotal,1,3) + " us)  winner=" + prof.cyc_winner + "  nb=" + prof.cyc_nb + "  insert=" + prof.cyc_insert
+       + "  M=" + ((prof.misa >> 12) & 1) + " mxisa=" + hex(prof.mxisa)
+       + "  tx_stall=" + prof.tx_stall + "  smp_dropped=" + prof.smp_dropped, 12, y0 + 116);
 }
 
 // ===============================
@@ -0,0 +1,61 @@
+#!/usr/bin/env bash
+
+set -e
+
+# Cycle-count testbench of the V3 CFS winner finder (GHDL, or NVC with
+# SIM=nvc): s1 / s2 / min1 / min2 against the reference scan, single shot
+# (IRQ) and batch cycles, once per LANES and COARSE setting (coarse pass
+# off and at 16 lanes by default), with CTX = 2 node_mem banks (the second
+# one searched with the set mirrored).
+#
+# Usage:   sh run.sh [dataset] [lanes...]
+# Example: SIM=nvc MAXNODES=64 sh run.sh circles 1 2 4 8
+#          COARSE="0 8" sh run.sh circles 1 2   (coarse pass, 0 = off)
+#          MOVE=true sh run.sh circles 4     (s1 / neighbor move unit)
+#          CLK_ASYNC=true sh run.sh circles 1 4         (engine on its own clock)
+#          CTX=8 sh run.sh circles 4                    (node_mem banks, 1..8)
+#          MOVE=true DUMP=true sh run.sh circles 4      (snapshot framer, edges with MOVE)
+#
+# Not run yet: no GHDL / NVC result exists for these benches.
+
+HERE="$(cd "$(dirname "$0")" && pwd)"
+SRC="$HERE/../gng_gowin_project/src"
+HOST="$HERE/../../gng_host"
+DATASET="${1:-circles}"
+if [ $# -gt 0 ]; then shift; fi
+LANES="${*:-1 2 4 8}"
+MAXNODES="${MAXNODES:-40}"
+COARSE="${COARSE:-0 16}"
+MOVE="${MOVE:-false}"
+DUMP="${DUMP:-false}"
+CLK_ASYNC="${CLK_ASYNC:-false}"
+CTX="${CTX:-2}"
+SIM="${SIM:-ghdl}"
+WORK="$HERE/build"
+
+# vectors need gng_host's numpy, the benches GHDL or NVC on PATH
+command -v "$SIM" >/dev/null || { echo "run.sh: $SIM not found (SIM=ghdl or SIM=nvc)" >&2; exit 1; }
+python3 -c "import numpy" 2>/dev/null || { echo "run.sh: gngio needs numpy (pip install numpy)" >&2; exit 1; }
+
+mkdir -p "$WORK"
+cd "$WORK"
+
+(cd "$HOST" && python3 -m gngio tb vectors v3 "$WORK/winner_v3.txt" --dataset "$DATASET" --max-nodes "$MAXNODES")
+
+LIB="$SRC/neorv32_package.vhd $SRC/neorv32_cfs_engine.vhd $SRC/neorv32_cfs.vhd"
+
+if [ "$SIM" = "nvc" ]
+then
+  nvc --std=2008 --work=neorv32 -a $LIB
+  nvc --std=2008 -L . -a "$HERE/tb_neorv32_cfs.vhd"
+  for c in $COARSE; do for l in $LANES; do
+    nvc --std=2008 -L . -e -gLANES="$l" -gMAXNODES="$MAXNODES" -gCTX="$CTX" -gCOARSE="$c" -gMOVE="$MOVE" -gDUMP="$DUMP" -gCLK_ASYNC="$CLK_ASYNC" -gVECTORS=winner_v3.txt tb_neorv32_cfs -r
+  done; done
+else
+  ghdl -a --std=08 --work=neorv32 $LIB
+  ghdl -a --std=08 "$HERE/tb_neorv32_cfs.vhd"
+  ghdl -e --std=08 tb_neorv32_cfs
+  for c in $COARSE; do for l in $LANES; do
+    ghdl -r --std=08 tb_neorv32_cfs -gLANES="$l" -gMAXNODES="$MAXNODES" -gCTX="$CTX" -gCOARSE="$c" -gMOVE="$MOVE" -gDUMP="$DUMP" -gCLK_ASYNC="$CLK_ASYNC" -gVECTORS=winner_v3.txt
+  done; done
+fi
@@ -0,0 +1,673 @@
+-- ============================================================================
+-- tb_neorv32_cfs.vhd - self-checking bench for the CFS winner finder
+--
+-- Drives neorv32_cfs.vhd through its bus port the way fw/main.c does and
+-- checks every search against the vector file of
+-- "python -m gngio tb vectors v3" (format in gng_host/gngio/tb.py):
+--   - N record: NODE_COUNT, the ACT words at ACT_BASE + w and the nodes at
+--     NODE_BASE + i (DIM = 2, Q1.15 x | y << 16)
+--   - single shot: XIN / YIN, CTRL = START | IRQ_EN, wait for irq_o, read
+--     OUT_S12 / OUT_MIN1 / OUT_MIN2; the XIN / YIN of sample k+1 are
+--     written while sample k is searched (input double buffer)
+--   - batch: the same samples again through SMP_PUSH in runs of <= 32,
+--     CTRL = BATCH, poll REG_BATCH until the RES level holds the run,
+--     CTRL = CLEAR, then RES_S12 + RES_MIN1 (pop) per result
+-- s1 / min1 are compared when the set has an active node, s2 / min2 when it
+-- has two. Prints cycles per search (CTRL write -> irq_o) min / mean / max
+-- and batch cycles per sample; fails with severity failure on a mismatch.
+-- At the end the perf counters (24..31) are frozen and read: PERF_START must
+-- equal the searches run, PERF_SMP the batch samples pushed.
+-- With CLK_ASYNC = true the engine runs on its own clock (CFS_PERIOD, not a
+-- multiple of the bus clock), so every search, batch run and the result
+-- ring go through the START / ack toggles and the Gray pointers; INFO must
+-- read back MAXNODES, LANES and the CLK_ASYNC bit. Cycles stay clk_i cycles.
+-- With CTX > 1 every N record also goes into bank CTX-1 (REG_CTX) mirrored,
+-- 32767 - v per component, and after the single shots the same samples,
+-- mirrored, are searched in that bank: the distances are those of bank 0,
+-- so the expected s1 / s2 / min1 / min2 hold as they are. Everything else
+-- runs in bank 0, which must not see the writes to the other one.
+-- With MOVE = true every set with two usable nodes ends with one START |
+-- MOVE of its first sample, every other active node written as a neighbor
+-- of its s1 and EPS_N = 0.25; the node window must then hold s1 moved by
+-- EPS_B and the neighbors by EPS_N (pos_step of GNG_POS16), the rest as is,
+-- and a search of the last sample must then give the s1 / s2 / min1 / min2
+-- of a scan over the moved positions (node_mem banks and coarse_mem were
+-- both written by the unit).
+-- With DUMP = true every N record is dumped (REG_DUMP START, REG_DUMP_DIV =
+-- DUMP_DIV clocks per bit): a UART receiver on uart_txd_o collects the
+-- bytes, which must be the CMD_GNG_NODES frame of the active nodes (ids
+-- ascending, at most 50, (q15 * 1000) >> 15 wire units) and, with MOVE,
+-- the i < j pairs of the rows written before (j = i+1..i+4, both active)
+-- as one CMD_GNG_EDGES frame or CMD_GNG_EDGES_CHUNK frames of 124, capped
+-- at the 512 of pair_mem with the overflow bit; each with the firmware
+-- checksum. REG_DUMP must then read back the node / pair counts and
+-- uart_ctsn_o must have held UART0 while the framer ran.
+--
+--   ghdl -r --std=08 tb_neorv32_cfs -gLANES=4 -gVECTORS=winner_v3.txt
+--   ghdl -r --std=08 tb_neorv32_cfs -gLANES=1 -gCOARSE=16      (coarse pass)
+--   ghdl -r --std=08 tb_neorv32_cfs -gMOVE=true                 (move unit)
+--   ghdl -r --std=08 tb_neorv32_cfs -gCLK_ASYNC=true            (engine clock domain)
+--   ghdl -r --std=08 tb_neorv32_cfs -gCTX=2                     (node_mem banks)
+--   ghdl -r --std=08 tb_neorv32_cfs -gMOVE=true -gDUMP=true     (snapshot framer)
+-- ============================================================================
+
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library std;
+use std.textio.all;
+
+library neorv32;
+use neorv32.neorv32_package.all;
+
+entity tb_neorv32_cfs is
+  generic (
+    LANES     : natural := 4;
+    MAXNODES  : natural := 40;
+    CTX       : natural := 1;
+    COARSE    : natural := 0;
+    MOVE      : boolean := false;
+    DUMP      : boolean := false;
+    CLK_ASYNC : boolean := false;
+    VECTORS   : string  := "winner_v3.txt"
+  );
+end entity;
+
+architecture sim of tb_neorv32_cfs is
+
+  constant CLK_PERIOD : time := 37 ns;  -- 27 MHz
+  constant CFS_PERIOD : time := 13 ns;  -- ~77 MHz engine clock (CLK_ASYNC)
+
+  -- register word indices (neorv32_cfs.vhd)
+  constant REG_CTRL       : natural := 0;
+  constant REG_EPS_B      : natural := 4;
+  constant REG_EPS_N      : natural := 5;
+  constant REG_XIN        : natural := 8;
+  constant REG_YIN        : natural := 9;
+  constant REG_NODE_COUNT : natural := 10;
+  constant REG_OUT_S12    : natural := 13;
+  constant REG_OUT_MIN1   : natural := 14;
+  constant REG_OUT_MIN2   : natural := 15;
+  constant REG_SMP_PUSH   : natural := 16;
+  constant REG_BATCH      : natural := 17;
+  constant REG_RES_S12    : natural := 18;
+  constant REG_RES_MIN1   : natural := 19;
+  constant REG_INFO       : natural := 20;
+  constant REG_CTX        : natural := 21;
+  constant REG_DUMP       : natural := 23;
+  constant REG_PERF_CTRL  : natural := 24;
+  constant REG_PERF_BASE  : natural := 25;
+  constant REG_DUMP_DIV   : natural := 32;
+  constant REG_ACT_BASE   : natural := 64;
+  constant NODE_BASE      : natural := 128;
+  constant ADJ_BASE       : natural := 8192;
+
+  constant CTRL_CLEAR  : natural := 16#01#;
+  constant CTRL_START  : natural := 16#02#;
+  constant CTRL_IRQ_EN : natural := 16#04#;
+  constant CTRL_BATCH  : natural := 16#08#;
+  constant CTRL_MOVE   : natural := 16#40#;
+  constant PERF_FREEZE : natural := 16#02#;
+  constant DUMP_START  : natural := 16#100#;
+  constant DUMP_EDGES  : natural := 16#200#;
+
+  constant SMP_DEPTH : natural := 32;
+  constant ACT_WORDS : natural := (MAXNODES + 31) / 32;
+  constant EPS_B     : natural := 19661; -- CFS reset value (0.3)
+  constant EPS_N_MV  : natural := 16384; -- 0.25, so every neighbor moves
+  constant DUMP_DIV  : natural := 8;     -- clk_i cycles per dump bit
+  constant DP_PAIRS  : natural := 512;   -- pair_mem entries
+
+  -- p + ((eps * (t - p) + 32768) >> 16), >> rounding down
+  function pos_step(p, t, eps : integer) return integer is
+    variable m : integer;
+  begin
+    m := eps * (t - p) + 32768;
+    return (p + (m - (m mod 65536)) / 65536) mod 65536;
+  end function;
+
+  signal clk     : std_ulogic := '0';
+  signal clk_cfs : std_ulogic := '0';
+  signal rstn    : std_ulogic := '0';
+  signal running : boolean := true;
+  signal req     : bus_req_t := req_terminate_c;
+  signal rsp     : bus_rsp_t;
+  signal irq     : std_ulogic;
+  signal txd     : std_ulogic;
+  signal ctsn    : std_ulogic;
+
+  -- bytes received on uart_txd_o
+  type bytes_t is array (0 to 4095) of std_ulogic_vector(7 downto 0);
+  signal rx_buf  : bytes_t;
+  signal rx_n    : natural := 0;
+  signal rx_ferr : natural := 0;
+
+begin
+
+  clk <= not clk after CLK_PERIOD / 2 when running else '0';
+  clk_cfs <= not clk_cfs after CFS_PERIOD / 2 when running and CLK_ASYNC else '0';
+
+  dut : entity neorv32.neorv32_cfs
+    generic map (LANES => LANES, MAXNODES => MAXNODES, CTX => CTX, COARSE => COARSE, MOVE => MOVE,
+                 DUMP => DUMP, CLK_ASYNC => CLK_ASYNC)
+    port map (
+      clk_i => clk, clk_cfs_i => clk_cfs, rstn_i => rstn,
+      bus_req_i => req, bus_rsp_o => rsp,
+      irq_o => irq, clk_en_o => open,
+      uart_txd_i => '1', uart_txd_o => txd, uart_ctsn_o => ctsn
+    );
+
+  -- 8N1 receiver at DUMP_DIV clocks per bit, sampled mid-bit
+  rx : process
+    variable b : std_ulogic_vector(7 downto 0);
+  begin
+    wait until falling_edge(txd);
+    for t in 1 to DUMP_DIV / 2 loop
+      wait until rising_edge(clk);
+    end loop;
+    for i in 0 to 7 loop
+      for t in 1 to DUMP_DIV loop
+        wait until rising_edge(clk);
+      end loop;
+      b(i) := txd;
+    end loop;
+    for t in 1 to DUMP_DIV loop
+      wait until rising_edge(clk);
+    end loop;
+    if txd /= '1' then
+      rx_ferr <= rx_ferr + 1;
+    end if;
+    rx_buf(rx_n mod 4096) <= b;
+    rx_n <= rx_n + 1;
+  end process;
+
+  stim : process
+    type smp_t is array (0 to 1023) of integer;
+    file     f : text;
+    variable l, o : line;
+    variable c    : character;
+    variable n, m : integer;
+    variable vx, vy, va : integer;
+    variable sx, sy, e1, e2 : smp_t;
+    variable nx, ny : smp_t;
+    variable ex, ey, eps : integer;
+    variable mact : std_ulogic_vector(32*ACT_WORDS-1 downto 0);
+    variable mvcyc, moves, msearches, csearches : natural := 0;
+    variable rs1, rs2, rd1, rd2, dd : integer;
+    variable w1, w2 : unsigned(31 downto 0);
+    type umem_t is array (0 to 1023) of unsigned(31 downto 0);
+    variable d1s, d2s : umem_t;
+    variable count, usable : natural;
+    variable act  : std_ulogic_vector(32*ACT_WORDS-1 downto 0);
+    variable rd, s12 : std_ulogic_vector(31 downto 0);
+    variable cyc, cmin, cmax, total, searches : natural := 0;
+    variable bcyc, bsamples : natural := 0;
+    variable errors : natural := 0;
+    variable k0, run : natural;
+    variable p_start, p_smp, p_busy, p_idle, p_bus, p_stall : natural;
+    variable pa, pb : smp_t;
+    variable np, nd, nch, rp, rb, csum, derr, dumps : natural := 0;
+
+    procedure bus_write(reg : natural; data : std_ulogic_vector(31 downto 0)) is
+    begin
+      req.addr <= std_ulogic_vector(to_unsigned(reg * 4, 32));
+      req.data <= data;
+      req.ben  <= "1111";
+      req.rw   <= '1';
+      req.stb  <= '1';
+      wait until rising_edge(clk);
+      req.stb  <= '0';
+      wait until rising_edge(clk) and rsp.ack = '1';
+    end procedure;
+
+    procedure bus_write(reg : natural; data : natural) is
+    begin
+      bus_write(reg, std_ulogic_vector(to_unsigned(data, 32)));
+    end procedure;
+
+    procedure bus_read(reg : natural; data : out std_ulogic_vector(31 downto 0)) is
+    begin
+      req.addr <= std_ulogic_vector(to_unsigned(reg * 4, 32));
+      req.ben  <= "1111";
+      req.rw   <= '0';
+      req.stb  <= '1';
+      wait until rising_edge(clk);
+      req.stb  <= '0';
+      wait until rising_edge(clk) and rsp.ack = '1';
+      data := rsp.data;
+    end procedure;
+
+    procedure check(k : natural; s1, s2 : natural; d1, d2 : unsigned(31 downto 0);
+                    with_d2 : boolean; what : string) is
+    begin
+      if (usable >= 1 and s1 /= e1(k)) or d1 /= d1s(k) or
+         (usable >= 2 and (s2 /= e2(k) or (with_d2 and d2 /= d2s(k)))) then
+        errors := errors + 1;
+        report what & " sample (" & integer'image(sx(k)) & ", " & integer'image(sy(k))
+               & "): s1/s2/min1 " & integer'image(s1) & "/" & integer'image(s2) & "/"
+               & to_hstring(d1) & ", want " & integer'image(e1(k)) & "/"
+               & integer'image(e2(k)) & "/" & to_hstring(d1s(k)) severity error;
+      end if;
+    end procedure;
+
+    -- next received byte = v (first mismatch of a dump reported)
+    procedure expect(v : natural; what : string) is
+    begin
+      if (rp >= rx_n) or (to_integer(unsigned(rx_buf(rp mod 4096))) /= v mod 256) then
+        if derr = 0 then
+          report "dump " & integer'image(dumps) & ": byte " & integer'image(rp - rb) & " (" & what
+                 & "), want " & integer'image(v mod 256) severity error;
+        end if;
+        derr := derr + 1;
+      end if;
+      csum := csum + v mod 256;
+      rp := rp + 1;
+    end procedure;
+
+    procedure expect_head(cmd, len : natural) is
+    begin
+      expect(16#FF#, "sync");
+      expect(16#FF#, "sync");
+      csum := 0;
+      expect(cmd, "cmd");
+      expect(len, "len");
+    end procedure;
+
+    procedure expect_chk is
+    begin
+      expect(255 - csum mod 256, "checksum");
+    end procedure;
+
+  begin
+    cmin := natural'high;
+    rstn <= '0';
+    wait for 5 * CLK_PERIOD;
+    wait until rising_edge(clk);
+    rstn <= '1';
+    wait until rising_edge(clk);
+
+    bus_read(REG_INFO, rd);
+    if (to_integer(unsigned(rd(15 downto 0))) /= MAXNODES) or (to_integer(unsigned(rd(23 downto 16))) /= LANES) or
+       ((rd(24) = '1') /= CLK_ASYNC) or (to_integer(unsigned(rd(31 downto 28))) /= CTX) then
+      errors := errors + 1;
+      report "info: " & to_hstring(rd) & ", want MAXNODES / LANES / CLK_ASYNC / CTX " & integer'image(MAXNODES)
+             & " / " & integer'image(LANES) & " / " & boolean'image(CLK_ASYNC) & " / " & integer'image(CTX)
+             severity error;
+    end if;
+
+    file_open(f, VECTORS, read_mode);
+    while not endfile(f) loop
+      readline(f, l);
+      next when l'length = 0;
+      read(l, c);
+      if c = 'N' then
+        read(l, n);
+        read(l, m);
+        assert m = MAXNODES
+          report "vector file is for MAX_NODES=" & integer'image(m) severity failure;
+        count  := n;
+        usable := 0;
+        act    := (others => '0');
+        for i in 0 to m - 1 loop
+          readline(f, l);
+          read(l, vx);
+          read(l, vy);
+          read(l, va);
+          nx(i) := vx;
+          ny(i) := vy;
+          bus_write(NODE_BASE + i, std_ulogic_vector(to_unsigned(vy, 16)) & std_ulogic_vector(to_unsigned(vx, 16)));
+          if va /= 0 then
+            act(i) := '1';
+            if i < n then
+              usable := usable + 1;
+            end if;
+          end if;
+        end loop;
+        for w in 0 to ACT_WORDS-1 loop
+          bus_write(REG_ACT_BASE + w, act(32*w+31 downto 32*w));
+        end loop;
+        bus_write(REG_NODE_COUNT, count);
+        if CTX > 1 then
+          bus_write(REG_CTX, CTX-1);
+          for i in 0 to m - 1 loop
+            bus_write(NODE_BASE + i, std_ulogic_vector(to_unsigned(32767 - ny(i), 16))
+                                     & std_ulogic_vector(to_unsigned(32767 - nx(i), 16)));
+          end loop;
+          bus_write(REG_CTX, 0);
+        end if;
+
+        -- snapshot dump of the set off the UART pin
+        if DUMP then
+          np := 0;
+          if MOVE then
+            for i in 0 to MAXNODES-1 loop
+              mact := (others => '0');
+              for j in 0 to MAXNODES-1 loop
+                if (act(i) = '1') and (act(j) = '1') and (j /= i) and (abs (j - i) <= 4) then
+                  mact(j) := '1';
+                  if (j > i) and (np < DP_PAIRS) then
+                    pa(np) := i;
+                    pb(np) := j;
+                    np := np + 1;
+                  elsif j > i then
+                    np := DP_PAIRS + 1;  -- overflow, the first DP_PAIRS are sent
+                  end if;
+                end if;
+              end loop;
+              for w in 0 to ACT_WORDS-1 loop
+                bus_write(ADJ_BASE + i * 8 + w, mact(32*w+31 downto 32*w));
+              end loop;
+            end loop;
+          end if;
+          bus_write(REG_DUMP_DIV, DUMP_DIV);
+          dumps := dumps + 1;
+          rp    := rx_n;
+          rb    := rp;
+          derr  := 0;
+          if MOVE then
+            bus_write(REG_DUMP, DUMP_START + DUMP_EDGES + dumps mod 256);
+          else
+            bus_write(REG_DUMP, DUMP_START + dumps mod 256);
+          end if;
+          if ctsn /= '1' then
+            errors := errors + 1;
+            report "dump: uart_ctsn_o low after START" severity error;
+          end if;
+          loop
+            bus_read(REG_DUMP, rd);
+            exit when rd(0) = '0';
+          end loop;
+          if ctsn /= '0' then
+            errors := errors + 1;
+            report "dump: uart_ctsn_o still high after the dump" severity error;
+          end if;
+
+          nd := 0;
+          for i in 0 to MAXNODES-1 loop
+            if act(i) = '1' then nd := nd + 1; end if;
+          end loop;
+          if nd > 50 then nd := 50; end if;
+          expect_head(16#10#, 2 + 5 * nd);
+          expect(dumps, "fid");
+          expect(nd, "n");
+          vx := 0;
+          for i in 0 to MAXNODES-1 loop
+            if (act(i) = '1') and (vx < nd) then
+              expect(i, "node id");
+              expect((nx(i) * 1000 / 32768) mod 256, "x lo");
+              expect((nx(i) * 1000 / 32768) / 256, "x hi");
+              expect((ny(i) * 1000 / 32768) mod 256, "y lo");
+              expect((ny(i) * 1000 / 32768) / 256, "y hi");
+              vx := vx + 1;
+            end if;
+          end loop;
+          expect_chk;
+          vy := np;                      -- pairs collected
+          if vy > DP_PAIRS then vy := DP_PAIRS; end if;
+          if MOVE and (vy <= 126) then
+            expect_head(16#11#, 2 + 2 * vy);
+            expect(dumps, "fid");
+            expect(vy, "n");
+            for k in 0 to vy - 1 loop
+              expect(pa(k), "pair a");
+              expect(pb(k), "pair b");
+            end loop;
+            expect_chk;
+          elsif MOVE then
+            nch := (vy + 123) / 124;
+            for ch in 0 to nch - 1 loop
+              n := vy - ch * 124;
+              if n > 124 then n := 124; end if;
+              expect_head(16#14#, 7 + 2 * n);
+              expect(dumps, "fid");
+              expect(0, "flags");
+              expect(ch, "chunk");
+              expect(nch, "n_chunks");
+              expect(vy mod 256, "total lo");
+              expect(vy / 256, "total hi");
+              expect(n, "n");
+              for k in ch * 124 to ch * 124 + n - 1 loop
+                expect(pa(k), "pair a");
+                expect(pb(k), "pair b");
+              end loop;
+              expect_chk;
+            end loop;
+          end if;
+          if rp /= rx_n then
+            derr := derr + 1;
+            report "dump " & integer'image(dumps) & ": " & integer'image(rx_n - rp)
+                   & " bytes more than the frames" severity error;
+          end if;
+          if (to_integer(unsigned(rd(15 downto 8))) /= nd) or (to_integer(unsigned(rd(31 downto 16))) /= vy) or
+             ((rd(2) = '1') /= (np > DP_PAIRS)) or (rd(1) /= '0') then
+            derr := derr + 1;
+            report "dump: REG_DUMP " & to_hstring(rd) & ", want nodes " & integer'image(nd)
+                   & " pairs " & integer'image(vy) severity error;
+          end if;
+          if derr /= 0 then
+            errors := errors + 1;
+          end if;
+        end if;
+
+      elsif c = 'S' then
+        read(l, m);
+        for k in 0 to m - 1 loop
+          readline(f, l);
+          read(l, sx(k));
+          read(l, sy(k));
+          read(l, e1(k));
+          read(l, e2(k));
+          read(l, vx);
+          read(l, vy);
+          d1s(k) := shift_left(to_unsigned(vx, 32), 16) + to_unsigned(vy, 32);
+          read(l, vx);
+          read(l, vy);
+          d2s(k) := shift_left(to_unsigned(vx, 32), 16) + to_unsigned(vy, 32);
+        end loop;
+
+        -- single shot, IRQ completion, next sample staged during the search
+        if m > 0 then
+          bus_write(REG_XIN, sx(0));
+          bus_write(REG_YIN, sy(0));
+        end if;
+        for k in 0 to m - 1 loop
+          bus_write(REG_CTRL, CTRL_START + CTRL_IRQ_EN);
+          cyc := 0;
+          if k + 1 < m then
+            bus_write(REG_XIN, sx(k + 1));
+            bus_write(REG_YIN, sy(k + 1));
+            cyc := 4;
+          end if;
+          while irq /= '1' loop
+            wait until rising_edge(clk);
+            cyc := cyc + 1;
+          end loop;
+          bus_read(REG_OUT_MIN1, rd);
+          w1 := unsigned(rd);
+          bus_read(REG_OUT_MIN2, rd);
+          w2 := unsigned(rd);
+          bus_read(REG_OUT_S12, rd);
+          check(k, to_integer(unsigned(rd(7 downto 0))), to_integer(unsigned(rd(15 downto 8))),
+                w1, w2, true, "single");
+          total    := total + cyc;
+          searches := searches + 1;
+          if cyc < cmin then cmin := cyc; end if;
+          if cyc > cmax then cmax := cyc; end if;
+        end loop;
+        bus_write(REG_CTRL, CTRL_CLEAR);
+
+        -- the mirrored set in bank CTX-1, same answers
+        if CTX > 1 then
+          bus_write(REG_CTX, CTX-1);
+          for k in 0 to m - 1 loop
+            bus_write(REG_XIN, 32767 - sx(k));
+            bus_write(REG_YIN, 32767 - sy(k));
+            bus_write(REG_CTRL, CTRL_START + CTRL_IRQ_EN);
+            while irq /= '1' loop
+              wait until rising_edge(clk);
+            end loop;
+            bus_read(REG_OUT_MIN1, rd);
+            w1 := unsigned(rd);
+            bus_read(REG_OUT_MIN2, rd);
+            w2 := unsigned(rd);
+            bus_read(REG_OUT_S12, rd);
+            check(k, to_integer(unsigned(rd(7 downto 0))), to_integer(unsigned(rd(15 downto 8))),
+                  w1, w2, true, "ctx " & integer'image(CTX-1) & " mirrored");
+            csearches := csearches + 1;
+          end loop;
+          bus_write(REG_CTRL, CTRL_CLEAR);
+          bus_write(REG_CTX, 0);
+        end if;
+
+        -- batch, runs of <= SMP_DEPTH
+        k0 := 0;
+        while k0 < m loop
+          run := m - k0;
+          if run > SMP_DEPTH then run := SMP_DEPTH; end if;
+          for k in k0 to k0 + run - 1 loop
+            bus_write(REG_SMP_PUSH, std_ulogic_vector(to_unsigned(sy(k), 16)) & std_ulogic_vector(to_unsigned(sx(k), 16)));
+          end loop;
+          bus_write(REG_CTRL, CTRL_BATCH);
+          cyc := 0;
+          loop
+            bus_read(REG_BATCH, rd);
+            cyc := cyc + 2;
+            exit when to_integer(unsigned(rd(13 downto 8))) >= run;
+          end loop;
+          bus_write(REG_CTRL, CTRL_CLEAR);
+          for k in k0 to k0 + run - 1 loop
+            bus_read(REG_RES_S12, s12);
+            bus_read(REG_RES_MIN1, rd);
+            w1 := unsigned(rd);
+            rd := s12;
+            check(k, to_integer(unsigned(rd(7 downto 0))), to_integer(unsigned(rd(15 downto 8))),
+                  w1, w1, false, "batch");
+          end loop;
+          bcyc     := bcyc + cyc;
+          bsamples := bsamples + run;
+          k0       := k0 + run;
+        end loop;
+
+        -- move unit: sample 0, every other active node a neighbor of its s1
+        if MOVE and (m > 0) and (usable >= 2) then
+          mact := act;
+          mact(e1(0)) := '0';
+          for w in 0 to ACT_WORDS-1 loop
+            bus_write(ADJ_BASE + e1(0) * 8 + w, mact(32*w+31 downto 32*w));
+          end loop;
+          bus_write(REG_EPS_N, EPS_N_MV);
+          bus_write(REG_XIN, sx(0));
+          bus_write(REG_YIN, sy(0));
+          bus_write(REG_CTRL, CTRL_START + CTRL_IRQ_EN + CTRL_MOVE);
+          cyc := 0;
+          while irq /= '1' loop
+            wait until rising_edge(clk);
+            cyc := cyc + 1;
+          end loop;
+          bus_write(REG_CTRL, CTRL_CLEAR);
+          mvcyc := mvcyc + cyc;
+          moves := moves + 1;
+          for i in 0 to MAXNODES-1 loop
+            ex := nx(i);
+            ey := ny(i);
+            if (i = e1(0)) or (mact(i) = '1') then
+              if i = e1(0) then eps := EPS_B; else eps := EPS_N_MV; end if;
+              ex := pos_step(nx(i), sx(0), eps);
+              ey := pos_step(ny(i), sy(0), eps);
+            end if;
+            bus_read(NODE_BASE + i, rd);
+            if (to_integer(unsigned(rd(15 downto 0))) /= ex) or (to_integer(unsigned(rd(31 downto 16))) /= ey) then
+              errors := errors + 1;
+              report "move: node " & integer'image(i) & " = " & to_hstring(rd) & ", want ("
+                     & integer'image(ex) & ", " & integer'image(ey) & ")" severity error;
+            end if;
+            nx(i) := ex;
+            ny(i) := ey;
+          end loop;
+
+          -- the next search must see the moved words (node_mem banks, coarse_mem)
+          rs1 := -1;
+          rs2 := -1;
+          for i in 0 to count-1 loop
+            if act(i) = '1' then
+              dd := (nx(i) - sx(m-1))**2 + (ny(i) - sy(m-1))**2;
+              if (rs1 < 0) or (dd < rd1) then
+                rs2 := rs1; rd2 := rd1;
+                rs1 := i;   rd1 := dd;
+              elsif (rs2 < 0) or (dd < rd2) then
+                rs2 := i;   rd2 := dd;
+              end if;
+            end if;
+          end loop;
+          bus_write(REG_XIN, sx(m-1));
+          bus_write(REG_YIN, sy(m-1));
+          bus_write(REG_CTRL, CTRL_START + CTRL_IRQ_EN);
+          while irq /= '1' loop
+            wait until rising_edge(clk);
+          end loop;
+          bus_write(REG_CTRL, CTRL_CLEAR);
+          msearches := msearches + 1;
+          bus_read(REG_OUT_MIN1, rd);
+          w1 := unsigned(rd);
+          bus_read(REG_OUT_MIN2, rd);
+          w2 := unsigned(rd);
+          bus_read(REG_OUT_S12, rd);
+          if (to_integer(unsigned(rd(7 downto 0))) /= rs1) or (w1 /= to_unsigned(rd1, 32)) or
+             (to_integer(unsigned(rd(15 downto 8))) /= rs2) or (w2 /= to_unsigned(rd2, 32)) then
+            errors := errors + 1;
+            report "move: search after the move s1/s2/min1 " & integer'image(to_integer(unsigned(rd(7 downto 0))))
+                   & "/" & integer'image(to_integer(unsigned(rd(15 downto 8)))) & "/" & to_hstring(w1)
+                   & ", want " & integer'image(rs1) & "/" & integer'image(rs2) & "/"
+                   & to_hstring(to_unsigned(rd1, 32)) severity error;
+          end if;
+        end if;
+      end if;
+    end loop;
+    file_close(f);
+
+    bus_write(REG_PERF_CTRL, PERF_FREEZE);
+    bus_read(REG_PERF_BASE + 0, rd); p_start := to_integer(unsigned(rd));
+    bus_read(REG_PERF_BASE + 1, rd); p_smp   := to_integer(unsigned(rd));
+    bus_read(REG_PERF_BASE + 2, rd); p_busy  := to_integer(unsigned(rd));
+    bus_read(REG_PERF_BASE + 3, rd); p_idle  := to_integer(unsigned(rd));
+    bus_read(REG_PERF_BASE + 5, rd); p_bus   := to_integer(unsigned(rd));
+    bus_read(REG_PERF_BASE + 6, rd); p_stall := to_integer(unsigned(rd));
+    if p_start /= searches + csearches + moves + msearches or p_smp /= bsamples then
+      errors := errors + 1;
+      report "perf: START/SMP " & integer'image(p_start) & "/" & integer'image(p_smp)
+             & ", want " & integer'image(searches + csearches + moves + msearches) & "/"
+             & integer'image(bsamples) severity error;
+    end if;
+
+    write(o, string'("neorv32_cfs LANES=") & integer'image(LANES) & " COARSE="
+             & integer'image(COARSE) & " MAXNODES=" & integer'image(MAXNODES) & " CTX=" & integer'image(CTX)
+             & " CLK_ASYNC=" & boolean'image(CLK_ASYNC) & ": " & integer'image(searches)
+             & " searches, cycles min/mean/max " & integer'image(cmin) & "/"
+             & integer'image(total / maximum(searches, 1)) & "/" & integer'image(cmax)
+             & ", batch " & integer'image(bcyc / maximum(bsamples, 1)) & " cycles/sample, "
+             & integer'image(errors) & " errors");
+    writeline(output, o);
+    write(o, string'("  perf: busy ") & integer'image(p_busy) & " idle " & integer'image(p_idle)
+             & " bus " & integer'image(p_bus) & " stall " & integer'image(p_stall));
+    writeline(output, o);
+    if MOVE then
+      write(o, string'("  move: ") & integer'image(moves) & " START | MOVE, "
+               & integer'image(mvcyc / maximum(moves, 1)) & " cycles mean (search + move)");
+      writeline(output, o);
+    end if;
+    if DUMP then
+      if rx_ferr /= 0 then
+        errors := errors + 1;
+        report "dump: " & integer'image(rx_ferr) & " bytes without a stop bit" severity error;
+      end if;
+      write(o, string'("  dump: ") & integer'image(dumps) & " keyframes, " & integer'image(rx_n)
+               & " bytes at " & integer'image(DUMP_DIV) & " clocks/bit");
+      writeline(output, o);
+    end if;
+    assert errors = 0 report "neorv32_cfs: mismatches" severity failure;
+    running <= false;
+    wait;
+  end process;
+
+end architecture;
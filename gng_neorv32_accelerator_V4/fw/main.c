@@ -0,0 +1,445 @@
+// ================================================================================
+// NEORV32 main.c - GNG Fritzke (V4: CFS does the full GNG step)
+// CPU ONLY does: UART RX of the dataset, sample feeding, snapshot streaming
+//
+// CFS (gng_core, V2 datapath):
+//   - sample FIFO: CPU pushes packed Q1.15 (x | y<<16) into REG_SAMPLE
+//   - per sample: winner, move s1 + neighbors, age/prune edges, connect s1-s2,
+//     insert every LAMBDA, error decay -- all in fabric
+//   - node/edge BRAMs are readable through the CFS window while PARKED
+//
+// DATASET (PACKED Q1.15 AT RX TIME):
+//   - CMD_DATA_BATCH int16 (value*1000) converted once into dataQ[]
+//   - feeding a sample is a single bus write, no per-step float work
+//
+// SNAPSHOT (EVERY STREAM_EVERY_N HW STEPS):
+//   - CTRL.RUN=0 -> core finishes the current iteration and parks
+//   - read node window + edge window, send CMD_GNG_NODES / CMD_GNG_EDGES
+//   - CTRL.RUN=1 -> resume (FIFO content is kept)
+//
+// STREAMING COMPATIBILITY (KEEP OLD PROCESSING FORMAT):
+//   CMD_GNG_NODES / CMD_GNG_EDGES identical to V3
+//   CMD_PROF: cyc_total = clocks of the last hardware iteration; winner,
+//   move_w, nb, connect and insert = mean clocks per step since the last
+//   snapshot from the CFS PERF_PH counters (0 on bitstreams without them),
+//   delete / prune run inside the neighbor pass, renorm does not exist
+// ================================================================================
+
+#include <neorv32.h>
+#include <neorv32_cfs.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define BAUD_RATE 1000000
+
+// ---------------- Limits (must match neorv32_cfs.vhd MAXNODES) ----------------
+#define MAXPTS        100
+#define MAX_NODES      40
+#define MAX_EDGES_FULL ((MAX_NODES * (MAX_NODES - 1)) / 2)
+
+// ---------------- CPU clock (for Processing conversion) ----------------
+#define CPU_HZ 27000000u
+
+// ---------------- UART protocol ----------------
+#define UART_HDR        0xFFu
+#define CMD_DATA_BATCH  0x01u
+#define CMD_DONE        0x02u
+#define CMD_RUN         0x03u
+#define CMD_GNG_NODES   0x10u
+#define CMD_GNG_EDGES   0x11u
+#define CMD_PROF        0x12u
+
+#define STREAM_EVERY_N  100  // stream every N hardware steps
+
+// Old edge streaming header = 2 bytes: [frame_id][count]
+// => 2 + 2*count <= 255 => count <= 126
+#define MAX_EDGE_PAIRS_PER_FRAME 126
+
+enum { RX_WAIT_H1=0, RX_WAIT_H2, RX_WAIT_CMD, RX_WAIT_LEN, RX_WAIT_PAYLOAD, RX_WAIT_CHK };
+
+static uint8_t  rx_state = RX_WAIT_H1;
+static uint8_t  rx_cmd   = 0;
+static uint8_t  rx_len   = 0;
+static uint8_t  rx_index = 0;
+static uint8_t  rx_sum   = 0;
+static uint8_t  rx_payload[256];
+
+// Dataset (packed Q1.15, ready for REG_SAMPLE)
+static uint32_t dataQ[MAXPTS];
+static int   dataCount = 0;
+static bool  dataDone  = false;
+static bool  running   = false;
+
+static uint32_t stepCount = 0;
+static int dataIndex = 0;
+static uint8_t frame_id = 0;
+static bool g_has_cfs = false;
+
+// ============================ CFS REG MAP (match VHDL) ============================
+#define CFS_REG_CTRL       0
+#define CFS_REG_STEP_COUNT 1
+#define CFS_REG_NODE_COUNT 2
+#define CFS_REG_FIFO       3
+#define CFS_REG_LAST_S12   4
+#define CFS_REG_STEP_CYC   5
+#define CFS_REG_DROPPED    6
+#define CFS_REG_SAMPLE     8
+#define CFS_REG_PERF_BASE  17  // R: clocks per gng_core phase group k at 17 + k
+
+#define CFS_NODE_BASE      256  // 4 words per node: xy, act|deg<<8, err, -
+#define CFS_NODE_STRIDE    4
+#define CFS_EDGE_BASE      1024 // 1 word per edge (stored age+1, 0 = none)
+
+#define CFS_CTRL_INIT      (1u << 0)
+#define CFS_CTRL_RUN       (1u << 1)
+#define CFS_CTRL_IRQ_EN    (1u << 2)
+#define CFS_STATUS_BUSY    (1u << 16)
+#define CFS_STATUS_PARKED  (1u << 17)
+#define CFS_STATUS_EMPTY   (1u << 18)
+#define CFS_STATUS_FULL    (1u << 19)
+
+// ============================ PROF struct ========================================
+typedef struct {
+  uint32_t cyc_total;      // clocks of the last hardware iteration (REG_STEP_CYC)
+  uint32_t cyc_winner;
+  uint32_t cyc_move_w;
+  uint32_t cyc_nb;
+  uint32_t cyc_connect;
+  uint32_t cyc_delete;
+  uint32_t cyc_prune;
+  uint32_t cyc_insert;
+  uint32_t cyc_renorm;
+  uint32_t cyc_overlap;    // CPU cycles spent in the snapshot (park + read)
+} Prof;
+
+static Prof g_prof = {0};
+
+// gng_core phase groups (PERF_PH words, order = PHG_* in gng_core.vhd)
+#define PHG_WIN   1
+#define PHG_UPD   2
+#define PHG_NB    3
+#define PHG_CONN  4
+#define PHG_INS   5
+#define PHG_N     7
+static uint32_t perf_prev[PHG_N];
+static uint32_t perf_prev_steps = 0;
+
+// ============================ Cycle read (64-bit) ================================
+static inline uint64_t rdcycle64(void) {
+  uint32_t hi0, lo, hi1;
+  do {
+    hi0 = neorv32_cpu_csr_read(CSR_MCYCLEH);
+    lo  = neorv32_cpu_csr_read(CSR_MCYCLE);
+    hi1 = neorv32_cpu_csr_read(CSR_MCYCLEH);
+  } while (hi0 != hi1);
+  return ((uint64_t)hi0 << 32) | (uint64_t)lo;
+}
+
+// ============================ Utility ===========================================
+static inline uint16_t float_to_q15_pos(float v) {
+  if (v <= 0.0f) return 0;
+  if (v >= 0.9999694824f) return 0x7FFF;
+  int32_t q = (int32_t)(v * 32768.0f + 0.5f);
+  if (q > 0x7FFF) q = 0x7FFF;
+  return (uint16_t)q;
+}
+
+static inline uint32_t pack_node_q15(float x, float y) {
+  uint16_t xq = float_to_q15_pos(x);
+  uint16_t yq = float_to_q15_pos(y);
+  return ((uint32_t)xq) | (((uint32_t)yq) << 16);
+}
+
+// Q1.15 -> wire format (value*1000)
+static inline int16_t q15_to_wire(uint16_t q) {
+  return (int16_t)(((uint32_t)q * 1000u) >> 15);
+}
+
+// edge index for i<j
+static inline int edge_index_ij(int i, int j) {
+  // ASSUME i < j
+  return (i * (2*MAX_NODES - i - 1)) / 2 + (j - i - 1);
+}
+
+// ============================ UART TX ===========================================
+static void uart_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  uint8_t sum = (uint8_t)(cmd + len);
+  for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
+  uint8_t chk = (uint8_t)(~sum);
+
+  neorv32_uart0_putc((char)UART_HDR);
+  neorv32_uart0_putc((char)UART_HDR);
+  neorv32_uart0_putc((char)cmd);
+  neorv32_uart0_putc((char)len);
+  for (uint8_t i = 0; i < len; i++) neorv32_uart0_putc((char)payload[i]);
+  neorv32_uart0_putc((char)chk);
+}
+
+static inline void wr_u32_le(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t)(v & 0xFFu);
+  p[1] = (uint8_t)((v >> 8) & 0xFFu);
+  p[2] = (uint8_t)((v >> 16) & 0xFFu);
+  p[3] = (uint8_t)((v >> 24) & 0xFFu);
+}
+
+static void sendPROF(void) {
+  // same layout as V3:
+  // [0] frame_id
+  // [1..36]  cyc_total .. cyc_renorm
+  // [37..40] stepCount
+  // [41..44] cyc_overlap
+  uint8_t payload[1 + 9*4 + 4 + 4];
+  uint8_t p = 0;
+  payload[p++] = frame_id;
+
+  wr_u32_le(&payload[p], g_prof.cyc_total);   p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_winner);  p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_move_w);  p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_nb);      p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_connect); p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_delete);  p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_prune);   p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_insert);  p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_renorm);  p += 4;
+
+  wr_u32_le(&payload[p], stepCount);          p += 4;
+  wr_u32_le(&payload[p], g_prof.cyc_overlap); p += 4;
+
+  uart_send_frame(CMD_PROF, payload, p);
+}
+
+// ============================ CFS snapshot ======================================
+// node window copy (filled while parked, streamed after resume)
+static uint32_t snap_xy[MAX_NODES];
+static uint8_t  snap_act[MAX_NODES];
+static uint8_t  snap_edge[MAX_EDGES_FULL];
+
+static void cfs_park(void) {
+  NEORV32_CFS->REG[CFS_REG_CTRL] = 0; // RUN=0
+  while ((NEORV32_CFS->REG[CFS_REG_CTRL] & CFS_STATUS_PARKED) == 0) { }
+}
+
+static void cfs_resume(void) {
+  NEORV32_CFS->REG[CFS_REG_CTRL] = CFS_CTRL_RUN;
+}
+
+static void cfs_read_snapshot(void) {
+  for (int i = 0; i < MAX_NODES; i++) {
+    snap_xy[i]  = NEORV32_CFS->REG[CFS_NODE_BASE + CFS_NODE_STRIDE*i + 0];
+    snap_act[i] = (uint8_t)(NEORV32_CFS->REG[CFS_NODE_BASE + CFS_NODE_STRIDE*i + 1] & 1u);
+  }
+  for (int e = 0; e < MAX_EDGES_FULL; e++) {
+    snap_edge[e] = (uint8_t)NEORV32_CFS->REG[CFS_EDGE_BASE + e];
+  }
+  stepCount        = NEORV32_CFS->REG[CFS_REG_STEP_COUNT];
+  g_prof.cyc_total = NEORV32_CFS->REG[CFS_REG_STEP_CYC];
+
+  // parked: only the idle group counts, the others are one consistent set
+  uint32_t d[PHG_N];
+  for (int k = 0; k < PHG_N; k++) {
+    uint32_t v = NEORV32_CFS->REG[CFS_REG_PERF_BASE + k];
+    d[k] = v - perf_prev[k];
+    perf_prev[k] = v;
+  }
+  uint32_t steps = stepCount - perf_prev_steps;
+  perf_prev_steps = stepCount;
+  if (steps == 0) return;
+  g_prof.cyc_winner  = d[PHG_WIN]  / steps;
+  g_prof.cyc_move_w  = d[PHG_UPD]  / steps;
+  g_prof.cyc_nb      = d[PHG_NB]   / steps;
+  g_prof.cyc_connect = d[PHG_CONN] / steps;
+  g_prof.cyc_insert  = d[PHG_INS]  / steps;
+}
+
+static void sendGNGNodes(void) {
+  uint8_t payload[2 + MAX_NODES * 5];
+  uint8_t p = 0;
+  payload[p++] = frame_id;
+  payload[p++] = 0; // node_count placeholder
+
+  uint8_t node_count = 0;
+  for (int i = 0; i < MAX_NODES; i++) {
+    if (!snap_act[i]) continue;
+    int16_t xi = q15_to_wire((uint16_t)(snap_xy[i] & 0xFFFFu));
+    int16_t yi = q15_to_wire((uint16_t)(snap_xy[i] >> 16));
+    payload[p++] = (uint8_t)i;
+    payload[p++] = (uint8_t)(xi & 0xFF);
+    payload[p++] = (uint8_t)((xi >> 8) & 0xFF);
+    payload[p++] = (uint8_t)(yi & 0xFF);
+    payload[p++] = (uint8_t)((yi >> 8) & 0xFF);
+    node_count++;
+  }
+  payload[1] = node_count;
+  uart_send_frame(CMD_GNG_NODES, payload, p);
+}
+
+// OLD FORMAT (Processing-compatible): [frame_id][count][(a,b)...]
+static void sendGNGEdges(void) {
+  uint8_t payload[2 + MAX_EDGE_PAIRS_PER_FRAME * 2];
+  uint8_t p = 0;
+
+  payload[p++] = frame_id; // [0]
+  payload[p++] = 0;        // [1] count placeholder
+
+  uint8_t edge_count = 0;
+
+  for (int i = 0; i < MAX_NODES; i++) {
+    for (int j = i + 1; j < MAX_NODES; j++) {
+      int ei = edge_index_ij(i, j);
+      if (snap_edge[ei] == 0) continue;
+
+      payload[p++] = (uint8_t)i;
+      payload[p++] = (uint8_t)j;
+      edge_count++;
+
+      if (edge_count >= MAX_EDGE_PAIRS_PER_FRAME) {
+        payload[1] = edge_count;
+        uart_send_frame(CMD_GNG_EDGES, payload, p);
+        return;
+      }
+    }
+  }
+
+  payload[1] = edge_count;
+  uart_send_frame(CMD_GNG_EDGES, payload, p);
+}
+
+// ============================ UART RX ===========================================
+static void handleCommand(uint8_t cmd, const uint8_t *payload, uint8_t len) {
+  if (cmd == CMD_DATA_BATCH) {
+    if (len < 1) return;
+    uint8_t count = payload[0];
+    if (len < (uint8_t)(1 + count * 4u)) return;
+
+    uint8_t pos = 1;
+    for (uint8_t i = 0; i < count; i++) {
+      int16_t xi = (int16_t)((uint16_t)payload[pos] | ((uint16_t)payload[pos + 1] << 8));
+      int16_t yi = (int16_t)((uint16_t)payload[pos + 2] | ((uint16_t)payload[pos + 3] << 8));
+      pos += 4;
+      if (dataCount < MAXPTS) {
+        dataQ[dataCount] = pack_node_q15((float)xi / 1000.0f, (float)yi / 1000.0f);
+        dataCount++;
+      }
+    }
+  } else if (cmd == CMD_DONE) {
+    dataDone = true;
+  } else if (cmd == CMD_RUN) {
+    running = true;
+  }
+}
+
+static void readSerial(void) {
+  while (neorv32_uart0_char_received()) {
+    uint8_t b = (uint8_t)neorv32_uart0_getc();
+    switch (rx_state) {
+      case RX_WAIT_H1:
+        if (b == UART_HDR) rx_state = RX_WAIT_H2;
+        break;
+      case RX_WAIT_H2:
+        if (b == UART_HDR) rx_state = RX_WAIT_CMD;
+        else rx_state = RX_WAIT_H1;
+        break;
+      case RX_WAIT_CMD:
+        rx_cmd = b; rx_sum = b; rx_state = RX_WAIT_LEN;
+        break;
+      case RX_WAIT_LEN:
+        rx_len = b;
+        rx_sum = (uint8_t)(rx_sum + b);
+        rx_index = 0;
+        if (rx_len == 0) rx_state = RX_WAIT_CHK;
+        else rx_state = RX_WAIT_PAYLOAD;
+        break;
+      case RX_WAIT_PAYLOAD:
+        rx_payload[rx_index++] = b;
+        rx_sum = (uint8_t)(rx_sum + b);
+        if (rx_index >= rx_len) rx_state = RX_WAIT_CHK;
+        break;
+      case RX_WAIT_CHK: {
+        uint8_t expected = (uint8_t)(~rx_sum);
+        if (b == expected) handleCommand(rx_cmd, rx_payload, rx_len);
+        rx_state = RX_WAIT_H1;
+        break;
+      }
+      default:
+        rx_state = RX_WAIT_H1;
+        break;
+    }
+  }
+}
+
+// ============================ CFS feeding =======================================
+// top up the sample FIFO; returns number of samples pushed
+static uint32_t cfs_feed(void) {
+  uint32_t f     = NEORV32_CFS->REG[CFS_REG_FIFO];
+  uint32_t level = f & 0xFFu;
+  uint32_t depth = (f >> 16) & 0xFFu;
+  uint32_t n     = depth - level;
+
+  for (uint32_t k = 0; k < n; k++) {
+    NEORV32_CFS->REG[CFS_REG_SAMPLE] = dataQ[dataIndex];
+    dataIndex++;
+    if (dataIndex >= dataCount) dataIndex = 0;
+  }
+  return n;
+}
+
+// ============================ Init ===============================================
+static void initGNG(void) {
+  dataCount=0; dataDone=false; running=false;
+  stepCount=0; dataIndex=0; frame_id=0;
+
+  // re-seed the hardware model (nodes 0.2/0.8 + edge 0-1), flush FIFO, stay parked
+  NEORV32_CFS->REG[CFS_REG_CTRL] = CFS_CTRL_INIT;
+}
+
+int main(void) {
+  neorv32_rte_setup();
+  neorv32_uart0_setup(BAUD_RATE, 0);
+
+  neorv32_uart0_puts("READY\n");
+
+  g_has_cfs = (neorv32_cfs_available() != 0);
+  neorv32_uart0_puts(g_has_cfs ? "CFS=1\n" : "CFS=0\n");
+  if (!g_has_cfs) {
+    neorv32_uart0_puts("ERROR: CFS missing\n");
+    while (1) { }
+  }
+
+  initGNG();
+
+  bool preprocessed = false;
+  uint32_t next_stream = STREAM_EVERY_N;
+
+  while (1) {
+    readSerial();
+
+    if (dataDone && !preprocessed) {
+      neorv32_uart0_puts("DATA OK\n");
+      preprocessed = true;
+      running = true; // auto-run
+      cfs_resume();
+    }
+
+    if (!dataDone || !running || (dataCount <= 0)) continue;
+
+    (void)cfs_feed();
+
+    // stream (hardware keeps the FIFO, resumes after the snapshot is copied)
+    if (NEORV32_CFS->REG[CFS_REG_STEP_COUNT] >= next_stream) {
+      uint64_t t0 = rdcycle64();
+      cfs_park();
+      cfs_read_snapshot();
+      cfs_resume();
+      g_prof.cyc_overlap = (uint32_t)(rdcycle64() - t0);
+
+      next_stream = stepCount - (stepCount % STREAM_EVERY_N) + STREAM_EVERY_N;
+
+      frame_id++;
+      sendGNGNodes();
+      sendGNGEdges(); // Processing-compatible (old format)
+      sendPROF();     // profiling frame
+    }
+  }
+
+  return 0;
+}
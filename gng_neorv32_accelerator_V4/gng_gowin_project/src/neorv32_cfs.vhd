@@ -0,0 +1,335 @@
+-- ================================================================================
+-- NEORV32 CFS (V4: full GNG step in hardware) - wraps gng_core behind the CFS bus
+-- - Sample FIFO: FIFO_DEPTH x 32-bit packed Q1.15 (x | y<<16), written via REG_SAMPLE
+-- - gng_core pops one sample per iteration while CTRL.RUN = 1
+-- - Snapshot window: node / edge BRAMs readable while STATUS.PARKED = 1
+-- - Bus: 1-cycle response for registers, 2-cycle for node/edge window (sync BRAM)
+-- - IRQ: irq_o = CTRL.IRQ_EN and FIFO level <= FIFO_DEPTH/2 (level, refill to drop)
+--
+-- Register map (word index):
+--   0   CTRL       W: bit0 INIT (pulse: re-seed model, flush FIFO)
+--                     bit1 RUN (sticky), bit2 IRQ_EN (sticky)
+--                  R: bit1 RUN, bit2 IRQ_EN,
+--                     bit16 BUSY, bit17 PARKED, bit18 FIFO_EMPTY, bit19 FIFO_FULL
+--   1   STEP_COUNT R: finished iterations since INIT
+--   2   NODE_COUNT R: created nodes (V2 semantics)
+--   3   FIFO       R: bits 7..0 level, bits 23..16 depth
+--   4   LAST_S12   R: s1 | s2<<8 of the last iteration
+--   5   STEP_CYC   R: clocks of the last iteration
+--   6   DROPPED    R: samples written while the FIFO was full
+--   8   SAMPLE     W: push x | y<<16 (Q1.15)
+--   16  PERF_CTRL  W: bit0 clear the phase counters; R: bits 15..8 counter count
+--   17+k PERF_PH   R: clocks spent in gng_core phase group k since INIT / clear
+--                     (0 idle+park, 1 winner, 2 update, 3 neighbors, 4 connect,
+--                      5 insert, 6 next), stable while PARKED (only k = 0 runs)
+--   NODE_BASE + 4*i + 0 : x | y<<16          (Q1.15)
+--   NODE_BASE + 4*i + 1 : act | deg<<8
+--   NODE_BASE + 4*i + 2 : err (u32, core units)
+--   EDGE_BASE + k       : stored edge byte (0 = none, else age+1), k = edge_idx(i<j)
+-- ================================================================================
+library ieee;
+use ieee.std_logic_1164.all;
+use ieee.numeric_std.all;
+
+library neorv32;
+use neorv32.neorv32_package.all;
+
+entity neorv32_cfs is
+  generic (
+    FIFO_DEPTH : natural := 64  -- sample FIFO entries (power of 2, <= 128)
+  );
+  port (
+    clk_i     : in  std_ulogic;
+    rstn_i    : in  std_ulogic;
+    bus_req_i : in  bus_req_t;
+    bus_rsp_o : out bus_rsp_t;
+    irq_o     : out std_ulogic
+  );
+end neorv32_cfs;
+
+architecture neorv32_cfs_rtl of neorv32_cfs is
+
+  constant REG_CTRL       : natural := 0;
+  constant REG_STEP_COUNT : natural := 1;
+  constant REG_NODE_COUNT : natural := 2;
+  constant REG_FIFO       : natural := 3;
+  constant REG_LAST_S12   : natural := 4;
+  constant REG_STEP_CYC   : natural := 5;
+  constant REG_DROPPED    : natural := 6;
+  constant REG_SAMPLE     : natural := 8;
+  constant REG_PERF_CTRL  : natural := 16;
+  constant REG_PERF_BASE  : natural := 17;
+  constant PERF_N         : natural := 7;  -- gng_core PHG_* groups
+
+  constant MAXNODES  : natural := 40;
+  constant EDGE_N    : natural := (MAXNODES * (MAXNODES - 1)) / 2;
+  constant NODE_BASE : natural := 256;
+  constant EDGE_BASE : natural := 1024;
+
+  -- sample FIFO (show-ahead)
+  type fifo_mem_t is array (0 to FIFO_DEPTH-1) of std_ulogic_vector(31 downto 0);
+  signal fifo_mem   : fifo_mem_t;
+  signal fifo_wp    : natural range 0 to FIFO_DEPTH-1 := 0;
+  signal fifo_rp    : natural range 0 to FIFO_DEPTH-1 := 0;
+  signal fifo_level : natural range 0 to FIFO_DEPTH := 0;
+  signal fifo_empty : std_ulogic;
+  signal fifo_full  : std_ulogic;
+  signal fifo_valid : std_ulogic;
+  signal fifo_head  : std_ulogic_vector(31 downto 0);
+  signal fifo_push  : std_ulogic;
+
+  signal run_en      : std_ulogic := '0';
+  signal irq_en      : std_ulogic := '0';
+  signal init_pulse  : std_ulogic := '0';
+  signal step_count  : unsigned(31 downto 0) := (others => '0');
+  signal dropped     : unsigned(31 downto 0) := (others => '0');
+
+  -- core
+  signal core_pop       : std_ulogic;
+  signal core_busy      : std_ulogic;
+  signal core_parked    : std_ulogic;
+  signal core_step      : std_ulogic;
+  signal core_s12       : std_ulogic_vector(15 downto 0);
+  signal core_ncount    : std_ulogic_vector(7 downto 0);
+  signal core_step_cyc  : std_ulogic_vector(31 downto 0);
+  signal core_phase     : std_ulogic_vector(2 downto 0);
+
+  type perf_t is array (0 to PERF_N-1) of unsigned(31 downto 0);
+  signal perf           : perf_t := (others => (others => '0'));
+  signal perf_clr       : std_ulogic := '0';
+  signal host_node_addr : unsigned(7 downto 0)  := (others => '0');
+  signal host_node_data : std_ulogic_vector(79 downto 0);
+  signal host_edge_addr : unsigned(12 downto 0) := (others => '0');
+  signal host_edge_data : std_ulogic_vector(7 downto 0);
+
+  signal stb_prev  : std_ulogic := '0';
+  signal req_valid : std_ulogic := '0';
+  signal req_wait  : std_ulogic := '0'; -- window read: one extra clock for the BRAM
+  signal req_rw    : std_ulogic := '0';
+  signal req_ben   : std_ulogic_vector(3 downto 0) := (others => '0');
+  signal req_idx_u : unsigned(13 downto 0) := (others => '0');
+  signal accept    : std_ulogic;
+
+begin
+
+  assert (FIFO_DEPTH >= 2) and (FIFO_DEPTH <= 128)
+    report "neorv32_cfs: FIFO_DEPTH must be 2..128" severity failure;
+
+  fifo_empty <= '1' when fifo_level = 0 else '0';
+  fifo_full  <= '1' when fifo_level = FIFO_DEPTH else '0';
+  fifo_valid <= not fifo_empty;
+  fifo_head  <= fifo_mem(fifo_rp);
+
+  fifo_push <= '1' when (accept = '1') and (bus_req_i.rw = '1') and (bus_req_i.ben = "1111") and
+                        (unsigned(bus_req_i.addr(15 downto 2)) = REG_SAMPLE) and (fifo_full = '0') else '0';
+
+  -- FIFO storage (no reset -> distributed RAM)
+  fifo_write: process(clk_i)
+  begin
+    if rising_edge(clk_i) then
+      if fifo_push = '1' then
+        fifo_mem(fifo_wp) <= bus_req_i.data;
+      end if;
+    end if;
+  end process;
+
+  -- level IRQ: FIFO at or below half, cleared by refilling (or IRQ_EN=0)
+  irq_o <= irq_en when fifo_level <= (FIFO_DEPTH / 2) else '0';
+
+  accept <= bus_req_i.stb and (not stb_prev) and (not req_valid);
+
+  -- ==========================================================
+  -- GNG core (V2 datapath)
+  -- ==========================================================
+  core_inst: entity neorv32.gng_core
+  generic map (
+    MAX_NODES => MAXNODES
+  )
+  port map (
+    clk_i             => clk_i,
+    rstn_i            => rstn_i,
+    init_i            => init_pulse,
+    run_i             => run_en,
+    smp_valid_i       => fifo_valid,
+    smp_data_i        => fifo_head,
+    smp_pop_o         => core_pop,
+    busy_o            => core_busy,
+    parked_o          => core_parked,
+    step_o            => core_step,
+    s12_o             => core_s12,
+    node_count_o      => core_ncount,
+    step_cyc_o        => core_step_cyc,
+    phase_o           => core_phase,
+    host_node_addr_i  => host_node_addr,
+    host_node_rdata_o => host_node_data,
+    host_edge_addr_i  => host_edge_addr,
+    host_edge_rdata_o => host_edge_data
+  );
+
+  -- per-phase clock counters (INIT or PERF_CTRL.bit0 clears)
+  perf_cnt: process(clk_i)
+    variable g : natural;
+  begin
+    if rising_edge(clk_i) then
+      g := to_integer(unsigned(core_phase));
+      if (rstn_i = '0') or (init_pulse = '1') or (perf_clr = '1') then
+        perf <= (others => (others => '0'));
+      elsif g < PERF_N then
+        perf(g) <= perf(g) + 1;
+      end if;
+    end if;
+  end process;
+
+  -- ==========================================================
+  -- Bus (1-cycle response, 2 for BRAM window), NO blocking-read
+  -- ==========================================================
+  bus_access: process(clk_i, rstn_i)
+    variable reg_idx : natural;
+    variable di      : natural;
+  begin
+    if rstn_i = '0' then
+      bus_rsp_o <= rsp_terminate_c;
+      req_valid <= '0';
+      req_wait  <= '0';
+      req_rw    <= '0';
+      req_ben   <= (others => '0');
+      req_idx_u <= (others => '0');
+      stb_prev    <= '0';
+      init_pulse  <= '0';
+      perf_clr    <= '0';
+      run_en      <= '0';
+      irq_en      <= '0';
+      fifo_wp     <= 0;
+      fifo_rp     <= 0;
+      fifo_level  <= 0;
+      step_count  <= (others => '0');
+      dropped     <= (others => '0');
+      host_node_addr <= (others => '0');
+      host_edge_addr <= (others => '0');
+
+    elsif rising_edge(clk_i) then
+      stb_prev <= bus_req_i.stb;
+
+      bus_rsp_o.ack  <= '0';
+      bus_rsp_o.err  <= '0';
+      bus_rsp_o.data <= (others => '0');
+
+      init_pulse <= '0';
+      perf_clr   <= '0';
+
+      if core_step = '1' then
+        step_count <= step_count + 1;
+      end if;
+
+      if accept = '1' then
+        req_valid <= '1';
+        req_rw    <= bus_req_i.rw;
+        req_ben   <= bus_req_i.ben;
+        req_idx_u <= unsigned(bus_req_i.addr(15 downto 2));
+
+        reg_idx := to_integer(unsigned(bus_req_i.addr(15 downto 2)));
+
+        if (bus_req_i.rw = '1') and (bus_req_i.ben = "1111") then
+          if reg_idx = REG_CTRL then
+            if bus_req_i.data(0) = '1' then init_pulse <= '1'; end if;
+            run_en <= bus_req_i.data(1);
+            irq_en <= bus_req_i.data(2);
+
+          elsif reg_idx = REG_PERF_CTRL then
+            perf_clr <= bus_req_i.data(0);
+
+          elsif reg_idx = REG_SAMPLE then
+            if fifo_full = '1' then
+              dropped <= dropped + 1;
+            end if;
+          end if;
+
+        elsif bus_req_i.rw = '0' then
+          -- window reads: present the BRAM address now, answer one clock later
+          if (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + 4*MAXNODES) then
+            host_node_addr <= to_unsigned((reg_idx - NODE_BASE) / 4, 8);
+            req_wait <= '1';
+          elsif (reg_idx >= EDGE_BASE) and (reg_idx < EDGE_BASE + EDGE_N) then
+            host_edge_addr <= to_unsigned(reg_idx - EDGE_BASE, 13);
+            req_wait <= '1';
+          end if;
+        end if;
+      end if;
+
+      -- FIFO pointers (push from bus, pop from core; INIT flushes)
+      if init_pulse = '1' then
+        fifo_wp    <= 0;
+        fifo_rp    <= 0;
+        fifo_level <= 0;
+        step_count <= (others => '0');
+        dropped    <= (others => '0');
+      else
+        if fifo_push = '1' then
+          fifo_wp <= (fifo_wp + 1) mod FIFO_DEPTH;
+        end if;
+        if core_pop = '1' then
+          fifo_rp <= (fifo_rp + 1) mod FIFO_DEPTH;
+        end if;
+        if (fifo_push = '1') and (core_pop = '0') then
+          fifo_level <= fifo_level + 1;
+        elsif (fifo_push = '0') and (core_pop = '1') then
+          fifo_level <= fifo_level - 1;
+        end if;
+      end if;
+
+      if (req_valid = '1') and (req_wait = '1') then
+        req_wait <= '0';
+
+      elsif req_valid = '1' then
+        req_valid     <= '0';
+        bus_rsp_o.ack <= '1';
+        reg_idx := to_integer(req_idx_u);
+
+        if req_rw = '0' then
+          if reg_idx = REG_CTRL then
+            bus_rsp_o.data(1)  <= run_en;
+            bus_rsp_o.data(2)  <= irq_en;
+            bus_rsp_o.data(16) <= core_busy;
+            bus_rsp_o.data(17) <= core_parked;
+            bus_rsp_o.data(18) <= fifo_empty;
+            bus_rsp_o.data(19) <= fifo_full;
+
+          elsif reg_idx = REG_STEP_COUNT then
+            bus_rsp_o.data <= std_ulogic_vector(step_count);
+          elsif reg_idx = REG_NODE_COUNT then
+            bus_rsp_o.data(7 downto 0) <= core_ncount;
+          elsif reg_idx = REG_FIFO then
+            bus_rsp_o.data(7 downto 0)   <= std_ulogic_vector(to_unsigned(fifo_level, 8));
+            bus_rsp_o.data(23 downto 16) <= std_ulogic_vector(to_unsigned(FIFO_DEPTH, 8));
+          elsif reg_idx = REG_LAST_S12 then
+            bus_rsp_o.data(15 downto 0) <= core_s12;
+          elsif reg_idx = REG_STEP_CYC then
+            bus_rsp_o.data <= core_step_cyc;
+          elsif reg_idx = REG_DROPPED then
+            bus_rsp_o.data <= std_ulogic_vector(dropped);
+          elsif reg_idx = REG_PERF_CTRL then
+            bus_rsp_o.data(15 downto 8) <= std_ulogic_vector(to_unsigned(PERF_N, 8));
+          elsif (reg_idx >= REG_PERF_BASE) and (reg_idx < REG_PERF_BASE + PERF_N) then
+            bus_rsp_o.data <= std_ulogic_vector(perf(reg_idx - REG_PERF_BASE));
+
+          elsif (reg_idx >= NODE_BASE) and (reg_idx < NODE_BASE + 4*MAXNODES) then
+            di := (reg_idx - NODE_BASE) mod 4;
+            if di = 0 then
+              bus_rsp_o.data <= host_node_data(31 downto 0);
+            elsif di = 1 then
+              bus_rsp_o.data(0)           <= host_node_data(32);
+              bus_rsp_o.data(15 downto 8) <= host_node_data(40 downto 33);
+            elsif di = 2 then
+              bus_rsp_o.data <= host_node_data(72 downto 41);
+            end if;
+
+          elsif (reg_idx >= EDGE_BASE) and (reg_idx < EDGE_BASE + EDGE_N) then
+            bus_rsp_o.data(7 downto 0) <= host_edge_data;
+          end if;
+        end if;
+      end if;
+
+    end if;
+  end process;
+
+end architecture;
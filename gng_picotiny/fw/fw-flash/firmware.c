@@ -40,466 +40,506 @@ static int32_t uart_getc_nonblock(void)
     return (int32_t)UART0->DATA;
 }
 
-static void uart_putu(unsigned int v)
+static void uart_putb(uint8_t b)
 {
-    char buf[10];
-    int pos = 0;
-
-    if (v == 0) {
-        uart_putc('0');
-        return;
-    }
-
-    while (v > 0 && pos < (int)sizeof(buf)) {
-        buf[pos++] = (char)('0' + (v % 10));
-        v /= 10;
-    }
-
-    while (pos > 0) {
-        uart_putc(buf[--pos]);
-    }
-}
-
-static void uart_putf5(float f)
-{
-    if (f < 0.0f) {
-        uart_putc('-');
-        f = -f;
-    }
-
-    unsigned int ipart = (unsigned int)f;
-    float frac = f - (float)ipart;
-    unsigned int fpart = (unsigned int)(frac * 100000.0f + 0.5f); // 5 digit
-
-    uart_putu(ipart);
-    uart_putc('.');
-
-    unsigned int div = 10000;
-    while (div > 0) {
-        unsigned int digit = (fpart / div) % 10;
-        uart_putc((char)('0' + digit));
-        div /= 10;
-    }
+    UART0->DATA = (uint32_t)b;   // raw byte, no '\n' -> "\r\n"
 }
 
 // =======================
-//  String & parsing helper
+//  Binary protocol (same frames as the NEORV32 builds)
+//  Frame: FF FF CMD LEN PAYLOAD CHK, CHK = ~(CMD + LEN + sum(payload))
+//  Coordinates on the wire: int16 = value * 1000 (little endian)
 // =======================
-static int starts_with(const char *s, const char *pfx)
+#define UART_HDR        0xFFu
+#define CMD_DATA_BATCH  0x01u   // host: [count][x lo][x hi][y lo][y hi]...
+#define CMD_DONE        0x02u   // host: dataset complete, start training
+#define CMD_RUN         0x03u   // host: (re)start training
+#define CMD_GNG_NODES   0x10u   // fw:   [frame_id][count][id][x lo][x hi][y lo][y hi]...
+#define CMD_GNG_EDGES   0x11u   // fw:   [frame_id][count][a][b]...
+#define CMD_PROF        0x12u   // fw:   [frame_id][9 x u32 cycles][u32 step]
+
+static void uart_send_frame(uint8_t cmd, const uint8_t *payload, uint8_t len)
 {
-    while (*pfx) {
-        if (*s++ != *pfx++) return 0;
-    }
-    return 1;
+    uint8_t sum = (uint8_t)(cmd + len);
+    for (uint8_t i = 0; i < len; i++) sum = (uint8_t)(sum + payload[i]);
+
+    uart_putb(UART_HDR);
+    uart_putb(UART_HDR);
+    uart_putb(cmd);
+    uart_putb(len);
+    for (uint8_t i = 0; i < len; i++) uart_putb(payload[i]);
+    uart_putb((uint8_t)(~sum));
 }
 
-static float parse_float(const char *p, const char **endp)
+static inline void wr_u32_le(uint8_t *p, uint32_t v)
 {
-    int sign = 1;
-    float val = 0.0f;
-
-    if (*p == '-') {
-        sign = -1;
-        p++;
-    }
-
-    // integer part
-    while (*p >= '0' && *p <= '9') {
-        val = val * 10.0f + (float)(*p - '0');
-        p++;
-    }
-
-    // fraction
-    if (*p == '.') {
-        p++;
-        float factor = 0.1f;
-        while (*p >= '0' && *p <= '9') {
-            val += factor * (float)(*p - '0');
-            factor *= 0.1f;
-            p++;
-        }
-    }
+    p[0] = (uint8_t)(v & 0xFFu);
+    p[1] = (uint8_t)((v >> 8) & 0xFFu);
+    p[2] = (uint8_t)((v >> 16) & 0xFFu);
+    p[3] = (uint8_t)((v >> 24) & 0xFFu);
+}
 
-    if (endp) *endp = p;
-    return (float)sign * val;
+static inline uint32_t rdcycle(void)
+{
+    uint32_t c;
+    __asm__ volatile ("rdcycle %0" : "=r"(c));
+    return c;
 }
 
 // =======================
 //  Buffer & dataset
 // =======================
-#define RXBUF_LEN    64
 #define MAX_SAMPLES  200
 
-static char rxbuf[RXBUF_LEN];
-static uint32_t rxpos = 0;
+enum { RX_WAIT_H1 = 0, RX_WAIT_H2, RX_WAIT_CMD, RX_WAIT_LEN, RX_WAIT_PAYLOAD, RX_WAIT_CHK };
 
-static float xs[MAX_SAMPLES];
-static float ys[MAX_SAMPLES];
-static uint32_t nsamples = 0;
-static uint32_t sample_count = 0;
+static uint8_t rx_state = RX_WAIT_H1;
+static uint8_t rx_cmd   = 0;
+static uint8_t rx_len   = 0;
+static uint8_t rx_index = 0;
+static uint8_t rx_sum   = 0;
+static uint8_t rx_payload[256];
 
 // =======================
-//  GNG data structure
+//  GNG core (../../../gng_core): step, parameters, edge storage shared
+//  with the NEORV32 / Arduino builds, only the protocol lives here
 // =======================
-#define GNG_MAX_NODES     20
-#define GNG_MAX_NEIGHBORS 6
-#define GNG_MAX_AGE       50
-
-#define GNG_LAMBDA        50      // setiap 50 iterasi tambah node
-#define GNG_EPS_B         0.05f   // learning rate winner
-#define GNG_EPS_N         0.006f  // learning rate neighbor
-#define GNG_ALPHA         0.5f
-#define GNG_D_ERR         0.995f
-
-// seberapa sering kirim snapshot GNG
-#define GNG_STREAM_EVERY  20
-
-static float   gng_wx[GNG_MAX_NODES];
-static float   gng_wy[GNG_MAX_NODES];
-static float   gng_err[GNG_MAX_NODES];
-static int8_t  gng_nbr[GNG_MAX_NODES][GNG_MAX_NEIGHBORS];
-static uint8_t gng_age[GNG_MAX_NODES][GNG_MAX_NEIGHBORS];
-static uint32_t gng_nodes = 0;
-
-// === state continuous training ===
-static uint8_t  gng_running      = 0;
-static uint32_t gng_iter         = 0;
-static uint32_t gng_sample_index = 0;
+#define MAX_NODES         20
+#define GNG_PROFILE       1
+#define GNG_CYCLES()      rdcycle()
+#define GNG_DIRTY         1                   // moved nodes -> GNGP node window
+#define GNG_MAX_DEGREE    6                   // full node: new edge evicts its oldest
+#ifndef GNG_RAMTEXT
+#define GNG_RAMTEXT       1
+#endif
+#if GNG_RAMTEXT
+// step path runs from SRAM (linker_flash.ld .ramtext, copied by crt_flash.S)
+#define GNG_HOT           __attribute__((section(".ramtext")))
+#endif
+#define GNG_FIND_WINNERS  gngp_find_winners
+#ifndef GNG_PCPI
+#define GNG_PCPI          0                   // 1 = picogng_pcpi.v in the bitstream (make PCPI=yes)
+#endif
+#include "gng_core.h"
 
 // =======================
-//  GNG helpers
+//  GNG winner finder (hw/picogng.v, S3 0xC000_0000): the NEORV32 CFS register
+//  subset, node words Q1.15 x | y << 16. Old bitstreams read INFO = 0 -> the
+//  CPU search stays in use
 // =======================
-static float dist2(float x1, float y1, float x2, float y2)
+#define GNGP               ((volatile uint32_t *)0xC0000000)
+#define GNGP_REG_CTRL       0
+#define GNGP_REG_XIN        8
+#define GNGP_REG_YIN        9
+#define GNGP_REG_NODE_COUNT 10
+#define GNGP_REG_ACT_LO     11
+#define GNGP_REG_ACT_HI     12
+#define GNGP_REG_OUT_S12    13
+#define GNGP_REG_OUT_MIN1   14
+#define GNGP_REG_INFO       20   // MAXNODES (15..0) | LANES << 16
+#define GNGP_NODE_BASE      128
+
+#define GNGP_CTRL_CLEAR     (1u << 0)
+#define GNGP_CTRL_START     (1u << 1)
+#define GNGP_STATUS_DONE    (1u << 17)
+#define GNGP_TIMEOUT        10000u
+
+#if MAX_NODES > 64
+#error "picogng.v has ACT_LO / ACT_HI only (64 nodes)"
+#endif
+
+static uint8_t  g_has_gngp = 0;
+static uint32_t gngp_shadow[MAX_NODES];   // node words the peripheral / PCPI search uses
+
+// after gng_reset(): capacity check, then the whole node window
+static void gngp_setup(void)
 {
-    float dx = x1 - x2;
-    float dy = y1 - y2;
-    return dx*dx + dy*dy;
+    uint32_t info = GNGP[GNGP_REG_INFO];
+    g_has_gngp = ((info & 0xFFFFu) >= MAX_NODES) && ((info >> 16) != 0);
+    if (!g_has_gngp && !GNG_PCPI) return;
+
+    if (g_has_gngp) GNGP[GNGP_REG_CTRL] = GNGP_CTRL_CLEAR;
+    for (int i = 0; i < MAX_NODES; i++) {
+        gngp_shadow[i] = pack_node_q15(nodes[i].x, nodes[i].y);
+        if (g_has_gngp) GNGP[GNGP_NODE_BASE + i] = gngp_shadow[i];
+    }
+    for (int w = 0; w < ACT_WORDS; w++) g_dirty[w] = 0;
 }
 
-static void gng_init(void)
+// write moved active nodes whose Q1.15 word changed
+GNG_HOT static void gngp_flush_dirty(void)
 {
-    uint32_t i, j;
-    for (i = 0; i < GNG_MAX_NODES; i++) {
-        gng_wx[i] = 0.0f;
-        gng_wy[i] = 0.0f;
-        gng_err[i] = 0.0f;
-        for (j = 0; j < GNG_MAX_NEIGHBORS; j++) {
-            gng_nbr[i][j] = -1;
-            gng_age[i][j] = 0;
+    for (int w = 0; w < ACT_WORDS; w++) {
+        uint32_t m = g_dirty[w] & g_act[w];
+        g_dirty[w] = 0;
+        for (; m; m &= m - 1u) {
+            int i = w * 32 + GNG_CTZ(m);
+            uint32_t v = pack_node_q15(nodes[i].x, nodes[i].y);
+            if (v == gngp_shadow[i]) continue;
+            gngp_shadow[i] = v;
+            if (g_has_gngp) GNGP[GNGP_NODE_BASE + i] = v;
         }
     }
-
-    if (nsamples < 2) {
-        gng_nodes = 0;
-        return;
-    }
-
-    gng_nodes = 2;
-    gng_wx[0] = xs[0];
-    gng_wy[0] = ys[0];
-    gng_wx[1] = xs[nsamples - 1];
-    gng_wy[1] = ys[nsamples - 1];
-    gng_err[0] = 0.0f;
-    gng_err[1] = 0.0f;
 }
 
-static int gng_find_neighbor_index(int a, int b)
+// =======================
+//  GNG PCPI co-processor (hw/picogng_pcpi.v, GNG_PCPI=1): custom-0 dist2 and
+//  a running s1/s2 argmin; the CPU walks the active nodes over gngp_shadow,
+//  one ACC per node instead of a libgcc-multiplied dist2. Without the unit
+//  the instructions trap, so this is a build option and not probed; the bus
+//  peripheral still wins when its INFO is there
+// =======================
+#if GNG_PCPI
+#define PCPI_GNG_DIST2      0
+#define PCPI_GNG_SMP        1
+#define PCPI_GNG_ACC        2
+#define PCPI_GNG_S12        3
+#define PCPI_GNG_MIN1       4
+
+// the unit holds the argmin state, so every call stays in program order
+#define PCPI_GNG(f7, a, b) __extension__ ({                                 \
+    uint32_t _r;                                                            \
+    __asm__ volatile (".insn r CUSTOM_0, 0, %1, %0, %2, %3"                 \
+                      : "=r"(_r) : "i"(f7), "r"(a), "r"(b));                \
+    _r; })
+
+GNG_HOT static void pcpi_find_winners(pos_t x, pos_t y, int *s1, int *s2, dist_t *d1)
 {
-    for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-        if (gng_nbr[a][k] == b) return k;
+    gngp_flush_dirty();
+    PCPI_GNG(PCPI_GNG_SMP, pack_node_q15(x, y), 0u);
+    FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+        PCPI_GNG(PCPI_GNG_ACC, gngp_shadow[i], (uint32_t)i);
     }
-    return -1;
+    uint32_t s12 = PCPI_GNG(PCPI_GNG_S12, 0u, 0u);
+    *s1 = (int)(s12 & 0xFFu);
+    *s2 = (int)((s12 >> 8) & 0xFFu);
+    *d1 = dist_from_q30(PCPI_GNG(PCPI_GNG_MIN1, 0u, 0u));
 }
+#define gngp_find_winners_cpu pcpi_find_winners
+#else
+#define gngp_find_winners_cpu gng_find_winners_sw
+#endif
 
-static void gng_add_directed_edge(int a, int b)
+GNG_HOT static void gngp_find_winners(pos_t x, pos_t y, int *s1, int *s2, dist_t *d1)
 {
-    if (a == b) return;
-
-    int idx = gng_find_neighbor_index(a, b);
-    if (idx >= 0) {
-        gng_age[a][idx] = 0;
+    if (!g_has_gngp) {
+        gngp_find_winners_cpu(x, y, s1, s2, d1);
         return;
     }
 
-    int free_idx = -1;
-    uint8_t oldest_age = 0;
-    int oldest_idx = 0;
-
-    for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-        if (gng_nbr[a][k] < 0) {
-            free_idx = k;
-            break;
-        }
-        if (gng_age[a][k] > oldest_age) {
-            oldest_age = gng_age[a][k];
-            oldest_idx = k;
+    gngp_flush_dirty();
+    uint32_t smp = pack_node_q15(x, y);
+    GNGP[GNGP_REG_XIN]        = smp & 0xFFFFu;
+    GNGP[GNGP_REG_YIN]        = smp >> 16;
+    GNGP[GNGP_REG_NODE_COUNT] = MAX_NODES;
+    GNGP[GNGP_REG_ACT_LO]     = g_act[0];
+    GNGP[GNGP_REG_ACT_HI]     = (ACT_WORDS > 1) ? g_act[ACT_WORDS - 1] : 0u;
+    GNGP[GNGP_REG_CTRL]       = GNGP_CTRL_START;
+
+    for (uint32_t t = 0; t < GNGP_TIMEOUT; t++) {
+        if (GNGP[GNGP_REG_CTRL] & GNGP_STATUS_DONE) {
+            uint32_t s12 = GNGP[GNGP_REG_OUT_S12];
+            *s1 = (int)(s12 & 0xFFu);
+            *s2 = (int)((s12 >> 8) & 0xFFu);
+            *d1 = dist_from_q30(GNGP[GNGP_REG_OUT_MIN1]);
+            return;
         }
     }
-
-    if (free_idx < 0)
-        free_idx = oldest_idx;
-
-    gng_nbr[a][free_idx] = (int8_t)b;
-    gng_age[a][free_idx] = 0;
+    // no answer (rare): CPU search, resync the window
+    gngp_find_winners_cpu(x, y, s1, s2, d1);
+    gngp_setup();
 }
 
-static void gng_add_edge(int a, int b)
+// =======================
+//  HDMI plot (hw/hdmi/svo_gngplot.v, S3 0xC000_1000): the line engine draws
+//  into the back buffer, SWAP shows it at the next video frame. A new graph
+//  is drawn as soon as the last one is on screen (up to 60 per second), so
+//  the display follows training at full step rate, without the UART
+// =======================
+#define PLOT                ((volatile uint32_t *)0xC0001000)
+#define PLOT_REG_CTRL       0
+#define PLOT_REG_LINE       1
+#define PLOT_REG_INFO       2    // PLOT (15..0) | SCALE << 16
+#define PLOT_SIZE           240u
+
+#define PLOT_CTRL_CLEAR     (1u << 0)
+#define PLOT_CTRL_SWAP      (1u << 1)
+#define PLOT_CTRL_ON        (1u << 2)
+#define PLOT_STATUS_BUSY    (1u << 16)
+#define PLOT_STATUS_PEND    (1u << 17)
+
+static uint8_t g_has_plot = 0;
+
+// old bitstreams read 0 here (picogng.v INFO is word 20)
+static void plot_setup(void)
 {
-    if (a == b) return;
-    gng_add_directed_edge(a, b);
-    gng_add_directed_edge(b, a);
+    g_has_plot = ((PLOT[PLOT_REG_INFO] & 0xFFFFu) == PLOT_SIZE);
 }
 
-static void gng_remove_edge_pair(int a, int b)
+// Q1.15 [0, 1) -> plot pixel 0..PLOT_SIZE-1
+static inline uint32_t plot_px(uint16_t q)
 {
-    int k = gng_find_neighbor_index(a, b);
-    if (k >= 0) {
-        gng_nbr[a][k] = -1;
-        gng_age[a][k] = 0;
-    }
-    int k2 = gng_find_neighbor_index(b, a);
-    if (k2 >= 0) {
-        gng_nbr[b][k2] = -1;
-        gng_age[b][k2] = 0;
-    }
+    return ((uint32_t)q * PLOT_SIZE) >> 15;
 }
 
-static void gng_increment_ages_from(int a)
+static inline void plot_line(uint32_t x0, uint32_t y0, uint32_t x1, uint32_t y1)
 {
-    for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-        int nb = gng_nbr[a][k];
-        if (nb < 0) continue;
-
-        if (gng_age[a][k] < 255)
-            gng_age[a][k]++;
-
-        int k2 = gng_find_neighbor_index(nb, a);
-        if (k2 >= 0)
-            gng_age[nb][k2] = gng_age[a][k];
-    }
+    PLOT[PLOT_REG_LINE] = x0 | (y0 << 8) | (x1 << 16) | (y1 << 24);
 }
 
-static void gng_remove_old_edges_from(int a)
+// clear, edges, a 5-pixel cross per node, swap; each LINE store waits for the
+// engine, the whole graph takes ~10k cycles at 20 nodes
+static void gng_plot_draw(void)
 {
-    for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-        int nb = gng_nbr[a][k];
-        if (nb < 0) continue;
+    uint8_t px[MAX_NODES], py[MAX_NODES];
 
-        if (gng_age[a][k] > GNG_MAX_AGE) {
-            gng_remove_edge_pair(a, nb);
+    PLOT[PLOT_REG_CTRL] = PLOT_CTRL_CLEAR | PLOT_CTRL_ON;
+
+    FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+        px[i] = (uint8_t)plot_px(pos_to_q15(nodes[i].x));
+        py[i] = (uint8_t)(PLOT_SIZE - 1u - plot_px(pos_to_q15(nodes[i].y)));   // y up
+    }
+    FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+        FOR_EACH_NEIGHBOR(j, i, i + 1, MAX_NODES) {
+            plot_line(px[i], py[i], px[j], py[j]);
         }
     }
+    FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+        uint32_t x = px[i], y = py[i];
+        plot_line(x < 2u ? 0u : x - 2u, y, x > PLOT_SIZE - 3u ? PLOT_SIZE - 1u : x + 2u, y);
+        plot_line(x, y < 2u ? 0u : y - 2u, x, y > PLOT_SIZE - 3u ? PLOT_SIZE - 1u : y + 2u);
+    }
+
+    PLOT[PLOT_REG_CTRL] = PLOT_CTRL_SWAP | PLOT_CTRL_ON;
 }
 
+static sample_t xys[MAX_SAMPLES];   // Q1.15 x | y << 16
+static uint32_t nsamples = 0;
+static uint32_t sample_count = 0;
+
+// seberapa sering kirim snapshot GNG
+#define GNG_STREAM_EVERY  20
+
+// === state continuous training ===
+static uint8_t  gng_running      = 0;
+static uint32_t gng_sample_index = 0;
+static uint8_t  gng_frame_id     = 0;
+
 // =======================
-//  Kirim snapshot GNG
+//  Kirim snapshot GNG (NODES + EDGES + PROF, same frame_id)
 // =======================
-static void gng_send_snapshot(uint32_t iter)
+static void gng_send_snapshot(void)
 {
-    uart_puts("GNG:");
-    uart_puts("T:");
-    uart_putu(iter);
-    uart_putc(';');
+    uint8_t payload[2 + MAX_NODES * 5];
+    uint8_t p = 0;
+    uint8_t n = 0;
 
     // nodes
-    for (uint32_t i = 0; i < gng_nodes; i++) {
-        uart_puts("N:");
-        uart_putu(i);
-        uart_putc(',');
-        uart_putf5(gng_wx[i]);
-        uart_putc(',');
-        uart_putf5(gng_wy[i]);
-        uart_putc(';');
+    payload[p++] = gng_frame_id;
+    payload[p++] = 0;
+    FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+        int16_t xi = pos_to_wire(nodes[i].x);
+        int16_t yi = pos_to_wire(nodes[i].y);
+        n++;
+        payload[p++] = (uint8_t)i;
+        payload[p++] = (uint8_t)(xi & 0xFF);
+        payload[p++] = (uint8_t)((xi >> 8) & 0xFF);
+        payload[p++] = (uint8_t)(yi & 0xFF);
+        payload[p++] = (uint8_t)((yi >> 8) & 0xFF);
     }
-
-    // edges (i < j supaya tidak double)
-    for (uint32_t i = 0; i < gng_nodes; i++) {
-        for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-            int nb = gng_nbr[i][k];
-            if (nb < 0) continue;
-            if (nb <= (int)i) continue;
-            uart_puts("E:");
-            uart_putu(i);
-            uart_putc(',');
-            uart_putu((unsigned int)nb);
-            uart_putc(';');
+    payload[1] = n;
+    uart_send_frame(CMD_GNG_NODES, payload, p);
+
+    // edges (i < j supaya tidak double), max 126 pairs -> 1 frame
+    uint8_t epay[2 + 126 * 2];
+    uint8_t count = 0;
+    p = 2;
+    FOR_EACH_ACTIVE(i, 0, MAX_NODES) {
+        FOR_EACH_NEIGHBOR(j, i, i + 1, MAX_NODES) {
+            if (count == 126) continue;
+            epay[p++] = (uint8_t)i;
+            epay[p++] = (uint8_t)j;
+            count++;
         }
     }
-
-    uart_putc('\n');
+    epay[0] = gng_frame_id;
+    epay[1] = count;
+    uart_send_frame(CMD_GNG_EDGES, epay, p);
+
+    // prof: same 9 phases as the NEORV32 builds (gng_core g_prof), step count
+    uint8_t ppay[1 + 10 * 4];
+    ppay[0] = gng_frame_id;
+    wr_u32_le(&ppay[1],  g_prof.cyc_total);
+    wr_u32_le(&ppay[5],  g_prof.cyc_winner);
+    wr_u32_le(&ppay[9],  g_prof.cyc_move_w);
+    wr_u32_le(&ppay[13], g_prof.cyc_nb);
+    wr_u32_le(&ppay[17], g_prof.cyc_connect);
+    wr_u32_le(&ppay[21], g_prof.cyc_delete);
+    wr_u32_le(&ppay[25], g_prof.cyc_prune);
+    wr_u32_le(&ppay[29], g_prof.cyc_insert);
+    wr_u32_le(&ppay[33], g_prof.cyc_renorm);
+    wr_u32_le(&ppay[37], (uint32_t)stepCount);
+    uart_send_frame(CMD_PROF, ppay, sizeof(ppay));
+
+    gng_frame_id++;
 }
 
 // =======================
 //  Satu langkah GNG (continuous)
 // =======================
-static void gng_train_step(void)
+GNG_HOT static void gng_train_step(void)
 {
     if (!gng_running)       return;
     if (nsamples < 2)       return;
-    if (gng_nodes < 2)      return;
 
     // ambil sample dan maju
-    float x = xs[gng_sample_index];
-    float y = ys[gng_sample_index];
+    sample_t smp = xys[gng_sample_index];
 
     gng_sample_index++;
     if (gng_sample_index >= nsamples)
         gng_sample_index = 0;
 
-    // cari s1, s2
-    int s1 = -1, s2 = -1;
-    float d1 = 1e30f, d2 = 1e30f;
-
-    for (uint32_t i = 0; i < gng_nodes; i++) {
-        float d = dist2(x, y, gng_wx[i], gng_wy[i]);
-        if (d < d1) {
-            d2 = d1;
-            s2 = s1;
-            d1 = d;
-            s1 = (int)i;
-        } else if (d < d2) {
-            d2 = d;
-            s2 = (int)i;
-        }
-    }
-
-    if (s1 < 0 || s2 < 0)
+    if (!gng_step(sample_x(smp), sample_y(smp)))
         return;
 
-    // umurkan edge dari s1
-    gng_increment_ages_from(s1);
-
-    // connect s1-s2
-    gng_add_edge(s1, s2);
-
-    // update winner
-    gng_wx[s1] += GNG_EPS_B * (x - gng_wx[s1]);
-    gng_wy[s1] += GNG_EPS_B * (y - gng_wy[s1]);
-    gng_err[s1] += d1;
-
-    // update neighbors
-    for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-        int nb = gng_nbr[s1][k];
-        if (nb < 0) continue;
-        gng_wx[nb] += GNG_EPS_N * (x - gng_wx[nb]);
-        gng_wy[nb] += GNG_EPS_N * (y - gng_wy[nb]);
+    // HDMI: next graph once the last one is on screen
+    if (g_has_plot && !(PLOT[PLOT_REG_CTRL] & (PLOT_STATUS_BUSY | PLOT_STATUS_PEND))) {
+        gng_plot_draw();
     }
 
-    // buang edge tua dari s1
-    gng_remove_old_edges_from(s1);
+    // KIRIM SNAPSHOT SETIAP GNG_STREAM_EVERY ITERASI
+    if ((stepCount % GNG_STREAM_EVERY) == 0) {
+        gng_send_snapshot();
+    }
+}
 
-    // naikkan iter counter
-    gng_iter++;
+// =======================
+//  Frame handler
+// =======================
+static void gng_start(void)
+{
+    // mulai continuous GNG
+    if (nsamples < 2) {
+        uart_puts("GNG:ERR:INSUFFICIENT_DATA;\n");
+        return;
+    }
 
-    // tiap LAMBDA iterasi, insert node baru
-    if ((gng_iter % GNG_LAMBDA) == 0 && gng_nodes < GNG_MAX_NODES) {
-        int q = 0;
-        float max_err = gng_err[0];
-        for (uint32_t i = 1; i < gng_nodes; i++) {
-            if (gng_err[i] > max_err) {
-                max_err = gng_err[i];
-                q = (int)i;
-            }
-        }
+    gng_reset();
+    gngp_setup();
 
-        int f = -1;
-        float max_err_n = -1.0f;
-        for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-            int nb = gng_nbr[q][k];
-            if (nb < 0) continue;
-            if (gng_err[nb] > max_err_n) {
-                max_err_n = gng_err[nb];
-                f = nb;
-            }
-        }
+    gng_running      = 1;
+    gng_sample_index = 0;
+    gng_frame_id     = 0;
 
-        if (f >= 0) {
-            int r = (int)gng_nodes;
-            gng_nodes++;
+    uart_puts("GNG:START;\n");
 
-            // posisi node baru = tengah q dan f
-            gng_wx[r] = 0.5f * (gng_wx[q] + gng_wx[f]);
-            gng_wy[r] = 0.5f * (gng_wy[q] + gng_wy[f]);
-            gng_err[r] = gng_err[q];
+    // opsional: kirim snapshot awal
+    gng_send_snapshot();
+}
 
-            for (int k = 0; k < GNG_MAX_NEIGHBORS; k++) {
-                gng_nbr[r][k] = -1;
-                gng_age[r][k] = 0;
+static void handle_frame(uint8_t cmd, const uint8_t *payload, uint8_t len)
+{
+    if (cmd == CMD_DATA_BATCH) {
+        if (len < 1) return;
+        uint8_t count = payload[0];
+        if (len < (uint8_t)(1 + count * 4u)) return;
+
+        uint8_t pos = 1;
+        for (uint8_t i = 0; i < count; i++) {
+            int16_t xi = (int16_t)((uint16_t)payload[pos] | ((uint16_t)payload[pos + 1] << 8));
+            int16_t yi = (int16_t)((uint16_t)payload[pos + 2] | ((uint16_t)payload[pos + 3] << 8));
+            pos += 4;
+            if (nsamples < MAX_SAMPLES) {
+                xys[nsamples] = q15_from_wire(xi) | (q15_from_wire(yi) << 16);
+                nsamples++;
             }
-
-            gng_err[q] *= GNG_ALPHA;
-            gng_err[f] *= GNG_ALPHA;
-
-            gng_remove_edge_pair(q, f);
-            gng_add_edge(q, r);
-            gng_add_edge(r, f);
         }
+        sample_count += count;
     }
-
-    // decay error
-    for (uint32_t i = 0; i < gng_nodes; i++) {
-        gng_err[i] *= GNG_D_ERR;
+    else if (cmd == CMD_DONE) {
+        gng_start();
     }
-
-    // KIRIM SNAPSHOT SETIAP GNG_STREAM_EVERY ITERASI
-    if ((gng_iter % GNG_STREAM_EVERY) == 0) {
-        gng_send_snapshot(gng_iter);
+    else if (cmd == CMD_RUN) {
+        if (!gng_running) gng_start();
     }
 }
 
-// =======================
-//  Line handler
-// =======================
-static void handle_line(const char *line)
+static void uart_rx_byte(uint8_t b)
 {
-    if (starts_with(line, "DATA:")) {
-        const char *p = line + 5;
-        float x, y;
-
-        x = parse_float(p, &p);
-        if (*p == ',') p++;
-        y = parse_float(p, &p);
-
-        if (nsamples < MAX_SAMPLES) {
-            xs[nsamples] = x;
-            ys[nsamples] = y;
-            nsamples++;
+    switch (rx_state) {
+        case RX_WAIT_H1:
+            if (b == UART_HDR) rx_state = RX_WAIT_H2;
+            break;
+        case RX_WAIT_H2:
+            rx_state = (b == UART_HDR) ? RX_WAIT_CMD : RX_WAIT_H1;
+            break;
+        case RX_WAIT_CMD:
+            rx_cmd = b; rx_sum = b; rx_state = RX_WAIT_LEN;
+            break;
+        case RX_WAIT_LEN:
+            rx_len = b;
+            rx_sum = (uint8_t)(rx_sum + b);
+            rx_index = 0;
+            rx_state = (rx_len == 0) ? RX_WAIT_CHK : RX_WAIT_PAYLOAD;
+            break;
+        case RX_WAIT_PAYLOAD:
+            rx_payload[rx_index++] = b;
+            rx_sum = (uint8_t)(rx_sum + b);
+            if (rx_index >= rx_len) rx_state = RX_WAIT_CHK;
+            break;
+        case RX_WAIT_CHK: {
+            uint8_t expected = (uint8_t)(~rx_sum);
+            if (b == expected) handle_frame(rx_cmd, rx_payload, rx_len);
+            rx_state = RX_WAIT_H1;
+            break;
         }
-
-        sample_count++;
-        uart_puts("ACK ");
-        uart_putu(sample_count);
-        uart_putc('\n');
+        default:
+            rx_state = RX_WAIT_H1;
+            break;
     }
-    else if (starts_with(line, "DONE")) {
-        // mulai continuous GNG
-        if (nsamples < 2) {
-            uart_puts("GNG:ERR:INSUFFICIENT_DATA;\n");
-            return;
-        }
+}
 
-        gng_init();
-        if (gng_nodes < 2) {
-            uart_puts("GNG:ERR:INIT_FAIL;\n");
-            return;
-        }
+// =======================
+//  SPI flash XIP mode (spimemio_puya cfgreg, 0x81000000)
+//  Tang Nano 9K wires DSPI only (config_qspi is tied 0 in hw), so the fastest
+//  mode is dual I/O read (cfgreg[22]) + continuous read mode (cfgreg[20]):
+//  CSB stays low between sequential fetches, no command / address per word
+// =======================
+#define SPIMEM_CFG          (*(volatile uint32_t *)0x81000000)
+#define SPIMEM_MODE_MASK    0x007F0000u
+#define SPIMEM_MODE_DSPI    0x00400000u
+#define SPIMEM_MODE_CRM     0x00100000u
 
-        gng_add_edge(0, 1);
+static void flash_mode_dspi_crm(void)
+{
+    SPIMEM_CFG = (SPIMEM_CFG & ~SPIMEM_MODE_MASK) | SPIMEM_MODE_DSPI | SPIMEM_MODE_CRM;
+}
 
-        gng_running      = 1;
-        gng_iter         = 0;
-        gng_sample_index = 0;
+static void uart_putu(uint32_t v)
+{
+    char buf[11];
+    int n = 0;
+    do { buf[n++] = (char)('0' + v % 10u); v /= 10u; } while (v);
+    while (n) uart_putc(buf[--n]);
+}
 
-        uart_puts("GNG:START;\n");
+// cycles per gng_step() on a fixed pseudo-random sample stream; boot prints it
+// for single SPI and for DSPI + CRM. Build with GNG_RAMTEXT=0 (make RAMTEXT=no)
+// for the all-XIP numbers: the difference is what .ramtext saves per step
+#define GNG_BENCH_STEPS   400u
 
-        // opsional: kirim snapshot awal
-        gng_send_snapshot(0);
-    }
-    else {
-        uart_puts("UNKNOWN:");
-        uart_puts(line);
-        uart_putc('\n');
+static uint32_t gng_bench(void)
+{
+    uint32_t lcg = 12345u;
+    gng_reset();
+    gngp_setup();
+    uint32_t t0 = rdcycle();
+    for (uint32_t k = 0; k < GNG_BENCH_STEPS; k++) {
+        lcg = lcg * 1664525u + 1013904223u;
+        sample_t smp = (lcg >> 1) & 0x7FFF7FFFu;
+        gng_step(sample_x(smp), sample_y(smp));
     }
+    return (rdcycle() - t0) / GNG_BENCH_STEPS;
 }
 
 // =======================
@@ -510,37 +550,32 @@ void main(void)
     uart_init_hw();
 
     uart_puts("\nPicoRV GNG UART firmware with continuous streaming\n");
-    uart_puts("Format: DATA:x,y; + \\n, lalu DONE;\\n\n");
-
-    rxpos        = 0;
+    uart_puts("Format: binary frames FF FF CMD LEN PAYLOAD CHK (DATA_BATCH, DONE)\n");
+
+    plot_setup();
+
+    uint32_t cyc_spi = gng_bench();
+    flash_mode_dspi_crm();
+    uint32_t cyc_dspi = gng_bench();
+    uart_puts(GNG_RAMTEXT ? "bench (.ramtext" : "bench (XIP");
+    uart_puts(g_has_gngp ? ", GNGP): " : GNG_PCPI ? ", PCPI): " : ", CPU search): ");
+    uart_puts("cycles/step spi=");
+    uart_putu(cyc_spi);
+    uart_puts(" dspi+crm=");
+    uart_putu(cyc_dspi);
+    uart_puts("\n");
+
+    rx_state     = RX_WAIT_H1;
     nsamples     = 0;
     sample_count = 0;
     gng_running  = 0;
-    gng_iter     = 0;
     gng_sample_index = 0;
 
     for (;;) {
         // 1) UART non-blocking
         int32_t v = uart_getc_nonblock();
         if (v >= 0) {
-            char c = (char)v;
-
-            if (c == '\r') {
-                // ignore
-            } else if (c == '\n') {
-                rxbuf[rxpos] = '\0';
-                if (rxpos > 0) {
-                    handle_line(rxbuf);
-                }
-                rxpos = 0;
-            } else {
-                if (rxpos < (RXBUF_LEN - 1)) {
-                    rxbuf[rxpos++] = c;
-                } else {
-                    // overflow: reset
-                    rxpos = 0;
-                }
-            }
+            uart_rx_byte((uint8_t)v);
         }
 
         // 2) Satu langkah training GNG setiap loop
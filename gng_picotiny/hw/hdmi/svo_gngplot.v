@@ -0,0 +1,246 @@
+`timescale 1ns / 1ps
+`include "svo_defines.vh"
+
+// ================================================================================
+// svo_gngplot - GNG graph on HDMI, background layer of svo_hdmi_top
+// - framebuffer: 2 x 256x256 x 1 bit (front / back), 8 banks of 16K x 1
+//   (bank = x[2:0], word = {buf, y, x[7:3]}), 8 BSRAM
+// - shown as a PLOT x PLOT square, scaled 2x on 480-line modes and centered;
+//   outside the square (and while CTRL.ON = 0) the output is black
+// - line engine (Bresenham): one pixel per clock into the back buffer,
+//   CLEAR wipes the back buffer in 8192 clocks (all banks at once),
+//   SWAP flips front / back at the next start of frame (no tearing)
+// - register map, word index = addr[3:2]:
+//     0  CTRL  W: bit0 CLEAR, bit1 SWAP, bit2 ON (turns the plot on and
+//                 svo_term off)           R: bit16 BUSY, bit17 SWAP pending, bit18 ON
+//     1  LINE  W: x0 | y0 << 8 | x1 << 16 | y1 << 24 (pixels, y down), point: x0 = x1, y0 = y1
+//     2  INFO  R: PLOT | SCALE << 16
+// - bus: ready one clock after valid; a write waits (ready low) while the
+//   engine is busy or a SWAP is pending, reads never wait
+// - one clock: the bus side and the video stream both run on clk (PicoTiny
+//   clocks the CPU from the pixel clock)
+// ================================================================================
+module svo_gngplot #( `SVO_DEFAULT_PARAMS ) (
+	input clk, resetn,
+
+	// picorv32 native bus
+	input         mem_s_valid,
+	input  [31:0] mem_s_addr,
+	input  [31:0] mem_s_wdata,
+	input  [3:0]  mem_s_wstrb,
+	output        mem_s_ready,
+	output [31:0] mem_s_rdata,
+
+	// 1 while the plot is shown (svo_hdmi_top mutes the terminal overlay)
+	output plot_on,
+
+	// output stream
+	//   tuser[0] ... start of frame
+	output reg out_axis_tvalid,
+	input out_axis_tready,
+	output reg [SVO_BITS_PER_PIXEL-1:0] out_axis_tdata,
+	output reg [0:0] out_axis_tuser
+);
+	`SVO_DECLS
+
+	localparam PLOT  = 240;
+	localparam SCALE = (SVO_VER_PIXELS >= 2 * PLOT) ? 2 : 1;
+	localparam HOFF  = (SVO_HOR_PIXELS - SCALE * PLOT) / 2;
+	localparam VOFF  = (SVO_VER_PIXELS - SCALE * PLOT) / 2;
+
+	localparam [SVO_BITS_PER_PIXEL-1:0] FG_PIXVAL = 24'h00e000;   // {b, g, r}
+	localparam [SVO_BITS_PER_PIXEL-1:0] BG_PIXVAL = 24'h181818;
+
+	localparam REG_CTRL = 2'd0;
+	localparam REG_LINE = 2'd1;
+	localparam REG_INFO = 2'd2;
+
+	localparam ST_IDLE  = 2'd0;
+	localparam ST_CLEAR = 2'd1;
+	localparam ST_LINE  = 2'd2;
+
+	// ---------------- framebuffer ----------------
+	reg        front;
+	reg  [7:0] fb_we;
+	reg        fb_wbit;
+	reg [13:0] fb_waddr;
+	wire       fb_re;
+	wire [13:0] fb_raddr;
+	wire [7:0] fb_rd;
+
+	genvar b;
+	generate for (b = 0; b < 8; b = b + 1) begin : bank
+		reg mem [0:16383];
+		reg rd;
+		always @(posedge clk) begin
+			if (fb_we[b])
+				mem[fb_waddr] <= fb_wbit;
+			if (fb_re)
+				rd <= mem[fb_raddr];
+		end
+		assign fb_rd[b] = rd;
+	end endgenerate
+
+	// ---------------- bus side + draw engine ----------------
+	reg        ready_r;
+	reg [31:0] rdata_r;
+	reg        on_r;
+	reg        pend;
+	reg  [1:0] state;
+
+	reg [12:0] clr_cnt;
+	reg  [7:0] lx, ly, ex, ey;
+	reg        sx, sy;             // 1 = step -1
+	reg signed [11:0] ldx, ldy;    // ldx = |x1 - x0|, ldy = -|y1 - y0|
+	reg signed [11:0] lerr;
+
+	wire [1:0] ri      = mem_s_addr[3:2];
+	wire       wr      = |mem_s_wstrb;
+	wire       idle    = (state == ST_IDLE) && !pend;
+	wire       bus_acc = mem_s_valid && !ready_r && (!wr || idle);
+	wire       bus_wr  = bus_acc && wr;
+
+	wire signed [11:0] e2 = lerr <<< 1;
+	wire step_x = (e2 >= ldy);
+	wire step_y = (e2 <= ldx);
+
+	wire [7:0] w_x0 = mem_s_wdata[7:0];
+	wire [7:0] w_y0 = mem_s_wdata[15:8];
+	wire [7:0] w_x1 = mem_s_wdata[23:16];
+	wire [7:0] w_y1 = mem_s_wdata[31:24];
+
+	reg sof_flip;   // video side: a frame starts this clock
+
+	assign mem_s_ready = ready_r;
+	assign mem_s_rdata = rdata_r;
+	assign plot_on     = on_r;
+
+	always @(posedge clk) begin
+		fb_we <= 8'b0;
+
+		if (!resetn) begin
+			ready_r <= 1'b0;
+			rdata_r <= 32'b0;
+			on_r    <= 1'b0;
+			pend    <= 1'b0;
+			front   <= 1'b0;
+			state   <= ST_IDLE;
+		end else begin
+			ready_r <= 1'b0;
+			if (bus_acc) begin
+				ready_r <= 1'b1;
+				rdata_r <= 32'b0;
+				if (!wr) begin
+					case (ri)
+					REG_CTRL: rdata_r <= {13'b0, on_r, pend, state != ST_IDLE, 16'b0};
+					REG_INFO: rdata_r <= SCALE << 16 | PLOT;
+					default: ;
+					endcase
+				end
+			end
+
+			if (bus_wr && ri == REG_CTRL) begin
+				on_r <= mem_s_wdata[2];
+				if (mem_s_wdata[0]) begin
+					clr_cnt <= 13'd0;
+					state   <= ST_CLEAR;
+				end else if (mem_s_wdata[1]) begin
+					pend <= 1'b1;
+				end
+			end
+
+			if (bus_wr && ri == REG_LINE) begin
+				lx   <= w_x0;
+				ly   <= w_y0;
+				ex   <= w_x1;
+				ey   <= w_y1;
+				sx   <= (w_x1 < w_x0);
+				sy   <= (w_y1 < w_y0);
+				ldx  <= (w_x1 < w_x0) ? w_x0 - w_x1 : w_x1 - w_x0;
+				ldy  <= (w_y1 < w_y0) ? w_y1 - w_y0 : w_y0 - w_y1;
+				lerr <= ((w_x1 < w_x0) ? w_x0 - w_x1 : w_x1 - w_x0) -
+				        ((w_y1 < w_y0) ? w_y0 - w_y1 : w_y1 - w_y0);
+				state <= ST_LINE;
+			end
+
+			case (state)
+			ST_CLEAR: begin
+				fb_we    <= 8'hff;
+				fb_wbit  <= 1'b0;
+				fb_waddr <= {~front, clr_cnt};
+				clr_cnt  <= clr_cnt + 13'd1;
+				if (&clr_cnt)
+					state <= ST_IDLE;
+			end
+			ST_LINE: begin
+				fb_we    <= 8'b1 << lx[2:0];
+				fb_wbit  <= 1'b1;
+				fb_waddr <= {~front, ly, lx[7:3]};
+				if (lx == ex && ly == ey) begin
+					state <= ST_IDLE;
+				end else begin
+					lerr <= lerr + (step_x ? ldy : 12'sd0) + (step_y ? ldx : 12'sd0);
+					if (step_x) lx <= sx ? lx - 8'd1 : lx + 8'd1;
+					if (step_y) ly <= sy ? ly - 8'd1 : ly + 8'd1;
+				end
+			end
+			default: ;
+			endcase
+
+			if (pend && sof_flip) begin
+				front <= ~front;
+				pend  <= 1'b0;
+			end
+		end
+	end
+
+	// ---------------- video stream ----------------
+	// the pixel at the cursor was read from the front buffer at the previous
+	// advance; each advance emits it and reads the next one
+	reg [`SVO_XYBITS-1:0] hcursor;
+	reg [`SVO_XYBITS-1:0] vcursor;
+	reg in_cur;
+	reg [2:0] sel_cur;
+
+	wire adv = !out_axis_tvalid || out_axis_tready;
+
+	wire last_h = (hcursor == SVO_HOR_PIXELS-1);
+	wire last_v = (vcursor == SVO_VER_PIXELS-1);
+	wire [`SVO_XYBITS-1:0] hnext = last_h ? 0 : hcursor + 1;
+	wire [`SVO_XYBITS-1:0] vnext = !last_h ? vcursor : last_v ? 0 : vcursor + 1;
+
+	wire [`SVO_XYBITS-1:0] hrel = hnext - HOFF;
+	wire [`SVO_XYBITS-1:0] vrel = vnext - VOFF;
+	wire in_next = (hnext >= HOFF) && (hrel < SCALE * PLOT) &&
+	               (vnext >= VOFF) && (vrel < SCALE * PLOT);
+	wire [7:0] px_next = hrel >> (SCALE - 1);
+	wire [7:0] py_next = vrel >> (SCALE - 1);
+
+	assign fb_re    = adv;
+	assign fb_raddr = {front, py_next, px_next[7:3]};
+
+	always @(posedge clk) begin
+		sof_flip <= 1'b0;
+
+		if (!resetn) begin
+			hcursor <= 0;
+			vcursor <= 0;
+			in_cur  <= 1'b0;
+			sel_cur <= 3'd0;
+			out_axis_tvalid <= 0;
+			out_axis_tdata <= 0;
+			out_axis_tuser <= 0;
+		end else
+		if (adv) begin
+			out_axis_tvalid <= 1;
+			out_axis_tdata <= !on_r || !in_cur ? 0 : fb_rd[sel_cur] ? FG_PIXVAL : BG_PIXVAL;
+			out_axis_tuser[0] <= !hcursor && !vcursor;
+			sof_flip <= !hcursor && !vcursor;
+
+			hcursor <= hnext;
+			vcursor <= vnext;
+			in_cur  <= in_next;
+			sel_cur <= px_next[2:0];
+		end
+	end
+endmodule
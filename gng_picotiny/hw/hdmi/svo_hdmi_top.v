@@ -33,6 +33,14 @@ module svo_hdmi_top (
 	output term_out_tready,
 	input [7:0] term_in_tdata,
 
+	// GNG plot registers (svo_gngplot, on clk; clk must be clk_pixel)
+	input         plot_valid,
+	input  [31:0] plot_addr,
+	input  [31:0] plot_wdata,
+	input  [3:0]  plot_wstrb,
+	output        plot_ready,
+	output [31:0] plot_rdata,
+
 	// output signals
 	output       tmds_clk_n,
 	output       tmds_clk_p,
@@ -86,10 +94,21 @@ module svo_hdmi_top (
 	wire clk_resetn = resetn && locked_clk_q[3];
 	wire clk_pixel_resetn = locked && resetn_clk_pixel_q[3];
 
-	svo_tcard #( `SVO_PASS_PARAMS ) svo_tcard (
-		.clk(clk_pixel),
+	wire plot_on;
+
+	svo_gngplot #( `SVO_PASS_PARAMS ) svo_gngplot (
+		.clk(clk),
 		.resetn(resetn),
 
+		.mem_s_valid(plot_valid),
+		.mem_s_addr(plot_addr),
+		.mem_s_wdata(plot_wdata),
+		.mem_s_wstrb(plot_wstrb),
+		.mem_s_ready(plot_ready),
+		.mem_s_rdata(plot_rdata),
+
+		.plot_on(plot_on),
+
 		.out_axis_tvalid(vdma_tvalid),
 		.out_axis_tready(vdma_tready),
 		.out_axis_tdata(vdma_tdata),
@@ -114,7 +133,7 @@ module svo_hdmi_top (
 	svo_overlay #( `SVO_PASS_PARAMS ) svo_overlay (
 		.clk(clk_pixel),
 		.resetn(clk_pixel_resetn),
-		.enable(1'b1),
+		.enable(!plot_on),
 
 		.in_axis_tvalid(vdma_tvalid),
 		.in_axis_tready(vdma_tready),
@@ -0,0 +1,299 @@
+`timescale 1ns/1ps
+
+// ================================================================================
+// PicoMem_GNG - GNG winner finder on the picorv32 native bus
+// Port of the V3 NEORV32 CFS winner engine (neorv32_cfs.vhd / neorv32_cfs_engine.vhd)
+// - node_mem: MAXNODES x 32-bit (packed Q1.15 x | y << 16), LANES banks
+//   (node i -> bank i % LANES, row i / LANES), write-only from the bus
+//   (the firmware keeps a shadow copy)
+// - scan: one lane group per clock, only groups holding an active node are
+//   visited (priority encoder on the group mask):
+//     E0 issue  : lowest group with an active node
+//     E1 read   : node_mem row (async read), |dx| / |dy|
+//     E2 dist   : dx^2 + dy^2 in Q2.30 (NO >>15)
+//     E3 tree   : log2(LANES) merge levels of the lane group
+//     E4 merge  : running min1/min2, ties -> lower index (same as the CPU scan)
+//   a search takes (active groups + 4) clocks
+// - register map: the CFS subset gng_cfs.h uses, word index = addr[9:2]
+//     0  CTRL       W: bit0 CLEAR, bit1 START   R: bit16 BUSY, bit17 DONE
+//     8  XIN        Q1.15
+//     9  YIN        Q1.15
+//     10 NODE_COUNT nodes >= NODE_COUNT are ignored
+//     11 ACT_LO     active mask, nodes 0..31
+//     12 ACT_HI     active mask, nodes 32..63
+//     13 OUT_S12    s1 | s2 << 8
+//     14 OUT_MIN1   Q2.30
+//     15 OUT_MIN2   Q2.30
+//     20 INFO       MAXNODES | LANES << 16 (reads 0 without this peripheral)
+//     128 + i       node i
+// - bus: ready one clock after valid (like PicoMem_GPIO), word stores only
+// ================================================================================
+module PicoMem_GNG #(
+  parameter LANES    = 2,   // 1, 2 or 4 distance lanes
+  parameter MAXNODES = 40   // 1..64 (ACT_LO / ACT_HI)
+) (
+  input         clk,
+  input         resetn,
+  input         mem_s_valid,
+  input  [31:0] mem_s_addr,
+  input  [31:0] mem_s_wdata,
+  input  [3:0]  mem_s_wstrb,
+  output        mem_s_ready,
+  output [31:0] mem_s_rdata
+);
+
+ localparam REG_CTRL       = 8'd0;
+ localparam REG_XIN        = 8'd8;
+ localparam REG_YIN        = 8'd9;
+ localparam REG_NODE_COUNT = 8'd10;
+ localparam REG_ACT_LO     = 8'd11;
+ localparam REG_ACT_HI     = 8'd12;
+ localparam REG_OUT_S12    = 8'd13;
+ localparam REG_OUT_MIN1   = 8'd14;
+ localparam REG_OUT_MIN2   = 8'd15;
+ localparam REG_INFO       = 8'd20;
+ localparam NODE_BASE      = 8'd128;
+
+ localparam ROWS   = (MAXNODES + LANES - 1) / LANES;
+ localparam MASK_W = ROWS * LANES;
+
+ // {d[31:0], id[7:0]} candidate, pair = {m1, m2}
+ localparam [39:0] CAND_NONE = {32'hFFFF_FFFF, 8'h00};
+ localparam [79:0] PAIR_NONE = {CAND_NONE, CAND_NONE};
+
+ // merge two sorted pairs (m1 <= m2); a holds the lower node indices so ties
+ // resolve exactly like the sequential 1-node/clock scan
+ function [79:0] merge_pair;
+   input [79:0] a;
+   input [79:0] b;
+   begin
+     if (b[79:48] < a[79:48])
+       merge_pair = {b[79:40], (a[79:48] <= b[39:8]) ? a[79:40] : b[39:0]};
+     else
+       merge_pair = {a[79:40], (b[79:48] < a[39:8]) ? b[79:40] : a[39:0]};
+   end
+ endfunction
+
+ function [15:0] abs_diff;
+   input [15:0] a;
+   input [15:0] b;
+   begin
+     abs_diff = (a >= b) ? (a - b) : (b - a);
+   end
+ endfunction
+
+ // ---------------- bus side ----------------
+ reg        ready_r;
+ reg [31:0] rdata_r;
+
+ reg [15:0] xin_q15;
+ reg [15:0] yin_q15;
+ reg [8:0]  node_count;
+ reg [63:0] act;
+
+ reg        run;
+ reg        done_r;
+
+ reg [7:0]  out_s1;
+ reg [7:0]  out_s2;
+ reg [31:0] out_min1;
+ reg [31:0] out_min2;
+
+ wire [7:0] ri      = mem_s_addr[9:2];
+ wire       bus_acc = mem_s_valid && !ready_r;
+ wire       bus_wr  = bus_acc && (|mem_s_wstrb);
+ wire       start   = bus_wr && (ri == REG_CTRL) && mem_s_wdata[1];
+ wire       clear   = bus_wr && (ri == REG_CTRL) && mem_s_wdata[0];
+ wire       node_we = bus_wr && (ri >= NODE_BASE) && (ri < NODE_BASE + MAXNODES);
+ wire [7:0] node_di = ri - NODE_BASE;
+
+ assign mem_s_ready = ready_r;
+ assign mem_s_rdata = rdata_r;
+
+ always @(posedge clk) begin
+   if (!resetn) begin
+     ready_r    <= 1'b0;
+     rdata_r    <= 32'b0;
+     xin_q15    <= 16'b0;
+     yin_q15    <= 16'b0;
+     node_count <= 9'd2;
+     act        <= 64'b0;
+   end else begin
+     ready_r <= 1'b0;
+     if (bus_acc) begin
+       ready_r <= 1'b1;
+       rdata_r <= 32'b0;
+       if (bus_wr) begin
+         case (ri)
+         REG_XIN:        xin_q15    <= mem_s_wdata[15:0];
+         REG_YIN:        yin_q15    <= mem_s_wdata[15:0];
+         REG_NODE_COUNT: node_count <= mem_s_wdata[8:0];
+         REG_ACT_LO:     act[31:0]  <= mem_s_wdata;
+         REG_ACT_HI:     act[63:32] <= mem_s_wdata;
+         default: ;
+         endcase
+       end else begin
+         case (ri)
+         REG_CTRL:       rdata_r <= {14'b0, done_r, run, 16'b0};
+         REG_XIN:        rdata_r <= {16'b0, xin_q15};
+         REG_YIN:        rdata_r <= {16'b0, yin_q15};
+         REG_NODE_COUNT: rdata_r <= {23'b0, node_count};
+         REG_ACT_LO:     rdata_r <= act[31:0];
+         REG_ACT_HI:     rdata_r <= act[63:32];
+         REG_OUT_S12:    rdata_r <= {16'b0, out_s2, out_s1};
+         REG_OUT_MIN1:   rdata_r <= out_min1;
+         REG_OUT_MIN2:   rdata_r <= out_min2;
+         REG_INFO:       rdata_r <= LANES * 32'h1_0000 + MAXNODES;
+         default: ;
+         endcase
+       end
+     end
+   end
+ end
+
+ // ---------------- node_mem banks (no reset -> distributed RAM) ----------------
+ reg  [7:0]          p0_row;
+ wire [LANES*32-1:0] node_rd;
+
+ genvar l;
+ generate
+   for (l = 0; l < LANES; l = l + 1) begin : bank
+     reg [31:0] mem [0:ROWS-1];
+     always @(posedge clk) begin
+       if (node_we && (node_di % LANES == l)) mem[node_di / LANES] <= mem_s_wdata;
+     end
+     assign node_rd[32*l +: 32] = mem[p0_row];
+   end
+ endgenerate
+
+ // ---------------- issue: lowest lane group with an active node ----------------
+ reg [MASK_W-1:0] scan_mask;   // active nodes not yet issued
+ reg [MASK_W-1:0] scan_init;   // ACT & (i < NODE_COUNT), loaded at START
+ reg [15:0]       scan_x;
+ reg [15:0]       scan_y;
+
+ reg       ffs_any;
+ reg [7:0] ffs_row;
+ integer   k;
+
+ always @* begin
+   ffs_any = 1'b0;
+   ffs_row = 8'd0;
+   for (k = ROWS - 1; k >= 0; k = k - 1) begin
+     if (|scan_mask[k*LANES +: LANES]) begin
+       ffs_any = 1'b1;
+       ffs_row = k;
+     end
+   end
+   for (k = 0; k < MASK_W; k = k + 1) begin
+     scan_init[k] = (k < MAXNODES) && (k < node_count) && act[k];
+   end
+ end
+
+ // ---------------- pipeline registers (pN_v = stage N holds a lane group) ----------------
+ reg                 p0_v, p1_v, p2_v, p3_v;
+ reg [LANES-1:0]     p0_lv, p1_lv, p2_lv;
+ reg [7:0]           p1_base, p2_base;
+ reg [LANES*16-1:0]  p1_dx, p1_dy;
+ reg [LANES*32-1:0]  p2_d;
+ reg [79:0]          p3_best;
+
+ // E3 lane tree (combinational, feeds p3_best)
+ reg [LANES*80-1:0] tree;
+ reg [7:0]          lane_id;
+ integer t, s;
+
+ always @* begin
+   for (t = 0; t < LANES; t = t + 1) begin
+     lane_id = p2_base + t;
+     if (p2_lv[t]) tree[80*t +: 80] = {p2_d[32*t +: 32], lane_id, CAND_NONE};
+     else          tree[80*t +: 80] = PAIR_NONE;
+   end
+   for (s = 1; s < LANES; s = s * 2) begin
+     for (t = 0; t + s < LANES; t = t + 2 * s) begin
+       tree[80*t +: 80] = merge_pair(tree[80*t +: 80], tree[80*(t+s) +: 80]);
+     end
+   end
+ end
+
+ integer j;
+
+ always @(posedge clk) begin
+   if (!resetn) begin
+     run       <= 1'b0;
+     done_r    <= 1'b0;
+     scan_mask <= {MASK_W{1'b0}};
+     p0_v <= 1'b0; p1_v <= 1'b0; p2_v <= 1'b0; p3_v <= 1'b0;
+     out_s1    <= 8'd0;
+     out_s2    <= 8'd0;
+     out_min1  <= 32'hFFFF_FFFF;
+     out_min2  <= 32'hFFFF_FFFF;
+   end else begin
+     // ---------------- E4: running result vs lane group ----------------
+     if (p3_v) begin
+       {out_min1, out_s1, out_min2, out_s2} <=
+         merge_pair({out_min1, out_s1, out_min2, out_s2}, p3_best);
+     end
+
+     // ---------------- E3: merge tree ----------------
+     p3_v    <= p2_v;
+     p3_best <= tree[79:0];
+
+     // ---------------- E2: Q2.30 distance ----------------
+     p2_v    <= p1_v;
+     p2_base <= p1_base;
+     p2_lv   <= p1_lv;
+     for (j = 0; j < LANES; j = j + 1) begin
+       p2_d[32*j +: 32] <= p1_dx[16*j +: 16] * p1_dx[16*j +: 16] +
+                           p1_dy[16*j +: 16] * p1_dy[16*j +: 16];
+     end
+
+     // ---------------- E1: node row read, differences ----------------
+     p1_v    <= p0_v;
+     p1_base <= p0_row * LANES;
+     p1_lv   <= p0_lv;
+     for (j = 0; j < LANES; j = j + 1) begin
+       p1_dx[16*j +: 16] <= abs_diff(scan_x, node_rd[32*j +: 16]);
+       p1_dy[16*j +: 16] <= abs_diff(scan_y, node_rd[32*j+16 +: 16]);
+     end
+
+     // ---------------- E0: issue the next active lane group ----------------
+     p0_v <= 1'b0;
+     if (run) begin
+       if (!ffs_any) begin
+         // nothing left to issue: done once the pipeline has drained
+         if (!p0_v && !p1_v && !p2_v && !p3_v) begin
+           run    <= 1'b0;
+           done_r <= 1'b1;
+         end
+       end else begin
+         p0_v   <= 1'b1;
+         p0_row <= ffs_row;
+         p0_lv  <= scan_mask[ffs_row*LANES +: LANES];
+         scan_mask[ffs_row*LANES +: LANES] <= {LANES{1'b0}};
+       end
+     end
+
+     // ---------------- control: CLEAR aborts, START loads a new search ----------------
+     if (clear) begin
+       run    <= 1'b0;
+       done_r <= 1'b0;
+       p0_v <= 1'b0; p1_v <= 1'b0; p2_v <= 1'b0; p3_v <= 1'b0;
+     end
+
+     if (start) begin
+       run       <= 1'b1;
+       done_r    <= 1'b0;
+       scan_x    <= xin_q15;
+       scan_y    <= yin_q15;
+       scan_mask <= scan_init;
+       p0_v <= 1'b0; p1_v <= 1'b0; p2_v <= 1'b0; p3_v <= 1'b0;
+       out_s1    <= 8'd0;
+       out_s2    <= 8'd0;
+       out_min1  <= 32'hFFFF_FFFF;
+       out_min2  <= 32'hFFFF_FFFF;
+     end
+   end
+ end
+
+endmodule
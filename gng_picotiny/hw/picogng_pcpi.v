@@ -0,0 +1,154 @@
+`timescale 1ns/1ps
+
+// ================================================================================
+// picorv32_pcpi_gng - GNG distance / argmin co-processor on the picorv32 PCPI
+// Low-LUT alternative to PicoMem_GNG (picogng.v): the CPU walks the active
+// nodes, the unit does the squared distance and keeps the two nearest
+// - custom-0 R-type (opcode 0001011, funct3 000), funct7:
+//     0 DIST2  rd = dx^2 + dy^2 of the packed Q1.15 words rs1, rs2 (Q2.30)
+//     1 SMP    sample = rs1, min1 = min2 = ~0, s1 = s2 = 0       rd = 0
+//     2 ACC    node word rs1, node id rs2: d = DIST2(sample, rs1),
+//                d < min1        -> (s2, min2) = (s1, min1), (s1, min1) = (id, d)
+//                else d < min2   -> (s2, min2) = (id, d)          rd = d
+//              i.e. the loop of gng_find_winners_sw with ids walked upwards
+//     3 S12    rd = s1 | s2 << 8
+//     4 MIN1   rd = min1 (Q2.30)
+//     5 MIN2   rd = min2 (Q2.30)
+//   anything else is left to the core (CATCH_ILLINSN trap)
+// - one 16 x 16 multiplier, dx^2 then dy^2: DIST2 / ACC are ready 4 clocks
+//   after pcpi_valid (|dx| |dy|, dx^2, + dy^2, compare / write back), the
+//   register ops after 1, so pcpi_wait stays low (well inside the 16-clock
+//   PCPI timeout)
+// ================================================================================
+module picorv32_pcpi_gng (
+  input             clk,
+  input             resetn,
+  input             pcpi_valid,
+  input      [31:0] pcpi_insn,
+  input      [31:0] pcpi_rs1,
+  input      [31:0] pcpi_rs2,
+  output reg        pcpi_wr,
+  output reg [31:0] pcpi_rd,
+  output            pcpi_wait,
+  output reg        pcpi_ready
+);
+
+ localparam [6:0] OP_DIST2 = 7'd0;
+ localparam [6:0] OP_SMP   = 7'd1;
+ localparam [6:0] OP_ACC   = 7'd2;
+ localparam [6:0] OP_S12   = 7'd3;
+ localparam [6:0] OP_MIN1  = 7'd4;
+ localparam [6:0] OP_MIN2  = 7'd5;
+
+ localparam [1:0] ST_IDLE = 2'd0;
+ localparam [1:0] ST_SQX  = 2'd1;
+ localparam [1:0] ST_SQY  = 2'd2;
+ localparam [1:0] ST_WB   = 2'd3;
+
+ function [15:0] abs_diff;
+   input [15:0] a;
+   input [15:0] b;
+   begin
+     abs_diff = (a >= b) ? (a - b) : (b - a);
+   end
+ endfunction
+
+ wire [6:0] op       = pcpi_insn[31:25];
+ wire       insn_gng = pcpi_valid && (pcpi_insn[6:0] == 7'b0001011) &&
+                       (pcpi_insn[14:12] == 3'b000) && (op <= OP_MIN2);
+
+ // ---------------- argmin state ----------------
+ reg [31:0] smp;     // packed Q1.15 sample
+ reg [31:0] min1;
+ reg [31:0] min2;
+ reg [7:0]  s1;
+ reg [7:0]  s2;
+
+ // ---------------- distance: one shared multiplier ----------------
+ reg [1:0]  st;
+ reg [15:0] dx;
+ reg [15:0] dy;
+ reg [31:0] acc;
+ reg        is_acc;
+ reg [7:0]  id;
+
+ wire [15:0] m_in = (st == ST_SQX) ? dx : dy;
+ wire [31:0] m_sq = m_in * m_in;
+
+ // DIST2: rs1 against rs2, ACC: rs1 against the sample
+ wire [31:0] ref_w = (op == OP_ACC) ? smp : pcpi_rs2;
+
+ assign pcpi_wait = 1'b0;
+
+ always @(posedge clk) begin
+   pcpi_wr    <= 1'b0;
+   pcpi_ready <= 1'b0;
+   if (!resetn) begin
+     st   <= ST_IDLE;
+     smp  <= 32'b0;
+     min1 <= 32'hFFFF_FFFF;
+     min2 <= 32'hFFFF_FFFF;
+     s1   <= 8'd0;
+     s2   <= 8'd0;
+   end else begin
+     case (st)
+     ST_IDLE: begin
+       // pcpi_ready high: the core drops pcpi_valid on this edge, no re-issue
+       if (insn_gng && !pcpi_ready) begin
+         case (op)
+         OP_DIST2, OP_ACC: begin
+           dx     <= abs_diff(ref_w[15:0], pcpi_rs1[15:0]);
+           dy     <= abs_diff(ref_w[31:16], pcpi_rs1[31:16]);
+           is_acc <= (op == OP_ACC);
+           id     <= pcpi_rs2[7:0];
+           st     <= ST_SQX;
+         end
+         OP_SMP: begin
+           smp        <= pcpi_rs1;
+           min1       <= 32'hFFFF_FFFF;
+           min2       <= 32'hFFFF_FFFF;
+           s1         <= 8'd0;
+           s2         <= 8'd0;
+           pcpi_rd    <= 32'b0;
+           pcpi_wr    <= 1'b1;
+           pcpi_ready <= 1'b1;
+         end
+         default: begin
+           pcpi_rd    <= (op == OP_S12)  ? {16'b0, s2, s1} :
+                         (op == OP_MIN1) ? min1 : min2;
+           pcpi_wr    <= 1'b1;
+           pcpi_ready <= 1'b1;
+         end
+         endcase
+       end
+     end
+     ST_SQX: begin
+       acc <= m_sq;
+       st  <= ST_SQY;
+     end
+     ST_SQY: begin
+       acc <= acc + m_sq;
+       st  <= ST_WB;
+     end
+     ST_WB: begin
+       pcpi_rd    <= acc;
+       pcpi_wr    <= 1'b1;
+       pcpi_ready <= 1'b1;
+       st         <= ST_IDLE;
+       if (is_acc) begin
+         if (acc < min1) begin
+           min2 <= min1;
+           s2   <= s1;
+           min1 <= acc;
+           s1   <= id;
+         end else if (acc < min2) begin
+           min2 <= acc;
+           s2   <= id;
+         end
+       end
+     end
+     endcase
+   end
+ end
+
+endmodule
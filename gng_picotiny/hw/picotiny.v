@@ -1,6 +1,12 @@
 `timescale 1ns/1ps
 
-module picotiny (
+// GNG_PERIPH = 1: PicoMem_GNG winner finder on S3 (picogng.v)
+// GNG_PCPI   = 1: picorv32_pcpi_gng distance / argmin co-processor (picogng_pcpi.v),
+//                 the low-LUT option; firmware make PCPI=yes
+module picotiny #(
+  parameter GNG_PERIPH = 1,
+  parameter GNG_PCPI   = 0
+) (
   input clk,
   input resetn,
 
@@ -48,12 +54,29 @@ module picotiny (
  wire [3:0] picop_wstrb;
  wire [31:0] picop_rdata;
 
- wire wbp_valid;
- wire wbp_ready;
- wire [31:0] wbp_addr;
- wire [31:0] wbp_wdata;
- wire [3:0] wbp_wstrb;
- wire [31:0] wbp_rdata;
+ wire s3_valid;
+ wire s3_ready;
+ wire [31:0] s3_addr;
+ wire [31:0] s3_wdata;
+ wire [3:0] s3_wstrb;
+ wire [31:0] s3_rdata;
+
+ wire gngp_valid;
+ wire gngp_ready;
+ wire [31:0] gngp_rdata;
+
+ wire pcpi_valid;
+ wire [31:0] pcpi_insn;
+ wire [31:0] pcpi_rs1;
+ wire [31:0] pcpi_rs2;
+ wire pcpi_wr;
+ wire [31:0] pcpi_rd;
+ wire pcpi_wait;
+ wire pcpi_ready;
+
+ wire plot_valid;
+ wire plot_ready;
+ wire [31:0] plot_rdata;
  
  wire spimemcfg_valid;
  wire spimemcfg_ready;
@@ -107,7 +130,8 @@ Reset_Sync u_Reset_Sync (
 );
 
 picorv32 #(
-   .PROGADDR_RESET(32'h8000_0000)
+   .PROGADDR_RESET(32'h8000_0000),
+   .ENABLE_PCPI(GNG_PCPI != 0)
 ) u_picorv32 (
    .clk(clk_p),
    .resetn(sys_resetn),
@@ -119,10 +143,40 @@ picorv32 #(
    .mem_wdata(mem_wdata),
    .mem_wstrb(mem_wstrb),
    .mem_rdata(mem_rdata),
+   .pcpi_valid(pcpi_valid),
+   .pcpi_insn(pcpi_insn),
+   .pcpi_rs1(pcpi_rs1),
+   .pcpi_rs2(pcpi_rs2),
+   .pcpi_wr(pcpi_wr),
+   .pcpi_rd(pcpi_rd),
+   .pcpi_wait(pcpi_wait),
+   .pcpi_ready(pcpi_ready),
    .irq(32'b0),
    .eoi()
  );
 
+generate
+  if (GNG_PCPI) begin : gen_pcpi
+    picorv32_pcpi_gng u_pcpi_gng (
+      .clk(clk_p),
+      .resetn(sys_resetn),
+      .pcpi_valid(pcpi_valid),
+      .pcpi_insn(pcpi_insn),
+      .pcpi_rs1(pcpi_rs1),
+      .pcpi_rs2(pcpi_rs2),
+      .pcpi_wr(pcpi_wr),
+      .pcpi_rd(pcpi_rd),
+      .pcpi_wait(pcpi_wait),
+      .pcpi_ready(pcpi_ready)
+    );
+  end else begin : gen_no_pcpi
+    assign pcpi_wr    = 1'b0;
+    assign pcpi_rd    = 32'b0;
+    assign pcpi_wait  = 1'b0;
+    assign pcpi_ready = 1'b0;
+  end
+endgenerate
+
  PicoMem_SRAM_8KB u_PicoMem_SRAM_8KB_7 (
   .resetn(sys_resetn),
   .clk(clk_p),
@@ -137,7 +191,8 @@ picorv32 #(
  // S0 0x0000_0000 -> SPI Flash XIP
  // S1 0x4000_0000 -> SRAM
  // S2 0x8000_0000 -> PicoPeriph
- // S3 0xC000_0000 -> Wishbone
+ // S3 0xC000_0000 -> GNG winner finder (picogng.v)
+ //    0xC000_1000 -> GNG HDMI plot (hdmi/svo_gngplot.v)
  PicoMem_Mux_1_4 u_PicoMem_Mux_1_4_8 (
   .picom_valid(mem_valid),
   .picom_ready(mem_ready),
@@ -167,14 +222,20 @@ picorv32 #(
   .picos2_wstrb(picop_wstrb),
   .picos2_rdata(picop_rdata),
 
-  .picos3_valid(wbp_valid),
-  .picos3_ready(wbp_ready),
-  .picos3_addr(wbp_addr),
-  .picos3_wdata(wbp_wdata),
-  .picos3_wstrb(wbp_wstrb),
-  .picos3_rdata(wbp_rdata)
+  .picos3_valid(s3_valid),
+  .picos3_ready(s3_ready),
+  .picos3_addr(s3_addr),
+  .picos3_wdata(s3_wdata),
+  .picos3_wstrb(s3_wstrb),
+  .picos3_rdata(s3_rdata)
  );
 
+ // S3: addr[12] selects the plot
+ assign gngp_valid = s3_valid & ~s3_addr[12];
+ assign plot_valid = s3_valid &  s3_addr[12];
+ assign s3_ready   = s3_addr[12] ? plot_ready : gngp_ready;
+ assign s3_rdata   = s3_addr[12] ? plot_rdata : gngp_rdata;
+
 // S0 0x8000_0000 -> BOOTROM
 // S1 0x8100_0000 -> SPI Flash
 // S2 0x8200_0000 -> GPIO
@@ -286,7 +347,29 @@ picorv32 #(
  );
 
 
-assign wbp_ready = 1'b1;
+generate
+  if (GNG_PERIPH) begin : gen_gngp
+    PicoMem_GNG #(
+      .LANES(2),
+      .MAXNODES(40)
+    ) u_PicoMem_GNG (
+      .resetn(sys_resetn),
+      .clk(clk_p),
+      .mem_s_valid(gngp_valid),
+      .mem_s_ready(gngp_ready),
+      .mem_s_addr(s3_addr),
+      .mem_s_wdata(s3_wdata),
+      .mem_s_wstrb(s3_wstrb),
+      .mem_s_rdata(gngp_rdata)
+    );
+  end else begin : gen_no_gngp
+    // no winner finder: answer every access, INFO reads 0 (firmware: PCPI / CPU search)
+    reg gngp_ready_r;
+    always @(posedge clk_p) gngp_ready_r <= sys_resetn && gngp_valid && !gngp_ready_r;
+    assign gngp_ready = gngp_ready_r;
+    assign gngp_rdata = 32'b0;
+  end
+endgenerate
  
 wire svo_term_valid;
 assign svo_term_valid = (uart_valid && uart_ready) & (~uart_addr[2]) & uart_wstrb[0];
@@ -304,6 +387,13 @@ svo_hdmi_top u_hdmi (
 	.term_out_tready(),
 	.term_in_tdata( uart_wdata[7:0] ),
 
+	.plot_valid(plot_valid),
+	.plot_addr(s3_addr),
+	.plot_wdata(s3_wdata),
+	.plot_wstrb(s3_wstrb),
+	.plot_ready(plot_ready),
+	.plot_rdata(plot_rdata),
+
 	// output signals
 	.tmds_clk_n(tmds_clk_n),
 	.tmds_clk_p(tmds_clk_p),
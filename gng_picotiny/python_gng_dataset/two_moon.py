@@ -1,10 +1,17 @@
+import sys
 import time
+from pathlib import Path
+
 import serial
 import numpy as np
 from sklearn.datasets import make_moons
 import matplotlib.pyplot as plt
 from matplotlib.animation import FuncAnimation
 
+# receiver shared by the host tools (repo root /gng_host)
+sys.path.insert(0, str(Path(__file__).resolve().parents[2] / "gng_host"))
+import gngio  # noqa: E402
+
 # =======================
 # Konfigurasi UART & data
 # =======================
@@ -29,95 +36,70 @@ ser = serial.Serial(PORT, BAUD, timeout=0.5)
 print("[INFO] Serial opened.")
 
 # =======================
-# Kirim dataset ke PicoRV
+# Kirim dataset ke PicoRV (binary frames, sama dengan NEORV32 V3)
 # =======================
+BATCH_POINTS = 20
+
 print("[INFO] Sending dataset...")
-for i, (xv, yv) in enumerate(Xn, start=1):
-    line = f"DATA:{xv:.5f},{yv:.5f};\n"
-    ser.write(line.encode("ascii"))
-    print(f"[TX] {line.strip()}")
-
-    ack = ser.readline().decode("ascii", errors="ignore").strip()
-    if ack:
-        print(f"[RX] {ack}")
-    else:
-        print(f"[WARN] No ACK for sample {i}")
+for i in range(0, len(Xn), BATCH_POINTS):
+    chunk = Xn[i:i + BATCH_POINTS]
+    for fr in gngio.encode_data_batch(chunk):
+        ser.write(fr)
+    print(f"[TX] DATA_BATCH count={len(chunk)} idx={i}")
+    time.sleep(0.01)
 
 # Beritahu firmware bahwa dataset selesai
-ser.write(b"DONE;\n")
-print("[TX] DONE;")
+ser.write(gngio.encode_frame(gngio.CMD_DONE))
+print("[TX] DONE")
 print("[INFO] Dataset sent. Switching to LIVE GNG mode...")
 
 # Setelah dataset selesai, pakai non-blocking read
 ser.timeout = 0
-ser.reset_input_buffer()
 
 # =======================
 # Buffer & state GNG (diupdate dari UART)
 # =======================
-line_buffer = ""          # buffer untuk potongan line UART
-latest_nodes = []         # list[(x,y)]
+parser = gngio.FrameParser()
+text_buffer = ""          # teks di luar frame (START / ERR)
+latest_nodes = {}         # id -> (x,y)
 latest_edges = []         # list[(i,j)]
 
 
-def parse_gng_line(line: str):
-    """
-    line: string mulai dari 'GNG:...'
-    Format payload yang diharapkan:
-      GNG:N:0,x0,y0;N:1,x1,y1;...;E:0,1;E:1,2;
-    """
+def handle_frame(fr):
     global latest_nodes, latest_edges
-    payload = line[4:]  # buang 'GNG:'
 
-    nodes = []
-    edges = []
+    if fr.cmd == gngio.CMD_GNG_NODES:
+        _, nodes = gngio.decode_nodes(fr.payload)
+        latest_nodes = {int(n["id"]): (n["x"] / 1000.0, n["y"] / 1000.0) for n in nodes}
 
-    parts = [p for p in payload.split(';') if p]
-    for p in parts:
-        if p.startswith("N:"):
-            # N:id,x,y
-            _, rest = p.split(":", 1)
-            _id_str, xs, ys = rest.split(",")
-            nodes.append((float(xs), float(ys)))
-        elif p.startswith("E:"):
-            # E:a,b
-            _, rest = p.split(":", 1)
-            a_str, b_str = rest.split(",")
-            edges.append((int(a_str), int(b_str)))
+    elif fr.cmd == gngio.CMD_GNG_EDGES:
+        _, edges = gngio.decode_edges(fr.payload)
+        latest_edges = [(int(e["a"]), int(e["b"])) for e in edges]
 
-    # update state global
-    latest_nodes = nodes
-    latest_edges = edges
+    elif fr.cmd == gngio.CMD_PROF:
+        d = gngio.decode_prof(fr.payload)
+        print(f"[RX] frame={d['frame_id']} step={d.get('step')} cyc_step={d['cyc_total']}")
 
 
 def poll_serial():
     """
-    Baca semua data yang ada di UART (non-blocking),
-    pecah per-baris, dan parse semua line yang diawali 'GNG:'.
+    Baca semua data yang ada di UART (non-blocking) dan proses frame-nya;
+    byte di luar frame dicetak sebagai teks.
     """
-    global line_buffer
-
-    while True:
-        n = ser.in_waiting
-        if n <= 0:
-            break
-
-        data = ser.read(n)
-        if not data:
-            break
-
-        text = data.decode("ascii", errors="ignore")
-        line_buffer += text
-
-        # proses semua line yang lengkap
-        while "\n" in line_buffer:
-            line, line_buffer = line_buffer.split("\n", 1)
-            line = line.strip()
-            if not line:
-                continue
+    global text_buffer
+
+    n = ser.in_waiting
+    if n > 0:
+        for fr in parser.feed(ser.read(n)):
+            handle_frame(fr)
+        text_buffer += parser.text.decode("ascii", errors="ignore")
+        parser.text.clear()
+
+    while "\n" in text_buffer:
+        line, text_buffer = text_buffer.split("\n", 1)
+        line = line.strip()
+        if line:
             print(f"[RX] {line}")
-            if line.startswith("GNG:"):
-                parse_gng_line(line)
 
 
 # =======================
@@ -166,8 +148,8 @@ def update(frame):
     global latest_nodes, latest_edges, edge_lines
 
     if latest_nodes:
-        xs = [p[0] for p in latest_nodes]
-        ys = [p[1] for p in latest_nodes]
+        xs = [p[0] for p in latest_nodes.values()]
+        ys = [p[1] for p in latest_nodes.values()]
         offsets = np.column_stack((xs, ys))
     else:
         # penting: kalau kosong, kasih array 0x2 biar tidak error IndexError
@@ -182,7 +164,7 @@ def update(frame):
     # 3) gambar edge baru berdasarkan latest_edges
     if latest_edges and latest_nodes:
         for a, b in latest_edges:
-            if 0 <= a < len(latest_nodes) and 0 <= b < len(latest_nodes):
+            if a in latest_nodes and b in latest_nodes:
                 x1, y1 = latest_nodes[a]
                 x2, y2 = latest_nodes[b]
                 (ln,) = ax.plot(
@@ -196,7 +178,7 @@ def update(frame):
     # pertama hapus semua teks lama dengan cara simple:
     for artist in list(ax.texts):
         artist.remove()
-    for idx, (xv, yv) in enumerate(latest_nodes):
+    for idx, (xv, yv) in latest_nodes.items():
         ax.text(
             xv, yv,
             str(idx),
@@ -0,0 +1,217 @@
+`timescale 1ns/1ps
+
+// ================================================================================
+// picogng_pcpi_tb - self-checking bench of picorv32_pcpi_gng (hw/picogng_pcpi.v)
+// Drives the PCPI port the way picorv32 does (pcpi_valid held with insn / rs1 /
+// rs2 until pcpi_ready, dropped after the edge that shows it, 16-clock timeout)
+// and checks against a reference in the bench:
+// - DIST2 of random Q1.15 [0, 1) word pairs: rd = dx^2 + dy^2
+// - sets of 1..40 random nodes (every 7th a copy of an earlier one, so ties
+//   occur): SMP, one ACC per node with ids upwards (rd = d), then S12 / MIN1 /
+//   MIN2 = the strict-< two-nearest scan of gng_find_winners_sw (ties keep
+//   the lower id, s2 = 0 / min2 = ~0 with one node)
+// - funct7 6, funct3 1 and the base MUL opcode: no pcpi_ready within the
+//   timeout and the argmin state untouched
+// $random without a seed, so every run sees the same sets. Prints the ops,
+// the worst ready latency and "PASS" / "FAIL".
+//
+//   iverilog -o picogng_pcpi_tb ../hw/picogng_pcpi.v picogng_pcpi_tb.v && vvp picogng_pcpi_tb
+// Not run yet: no iverilog / simulator result exists for this bench.
+// ================================================================================
+module picogng_pcpi_tb;
+
+ localparam [6:0] OP_DIST2 = 7'd0;
+ localparam [6:0] OP_SMP   = 7'd1;
+ localparam [6:0] OP_ACC   = 7'd2;
+ localparam [6:0] OP_S12   = 7'd3;
+ localparam [6:0] OP_MIN1  = 7'd4;
+ localparam [6:0] OP_MIN2  = 7'd5;
+
+ localparam [6:0] CUSTOM0  = 7'b0001011;
+ localparam [6:0] OP_REG   = 7'b0110011;   // MUL / DIV live here
+ localparam integer TIMEOUT = 16;
+
+ reg         clk = 1'b0;
+ reg         resetn = 1'b0;
+ reg         pcpi_valid = 1'b0;
+ reg  [31:0] pcpi_insn = 32'b0;
+ reg  [31:0] pcpi_rs1 = 32'b0;
+ reg  [31:0] pcpi_rs2 = 32'b0;
+ wire        pcpi_wr;
+ wire [31:0] pcpi_rd;
+ wire        pcpi_wait;
+ wire        pcpi_ready;
+
+ always #20.833 clk = ~clk;   // 24 MHz
+
+ picorv32_pcpi_gng dut (
+   .clk(clk), .resetn(resetn),
+   .pcpi_valid(pcpi_valid), .pcpi_insn(pcpi_insn), .pcpi_rs1(pcpi_rs1), .pcpi_rs2(pcpi_rs2),
+   .pcpi_wr(pcpi_wr), .pcpi_rd(pcpi_rd), .pcpi_wait(pcpi_wait), .pcpi_ready(pcpi_ready)
+ );
+
+ integer errors = 0;
+ integer ops = 0;
+ integer lat_max = 0;
+ reg     ok;
+ reg [31:0] rd;
+
+ // one instruction: rd, ok = 1 if the unit answered within the timeout
+ task pcpi;
+   input [6:0]  f7;
+   input [2:0]  f3;
+   input [6:0]  opcode;
+   input [31:0] a;
+   input [31:0] b;
+   integer n;
+   begin
+     pcpi_insn  <= {f7, 5'd12, 5'd11, f3, 5'd10, opcode};
+     pcpi_rs1   <= a;
+     pcpi_rs2   <= b;
+     pcpi_valid <= 1'b1;
+     ok = 1'b0;
+     n  = 0;
+     while (!ok && n < TIMEOUT) begin
+       @(posedge clk);
+       n = n + 1;
+       if (pcpi_ready) begin
+         ok = 1'b1;
+         rd = pcpi_rd;
+         if (!pcpi_wr) begin
+           errors = errors + 1;
+           $display("op %0d: pcpi_ready without pcpi_wr", f7);
+         end
+       end
+       if (pcpi_wait) begin
+         errors = errors + 1;
+         $display("op %0d: pcpi_wait high", f7);
+       end
+     end
+     pcpi_valid <= 1'b0;
+     @(posedge clk);
+     if (ok && n > lat_max) lat_max = n;
+     ops = ops + 1;
+   end
+ endtask
+
+ task gng;
+   input [6:0]  f7;
+   input [31:0] a;
+   input [31:0] b;
+   begin
+     pcpi(f7, 3'b000, CUSTOM0, a, b);
+     if (!ok) begin
+       errors = errors + 1;
+       $display("op %0d: no pcpi_ready within %0d clocks", f7, TIMEOUT);
+     end
+   end
+ endtask
+
+ task want;
+   input [31:0]  v;
+   input [255:0] what;
+   begin
+     if (rd !== v) begin
+       errors = errors + 1;
+       $display("%0s: %h, want %h", what, rd, v);
+     end
+   end
+ endtask
+
+ function [31:0] dist2;
+   input [31:0] a;
+   input [31:0] b;
+   reg   [15:0] dx, dy;
+   begin
+     dx = (a[15:0] >= b[15:0]) ? a[15:0] - b[15:0] : b[15:0] - a[15:0];
+     dy = (a[31:16] >= b[31:16]) ? a[31:16] - b[31:16] : b[31:16] - a[31:16];
+     dist2 = dx * dx + dy * dy;
+   end
+ endfunction
+
+ function [31:0] rnd_q15;
+   input dummy;
+   begin
+     rnd_q15 = $random & 32'h7FFF_7FFF;
+   end
+ endfunction
+
+ reg  [31:0] nodes [0:39];
+ reg  [31:0] smp, d, min1, min2;
+ reg  [7:0]  s1, s2;
+ integer     t, k, n;
+
+ initial begin
+   repeat (5) @(posedge clk);
+   resetn <= 1'b1;
+   @(posedge clk);
+
+   // DIST2
+   for (t = 0; t < 200; t = t + 1) begin
+     nodes[0] = rnd_q15(0);
+     nodes[1] = (t < 4) ? {(t[0] ? 16'h7FFF : 16'h0000), 16'h7FFF} : rnd_q15(0);
+     gng(OP_DIST2, nodes[0], nodes[1]);
+     want(dist2(nodes[1], nodes[0]), "DIST2");
+   end
+
+   // SMP + ACC per node, then S12 / MIN1 / MIN2
+   for (t = 0; t < 100; t = t + 1) begin
+     n = 1 + ($random & 32'h7FFF) % 40;
+     for (k = 0; k < n; k = k + 1)
+       nodes[k] = (k % 7 == 6) ? nodes[k - 3] : rnd_q15(0);
+     smp  = rnd_q15(0);
+     min1 = 32'hFFFF_FFFF;
+     min2 = 32'hFFFF_FFFF;
+     s1   = 8'd0;
+     s2   = 8'd0;
+     gng(OP_SMP, smp, 32'b0);
+     want(32'b0, "SMP");
+     for (k = 0; k < n; k = k + 1) begin
+       d = dist2(smp, nodes[k]);
+       gng(OP_ACC, nodes[k], k);
+       want(d, "ACC");
+       if (d < min1) begin
+         min2 = min1;
+         s2   = s1;
+         min1 = d;
+         s1   = k;
+       end else if (d < min2) begin
+         min2 = d;
+         s2   = k;
+       end
+     end
+     gng(OP_S12, 32'b0, 32'b0);
+     want({16'b0, s2, s1}, "S12");
+     gng(OP_MIN1, 32'b0, 32'b0);
+     want(min1, "MIN1");
+     gng(OP_MIN2, 32'b0, 32'b0);
+     want(min2, "MIN2");
+
+     // left to the core: no answer, state kept
+     pcpi(7'd6, 3'b000, CUSTOM0, smp, 32'd1);
+     if (ok) begin
+       errors = errors + 1;
+       $display("funct7 6 answered");
+     end
+     pcpi(OP_ACC, 3'b001, CUSTOM0, 32'b0, 32'd1);
+     if (ok) begin
+       errors = errors + 1;
+       $display("custom-0 funct3 1 answered");
+     end
+     pcpi(7'd1, 3'b000, OP_REG, smp, smp);
+     if (ok) begin
+       errors = errors + 1;
+       $display("MUL answered");
+     end
+     gng(OP_S12, 32'b0, 32'b0);
+     want({16'b0, s2, s1}, "S12 after foreign insns");
+     gng(OP_MIN1, 32'b0, 32'b0);
+     want(min1, "MIN1 after foreign insns");
+   end
+
+   $display("picogng_pcpi: %0d ops, worst ready latency %0d clocks (timeout %0d), %0d errors: %0s",
+            ops, lat_max, TIMEOUT, errors, (errors == 0) ? "PASS" : "FAIL");
+   $finish;
+ end
+
+endmodule
@@ -0,0 +1,479 @@
+// decoder.js - live viewer worker: serial bytes -> network / PROF state
+//
+// The page posts every WebSerial read as a transferred ArrayBuffer; this
+// worker splits the frames, keeps the network and the PROF statistics, and
+// posts at most one "graph" and one "prof" message per FLUSH_MS back, again
+// as transferred typed arrays. The UI thread never touches a byte of the
+// stream. Same wire formats as gng_host/gngio/protocol.py:
+//   ff: FF FF CMD LEN PAYLOAD CHK (V3 / V2-sw / PicoTiny / Arduino)
+//       NODES, EDGES, EDGES_CHUNK, EDGES_BITMAP, DELTA, PROF, PROF_AGG,
+//       COMPONENTS, REMAP; bytes outside frames (READY ...) go out as text
+//   a5: V2 gng.vhd streamer, A5 10 DBG / 20 nodes / 21 edges / 22 bitmap
+// A network is shown once NODES and the EDGES of the same frame id are in
+// (keyframe); a DELTA applies only on top of the frame before it, after a
+// lost frame the picture holds until the next keyframe (two_moon.pde).
+
+"use strict";
+
+const CMD_GNG_NODES = 0x10;
+const CMD_GNG_EDGES = 0x11;
+const CMD_PROF = 0x12;
+const CMD_GNG_DELTA = 0x13;
+const CMD_GNG_EDGES_CHUNK = 0x14;
+const CMD_GNG_EDGES_BITMAP = 0x17;
+const CMD_PROF_AGG = 0x1C;
+const CMD_GNG_COMPONENTS = 0x1E;
+const CMD_GNG_REMAP = 0x20;
+
+const A5_DBG = 0x10;
+const A5_NODES = 0x20;
+const A5_EDGES = 0x21;
+const A5_EDGE_BITMAP = 0x22;
+const A5_DBG_LEN = 54;
+const A5_DBG_TAGS = [
+  0xA6, 0xA7, 0xA8, 0xC0, 0xC1, 0xC2, 0xC3, 0xC4, 0xC5, 0xC6, 0xC7, 0xC8,
+  0xC9, 0xAA, 0xAB, 0xAC, 0xAD, 0xAE, 0xAF, 0xB0, 0xB1, 0xB2, 0xB3, 0xB4,
+  0xB5, 0xA9];
+const A5_DBG_FIELDS = [
+  "s1", "s2", "edge01", "es1s2_pre", "deg_s1", "deg_s2", "conn", "rm",
+  "iso", "iso_id", "node_count", "ins", "ins_id",
+  "err0", "err1", "err2", "err3", "s1x_lo", "s1x_hi", "s1y_lo", "s1y_hi",
+  "ts0", "ts1", "ts2", "ts3", "sample"];
+
+// protocol.py PROF_FIELDS / PROF_AGG_PHASES
+const PROF_FIELDS = [
+  "cyc_total", "cyc_winner", "cyc_move_w", "cyc_nb", "cyc_connect",
+  "cyc_delete", "cyc_prune", "cyc_insert", "cyc_renorm", "step",
+  "cyc_overlap", "misa", "mxisa", "tx_stall", "smp_dropped",
+  "epochs", "cache", "idle", "time", "qe", "qe_slow",
+  "drift_events", "drift_lat", "drift_left", "passes", "rx_bad", "rx_lost"];
+const PHASES = PROF_FIELDS.slice(0, 9).concat(["cyc_overlap"]);
+const BINS = 32;      // log2 cycle bins, bin b = [2^b, 2^(b+1))
+
+const MAX_ID = 1024;  // node id space (16-bit chunk ids stay below MAX_NODES)
+const FLUSH_MS = 16;
+
+// ---------------------------------------------------------------------------
+// byte buffer
+// ---------------------------------------------------------------------------
+let buf = new Uint8Array(1 << 16);
+let head = 0;  // first unparsed byte
+let tail = 0;  // end of data
+
+function append(chunk) {
+  if (tail + chunk.length > buf.length) {
+    const live = tail - head;
+    if (live + chunk.length > buf.length) {
+      let n = buf.length;
+      while (n < live + chunk.length) n *= 2;
+      const nb = new Uint8Array(n);
+      nb.set(buf.subarray(head, tail));
+      buf = nb;
+    } else {
+      buf.copyWithin(0, head, tail);
+    }
+    tail = live;
+    head = 0;
+  }
+  buf.set(chunk, tail);
+  tail += chunk.length;
+}
+
+// ---------------------------------------------------------------------------
+// state
+// ---------------------------------------------------------------------------
+let kind = "ff";
+
+const pos = new Float32Array(2 * MAX_ID);
+const act = new Uint8Array(MAX_ID);
+const label = new Uint8Array(MAX_ID).fill(0xFF);
+let edges = new Set();        // a * MAX_ID + b, a < b
+
+let staged = null;            // NODES waiting for their EDGES: {fid, ids, xy}
+let chunks = null;            // EDGES_CHUNK of staged.fid: {next, keys}
+let synced = false;
+let lastFid = -1;
+let a5Slots = 0;
+
+const stats = {
+  bytes: 0, frames: 0, bad: 0, keyframes: 0, deltas: 0, dropped: 0,
+  components: 0, remaps: 0, dbg: null,
+};
+let prof = null;              // last PROF dict
+let profPrev = null;          // {t, step} for steps/s
+let stepsPerSec = 0;
+const hist = PHASES.map(() => new Float64Array(BINS));
+const aggHist = PHASES.map(() => null);  // PROF_AGG interval, replaces hist
+let aggFid = -1;
+
+let graphDirty = false;
+let profDirty = false;
+let flushTimer = 0;
+let text = "";
+
+function reset() {
+  head = tail = 0;
+  act.fill(0);
+  label.fill(0xFF);
+  edges = new Set();
+  staged = chunks = null;
+  synced = false;
+  lastFid = -1;
+  for (const k of Object.keys(stats)) stats[k] = (k === "dbg") ? null : 0;
+  prof = profPrev = null;
+  stepsPerSec = 0;
+  for (const h of hist) h.fill(0);
+  aggHist.fill(null);
+  graphDirty = profDirty = true;
+  text = "";
+}
+
+const edgeKey = (a, b) => (a < b) ? a * MAX_ID + b : b * MAX_ID + a;
+const i16 = (p, o) => ((p[o] | (p[o + 1] << 8)) << 16) >> 16;
+const u32 = (p, o) => (p[o] | (p[o + 1] << 8) | (p[o + 2] << 16) | (p[o + 3] << 24)) >>> 0;
+
+function log2Bin(v) {
+  return v ? Math.min(31 - Math.clz32(v), BINS - 1) : 0;
+}
+
+// i < j row-major bit k of the half matrix (edge_index_ij) -> (i, j)
+function triuPair(k, n) {
+  let i = 0, row = n - 1;
+  while (k >= row && row > 0) { k -= row; i++; row--; }
+  return row > 0 ? [i, i + 1 + k] : null;
+}
+
+// ---------------------------------------------------------------------------
+// network
+// ---------------------------------------------------------------------------
+function keyframe(ids, xy, keys) {
+  act.fill(0);
+  for (let k = 0; k < ids.length; k++) {
+    const id = ids[k];
+    if (id >= MAX_ID) continue;
+    act[id] = 1;
+    pos[2 * id] = xy[2 * k];
+    pos[2 * id + 1] = xy[2 * k + 1];
+  }
+  edges = keys;
+  stats.keyframes++;
+  graphDirty = true;
+}
+
+function stageNodes(fid, p, cnt, off, stride, actOff) {
+  const ids = [], xy = [];
+  for (let k = 0; k < cnt; k++) {
+    const o = off + k * stride;
+    if (o + stride > p.length) break;
+    if (actOff >= 0 && !p[o + actOff]) continue;
+    ids.push(p[o]);
+    xy.push(i16(p, o + stride - 4) / 1000, i16(p, o + stride - 2) / 1000);
+  }
+  staged = { fid, ids, xy };
+  chunks = null;
+}
+
+function commit(fid, keys) {
+  if (!staged || (fid !== null && fid !== staged.fid)) return;
+  keyframe(staged.ids, staged.xy, keys);
+  synced = true;
+  lastFid = fid;
+  staged = chunks = null;
+}
+
+function pairsToKeys(p, cnt, off, wide, keys) {
+  const w = wide ? 4 : 2;
+  for (let k = 0; k < cnt && off + (k + 1) * w <= p.length; k++) {
+    const o = off + k * w;
+    const a = wide ? (p[o] | (p[o + 1] << 8)) : p[o];
+    const b = wide ? (p[o + 2] | (p[o + 3] << 8)) : p[o + 1];
+    if (a !== b && a < MAX_ID && b < MAX_ID) keys.add(edgeKey(a, b));
+  }
+  return keys;
+}
+
+function bitmapToKeys(p, off, n, gap) {
+  const keys = new Set();
+  let k = 0;
+  for (let o = off; o < p.length; o++) {
+    const v = p[o];
+    if (gap) {
+      if (v === 255) { k += 255; continue; }
+      k += v;
+      const ij = triuPair(k, n);
+      if (ij) keys.add(edgeKey(ij[0], ij[1]));
+      k++;
+    } else {
+      for (let bit = 0; bit < 8; bit++, k++) {
+        if (!(v & (1 << bit))) continue;
+        const ij = triuPair(k, n);
+        if (ij) keys.add(edgeKey(ij[0], ij[1]));
+      }
+    }
+  }
+  return keys;
+}
+
+function onDelta(p) {
+  if (p.length < 4) return;
+  const fid = p[0], nUpd = p[1], nAdd = p[2], nRem = p[3];
+  if (p.length < 4 + nUpd * 5 + (nAdd + nRem) * 2) return;
+  if (!synced || fid !== ((lastFid + 1) & 0xFF)) {
+    synced = false;
+    stats.dropped++;
+    return;
+  }
+  let o = 4;
+  for (let u = 0; u < nUpd; u++, o += 5) {
+    const id = p[o] & 0x7F;
+    act[id] = (p[o] & 0x80) ? 0 : 1;
+    pos[2 * id] = i16(p, o + 1) / 1000;
+    pos[2 * id + 1] = i16(p, o + 3) / 1000;
+  }
+  for (let e = 0; e < nAdd + nRem; e++, o += 2) {
+    const a = p[o], b = p[o + 1];
+    if (a === b) continue;
+    if (e < nAdd) edges.add(edgeKey(a, b)); else edges.delete(edgeKey(a, b));
+  }
+  lastFid = fid;
+  stats.deltas++;
+  graphDirty = true;
+}
+
+// ---------------------------------------------------------------------------
+// PROF
+// ---------------------------------------------------------------------------
+function onProf(p) {
+  const n = Math.min((p.length - 1) >> 2, PROF_FIELDS.length);
+  const d = { frame_id: p[0] };
+  for (let k = 0; k < n; k++) d[PROF_FIELDS[k]] = u32(p, 1 + 4 * k);
+  const now = performance.now();
+  if ("step" in d) {
+    if (profPrev && d.step > profPrev.step && now > profPrev.t)
+      stepsPerSec = (d.step - profPrev.step) * 1000 / (now - profPrev.t);
+    profPrev = { t: now, step: d.step };
+  }
+  PHASES.forEach((name, ph) => {
+    if (name in d && (ph === 0 || d[name])) hist[ph][log2Bin(d[name])]++;
+  });
+  prof = d;
+  profDirty = true;
+}
+
+function onProfAgg(p) {
+  if (p.length < 24) return;
+  const fid = p[0], ph = p[1], b0 = p[2], nb = p[3];
+  if (ph >= PHASES.length) return;
+  if (fid !== aggFid) { aggHist.fill(null); aggFid = fid; }
+  const h = new Float64Array(BINS);
+  for (let k = 0; k < nb && 24 + 2 * k + 1 < p.length; k++) {
+    const b = b0 + k;
+    if (b < BINS) h[b] = p[24 + 2 * k] | (p[25 + 2 * k] << 8);
+  }
+  aggHist[ph] = { hist: h, count: u32(p, 4), min: u32(p, 8), max: u32(p, 12),
+                  sum: u32(p, 16) + u32(p, 20) * 4294967296 };
+  profDirty = true;
+}
+
+// ---------------------------------------------------------------------------
+// framed protocol
+// ---------------------------------------------------------------------------
+function onFrame(cmd, p) {
+  stats.frames++;
+  switch (cmd) {
+    case CMD_GNG_NODES:
+      if (p.length >= 2) stageNodes(p[0], p, p[1], 2, 5, -1);
+      break;
+    case CMD_GNG_EDGES:
+      if (p.length >= 2) commit(p[0], pairsToKeys(p, p[1], 2, false, new Set()));
+      break;
+    case CMD_GNG_EDGES_CHUNK: {
+      if (p.length < 7 || !staged || p[0] !== staged.fid) break;
+      const c = p[2], nc = p[3];
+      if (c === 0) chunks = { next: 0, keys: new Set() };
+      if (!chunks || c !== chunks.next) { chunks = null; break; }
+      pairsToKeys(p, p[6], 7, (p[1] & 1) !== 0, chunks.keys);
+      chunks.next++;
+      if (chunks.next === nc) commit(p[0], chunks.keys);
+      break;
+    }
+    case CMD_GNG_EDGES_BITMAP:
+      if (p.length >= 3) commit(p[0], bitmapToKeys(p, 3, p[1], (p[2] & 1) !== 0));
+      break;
+    case CMD_GNG_DELTA:
+      onDelta(p);
+      break;
+    case CMD_PROF:
+      onProf(p);
+      break;
+    case CMD_PROF_AGG:
+      onProfAgg(p);
+      break;
+    case CMD_GNG_COMPONENTS:
+      if (p.length >= 4) {
+        if (p[2] === 0) label.fill(0xFF);
+        for (let k = 0; k < p[3] && 4 + k < p.length; k++) label[p[2] + k] = p[4 + k];
+        stats.components = p[1];
+        graphDirty = true;
+      }
+      break;
+    case CMD_GNG_REMAP:
+      stats.remaps++;  // ids change with the next keyframe
+      synced = false;
+      break;
+  }
+}
+
+function parseFF() {
+  const b = buf;
+  let i = head;
+  for (;;) {
+    let j = b.indexOf(0xFF, i);
+    if (j < 0 || j >= tail) { addText(i, tail); i = tail; break; }
+    if (j + 1 >= tail) { addText(i, j); i = j; break; }
+    if (b[j + 1] !== 0xFF) { addText(i, j + 1); i = j + 1; continue; }
+    addText(i, j);
+    if (j + 4 > tail) { i = j; break; }
+    const cmd = b[j + 2];
+    if (cmd === 0xFF) { i = j + 1; continue; }  // FF FF FF: header one byte later
+    const end = j + 5 + b[j + 3];
+    if (end > tail) { i = j; break; }
+    let s = 0;
+    for (let k = j + 2; k < end - 1; k++) s += b[k];
+    if (((~s) & 0xFF) === b[end - 1]) {
+      onFrame(cmd, b.slice(j + 4, end - 1));
+      i = end;
+    } else {
+      stats.bad++;
+      i = j + 1;
+    }
+  }
+  head = i;
+}
+
+function addText(i, j) {
+  for (let k = i; k < j; k++) {
+    const c = buf[k];
+    if (c === 10) { if (text) postMessage({ type: "text", line: text }); text = ""; }
+    else if (c >= 32 && c < 127 && text.length < 200) text += String.fromCharCode(c);
+  }
+}
+
+// ---------------------------------------------------------------------------
+// V2 A5 streamer
+// ---------------------------------------------------------------------------
+function onA5(t, p) {
+  stats.frames++;
+  if (t === A5_DBG) {
+    const d = {};
+    A5_DBG_FIELDS.forEach((name, k) => { d[name] = p[3 + 2 * k]; });
+    d.err32 = (d.err0 | (d.err1 << 8) | (d.err2 << 16) | (d.err3 << 24)) >>> 0;
+    d.ts = (d.ts0 | (d.ts1 << 8) | (d.ts2 << 16) | (d.ts3 << 24)) >>> 0;
+    stats.dbg = d;
+    profDirty = true;
+  } else if (t === A5_NODES) {
+    a5Slots = p[2];
+    stageNodes(null, p, p[2], 4, 7, 1);
+  } else if (t === A5_EDGES) {
+    const keys = new Set();
+    const cnt = p[2] | (p[3] << 8);
+    for (let k = 0; k < cnt; k++) {
+      const a = p[4 + 3 * k], b = p[5 + 3 * k];
+      if (a !== b) keys.add(edgeKey(a, b));
+    }
+    commit(null, keys);
+  } else if (t === A5_EDGE_BITMAP) {
+    commit(null, bitmapToKeys(p, 4, a5Slots, false));
+  }
+}
+
+function parseA5() {
+  const b = buf;
+  let i = head;
+  for (;;) {
+    const j = b.indexOf(0xA5, i);
+    if (j < 0 || j >= tail) { i = tail; break; }
+    if (j + 4 > tail) { i = j; break; }
+    const t = b[j + 1];
+    let ln;
+    if (t === A5_DBG) ln = A5_DBG_LEN;
+    else if (t === A5_NODES) ln = 4 + b[j + 2] * 7;
+    else if (t === A5_EDGES) ln = 4 + (b[j + 2] | (b[j + 3] << 8)) * 3;
+    else if (t === A5_EDGE_BITMAP) ln = 4 + (b[j + 2] | (b[j + 3] << 8));
+    else { i = j + 1; continue; }
+    if (j + ln > tail) { i = j; break; }
+    if (t === A5_DBG && !A5_DBG_TAGS.every((tag, k) => b[j + 2 + 2 * k] === tag)) {
+      stats.bad++;
+      i = j + 1;
+      continue;
+    }
+    onA5(t, b.slice(j, j + ln));
+    i = j + ln;
+  }
+  head = i;
+}
+
+// ---------------------------------------------------------------------------
+// out to the page
+// ---------------------------------------------------------------------------
+function flush() {
+  flushTimer = 0;
+  if (graphDirty) {
+    graphDirty = false;
+    let n = 0;
+    for (let id = 0; id < MAX_ID; id++) n += act[id];
+    const xy = new Float32Array(2 * n);
+    const lab = new Float32Array(n);
+    let k = 0;
+    for (let id = 0; id < MAX_ID; id++) {
+      if (!act[id]) continue;
+      xy[2 * k] = pos[2 * id];
+      xy[2 * k + 1] = pos[2 * id + 1];
+      lab[k] = label[id];
+      k++;
+    }
+    const seg = new Float32Array(4 * edges.size);
+    let e = 0;
+    for (const key of edges) {
+      const a = Math.floor(key / MAX_ID), b = key % MAX_ID;
+      if (!act[a] || !act[b]) continue;
+      seg.set([pos[2 * a], pos[2 * a + 1], pos[2 * b], pos[2 * b + 1]], 4 * e);
+      e++;
+    }
+    const segs = seg.subarray(0, 4 * e).slice();
+    postMessage({ type: "graph", nodes: n, edges: e, xy, lab, seg: segs },
+                [xy.buffer, lab.buffer, segs.buffer]);
+  }
+  if (profDirty) {
+    profDirty = false;
+    const agg = aggHist.some(Boolean);
+    const h = new Float64Array(PHASES.length * BINS);
+    PHASES.forEach((_, ph) => h.set(agg ? (aggHist[ph] ? aggHist[ph].hist : new Float64Array(BINS))
+                                        : hist[ph], ph * BINS));
+    postMessage({ type: "prof", phases: PHASES, bins: BINS, hist: h, agg, prof,
+                  stepsPerSec, dbg: stats.dbg }, [h.buffer]);
+  }
+  postMessage({ type: "stats", stats: Object.assign({}, stats, { dbg: undefined }), synced });
+}
+
+onmessage = (ev) => {
+  const m = ev.data;
+  if (m.type === "bytes") {
+    const chunk = new Uint8Array(m.buf);
+    stats.bytes += chunk.length;
+    append(chunk);
+    if (kind === "a5") parseA5(); else parseFF();
+  } else if (m.type === "kind") {
+    kind = m.kind;
+    reset();
+  } else if (m.type === "reset") {
+    reset();
+  } else if (m.type === "redraw") {
+    graphDirty = true;
+  } else if (m.type === "clear-hist") {
+    for (const h of hist) h.fill(0);
+    aggHist.fill(null);
+    profDirty = true;
+  }
+  if (!flushTimer) flushTimer = setTimeout(flush, FLUSH_MS);
+};
@@ -0,0 +1,408 @@
+// live.js - WebSerial live viewer of a GNG board (UI thread)
+//
+// Reads the port and hands every chunk to decoder.js as a transferred
+// ArrayBuffer, then only draws what the worker posts back:
+//   - graph: WebGL2, one instanced draw for all edges (a quad per edge,
+//     widened in the vertex shader) and one for all nodes (a quad per node,
+//     cut to a disc in the fragment shader, colour = component label)
+//   - PROF: one row of log2 cycle bins per phase, from the PROF frames or,
+//     when the firmware sends them (GNG_PROF_AGG=1), the PROF_AGG intervals
+// Drawing runs on requestAnimationFrame with the newest message only, so a
+// burst of snapshots costs one upload and one draw per display frame.
+// Train sends CMD_GEN to a V3 board: it trains on an on-board generator
+// (no dataset upload) and streams its snapshots.
+
+"use strict";
+
+const CMD_GEN = 0x29;
+
+const $ = (id) => document.getElementById(id);
+
+const worker = new Worker("decoder.js");
+let port = null;
+let reader = null;
+let writer = null;
+let reading = null;     // readLoop() promise
+
+let graph = null;       // newest "graph" message, not yet drawn
+let profMsg = null;     // newest "prof" message, not yet drawn
+let view = null;        // [x0, y0, x1, y1] of the graph canvas
+let fitNext = true;
+let lastStats = null;
+let lastStatsT = 0;
+let bytesPerSec = 0;
+
+// ---------------------------------------------------------------------------
+// serial
+// ---------------------------------------------------------------------------
+function frame(cmd, payload) {
+  let s = cmd + payload.length;
+  for (const v of payload) s += v;
+  return new Uint8Array([0xFF, 0xFF, cmd, payload.length, ...payload, (~s) & 0xFF]);
+}
+
+async function connect() {
+  port = await navigator.serial.requestPort();
+  await port.open({ baudRate: Number($("baud").value), bufferSize: 1 << 16 });
+  worker.postMessage({ type: "kind", kind: $("kind").value });
+  writer = port.writable.getWriter();
+  fitNext = true;
+  $("connect").textContent = "Disconnect";
+  $("train").disabled = $("kind").value !== "ff";
+  $("kind").disabled = $("baud").disabled = true;
+  log(`open at ${$("baud").value} baud`);
+  reading = readLoop();
+}
+
+async function readLoop() {
+  while (port && port.readable) {
+    reader = port.readable.getReader();
+    try {
+      for (;;) {
+        const { value, done } = await reader.read();
+        if (done) break;
+        const own = (value.byteOffset === 0 && value.byteLength === value.buffer.byteLength)
+          ? value : value.slice();
+        worker.postMessage({ type: "bytes", buf: own.buffer }, [own.buffer]);
+      }
+    } catch (err) {
+      log(`read: ${err.message}`);   // framing / parity / overrun: keep reading
+    } finally {
+      reader.releaseLock();
+      reader = null;
+    }
+  }
+}
+
+async function disconnect() {
+  const p = port;
+  port = null;
+  if (reader) await reader.cancel().catch(() => {});
+  await reading;
+  if (writer) { writer.releaseLock(); writer = null; }
+  if (p) await p.close().catch(() => {});
+  $("connect").textContent = "Connect";
+  $("train").disabled = true;
+  $("kind").disabled = $("baud").disabled = false;
+  log("closed");
+}
+
+function log(line) {
+  const el = $("log");
+  el.textContent = (el.textContent + line + "\n").split("\n").slice(-200).join("\n");
+  el.scrollTop = el.scrollHeight;
+}
+
+// ---------------------------------------------------------------------------
+// WebGL2 graph
+// ---------------------------------------------------------------------------
+const gl = $("graph").getContext("webgl2", { antialias: true });
+
+const VIEW_GLSL = `
+uniform vec4 u_view;    // x0, y0, 1 / (x1 - x0), 1 / (y1 - y0)
+uniform vec2 u_px;      // 2 / canvas size in device pixels
+vec2 to_clip(vec2 p) { return (p - u_view.xy) * u_view.zw * 2.0 - 1.0; }
+`;
+
+const EDGE_VS = `#version 300 es
+in vec2 a_corner;       // x: 0 = end a, 1 = end b; y: -1 / +1 side
+in vec4 a_seg;          // per edge: ax, ay, bx, by
+uniform float u_width;
+${VIEW_GLSL}
+void main() {
+  vec2 a = to_clip(a_seg.xy), b = to_clip(a_seg.zw);
+  vec2 d = (b - a) / u_px;
+  vec2 n = length(d) > 0.0 ? normalize(vec2(-d.y, d.x)) : vec2(0.0);
+  gl_Position = vec4(mix(a, b, a_corner.x) + n * a_corner.y * u_width * 0.5 * u_px, 0.0, 1.0);
+}`;
+
+const EDGE_FS = `#version 300 es
+precision mediump float;
+out vec4 o;
+void main() { o = vec4(0.45, 0.47, 0.50, 0.85); }`;
+
+const NODE_VS = `#version 300 es
+in vec2 a_corner;       // -1 / +1 square
+in vec2 a_pos;          // per node
+in float a_label;       // component label, 255 = none
+uniform float u_radius;
+${VIEW_GLSL}
+out vec2 v_uv;
+out float v_label;
+void main() {
+  v_uv = a_corner;
+  v_label = a_label;
+  gl_Position = vec4(to_clip(a_pos) + a_corner * u_radius * u_px, 0.0, 1.0);
+}`;
+
+const NODE_FS = `#version 300 es
+precision mediump float;
+in vec2 v_uv;
+in float v_label;
+out vec4 o;
+vec3 hue(float h) {
+  return clamp(abs(mod(h * 6.0 + vec3(0.0, 4.0, 2.0), 6.0) - 3.0) - 1.0, 0.0, 1.0);
+}
+void main() {
+  float r = length(v_uv);
+  if (r > 1.0) discard;
+  vec3 c = v_label > 254.5 ? vec3(0.71, 0.07, 0.11)      // no labels: --accent
+                           : 0.8 * hue(fract(v_label * 0.618034));
+  o = vec4(r > 0.72 ? vec3(1.0) : c, 1.0);
+}`;
+
+function program(vs, fs) {
+  const p = gl.createProgram();
+  for (const [type, src] of [[gl.VERTEX_SHADER, vs], [gl.FRAGMENT_SHADER, fs]]) {
+    const s = gl.createShader(type);
+    gl.shaderSource(s, src);
+    gl.compileShader(s);
+    if (!gl.getShaderParameter(s, gl.COMPILE_STATUS)) throw new Error(gl.getShaderInfoLog(s));
+    gl.attachShader(p, s);
+  }
+  gl.linkProgram(p);
+  if (!gl.getProgramParameter(p, gl.LINK_STATUS)) throw new Error(gl.getProgramInfoLog(p));
+  return p;
+}
+
+// one VAO per pass: a static 4-corner strip plus per-instance buffers
+function pass(prog, corners, inst) {
+  const vao = gl.createVertexArray();
+  gl.bindVertexArray(vao);
+  const cb = gl.createBuffer();
+  gl.bindBuffer(gl.ARRAY_BUFFER, cb);
+  gl.bufferData(gl.ARRAY_BUFFER, new Float32Array(corners), gl.STATIC_DRAW);
+  const loc = gl.getAttribLocation(prog, "a_corner");
+  gl.enableVertexAttribArray(loc);
+  gl.vertexAttribPointer(loc, 2, gl.FLOAT, false, 0, 0);
+  const bufs = {};
+  for (const [name, size] of inst) {
+    const b = gl.createBuffer();
+    const l = gl.getAttribLocation(prog, name);
+    gl.bindBuffer(gl.ARRAY_BUFFER, b);
+    gl.enableVertexAttribArray(l);
+    gl.vertexAttribPointer(l, size, gl.FLOAT, false, 0, 0);
+    gl.vertexAttribDivisor(l, 1);
+    bufs[name] = b;
+  }
+  gl.bindVertexArray(null);
+  const uni = {};
+  for (const u of ["u_view", "u_px", "u_width", "u_radius"]) uni[u] = gl.getUniformLocation(prog, u);
+  return { prog, vao, bufs, uni, count: 0 };
+}
+
+let edgePass = null;
+let nodePass = null;
+if (gl) {
+  edgePass = pass(program(EDGE_VS, EDGE_FS), [0, -1, 1, -1, 0, 1, 1, 1], [["a_seg", 4]]);
+  nodePass = pass(program(NODE_VS, NODE_FS), [-1, -1, 1, -1, -1, 1, 1, 1],
+                  [["a_pos", 2], ["a_label", 1]]);
+  gl.enable(gl.BLEND);
+  gl.blendFunc(gl.SRC_ALPHA, gl.ONE_MINUS_SRC_ALPHA);
+} else {
+  $("graph-info").textContent = "no WebGL2 in this browser";
+}
+
+function upload(p, name, data) {
+  gl.bindBuffer(gl.ARRAY_BUFFER, p.bufs[name]);
+  gl.bufferData(gl.ARRAY_BUFFER, data, gl.DYNAMIC_DRAW);
+}
+
+function fitView(xy) {
+  let x0 = Infinity, y0 = Infinity, x1 = -Infinity, y1 = -Infinity;
+  for (let k = 0; k < xy.length; k += 2) {
+    x0 = Math.min(x0, xy[k]); x1 = Math.max(x1, xy[k]);
+    y0 = Math.min(y0, xy[k + 1]); y1 = Math.max(y1, xy[k + 1]);
+  }
+  if (!(x1 >= x0)) return view || [0, 0, 1, 1];
+  const m = 0.08 * Math.max(x1 - x0, y1 - y0, 1e-3);
+  if (!fitNext && view) {   // grow only, so the picture does not jump
+    x0 = Math.min(x0, view[0] + m); y0 = Math.min(y0, view[1] + m);
+    x1 = Math.max(x1, view[2] - m); y1 = Math.max(y1, view[3] - m);
+  }
+  fitNext = false;
+  return [x0 - m, y0 - m, x1 + m, y1 + m];
+}
+
+function sizeCanvas(c) {
+  const dpr = window.devicePixelRatio || 1;
+  const w = Math.max(1, Math.round(c.clientWidth * dpr));
+  const h = Math.max(1, Math.round(c.clientHeight * dpr));
+  if (c.width !== w || c.height !== h) { c.width = w; c.height = h; }
+  return dpr;
+}
+
+function drawGraph() {
+  const dpr = sizeCanvas(gl.canvas);
+  const w = gl.canvas.width, h = gl.canvas.height;
+  if (graph) {
+    upload(edgePass, "a_seg", graph.seg);
+    upload(nodePass, "a_pos", graph.xy);
+    upload(nodePass, "a_label", graph.lab);
+    edgePass.count = graph.edges;
+    nodePass.count = graph.nodes;
+    view = fitView(graph.xy);
+    graph = null;
+  }
+  gl.viewport(0, 0, w, h);
+  gl.clearColor(1, 1, 1, 1);
+  gl.clear(gl.COLOR_BUFFER_BIT);
+  if (!view) return;
+
+  // square aspect: widen the shorter side of the view box
+  let [x0, y0, x1, y1] = view;
+  const sx = (x1 - x0) / w, sy = (y1 - y0) / h;
+  if (sx > sy) { const d = (sx * h - (y1 - y0)) / 2; y0 -= d; y1 += d; }
+  else { const d = (sy * w - (x1 - x0)) / 2; x0 -= d; x1 += d; }
+
+  for (const [p, mode] of [[edgePass, "u_width"], [nodePass, "u_radius"]]) {
+    if (!p.count) continue;
+    gl.useProgram(p.prog);
+    gl.uniform4f(p.uni.u_view, x0, y0, 1 / (x1 - x0), 1 / (y1 - y0));
+    gl.uniform2f(p.uni.u_px, 2 / w, 2 / h);
+    gl.uniform1f(p.uni[mode], (mode === "u_width" ? 1.6 : 5.0) * dpr);
+    gl.bindVertexArray(p.vao);
+    gl.drawArraysInstanced(gl.TRIANGLE_STRIP, 0, 4, p.count);
+  }
+  gl.bindVertexArray(null);
+}
+
+// ---------------------------------------------------------------------------
+// PROF histograms
+// ---------------------------------------------------------------------------
+const hctx = $("hist").getContext("2d");
+
+function drawHist(m) {
+  const c = hctx.canvas;
+  const dpr = sizeCanvas(c);
+  const w = c.width, h = c.height;
+  hctx.clearRect(0, 0, w, h);
+  const rows = m.phases.map((name, ph) => ({ name, h: m.hist.subarray(ph * m.bins, (ph + 1) * m.bins) }))
+    .filter((r) => r.h.some((v) => v > 0));
+  if (!rows.length) return;
+  let b0 = m.bins, b1 = 0;
+  for (const r of rows) r.h.forEach((v, b) => { if (v) { b0 = Math.min(b0, b); b1 = Math.max(b1, b); } });
+
+  const left = 92 * dpr, bottom = 16 * dpr;
+  const rowH = (h - bottom) / rows.length;
+  const colW = (w - left) / (b1 - b0 + 1);
+  hctx.font = `${11 * dpr}px "Fira Code", monospace`;
+  hctx.textBaseline = "middle";
+  rows.forEach((r, k) => {
+    const y = k * rowH;
+    let max = 0, n = 0, mean = 0;
+    r.h.forEach((v, b) => { max = Math.max(max, v); n += v; mean += v * 1.5 * 2 ** b; });
+    hctx.fillStyle = "#5f6670";
+    hctx.fillText(r.name.replace(/^cyc_/, ""), 4 * dpr, y + rowH / 2);
+    hctx.fillStyle = "#b5121b";
+    for (let b = b0; b <= b1; b++) {
+      const v = r.h[b];
+      if (!v) continue;
+      const bh = (rowH - 4 * dpr) * v / max;
+      hctx.fillRect(left + (b - b0) * colW + 1, y + rowH - 2 * dpr - bh, colW - 2, bh);
+    }
+    hctx.fillStyle = "#333333";
+    hctx.textAlign = "right";
+    hctx.fillText(`~${Math.round(mean / n)}`, w - 4 * dpr, y + rowH / 2);
+    hctx.textAlign = "left";
+  });
+  hctx.fillStyle = "#5f6670";
+  for (let b = b0; b <= b1; b += Math.max(1, Math.ceil((b1 - b0 + 1) / 8)))
+    hctx.fillText(`2^${b}`, left + (b - b0) * colW, h - bottom / 2);
+  $("hist-info").textContent = (m.agg ? "PROF_AGG interval" : "PROF frames since clear")
+    + ", cycles per phase, log2 bins, ~mean";
+}
+
+function row(cells) {
+  return "<tr>" + cells.map((c) => `<td>${c}</td>`).join("") + "</tr>";
+}
+
+function drawTable(m, s) {
+  const cells = [];
+  const p = m && m.prof;
+  if (s) {
+    cells.push(["frames", s.frames], ["bad chk", s.bad],
+               ["KB/s", (bytesPerSec / 1024).toFixed(1)], ["keyframes", s.keyframes],
+               ["deltas", s.deltas], ["deltas lost", s.dropped]);
+    if (s.components) cells.push(["components", s.components]);
+  }
+  if (p) {
+    cells.push(["step", p.step ?? "-"], ["steps/s", m.stepsPerSec.toFixed(0)],
+               ["cyc_total", p.cyc_total]);
+    if ("qe" in p) cells.push(["QE EMA", (p.qe / 2 ** 30).toFixed(5)]);
+    if ("idle" in p) cells.push(["idle", p.idle]);
+    if ("rx_bad" in p) cells.push(["rx_bad", p.rx_bad], ["rx_lost", p.rx_lost ?? 0]);
+  }
+  if (m && m.dbg) {
+    const d = m.dbg;
+    cells.push(["V2 nodes", d.node_count], ["s1 / s2", `${d.s1} / ${d.s2}`],
+               ["ts", d.ts], ["err s1", d.err32]);
+  }
+  let html = "";
+  for (let k = 0; k < cells.length; k += 2)
+    html += row(cells[k].concat(cells[k + 1] || ["", ""]));
+  $("prof").innerHTML = html;
+}
+
+// ---------------------------------------------------------------------------
+// worker messages and the frame loop
+// ---------------------------------------------------------------------------
+let lastProf = null;
+let statsMsg = null;
+let tableT = 0;
+
+worker.onmessage = (ev) => {
+  const m = ev.data;
+  if (m.type === "graph") {
+    graph = m;
+    $("graph-info").textContent = `${m.nodes} nodes, ${m.edges} edges`;
+  } else if (m.type === "prof") {
+    profMsg = m;
+  } else if (m.type === "stats") {
+    const now = performance.now();
+    if (lastStats && now - lastStatsT > 500) {
+      bytesPerSec = (m.stats.bytes - lastStats.bytes) * 1000 / (now - lastStatsT);
+      lastStats = m.stats;
+      lastStatsT = now;
+    } else if (!lastStats) {
+      lastStats = m.stats;
+      lastStatsT = now;
+    }
+    statsMsg = m.stats;
+  } else if (m.type === "text") {
+    log(m.line);
+  }
+};
+
+function tick() {
+  if (gl) drawGraph();
+  if (profMsg) {
+    drawHist(profMsg);
+    lastProf = profMsg;
+    profMsg = null;
+  }
+  const now = performance.now();
+  if (statsMsg && now - tableT > 250) {
+    drawTable(lastProf, statsMsg);
+    tableT = now;
+  }
+  requestAnimationFrame(tick);
+}
+
+// ---------------------------------------------------------------------------
+// controls
+// ---------------------------------------------------------------------------
+if (!("serial" in navigator)) {
+  $("unsupported").hidden = false;
+  $("connect").disabled = true;
+}
+
+$("connect").onclick = () => (port ? disconnect() : connect()).catch((err) => log(err.message));
+$("train").onclick = () => {
+  if (writer) writer.write(frame(CMD_GEN, [Number($("gen").value)])).catch((err) => log(err.message));
+};
+$("fit").onclick = () => { fitNext = true; view = null; worker.postMessage({ type: "redraw" }); };
+$("clear").onclick = () => worker.postMessage({ type: "clear-hist" });
+$("kind").onchange = () => worker.postMessage({ type: "kind", kind: $("kind").value });
+
+requestAnimationFrame(tick);